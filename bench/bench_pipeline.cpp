@@ -0,0 +1,580 @@
+// bench_pipeline — end-to-end benchmark of a real pipeline: loads a pipeline
+// JSON (e.g. pipelines/*.template.json) through PipelineLoader/PluginManager,
+// swaps its capture node for a non-realtime capture_file replay of a clip (a
+// capture_synthetic node is kept: it generates its own frames), and
+// runs N copies in parallel, one worker process each (as N cameras would run
+// N zm-core workers). Writes a JSON report per pipeline: input throughput,
+// per-stage fps / drops / queue high-water / wait and service latency
+// percentiles / utilisation, published events, and CPU and RSS per copy.
+//
+//   bench_pipeline --pipeline pipelines/e2e_file_cascade.template.json
+//       --clip bench/clips/1080p_h264.mp4 --plugins build/plugins [--copies 4]
+//       [--set detect.model_path=bench/models/yolo26n.onnx] [--duration 30 --warmup 5]
+//       [--out report.json] [--baseline baseline.json --tolerance 0.10]
+//
+// Without --duration each copy plays the clip once and stops when the
+// pipeline has drained; with it the clip loops and only the last `duration`
+// seconds after `warmup` are measured. --baseline compares against a stored
+// report (see README) and exits 3 if any metric regressed.
+
+#include "zm/PipelineLoader.hpp"
+#include "zm/PluginManager.hpp"
+#include "zm/EventBus.hpp"
+#include "zm/platform.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+namespace fs = std::filesystem;
+
+struct Options {
+    std::vector<std::string> pipelines;
+    std::string clip, plugins = "plugins", out = "-", baseline, workdir;
+    std::vector<std::pair<std::string, std::string>> sets;  // "id.key", json value
+    int copies = 1;
+    double duration = 0, warmup = 2, timeout = 600, start_timeout = 60;
+    int idle_ms = 1500;
+    double tolerance = 0.10;
+    bool verbose = false;
+};
+
+static void usage() {
+    fprintf(stderr,
+            "bench_pipeline --pipeline <json> [--pipeline ...] --clip <file> [--plugins <dir>]\n"
+            "    [--copies N] [--set <id>.<key>=<value>] [--duration S] [--warmup S]\n"
+            "    [--idle-ms MS] [--timeout S] [--out <report.json|->] [--workdir <dir>]\n"
+            "    [--baseline <report.json>] [--tolerance 0.10] [--verbose]\n");
+}
+
+// ---------------------------------------------------------------------------
+// Pipeline preparation
+// ---------------------------------------------------------------------------
+
+static json* nodeCfg(json& node) {
+    if (node.contains("cfg") && node["cfg"].is_object()) return &node["cfg"];
+    if (node.contains("config") && node["config"].is_object()) return &node["config"];
+    node["cfg"] = json::object();
+    return &node["cfg"];
+}
+
+// Rewrites one copy of the pipeline: the capture node becomes a capture_file
+// replay, plugin paths point at --plugins, recorders write under the copy's
+// work directory and --set overrides are applied. Notes what was changed.
+static bool prepareNode(json& node, const Options& o, int copy, const std::string& dir,
+                        std::vector<std::string>& notes, std::string& err) {
+    if (!node.is_object()) return true;
+    const std::string kind = node.value("kind", std::string());
+    const std::string id = node.value("id", kind);
+    json& cfg = *nodeCfg(node);
+
+    if (kind == "capture_synthetic") {
+        // Generates its own frames: kept as configured, but a play-once run
+        // needs a finite stream to drain.
+        if (o.duration <= 0 && cfg.value("frames", 0) <= 0) {
+            cfg["frames"] = 600;
+            notes.push_back(id + ": capture_synthetic limited to 600 frames (set frames or --duration)");
+        }
+    } else if (kind.rfind("capture_", 0) == 0) {
+        int sid = cfg.value("stream_id", 0);
+        if (cfg.contains("streams") && cfg["streams"].is_array() && !cfg["streams"].empty()) {
+            sid = cfg["streams"][0].value("stream_id", 0);
+            if (cfg["streams"].size() > 1)
+                notes.push_back(id + ": only stream " + std::to_string(sid) + " of " +
+                                std::to_string(cfg["streams"].size()) + " is replayed");
+        }
+        std::string clip = o.clip;
+        if (clip.empty() && kind == "capture_file") clip = cfg.value("path", std::string());
+        if (clip.empty()) {
+            err = id + ": " + kind + " needs --clip";
+            return false;
+        }
+        if (kind != "capture_file") notes.push_back(id + ": " + kind + " replaced by capture_file");
+        node["kind"] = "capture_file";
+        node.erase("path");
+        cfg = json{{"path", clip}, {"stream_id", sid}, {"loop", o.duration > 0}, {"realtime", false}};
+    }
+    if (node.contains("kind") && !node.contains("path")) {
+        const std::string k = node["kind"].get<std::string>();
+        node["path"] = o.plugins + "/" + k + "/" + k + ZM_PLUGIN_EXT;
+    }
+    if (cfg.contains("root") && cfg["root"].is_string()) cfg["root"] = dir + "/" + id;
+    if (cfg.contains("monitor_id")) cfg["monitor_id"] = copy + 1;
+    for (const auto& [key, value] : o.sets) {
+        const size_t dot = key.find('.');
+        if (key.substr(0, dot) != id && key.substr(0, dot) != kind) continue;
+        json v = json::parse(value, nullptr, /*allow_exceptions=*/false);
+        cfg[key.substr(dot + 1)] = v.is_discarded() ? json(value) : v;
+    }
+    if (node.contains("children") && node["children"].is_array())
+        for (auto& c : node["children"])
+            if (!prepareNode(c, o, copy, dir, notes, err)) return false;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// One copy (runs in its own process)
+// ---------------------------------------------------------------------------
+
+static double seconds(Clock::duration d) { return std::chrono::duration<double>(d).count(); }
+
+static double cpuSeconds() {
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+static double rssMiB() {
+    long long size = 0, resident = 0;
+    if (FILE* f = fopen("/proc/self/statm", "r")) {
+        if (fscanf(f, "%lld %lld", &size, &resident) != 2) resident = 0;
+        fclose(f);
+    }
+    return resident * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+}
+
+static json latencyJson(const zm::LatencyHistogram::Snapshot& h) {
+    return json{{"count", h.count},
+                {"mean", std::round(h.mean_us() * 10) / 10},
+                {"p50", h.percentile_us(0.50)},
+                {"p95", h.percentile_us(0.95)},
+                {"p99", h.percentile_us(0.99)},
+                {"max", h.max_us}};
+}
+
+struct Snapshot {
+    Clock::time_point t;
+    double cpu = 0;
+    zm::PluginManager::CaptureStatus capture;
+    std::vector<zm::PluginManager::StageStatus> stages;
+};
+
+static Snapshot snap(const zm::PluginManager& pm) {
+    return Snapshot{Clock::now(), cpuSeconds(), pm.captureStats(), pm.stageStats()};
+}
+
+static json runCopy(const std::string& pipelinePath, const Options& o, int copy) {
+    json r{{"copy", copy}, {"ok", false}};
+    zm::PipelineLoader loader(pipelinePath);
+    if (!loader.load()) return r["error"] = "pipeline load failed", r;
+    zm::PluginManager pm;
+    if (!pm.loadPipeline(loader.getPipeline())) return r["error"] = "plugin load failed", r;
+    pm.setRingName("zm_bench_" + std::to_string(getpid()));
+    pm.setRateControl(loader.getRateControl());
+
+    std::mutex evMu;
+    std::map<std::string, uint64_t> events;
+    zm::EventBus::instance().subscribe("plugin_event", [&](const std::string& m) {
+        json j = json::parse(m, nullptr, /*allow_exceptions=*/false);
+        const std::string type = j.is_object() ? j.value("type", std::string("?")) : "?";
+        std::lock_guard<std::mutex> lk(evMu);
+        ++events[type];
+    });
+
+    const auto tLoad = Clock::now();
+    pm.startAll();
+    const auto t0 = Clock::now();
+    r["start_s"] = seconds(t0 - tLoad);
+
+    const bool timed = o.duration > 0;
+    Snapshot base = snap(pm), last = base;
+    std::map<std::string, uint64_t> eventsBase;
+    bool warm = !timed || o.warmup <= 0;
+    uint64_t lastSig = 0;
+    auto lastActive = t0;
+    double rssSum = 0, rssPeak = 0;
+    int rssN = 0;
+    std::string stopReason;
+    for (;;) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        last = snap(pm);
+        uint64_t sig = last.capture.frames;
+        bool drained = true;
+        for (const auto& s : last.stages) {
+            sig += s.stats.processed + s.stats.dropped;
+            drained = drained && s.stats.depth == 0 && !s.stats.busy;
+        }
+        if (sig != lastSig) lastActive = last.t, lastSig = sig;
+        if (warm) {
+            const double rss = rssMiB();
+            rssSum += rss, ++rssN, rssPeak = std::max(rssPeak, rss);
+        }
+        const double el = seconds(last.t - t0);
+        if (!warm && el >= o.warmup) {
+            warm = true;
+            base = last;
+            std::lock_guard<std::mutex> lk(evMu);
+            eventsBase = events;
+        }
+        if (timed && el >= o.warmup + o.duration) { stopReason = "duration"; break; }
+        if (!timed && last.capture.frames > 0 && drained &&
+            last.t - lastActive >= std::chrono::milliseconds(o.idle_ms)) {
+            stopReason = "drained";
+            break;
+        }
+        if (last.capture.frames == 0 && el > o.start_timeout) { stopReason = "no_frames"; break; }
+        if (el > o.timeout) { stopReason = "timeout"; break; }
+    }
+    pm.stopAll();
+
+    // Play-once runs are measured up to the last frame handled, not the idle
+    // tail used to detect the end.
+    const auto tEnd = timed ? last.t : lastActive;
+    const double win = std::max(1e-6, seconds(tEnd - base.t));
+    const uint64_t frames = last.capture.frames - base.capture.frames;
+    const double cpu = last.cpu - base.cpu;
+    r["ok"] = stopReason == "duration" || stopReason == "drained";
+    r["stop"] = stopReason;
+    if (!r["ok"].get<bool>()) r["error"] = stopReason;
+    r["window_s"] = win;
+    r["frames_in"] = frames;
+    r["fps_in"] = frames / win;
+    r["ring_rejected"] = last.capture.ring_rejected - base.capture.ring_rejected;
+    r["cpu_s"] = cpu;
+    r["cpu_pct"] = 100.0 * cpu / win;
+    r["cpu_ms_per_frame"] = frames ? 1000.0 * cpu / frames : 0.0;
+    r["rss_mb_avg"] = rssN ? rssSum / rssN : 0.0;
+    r["rss_mb_peak"] = rssPeak;
+    json stages = json::array();
+    for (size_t i = 0; i < last.stages.size(); ++i) {
+        const auto& s = last.stages[i].stats;
+        const auto& b = base.stages[i].stats;
+        const auto service = s.service.since(b.service);
+        const uint64_t processed = s.processed - b.processed, dropped = s.dropped - b.dropped;
+        stages.push_back(json{
+            {"id", last.stages[i].id},
+            {"plugin", fs::path(last.stages[i].path).stem().string()},
+            {"processed", processed},
+            {"dropped", dropped},
+            {"drop_rate", processed + dropped ? double(dropped) / double(processed + dropped) : 0.0},
+            {"fps", processed / win},
+            {"queue_capacity", s.max_depth},
+            {"queue_high_water", s.high_water},
+            {"util_pct", 100.0 * service.sum_us / 1e6 / win},
+            {"wait_us", latencyJson(s.wait.since(b.wait))},
+            {"service_us", latencyJson(service)},
+        });
+    }
+    r["stages"] = stages;
+    json ev = json::object();
+    {
+        std::lock_guard<std::mutex> lk(evMu);
+        for (const auto& [type, n] : events) ev[type] = n - eventsBase[type];
+    }
+    r["events"] = ev;
+    return r;
+}
+
+// ---------------------------------------------------------------------------
+// Aggregation and baseline comparison
+// ---------------------------------------------------------------------------
+
+static json aggregate(const json& copies) {
+    double fpsSum = 0, fpsMin = 0, cpuPct = 0, cpuS = 0, rssPeak = 0, rssSum = 0;
+    uint64_t frames = 0, ringRejected = 0, processed = 0, dropped = 0;
+    int ok = 0;
+    std::map<std::string, json> st;  // per stage id, merged across copies
+    std::vector<std::string> order;
+    for (const auto& c : copies) {
+        if (!c.value("ok", false)) continue;
+        const double fps = c["fps_in"].get<double>();
+        fpsSum += fps;
+        fpsMin = ok == 0 ? fps : std::min(fpsMin, fps);
+        ++ok;
+        frames += c["frames_in"].get<uint64_t>();
+        ringRejected += c["ring_rejected"].get<uint64_t>();
+        cpuPct += c["cpu_pct"].get<double>();
+        cpuS += c["cpu_s"].get<double>();
+        rssPeak = std::max(rssPeak, c["rss_mb_peak"].get<double>());
+        rssSum += c["rss_mb_peak"].get<double>();
+        for (const auto& s : c["stages"]) {
+            const std::string id = s["id"].get<std::string>();
+            if (!st.count(id)) {
+                order.push_back(id);
+                st[id] = json{{"id", id}, {"plugin", s["plugin"]}, {"processed", 0}, {"dropped", 0},
+                              {"fps_total", 0.0}, {"util_pct_max", 0.0},
+                              {"service_us_p95_max", 0}, {"wait_us_p95_max", 0}};
+            }
+            json& a = st[id];
+            a["processed"] = a["processed"].get<uint64_t>() + s["processed"].get<uint64_t>();
+            a["dropped"] = a["dropped"].get<uint64_t>() + s["dropped"].get<uint64_t>();
+            a["fps_total"] = a["fps_total"].get<double>() + s["fps"].get<double>();
+            a["util_pct_max"] = std::max(a["util_pct_max"].get<double>(), s["util_pct"].get<double>());
+            a["service_us_p95_max"] = std::max(a["service_us_p95_max"].get<uint64_t>(),
+                                               s["service_us"]["p95"].get<uint64_t>());
+            a["wait_us_p95_max"] = std::max(a["wait_us_p95_max"].get<uint64_t>(),
+                                            s["wait_us"]["p95"].get<uint64_t>());
+            processed += s["processed"].get<uint64_t>();
+            dropped += s["dropped"].get<uint64_t>();
+        }
+    }
+    json stages = json::array();
+    std::string bottleneck;
+    double worst = -1;
+    for (const auto& id : order) {
+        json& a = st[id];
+        const uint64_t p = a["processed"], d = a["dropped"];
+        a["drop_rate"] = p + d ? double(d) / double(p + d) : 0.0;
+        // The stage that sheds the most frames, else the busiest one.
+        const double score = a["drop_rate"].get<double>() * 1000 + a["util_pct_max"].get<double>();
+        if (score > worst) worst = score, bottleneck = id;
+        stages.push_back(a);
+    }
+    return json{{"copies_ok", ok},
+                {"frames_in", frames},
+                {"fps_total", fpsSum},
+                {"fps_per_copy_mean", ok ? fpsSum / ok : 0.0},
+                {"fps_per_copy_min", fpsMin},
+                {"cpu_pct_total", cpuPct},
+                {"cpu_ms_per_frame", frames ? 1000.0 * cpuS / frames : 0.0},
+                {"rss_mb_peak_max", rssPeak},
+                {"rss_mb_peak_sum", rssSum},
+                {"ring_rejected", ringRejected},
+                {"stage_dropped", dropped},
+                {"drop_rate", processed + dropped ? double(dropped) / double(processed + dropped) : 0.0},
+                {"bottleneck", bottleneck},
+                {"stages", stages}};
+}
+
+// One metric checked against the baseline: a regression is a move in the bad
+// direction by more than `tolerance` (relative) plus `slack` (absolute, so
+// near-zero metrics don't flap).
+struct Check {
+    std::string metric;
+    double base, cur;
+    bool higherIsBetter;
+    double slack;
+};
+
+static json compare(const json& base, const json& cur, double tol, int& failed) {
+    std::vector<Check> checks;
+    const json& b = base["aggregate"];
+    const json& c = cur["aggregate"];
+    auto num = [](const json& j, const char* k) { return j.contains(k) ? j[k].get<double>() : NAN; };
+    checks.push_back({"fps_per_copy_mean", num(b, "fps_per_copy_mean"), num(c, "fps_per_copy_mean"), true, 0.5});
+    checks.push_back({"cpu_ms_per_frame", num(b, "cpu_ms_per_frame"), num(c, "cpu_ms_per_frame"), false, 0.05});
+    checks.push_back({"rss_mb_peak_max", num(b, "rss_mb_peak_max"), num(c, "rss_mb_peak_max"), false, 8.0});
+    checks.push_back({"drop_rate", num(b, "drop_rate"), num(c, "drop_rate"), false, 0.01});
+    for (const auto& bs : b["stages"]) {
+        for (const auto& cs : c["stages"]) {
+            if (cs["id"] != bs["id"]) continue;
+            const std::string id = bs["id"].get<std::string>();
+            checks.push_back({id + ".service_us_p95", num(bs, "service_us_p95_max"),
+                              num(cs, "service_us_p95_max"), false, 200.0});
+            checks.push_back({id + ".drop_rate", num(bs, "drop_rate"), num(cs, "drop_rate"), false, 0.01});
+        }
+    }
+    json out = json::array();
+    fprintf(stderr, "  %-32s %12s %12s %8s\n", "metric", "baseline", "current", "change");
+    for (const auto& k : checks) {
+        if (std::isnan(k.base) || std::isnan(k.cur)) continue;
+        const bool bad = k.higherIsBetter ? k.cur < k.base * (1 - tol) - k.slack
+                                          : k.cur > k.base * (1 + tol) + k.slack;
+        const double change = k.base != 0 ? (k.cur - k.base) / std::fabs(k.base) : 0.0;
+        failed += bad;
+        fprintf(stderr, "  %-32s %12.3f %12.3f %+7.1f%%%s\n", k.metric.c_str(), k.base, k.cur,
+                100 * change, bad ? "  REGRESSION" : "");
+        out.push_back(json{{"metric", k.metric}, {"baseline", k.base}, {"current", k.cur},
+                           {"change", change}, {"regression", bad}});
+    }
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+
+static json runPipeline(const std::string& path, const Options& o) {
+    const std::string name = fs::path(path).stem().stem().string();  // x.template.json -> x
+    json run{{"pipeline", name}, {"file", path}, {"copies", o.copies}};
+    json root;
+    try {
+        std::ifstream f(path);
+        f >> root;
+    } catch (const std::exception& e) {
+        run["error"] = std::string("cannot parse: ") + e.what();
+        return run;
+    }
+
+    std::vector<std::string> notes;
+    std::vector<std::string> files;
+    for (int k = 0; k < o.copies; ++k) {
+        const std::string dir = o.workdir + "/" + name + "/copy" + std::to_string(k);
+        fs::create_directories(dir);
+        json p = root;
+        std::string err;
+        std::vector<std::string> n;
+        if (p.contains("plugins") && p["plugins"].is_array())
+            for (auto& node : p["plugins"])
+                if (!prepareNode(node, o, k, dir, n, err)) break;
+        if (!err.empty()) {
+            run["error"] = err;
+            return run;
+        }
+        if (k == 0) notes = n;
+        files.push_back(dir + "/pipeline.json");
+        std::ofstream(files.back()) << p.dump(2);
+    }
+    run["notes"] = notes;
+
+    fprintf(stderr, "bench_pipeline: %s x%d ...\n", name.c_str(), o.copies);
+    std::vector<pid_t> pids;
+    for (int k = 0; k < o.copies; ++k) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            const std::string dir = fs::path(files[k]).parent_path().string();
+            if (!o.verbose) {
+                const int fd = open((dir + "/log.txt").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                if (fd >= 0) dup2(fd, 1), dup2(fd, 2), close(fd);
+            }
+            json r;
+            try {
+                r = runCopy(files[k], o, k);
+            } catch (const std::exception& e) {
+                r = json{{"copy", k}, {"ok", false}, {"error", e.what()}};
+            }
+            std::ofstream(dir + "/result.json") << r.dump();
+            fflush(nullptr);
+            _exit(r.value("ok", false) ? 0 : 1);
+        }
+        pids.push_back(pid);
+    }
+    json copies = json::array();
+    for (int k = 0; k < o.copies; ++k) {
+        int status = 0;
+        if (pids[k] > 0) waitpid(pids[k], &status, 0);
+        json r = json{{"copy", k}, {"ok", false}};
+        std::ifstream f(fs::path(files[k]).parent_path() / "result.json");
+        if (pids[k] <= 0) {
+            r["error"] = "fork failed";
+        } else if (WIFSIGNALED(status)) {
+            r["error"] = "killed by signal " + std::to_string(WTERMSIG(status));
+        } else if (f) {
+            r = json::parse(f, nullptr, /*allow_exceptions=*/false);
+            if (r.is_discarded()) r = json{{"copy", k}, {"ok", false}, {"error", "bad result"}};
+        } else {
+            r["error"] = "no result";
+        }
+        if (!r.value("ok", false))
+            fprintf(stderr, "bench_pipeline: %s copy %d failed: %s (log: %s)\n", name.c_str(), k,
+                    r.value("error", std::string("?")).c_str(),
+                    (fs::path(files[k]).parent_path() / "log.txt").c_str());
+        copies.push_back(r);
+    }
+    run["copy_results"] = copies;
+    run["aggregate"] = aggregate(copies);
+    const json& a = run["aggregate"];
+    fprintf(stderr, "bench_pipeline: %s: %d/%d ok, %.1f fps total (%.1f/copy min), %.0f%% CPU, "
+                    "%.2f ms CPU/frame, peak RSS %.0f MiB, drop rate %.3f, bottleneck %s\n",
+            name.c_str(), a["copies_ok"].get<int>(), o.copies, a["fps_total"].get<double>(),
+            a["fps_per_copy_min"].get<double>(), a["cpu_pct_total"].get<double>(),
+            a["cpu_ms_per_frame"].get<double>(), a["rss_mb_peak_max"].get<double>(),
+            a["drop_rate"].get<double>(), a["bottleneck"].get<std::string>().c_str());
+    return run;
+}
+
+int main(int argc, char** argv) {
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        auto nx = [&]() -> std::string { return i + 1 < argc ? argv[++i] : ""; };
+        if (a == "--pipeline") o.pipelines.push_back(nx());
+        else if (a == "--clip") o.clip = nx();
+        else if (a == "--plugins") o.plugins = nx();
+        else if (a == "--copies") o.copies = std::max(1, atoi(nx().c_str()));
+        else if (a == "--duration") o.duration = atof(nx().c_str());
+        else if (a == "--warmup") o.warmup = atof(nx().c_str());
+        else if (a == "--idle-ms") o.idle_ms = atoi(nx().c_str());
+        else if (a == "--timeout") o.timeout = atof(nx().c_str());
+        else if (a == "--out") o.out = nx();
+        else if (a == "--workdir") o.workdir = nx();
+        else if (a == "--baseline") o.baseline = nx();
+        else if (a == "--tolerance") o.tolerance = atof(nx().c_str());
+        else if (a == "--verbose") o.verbose = true;
+        else if (a == "--set") {
+            const std::string kv = nx();
+            const size_t eq = kv.find('=');
+            if (eq == std::string::npos || kv.find('.') > eq) { usage(); return 2; }
+            o.sets.emplace_back(kv.substr(0, eq), kv.substr(eq + 1));
+        } else { usage(); return a == "-h" || a == "--help" ? 0 : 2; }
+    }
+    if (o.pipelines.empty()) { usage(); return 2; }
+    if (o.workdir.empty()) o.workdir = "/tmp/zm_bench_" + std::to_string(getpid());
+    o.plugins = fs::absolute(o.plugins).string();
+    if (!o.clip.empty()) o.clip = fs::absolute(o.clip).string();
+
+    char when[32];
+    const time_t now = time(nullptr);
+    strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    char host[256] = {};
+    gethostname(host, sizeof(host) - 1);
+    json report{{"bench", "bench_pipeline"}, {"version", 1}, {"started", when},
+                {"host", {{"name", host}, {"cpus", std::thread::hardware_concurrency()}}},
+                {"options", {{"clip", o.clip}, {"copies", o.copies}, {"duration_s", o.duration},
+                             {"warmup_s", o.warmup}}},
+                {"runs", json::array()}};
+    bool anyFailed = false;
+    for (const auto& p : o.pipelines) {
+        json run = runPipeline(p, o);
+        if (run.contains("error") ||
+            run["aggregate"]["copies_ok"].get<int>() != o.copies)
+            anyFailed = true;
+        report["runs"].push_back(run);
+    }
+
+    int regressions = 0;
+    if (!o.baseline.empty()) {
+        std::ifstream f(o.baseline);
+        json base = json::parse(f, nullptr, /*allow_exceptions=*/false);
+        if (base.is_discarded() || !base.contains("runs")) {
+            fprintf(stderr, "bench_pipeline: cannot read baseline %s\n", o.baseline.c_str());
+            return 2;
+        }
+        json reg{{"baseline", o.baseline}, {"tolerance", o.tolerance}, {"runs", json::array()}};
+        for (auto& run : report["runs"]) {
+            if (!run.contains("aggregate")) continue;
+            for (const auto& b : base["runs"]) {
+                if (b["pipeline"] != run["pipeline"] || !b.contains("aggregate")) continue;
+                fprintf(stderr, "bench_pipeline: %s vs baseline (%s):\n",
+                        run["pipeline"].get<std::string>().c_str(), o.baseline.c_str());
+                if (b["copies"] != run["copies"])
+                    fprintf(stderr, "  note: baseline ran %d copies\n", b["copies"].get<int>());
+                int failed = 0;
+                json checks = compare(b, run, o.tolerance, failed);
+                regressions += failed;
+                reg["runs"].push_back(json{{"pipeline", run["pipeline"]}, {"failed", failed},
+                                           {"checks", checks}});
+            }
+        }
+        reg["failed"] = regressions;
+        report["regression"] = reg;
+    }
+
+    const std::string text = report.dump(2);
+    if (o.out == "-") {
+        printf("%s\n", text.c_str());
+    } else {
+        std::ofstream(o.out) << text << "\n";
+        fprintf(stderr, "bench_pipeline: report written to %s\n", o.out.c_str());
+    }
+    if (regressions) return 3;
+    return anyFailed ? 1 : 0;
+}
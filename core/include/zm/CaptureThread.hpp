@@ -29,6 +29,13 @@ public:
     // Stop capture loop
     void stop();
 
+    // Frames taken from the ring and handed to the downstream stages.
+    uint64_t frames() const { return frames_.load(std::memory_order_relaxed); }
+
+    // True once the input plugin's start() has returned (it runs on the
+    // capture thread), until the loop exits and stops it again.
+    bool pluginStarted() const { return pluginStarted_.load(std::memory_order_acquire); }
+
 private:
     void run();
 
@@ -40,6 +47,8 @@ private:
 
     std::thread thread_;
     std::atomic<bool> running_{false};
+    std::atomic<uint64_t> frames_{0};
+    std::atomic<bool> pluginStarted_{false};
 };
 
 } // namespace zm
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include "zm_plugin.h"
+
+namespace zm {
+
+// Host-owned cache of recently forwarded decoded frames, exposed to plugins as
+// zm_host_api_t.frame_cache. Each slot, keyed by (stream_id, hw_type, payload
+// size), holds refcounted references to the buffers StageRunner already shares
+// with a stage's children, newest last: depth 1 is a "latest frame" slot,
+// larger depths give a short ring for pts-matched lookups.
+//
+// Idle (publish() is a relaxed load and return) until a plugin calls retain().
+class FrameCache {
+public:
+    using Buffer = std::shared_ptr<const std::vector<uint8_t>>;
+
+    // A slot that has not been published to for this long is dropped (stream
+    // stopped or changed resolution), so it doesn't pin a full frame forever.
+    static constexpr std::chrono::seconds kSlotIdle{10};
+
+    // Keep at least `frames` frames per slot; enables the cache.
+    void retain(size_t frames);
+    size_t depth() const { return depth_.load(std::memory_order_relaxed); }
+
+    // Offer a forwarded [zm_frame_hdr_t][payload] buffer. Only decoded CPU frame
+    // types are kept; a repeat of the newest pts (a pass-through stage
+    // re-forwarding it) is ignored and a pts that goes backwards restarts the slot.
+    void publish(const Buffer& frame);
+
+    // Newest frame for the stream/type; `bytes` = payload size, 0 = any slot.
+    Buffer latest(uint32_t stream_id, uint32_t hw_type, uint32_t bytes) const;
+    // Frame nearest `pts_usec` within `tolerance_usec`, or null.
+    Buffer at(uint32_t stream_id, uint32_t hw_type, uint32_t bytes, uint64_t pts_usec,
+              uint64_t tolerance_usec) const;
+
+    size_t slots() const;
+
+private:
+    using Key = std::tuple<uint32_t, uint32_t, uint32_t>;  // stream, hw_type, bytes
+    struct Slot {
+        std::deque<Buffer> frames;
+        std::chrono::steady_clock::time_point last_publish;
+    };
+
+    template <typename Fn>
+    void forEachSlot(uint32_t stream_id, uint32_t hw_type, uint32_t bytes, Fn&& fn) const;
+
+    std::atomic<size_t> depth_{0};
+    mutable std::mutex mutex_;
+    std::map<Key, Slot> slots_;
+};
+
+} // namespace zm
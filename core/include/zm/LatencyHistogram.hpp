@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace zm {
+
+// Microsecond latency histogram: exact below 8 us, then each power of two is
+// split into 4 linear sub-buckets (so a percentile is within 25% of the true
+// value). One thread records; any thread may take a snapshot. Recording is a
+// few relaxed atomic adds, cheap enough for every frame of every stage.
+class LatencyHistogram {
+public:
+    static constexpr int kBuckets = 160;  // up to 2^40 us
+
+    struct Snapshot {
+        std::array<uint64_t, kBuckets> counts{};
+        uint64_t count = 0;
+        uint64_t sum_us = 0;
+        uint64_t max_us = 0;
+
+        double mean_us() const { return count ? static_cast<double>(sum_us) / count : 0.0; }
+
+        // Upper bound of the bucket holding the q-quantile (0 < q <= 1),
+        // capped at the largest recorded value. 0 when empty.
+        uint64_t percentile_us(double q) const {
+            if (count == 0) return 0;
+            uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count) + 0.5);
+            if (rank < 1) rank = 1;
+            if (rank > count) rank = count;
+            uint64_t seen = 0;
+            for (int b = 0; b < kBuckets; ++b) {
+                seen += counts[b];
+                if (seen >= rank) {
+                    const uint64_t hi = bucket_upper(b);
+                    return hi < max_us ? hi : max_us;
+                }
+            }
+            return max_us;
+        }
+
+        // What was recorded between `older` and this snapshot. The maximum
+        // cannot be windowed, so the newer one is kept.
+        Snapshot since(const Snapshot& older) const {
+            Snapshot d = *this;
+            for (int b = 0; b < kBuckets; ++b) d.counts[b] -= older.counts[b];
+            d.count -= older.count;
+            d.sum_us -= older.sum_us;
+            return d;
+        }
+    };
+
+    void record(uint64_t us) {
+        counts_[bucket(us)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(us, std::memory_order_relaxed);
+        if (us > max_.load(std::memory_order_relaxed)) max_.store(us, std::memory_order_relaxed);
+    }
+
+    Snapshot snapshot() const {
+        Snapshot s;
+        for (int b = 0; b < kBuckets; ++b) s.counts[b] = counts_[b].load(std::memory_order_relaxed);
+        // The total is the sum of the buckets read, so percentiles stay
+        // consistent while the recorder runs.
+        for (uint64_t c : s.counts) s.count += c;
+        s.sum_us = sum_.load(std::memory_order_relaxed);
+        s.max_us = max_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    static int bucket(uint64_t us) {
+        if (us < 4) return static_cast<int>(us);
+        const int octave = 63 - __builtin_clzll(us);  // >= 2
+        const int b = 4 * (octave - 1) + static_cast<int>((us >> (octave - 2)) & 3);
+        return b < kBuckets ? b : kBuckets - 1;
+    }
+
+    static uint64_t bucket_upper(int b) {
+        if (b < 4) return static_cast<uint64_t>(b);
+        const int octave = b / 4 + 1;
+        const uint64_t step = uint64_t{1} << (octave - 2);
+        return (static_cast<uint64_t>(4 + b % 4) << (octave - 2)) + step - 1;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+}  // namespace zm
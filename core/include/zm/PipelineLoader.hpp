@@ -20,11 +20,16 @@ public:
     // Get parsed pipeline (vector of PluginConfig)
     const std::vector<PluginConfig>& getPipeline() const;
 
+    // Root "rate_control" settings (true, or an object of RateControlConfig
+    // fields); disabled when absent.
+    const RateControlConfig& getRateControl() const { return rateControl_; }
+
     // Progress info for last load
     void printProgress() const;
 private:
     std::string path_;
     std::vector<PluginConfig> pipeline_;
+    RateControlConfig rateControl_;
     // For progress/debug
     std::vector<std::string> progress_msgs_;
 };
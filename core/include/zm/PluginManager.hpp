@@ -5,17 +5,24 @@
 #include <string>
 #include "zm_plugin.h"
 #include "zm/CaptureThread.hpp"
+#include "zm/RateController.hpp"
 #include "zm/ShmRing.hpp"
+#include "zm/StageRunner.hpp"
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 namespace zm {
 
 class WorkerLink;   // optional media sink handed to the CaptureThread
-class StageRunner;  // per-stage thread + bounded drop-queue
+class FrameCache;   // shared decoded-frame cache (zm_host_api_t.frame_cache)
 
 // Manages dynamic loading and lifecycle of C plugins for a pipeline
 struct PluginConfig {
+    // Node "id" from the pipeline JSON (may be empty).
+    std::string id;
     std::string path;
     std::string config_json;
     // Indices (into the flattened pipeline vector) of this node's downstream
@@ -23,9 +30,16 @@ struct PluginConfig {
     // topology so the engine can route frames stage-to-stage instead of fanning
     // the captured frame flat to every plugin.
     std::vector<int> children;
+    // Which output of a multi-output parent this node consumes (see
+    // ZM_FRAME_OUTPUT). 0 = the parent's primary output.
+    int output = 0;
     // Bounded input-queue depth for this stage's thread (drop-oldest when full).
     // Small for low-latency detectors; large for recorders that shouldn't drop.
     int queue_depth = 16;
+    // Whether backpressure rate control watches this stage's queue (node key
+    // "rate_control": false opts out, e.g. for a recorder that must not cause
+    // upstream decimation).
+    bool rate_control = true;
 };
 
 class PluginManager {
@@ -47,6 +61,11 @@ public:
     // instance (e.g. per monitor). Set before startAll().
     void setRingName(const std::string& name) { ringName_ = name; }
 
+    // Backpressure rate control: while running, congested stages ask their
+    // nearest upstream plugin that exports zm_plugin_control to decimate.
+    // Set before startAll().
+    void setRateControl(const RateControlConfig& cfg) { rateCfg_ = cfg; }
+
     // Start all plugins in the pipeline
     void startAll();
     // Stop all plugins in the pipeline
@@ -58,12 +77,40 @@ public:
     // Get the raw handle for the plugin at index
     void* getHandle(size_t index) const;
 
+    // Per-stage counters and latencies of the running pipeline, one entry per
+    // non-input plugin in pipeline order. Empty before startAll().
+    struct StageStatus {
+        std::string id;
+        std::string path;
+        StageRunner::Stats stats;
+    };
+    std::vector<StageStatus> stageStats() const;
+
+    // Frames the capture thread delivered downstream, and frames the input
+    // plugin produced that the ring refused (full or oversized).
+    struct CaptureStatus {
+        uint64_t frames = 0;
+        uint64_t ring_rejected = 0;
+    };
+    CaptureStatus captureStats() const;
+
 private:
     struct PluginInstance {
         void* handle;
         zm_plugin_t plugin;
         PluginConfig config;
+        zm_plugin_control_fn control = nullptr;  // optional ZM_PLUGIN_CONTROL_SYMBOL
+    };
+    // One rate-controlled producer and the stages whose queues drive it.
+    struct RateTarget {
+        size_t producer;
+        std::vector<size_t> stages;
+        RateController policy;
+        int sent = 1;  // keep_every last delivered to the producer
     };
+    void startRateControl(size_t inputIdx);
+    void stopRateControl();
+    void rateControlLoop();
     std::vector<void*> handles_; // legacy
     std::vector<PluginInstance> pipeline_;
     // For main pipeline: manage ring and capture thread
@@ -71,10 +118,21 @@ private:
     std::unique_ptr<class CaptureThread> captureThread_;
     WorkerLink* link_ = nullptr;  // not owned
     std::string ringName_ = "zm_shmring";
+    // Latest/recent decoded frames forwarded between stages, shared with plugins
+    // through zm_host_api_t.frame_cache. Declared before runners_ so it outlives
+    // every stage thread that publishes to it.
+    std::unique_ptr<FrameCache> frameCache_;
     // One StageRunner (thread + bounded drop-queue) per non-input plugin. Used as
     // the host_ctx for each plugin so host->on_frame routes to that stage's
     // children's queues, decoupling stages so a slow one can't stall the rest.
     std::vector<std::unique_ptr<StageRunner>> runners_;
+    RateControlConfig rateCfg_;
+    size_t inputIdx_ = 0;
+    std::vector<RateTarget> rateTargets_;
+    std::thread rateThread_;
+    std::mutex rateMutex_;
+    std::condition_variable rateCv_;
+    bool rateStop_ = false;
 };
 
 } // namespace zm
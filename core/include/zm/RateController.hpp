@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace zm {
+
+// Pipeline-level backpressure rate control ("rate_control" in the pipeline
+// JSON). Off unless enabled.
+struct RateControlConfig {
+    bool enabled = false;
+    int interval_ms = 500;     // how often stage queues are sampled
+    double high_water = 0.75;  // queue fill fraction that counts as congested
+    double low_water = 0.25;   // ... and at or below which a stage is calm
+    double drop_rate = 0.05;   // dropped / offered per interval that counts as congested
+    int max_decimation = 8;    // largest keep_every ever requested
+    int recover_ticks = 6;     // calm intervals before stepping keep_every back down
+};
+
+// Decimation policy for one producer (a stage or input that exports
+// zm_plugin_control) fed by the queues of the stages it drives. Each tick
+// takes the stages' cumulative counters; congestion doubles keep_every (then
+// waits two ticks for the change to reach the queues), and recover_ticks
+// calm ticks in a row step it back down by one, so the producer probes its
+// way back to full rate.
+class RateController {
+public:
+    struct Sample {
+        uint64_t processed = 0;
+        uint64_t dropped = 0;
+        size_t depth = 0;
+        size_t max_depth = 0;
+    };
+
+    explicit RateController(const RateControlConfig& cfg) : cfg_(cfg) {}
+
+    // Returns true when keep_every() changed on this tick.
+    bool update(const std::vector<Sample>& stages) {
+        if (last_.size() != stages.size()) {  // first tick: no deltas yet
+            last_ = stages;
+            return false;
+        }
+        int hot = -1;
+        bool calm = true;
+        for (size_t i = 0; i < stages.size(); ++i) {
+            const Sample& s = stages[i];
+            const uint64_t dp = s.processed - last_[i].processed;
+            const uint64_t dd = s.dropped - last_[i].dropped;
+            const double fill = s.max_depth ? static_cast<double>(s.depth) / s.max_depth : 0.0;
+            const bool dropping = dd > 0 && static_cast<double>(dd) > cfg_.drop_rate * (dp + dd);
+            if (hot < 0 && (dropping || fill >= cfg_.high_water)) hot = static_cast<int>(i);
+            if (dd > 0 || fill > cfg_.low_water) calm = false;
+        }
+        last_ = stages;
+        if (cooldown_ > 0) --cooldown_;
+
+        const int maxKeep = std::max(1, cfg_.max_decimation);
+        if (hot >= 0) {
+            calm_ticks_ = 0;
+            congested_ = hot;
+            if (cooldown_ > 0 || keep_every_ >= maxKeep) return false;
+            keep_every_ = std::min(maxKeep, keep_every_ * 2);
+            cooldown_ = 2;
+            return true;
+        }
+        if (!calm) {
+            calm_ticks_ = 0;
+            return false;
+        }
+        if (keep_every_ == 1 || ++calm_ticks_ < std::max(1, cfg_.recover_ticks)) return false;
+        calm_ticks_ = 0;
+        --keep_every_;
+        if (keep_every_ == 1) congested_ = -1;
+        return true;
+    }
+
+    // Keep 1 of every keep_every() frames (1 = full rate).
+    int keep_every() const { return keep_every_; }
+    // Index (into the update() vector) of the stage that last raised
+    // keep_every, or -1 once back at full rate.
+    int congested() const { return congested_; }
+
+private:
+    RateControlConfig cfg_;
+    std::vector<Sample> last_;
+    int keep_every_ = 1;
+    int cooldown_ = 0;
+    int calm_ticks_ = 0;
+    int congested_ = -1;
+};
+
+}  // namespace zm
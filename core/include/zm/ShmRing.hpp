@@ -1,5 +1,6 @@
 #pragma once
 #include <cstddef>
+#include <cstdint>
 #include <atomic>
 #include <string>
 #include <boost/interprocess/shared_memory_object.hpp>
@@ -22,6 +23,10 @@ public:
     // Wake any blocked pop() so it returns false. Used during shutdown.
     void cancel();
 
+    // push() calls refused because the ring was full or the frame larger
+    // than a slot (counted in this process only).
+    uint64_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
+
 private:
     struct Header {
         std::atomic<size_t> head;
@@ -38,6 +43,7 @@ private:
     char* buffer_;
     std::string name_;
     std::atomic<bool> cancelled_{false};
+    std::atomic<uint64_t> rejected_{0};
 };
 
 } // namespace zm
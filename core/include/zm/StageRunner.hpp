@@ -1,34 +1,66 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
 #include <deque>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
 
 #include "zm_plugin.h"
+#include "zm/LatencyHistogram.hpp"
 
 namespace zm {
 
+class FrameCache;
+
 // Runs one pipeline stage (plugin) on its own thread with a bounded, drop-oldest
 // input queue. Decouples stages so a slow stage (e.g. a heavy detector) drops its
 // own backlog instead of stalling capture, recording, or sibling branches.
 //
-// Frames are delivered as owned copies of the [zm_frame_hdr_t][payload] buffer.
+// Frames are queued as immutable, refcounted [zm_frame_hdr_t][payload] buffers.
 // A plugin's on_frame runs on this runner's thread; when it forwards downstream
 // via host->on_frame, the host routes that to forwardToChildren(), which copies
-// into each child runner's queue.
+// the frame once and shares that buffer between the child queues (and the
+// host FrameCache, when set).
 class StageRunner {
 public:
+    using Buffer = std::shared_ptr<const std::vector<uint8_t>>;
+
+    // Point-in-time view of the stage for monitoring and benchmarks.
+    struct Stats {
+        uint64_t processed = 0;
+        uint64_t dropped = 0;
+        size_t depth = 0;       // frames queued now
+        size_t max_depth = 0;   // configured bound
+        size_t high_water = 0;  // deepest the queue has been
+        bool busy = false;      // on_frame in progress
+        LatencyHistogram::Snapshot wait;     // enqueue -> dequeue
+        LatencyHistogram::Snapshot service;  // on_frame duration
+    };
+
     StageRunner(zm_plugin_t* plugin, size_t max_depth);
     ~StageRunner();
 
     StageRunner(const StageRunner&) = delete;
     StageRunner& operator=(const StageRunner&) = delete;
 
-    void setChildren(std::vector<StageRunner*> children) { children_ = std::move(children); }
+    // `outputs[i]` is the parent output index child i consumes (default 0 for
+    // every child); see ZM_FRAME_OUTPUT.
+    void setChildren(std::vector<StageRunner*> children, std::vector<int> outputs = {}) {
+        outputs.resize(children.size(), 0);
+        children_ = std::move(children);
+        child_outputs_ = std::move(outputs);
+    }
+
+    // Cache that forwarded frames are published to (not owned; may be null).
+    // Plugins reach it through zm_host_api_t.frame_cache with this runner as
+    // host_ctx.
+    void setFrameCache(FrameCache* cache) { cache_ = cache; }
+    FrameCache* frameCache() const { return cache_; }
 
     void start();
     void stop();
@@ -36,28 +68,50 @@ public:
     // Enqueue a copy of the frame for this stage; drops the oldest queued frame
     // if the queue is full. Thread-safe; never blocks the caller.
     void deliver(const void* buf, size_t size);
+    // Enqueue a shared buffer without copying. The output tag must already be
+    // clear.
+    void deliver(Buffer frame);
 
-    // Forward a produced frame to every downstream child (copies into their
-    // queues). Called from the chain host->on_frame hook.
+    // Forward a produced frame to every downstream child consuming its output
+    // index: one copy, shared by their queues. Called from the chain
+    // host->on_frame hook.
     void forwardToChildren(const void* buf, size_t size);
+    // Same, with side-data `entries` (encoded zm_side_data_entry_t records)
+    // folded into that copy; they replace upstream entries of the same type.
+    // Called from host->on_frame_side_data.
+    void forwardToChildren(const void* buf, size_t size, const void* entries,
+                           size_t entries_size);
 
     uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
     uint64_t processed() const { return processed_.load(std::memory_order_relaxed); }
+    Stats stats() const;
 
 private:
+    using Clock = std::chrono::steady_clock;
+    struct Queued {
+        Buffer frame;
+        Clock::time_point enqueued;
+    };
+
     void run();
 
     zm_plugin_t* plugin_;
     size_t max_depth_;
     std::vector<StageRunner*> children_;
+    std::vector<int> child_outputs_;
+    FrameCache* cache_ = nullptr;
 
-    std::deque<std::vector<uint8_t>> queue_;
-    std::mutex mutex_;
+    std::deque<Queued> queue_;
+    size_t high_water_ = 0;
+    mutable std::mutex mutex_;
     std::condition_variable cv_;
     std::thread thread_;
     std::atomic<bool> running_{false};
     std::atomic<uint64_t> dropped_{0};
     std::atomic<uint64_t> processed_{0};
+    std::atomic<bool> busy_{false};
+    LatencyHistogram wait_;
+    LatencyHistogram service_;
 };
 
 } // namespace zm
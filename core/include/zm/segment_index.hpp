@@ -0,0 +1,136 @@
+// Keyframe/time index sidecar for recorded segments.
+//
+// store writes one `<clip>.idx` next to every recorded clip/segment while it
+// records: the byte offset of each keyframe cluster plus trigger event markers.
+// A reader (zm-api, the seg_extract tool) can then map a time range to a byte
+// range with a binary search and cut a clip by copying bytes, without opening a
+// demuxer or seeking through the media file.
+//
+// File layout (all integers little-endian):
+//   header (32 bytes)
+//     u8[8] magic        "ZMSIDX1\0"
+//     u32   version      currently 1
+//     u32   reserved     0
+//     i64   start_pts_us absolute capture pts of the clip's first packet
+//     i64   wall_time    unix seconds when the clip was opened
+//   records (repeated until EOF; appended as the clip is written)
+//     i64   pts_us       relative to start_pts_us (== the muxer's timestamps)
+//     i64   offset       byte offset in the media file (see RecordKind)
+//     u16   kind         RecordKind
+//     u16   tag_len      bytes of tag that follow the fixed part
+//     u32   reserved     0
+//     u8[]  tag          tag_len bytes, zero-padded to a multiple of 8
+//
+// Records are append-only so a crash mid-recording still leaves a usable index
+// (everything up to the last flushed keyframe); an End record marks a clip that
+// was closed cleanly. Unknown record kinds must be skipped by readers.
+
+#ifndef ZM_SEGMENT_INDEX_HPP
+#define ZM_SEGMENT_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace zm {
+namespace segment_index {
+
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 32;
+constexpr size_t kRecordFixedSize = 24;
+constexpr uint16_t kMaxTagLen = 256;
+extern const uint8_t kMagic[8];
+
+enum class RecordKind : uint16_t {
+  // offset = first byte of the cluster that starts with this keyframe. The
+  // first keyframe's offset is also the size of the container header.
+  Keyframe = 1,
+  // A trigger event during the clip; tag = event type, offset = the keyframe
+  // cluster containing it (where a cut covering the event must start).
+  Event = 2,
+  // Clean close; offset = final file size, pts_us = clip duration.
+  End = 3,
+};
+
+struct Record {
+  int64_t pts_us = 0;
+  int64_t offset = 0;
+  RecordKind kind = RecordKind::Keyframe;
+  std::string tag;
+};
+
+// Encoders: produce the exact bytes appended to an index file.
+std::vector<uint8_t> EncodeHeader(int64_t start_pts_us, int64_t wall_time);
+std::vector<uint8_t> EncodeRecord(const Record &record);
+
+// Parsed index. `keyframes` is sorted by pts (append order).
+struct Index {
+  int64_t start_pts_us = 0;
+  int64_t wall_time = 0;
+  std::vector<Record> keyframes;
+  std::vector<Record> events;
+  bool complete = false;         // an End record was present
+  int64_t file_size = 0;         // from End, else 0
+  int64_t duration_us = 0;       // from End, else the last keyframe pts
+
+  // Container header size (bytes before the first cluster); 0 if no keyframes.
+  int64_t header_bytes() const { return keyframes.empty() ? 0 : keyframes.front().offset; }
+};
+
+// Parse a whole index file image. A truncated trailing record (crash while
+// appending) is ignored, not an error.
+bool Parse(const uint8_t *data, size_t size, Index &out, std::string *error = nullptr);
+bool Load(const std::string &path, Index &out, std::string *error = nullptr);
+
+// Keyframe-aligned byte range covering [from_us, to_us] (clip-relative pts).
+// begin = cluster of the last keyframe <= from_us; end = the first keyframe
+// cluster after to_us, or `media_size` / the indexed file size if none.
+struct ByteRange {
+  int64_t begin = 0;
+  int64_t end = 0;
+  int64_t first_pts_us = 0;      // pts of the keyframe the range starts at
+};
+bool RangeFor(const Index &index, int64_t from_us, int64_t to_us, int64_t media_size,
+              ByteRange &out);
+
+// Cut [from_us, to_us] out of `media_path` by byte copy: the container header
+// followed by the keyframe-aligned cluster range. No demuxing.
+bool ExtractRange(const std::string &media_path, const Index &index, int64_t from_us,
+                  int64_t to_us, const std::string &out_path, std::string *error = nullptr);
+
+// Incremental writer used while recording. Not thread-safe; owned by the
+// recorder's writer thread.
+class Writer {
+ public:
+  Writer() = default;
+  ~Writer();
+  Writer(const Writer &) = delete;
+  Writer &operator=(const Writer &) = delete;
+
+  bool Open(const std::string &path, int64_t start_pts_us, int64_t wall_time);
+  bool IsOpen() const { return file_ != nullptr; }
+  const std::string &path() const { return path_; }
+
+  void AddKeyframe(int64_t pts_us, int64_t offset);
+  void AddEvent(int64_t pts_us, const std::string &type);
+  // Push buffered records to the kernel (called at the recorder's flush points).
+  void Flush();
+  // Follow a rename of the media file (the open FILE keeps writing the inode).
+  bool Rename(const std::string &new_path);
+  // Write the End record and close.
+  void Close(int64_t duration_us, int64_t file_size);
+
+ private:
+  void Append(const Record &record);
+
+  std::FILE *file_ = nullptr;
+  std::string path_;
+  int64_t last_keyframe_offset_ = 0;
+};
+
+} // namespace segment_index
+} // namespace zm
+
+#endif // ZM_SEGMENT_INDEX_HPP
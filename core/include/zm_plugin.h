@@ -48,6 +48,35 @@ typedef enum zm_hw_type_e {
     ZM_FRAME_COMPRESSED_AUDIO = 104  // Compressed audio (AAC, Opus, G.711, ...)
 } zm_hw_type_t;
 
+// Opaque reference to a frame held by the host frame cache (see below).
+typedef struct zm_frame_ref_s zm_frame_ref_t;
+
+// Host-owned cache of recently forwarded decoded frames (ZM_FRAME_RGB24 /
+// ZM_FRAME_GRAYSCALE / ZM_FRAME_YUV420P), one slot per (stream_id, hw_type,
+// payload size). The slot holds a reference to the same buffer the host already
+// queued for the producing stage's children, so caching costs no copy. Plugins
+// that only look at a frame occasionally (snapshots, VLM prompts, cutouts)
+// acquire a reference on demand instead of copying every frame they see.
+//
+// The cache is idle until some plugin calls retain(). A reference stays valid
+// (and its bytes immutable) until release(); all calls are thread-safe.
+typedef struct zm_frame_cache_api_s {
+    // Keep at least `frames` recent frames per slot (1 = latest only). The
+    // largest request across plugins wins. Call once from start().
+    void (*retain)(void* host_ctx, uint32_t frames);
+    // Newest cached frame of `stream_id` / `hw_type`; `bytes` selects the payload
+    // size (0 = any). On success *frame / *size describe the whole
+    // [zm_frame_hdr_t][payload] buffer. Returns NULL if nothing is cached.
+    zm_frame_ref_t* (*acquire_latest)(void* host_ctx, uint32_t stream_id, uint32_t hw_type,
+                                      uint32_t bytes, const void** frame, size_t* size);
+    // Cached frame whose pts is nearest `pts_usec`, if within `tolerance_usec`.
+    zm_frame_ref_t* (*acquire_at)(void* host_ctx, uint32_t stream_id, uint32_t hw_type,
+                                  uint32_t bytes, uint64_t pts_usec, uint64_t tolerance_usec,
+                                  const void** frame, size_t* size);
+    // Drop a reference returned by acquire_latest / acquire_at.
+    void (*release)(void* host_ctx, zm_frame_ref_t* ref);
+} zm_frame_cache_api_t;
+
 // Host API for plugins to call
 typedef struct zm_host_api_s {
     // Logger with different severity levels
@@ -66,8 +95,15 @@ typedef struct zm_host_api_s {
                            void* user);
     // Remove a subscription created with subscribe_evt.
     void (*unsubscribe_evt)(void* host_ctx, void* handle);
-    // Reserved for future extensions of the API
-    void* reserved[2];
+    // Shared decoded-frame cache. NULL when the host does not provide one (e.g.
+    // for input plugins), so always check before use.
+    const zm_frame_cache_api_t* frame_cache;
+    // Like on_frame, but the forwarded copy also carries `entries` (encoded
+    // zm_side_data_entry_t records, see zm_side_data.h) as frame side data,
+    // replacing upstream entries of the same types. NULL on hosts without side
+    // data support: fall back to on_frame.
+    void (*on_frame_side_data)(void* host_ctx, const void* frame_hdr, size_t frame_size,
+                               const void* entries, size_t entries_size);
 } zm_host_api_t;
 
 // Frame header prefixed to each media packet/frame
@@ -80,6 +116,19 @@ typedef struct zm_frame_hdr_s {
     uint64_t pts_usec;         // Presentation timestamp in microseconds
 } zm_frame_hdr_t;
 
+// zm_frame_hdr_t.flags bits.
+#define ZM_FRAME_FLAG_KEYFRAME 0x1u
+// A side-data block follows the payload (see zm_side_data.h).
+#define ZM_FRAME_FLAG_SIDE_DATA 0x2u
+// Multi-output stages (e.g. decode_ffmpeg's resolution pyramid) tag each frame
+// with the index of the output it belongs to in the top byte of flags. The host
+// routes a tagged frame only to the children that selected that output
+// ("output" on the child node in the pipeline JSON; default 0) and clears the
+// tag on delivery, so single-output plugins never see it.
+#define ZM_FRAME_OUTPUT_SHIFT 24
+#define ZM_FRAME_OUTPUT_MASK 0xff000000u
+#define ZM_FRAME_OUTPUT(flags) (((flags) & ZM_FRAME_OUTPUT_MASK) >> ZM_FRAME_OUTPUT_SHIFT)
+
 // Descriptor for a frame that lives on a GPU/accelerator surface (zero-copy
 // path). When a frame's hw_type is a GPU type (ZM_HW_CUDA / ZM_HW_VAAPI /
 // ZM_HW_VTB), the on_frame payload after the zm_frame_hdr_t is THIS struct, not
@@ -117,6 +166,21 @@ typedef struct zm_plugin_s {
 #define ZM_PLUGIN_EXPORT_SYMBOL "zm_plugin_init"
 typedef void (*zm_plugin_init_fn)(zm_plugin_t*);
 
+// Optional control entry point. A plugin that can shed work on request exports
+// it; the host looks it up next to zm_plugin_init and only calls it between the
+// plugin's start() and stop(), from a host thread (not the one running
+// on_frame), so a handler should just record the request (e.g. in an atomic)
+// for on_frame to pick up. `json_msg` is valid for the duration of the call.
+//
+// Messages sent by the host today:
+//   {"type":"rate_control","keep_every":N,"stage":"<id>","reason":"backpressure"|"recovered"}
+//     Downstream stage <id> is congested (or has recovered): forward only 1 of
+//     every N frames (N = 1 restores full rate), shedding the skipped frames as
+//     early and as cheaply as possible.
+// Unknown message types must be ignored.
+#define ZM_PLUGIN_CONTROL_SYMBOL "zm_plugin_control"
+typedef void (*zm_plugin_control_fn)(zm_plugin_t* plugin, const char* json_msg);
+
 // =============================================================================
 // PLUGIN LOGGING UTILITIES
 // =============================================================================
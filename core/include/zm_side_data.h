@@ -0,0 +1,146 @@
+#pragma once
+
+// Frame side data: typed metadata that travels WITH a frame instead of as a
+// separate event, so a downstream stage reads e.g. the motion boxes of exactly
+// this frame without correlating events by pts.
+//
+// Layout of a frame carrying side data (ZM_FRAME_FLAG_SIDE_DATA set in flags):
+//
+//   [zm_frame_hdr_t][payload][entry][entry]...[zm_side_data_trailer_t]
+//
+// Each entry is a zm_side_data_entry_t followed by `bytes` of value, padded to
+// 8 bytes. The trailer at the very end gives the size of the whole block, so
+// the payload is everything between the header and the first entry
+// (zm_frame_payload_size). Plugins that only check size >= header + expected
+// payload keep working unchanged; plugins that take "the rest of the buffer"
+// as payload should use zm_frame_payload_size().
+//
+// Producers do not build the block themselves: they pass encoded entries to
+// zm_host_api_t.on_frame_side_data, which appends them while making the copy it
+// makes for every forwarded frame anyway. An entry replaces any upstream entry
+// of the same type. Readers use zm_side_data_find().
+
+#include "zm_plugin.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ZM_SIDE_DATA_MAGIC 0x44535a5au  // "ZZSD"
+
+typedef enum {
+    ZM_SIDE_MOTION_BOXES = 1,   // zm_side_box_t[]: changed regions, source pixels
+    ZM_SIDE_MOTION_GRID = 2,    // zm_side_motion_grid_t + cols*rows bytes: changed
+                                // samples per cell, saturating at 255 (0 = still)
+    ZM_SIDE_SCENE_SCORE = 3,    // float: fraction of the frame that changed, 0..1
+    ZM_SIDE_PRIVACY_MASK = 4,   // zm_side_box_t[]: areas to blank before output
+    ZM_SIDE_TRACK_BOXES = 5,    // zm_side_track_box_t[]
+    ZM_SIDE_USER = 0x8000       // first id for plugin-private types
+} zm_side_data_type_t;
+
+typedef struct zm_side_data_entry_s {
+    uint32_t type;    // zm_side_data_type_t
+    uint32_t bytes;   // value size, excluding padding
+} zm_side_data_entry_t;
+
+typedef struct zm_side_data_trailer_s {
+    uint32_t bytes;   // whole block: entries + padding + this trailer
+    uint32_t magic;   // ZM_SIDE_DATA_MAGIC
+} zm_side_data_trailer_t;
+
+typedef struct zm_side_box_s {
+    int32_t x, y, w, h;
+} zm_side_box_t;
+
+typedef struct zm_side_motion_grid_s {
+    uint16_t cols, rows;        // grid size; cols*rows cell bytes follow
+    uint16_t cell_w, cell_h;    // source pixels per cell
+} zm_side_motion_grid_t;
+
+typedef struct zm_side_track_box_s {
+    int32_t track_id;
+    int32_t class_id;
+    int32_t x, y, w, h;
+} zm_side_track_box_t;
+
+static inline size_t zm_side_data_pad(size_t n) { return (n + 7u) & ~(size_t)7u; }
+
+// Size of the side-data block of a frame (0 when it has none or it is malformed).
+static inline size_t zm_frame_side_data_size(const void* frame, size_t size) {
+    if (!frame || size < sizeof(zm_frame_hdr_t) + sizeof(zm_side_data_trailer_t)) return 0;
+    const zm_frame_hdr_t* hdr = (const zm_frame_hdr_t*)frame;
+    if (!(hdr->flags & ZM_FRAME_FLAG_SIDE_DATA)) return 0;
+    zm_side_data_trailer_t t;
+    memcpy(&t, (const uint8_t*)frame + size - sizeof(t), sizeof(t));
+    if (t.magic != ZM_SIDE_DATA_MAGIC || t.bytes < sizeof(t) ||
+        t.bytes > size - sizeof(zm_frame_hdr_t))
+        return 0;
+    return t.bytes;
+}
+
+// Payload bytes of a frame: everything after the header, minus any side data.
+static inline size_t zm_frame_payload_size(const void* frame, size_t size) {
+    if (!frame || size < sizeof(zm_frame_hdr_t)) return 0;
+    return size - sizeof(zm_frame_hdr_t) - zm_frame_side_data_size(frame, size);
+}
+
+// Walk the entries of `frame`: pass *cursor = 0 to start. Returns 1 and fills
+// *type / *value / *bytes for the next entry, 0 when done. Entries follow the
+// payload unaligned, so copy values out (memcpy) rather than casting *value.
+static inline int zm_side_data_next(const void* frame, size_t size, size_t* cursor,
+                                    uint32_t* type, const void** value, size_t* bytes) {
+    const size_t block = zm_frame_side_data_size(frame, size);
+    if (!block || !cursor) return 0;
+    const size_t begin = size - block;
+    const size_t end = size - sizeof(zm_side_data_trailer_t);
+    const size_t at = begin + *cursor;
+    if (at + sizeof(zm_side_data_entry_t) > end) return 0;
+    zm_side_data_entry_t e;
+    memcpy(&e, (const uint8_t*)frame + at, sizeof(e));
+    const size_t span = sizeof(e) + zm_side_data_pad(e.bytes);
+    if (e.bytes > end - at - sizeof(e) || span > end - at) return 0;
+    *cursor += span;
+    if (type) *type = e.type;
+    if (value) *value = (const uint8_t*)frame + at + sizeof(e);
+    if (bytes) *bytes = e.bytes;
+    return 1;
+}
+
+// Value of the first entry of `type` (unaligned; see above); *bytes receives
+// its size. NULL if absent.
+static inline const void* zm_side_data_find(const void* frame, size_t size, uint32_t type,
+                                            size_t* bytes) {
+    size_t cursor = 0, n = 0;
+    uint32_t t = 0;
+    const void* v = NULL;
+    while (zm_side_data_next(frame, size, &cursor, &t, &v, &n)) {
+        if (t != type) continue;
+        if (bytes) *bytes = n;
+        return v;
+    }
+    return NULL;
+}
+
+// Encode one entry into `dst` (capacity `cap`) for on_frame_side_data. Returns
+// the bytes written (header + padded value), or 0 if it does not fit.
+static inline size_t zm_side_data_put(void* dst, size_t cap, uint32_t type, const void* value,
+                                      size_t bytes) {
+    const size_t span = sizeof(zm_side_data_entry_t) + zm_side_data_pad(bytes);
+    if (!dst || span > cap || bytes > UINT32_MAX) return 0;
+    zm_side_data_entry_t e;
+    e.type = type;
+    e.bytes = (uint32_t)bytes;
+    memcpy(dst, &e, sizeof(e));
+    uint8_t* v = (uint8_t*)dst + sizeof(e);
+    if (bytes) memcpy(v, value, bytes);
+    memset(v + bytes, 0, span - sizeof(e) - bytes);
+    return span;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,6 +2,7 @@
 #include "zm/EventBus.hpp"
 #include "zm/WorkerLink.hpp"
 #include "zm/StageRunner.hpp"
+#include "zm/FrameCache.hpp"
 #include <cstring>
 #include <iostream>
 #include <chrono>
@@ -101,7 +102,8 @@ void CaptureThread::run() {
     void* host_ctx = &ring_;
     if (inputPlugin_->start)
         inputPlugin_->start(inputPlugin_, &host_api, host_ctx, inputConfig_.c_str());
-    
+    pluginStarted_.store(true, std::memory_order_release);
+
     // Process frames from ring buffer
     const size_t headerSize = sizeof(zm_frame_hdr_t);
     const size_t MAX_BUFFER = 4 * 1024 * 1024; // 4MB buffer for frame data
@@ -137,10 +139,24 @@ void CaptureThread::run() {
 
             // Deliver to the input plugin's downstream stages. Each runs on its
             // own thread with a bounded drop-queue, so a slow stage drops its own
-            // backlog instead of blocking capture or sibling branches.
+            // backlog instead of blocking capture or sibling branches. One copy
+            // is shared by every stage's queue (and the frame cache, which only
+            // keeps decoded frames from inputs that produce them).
+            StageRunner::Buffer frame;
+            FrameCache* cache = nullptr;
             for (auto* out : outputs_) {
-                if (out) out->deliver(buffer.data(), size);
+                if (!out) continue;
+                if (!frame) {
+                    const auto* p = reinterpret_cast<const uint8_t*>(buffer.data());
+                    auto copy = std::make_shared<std::vector<uint8_t>>(p, p + size);
+                    reinterpret_cast<zm_frame_hdr_t*>(copy->data())->flags &= ~ZM_FRAME_OUTPUT_MASK;
+                    frame = std::move(copy);
+                }
+                out->deliver(frame);
+                if (!cache) cache = out->frameCache();
             }
+            if (frame && cache) cache->publish(frame);
+            frames_.fetch_add(1, std::memory_order_relaxed);
         } else {
             // Sleep a bit if no frames to avoid busy loop
             std::this_thread::sleep_for(std::chrono::milliseconds(5));
@@ -148,6 +164,7 @@ void CaptureThread::run() {
     }
     
     // Stop the plugin when we're done
+    pluginStarted_.store(false, std::memory_order_release);
     inputPlugin_->stop(inputPlugin_);
 }
 
@@ -0,0 +1,97 @@
+#include "zm/FrameCache.hpp"
+#include "zm_side_data.h"
+
+namespace zm {
+
+namespace {
+bool cacheable(uint32_t hw_type) {
+    return hw_type == ZM_FRAME_RGB24 || hw_type == ZM_FRAME_GRAYSCALE ||
+           hw_type == ZM_FRAME_YUV420P;
+}
+
+const zm_frame_hdr_t* header(const FrameCache::Buffer& b) {
+    return reinterpret_cast<const zm_frame_hdr_t*>(b->data());
+}
+}  // namespace
+
+void FrameCache::retain(size_t frames) {
+    if (frames < 1) frames = 1;
+    size_t cur = depth_.load(std::memory_order_relaxed);
+    while (cur < frames && !depth_.compare_exchange_weak(cur, frames)) {}
+}
+
+void FrameCache::publish(const Buffer& frame) {
+    const size_t depth = depth_.load(std::memory_order_relaxed);
+    if (depth == 0 || !frame || frame->size() < sizeof(zm_frame_hdr_t)) return;
+    const zm_frame_hdr_t* hdr = header(frame);
+    if (!cacheable(hdr->hw_type)) return;
+    // Slots are keyed by pixel payload; side data does not split them.
+    const uint32_t bytes = static_cast<uint32_t>(zm_frame_payload_size(frame->data(), frame->size()));
+    const auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Slot& slot = slots_[Key{hdr->stream_id, hdr->hw_type, bytes}];
+    slot.last_publish = now;
+    if (!slot.frames.empty()) {
+        const uint64_t newest = header(slot.frames.back())->pts_usec;
+        if (hdr->pts_usec == newest) return;
+        if (hdr->pts_usec < newest) slot.frames.clear();
+    }
+    slot.frames.push_back(frame);
+    while (slot.frames.size() > depth) slot.frames.pop_front();
+
+    for (auto it = slots_.begin(); it != slots_.end();) {
+        if (now - it->second.last_publish > kSlotIdle) it = slots_.erase(it);
+        else ++it;
+    }
+}
+
+template <typename Fn>
+void FrameCache::forEachSlot(uint32_t stream_id, uint32_t hw_type, uint32_t bytes, Fn&& fn) const {
+    if (bytes) {
+        auto it = slots_.find(Key{stream_id, hw_type, bytes});
+        if (it != slots_.end()) fn(it->second);
+        return;
+    }
+    for (auto it = slots_.lower_bound(Key{stream_id, hw_type, 0});
+         it != slots_.end() && std::get<0>(it->first) == stream_id &&
+         std::get<1>(it->first) == hw_type;
+         ++it)
+        fn(it->second);
+}
+
+FrameCache::Buffer FrameCache::latest(uint32_t stream_id, uint32_t hw_type, uint32_t bytes) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Buffer best;
+    forEachSlot(stream_id, hw_type, bytes, [&](const Slot& s) {
+        if (s.frames.empty()) return;
+        if (!best || header(s.frames.back())->pts_usec > header(best)->pts_usec)
+            best = s.frames.back();
+    });
+    return best;
+}
+
+FrameCache::Buffer FrameCache::at(uint32_t stream_id, uint32_t hw_type, uint32_t bytes,
+                                  uint64_t pts_usec, uint64_t tolerance_usec) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Buffer best;
+    uint64_t best_d = tolerance_usec;
+    forEachSlot(stream_id, hw_type, bytes, [&](const Slot& s) {
+        for (const auto& f : s.frames) {
+            const uint64_t p = header(f)->pts_usec;
+            const uint64_t d = p > pts_usec ? p - pts_usec : pts_usec - p;
+            if (d <= best_d) {
+                best_d = d;
+                best = f;
+            }
+        }
+    });
+    return best;
+}
+
+size_t FrameCache::slots() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slots_.size();
+}
+
+} // namespace zm
@@ -20,6 +20,7 @@ PipelineLoader::~PipelineLoader() {}
 
 bool PipelineLoader::load() {
     pipeline_.clear();
+    rateControl_ = RateControlConfig{};
     try {
         std::ifstream f(path_);
         if (!f) {
@@ -44,13 +45,15 @@ bool PipelineLoader::load() {
         // Recursively flatten plugins while preserving the tree topology:
         // each node records the flat-vector indices of its children, so the
         // engine can route frames stage-to-stage. Returns the node's index.
-        std::function<int(const nlohmann::json&)> add_plugin;
-        add_plugin = [&](const nlohmann::json& plugin) -> int {
+        std::function<int(const nlohmann::json&, const nlohmann::json*)> add_plugin;
+        add_plugin = [&](const nlohmann::json& plugin, const nlohmann::json* parent) -> int {
             if (!plugin.is_object()) {
                 std::cerr << "A plugin entry is not an object in " << path_ << std::endl;
                 return -1;
             }
             PluginConfig pcfg;
+            if (plugin.contains("id") && plugin["id"].is_string())
+                pcfg.id = plugin["id"].get<std::string>();
             if (plugin.contains("path")) {
                 pcfg.path = plugin["path"].get<std::string>();
             } else if (plugin.contains("kind")) {
@@ -63,18 +66,62 @@ bool PipelineLoader::load() {
                 pcfg.config_json = plugin["cfg"].dump();
             if (plugin.contains("queue_depth") && plugin["queue_depth"].is_number_integer())
                 pcfg.queue_depth = plugin["queue_depth"].get<int>();
+            if (plugin.contains("rate_control") && plugin["rate_control"].is_boolean())
+                pcfg.rate_control = plugin["rate_control"].get<bool>();
+            // Which parent output this node consumes: an index, or a name looked
+            // up in the parent's config "outputs" array (e.g. decode_ffmpeg).
+            if (plugin.contains("output")) {
+                const auto& out = plugin["output"];
+                if (out.is_number_integer()) {
+                    pcfg.output = out.get<int>();
+                } else if (out.is_string()) {
+                    const nlohmann::json* pc = nullptr;
+                    if (parent && parent->contains("config")) pc = &(*parent)["config"];
+                    else if (parent && parent->contains("cfg")) pc = &(*parent)["cfg"];
+                    bool found = false;
+                    if (pc && pc->contains("outputs") && (*pc)["outputs"].is_array()) {
+                        const auto& outs = (*pc)["outputs"];
+                        for (size_t i = 0; i < outs.size(); ++i) {
+                            if (outs[i].is_object() &&
+                                outs[i].value("name", std::string()) == out.get<std::string>()) {
+                                pcfg.output = static_cast<int>(i);
+                                found = true;
+                                break;
+                            }
+                        }
+                    }
+                    if (!found)
+                        std::cerr << "Unknown parent output \"" << out.get<std::string>()
+                                  << "\" in " << path_ << "; using output 0" << std::endl;
+                }
+            }
             const int myIndex = static_cast<int>(pipeline_.size());
             pipeline_.push_back(std::move(pcfg));
             // Recurse into children, appending their indices to this node.
             if (plugin.contains("children") && plugin["children"].is_array()) {
                 for (const auto& child : plugin["children"]) {
-                    const int ci = add_plugin(child);
+                    const int ci = add_plugin(child, &plugin);
                     if (ci >= 0) pipeline_[myIndex].children.push_back(ci);
                 }
             }
             return myIndex;
         };
-        for (const auto& plugin : arr) add_plugin(plugin);
+        for (const auto& plugin : arr) add_plugin(plugin, nullptr);
+
+        if (root.contains("rate_control")) {
+            const auto& rc = root["rate_control"];
+            if (rc.is_boolean()) {
+                rateControl_.enabled = rc.get<bool>();
+            } else if (rc.is_object()) {
+                rateControl_.enabled = rc.value("enabled", true);
+                rateControl_.interval_ms = rc.value("interval_ms", rateControl_.interval_ms);
+                rateControl_.high_water = rc.value("high_water", rateControl_.high_water);
+                rateControl_.low_water = rc.value("low_water", rateControl_.low_water);
+                rateControl_.drop_rate = rc.value("drop_rate", rateControl_.drop_rate);
+                rateControl_.max_decimation = rc.value("max_decimation", rateControl_.max_decimation);
+                rateControl_.recover_ticks = rc.value("recover_ticks", rateControl_.recover_ticks);
+            }
+        }
 
         // Backward-compat: a flat array (no node declares children) is treated
         // as a linear chain node[i] -> node[i+1].
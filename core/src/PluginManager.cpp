@@ -5,9 +5,13 @@
 #include "zm_plugin.h"
 #include "zm/EventBus.hpp"
 #include "zm/StageRunner.hpp"
+#include "zm/FrameCache.hpp"
+#include <algorithm>
+#include <chrono>
 #include <dlfcn.h>
 #include <iostream>
 #include <cstring>
+#include <nlohmann/json.hpp>
 
 // Global host API for v1 plugins
 // Route plugin logs to stdout so VS Code Debug Console can capture them
@@ -25,6 +29,12 @@ extern "C" void chain_on_frame(void* host_ctx, const void* buf, size_t size) {
     if (!host_ctx) return;
     static_cast<zm::StageRunner*>(host_ctx)->forwardToChildren(buf, size);
 }
+// Same, appending frame side data to the copy made for the children.
+extern "C" void chain_on_frame_side_data(void* host_ctx, const void* buf, size_t size,
+                                         const void* entries, size_t entries_size) {
+    if (!host_ctx) return;
+    static_cast<zm::StageRunner*>(host_ctx)->forwardToChildren(buf, size, entries, entries_size);
+}
 
 // Host-backed event subscription so plugins reliably reach the host's single
 // EventBus instance across the dlopen boundary (a plugin calling
@@ -43,6 +53,47 @@ extern "C" void host_unsubscribe_evt(void* /*host_ctx*/, void* handle) {
         static_cast<zm::EventBus::SubscriptionId>(reinterpret_cast<uintptr_t>(handle)));
 }
 
+// Host frame cache (zm_frame_cache_api_t). host_ctx is the calling plugin's
+// StageRunner, which points at the pipeline's FrameCache; a reference is a heap
+// copy of the shared_ptr, so the buffer lives until release().
+static zm::FrameCache* host_frame_cache(void* host_ctx) {
+    return host_ctx ? static_cast<zm::StageRunner*>(host_ctx)->frameCache() : nullptr;
+}
+static zm_frame_ref_t* host_frame_ref(zm::FrameCache::Buffer buf, const void** frame, size_t* size) {
+    if (!buf) return nullptr;
+    if (frame) *frame = buf->data();
+    if (size) *size = buf->size();
+    return reinterpret_cast<zm_frame_ref_t*>(new zm::FrameCache::Buffer(std::move(buf)));
+}
+extern "C" void host_frame_cache_retain(void* host_ctx, uint32_t frames) {
+    if (auto* cache = host_frame_cache(host_ctx)) cache->retain(frames);
+}
+extern "C" zm_frame_ref_t* host_frame_cache_acquire_latest(void* host_ctx, uint32_t stream_id,
+                                                           uint32_t hw_type, uint32_t bytes,
+                                                           const void** frame, size_t* size) {
+    auto* cache = host_frame_cache(host_ctx);
+    return cache ? host_frame_ref(cache->latest(stream_id, hw_type, bytes), frame, size) : nullptr;
+}
+extern "C" zm_frame_ref_t* host_frame_cache_acquire_at(void* host_ctx, uint32_t stream_id,
+                                                       uint32_t hw_type, uint32_t bytes,
+                                                       uint64_t pts_usec, uint64_t tolerance_usec,
+                                                       const void** frame, size_t* size) {
+    auto* cache = host_frame_cache(host_ctx);
+    return cache ? host_frame_ref(cache->at(stream_id, hw_type, bytes, pts_usec, tolerance_usec),
+                                  frame, size)
+                 : nullptr;
+}
+extern "C" void host_frame_cache_release(void* /*host_ctx*/, zm_frame_ref_t* ref) {
+    delete reinterpret_cast<zm::FrameCache::Buffer*>(ref);
+}
+
+static const zm_frame_cache_api_t gFrameCache = {
+    /* retain         */ host_frame_cache_retain,
+    /* acquire_latest */ host_frame_cache_acquire_latest,
+    /* acquire_at     */ host_frame_cache_acquire_at,
+    /* release        */ host_frame_cache_release,
+};
+
 zm_host_api_t gHost = {
     /* log */ host_log,
     /* publish_evt */ [](void* host_ctx, const char* json_event) -> void {
@@ -51,7 +102,8 @@ zm_host_api_t gHost = {
     /* on_frame        */ chain_on_frame,
     /* subscribe_evt   */ host_subscribe_evt,
     /* unsubscribe_evt */ host_unsubscribe_evt,
-    /* reserved        */ {nullptr, nullptr}
+    /* frame_cache     */ &gFrameCache,
+    /* on_frame_side_data */ chain_on_frame_side_data
 };
 
 namespace zm {
@@ -64,6 +116,7 @@ PluginManager::PluginManager() {
 }
 
 PluginManager::~PluginManager() {
+    stopRateControl();
     for (auto &handle : handles_) {
         dlclose(handle);
     }
@@ -107,6 +160,7 @@ bool PluginManager::loadPipeline(const std::vector<PluginConfig>& pipeline) {
                       << "; loading anyway." << std::endl;
         }
         inst.config = pcfg;
+        inst.control = reinterpret_cast<zm_plugin_control_fn>(dlsym(handle, ZM_PLUGIN_CONTROL_SYMBOL));
         pipeline_.push_back(inst);
     }
     return true;
@@ -130,10 +184,12 @@ void PluginManager::startAll() {
     // index-aligned with pipeline_ (the input slot stays null).
     runners_.clear();
     runners_.resize(pipeline_.size());
+    frameCache_ = std::make_unique<FrameCache>();
     for (size_t i = 0; i < pipeline_.size(); ++i) {
         if (i == inputIdx) continue;
         const int depth = pipeline_[i].config.queue_depth > 0 ? pipeline_[i].config.queue_depth : 16;
         runners_[i] = std::make_unique<StageRunner>(&pipeline_[i].plugin, static_cast<size_t>(depth));
+        runners_[i]->setFrameCache(frameCache_.get());
     }
     // Resolve a node's downstream child runners from the tree topology.
     auto childRunnersOf = [&](size_t i) {
@@ -143,8 +199,16 @@ void PluginManager::startAll() {
                 kids.push_back(runners_[ci].get());
         return kids;
     };
+    // Each child's selected parent output, aligned with childRunnersOf(i).
+    auto childOutputsOf = [&](size_t i) {
+        std::vector<int> outs;
+        for (int ci : pipeline_[i].config.children)
+            if (ci >= 0 && ci < static_cast<int>(pipeline_.size()) && runners_[ci])
+                outs.push_back(pipeline_[ci].config.output);
+        return outs;
+    };
     for (size_t i = 0; i < pipeline_.size(); ++i)
-        if (runners_[i]) runners_[i]->setChildren(childRunnersOf(i));
+        if (runners_[i]) runners_[i]->setChildren(childRunnersOf(i), childOutputsOf(i));
 
     // Start each non-input plugin with its StageRunner as host_ctx, so that
     // host->on_frame (chain_on_frame) routes its output into the children's
@@ -164,9 +228,13 @@ void PluginManager::startAll() {
                                                      childRunnersOf(inputIdx),
                                                      pipeline_[inputIdx].config.config_json, link_);
     captureThread_->start();
+
+    if (rateCfg_.enabled) startRateControl(inputIdx);
 }
 
 void PluginManager::stopAll() {
+    // No control messages once plugins start stopping.
+    stopRateControl();
     // Stop the frame pump first: this cancels the ring's blocking pop and joins
     // the capture thread, whose run() stops the input plugin on exit.
     if (captureThread_) {
@@ -187,6 +255,102 @@ void PluginManager::stopAll() {
 }
 
 
+// Group the watched stages by the producer that should shed their load: the
+// nearest ancestor (possibly the input plugin) exporting zm_plugin_control.
+// Stages with no such ancestor are left alone.
+void PluginManager::startRateControl(size_t inputIdx) {
+    inputIdx_ = inputIdx;
+    std::vector<int> parent(pipeline_.size(), -1);
+    for (size_t i = 0; i < pipeline_.size(); ++i)
+        for (int ci : pipeline_[i].config.children)
+            if (ci >= 0 && ci < static_cast<int>(pipeline_.size())) parent[ci] = static_cast<int>(i);
+    rateTargets_.clear();
+    for (size_t i = 0; i < pipeline_.size(); ++i) {
+        if (!runners_[i] || !pipeline_[i].config.rate_control) continue;
+        int p = parent[i];
+        while (p >= 0 && !pipeline_[p].control) p = parent[p];
+        if (p < 0) continue;
+        auto t = std::find_if(rateTargets_.begin(), rateTargets_.end(),
+                              [&](const RateTarget& r) { return r.producer == static_cast<size_t>(p); });
+        if (t == rateTargets_.end())
+            t = rateTargets_.insert(rateTargets_.end(),
+                                    RateTarget{static_cast<size_t>(p), {}, RateController(rateCfg_)});
+        t->stages.push_back(i);
+    }
+    if (rateTargets_.empty()) {
+        std::cout << "[PluginManager] rate_control: no plugin upstream of a stage exports "
+                  << ZM_PLUGIN_CONTROL_SYMBOL << "; disabled" << std::endl;
+        return;
+    }
+    rateStop_ = false;
+    rateThread_ = std::thread(&PluginManager::rateControlLoop, this);
+}
+
+void PluginManager::stopRateControl() {
+    if (!rateThread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lk(rateMutex_);
+        rateStop_ = true;
+    }
+    rateCv_.notify_all();
+    rateThread_.join();
+    rateTargets_.clear();
+}
+
+void PluginManager::rateControlLoop() {
+    const auto interval = std::chrono::milliseconds(std::max(10, rateCfg_.interval_ms));
+    std::unique_lock<std::mutex> lk(rateMutex_);
+    while (!rateCv_.wait_for(lk, interval, [this] { return rateStop_; })) {
+        for (auto& t : rateTargets_) {
+            std::vector<RateController::Sample> samples;
+            samples.reserve(t.stages.size());
+            for (size_t i : t.stages) {
+                const auto st = runners_[i]->stats();
+                samples.push_back({st.processed, st.dropped, st.depth, st.max_depth});
+            }
+            t.policy.update(samples);
+            const int keep = t.policy.keep_every();
+            if (keep == t.sent) continue;
+            // The input plugin is started on the capture thread; hold the
+            // message until that start() has returned.
+            if (t.producer == inputIdx_ && !(captureThread_ && captureThread_->pluginStarted()))
+                continue;
+            const int hot = t.policy.congested();
+            const auto& stage = pipeline_[hot >= 0 ? t.stages[hot] : t.stages.front()].config;
+            auto& producer = pipeline_[t.producer];
+            nlohmann::json msg = {
+                {"type", "rate_control"},
+                {"keep_every", keep},
+                {"stage", stage.id.empty() ? stage.path : stage.id},
+                {"reason", keep > t.sent ? "backpressure" : "recovered"}};
+            const std::string text = msg.dump();
+            producer.control(&producer.plugin, text.c_str());
+            t.sent = keep;
+            msg["producer"] = producer.config.id.empty() ? producer.config.path : producer.config.id;
+            const std::string evt = msg.dump();
+            std::cout << "[PluginManager] rate_control: " << evt << std::endl;
+            EventBus::instance().publish("plugin_event", evt);
+        }
+    }
+}
+
+std::vector<PluginManager::StageStatus> PluginManager::stageStats() const {
+    std::vector<StageStatus> out;
+    for (size_t i = 0; i < runners_.size() && i < pipeline_.size(); ++i) {
+        if (!runners_[i]) continue;
+        out.push_back(StageStatus{pipeline_[i].config.id, pipeline_[i].config.path,
+                                  runners_[i]->stats()});
+    }
+    return out;
+}
+
+PluginManager::CaptureStatus PluginManager::captureStats() const {
+    CaptureStatus s;
+    if (captureThread_) s.frames = captureThread_->frames();
+    if (ring_) s.ring_rejected = ring_->rejected();
+    return s;
+}
+
 size_t PluginManager::pluginCount() const {
     return pipeline_.size();
 }
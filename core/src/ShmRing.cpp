@@ -32,12 +32,18 @@ ShmRing::ShmRing(size_t slotCount, size_t slotSize, const std::string& name)
 }
 
 bool ShmRing::push(const void* data, size_t size) {
-    if (size > header_->slotSize) return false;
+    if (size > header_->slotSize) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
     size_t head = header_->head.load(std::memory_order_acquire);
     size_t tail = header_->tail.load(std::memory_order_relaxed);
     size_t next = (tail + 1) % header_->slotCount;
     // ring full
-    if (next == head) return false;
+    if (next == head) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
     // Get slot sizes array
     size_t* slotSizes = reinterpret_cast<size_t*>(reinterpret_cast<char*>(header_) + sizeof(Header));
     // Store actual size for this slot
@@ -1,5 +1,9 @@
 #include "zm/StageRunner.hpp"
+#include "zm/FrameCache.hpp"
+#include "zm_side_data.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 namespace zm {
@@ -25,43 +29,153 @@ void StageRunner::stop() {
 void StageRunner::deliver(const void* buf, size_t size) {
     if (!buf || size == 0) return;
     const auto* p = static_cast<const uint8_t*>(buf);
+    auto copy = std::make_shared<std::vector<uint8_t>>(p, p + size);
+    // The output tag only routes between a parent and its children.
+    if (size >= sizeof(zm_frame_hdr_t))
+        reinterpret_cast<zm_frame_hdr_t*>(copy->data())->flags &= ~ZM_FRAME_OUTPUT_MASK;
+    deliver(Buffer(std::move(copy)));
+}
+
+void StageRunner::deliver(Buffer frame) {
+    if (!frame || frame->empty()) return;
+    const auto now = Clock::now();
     {
         std::lock_guard<std::mutex> lock(mutex_);
         if (queue_.size() >= max_depth_) {
             queue_.pop_front();  // drop oldest; keep the freshest frames
             dropped_.fetch_add(1, std::memory_order_relaxed);
         }
-        queue_.emplace_back(p, p + size);
+        queue_.push_back(Queued{std::move(frame), now});
+        if (queue_.size() > high_water_) high_water_ = queue_.size();
     }
     cv_.notify_one();
 }
 
+StageRunner::Stats StageRunner::stats() const {
+    Stats s;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        s.depth = queue_.size();
+        s.high_water = high_water_;
+        s.busy = busy_.load(std::memory_order_relaxed);  // set under this lock on dequeue
+    }
+    s.max_depth = max_depth_;
+    s.processed = processed();
+    s.dropped = dropped();
+    s.wait = wait_.snapshot();
+    s.service = service_.snapshot();
+    return s;
+}
+
+namespace {
+
+// Types present in a run of encoded entries (stops at the first malformed one
+// and returns the valid prefix length through `valid`).
+std::vector<uint32_t> entryTypes(const uint8_t* p, size_t n, size_t& valid) {
+    std::vector<uint32_t> types;
+    size_t at = 0;
+    while (at + sizeof(zm_side_data_entry_t) <= n) {
+        zm_side_data_entry_t e;
+        std::memcpy(&e, p + at, sizeof(e));
+        const size_t span = sizeof(e) + zm_side_data_pad(e.bytes);
+        if (span > n - at) break;
+        types.push_back(e.type);
+        at += span;
+    }
+    valid = at;
+    return types;
+}
+
+// [hdr][payload][kept upstream entries][new entries][trailer].
+std::shared_ptr<std::vector<uint8_t>> withSideData(const void* buf, size_t size,
+                                                   const void* entries, size_t entries_size) {
+    const auto* in = static_cast<const uint8_t*>(buf);
+    const auto* add = static_cast<const uint8_t*>(entries);
+    size_t addLen = 0;
+    const std::vector<uint32_t> addTypes = entryTypes(add, entries_size, addLen);
+    const size_t head = sizeof(zm_frame_hdr_t) + zm_frame_payload_size(buf, size);
+
+    auto out = std::make_shared<std::vector<uint8_t>>();
+    out->reserve(head + zm_frame_side_data_size(buf, size) + addLen);
+    out->assign(in, in + head);
+    size_t cursor = 0, bytes = 0;
+    uint32_t type = 0;
+    const void* value = nullptr;
+    while (zm_side_data_next(buf, size, &cursor, &type, &value, &bytes)) {
+        if (std::find(addTypes.begin(), addTypes.end(), type) != addTypes.end()) continue;
+        const auto* p = static_cast<const uint8_t*>(value) - sizeof(zm_side_data_entry_t);
+        out->insert(out->end(), p, p + sizeof(zm_side_data_entry_t) + zm_side_data_pad(bytes));
+    }
+    out->insert(out->end(), add, add + addLen);
+    zm_side_data_trailer_t t;
+    t.bytes = static_cast<uint32_t>(out->size() - head + sizeof(t));
+    t.magic = ZM_SIDE_DATA_MAGIC;
+    const auto* tp = reinterpret_cast<const uint8_t*>(&t);
+    out->insert(out->end(), tp, tp + sizeof(t));
+    reinterpret_cast<zm_frame_hdr_t*>(out->data())->flags |= ZM_FRAME_FLAG_SIDE_DATA;
+    return out;
+}
+
+}  // namespace
+
 void StageRunner::forwardToChildren(const void* buf, size_t size) {
-    for (auto* child : children_) {
-        if (child) child->deliver(buf, size);
+    forwardToChildren(buf, size, nullptr, 0);
+}
+
+void StageRunner::forwardToChildren(const void* buf, size_t size, const void* entries,
+                                    size_t entries_size) {
+    if (!buf || size == 0) return;
+    const bool side = entries && entries_size && size >= sizeof(zm_frame_hdr_t);
+    int output = 0;
+    if (size >= sizeof(zm_frame_hdr_t))
+        output = static_cast<int>(ZM_FRAME_OUTPUT(static_cast<const zm_frame_hdr_t*>(buf)->flags));
+    Buffer shared;
+    for (size_t i = 0; i < children_.size(); ++i) {
+        if (!children_[i] || child_outputs_[i] != output) continue;
+        if (!shared) {
+            const auto* p = static_cast<const uint8_t*>(buf);
+            auto copy = side ? withSideData(buf, size, entries, entries_size)
+                             : std::make_shared<std::vector<uint8_t>>(p, p + size);
+            if (size >= sizeof(zm_frame_hdr_t))
+                reinterpret_cast<zm_frame_hdr_t*>(copy->data())->flags &= ~ZM_FRAME_OUTPUT_MASK;
+            shared = std::move(copy);
+        }
+        children_[i]->deliver(shared);
     }
+    // Only frames someone downstream consumes are cached: the buffer already
+    // exists, so the cache just takes another reference.
+    if (shared && cache_) cache_->publish(shared);
 }
 
 void StageRunner::run() {
     while (running_.load()) {
-        std::vector<uint8_t> item;
+        Buffer item;
+        Clock::time_point enqueued;
         {
             std::unique_lock<std::mutex> lock(mutex_);
             cv_.wait(lock, [this] { return !queue_.empty() || !running_.load(); });
             if (!running_.load()) break;  // drop any remaining backlog on shutdown
-            item = std::move(queue_.front());
+            item = std::move(queue_.front().frame);
+            enqueued = queue_.front().enqueued;
             queue_.pop_front();
+            busy_.store(true, std::memory_order_relaxed);
         }
+        const auto begin = Clock::now();
+        wait_.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(begin - enqueued).count()));
         if (plugin_ && plugin_->on_frame) {
             try {
-                plugin_->on_frame(plugin_, item.data(), item.size());
+                plugin_->on_frame(plugin_, item->data(), item->size());
             } catch (const std::exception& e) {
                 std::cerr << "[StageRunner] plugin on_frame threw: " << e.what() << std::endl;
             } catch (...) {
                 std::cerr << "[StageRunner] plugin on_frame threw (unknown)" << std::endl;
             }
         }
+        service_.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - begin).count()));
         processed_.fetch_add(1, std::memory_order_relaxed);
+        busy_.store(false, std::memory_order_relaxed);
     }
 }
 
@@ -0,0 +1,258 @@
+// Keyframe/time index sidecar for recorded segments (see header for layout).
+
+#include "zm/segment_index.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace zm {
+namespace segment_index {
+
+const uint8_t kMagic[8] = {'Z', 'M', 'S', 'I', 'D', 'X', '1', '\0'};
+
+namespace {
+
+void put_u16(std::vector<uint8_t> &out, uint16_t value) {
+  out.push_back(value & 0xff);
+  out.push_back((value >> 8) & 0xff);
+}
+
+void put_u32(std::vector<uint8_t> &out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) out.push_back((value >> (8 * i)) & 0xff);
+}
+
+void put_u64(std::vector<uint8_t> &out, uint64_t value) {
+  for (int i = 0; i < 8; ++i) out.push_back((value >> (8 * i)) & 0xff);
+}
+
+uint16_t get_u16(const uint8_t *in) {
+  return static_cast<uint16_t>(in[0]) | (static_cast<uint16_t>(in[1]) << 8);
+}
+
+uint32_t get_u32(const uint8_t *in) {
+  return static_cast<uint32_t>(in[0]) |
+         (static_cast<uint32_t>(in[1]) << 8) |
+         (static_cast<uint32_t>(in[2]) << 16) |
+         (static_cast<uint32_t>(in[3]) << 24);
+}
+
+uint64_t get_u64(const uint8_t *in) {
+  return static_cast<uint64_t>(get_u32(in)) |
+         (static_cast<uint64_t>(get_u32(in + 4)) << 32);
+}
+
+size_t padded(size_t len) { return (len + 7) & ~static_cast<size_t>(7); }
+
+void set_error(std::string *error, const std::string &msg) {
+  if (error) *error = msg;
+}
+
+bool copy_bytes(std::ifstream &in, std::ofstream &out, int64_t begin, int64_t end) {
+  in.seekg(begin);
+  if (!in) return false;
+  std::vector<char> buf(1 << 20);
+  int64_t left = end - begin;
+  while (left > 0) {
+    const std::streamsize n = static_cast<std::streamsize>(
+        std::min<int64_t>(left, static_cast<int64_t>(buf.size())));
+    in.read(buf.data(), n);
+    if (in.gcount() != n) return false;
+    out.write(buf.data(), n);
+    if (!out) return false;
+    left -= n;
+  }
+  return true;
+}
+
+} // namespace
+
+std::vector<uint8_t> EncodeHeader(int64_t start_pts_us, int64_t wall_time) {
+  std::vector<uint8_t> out(kMagic, kMagic + sizeof(kMagic));
+  put_u32(out, kVersion);
+  put_u32(out, 0);
+  put_u64(out, static_cast<uint64_t>(start_pts_us));
+  put_u64(out, static_cast<uint64_t>(wall_time));
+  return out;
+}
+
+std::vector<uint8_t> EncodeRecord(const Record &record) {
+  const uint16_t tag_len =
+      static_cast<uint16_t>(std::min<size_t>(record.tag.size(), kMaxTagLen));
+  std::vector<uint8_t> out;
+  out.reserve(kRecordFixedSize + padded(tag_len));
+  put_u64(out, static_cast<uint64_t>(record.pts_us));
+  put_u64(out, static_cast<uint64_t>(record.offset));
+  put_u16(out, static_cast<uint16_t>(record.kind));
+  put_u16(out, tag_len);
+  put_u32(out, 0);
+  out.insert(out.end(), record.tag.begin(), record.tag.begin() + tag_len);
+  out.resize(kRecordFixedSize + padded(tag_len), 0);
+  return out;
+}
+
+bool Parse(const uint8_t *data, size_t size, Index &out, std::string *error) {
+  out = Index{};
+  if (!data || size < kHeaderSize || std::memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+    set_error(error, "not a segment index");
+    return false;
+  }
+  if (get_u32(data + 8) != kVersion) {
+    set_error(error, "unsupported segment index version");
+    return false;
+  }
+  out.start_pts_us = static_cast<int64_t>(get_u64(data + 16));
+  out.wall_time = static_cast<int64_t>(get_u64(data + 24));
+
+  size_t pos = kHeaderSize;
+  while (pos + kRecordFixedSize <= size) {
+    const uint8_t *p = data + pos;
+    Record r;
+    r.pts_us = static_cast<int64_t>(get_u64(p));
+    r.offset = static_cast<int64_t>(get_u64(p + 8));
+    r.kind = static_cast<RecordKind>(get_u16(p + 16));
+    const uint16_t tag_len = get_u16(p + 18);
+    const size_t rec_size = kRecordFixedSize + padded(tag_len);
+    if (pos + rec_size > size) break;  // torn tail from a crash: ignore
+    r.tag.assign(reinterpret_cast<const char *>(p + kRecordFixedSize), tag_len);
+    pos += rec_size;
+
+    switch (r.kind) {
+      case RecordKind::Keyframe:
+        out.keyframes.push_back(std::move(r));
+        break;
+      case RecordKind::Event:
+        out.events.push_back(std::move(r));
+        break;
+      case RecordKind::End:
+        out.complete = true;
+        out.file_size = r.offset;
+        out.duration_us = r.pts_us;
+        break;
+      default:
+        break;  // unknown kinds are skipped
+    }
+  }
+  if (!out.complete && !out.keyframes.empty())
+    out.duration_us = out.keyframes.back().pts_us;
+  return true;
+}
+
+bool Load(const std::string &path, Index &out, std::string *error) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    set_error(error, "cannot open " + path);
+    return false;
+  }
+  std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)),
+                             std::istreambuf_iterator<char>());
+  return Parse(bytes.data(), bytes.size(), out, error);
+}
+
+bool RangeFor(const Index &index, int64_t from_us, int64_t to_us, int64_t media_size,
+              ByteRange &out) {
+  if (index.keyframes.empty() || to_us < from_us) return false;
+  const auto &kf = index.keyframes;
+  auto by_pts = [](const Record &r, int64_t pts) { return r.pts_us < pts; };
+
+  // Last keyframe at or before `from_us` (or the first one if from precedes it).
+  auto first_after_from = std::upper_bound(
+      kf.begin(), kf.end(), from_us,
+      [](int64_t pts, const Record &r) { return pts < r.pts_us; });
+  auto begin = first_after_from == kf.begin() ? kf.begin() : first_after_from - 1;
+  // First keyframe strictly after `to_us` bounds the end.
+  auto end = std::lower_bound(kf.begin(), kf.end(), to_us + 1, by_pts);
+
+  out.begin = begin->offset;
+  out.first_pts_us = begin->pts_us;
+  if (end != kf.end()) {
+    out.end = end->offset;
+  } else {
+    out.end = media_size > 0 ? media_size : index.file_size;
+  }
+  return out.end > out.begin;
+}
+
+bool ExtractRange(const std::string &media_path, const Index &index, int64_t from_us,
+                  int64_t to_us, const std::string &out_path, std::string *error) {
+  std::ifstream in(media_path, std::ios::binary | std::ios::ate);
+  if (!in) {
+    set_error(error, "cannot open " + media_path);
+    return false;
+  }
+  const int64_t media_size = static_cast<int64_t>(in.tellg());
+  ByteRange range;
+  if (!RangeFor(index, from_us, to_us, media_size, range)) {
+    set_error(error, "no keyframe range covers the requested time");
+    return false;
+  }
+  const int64_t header = index.header_bytes();
+  if (header <= 0 || header > media_size || range.end > media_size) {
+    set_error(error, "index does not match the media file");
+    return false;
+  }
+  std::ofstream out(out_path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    set_error(error, "cannot create " + out_path);
+    return false;
+  }
+  if (!copy_bytes(in, out, 0, header) || !copy_bytes(in, out, range.begin, range.end)) {
+    set_error(error, "short read/write while copying");
+    return false;
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Writer
+// -----------------------------------------------------------------------------
+Writer::~Writer() {
+  if (file_) std::fclose(file_);
+}
+
+bool Writer::Open(const std::string &path, int64_t start_pts_us, int64_t wall_time) {
+  if (file_) std::fclose(file_);
+  file_ = std::fopen(path.c_str(), "wb");
+  if (!file_) return false;
+  path_ = path;
+  last_keyframe_offset_ = 0;
+  const auto header = EncodeHeader(start_pts_us, wall_time);
+  std::fwrite(header.data(), 1, header.size(), file_);
+  return true;
+}
+
+void Writer::Append(const Record &record) {
+  if (!file_) return;
+  const auto bytes = EncodeRecord(record);
+  std::fwrite(bytes.data(), 1, bytes.size(), file_);
+}
+
+void Writer::AddKeyframe(int64_t pts_us, int64_t offset) {
+  last_keyframe_offset_ = offset;
+  Append(Record{pts_us, offset, RecordKind::Keyframe, {}});
+}
+
+void Writer::AddEvent(int64_t pts_us, const std::string &type) {
+  Append(Record{pts_us, last_keyframe_offset_, RecordKind::Event, type});
+}
+
+void Writer::Flush() {
+  if (file_) std::fflush(file_);
+}
+
+bool Writer::Rename(const std::string &new_path) {
+  if (!file_) return false;
+  if (std::rename(path_.c_str(), new_path.c_str()) != 0) return false;
+  path_ = new_path;
+  return true;
+}
+
+void Writer::Close(int64_t duration_us, int64_t file_size) {
+  if (!file_) return;
+  Append(Record{duration_us, file_size, RecordKind::End, {}});
+  std::fclose(file_);
+  file_ = nullptr;
+}
+
+} // namespace segment_index
+} // namespace zm
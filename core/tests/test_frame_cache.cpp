@@ -0,0 +1,111 @@
+#include "zm/FrameCache.hpp"
+#include "zm/StageRunner.hpp"
+#include "zm_plugin.h"
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace zm;
+
+namespace {
+std::vector<uint8_t> frame(uint32_t stream, uint32_t type, uint64_t pts, size_t bytes = 12) {
+    std::vector<uint8_t> f(sizeof(zm_frame_hdr_t) + bytes, 0);
+    zm_frame_hdr_t hdr{};
+    hdr.stream_id = stream;
+    hdr.hw_type = type;
+    hdr.bytes = static_cast<uint32_t>(bytes);
+    hdr.pts_usec = pts;
+    std::memcpy(f.data(), &hdr, sizeof(hdr));
+    return f;
+}
+
+FrameCache::Buffer shared(std::vector<uint8_t> f) {
+    return std::make_shared<const std::vector<uint8_t>>(std::move(f));
+}
+
+uint64_t pts_of(const FrameCache::Buffer& b) {
+    return reinterpret_cast<const zm_frame_hdr_t*>(b->data())->pts_usec;
+}
+
+void noop_on_frame(zm_plugin_t*, const void*, size_t) {}
+}  // namespace
+
+TEST(FrameCacheTest, IdleUntilRetained) {
+    FrameCache c;
+    c.publish(shared(frame(0, ZM_FRAME_RGB24, 1000)));
+    EXPECT_EQ(c.latest(0, ZM_FRAME_RGB24, 0), nullptr);
+    c.retain(1);
+    c.publish(shared(frame(0, ZM_FRAME_RGB24, 2000)));
+    auto f = c.latest(0, ZM_FRAME_RGB24, 12);
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(pts_of(f), 2000u);
+}
+
+TEST(FrameCacheTest, KeepsOnlyDecodedFramesPerStreamAndSize) {
+    FrameCache c;
+    c.retain(1);
+    c.publish(shared(frame(0, ZM_FRAME_COMPRESSED, 1000)));
+    c.publish(shared(frame(0, ZM_FRAME_RGB24, 1000, 12)));
+    c.publish(shared(frame(0, ZM_FRAME_RGB24, 2000, 48)));
+    c.publish(shared(frame(1, ZM_FRAME_RGB24, 5000, 12)));
+    EXPECT_EQ(c.latest(0, ZM_FRAME_COMPRESSED, 0), nullptr);
+    EXPECT_EQ(pts_of(c.latest(0, ZM_FRAME_RGB24, 12)), 1000u);
+    EXPECT_EQ(pts_of(c.latest(0, ZM_FRAME_RGB24, 0)), 2000u);  // any size: newest
+    EXPECT_EQ(pts_of(c.latest(1, ZM_FRAME_RGB24, 0)), 5000u);
+    EXPECT_EQ(c.slots(), 3u);
+}
+
+TEST(FrameCacheTest, HeldReferenceSurvivesReplacement) {
+    FrameCache c;
+    c.retain(1);
+    c.publish(shared(frame(0, ZM_FRAME_RGB24, 1000)));
+    auto held = c.latest(0, ZM_FRAME_RGB24, 0);
+    c.publish(shared(frame(0, ZM_FRAME_RGB24, 2000)));
+    EXPECT_EQ(pts_of(held), 1000u);
+    EXPECT_EQ(pts_of(c.latest(0, ZM_FRAME_RGB24, 0)), 2000u);
+}
+
+TEST(FrameCacheTest, HistoryServesNearestPtsWithinTolerance) {
+    FrameCache c;
+    c.retain(1);
+    c.retain(4);
+    c.retain(2);  // the largest request wins
+    EXPECT_EQ(c.depth(), 4u);
+    for (uint64_t pts = 0; pts <= 200000; pts += 40000)
+        c.publish(shared(frame(0, ZM_FRAME_RGB24, pts)));
+    // Ring holds 80000..200000.
+    EXPECT_EQ(pts_of(c.at(0, ZM_FRAME_RGB24, 0, 125000, 30000)), 120000u);
+    EXPECT_EQ(c.at(0, ZM_FRAME_RGB24, 0, 40000, 30000), nullptr);  // evicted
+    EXPECT_EQ(c.at(0, ZM_FRAME_RGB24, 0, 300000, 30000), nullptr);
+    // A restarted stream clock drops the stale history.
+    c.publish(shared(frame(0, ZM_FRAME_RGB24, 10)));
+    EXPECT_EQ(c.at(0, ZM_FRAME_RGB24, 0, 160000, 30000), nullptr);
+}
+
+TEST(FrameCacheTest, StageRunnerSharesForwardedFrameWithCache) {
+    FrameCache c;
+    c.retain(1);
+    zm_plugin_t parent_plugin{};
+    zm_plugin_t child_plugin{};
+    child_plugin.on_frame = noop_on_frame;
+    StageRunner parent(&parent_plugin, 4);
+    StageRunner child(&child_plugin, 4);
+    parent.setChildren({&child}, {1});
+    parent.setFrameCache(&c);
+
+    auto f = frame(3, ZM_FRAME_YUV420P, 7000);
+    reinterpret_cast<zm_frame_hdr_t*>(f.data())->flags = ZM_FRAME_FLAG_KEYFRAME | (2u << ZM_FRAME_OUTPUT_SHIFT);
+    parent.forwardToChildren(f.data(), f.size());  // output 2: no consumer, not cached
+    EXPECT_EQ(c.latest(3, ZM_FRAME_YUV420P, 0), nullptr);
+
+    reinterpret_cast<zm_frame_hdr_t*>(f.data())->flags = ZM_FRAME_FLAG_KEYFRAME | (1u << ZM_FRAME_OUTPUT_SHIFT);
+    parent.forwardToChildren(f.data(), f.size());
+    auto cached = c.latest(3, ZM_FRAME_YUV420P, 0);
+    ASSERT_NE(cached, nullptr);
+    // Cached copy has the routing tag cleared, like the child's queued copy.
+    EXPECT_EQ(reinterpret_cast<const zm_frame_hdr_t*>(cached->data())->flags, ZM_FRAME_FLAG_KEYFRAME);
+    // Parent's forwarding shares one buffer: the cache plus the child's queue.
+    EXPECT_EQ(cached.use_count(), 3);
+}
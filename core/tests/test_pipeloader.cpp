@@ -43,4 +43,56 @@ TEST(PipelineLoaderTest, FlatArrayLinearFallback) {
     remove(f.c_str());
 }
 
+TEST(PipelineLoaderTest, ChildSelectsParentOutputByNameOrIndex) {
+    const std::string f = "test_pipeline_outputs.json";
+    {
+        std::ofstream o(f);
+        o << R"({"plugins":[{"kind":"decode_ffmpeg","config":{"outputs":[)"
+             R"({"name":"detect","scale":"640x360"},{"name":"full"}]},"children":[)"
+             R"({"kind":"detect_onnx","output":"detect"},{"kind":"store_snapshot","output":"full"},)"
+             R"({"kind":"lpr","output":1},{"kind":"motion_gate"},{"kind":"x","output":"nope"}]}]})";
+    }
+    PipelineLoader loader(f);
+    ASSERT_TRUE(loader.load());
+    const auto& p = loader.getPipeline();
+    ASSERT_EQ(p.size(), 6u);
+    EXPECT_EQ(p[0].output, 0);
+    EXPECT_EQ(p[1].output, 0);  // "detect"
+    EXPECT_EQ(p[2].output, 1);  // "full"
+    EXPECT_EQ(p[3].output, 1);  // explicit index
+    EXPECT_EQ(p[4].output, 0);  // default
+    EXPECT_EQ(p[5].output, 0);  // unknown name falls back to the primary output
+    remove(f.c_str());
+}
+
+TEST(PipelineLoaderTest, RateControlRootAndNodeOptOut) {
+    const std::string f = "test_pipeline_rate.json";
+    {
+        std::ofstream o(f);
+        o << R"({"rate_control":{"interval_ms":250,"max_decimation":4},)"
+             R"("plugins":[{"kind":"decode_ffmpeg","children":[)"
+             R"({"kind":"detect_onnx"},{"kind":"store","rate_control":false}]}]})";
+    }
+    PipelineLoader loader(f);
+    ASSERT_TRUE(loader.load());
+    const auto& rc = loader.getRateControl();
+    EXPECT_TRUE(rc.enabled);
+    EXPECT_EQ(rc.interval_ms, 250);
+    EXPECT_EQ(rc.max_decimation, 4);
+    EXPECT_DOUBLE_EQ(rc.high_water, RateControlConfig{}.high_water);
+    const auto& p = loader.getPipeline();
+    ASSERT_EQ(p.size(), 3u);
+    EXPECT_TRUE(p[1].rate_control);
+    EXPECT_FALSE(p[2].rate_control);
+    remove(f.c_str());
+
+    {
+        std::ofstream o(f);
+        o << R"({"plugins":[{"kind":"a"}]})";
+    }
+    ASSERT_TRUE(loader.load());
+    EXPECT_FALSE(loader.getRateControl().enabled);
+    remove(f.c_str());
+}
+
 // main omitted; use gtest_main
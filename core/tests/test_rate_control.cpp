@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include "zm/RateController.hpp"
+
+using zm::RateControlConfig;
+using zm::RateController;
+
+namespace {
+
+// One stage that has processed/dropped these many frames in total so far.
+std::vector<RateController::Sample> stage(uint64_t processed, uint64_t dropped, size_t depth,
+                                          size_t max_depth = 16) {
+    return {RateController::Sample{processed, dropped, depth, max_depth}};
+}
+
+}  // namespace
+
+TEST(RateControllerTest, FirstTickOnlyRecordsCounters) {
+    RateController rc(RateControlConfig{});
+    EXPECT_FALSE(rc.update(stage(0, 1000, 16)));
+    EXPECT_EQ(rc.keep_every(), 1);
+    EXPECT_EQ(rc.congested(), -1);
+}
+
+TEST(RateControllerTest, DropsDoubleKeepEveryWithCooldownUpToMax) {
+    RateControlConfig cfg;
+    cfg.max_decimation = 8;
+    RateController rc(cfg);
+    uint64_t p = 0, d = 0;
+    rc.update(stage(p, d, 4));
+    std::vector<int> keeps;
+    for (int tick = 0; tick < 12; ++tick) {
+        p += 10, d += 10;  // half the offered frames dropped every tick
+        rc.update(stage(p, d, 16));
+        keeps.push_back(rc.keep_every());
+    }
+    // Doubles, then holds two ticks for the change to take effect.
+    EXPECT_EQ(keeps, (std::vector<int>{2, 2, 4, 4, 8, 8, 8, 8, 8, 8, 8, 8}));
+    EXPECT_EQ(rc.congested(), 0);
+}
+
+TEST(RateControllerTest, DeepQueueAloneIsCongestion) {
+    RateController rc(RateControlConfig{});
+    rc.update(stage(0, 0, 0));
+    EXPECT_FALSE(rc.update(stage(10, 0, 11)));  // 11/16 < 0.75
+    EXPECT_TRUE(rc.update(stage(20, 0, 12)));   // 12/16 >= 0.75
+    EXPECT_EQ(rc.keep_every(), 2);
+}
+
+TEST(RateControllerTest, OccasionalDropBelowRateIsTolerated) {
+    RateController rc(RateControlConfig{});
+    rc.update(stage(0, 0, 0));
+    EXPECT_FALSE(rc.update(stage(100, 2, 2)));  // 2/102 < 5%
+    EXPECT_EQ(rc.keep_every(), 1);
+}
+
+TEST(RateControllerTest, RecoversOneStepPerCalmStreak) {
+    RateControlConfig cfg;
+    cfg.recover_ticks = 3;
+    RateController rc(cfg);
+    uint64_t p = 0, d = 0;
+    rc.update(stage(p, d, 0));
+    for (int i = 0; i < 3; ++i) rc.update(stage(p += 10, d += 10, 16));
+    ASSERT_EQ(rc.keep_every(), 4);
+
+    int changes = 0;
+    for (int tick = 1; tick <= 9; ++tick) {
+        // A queue between the water marks resets the calm streak once.
+        const size_t depth = tick == 2 ? 8 : 1;
+        changes += rc.update(stage(p += 10, d, depth));
+    }
+    // Ticks 3..5 and 6..8 are the two complete calm streaks.
+    EXPECT_EQ(changes, 2);
+    EXPECT_EQ(rc.keep_every(), 2);
+    for (int tick = 0; tick < 3; ++tick) rc.update(stage(p += 10, d, 0));
+    EXPECT_EQ(rc.keep_every(), 1);
+    EXPECT_EQ(rc.congested(), -1);
+}
+
+TEST(RateControllerTest, ReportsTheCongestedStage) {
+    RateController rc(RateControlConfig{});
+    std::vector<RateController::Sample> s = {{0, 0, 0, 8}, {0, 0, 0, 4}};
+    rc.update(s);
+    s[0].processed = 50;
+    s[1].processed = 5;
+    s[1].dropped = 20;
+    EXPECT_TRUE(rc.update(s));
+    EXPECT_EQ(rc.congested(), 1);
+}
@@ -0,0 +1,157 @@
+// Unit tests for the recorded-segment keyframe/time index sidecar.
+
+#include "zm/segment_index.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace si = zm::segment_index;
+
+namespace {
+
+std::string temp_path(const std::string& name) {
+    return ::testing::TempDir() + "zm_segidx_" + name;
+}
+
+std::vector<uint8_t> read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(in)),
+                                std::istreambuf_iterator<char>());
+}
+
+// Index with a 100-byte header and one keyframe cluster per second, 1000 bytes each.
+si::Index make_index(int n) {
+    si::Index idx;
+    for (int i = 0; i < n; ++i)
+        idx.keyframes.push_back({i * 1000000LL, 100 + i * 1000LL, si::RecordKind::Keyframe, {}});
+    idx.complete = true;
+    idx.file_size = 100 + n * 1000LL;
+    return idx;
+}
+
+} // namespace
+
+TEST(SegmentIndex, RecordRoundTripWithTags) {
+    std::vector<uint8_t> buf = si::EncodeHeader(123456789, 1700000000);
+    ASSERT_EQ(buf.size(), si::kHeaderSize);
+    auto add = [&](const si::Record& r) {
+        auto b = si::EncodeRecord(r);
+        EXPECT_EQ(b.size() % 8, 0u);
+        buf.insert(buf.end(), b.begin(), b.end());
+    };
+    add({0, 512, si::RecordKind::Keyframe, {}});
+    add({400000, 512, si::RecordKind::Event, "tracked_detection"});
+    add({1000000, 9000, si::RecordKind::Keyframe, {}});
+    add({1500000, 12000, si::RecordKind::End, {}});
+
+    si::Index idx;
+    ASSERT_TRUE(si::Parse(buf.data(), buf.size(), idx));
+    EXPECT_EQ(idx.start_pts_us, 123456789);
+    EXPECT_EQ(idx.wall_time, 1700000000);
+    ASSERT_EQ(idx.keyframes.size(), 2u);
+    EXPECT_EQ(idx.header_bytes(), 512);
+    ASSERT_EQ(idx.events.size(), 1u);
+    EXPECT_EQ(idx.events[0].tag, "tracked_detection");
+    EXPECT_EQ(idx.events[0].pts_us, 400000);
+    EXPECT_TRUE(idx.complete);
+    EXPECT_EQ(idx.file_size, 12000);
+    EXPECT_EQ(idx.duration_us, 1500000);
+}
+
+TEST(SegmentIndex, TornTailAndUnknownKindsAreSkipped) {
+    std::vector<uint8_t> buf = si::EncodeHeader(0, 0);
+    auto kf = si::EncodeRecord({0, 64, si::RecordKind::Keyframe, {}});
+    auto unknown = si::EncodeRecord({5, 6, static_cast<si::RecordKind>(99), "x"});
+    auto kf2 = si::EncodeRecord({1000, 128, si::RecordKind::Keyframe, {}});
+    buf.insert(buf.end(), kf.begin(), kf.end());
+    buf.insert(buf.end(), unknown.begin(), unknown.end());
+    buf.insert(buf.end(), kf2.begin(), kf2.begin() + 10);  // crash mid-append
+
+    si::Index idx;
+    ASSERT_TRUE(si::Parse(buf.data(), buf.size(), idx));
+    EXPECT_EQ(idx.keyframes.size(), 1u);
+    EXPECT_FALSE(idx.complete);
+    EXPECT_EQ(idx.duration_us, 0);
+}
+
+TEST(SegmentIndex, RejectsBadMagic) {
+    std::vector<uint8_t> buf(64, 0);
+    si::Index idx;
+    std::string err;
+    EXPECT_FALSE(si::Parse(buf.data(), buf.size(), idx, &err));
+    EXPECT_FALSE(err.empty());
+}
+
+TEST(SegmentIndex, RangeIsKeyframeAligned) {
+    si::Index idx = make_index(10);
+    si::ByteRange r;
+    // 2.5 s .. 4.2 s: start at the 2 s keyframe, end at the 5 s keyframe.
+    ASSERT_TRUE(si::RangeFor(idx, 2500000, 4200000, 0, r));
+    EXPECT_EQ(r.begin, 2100);
+    EXPECT_EQ(r.end, 5100);
+    EXPECT_EQ(r.first_pts_us, 2000000);
+    // Exactly on a keyframe: that keyframe starts the range, and a `to` on a
+    // keyframe includes that GOP.
+    ASSERT_TRUE(si::RangeFor(idx, 3000000, 3000000, 0, r));
+    EXPECT_EQ(r.begin, 3100);
+    EXPECT_EQ(r.end, 4100);
+    // Past the last keyframe: runs to the end of the file.
+    ASSERT_TRUE(si::RangeFor(idx, 9500000, 20000000, 0, r));
+    EXPECT_EQ(r.begin, 9100);
+    EXPECT_EQ(r.end, 10100);
+    // Before the first keyframe clamps to it.
+    ASSERT_TRUE(si::RangeFor(idx, -5, 10, 0, r));
+    EXPECT_EQ(r.begin, 100);
+    EXPECT_FALSE(si::RangeFor(idx, 5, 1, 0, r));
+}
+
+TEST(SegmentIndex, WriterAppendsAndExtractCopiesRanges) {
+    const std::string media = temp_path("media.bin");
+    const std::string index_path = temp_path("media.bin.idx");
+    const std::string cut = temp_path("cut.bin");
+
+    // Fake media: 100-byte header 'H', then 5 clusters of 1000 bytes tagged '0'..'4'.
+    {
+        std::ofstream m(media, std::ios::binary);
+        m << std::string(100, 'H');
+        for (int i = 0; i < 5; ++i) m << std::string(1000, static_cast<char>('0' + i));
+    }
+    {
+        si::Writer w;
+        ASSERT_TRUE(w.Open(index_path, 42, 7));
+        for (int i = 0; i < 5; ++i) {
+            w.AddKeyframe(i * 1000000LL, 100 + i * 1000LL);
+            if (i == 3) w.AddEvent(3200000, "motion");
+            w.Flush();
+        }
+        const std::string renamed = index_path + ".moved";
+        ASSERT_TRUE(w.Rename(renamed));
+        EXPECT_EQ(w.path(), renamed);
+        w.Close(4900000, 5100);
+        std::rename(renamed.c_str(), index_path.c_str());
+    }
+
+    si::Index idx;
+    ASSERT_TRUE(si::Load(index_path, idx));
+    ASSERT_EQ(idx.keyframes.size(), 5u);
+    ASSERT_EQ(idx.events.size(), 1u);
+    EXPECT_EQ(idx.events[0].offset, 3100);  // the cluster containing the event
+    EXPECT_TRUE(idx.complete);
+
+    ASSERT_TRUE(si::ExtractRange(media, idx, 1500000, 2500000, cut));
+    const auto bytes = read_file(cut);
+    ASSERT_EQ(bytes.size(), 100u + 2000u);
+    EXPECT_EQ(bytes[0], 'H');
+    EXPECT_EQ(bytes[99], 'H');
+    EXPECT_EQ(bytes[100], '1');
+    EXPECT_EQ(bytes[1100], '2');
+    EXPECT_EQ(bytes.back(), '2');
+
+    std::remove(media.c_str());
+    std::remove(index_path.c_str());
+    std::remove(cut.c_str());
+}
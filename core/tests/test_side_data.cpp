@@ -0,0 +1,136 @@
+#include "zm/StageRunner.hpp"
+#include "zm_side_data.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace zm;
+
+namespace {
+std::mutex g_mu;
+std::vector<std::vector<uint8_t>> g_seen;
+void record_on_frame(zm_plugin_t*, const void* b, size_t n) {
+    std::lock_guard<std::mutex> lk(g_mu);
+    const auto* p = static_cast<const uint8_t*>(b);
+    g_seen.emplace_back(p, p + n);
+}
+void noop_on_frame(zm_plugin_t*, const void*, size_t) {}
+
+std::vector<uint8_t> frame(size_t payload) {
+    std::vector<uint8_t> f(sizeof(zm_frame_hdr_t) + payload);
+    for (size_t i = 0; i < payload; ++i) f[sizeof(zm_frame_hdr_t) + i] = static_cast<uint8_t>(i);
+    auto* h = reinterpret_cast<zm_frame_hdr_t*>(f.data());
+    h->stream_id = 3;
+    h->flags = ZM_FRAME_FLAG_KEYFRAME;
+    h->bytes = static_cast<uint32_t>(payload);
+    return f;
+}
+
+// Forward `f` with `entries` through a parent runner and return what the child
+// stage received.
+std::vector<uint8_t> forward(const std::vector<uint8_t>& f, const std::vector<uint8_t>& entries) {
+    {
+        std::lock_guard<std::mutex> lk(g_mu);
+        g_seen.clear();
+    }
+    zm_plugin_t child{};
+    child.on_frame = record_on_frame;
+    StageRunner childRunner(&child, 8);
+    zm_plugin_t parent{};
+    parent.on_frame = noop_on_frame;
+    StageRunner parentRunner(&parent, 8);
+    parentRunner.setChildren({&childRunner});
+    parentRunner.forwardToChildren(f.data(), f.size(), entries.data(), entries.size());
+    childRunner.start();
+    for (int i = 0; i < 200 && childRunner.processed() < 1; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    childRunner.stop();
+    std::lock_guard<std::mutex> lk(g_mu);
+    return g_seen.empty() ? std::vector<uint8_t>{} : g_seen[0];
+}
+
+template <typename T>
+void put(std::vector<uint8_t>& out, uint32_t type, const T* v, size_t n) {
+    const size_t at = out.size();
+    out.resize(at + sizeof(zm_side_data_entry_t) + zm_side_data_pad(n * sizeof(T)));
+    ASSERT_EQ(zm_side_data_put(out.data() + at, out.size() - at, type, v, n * sizeof(T)),
+              out.size() - at);
+}
+}  // namespace
+
+TEST(SideDataTest, PlainFrameHasNone) {
+    auto f = frame(10);
+    EXPECT_EQ(zm_frame_side_data_size(f.data(), f.size()), 0u);
+    EXPECT_EQ(zm_frame_payload_size(f.data(), f.size()), 10u);
+    EXPECT_EQ(zm_side_data_find(f.data(), f.size(), ZM_SIDE_MOTION_BOXES, nullptr), nullptr);
+    // The flag alone (no valid trailer) is not trusted.
+    reinterpret_cast<zm_frame_hdr_t*>(f.data())->flags |= ZM_FRAME_FLAG_SIDE_DATA;
+    EXPECT_EQ(zm_frame_payload_size(f.data(), f.size()), 10u);
+}
+
+TEST(SideDataTest, HostAppendsEntriesAndKeepsPayload) {
+    const zm_side_box_t boxes[2] = {{1, 2, 3, 4}, {5, 6, 7, 8}};
+    const float score = 0.25f;
+    std::vector<uint8_t> entries;
+    put(entries, ZM_SIDE_MOTION_BOXES, boxes, 2);
+    put(entries, ZM_SIDE_SCENE_SCORE, &score, 1);
+
+    const auto f = frame(13);  // odd payload: entries must not assume alignment
+    const auto got = forward(f, entries);
+    ASSERT_FALSE(got.empty());
+    const auto* hdr = reinterpret_cast<const zm_frame_hdr_t*>(got.data());
+    EXPECT_TRUE(hdr->flags & ZM_FRAME_FLAG_SIDE_DATA);
+    EXPECT_TRUE(hdr->flags & ZM_FRAME_FLAG_KEYFRAME);
+    ASSERT_EQ(zm_frame_payload_size(got.data(), got.size()), 13u);
+    EXPECT_EQ(std::memcmp(got.data() + sizeof(zm_frame_hdr_t), f.data() + sizeof(zm_frame_hdr_t), 13), 0);
+
+    size_t n = 0;
+    const void* v = zm_side_data_find(got.data(), got.size(), ZM_SIDE_MOTION_BOXES, &n);
+    ASSERT_NE(v, nullptr);
+    ASSERT_EQ(n, sizeof(boxes));
+    zm_side_box_t read[2];
+    std::memcpy(read, v, n);
+    EXPECT_EQ(read[1].x, 5);
+    EXPECT_EQ(read[1].h, 8);
+    v = zm_side_data_find(got.data(), got.size(), ZM_SIDE_SCENE_SCORE, &n);
+    ASSERT_NE(v, nullptr);
+    float s = 0;
+    std::memcpy(&s, v, sizeof(s));
+    EXPECT_FLOAT_EQ(s, 0.25f);
+}
+
+TEST(SideDataTest, DownstreamEntriesReplaceSameType) {
+    const zm_side_box_t a = {1, 1, 1, 1}, b = {9, 9, 9, 9};
+    const float score = 0.5f;
+    std::vector<uint8_t> first, second;
+    put(first, ZM_SIDE_MOTION_BOXES, &a, 1);
+    put(first, ZM_SIDE_SCENE_SCORE, &score, 1);
+    put(second, ZM_SIDE_MOTION_BOXES, &b, 1);
+
+    const auto once = forward(frame(8), first);
+    const auto twice = forward(once, second);
+    ASSERT_EQ(zm_frame_payload_size(twice.data(), twice.size()), 8u);
+
+    size_t cursor = 0, count = 0;
+    while (zm_side_data_next(twice.data(), twice.size(), &cursor, nullptr, nullptr, nullptr))
+        ++count;
+    EXPECT_EQ(count, 2u);
+    size_t n = 0;
+    const void* v = zm_side_data_find(twice.data(), twice.size(), ZM_SIDE_MOTION_BOXES, &n);
+    ASSERT_NE(v, nullptr);
+    zm_side_box_t got;
+    std::memcpy(&got, v, sizeof(got));
+    EXPECT_EQ(got.x, 9);
+    EXPECT_NE(zm_side_data_find(twice.data(), twice.size(), ZM_SIDE_SCENE_SCORE, nullptr), nullptr);
+}
+
+TEST(SideDataTest, PutRejectsTooSmallBuffer) {
+    uint8_t buf[12];
+    const int v = 1;
+    EXPECT_EQ(zm_side_data_put(buf, sizeof(buf), ZM_SIDE_USER, &v, sizeof(v)), 0u);
+    EXPECT_EQ(zm_side_data_put(buf, sizeof(buf), ZM_SIDE_USER, nullptr, 0), 8u);
+}
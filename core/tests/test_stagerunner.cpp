@@ -2,8 +2,10 @@
 #include "zm_plugin.h"
 
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <mutex>
 #include <thread>
 #include <vector>
 
@@ -72,6 +74,100 @@ TEST(StageRunnerTest, ForwardsToChildStage) {
     EXPECT_EQ(childRunner.processed(), 1u);
 }
 
+TEST(StageRunnerTest, RoutesTaggedOutputsToSelectingChildren) {
+    // Each child records the flags it receives; instance tells them apart.
+    static std::mutex mu;
+    static std::vector<std::pair<int, uint32_t>> seen;
+    seen.clear();
+    auto record = [](zm_plugin_t* p, const void* b, size_t) {
+        std::lock_guard<std::mutex> lk(mu);
+        seen.emplace_back(static_cast<int>(reinterpret_cast<intptr_t>(p->instance)),
+                          static_cast<const zm_frame_hdr_t*>(b)->flags);
+    };
+    zm_plugin_t full{}, small{};
+    full.on_frame = small.on_frame = record;
+    full.instance = reinterpret_cast<void*>(intptr_t{0});
+    small.instance = reinterpret_cast<void*>(intptr_t{1});
+    StageRunner fullRunner(&full, 64), smallRunner(&small, 64);
+
+    zm_plugin_t parent{};
+    parent.on_frame = noop_on_frame;
+    StageRunner parentRunner(&parent, 64);
+    parentRunner.setChildren({&fullRunner, &smallRunner}, {0, 1});
+
+    auto f = frame();
+    auto* hdr = reinterpret_cast<zm_frame_hdr_t*>(f.data());
+    for (uint32_t out : {0u, 1u, 2u}) {  // nobody selected output 2
+        hdr->flags = ZM_FRAME_FLAG_KEYFRAME | (out << ZM_FRAME_OUTPUT_SHIFT);
+        parentRunner.forwardToChildren(f.data(), f.size());
+    }
+    fullRunner.start();
+    smallRunner.start();
+    for (int i = 0; i < 200 && fullRunner.processed() + smallRunner.processed() < 2; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    fullRunner.stop();
+    smallRunner.stop();
+
+    std::lock_guard<std::mutex> lk(mu);
+    ASSERT_EQ(seen.size(), 2u);
+    std::sort(seen.begin(), seen.end());
+    EXPECT_EQ(seen[0].first, 0);
+    EXPECT_EQ(seen[1].first, 1);
+    // The output tag is cleared on delivery; the keyframe flag survives.
+    EXPECT_EQ(seen[0].second, ZM_FRAME_FLAG_KEYFRAME);
+    EXPECT_EQ(seen[1].second, ZM_FRAME_FLAG_KEYFRAME);
+}
+
+TEST(StageRunnerTest, StatsTrackQueueAndLatency) {
+    zm_plugin_t p{};
+    p.on_frame = slow_on_frame;  // 20ms each
+    StageRunner r(&p, /*max_depth=*/3);
+    auto f = frame();
+    for (int i = 0; i < 5; ++i) r.deliver(f.data(), f.size());
+    StageRunner::Stats s = r.stats();
+    EXPECT_EQ(s.depth, 3u);
+    EXPECT_EQ(s.high_water, 3u);
+    EXPECT_EQ(s.max_depth, 3u);
+    EXPECT_EQ(s.dropped, 2u);
+    EXPECT_FALSE(s.busy);
+
+    r.start();
+    for (int i = 0; i < 200 && r.processed() < 3; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    r.stop();
+    s = r.stats();
+    EXPECT_EQ(s.depth, 0u);
+    EXPECT_EQ(s.service.count, 3u);
+    EXPECT_GE(s.service.percentile_us(0.5), 15000u);
+    EXPECT_EQ(s.wait.count, 3u);
+    EXPECT_GE(s.wait.max_us, 30000u);  // the third frame waited behind two
+}
+
+TEST(LatencyHistogramTest, BucketsAndPercentiles) {
+    for (uint64_t v : {0ull, 1ull, 7ull, 8ull, 9ull, 100ull, 1000ull, 123456ull, 1ull << 39}) {
+        const int b = LatencyHistogram::bucket(v);
+        EXPECT_GE(LatencyHistogram::bucket_upper(b), v);
+        if (b > 0) {
+            EXPECT_LT(LatencyHistogram::bucket_upper(b - 1), v);
+        }
+        EXPECT_LE(LatencyHistogram::bucket_upper(b), v + v / 4);
+    }
+    LatencyHistogram h;
+    for (uint64_t v = 1; v <= 1000; ++v) h.record(v);
+    const auto a = h.snapshot();
+    EXPECT_EQ(a.count, 1000u);
+    EXPECT_DOUBLE_EQ(a.mean_us(), 500.5);
+    EXPECT_NEAR(static_cast<double>(a.percentile_us(0.5)), 500.0, 125.0);
+    EXPECT_NEAR(static_cast<double>(a.percentile_us(0.99)), 990.0, 10.0);
+    EXPECT_EQ(a.percentile_us(1.0), 1000u);
+
+    for (int i = 0; i < 100; ++i) h.record(5);
+    const auto d = h.snapshot().since(a);
+    EXPECT_EQ(d.count, 100u);
+    EXPECT_EQ(d.percentile_us(0.99), 5u);
+    EXPECT_EQ(d.sum_us, 500u);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -15,6 +15,13 @@
 // standard footfall-analytics anchor. We track the recent position and per-rule
 // latch state per (stream_id, track_id).
 //
+// SCALING: rules are compiled at load (rule_index.hpp): polygons into edge
+// tables, rule bounds into a grid per stream. Per event, each object only
+// meets the rules whose bounds its move touches; polygon tests then run per
+// rule over all of that rule's objects at once. Positions and latches live in
+// a flat TrackTable; a latch not written at the track's previous sample reads
+// as re-armed, so leaving a zone needs no visit to that zone's rule.
+//
 // OUTPUT event (published via host->publish_evt on a fired rule):
 //   {"type":"analytics","rule":"<name>","rule_type":"intrusion|linecross|loiter",
 //    "stream_id":N,"track_id":K,"label":"...","pts_usec":T,
@@ -30,13 +37,14 @@
 // an in-flight host callback never dereferences freed memory.
 
 #include "geometry.hpp"
+#include "rule_index.hpp"
 
 #include <zm_plugin.h>
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
-#include <map>
 #include <mutex>
 #include <string>
 #include <unordered_set>
@@ -59,6 +67,7 @@ struct Rule {
     RuleType type = RuleType::Intrusion;
 
     std::vector<Pt> polygon;  // intrusion / loiter
+    zm::analytics::EdgeTable edges;  // compiled `polygon`
     Pt line_a, line_b;        // linecross
     std::string direction = "any";  // linecross: "any" | "lr" | "rl"
     double seconds = 0.0;     // loiter
@@ -68,18 +77,35 @@ struct Rule {
     std::unordered_set<std::string> classes;  // empty => all classes
 };
 
-// Per-(track, rule) mutable state.
-struct RuleTrackState {
-    zm::analytics::ZoneState zone;  // intrusion / loiter latch
+// One tracked detection of the current event.
+struct EventSample {
+    zm::analytics::TrackTable::Sample track;
+    Pt cur;
+    int trackId = 0;
+    std::string label;
+};
+
+// One (sample, rule) pair to act on, in the order alarms are raised.
+struct RuleCheck {
+    enum Kind : uint8_t {
+        Zone,   // intrusion / loiter: step the latch with `inside`
+        Line,   // linecross
+        Carry,  // rule ignores the label: keep its latch as it was
+    };
+    uint32_t sample = 0;
+    uint32_t rule = 0;
+    Kind kind = Zone;
+    bool inside = false;
 };
 
-// Per object track, across all rules.
-struct TrackState {
-    bool has_prev = false;
-    Pt prev;                 // previous ground position (for linecross)
-    uint64_t last_seen = 0;  // pts of most recent sample (for pruning)
-    // Per-rule latch keyed by rule index.
-    std::map<std::size_t, RuleTrackState> rules;
+// Per-event working buffers, reused across events (guarded by the mutex).
+struct EventScratch {
+    std::vector<EventSample> samples;
+    std::vector<uint32_t> candidates;
+    std::vector<RuleCheck> checks;
+    std::vector<uint32_t> zoneChecks;  // indices into checks, grouped by rule
+    std::vector<float> xs, ys;
+    std::vector<uint8_t> inside;
 };
 
 // Shared, callback-owned state. Outlives the plugin instance on purpose.
@@ -91,11 +117,13 @@ struct AnalyticsState {
     void* subHandle = nullptr;
 
     std::vector<Rule> rules;
+    zm::analytics::RuleIndex index;  // built from `rules` at start
 
-    // Per (stream_id, track_id) -> TrackState. Guarded by mutex (callback runs
-    // on the publisher's thread).
+    // Per (stream_id, track_id) positions and latches. Guarded by mutex
+    // (callback runs on the publisher's thread).
     std::mutex mutex;
-    std::map<std::pair<int, int>, TrackState> tracks;
+    zm::analytics::TrackTable tracks;
+    EventScratch scratch;
 };
 
 // Per-plugin-instance context. `state` is intentionally leaked on stop.
@@ -161,10 +189,27 @@ void parseRules(const json& cfg, std::vector<Rule>& out) {
             for (const auto& c : rj["classes"])
                 if (c.is_string()) r.classes.insert(c.get<std::string>());
         }
+        if (!r.polygon.empty()) r.edges = zm::analytics::EdgeTable(r.polygon);
         out.push_back(std::move(r));
     }
 }
 
+// Where each rule can fire; a line's bounds cover every move crossing it.
+void buildIndex(AnalyticsState* state) {
+    std::vector<zm::analytics::RuleFootprint> fp;
+    fp.reserve(state->rules.size());
+    for (const Rule& r : state->rules) {
+        zm::analytics::RuleFootprint f;
+        f.bounds = r.type == RuleType::LineCross
+                       ? zm::analytics::segment_bounds(r.line_a, r.line_b)
+                       : r.edges.bounds();
+        f.has_stream = r.has_stream;
+        f.stream_id = r.stream_id;
+        fp.push_back(f);
+    }
+    state->index.build(fp);
+}
+
 bool ruleAppliesToClass(const Rule& r, const std::string& label) {
     if (r.classes.empty()) return true;
     return r.classes.count(label) > 0;
@@ -228,15 +273,28 @@ void emitLineCross(AnalyticsState* state, const Rule& r, int streamId,
     state->host->publish_evt(state->hostCtx, out.dump().c_str());
 }
 
-// Drop tracks not seen within kStaleTrackUsec of `now`. Caller holds the mutex.
-void pruneStale(AnalyticsState* state, uint64_t now) {
-    for (auto it = state->tracks.begin(); it != state->tracks.end();) {
-        if (now >= it->second.last_seen &&
-            now - it->second.last_seen > kStaleTrackUsec) {
-            it = state->tracks.erase(it);
-        } else {
-            ++it;
+// Run every Zone check's point-in-polygon test, one batch per rule.
+void evaluateZones(AnalyticsState* state) {
+    EventScratch& sc = state->scratch;
+    auto& checks = sc.checks;
+    std::stable_sort(sc.zoneChecks.begin(), sc.zoneChecks.end(),
+                     [&](uint32_t a, uint32_t b) { return checks[a].rule < checks[b].rule; });
+    for (std::size_t i = 0; i < sc.zoneChecks.size();) {
+        const uint32_t ri = checks[sc.zoneChecks[i]].rule;
+        std::size_t end = i;
+        sc.xs.clear();
+        sc.ys.clear();
+        for (; end < sc.zoneChecks.size() && checks[sc.zoneChecks[end]].rule == ri; ++end) {
+            const Pt p = sc.samples[checks[sc.zoneChecks[end]].sample].cur;
+            sc.xs.push_back(p.x);
+            sc.ys.push_back(p.y);
         }
+        sc.inside.resize(sc.xs.size());
+        state->rules[ri].edges.contains(sc.xs.data(), sc.ys.data(), sc.xs.size(),
+                                        sc.inside.data());
+        for (std::size_t k = i; k < end; ++k)
+            checks[sc.zoneChecks[k]].inside = sc.inside[k - i] != 0;
+        i = end;
     }
 }
 
@@ -259,7 +317,12 @@ void handleEvent(AnalyticsState* state, const std::string& msg) {
     if (!j.contains("detections") || !j["detections"].is_array()) return;
 
     std::lock_guard<std::mutex> lock(state->mutex);
-    pruneStale(state, pts);
+    state->tracks.prune(pts, kStaleTrackUsec);
+
+    EventScratch& sc = state->scratch;
+    sc.samples.clear();
+    sc.checks.clear();
+    sc.zoneChecks.clear();
 
     for (const auto& det : j["detections"]) {
         if (!det.is_object()) continue;
@@ -270,58 +333,76 @@ void handleEvent(AnalyticsState* state, const std::string& msg) {
             continue;
 
         const auto& b = det["bbox"];
-        const Pt cur = zm::analytics::bbox_ground(
+        EventSample es;
+        es.cur = zm::analytics::bbox_ground(
             b[0].get<float>(), b[1].get<float>(), b[2].get<float>(),
             b[3].get<float>());
-        const std::string label = det.value("label", std::string());
-
-        TrackState& ts = state->tracks[{streamId, trackId}];
-        const bool hadPrev = ts.has_prev;
-        const Pt prev = ts.prev;
-
-        for (std::size_t ri = 0; ri < state->rules.size(); ++ri) {
+        es.trackId = trackId;
+        es.label = det.value("label", std::string());
+        es.track = state->tracks.sample(streamId, trackId, es.cur, pts);
+
+        // Zones are tested at the new position; a tripwire against the move.
+        const zm::analytics::Bounds reach =
+            es.track.has_prev ? zm::analytics::segment_bounds(es.track.prev, es.cur)
+                              : zm::analytics::segment_bounds(es.cur, es.cur);
+        state->index.query(streamId, reach, sc.candidates);
+
+        const auto si = static_cast<uint32_t>(sc.samples.size());
+        for (const uint32_t ri : sc.candidates) {
             const Rule& r = state->rules[ri];
-            if (r.has_stream && r.stream_id != streamId) continue;
-            if (!ruleAppliesToClass(r, label)) continue;
-
-            RuleTrackState& rts = ts.rules[ri];
+            RuleCheck c;
+            c.sample = si;
+            c.rule = ri;
+            if (r.type == RuleType::LineCross) {
+                if (!es.track.has_prev || !ruleAppliesToClass(r, es.label)) continue;
+                c.kind = RuleCheck::Line;
+            } else if (!ruleAppliesToClass(r, es.label)) {
+                c.kind = RuleCheck::Carry;
+            } else {
+                c.kind = RuleCheck::Zone;
+                sc.zoneChecks.push_back(static_cast<uint32_t>(sc.checks.size()));
+            }
+            sc.checks.push_back(c);
+        }
+        sc.samples.push_back(std::move(es));
+    }
 
-            switch (r.type) {
-                case RuleType::Intrusion: {
-                    const bool inside =
-                        zm::analytics::point_in_polygon(r.polygon, cur);
-                    if (zm::analytics::intrusion_step(rts.zone, inside))
-                        emitAlarm(state, r, streamId, trackId, label, pts,
+    evaluateZones(state);
+
+    // Step latches and raise alarms in detection order, then rule order.
+    for (const RuleCheck& c : sc.checks) {
+        const EventSample& es = sc.samples[c.sample];
+        const Rule& r = state->rules[c.rule];
+        switch (c.kind) {
+            case RuleCheck::Carry:
+                state->tracks.latch(es.track, c.rule);
+                break;
+            case RuleCheck::Zone: {
+                zm::analytics::ZoneState& zone = state->tracks.latch(es.track, c.rule);
+                if (r.type == RuleType::Intrusion) {
+                    if (zm::analytics::intrusion_step(zone, c.inside))
+                        emitAlarm(state, r, streamId, es.trackId, es.label, pts,
                                   "intrusion");
-                    break;
-                }
-                case RuleType::Loiter: {
-                    const bool inside =
-                        zm::analytics::point_in_polygon(r.polygon, cur);
-                    const auto res = zm::analytics::loiter_step(
-                        rts.zone, inside, pts, r.seconds);
+                } else {
+                    const auto res =
+                        zm::analytics::loiter_step(zone, c.inside, pts, r.seconds);
                     if (res.fire)
-                        emitLoiter(state, r, streamId, trackId, label, pts,
+                        emitLoiter(state, r, streamId, es.trackId, es.label, pts,
                                    res.dwell_sec);
-                    break;
                 }
-                case RuleType::LineCross: {
-                    if (!hadPrev) break;  // need a previous position
-                    if (!zm::analytics::segments_intersect(prev, cur, r.line_a,
-                                                           r.line_b))
-                        break;
-                    const char* dir = crossingDirection(r, prev, cur);
-                    if (r.direction != "any" && std::string(dir) != r.direction)
-                        break;  // wrong direction; ignore
-                    emitLineCross(state, r, streamId, trackId, label, pts, dir);
+                break;
+            }
+            case RuleCheck::Line: {
+                const Pt prev = es.track.prev;
+                if (!zm::analytics::segments_intersect(prev, es.cur, r.line_a, r.line_b))
                     break;
-                }
+                const char* dir = crossingDirection(r, prev, es.cur);
+                if (r.direction != "any" && std::string(dir) != r.direction)
+                    break;  // wrong direction; ignore
+                emitLineCross(state, r, streamId, es.trackId, es.label, pts, dir);
+                break;
             }
         }
-
-        ts.prev = cur;
-        ts.has_prev = true;
-        ts.last_seen = pts;
     }
 }
 
@@ -347,6 +428,7 @@ int analytics_start(zm_plugin_t* plugin, zm_host_api_t* host, void* host_ctx,
     } catch (const std::exception& e) {
         ZM_LOG_ERROR("analytics_rules: failed to parse config: %s", e.what());
     }
+    buildIndex(state);
 
     state->running.store(true);
     ctx->state = state;
@@ -365,7 +447,8 @@ int analytics_start(zm_plugin_t* plugin, zm_host_api_t* host, void* host_ctx,
             state);
     }
 
-    ZM_LOG_INFO("analytics_rules: %zu rule(s) loaded", state->rules.size());
+    ZM_LOG_INFO("analytics_rules: %zu rule(s) loaded (%zu stream-scoped grid(s))",
+                state->rules.size(), state->index.stream_grids());
     return 0;
 }
 
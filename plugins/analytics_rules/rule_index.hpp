@@ -0,0 +1,544 @@
+// Load-time rule compilation and per-track state for the analytics_rules
+// plugin. Like geometry.hpp this is free of the host API so it can be
+// unit-tested standalone (see tests/test_rule_index.cpp).
+//
+//   EdgeTable  - a polygon's edges precomputed once, tested against a batch
+//                of points at a time (same answers as point_in_polygon).
+//   RuleIndex  - rule bounds bucketed into a uniform grid per stream, so an
+//                object only meets the rules near it.
+//   TrackTable - per-(stream, track) positions and per-(track, rule) latches
+//                in flat open-addressing tables. A latch is only trusted if
+//                it was written at the track's previous sample, so latches of
+//                rules an object has left expire without being visited.
+#pragma once
+
+#include "geometry.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#ifdef ZMP_USE_SIMD
+#include <xsimd/xsimd.hpp>
+#endif
+
+namespace zm::analytics {
+
+// Closed axis-aligned box. Default-constructed is empty.
+struct Bounds {
+    float x0 = 0.0f, y0 = 0.0f;
+    float x1 = -1.0f, y1 = -1.0f;
+
+    bool empty() const { return x1 < x0 || y1 < y0; }
+    void add(Pt p) {
+        if (empty()) {
+            x0 = x1 = p.x;
+            y0 = y1 = p.y;
+            return;
+        }
+        x0 = std::min(x0, p.x);
+        x1 = std::max(x1, p.x);
+        y0 = std::min(y0, p.y);
+        y1 = std::max(y1, p.y);
+    }
+    void add(const Bounds& b) {
+        if (b.empty()) return;
+        add(Pt{b.x0, b.y0});
+        add(Pt{b.x1, b.y1});
+    }
+    bool overlaps(const Bounds& b) const {
+        return !empty() && !b.empty() && x0 <= b.x1 && b.x0 <= x1 && y0 <= b.y1 && b.y0 <= y1;
+    }
+    bool contains(Pt p) const { return p.x >= x0 && p.x <= x1 && p.y >= y0 && p.y <= y1; }
+};
+
+inline Bounds bounds_of(const std::vector<Pt>& pts) {
+    Bounds b;
+    for (const Pt& p : pts) b.add(p);
+    return b;
+}
+
+// Box swept by a move from a to b: every segment a-b intersects lies in it.
+inline Bounds segment_bounds(Pt a, Pt b) {
+    Bounds r;
+    r.add(a);
+    r.add(b);
+    return r;
+}
+
+// A polygon compiled for point_in_polygon: per-edge deltas and extents are
+// computed once, and points outside the bounds are rejected before any edge
+// is touched. contains() walks the edges once per batch of points.
+class EdgeTable {
+public:
+    EdgeTable() = default;
+    explicit EdgeTable(const std::vector<Pt>& poly) {
+        const std::size_t n = poly.size();
+        if (n < 3) return;
+        bounds_ = bounds_of(poly);
+        edges_.reserve(n);
+        for (std::size_t i = 0, j = n - 1; i < n; j = i++) {
+            // Same orientation as point_in_polygon: a = poly[i], b = poly[j].
+            const Pt a = poly[i];
+            const Pt b = poly[j];
+            Edge e;
+            e.ax = a.x;
+            e.ay = a.y;
+            e.by = b.y;
+            e.dx = b.x - a.x;
+            e.dy = b.y - a.y;
+            e.xmin = std::min(a.x, b.x);
+            e.xmax = std::max(a.x, b.x);
+            e.ymin = std::min(a.y, b.y);
+            e.ymax = std::max(a.y, b.y);
+            edges_.push_back(e);
+        }
+    }
+
+    bool empty() const { return edges_.empty(); }
+    const Bounds& bounds() const { return bounds_; }
+
+    bool contains(Pt p) const {
+        if (edges_.empty() || !bounds_.contains(p)) return false;
+        bool inside = false;
+        for (const Edge& e : edges_) {
+            if (on_edge(e, p.x, p.y)) return true;
+            if (crosses(e, p.x, p.y)) inside = !inside;
+        }
+        return inside;
+    }
+
+    // out[i] = contains({xs[i], ys[i]}) for i < n.
+    void contains(const float* xs, const float* ys, std::size_t n, uint8_t* out) const {
+        std::size_t i = 0;
+#ifdef ZMP_USE_SIMD
+        using batch_t = xsimd::batch<float>;
+        using mask_t = xsimd::batch_bool<float>;
+        constexpr std::size_t VL = batch_t::size;
+        if (!edges_.empty()) {
+            const batch_t bx0(bounds_.x0), bx1(bounds_.x1);
+            const batch_t by0(bounds_.y0), by1(bounds_.y1);
+            const batch_t zero(0.0f);
+            for (; i + VL <= n; i += VL) {
+                const batch_t px = batch_t::load_unaligned(xs + i);
+                const batch_t py = batch_t::load_unaligned(ys + i);
+                mask_t res = (px >= bx0) & (px <= bx1) & (py >= by0) & (py <= by1);
+                if (xsimd::any(res)) {
+                    mask_t odd(false), on(false);
+                    for (const Edge& e : edges_) {
+                        const batch_t ay(e.ay), dx(e.dx), dy(e.dy), ax(e.ax);
+                        const batch_t ty = py - ay;
+                        // cross(a, b, p) == 0 within the edge's extent.
+                        const batch_t d = dx * ty - dy * (px - ax);
+                        const mask_t within = (px >= batch_t(e.xmin)) & (px <= batch_t(e.xmax)) &
+                                              (py >= batch_t(e.ymin)) & (py <= batch_t(e.ymax));
+                        on = on | ((d == zero) & within);
+                        // Half-open straddle, then the +x ray test. A
+                        // horizontal edge never straddles, so its inf/nan
+                        // quotient is masked out.
+                        const mask_t straddle = (ay > py) ^ (batch_t(e.by) > py);
+                        const batch_t xi = dx * ty / dy + ax;
+                        odd = odd ^ (straddle & (px < xi));
+                    }
+                    res = res & (on | odd);
+                }
+                const uint64_t m = res.mask();
+                for (std::size_t k = 0; k < VL; ++k) out[i + k] = static_cast<uint8_t>((m >> k) & 1);
+            }
+        }
+#endif
+        for (; i < n; ++i) out[i] = contains(Pt{xs[i], ys[i]}) ? 1 : 0;
+    }
+
+private:
+    struct Edge {
+        float ax, ay, by;  // a.x, a.y, b.y
+        float dx, dy;      // b - a
+        float xmin, xmax, ymin, ymax;
+    };
+
+    static bool on_edge(const Edge& e, float px, float py) {
+        const float d = e.dx * (py - e.ay) - e.dy * (px - e.ax);
+        return d == 0.0f && px >= e.xmin && px <= e.xmax && py >= e.ymin && py <= e.ymax;
+    }
+    static bool crosses(const Edge& e, float px, float py) {
+        return ((e.ay > py) != (e.by > py)) && (px < e.dx * (py - e.ay) / e.dy + e.ax);
+    }
+
+    Bounds bounds_;
+    std::vector<Edge> edges_;
+};
+
+// Uniform grid over the bounds of a set of rules, stored as one flat
+// cell -> rule list (CSR). A rule is listed in every cell its bounds touch.
+class RuleGrid {
+public:
+    // ids[i] is the rule index reported for bounds[i]. Empty bounds are
+    // never reported.
+    void build(const std::vector<Bounds>& bounds, const std::vector<uint32_t>& ids) {
+        area_ = Bounds{};
+        for (const Bounds& b : bounds) area_.add(b);
+        cols_ = rows_ = 0;
+        offsets_.clear();
+        entries_.clear();
+        if (area_.empty()) return;
+
+        // About one rule per cell for rules spread over the area; capped so a
+        // grid stays a few KiB.
+        const int n = std::clamp(static_cast<int>(std::ceil(std::sqrt(static_cast<double>(ids.size())))), 1, 64);
+        cols_ = rows_ = n;
+        const float w = area_.x1 - area_.x0, h = area_.y1 - area_.y0;
+        sx_ = w > 0.0f ? static_cast<float>(n) / w : 0.0f;
+        sy_ = h > 0.0f ? static_cast<float>(n) / h : 0.0f;
+
+        offsets_.assign(static_cast<std::size_t>(cols_) * rows_ + 1, 0);
+        for (int pass = 0; pass < 2; ++pass) {
+            std::vector<uint32_t> fill;
+            if (pass == 1) {
+                for (std::size_t c = 1; c < offsets_.size(); ++c) offsets_[c] += offsets_[c - 1];
+                entries_.resize(offsets_.back());
+                fill.assign(offsets_.begin(), offsets_.end() - 1);
+            }
+            for (std::size_t k = 0; k < bounds.size(); ++k) {
+                const Bounds& b = bounds[k];
+                if (b.empty()) continue;
+                const int c0 = col(b.x0), c1 = col(b.x1), r0 = row(b.y0), r1 = row(b.y1);
+                for (int r = r0; r <= r1; ++r)
+                    for (int c = c0; c <= c1; ++c) {
+                        const std::size_t cell = static_cast<std::size_t>(r) * cols_ + c;
+                        if (pass == 0)
+                            ++offsets_[cell + 1];
+                        else
+                            entries_[fill[cell]++] = Entry{b, ids[k]};
+                    }
+            }
+        }
+    }
+
+    // Appends the ids of rules whose bounds overlap q. A rule spanning
+    // several queried cells is appended once per cell.
+    void query(const Bounds& q, std::vector<uint32_t>& out) const {
+        if (!area_.overlaps(q)) return;
+        const int c0 = col(q.x0), c1 = col(q.x1), r0 = row(q.y0), r1 = row(q.y1);
+        for (int r = r0; r <= r1; ++r)
+            for (int c = c0; c <= c1; ++c) {
+                const std::size_t cell = static_cast<std::size_t>(r) * cols_ + c;
+                for (uint32_t k = offsets_[cell]; k < offsets_[cell + 1]; ++k)
+                    if (entries_[k].bounds.overlaps(q)) out.push_back(entries_[k].id);
+            }
+    }
+
+    std::size_t cells() const { return static_cast<std::size_t>(cols_) * rows_; }
+
+private:
+    struct Entry {
+        Bounds bounds;
+        uint32_t id;
+    };
+
+    // Monotonic in the coordinate, so a point inside a rule's bounds always
+    // falls in one of the rule's cells. Clamped before the int conversion
+    // so far-off coordinates stay defined.
+    static int cell_of(float v, int n) {
+        return static_cast<int>(std::clamp(std::floor(v), 0.0f, static_cast<float>(n - 1)));
+    }
+    int col(float x) const { return cell_of((x - area_.x0) * sx_, cols_); }
+    int row(float y) const { return cell_of((y - area_.y0) * sy_, rows_); }
+
+    Bounds area_;
+    int cols_ = 0, rows_ = 0;
+    float sx_ = 0.0f, sy_ = 0.0f;
+    std::vector<uint32_t> offsets_;
+    std::vector<Entry> entries_;
+};
+
+// Where a rule can fire: its bounds and, optionally, the one stream it
+// watches.
+struct RuleFootprint {
+    Bounds bounds;
+    bool has_stream = false;
+    int stream_id = 0;
+};
+
+// Rules compiled into one grid for stream-agnostic rules plus one per
+// stream id that has stream-scoped rules.
+class RuleIndex {
+public:
+    void build(const std::vector<RuleFootprint>& rules) {
+        std::vector<Bounds> shared_bounds;
+        std::vector<uint32_t> shared_ids;
+        std::vector<std::pair<int, uint32_t>> scoped;
+        for (std::size_t i = 0; i < rules.size(); ++i) {
+            if (rules[i].has_stream) {
+                scoped.emplace_back(rules[i].stream_id, static_cast<uint32_t>(i));
+            } else {
+                shared_bounds.push_back(rules[i].bounds);
+                shared_ids.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        shared_.build(shared_bounds, shared_ids);
+
+        std::sort(scoped.begin(), scoped.end());
+        streams_.clear();
+        for (std::size_t i = 0; i < scoped.size();) {
+            std::vector<Bounds> b;
+            std::vector<uint32_t> ids;
+            const int sid = scoped[i].first;
+            for (; i < scoped.size() && scoped[i].first == sid; ++i) {
+                b.push_back(rules[scoped[i].second].bounds);
+                ids.push_back(scoped[i].second);
+            }
+            streams_.emplace_back(sid, RuleGrid{});
+            streams_.back().second.build(b, ids);
+        }
+    }
+
+    // Rules of `stream_id` whose bounds overlap q: ascending, no duplicates.
+    void query(int stream_id, const Bounds& q, std::vector<uint32_t>& out) const {
+        out.clear();
+        shared_.query(q, out);
+        auto it = std::lower_bound(streams_.begin(), streams_.end(), stream_id,
+                                   [](const auto& s, int id) { return s.first < id; });
+        if (it != streams_.end() && it->first == stream_id) it->second.query(q, out);
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+
+    std::size_t stream_grids() const { return streams_.size(); }
+
+private:
+    RuleGrid shared_;
+    std::vector<std::pair<int, RuleGrid>> streams_;  // sorted by stream id
+};
+
+// Per-track positions and per-(track, rule) zone latches.
+//
+// Every sample gets a fresh tick from a table-wide clock. A latch written at
+// the track's previous sample carries over; any other latch reads as a fresh
+// ZoneState. That is exactly the state an intrusion/loiter latch is in after
+// an outside sample, so rules the object is nowhere near need no visit to
+// re-arm.
+class TrackTable {
+public:
+    struct Track {
+        int stream_id = 0;
+        int track_id = 0;
+        bool live = false;
+        bool has_prev = false;
+        Pt prev;                 // ground position at the latest sample
+        uint64_t last_seen = 0;  // pts of the latest sample
+        uint64_t tick = 0;       // clock value of the latest sample
+    };
+
+    // One sample of a track, as handed out by sample().
+    struct Sample {
+        uint32_t slot = 0;
+        uint64_t prev_tick = 0;  // tick of the track's previous sample (0: none)
+        uint64_t tick = 0;
+        bool has_prev = false;
+        Pt prev;                 // position at the previous sample
+    };
+
+    // Record a new position of (stream_id, track_id), creating the track on
+    // first sight.
+    Sample sample(int stream_id, int track_id, Pt cur, uint64_t pts) {
+        const uint32_t slot = find_or_add(stream_id, track_id);
+        Track& t = slots_[slot];
+        Sample s;
+        s.slot = slot;
+        s.prev_tick = t.tick;
+        s.tick = ++clock_;
+        s.has_prev = t.has_prev;
+        s.prev = t.prev;
+        t.tick = s.tick;
+        t.has_prev = true;
+        t.prev = cur;
+        t.last_seen = pts;
+        return s;
+    }
+
+    // The latch of `rule` for sample s, carried over from the track's
+    // previous sample or reset. Latches of one sample must be taken before
+    // the track's next sample's.
+    ZoneState& latch(const Sample& s, uint32_t rule) {
+        if ((latch_used_ + 1) * 4 > latches_.size() * 3)
+            rehash_latches(std::max<std::size_t>(kMinLatches, latches_.size() * 2), false);
+        const uint64_t key = (static_cast<uint64_t>(s.slot) << 32) | rule;
+        const std::size_t mask = latches_.size() - 1;
+        for (std::size_t i = mix(key) & mask;; i = (i + 1) & mask) {
+            Latch& e = latches_[i];
+            if (e.tick == 0) {
+                e.key = key;
+                e.zone = ZoneState{};
+                ++latch_used_;
+            } else if (e.key != key) {
+                continue;
+            } else if (e.tick != s.prev_tick && e.tick != s.tick) {
+                e.zone = ZoneState{};
+            }
+            e.tick = s.tick;
+            return e.zone;
+        }
+    }
+
+    // Drop tracks last seen more than max_age before `now` (a track seen
+    // after `now` is kept), then compact the latch table if expired latches
+    // fill half of it. Returns the number of tracks dropped.
+    std::size_t prune(uint64_t now, uint64_t max_age) {
+        std::size_t dropped = 0;
+        for (uint32_t slot = 0; slot < slots_.size(); ++slot) {
+            Track& t = slots_[slot];
+            if (!t.live || now < t.last_seen || now - t.last_seen <= max_age) continue;
+            erase_index(key_of(t.stream_id, t.track_id));
+            t = Track{};
+            free_.push_back(slot);
+            --live_;
+            ++dropped;
+        }
+        if (latch_used_ * 2 > latches_.size()) {
+            std::size_t keep = 0;
+            for (const Latch& e : latches_)
+                if (latch_live(e)) ++keep;
+            std::size_t cap = kMinLatches;
+            while (cap < keep * 4) cap *= 2;
+            rehash_latches(cap, true);
+        }
+        return dropped;
+    }
+
+    std::size_t size() const { return live_; }
+    const Track* find(int stream_id, int track_id) const {
+        const uint32_t slot = lookup(key_of(stream_id, track_id));
+        return slot == kNone ? nullptr : &slots_[slot];
+    }
+    std::size_t latch_capacity() const { return latches_.size(); }
+
+private:
+    static constexpr uint32_t kNone = 0xffffffffu;
+    static constexpr std::size_t kMinLatches = 64;
+    static constexpr std::size_t kMinIndex = 64;
+
+    struct IndexEntry {
+        uint64_t key = 0;
+        uint32_t slot = kNone;
+    };
+    struct Latch {
+        uint64_t key = 0;   // slot << 32 | rule
+        uint64_t tick = 0;  // sample that last wrote it; 0 = empty
+        ZoneState zone;
+    };
+
+    static uint64_t key_of(int stream_id, int track_id) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(stream_id)) << 32) |
+               static_cast<uint32_t>(track_id);
+    }
+    // splitmix64 finalizer: spreads sequential track ids over the table.
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    uint32_t lookup(uint64_t key) const {
+        if (index_.empty()) return kNone;
+        const std::size_t mask = index_.size() - 1;
+        for (std::size_t i = mix(key) & mask;; i = (i + 1) & mask) {
+            if (index_[i].slot == kNone) return kNone;
+            if (index_[i].key == key) return index_[i].slot;
+        }
+    }
+
+    void insert_index(uint64_t key, uint32_t slot) {
+        const std::size_t mask = index_.size() - 1;
+        std::size_t i = mix(key) & mask;
+        while (index_[i].slot != kNone) i = (i + 1) & mask;
+        index_[i] = IndexEntry{key, slot};
+    }
+
+    // Linear-probing delete with backward shift, so no tombstones build up.
+    void erase_index(uint64_t key) {
+        const std::size_t mask = index_.size() - 1;
+        std::size_t i = mix(key) & mask;
+        for (;; i = (i + 1) & mask) {
+            if (index_[i].slot == kNone) return;
+            if (index_[i].key == key) break;
+        }
+        for (std::size_t j = (i + 1) & mask; index_[j].slot != kNone; j = (j + 1) & mask) {
+            const std::size_t home = mix(index_[j].key) & mask;
+            // Move j into the hole at i unless its home lies in (i, j].
+            const bool stays = (i < j) ? (home > i && home <= j) : (home > i || home <= j);
+            if (stays) continue;
+            index_[i] = index_[j];
+            i = j;
+        }
+        index_[i] = IndexEntry{};
+    }
+
+    uint32_t find_or_add(int stream_id, int track_id) {
+        const uint64_t key = key_of(stream_id, track_id);
+        const uint32_t found = lookup(key);
+        if (found != kNone) return found;
+
+        if ((live_ + 1) * 4 > index_.size() * 3) {
+            std::vector<IndexEntry> old;
+            old.swap(index_);
+            index_.assign(std::max(kMinIndex, old.size() * 2), IndexEntry{});
+            for (const IndexEntry& e : old)
+                if (e.slot != kNone) insert_index(e.key, e.slot);
+        }
+        uint32_t slot;
+        if (!free_.empty()) {
+            slot = free_.back();
+            free_.pop_back();
+        } else {
+            slot = static_cast<uint32_t>(slots_.size());
+            slots_.emplace_back();
+        }
+        Track& t = slots_[slot];
+        t = Track{};
+        t.stream_id = stream_id;
+        t.track_id = track_id;
+        t.live = true;
+        insert_index(key, slot);
+        ++live_;
+        return slot;
+    }
+
+    // Between events the only latch a track can still read is the one
+    // written at its latest sample.
+    bool latch_live(const Latch& e) const {
+        if (e.tick == 0) return false;
+        const Track& t = slots_[static_cast<uint32_t>(e.key >> 32)];
+        return t.live && t.tick == e.tick;
+    }
+
+    void rehash_latches(std::size_t cap, bool drop_expired) {
+        std::vector<Latch> old;
+        old.swap(latches_);
+        latches_.assign(cap, Latch{});
+        latch_used_ = 0;
+        const std::size_t mask = cap - 1;
+        for (const Latch& e : old) {
+            if (e.tick == 0 || (drop_expired && !latch_live(e))) continue;
+            std::size_t i = mix(e.key) & mask;
+            while (latches_[i].tick != 0) i = (i + 1) & mask;
+            latches_[i] = e;
+            ++latch_used_;
+        }
+    }
+
+    std::vector<Track> slots_;
+    std::vector<uint32_t> free_;
+    std::vector<IndexEntry> index_;
+    std::vector<Latch> latches_;
+    std::size_t live_ = 0;
+    std::size_t latch_used_ = 0;
+    uint64_t clock_ = 0;
+};
+
+}  // namespace zm::analytics
@@ -0,0 +1,225 @@
+#include "rule_index.hpp"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+
+using zm::analytics::Bounds;
+using zm::analytics::EdgeTable;
+using zm::analytics::intrusion_step;
+using zm::analytics::point_in_polygon;
+using zm::analytics::Pt;
+using zm::analytics::RuleFootprint;
+using zm::analytics::RuleIndex;
+using zm::analytics::TrackTable;
+using zm::analytics::ZoneState;
+
+namespace {
+
+// Concave "U": notch cut from the top between x=4..6 down to y=5.
+std::vector<Pt> u_shape() {
+    return {{0, 0}, {10, 0}, {10, 10}, {6, 10}, {6, 5}, {4, 5}, {4, 10}, {0, 10}};
+}
+
+std::vector<Pt> random_polygon(std::mt19937& rng) {
+    std::uniform_real_distribution<float> c(0.0f, 100.0f), r(2.0f, 30.0f);
+    const float cx = c(rng), cy = c(rng);
+    const int n = 3 + static_cast<int>(rng() % 9);
+    std::vector<Pt> poly;
+    for (int i = 0; i < n; ++i) {
+        // Star-shaped around the center, with integer-ish vertices so some
+        // samples land exactly on vertices and edges.
+        const float a = 6.2831853f * static_cast<float>(i) / static_cast<float>(n);
+        const float rad = r(rng);
+        poly.push_back({std::round(cx + rad * std::cos(a)), std::round(cy + rad * std::sin(a))});
+    }
+    return poly;
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// EdgeTable
+// ---------------------------------------------------------------------------
+TEST(EdgeTable, MatchesPointInPolygon) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> u(-10.0f, 110.0f);
+    for (int t = 0; t < 200; ++t) {
+        const auto poly = t == 0 ? u_shape() : random_polygon(rng);
+        const EdgeTable et(poly);
+        std::vector<float> xs, ys;
+        for (int k = 0; k < 61; ++k) {
+            xs.push_back(u(rng));
+            ys.push_back(u(rng));
+        }
+        for (const Pt& v : poly) {  // vertices and edge midpoints
+            xs.push_back(v.x);
+            ys.push_back(v.y);
+            xs.push_back(std::round(v.x) + 0.5f);
+            ys.push_back(v.y);
+        }
+        for (int k = 0; k < 20; ++k) {  // lattice points
+            xs.push_back(static_cast<float>(rng() % 100));
+            ys.push_back(static_cast<float>(rng() % 100));
+        }
+        std::vector<uint8_t> out(xs.size());
+        et.contains(xs.data(), ys.data(), xs.size(), out.data());
+        for (size_t i = 0; i < xs.size(); ++i) {
+            const Pt p{xs[i], ys[i]};
+            const bool want = point_in_polygon(poly, p);
+            ASSERT_EQ(et.contains(p), want) << "poly " << t << " point " << p.x << "," << p.y;
+            ASSERT_EQ(out[i] != 0, want) << "poly " << t << " point " << p.x << "," << p.y;
+        }
+    }
+}
+
+TEST(EdgeTable, Degenerate) {
+    const EdgeTable et(std::vector<Pt>{{0, 0}, {1, 1}});
+    EXPECT_TRUE(et.empty());
+    const float xs[5] = {0, 0, 0, 0, 0}, ys[5] = {0, 0, 0, 0, 0};
+    uint8_t out[5] = {1, 1, 1, 1, 1};
+    et.contains(xs, ys, 5, out);
+    for (uint8_t v : out) EXPECT_EQ(v, 0);
+}
+
+// ---------------------------------------------------------------------------
+// RuleIndex
+// ---------------------------------------------------------------------------
+TEST(RuleIndex, CandidatesCoverEveryOverlappingRule) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> u(0.0f, 1000.0f), s(0.0f, 80.0f);
+    std::vector<RuleFootprint> rules(300);
+    for (size_t i = 0; i < rules.size(); ++i) {
+        const float x = u(rng), y = u(rng);
+        rules[i].bounds.add(Pt{x, y});
+        rules[i].bounds.add(Pt{x + s(rng), i % 7 == 0 ? y : y + s(rng)});  // some flat lines
+        rules[i].has_stream = i % 3 == 0;
+        rules[i].stream_id = static_cast<int>(i % 2);
+    }
+    RuleIndex index;
+    index.build(rules);
+    EXPECT_EQ(index.stream_grids(), 2u);
+
+    std::vector<uint32_t> got;
+    for (int q = 0; q < 500; ++q) {
+        const int stream = q % 3;
+        Bounds box;
+        box.add(Pt{u(rng), u(rng)});
+        if (q % 2) box.add(Pt{box.x0 + s(rng), box.y0 + s(rng)});
+        index.query(stream, box, got);
+        std::vector<uint32_t> want;
+        for (size_t i = 0; i < rules.size(); ++i)
+            if ((!rules[i].has_stream || rules[i].stream_id == stream) && rules[i].bounds.overlaps(box))
+                want.push_back(static_cast<uint32_t>(i));
+        ASSERT_EQ(got, want) << "query " << q;
+    }
+
+    // Far outside the rules' area.
+    Bounds far;
+    far.add(Pt{1e30f, -1e30f});
+    index.query(0, far, got);
+    EXPECT_TRUE(got.empty());
+}
+
+TEST(RuleIndex, Empty) {
+    RuleIndex index;
+    index.build({});
+    std::vector<uint32_t> got{1, 2};
+    Bounds q;
+    q.add(Pt{1, 1});
+    index.query(0, q, got);
+    EXPECT_TRUE(got.empty());
+}
+
+// ---------------------------------------------------------------------------
+// TrackTable
+// ---------------------------------------------------------------------------
+TEST(TrackTable, PositionsAndPruning) {
+    TrackTable t;
+    auto s = t.sample(1, 5, Pt{1, 2}, 100);
+    EXPECT_FALSE(s.has_prev);
+    s = t.sample(1, 5, Pt{3, 4}, 200);
+    ASSERT_TRUE(s.has_prev);
+    EXPECT_EQ(s.prev.x, 1.0f);
+    EXPECT_EQ(s.prev.y, 2.0f);
+    t.sample(2, 5, Pt{0, 0}, 900);  // same track id, other stream
+    EXPECT_EQ(t.size(), 2u);
+
+    EXPECT_EQ(t.prune(1000, 500), 1u);  // (1,5) last seen at 200
+    EXPECT_EQ(t.find(1, 5), nullptr);
+    ASSERT_NE(t.find(2, 5), nullptr);
+    EXPECT_EQ(t.prune(100, 500), 0u);  // clock went backwards: keep
+    s = t.sample(1, 5, Pt{9, 9}, 1000);
+    EXPECT_FALSE(s.has_prev);
+}
+
+TEST(TrackTable, ManyTracksSurviveChurn) {
+    TrackTable t;
+    for (int round = 0; round < 20; ++round) {
+        const uint64_t now = static_cast<uint64_t>(round) * 10;
+        for (int id = round * 50; id < round * 50 + 200; ++id) t.sample(0, id, Pt{}, now);
+        t.prune(now, 15);
+        for (int id = round * 50; id < round * 50 + 200; ++id) ASSERT_NE(t.find(0, id), nullptr);
+        for (int id = 0; id < round * 50 - 50; ++id) ASSERT_EQ(t.find(0, id), nullptr) << id;
+    }
+}
+
+TEST(TrackTable, LatchCarriesOnlyFromPreviousSample) {
+    TrackTable t;
+    auto s = t.sample(0, 1, Pt{}, 0);
+    EXPECT_TRUE(intrusion_step(t.latch(s, 3), true));
+    s = t.sample(0, 1, Pt{}, 1);
+    EXPECT_FALSE(intrusion_step(t.latch(s, 3), true));  // still inside
+    s = t.sample(0, 1, Pt{}, 2);                          // rule 3 not visited
+    s = t.sample(0, 1, Pt{}, 3);
+    EXPECT_TRUE(intrusion_step(t.latch(s, 3), true));  // re-armed
+}
+
+// The sparse scheme (only rules near the object are visited, latches expire
+// by tick) raises the same alarms as visiting every rule with map state.
+TEST(TrackTable, SparseVisitsMatchDenseLatches) {
+    std::mt19937 rng(3);
+    std::vector<std::vector<Pt>> polys;
+    std::vector<EdgeTable> tables;
+    std::vector<RuleFootprint> fp;
+    for (int i = 0; i < 40; ++i) {
+        polys.push_back(random_polygon(rng));
+        tables.emplace_back(polys.back());
+        fp.push_back(RuleFootprint{tables.back().bounds()});
+    }
+    RuleIndex index;
+    index.build(fp);
+
+    TrackTable sparse;
+    std::map<std::pair<int, size_t>, ZoneState> dense;
+    std::vector<Pt> pos(30);
+    for (auto& p : pos) p = {static_cast<float>(rng() % 100), static_cast<float>(rng() % 100)};
+    std::vector<uint32_t> cand;
+    size_t fired = 0;
+    for (int step = 0; step < 400; ++step) {
+        for (size_t k = 0; k < pos.size(); ++k) {
+            if (rng() % 4 == 0) continue;  // not every track in every event
+            pos[k].x += static_cast<float>(static_cast<int>(rng() % 7) - 3);
+            pos[k].y += static_cast<float>(static_cast<int>(rng() % 7) - 3);
+            const Pt p = pos[k];
+            std::vector<size_t> want;
+            for (size_t r = 0; r < polys.size(); ++r)
+                if (intrusion_step(dense[{static_cast<int>(k), r}], point_in_polygon(polys[r], p)))
+                    want.push_back(r);
+
+            const auto s = sparse.sample(0, static_cast<int>(k), p, static_cast<uint64_t>(step));
+            Bounds q;
+            q.add(p);
+            index.query(0, q, cand);
+            std::vector<size_t> got;
+            for (uint32_t r : cand)
+                if (intrusion_step(sparse.latch(s, r), tables[r].contains(p))) got.push_back(r);
+            ASSERT_EQ(got, want) << "step " << step << " track " << k;
+            fired += got.size();
+        }
+        sparse.prune(static_cast<uint64_t>(step), 1000);
+    }
+    EXPECT_GT(fired, 20u);
+    EXPECT_LE(sparse.latch_capacity(), 1024u);  // expired latches get compacted
+}
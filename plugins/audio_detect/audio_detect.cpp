@@ -18,6 +18,7 @@
 
 #include "audio_topk.hpp"
 #include "logmel.hpp"
+#include "../detect_onnx/ort_model.hpp"  // open_session (shared model cache)
 
 #include <onnxruntime_cxx_api.h>
 
@@ -33,6 +34,7 @@
 #include <vector>
 
 #include "zm_plugin.h"
+#include "zm_side_data.h"
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -92,6 +94,7 @@ struct AudioDetectCtx {
     // ONNX Runtime state.
     std::unique_ptr<Ort::Env> env;
     Ort::SessionOptions sessionOptions;
+    std::shared_ptr<const zm::io::MappedFile> modelMapping;  // outlives session
     std::unique_ptr<Ort::Session> session;
     std::string inputName;
     std::string outputName;
@@ -460,8 +463,10 @@ static int audio_detect_start(zm_plugin_t* plugin, zm_host_api_t* host,
     // Construct the session if a model path was given.
     if (!ctx->modelPath.empty() && ctx->env) {
         try {
-            ctx->session = std::make_unique<Ort::Session>(
-                *ctx->env, ctx->modelPath.c_str(), ctx->sessionOptions);
+            zm::hw::CachedSession cs = zm::hw::open_session(
+                *ctx->env, ctx->modelPath, ctx->sessionOptions, "cpu");
+            ctx->modelMapping = std::move(cs.mapping);
+            ctx->session = std::move(cs.session);
 
             Ort::AllocatorWithDefaultOptions allocator;
             auto inName = ctx->session->GetInputNameAllocated(0, allocator);
@@ -476,16 +481,17 @@ static int audio_detect_start(zm_plugin_t* plugin, zm_host_api_t* host,
             if (ctx->inputRank != 2) ctx->inputRank = 1;
 
             ZM_LOG_INFO("audio_detect: loaded model '%s' (input='%s' output='%s' "
-                        "rank=%lld sr=%d win=%zu hop=%zu)",
+                        "rank=%lld sr=%d win=%zu hop=%zu) %s",
                         ctx->modelPath.c_str(), ctx->inputName.c_str(),
                         ctx->outputName.c_str(),
                         static_cast<long long>(ctx->inputRank), ctx->sampleRate,
-                        ctx->windowSamples, ctx->hopSamples);
+                        ctx->windowSamples, ctx->hopSamples, cs.stats.summary().c_str());
         } catch (const std::exception& e) {
             ZM_LOG_ERROR("audio_detect: failed to load model '%s': %s "
                          "(running as pass-through)",
                          ctx->modelPath.c_str(), e.what());
             ctx->session.reset();
+            ctx->modelMapping.reset();
         }
     } else {
         ZM_LOG_WARN("audio_detect: no model_path configured; running as pass-through");
@@ -523,7 +529,7 @@ static void audio_detect_on_frame(zm_plugin_t* plugin, const void* buf, size_t s
 
     const zm_frame_hdr_t* hdr = static_cast<const zm_frame_hdr_t*>(buf);
     const uint8_t* payload = static_cast<const uint8_t*>(buf) + sizeof(zm_frame_hdr_t);
-    const size_t payloadSize = size - sizeof(zm_frame_hdr_t);
+    const size_t payloadSize = zm_frame_payload_size(buf, size);
 
     // Not a compressed-audio frame (or wrong stream, or we can't run) -> forward.
     // audioStreamId < 0 means "any audio stream".
@@ -0,0 +1,99 @@
+#pragma once
+
+// Fast-start helpers for capture_rtsp_multi. A reconnect that reuses the
+// codec parameters cached from the last full probe (instead of running
+// avformat_find_stream_info again) checks them lazily: the first keyframe's
+// in-band SPS must match the SPS in the cached extradata. FFmpeg-free so it
+// is unit-testable.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace zm::codec_cache {
+
+struct Nal {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+inline int nal_type(const uint8_t* nal, bool hevc) {
+    return hevc ? (nal[0] >> 1) & 0x3f : nal[0] & 0x1f;
+}
+
+inline int sps_type(bool hevc) { return hevc ? 33 : 7; }
+
+// Trailing zero bytes belong to the next start code (or are padding), not
+// to the NAL.
+inline Nal trim_nal(const uint8_t* p, size_t n) {
+    while (n > 0 && p[n - 1] == 0) --n;
+    return {p, n};
+}
+
+// First NAL of `type` in an Annex B buffer.
+inline Nal find_annexb_nal(const uint8_t* p, size_t n, bool hevc, int type) {
+    size_t i = 0;
+    while (i + 3 <= n) {
+        if (p[i] == 0 && p[i + 1] == 0 && p[i + 2] == 1) {
+            const size_t begin = i + 3;
+            size_t end = begin;
+            while (end + 3 <= n && !(p[end] == 0 && p[end + 1] == 0 && p[end + 2] == 1)) ++end;
+            if (end + 3 > n) end = n;
+            if (begin < end && nal_type(p + begin, hevc) == type) return trim_nal(p + begin, end - begin);
+            i = end;
+        } else {
+            ++i;
+        }
+    }
+    return {};
+}
+
+// SPS from codec extradata: Annex B (RTSP sprop / parser output), avcC or
+// hvcC.
+inline Nal extradata_sps(const uint8_t* p, size_t n, bool hevc) {
+    if (!p || n < 4) return {};
+    if (p[0] == 0 && p[1] == 0 && (p[2] == 1 || (p[2] == 0 && p[3] == 1)))
+        return find_annexb_nal(p, n, hevc, sps_type(hevc));
+    if (!hevc) {
+        // avcC: version, profile, compat, level, lengthSize, numSPS, [len16 sps]...
+        if (n < 8 || p[0] != 1 || (p[5] & 0x1f) == 0) return {};
+        const size_t len = static_cast<size_t>(p[6]) << 8 | p[7];
+        return 8 + len <= n ? Nal{p + 8, len} : Nal{};
+    }
+    // hvcC: 22-byte header, numArrays, then {type, numNalus16, [len16 nal]...}.
+    if (n < 23) return {};
+    size_t off = 23;
+    for (unsigned a = 0; a < p[22]; ++a) {
+        if (off + 3 > n) return {};
+        const int type = p[off] & 0x3f;
+        const size_t count = static_cast<size_t>(p[off + 1]) << 8 | p[off + 2];
+        off += 3;
+        for (size_t k = 0; k < count; ++k) {
+            if (off + 2 > n) return {};
+            const size_t len = static_cast<size_t>(p[off]) << 8 | p[off + 1];
+            off += 2;
+            if (off + len > n) return {};
+            if (type == 33) return {p + off, len};
+            off += len;
+        }
+    }
+    return {};
+}
+
+enum class SpsCheck {
+    NoSps,     // packet (or cache) carries no SPS: nothing to compare yet
+    Match,
+    Mismatch,  // stream was reconfigured: cached parameters are stale
+};
+
+inline SpsCheck check_sps(const uint8_t* extradata, size_t extradata_size, const uint8_t* pkt,
+                          size_t pkt_size, bool hevc) {
+    const Nal cached = extradata_sps(extradata, extradata_size, hevc);
+    const Nal live = find_annexb_nal(pkt, pkt_size, hevc, sps_type(hevc));
+    if (!cached.data || !live.data) return SpsCheck::NoSps;
+    const Nal a = trim_nal(cached.data, cached.size);
+    return a.size == live.size && std::memcmp(a.data, live.data, a.size) == 0 ? SpsCheck::Match
+                                                                              : SpsCheck::Mismatch;
+}
+
+}  // namespace zm::codec_cache
@@ -0,0 +1,55 @@
+#pragma once
+
+// Per-stream demux read counters for capture_rtsp_multi. FFmpeg-free so the
+// arithmetic is unit-testable. Written by the stream's capture thread only;
+// the atomics are read by get_stream_statistics() and the StreamStats event.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+struct ReadStats {
+    std::atomic<uint64_t> packets{0};        // successful av_read_frame calls
+    std::atomic<uint64_t> read_us_total{0};  // time blocked in av_read_frame
+    std::atomic<uint64_t> read_us_max{0};
+    std::atomic<uint64_t> jitter_us{0};      // RFC 3550 interarrival jitter (video)
+
+    // One av_read_frame that blocked for `blocked_us` and returned a packet.
+    void on_read(uint64_t blocked_us) {
+        packets.fetch_add(1, std::memory_order_relaxed);
+        read_us_total.fetch_add(blocked_us, std::memory_order_relaxed);
+        if (blocked_us > read_us_max.load(std::memory_order_relaxed))
+            read_us_max.store(blocked_us, std::memory_order_relaxed);
+    }
+
+    // A video packet arrived at `arrival_us` (monotonic) carrying `pts_us`.
+    // Jitter is J += (|D| - J) / 16 with D = arrival delta - pts delta, taken
+    // once per frame: further slices of the same frame share its pts.
+    void on_video_packet(int64_t arrival_us, int64_t pts_us) {
+        if (have_last_ && pts_us == last_pts_us_) return;
+        if (have_last_) {
+            const double d = static_cast<double>(arrival_us - last_arrival_us_) -
+                             static_cast<double>(pts_us - last_pts_us_);
+            jitter_ += (std::fabs(d) - jitter_) / 16.0;
+            jitter_us.store(static_cast<uint64_t>(jitter_), std::memory_order_relaxed);
+        }
+        have_last_ = true;
+        last_arrival_us_ = arrival_us;
+        last_pts_us_ = pts_us;
+    }
+
+    // Timestamps restart on reconnect; do not count the gap as jitter.
+    void reset_timing() { have_last_ = false; }
+
+    uint64_t read_us_avg() const {
+        const uint64_t n = packets.load(std::memory_order_relaxed);
+        return n ? read_us_total.load(std::memory_order_relaxed) / n : 0;
+    }
+
+private:
+    bool have_last_ = false;
+    int64_t last_arrival_us_ = 0;
+    int64_t last_pts_us_ = 0;
+    double jitter_ = 0.0;
+};
@@ -0,0 +1,300 @@
+#pragma once
+
+// RTP depacketizers for the epoll RTSP ingest (rtsp_ingest.cpp): H.264
+// (RFC 6184), H.265 (RFC 7798) and AAC (RFC 3640 mpeg4-generic, AAC-hbr).
+// Header-only and FFmpeg-free so they are unit-testable.
+//
+// Video comes out one access unit at a time in Annex B (start-code) form, the
+// same layout libavformat's RTSP demuxer hands capture_rtsp_multi; AAC comes
+// out as raw access units. An access unit that lost a packet is dropped rather
+// than forwarded half-built.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace zm::rtp {
+
+struct RtpPacket {
+    uint8_t payload_type = 0;
+    bool marker = false;
+    uint16_t seq = 0;
+    uint32_t timestamp = 0;
+    uint32_t ssrc = 0;
+    const uint8_t* payload = nullptr;
+    size_t size = 0;
+};
+
+// Parse an RTP packet (CSRCs, header extension and padding skipped). False for
+// anything that is not RTP version 2 or is truncated.
+inline bool parse_rtp(const uint8_t* p, size_t n, RtpPacket& out) {
+    if (!p || n < 12 || (p[0] >> 6) != 2) return false;
+    size_t off = 12 + static_cast<size_t>(p[0] & 0x0f) * 4;
+    if (off > n) return false;
+    if (p[0] & 0x10) {  // header extension
+        if (off + 4 > n) return false;
+        off += 4 + (static_cast<size_t>(p[off + 2]) << 8 | p[off + 3]) * 4;
+        if (off > n) return false;
+    }
+    size_t end = n;
+    if (p[0] & 0x20) {  // padding
+        const uint8_t pad = p[n - 1];
+        if (pad == 0 || pad > end - off) return false;
+        end -= pad;
+    }
+    out.marker = (p[1] & 0x80) != 0;
+    out.payload_type = p[1] & 0x7f;
+    out.seq = static_cast<uint16_t>(p[2] << 8 | p[3]);
+    out.timestamp = static_cast<uint32_t>(p[4]) << 24 | static_cast<uint32_t>(p[5]) << 16 |
+                    static_cast<uint32_t>(p[6]) << 8 | p[7];
+    out.ssrc = static_cast<uint32_t>(p[8]) << 24 | static_cast<uint32_t>(p[9]) << 16 |
+               static_cast<uint32_t>(p[10]) << 8 | p[11];
+    out.payload = p + off;
+    out.size = end - off;
+    return true;
+}
+
+// Extends 32-bit RTP timestamps to a monotonic 64-bit count (wrap-safe for
+// steps under 2^31 either way).
+class TimestampUnwrapper {
+public:
+    int64_t unwrap(uint32_t ts) {
+        if (!init_) {
+            init_ = true;
+            last_ = ts;
+            return last_;
+        }
+        last_ += static_cast<int32_t>(ts - static_cast<uint32_t>(last_));
+        return last_;
+    }
+    void reset() { init_ = false; }
+
+private:
+    bool init_ = false;
+    int64_t last_ = 0;
+};
+
+// H.264 / H.265 access-unit assembler. Emits through
+// `emit(const uint8_t* data, size_t size, uint32_t rtp_ts, bool keyframe)`.
+class H26xDepacketizer {
+public:
+    explicit H26xDepacketizer(bool hevc = false) : hevc_(hevc) {}
+
+    // Out-of-band parameter sets (Annex B, from the SDP sprop-* attributes),
+    // prepended to keyframes that arrive without them in-band.
+    void set_parameter_sets(std::vector<uint8_t> annexb) { param_sets_ = std::move(annexb); }
+
+    uint64_t dropped() const { return dropped_; }
+
+    template <typename Emit>
+    void push(const RtpPacket& pkt, Emit&& emit) {
+        // Lost packet(s) may belong to the AU in progress or to the next one's
+        // start, so both are treated as incomplete.
+        const bool gap = have_seq_ && pkt.seq != static_cast<uint16_t>(last_seq_ + 1);
+        have_seq_ = true;
+        last_seq_ = pkt.seq;
+        if (gap) broken_ = true;
+
+        if (started_ && pkt.timestamp != au_ts_) flush(emit);  // previous AU lost its marker
+        if (!started_) {
+            started_ = true;
+            au_ts_ = pkt.timestamp;
+            broken_ = gap;
+        }
+        if (hevc_) push_h265(pkt.payload, pkt.size);
+        else push_h264(pkt.payload, pkt.size);
+        if (pkt.marker) flush(emit);
+    }
+
+private:
+    template <typename Emit>
+    void flush(Emit&& emit) {
+        if (started_ && !broken_ && !in_fu_ && !au_.empty()) {
+            if (key_ && !has_ps_ && !param_sets_.empty()) {
+                au_.insert(au_.begin(), param_sets_.begin(), param_sets_.end());
+            }
+            emit(au_.data(), au_.size(), au_ts_, key_);
+        } else if (started_ && (broken_ || in_fu_)) {
+            ++dropped_;
+        }
+        au_.clear();
+        started_ = broken_ = in_fu_ = key_ = has_ps_ = false;
+    }
+
+    void begin_nal() {
+        static const uint8_t kStart[4] = {0, 0, 0, 1};
+        au_.insert(au_.end(), kStart, kStart + 4);
+    }
+
+    void note_type(int type) {
+        if (hevc_) {
+            if (type >= 16 && type <= 21) key_ = true;  // IRAP
+            if (type >= 32 && type <= 34) has_ps_ = true;  // VPS/SPS/PPS
+        } else {
+            if (type == 5) key_ = true;
+            if (type == 7) has_ps_ = true;
+        }
+    }
+
+    void add_nal(const uint8_t* p, size_t n) {
+        if (n == 0) return;
+        note_type(hevc_ ? (p[0] >> 1) & 0x3f : p[0] & 0x1f);
+        begin_nal();
+        au_.insert(au_.end(), p, p + n);
+    }
+
+    // Aggregation packet body: repeated [size16][nal].
+    void add_aggregate(const uint8_t* p, size_t n) {
+        while (n >= 2) {
+            const size_t len = static_cast<size_t>(p[0]) << 8 | p[1];
+            p += 2;
+            n -= 2;
+            if (len > n) {
+                broken_ = true;
+                return;
+            }
+            add_nal(p, len);
+            p += len;
+            n -= len;
+        }
+    }
+
+    void push_h264(const uint8_t* p, size_t n) {
+        if (n < 1) return;
+        const int type = p[0] & 0x1f;
+        if (type >= 1 && type <= 23) {
+            add_nal(p, n);
+        } else if (type == 24) {  // STAP-A
+            add_aggregate(p + 1, n - 1);
+        } else if (type == 28) {  // FU-A
+            if (n < 2) return;
+            const bool start = (p[1] & 0x80) != 0, end = (p[1] & 0x40) != 0;
+            if (start) {
+                const uint8_t hdr = static_cast<uint8_t>((p[0] & 0xe0) | (p[1] & 0x1f));
+                note_type(hdr & 0x1f);
+                begin_nal();
+                au_.push_back(hdr);
+                in_fu_ = true;
+            } else if (!in_fu_) {
+                broken_ = true;  // continuation without its start
+                return;
+            }
+            au_.insert(au_.end(), p + 2, p + n);
+            if (end) in_fu_ = false;
+        }
+        // STAP-B / MTAP / FU-B (interleaved mode) are not negotiated; ignored.
+    }
+
+    void push_h265(const uint8_t* p, size_t n) {
+        if (n < 2) return;
+        const int type = (p[0] >> 1) & 0x3f;
+        if (type == 48) {  // AP
+            add_aggregate(p + 2, n - 2);
+        } else if (type == 49) {  // FU
+            if (n < 3) return;
+            const bool start = (p[2] & 0x80) != 0, end = (p[2] & 0x40) != 0;
+            if (start) {
+                const int nal_type = p[2] & 0x3f;
+                note_type(nal_type);
+                begin_nal();
+                au_.push_back(static_cast<uint8_t>((p[0] & 0x81) | (nal_type << 1)));
+                au_.push_back(p[1]);
+                in_fu_ = true;
+            } else if (!in_fu_) {
+                broken_ = true;
+                return;
+            }
+            au_.insert(au_.end(), p + 3, p + n);
+            if (end) in_fu_ = false;
+        } else if (type != 50) {  // PACI ignored
+            add_nal(p, n);
+        }
+    }
+
+    bool hevc_;
+    std::vector<uint8_t> param_sets_;
+    std::vector<uint8_t> au_;
+    uint32_t au_ts_ = 0;
+    uint16_t last_seq_ = 0;
+    bool have_seq_ = false;
+    bool started_ = false, broken_ = false, in_fu_ = false, key_ = false, has_ps_ = false;
+    uint64_t dropped_ = 0;
+};
+
+// RFC 3640 AAC-hbr depacketizer: AU-headers-length, then per AU a
+// sizelength-bit size and an index(delta)length-bit index. Emits
+// `emit(const uint8_t* data, size_t size, uint32_t rtp_ts, bool keyframe)`
+// once per AU, stepping the timestamp by frame_samples. An AU fragmented over
+// several packets (one AU header each) is reassembled.
+class AacDepacketizer {
+public:
+    AacDepacketizer(int size_length = 13, int index_length = 3, int index_delta_length = 3,
+                    int frame_samples = 1024)
+        : size_len_(size_length), index_len_(index_length),
+          index_delta_len_(index_delta_length), frame_samples_(frame_samples) {}
+
+    template <typename Emit>
+    void push(const RtpPacket& pkt, Emit&& emit) {
+        if (have_seq_ && pkt.seq != static_cast<uint16_t>(last_seq_ + 1)) frag_.clear();
+        have_seq_ = true;
+        last_seq_ = pkt.seq;
+        if (pkt.size < 2 || size_len_ <= 0) return;
+
+        const size_t header_bits = static_cast<size_t>(pkt.payload[0]) << 8 | pkt.payload[1];
+        const size_t header_bytes = (header_bits + 7) / 8;
+        if (2 + header_bytes > pkt.size) return;
+        const uint8_t* data = pkt.payload + 2 + header_bytes;
+        size_t avail = pkt.size - 2 - header_bytes;
+
+        BitReader br{pkt.payload + 2, header_bits};
+        std::vector<size_t>& sizes = sizes_;
+        sizes.clear();
+        for (int i = 0; br.left() >= static_cast<size_t>(size_len_); ++i) {
+            sizes.push_back(br.read(size_len_));
+            br.read(i == 0 ? index_len_ : index_delta_len_);
+        }
+
+        // One AU larger than this packet: a fragment of a reassembled AU.
+        if (sizes.size() == 1 && sizes[0] > avail) {
+            if (frag_.empty()) frag_size_ = sizes[0];
+            frag_.insert(frag_.end(), data, data + avail);
+            if (frag_.size() >= frag_size_ || pkt.marker) {
+                if (frag_.size() == frag_size_) emit(frag_.data(), frag_.size(), pkt.timestamp, true);
+                frag_.clear();
+            }
+            return;
+        }
+        frag_.clear();
+        uint32_t ts = pkt.timestamp;
+        for (size_t s : sizes) {
+            if (s > avail) return;
+            emit(data, s, ts, true);
+            data += s;
+            avail -= s;
+            ts += static_cast<uint32_t>(frame_samples_);
+        }
+    }
+
+private:
+    struct BitReader {
+        const uint8_t* p;
+        size_t bits;
+        size_t pos = 0;
+        size_t left() const { return bits - pos; }
+        size_t read(int n) {
+            size_t v = 0;
+            for (int i = 0; i < n && pos < bits; ++i, ++pos)
+                v = (v << 1) | ((p[pos / 8] >> (7 - pos % 8)) & 1u);
+            return v;
+        }
+    };
+
+    int size_len_, index_len_, index_delta_len_, frame_samples_;
+    std::vector<size_t> sizes_;
+    std::vector<uint8_t> frag_;
+    size_t frag_size_ = 0;
+    uint16_t last_seq_ = 0;
+    bool have_seq_ = false;
+};
+
+}  // namespace zm::rtp
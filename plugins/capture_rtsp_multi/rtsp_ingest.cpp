@@ -0,0 +1,650 @@
+#include "rtsp_ingest.hpp"
+#include "rtp_depacketizer.hpp"
+#include "zm_plugin.h"  // zm_log_level_t
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <random>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace zm::rtsp {
+
+namespace {
+
+int64_t mono_us() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+bool set_nonblock(int fd) {
+    const int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+void close_fd(int& fd) {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+enum FdKind { kTcp, kRtp, kRtcp };
+
+// epoll_event.data.ptr target. Lives inside its Session, so the pointer stays
+// valid for the Session's lifetime; `fd` is -1 once the socket is closed, so
+// events already queued for it in the current epoll_wait batch are ignored.
+struct FdRef {
+    RtspIngest::Session* session = nullptr;
+    FdKind kind = kTcp;
+    size_t track = 0;
+    int fd = -1;
+};
+
+constexpr size_t kMaxTracks = 2;          // video + optional audio
+constexpr size_t kMaxBufferedInput = 4 << 20;  // unparseable backlog = protocol error
+constexpr size_t kUdpDatagram = 65536;
+
+}  // namespace
+
+struct RtspIngest::Session {
+    enum class State { Idle, Connecting, Describe, Setup, Play, Playing, Stopped };
+
+    struct Track {
+        SdpTrack sdp;
+        bool audio = false;
+        std::unique_ptr<rtp::H26xDepacketizer> video_depay;
+        std::unique_ptr<rtp::AacDepacketizer> audio_depay;
+        rtp::TimestampUnwrapper unwrap;
+        bool have_base = false;
+        int64_t base_ts = 0;
+        FdRef rtp, rtcp;  // UDP transport only
+    };
+
+    IngestStream cfg;
+    Url url;
+    Auth auth;
+    State state = State::Idle;
+
+    FdRef tcp;
+    uint32_t tcp_events = 0;
+    std::string in, out;
+    size_t in_off = 0;
+
+    int cseq = 0;
+    std::string session_id;
+    int timeout_s = 60;
+    std::string last_method, last_url, last_extra;
+    bool auth_retried = false;
+
+    std::array<Track, kMaxTracks> tracks;
+    size_t ntracks = 0;
+    size_t setup_index = 0;
+
+    int64_t deadline_us = 0;        // handshake deadline, then RTP read deadline
+    int64_t next_keepalive_us = 0;
+    int64_t reconnect_at_us = 0;
+    int retry_count = 0;
+    int retry_delay_ms = MIN_RECONNECT_DELAY_MS;
+    bool notified_connected = false;
+};
+
+RtspIngest::RtspIngest(IngestCallbacks callbacks) : cb_(std::move(callbacks)) {}
+
+RtspIngest::~RtspIngest() { stop(); }
+
+bool RtspIngest::add(const IngestStream& stream) {
+    if (running_) return false;
+    auto s = std::make_unique<Session>();
+    s->cfg = stream;
+    if (!parse_url(stream.url, s->url)) {
+        if (cb_.log) cb_.log(stream.stream_id, ZM_LOG_ERROR, "Invalid RTSP URL: " + stream.url);
+        return false;
+    }
+    s->auth.user = s->url.user;
+    s->auth.password = s->url.password;
+    s->tcp.session = s.get();
+    s->tcp.kind = kTcp;
+    for (size_t i = 0; i < kMaxTracks; ++i) {
+        s->tracks[i].rtp = FdRef{s.get(), kRtp, i, -1};
+        s->tracks[i].rtcp = FdRef{s.get(), kRtcp, i, -1};
+    }
+    sessions_.push_back(std::move(s));
+    return true;
+}
+
+bool RtspIngest::start() {
+    if (running_) return true;
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        close_fd(epoll_fd_);
+        close_fd(wake_fd_);
+        return false;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;  // the wake fd
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+    udp_buf_.resize(kUdpDatagram);
+
+    const int64_t now = mono_us();
+    for (auto& s : sessions_) {
+        s->state = Session::State::Idle;
+        s->reconnect_at_us = now;
+    }
+    running_ = true;
+    thread_ = std::thread(&RtspIngest::run, this);
+    return true;
+}
+
+void RtspIngest::stop() {
+    if (!thread_.joinable()) return;
+    running_ = false;
+    const uint64_t one = 1;
+    (void)!::write(wake_fd_, &one, sizeof(one));
+    thread_.join();
+    close_fd(epoll_fd_);
+    close_fd(wake_fd_);
+}
+
+void RtspIngest::run() {
+    std::vector<epoll_event> events(64);
+    int64_t next_timer = service_timers(mono_us());
+    while (running_) {
+        const int64_t wait_us = std::max<int64_t>(0, next_timer - mono_us());
+        const int timeout_ms = static_cast<int>(std::min<int64_t>((wait_us + 999) / 1000, 1000));
+        const int n = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), timeout_ms);
+        if (n < 0 && errno != EINTR) break;
+        for (int i = 0; i < n && running_; ++i) {
+            auto* ref = static_cast<FdRef*>(events[i].data.ptr);
+            if (!ref) {
+                uint64_t v;
+                (void)!::read(wake_fd_, &v, sizeof(v));
+                continue;
+            }
+            if (ref->fd < 0) continue;  // closed earlier in this batch
+            Session& s = *ref->session;
+            if (ref->kind != kTcp) {
+                on_udp_readable(s, ref->track, ref->kind == kRtcp);
+                continue;
+            }
+            const uint32_t e = events[i].events;
+            if (s.state == Session::State::Connecting) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(s.tcp.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                if (err != 0 || (e & (EPOLLERR | EPOLLHUP))) {
+                    fail(s, std::string("connect failed: ") + std::strerror(err ? err : ECONNREFUSED));
+                    continue;
+                }
+                if (!(e & EPOLLOUT)) continue;
+                s.state = Session::State::Describe;
+                send_request(s, "DESCRIBE", s.url.request, "Accept: application/sdp\r\n");
+                continue;
+            }
+            if (e & (EPOLLIN | EPOLLERR | EPOLLHUP)) on_tcp_readable(s);
+            if (s.tcp.fd >= 0 && (e & EPOLLOUT)) flush_output(s);
+        }
+        next_timer = service_timers(mono_us());
+    }
+    for (auto& s : sessions_) close_session(*s, true);
+}
+
+void RtspIngest::connect(Session& s) {
+    close_session(s, false);
+    const std::string port = std::to_string(s.url.port);
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+    addrinfo* res = nullptr;
+    // Literal addresses resolve without I/O; only names fall back to a
+    // (blocking) resolver lookup on the reactor thread.
+    if (getaddrinfo(s.url.host.c_str(), port.c_str(), &hints, &res) != 0) {
+        hints.ai_flags = AI_NUMERICSERV;
+        if (getaddrinfo(s.url.host.c_str(), port.c_str(), &hints, &res) != 0 || !res) {
+            fail(s, "cannot resolve " + s.url.host);
+            return;
+        }
+    }
+    const int fd = socket(res->ai_family, res->ai_socktype | SOCK_CLOEXEC, res->ai_protocol);
+    if (fd < 0 || !set_nonblock(fd)) {
+        if (fd >= 0) ::close(fd);
+        freeaddrinfo(res);
+        fail(s, "socket failed");
+        return;
+    }
+    const int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    const int rc = ::connect(fd, res->ai_addr, res->ai_addrlen);
+    const int err = errno;
+    freeaddrinfo(res);
+    if (rc != 0 && err != EINPROGRESS) {
+        ::close(fd);
+        fail(s, std::string("connect failed: ") + std::strerror(err));
+        return;
+    }
+    s.tcp.fd = fd;
+    s.tcp_events = 0;
+    s.state = Session::State::Connecting;
+    s.deadline_us = mono_us() + CONNECT_TIMEOUT_US;
+    // Readiness for writing reports completion of the non-blocking connect.
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.ptr = &s.tcp;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+    s.tcp_events = ev.events;
+}
+
+void RtspIngest::fail(Session& s, const std::string& reason) {
+    const bool was_playing = s.notified_connected;
+    close_session(s, false);
+    if (was_playing && cb_.on_disconnected) cb_.on_disconnected(s.cfg.stream_id, reason);
+
+    s.retry_count++;
+    if (s.cfg.max_retry_attempts > 0 && s.retry_count >= s.cfg.max_retry_attempts) {
+        log(s, ZM_LOG_ERROR, reason + "; max retry attempts reached, stopping stream");
+        s.state = Session::State::Stopped;
+        return;
+    }
+    // Same backoff as the threaded path: doubling delay, +-200 ms jitter.
+    static thread_local std::minstd_rand gen{std::random_device{}()};
+    std::uniform_int_distribution<int> jitter(-200, 200);
+    const int delay_ms = std::max(std::min(s.retry_delay_ms, MAX_RECONNECT_DELAY_MS) + jitter(gen),
+                                  MIN_RECONNECT_DELAY_MS);
+    s.retry_delay_ms = std::min(s.retry_delay_ms * 2, MAX_RECONNECT_DELAY_MS);
+    log(s, ZM_LOG_WARN, reason + "; retrying in " + std::to_string(delay_ms) + " ms (attempt " +
+                            std::to_string(s.retry_count) + ")");
+    s.state = Session::State::Idle;
+    s.reconnect_at_us = mono_us() + static_cast<int64_t>(delay_ms) * 1000;
+}
+
+void RtspIngest::send_request(Session& s, const std::string& method, const std::string& url,
+                              const std::string& extra) {
+    s.last_method = method;
+    s.last_url = url;
+    s.last_extra = extra;
+    std::string req = method + " " + url + " RTSP/1.0\r\nCSeq: " + std::to_string(++s.cseq) +
+                      "\r\nUser-Agent: zm-next\r\n";
+    if (!s.session_id.empty()) req += "Session: " + s.session_id + "\r\n";
+    const std::string authz = s.auth.authorization(method, url);
+    if (!authz.empty()) req += "Authorization: " + authz + "\r\n";
+    req += extra;
+    req += "\r\n";
+    s.out += req;
+    flush_output(s);
+}
+
+void RtspIngest::flush_output(Session& s) {
+    while (!s.out.empty() && s.tcp.fd >= 0) {
+        const ssize_t n = ::send(s.tcp.fd, s.out.data(), s.out.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            s.out.erase(0, static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        fail(s, std::string("send failed: ") + std::strerror(errno));
+        return;
+    }
+    update_events(s);
+}
+
+void RtspIngest::update_events(Session& s) {
+    if (s.tcp.fd < 0 || s.state == Session::State::Connecting) return;
+    const uint32_t want = EPOLLIN | (s.out.empty() ? 0u : static_cast<uint32_t>(EPOLLOUT));
+    if (want == s.tcp_events) return;
+    epoll_event ev{};
+    ev.events = want;
+    ev.data.ptr = &s.tcp;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, s.tcp.fd, &ev);
+    s.tcp_events = want;
+}
+
+void RtspIngest::on_tcp_readable(Session& s) {
+    const int64_t now = mono_us();
+    for (;;) {
+        const size_t old = s.in.size();
+        s.in.resize(old + 65536);
+        const ssize_t n = ::recv(s.tcp.fd, &s.in[old], 65536, 0);
+        s.in.resize(old + static_cast<size_t>(std::max<ssize_t>(n, 0)));
+        if (n > 0) continue;
+        if (n == 0) {
+            fail(s, "connection closed by server");
+            return;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        fail(s, std::string("recv failed: ") + std::strerror(errno));
+        return;
+    }
+
+    // The control connection carries RTSP responses, interleaved RTP/RTCP
+    // ('$' channel len16 data) and the odd server request, in any order.
+    while (s.tcp.fd >= 0 && s.in_off < s.in.size()) {
+        const char* p = s.in.data() + s.in_off;
+        const size_t avail = s.in.size() - s.in_off;
+        if (p[0] == '$') {
+            if (avail < 4) break;
+            const uint8_t channel = static_cast<uint8_t>(p[1]);
+            const size_t len = static_cast<size_t>(static_cast<uint8_t>(p[2])) << 8 |
+                               static_cast<uint8_t>(p[3]);
+            if (avail < 4 + len) break;
+            const size_t track = channel / 2;
+            if (channel % 2 == 0 && track < s.ntracks)
+                on_rtp(s, track, reinterpret_cast<const uint8_t*>(p + 4), len, now);
+            s.in_off += 4 + len;
+        } else if (avail >= 5 && std::memcmp(p, "RTSP/", 5) == 0) {
+            Response r;
+            const long used = parse_response(p, avail, r);
+            if (used == 0) break;
+            if (used < 0) {
+                fail(s, "malformed RTSP response");
+                return;
+            }
+            s.in_off += static_cast<size_t>(used);
+            on_response(s, r);
+        } else if (avail < 5) {
+            break;
+        } else {
+            const bool request = std::isupper(static_cast<unsigned char>(p[0])) != 0;
+            const size_t used = request ? request_length(p, avail) : 0;
+            if (request && used == 0) break;  // incomplete server request
+            s.in_off += request ? used : 1;   // else resync byte by byte
+        }
+    }
+    if (s.tcp.fd < 0) return;
+    if (s.in.size() - s.in_off > kMaxBufferedInput) {
+        fail(s, "RTSP input backlog exceeded");
+        return;
+    }
+    if (s.in_off == s.in.size()) {
+        s.in.clear();
+        s.in_off = 0;
+    } else if (s.in_off > 65536) {
+        s.in.erase(0, s.in_off);
+        s.in_off = 0;
+    }
+}
+
+void RtspIngest::on_udp_readable(Session& s, size_t track, bool rtcp) {
+    Session::Track& t = s.tracks[track];
+    const int fd = rtcp ? t.rtcp.fd : t.rtp.fd;
+    const int64_t now = mono_us();
+    for (;;) {
+        const ssize_t n = ::recv(fd, udp_buf_.data(), udp_buf_.size(), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;  // EAGAIN, or an ICMP error surfaced on the socket
+        }
+        // Sender reports are not needed: pts come from each track's RTP clock.
+        if (!rtcp) on_rtp(s, track, udp_buf_.data(), static_cast<size_t>(n), now);
+        if (t.rtp.fd < 0) return;  // session failed from inside a callback
+    }
+}
+
+void RtspIngest::on_response(Session& s, const Response& r) {
+    using State = Session::State;
+    if (s.state == State::Playing) return;  // keepalive replies
+
+    if (r.status == 401 && !s.auth_retried && !s.auth.user.empty() &&
+        s.auth.challenge(r.header("www-authenticate"))) {
+        s.auth_retried = true;
+        send_request(s, s.last_method, s.last_url, s.last_extra);
+        return;
+    }
+    if (r.status != 200) {
+        fail(s, s.last_method + " failed with status " + std::to_string(r.status));
+        return;
+    }
+    s.auth_retried = false;
+
+    if (s.state == State::Describe) {
+        std::string base = r.header("content-base");
+        if (base.empty()) base = r.header("content-location");
+        if (base.empty()) base = s.url.request;
+        const auto tracks = parse_sdp(r.body, base);
+        const SdpTrack* video = nullptr;
+        const SdpTrack* audio = nullptr;
+        for (const auto& t : tracks) {
+            if (!video && t.media == "video" && (t.codec == Codec::H264 || t.codec == Codec::H265))
+                video = &t;
+            if (!audio && s.cfg.forward_audio && t.media == "audio" && t.codec == Codec::AAC)
+                audio = &t;
+        }
+        if (!video) {
+            fail(s, "no H.264/H.265 video track in SDP");
+            return;
+        }
+        s.ntracks = 0;
+        for (const SdpTrack* src : {video, audio}) {
+            if (!src) continue;
+            Session::Track& t = s.tracks[s.ntracks++];
+            t.sdp = *src;
+            t.audio = src->media == "audio";
+            t.unwrap.reset();
+            t.have_base = false;
+            if (t.audio) {
+                auto num = [&](const char* key, int def) {
+                    const std::string v = src->param(key);
+                    return v.empty() ? def : std::atoi(v.c_str());
+                };
+                t.audio_depay = std::make_unique<rtp::AacDepacketizer>(
+                    num("sizelength", 13), num("indexlength", 3), num("indexdeltalength", 3));
+            } else {
+                t.video_depay = std::make_unique<rtp::H26xDepacketizer>(src->codec == Codec::H265);
+                t.video_depay->set_parameter_sets(parameter_sets_annexb(*src));
+            }
+        }
+        s.state = State::Setup;
+        s.setup_index = 0;
+        setup_next(s);
+    } else if (s.state == State::Setup) {
+        if (s.session_id.empty()) s.session_id = session_id(r.header("session"), &s.timeout_s);
+        s.setup_index++;
+        setup_next(s);
+    } else if (s.state == State::Play) {
+        const int64_t now = mono_us();
+        s.state = State::Playing;
+        s.deadline_us = now + READ_TIMEOUT_US;
+        s.next_keepalive_us = now + static_cast<int64_t>(s.timeout_s) * 500000;
+        s.retry_count = 0;
+        s.retry_delay_ms = MIN_RECONNECT_DELAY_MS;
+        s.notified_connected = true;
+        log(s, ZM_LOG_INFO, "Playing " + s.url.request + " (" + s.cfg.transport + ")");
+        if (cb_.on_connected)
+            cb_.on_connected(s.cfg.stream_id, s.tracks[0].sdp,
+                             s.ntracks > 1 ? &s.tracks[1].sdp : nullptr);
+    }
+}
+
+void RtspIngest::setup_next(Session& s) {
+    if (s.setup_index >= s.ntracks) {
+        s.state = Session::State::Play;
+        send_request(s, "PLAY", s.url.request, "Range: npt=0.000-\r\n");
+        return;
+    }
+    const size_t i = s.setup_index;
+    std::string transport;
+    if (s.cfg.transport == "udp") {
+        if (!open_udp_pair(s, i)) {
+            fail(s, "cannot open UDP ports");
+            return;
+        }
+        sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+        getsockname(s.tracks[i].rtp.fd, reinterpret_cast<sockaddr*>(&addr), &len);
+        const int port = ntohs(addr.sin_port);
+        transport = "RTP/AVP;unicast;client_port=" + std::to_string(port) + "-" +
+                    std::to_string(port + 1);
+    } else {
+        transport = "RTP/AVP/TCP;unicast;interleaved=" + std::to_string(2 * i) + "-" +
+                    std::to_string(2 * i + 1);
+    }
+    send_request(s, "SETUP", s.tracks[i].sdp.control, "Transport: " + transport + "\r\n");
+}
+
+bool RtspIngest::open_udp_pair(Session& s, size_t track) {
+    Session::Track& t = s.tracks[track];
+    // RTP wants an even port with RTCP on the next one; retry until the
+    // kernel hands out a pair where both are free.
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        int rtp = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (rtp < 0) return false;
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        socklen_t len = sizeof(addr);
+        if (bind(rtp, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            getsockname(rtp, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            ::close(rtp);
+            return false;
+        }
+        int port = ntohs(addr.sin_port);
+        if (port % 2 != 0) {
+            ::close(rtp);
+            rtp = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+            if (rtp < 0) return false;
+            addr.sin_port = htons(static_cast<uint16_t>(port + 1 <= 65534 ? port + 1 : 0));
+            if (addr.sin_port == 0 ||
+                bind(rtp, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+                ::close(rtp);
+                continue;
+            }
+            port = port + 1;
+        }
+        int rtcp = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (rtcp < 0) {
+            ::close(rtp);
+            return false;
+        }
+        addr.sin_port = htons(static_cast<uint16_t>(port + 1));
+        if (bind(rtcp, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            ::close(rtp);
+            ::close(rtcp);
+            continue;
+        }
+        const int rcvbuf = 1 << 20;  // absorb keyframe bursts between reactor turns
+        setsockopt(rtp, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        t.rtp.fd = rtp;
+        t.rtcp.fd = rtcp;
+        for (FdRef* ref : {&t.rtp, &t.rtcp}) {
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.ptr = ref;
+            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, ref->fd, &ev);
+        }
+        return true;
+    }
+    return false;
+}
+
+void RtspIngest::on_rtp(Session& s, size_t track, const uint8_t* data, size_t size, int64_t now_us) {
+    rtp::RtpPacket pkt;
+    if (!rtp::parse_rtp(data, size, pkt)) return;
+    Session::Track& t = s.tracks[track];
+    if (static_cast<int>(pkt.payload_type) != t.sdp.payload_type) return;
+    if (s.state == Session::State::Playing) s.deadline_us = now_us + READ_TIMEOUT_US;
+
+    auto emit = [&](const uint8_t* au, size_t n, uint32_t ts, bool key) {
+        if (!s.notified_connected) return;  // RTP ahead of the PLAY reply
+        const int64_t ext = t.unwrap.unwrap(ts);
+        if (!t.have_base) {
+            t.have_base = true;
+            t.base_ts = ext;
+        }
+        IngestFrame f;
+        f.audio = t.audio;
+        f.data = au;
+        f.size = n;
+        f.pts_usec = t.sdp.clock_rate > 0 ? (ext - t.base_ts) * 1000000 / t.sdp.clock_rate : 0;
+        f.arrival_usec = now_us;
+        f.keyframe = key;
+        if (cb_.on_frame) cb_.on_frame(s.cfg.stream_id, f);
+    };
+    if (t.video_depay) t.video_depay->push(pkt, emit);
+    else if (t.audio_depay) t.audio_depay->push(pkt, emit);
+}
+
+void RtspIngest::close_session(Session& s, bool teardown) {
+    if (teardown && s.tcp.fd >= 0 && s.state == Session::State::Playing) {
+        // Best effort: one non-blocking write, no wait for the reply.
+        std::string req = "TEARDOWN " + s.url.request + " RTSP/1.0\r\nCSeq: " +
+                          std::to_string(++s.cseq) + "\r\n";
+        if (!s.session_id.empty()) req += "Session: " + s.session_id + "\r\n";
+        const std::string authz = s.auth.authorization("TEARDOWN", s.url.request);
+        if (!authz.empty()) req += "Authorization: " + authz + "\r\n";
+        req += "\r\n";
+        (void)!::send(s.tcp.fd, req.data(), req.size(), MSG_NOSIGNAL);
+    }
+    auto drop = [this](FdRef& ref) {
+        if (ref.fd < 0) return;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, ref.fd, nullptr);
+        close_fd(ref.fd);
+    };
+    drop(s.tcp);
+    for (auto& t : s.tracks) {
+        drop(t.rtp);
+        drop(t.rtcp);
+        t.video_depay.reset();
+        t.audio_depay.reset();
+    }
+    s.ntracks = 0;
+    s.tcp_events = 0;
+    s.in.clear();
+    s.in_off = 0;
+    s.out.clear();
+    s.session_id.clear();
+    s.auth_retried = false;
+    s.notified_connected = false;
+    if (s.state != Session::State::Stopped) s.state = Session::State::Idle;
+}
+
+int64_t RtspIngest::service_timers(int64_t now_us) {
+    using State = Session::State;
+    int64_t next = now_us + 1000000;
+    for (auto& sp : sessions_) {
+        Session& s = *sp;
+        switch (s.state) {
+        case State::Stopped:
+            continue;
+        case State::Idle:
+            if (now_us >= s.reconnect_at_us) connect(s);
+            break;
+        case State::Playing:
+            if (now_us >= s.deadline_us) {
+                fail(s, "no RTP for " + std::to_string(READ_TIMEOUT_US / 1000) + " ms");
+            } else if (now_us >= s.next_keepalive_us) {
+                // OPTIONS keeps the session alive on servers that ignore RTCP RR.
+                send_request(s, "OPTIONS", s.url.request);
+                s.next_keepalive_us = now_us + static_cast<int64_t>(s.timeout_s) * 500000;
+            }
+            break;
+        default:  // connecting / handshake in flight
+            if (now_us >= s.deadline_us) fail(s, "RTSP handshake timed out");
+            break;
+        }
+        if (s.state == State::Idle) next = std::min(next, s.reconnect_at_us);
+        else if (s.state == State::Playing) next = std::min({next, s.deadline_us, s.next_keepalive_us});
+        else if (s.state != State::Stopped) next = std::min(next, s.deadline_us);
+    }
+    return next;
+}
+
+void RtspIngest::log(const Session& s, int level, const std::string& msg) {
+    if (cb_.log) cb_.log(s.cfg.stream_id, level, msg);
+}
+
+}  // namespace zm::rtsp
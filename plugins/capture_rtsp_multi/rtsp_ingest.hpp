@@ -0,0 +1,103 @@
+#pragma once
+
+// Single-threaded RTSP/RTP ingest for many streams (Linux, epoll).
+//
+// capture_rtsp_multi's default path gives every stream a thread parked in a
+// blocking libavformat demuxer. RtspIngest instead runs every session on one
+// epoll reactor: non-blocking RTSP (DESCRIBE/SETUP/PLAY, Basic/Digest auth,
+// keepalive), RTP over TCP-interleaved or UDP, and its own H.264/H.265/AAC
+// depacketizing (rtp_depacketizer.hpp). Frames come out through callbacks on
+// the reactor thread; StreamManager turns them into the same on_frame packets
+// and StreamMetadata events the libavformat path produces.
+//
+// Session failures (refused, timed out, torn down) reconnect with the same
+// exponential backoff as the threaded path.
+
+#include "rtsp_protocol.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace zm::rtsp {
+
+struct IngestStream {
+    uint32_t stream_id = 0;
+    std::string url;
+    std::string transport = "tcp";  // "tcp" (interleaved) or "udp"
+    bool forward_audio = true;
+    int max_retry_attempts = 5;     // -1 / 0 = retry forever
+};
+
+struct IngestFrame {
+    bool audio = false;
+    const uint8_t* data = nullptr;  // Annex B access unit / raw AAC frame
+    size_t size = 0;
+    int64_t pts_usec = 0;           // from the track's RTP clock, 0 at PLAY
+    int64_t arrival_usec = 0;       // monotonic receive time
+    bool keyframe = false;
+};
+
+struct IngestCallbacks {
+    // Session is playing; `audio` is null without a forwarded audio track.
+    std::function<void(uint32_t stream_id, const SdpTrack& video, const SdpTrack* audio)>
+        on_connected;
+    std::function<void(uint32_t stream_id, const IngestFrame& frame)> on_frame;
+    std::function<void(uint32_t stream_id, const std::string& reason)> on_disconnected;
+    std::function<void(uint32_t stream_id, int level, const std::string& msg)> log;  // zm_log_level_t
+};
+
+class RtspIngest {
+public:
+    explicit RtspIngest(IngestCallbacks callbacks);
+    ~RtspIngest();
+
+    RtspIngest(const RtspIngest&) = delete;
+    RtspIngest& operator=(const RtspIngest&) = delete;
+
+    // Register a stream; only before start().
+    bool add(const IngestStream& stream);
+    // Spawn the reactor thread; sessions connect immediately.
+    bool start();
+    // Tear down every session (best-effort TEARDOWN) and join the thread.
+    void stop();
+
+    static constexpr int MIN_RECONNECT_DELAY_MS = 1000;
+    static constexpr int MAX_RECONNECT_DELAY_MS = 30000;
+    static constexpr int64_t CONNECT_TIMEOUT_US = 15000000;  // connect through PLAY
+    static constexpr int64_t READ_TIMEOUT_US = 10000000;     // no RTP while playing
+
+    struct Session;  // rtsp_ingest.cpp
+
+private:
+    void run();
+    void connect(Session& s);
+    void fail(Session& s, const std::string& reason);
+    void send_request(Session& s, const std::string& method, const std::string& url,
+                      const std::string& extra = std::string());
+    void flush_output(Session& s);
+    void on_tcp_readable(Session& s);
+    void on_udp_readable(Session& s, size_t track, bool rtcp);
+    void on_response(Session& s, const Response& r);
+    void on_rtp(Session& s, size_t track, const uint8_t* data, size_t size, int64_t now_us);
+    void setup_next(Session& s);
+    bool open_udp_pair(Session& s, size_t track);
+    void close_session(Session& s, bool teardown);
+    void update_events(Session& s);
+    int64_t service_timers(int64_t now_us);
+    void log(const Session& s, int level, const std::string& msg);
+
+    IngestCallbacks cb_;
+    std::vector<std::unique_ptr<Session>> sessions_;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;                 // eventfd: stop() wakes the reactor
+    std::vector<uint8_t> udp_buf_;     // one datagram at a time
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
+
+}  // namespace zm::rtsp
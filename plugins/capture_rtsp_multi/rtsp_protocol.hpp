@@ -0,0 +1,421 @@
+#pragma once
+
+// RTSP/SDP text handling for the epoll ingest (rtsp_ingest.cpp): URL parsing,
+// response framing, SDP track extraction, and Basic/Digest authorization.
+// Header-only and FFmpeg-free so it is unit-testable.
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace zm::rtsp {
+
+inline std::string to_lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+inline std::string trim(const std::string& s) {
+    size_t b = 0, e = s.size();
+    while (b < e && std::isspace(static_cast<unsigned char>(s[b]))) ++b;
+    while (e > b && std::isspace(static_cast<unsigned char>(s[e - 1]))) --e;
+    return s.substr(b, e - b);
+}
+
+// rtsp://[user[:pass]@]host[:port]/path  ->  parts; `request` is the URL
+// without credentials (what goes on the request line).
+struct Url {
+    std::string user, password, host, request;
+    int port = 554;
+};
+
+inline bool parse_url(const std::string& url, Url& out) {
+    static const char kScheme[] = "rtsp://";
+    if (url.compare(0, sizeof(kScheme) - 1, kScheme) != 0) return false;
+    const size_t auth_begin = sizeof(kScheme) - 1;
+    size_t host_begin = auth_begin;
+    const size_t path_begin = std::min(url.find('/', auth_begin), url.size());
+    const size_t at = url.rfind('@', path_begin);
+    if (at != std::string::npos && at >= auth_begin) {
+        const std::string cred = url.substr(auth_begin, at - auth_begin);
+        const size_t colon = cred.find(':');
+        out.user = cred.substr(0, colon);
+        out.password = colon == std::string::npos ? "" : cred.substr(colon + 1);
+        host_begin = at + 1;
+    }
+    std::string hostport = url.substr(host_begin, path_begin - host_begin);
+    if (!hostport.empty() && hostport[0] == '[') {  // [v6]:port
+        const size_t close = hostport.find(']');
+        if (close == std::string::npos) return false;
+        out.host = hostport.substr(1, close - 1);
+        if (close + 1 < hostport.size() && hostport[close + 1] == ':')
+            out.port = std::atoi(hostport.c_str() + close + 2);
+    } else {
+        const size_t colon = hostport.find(':');
+        out.host = hostport.substr(0, colon);
+        if (colon != std::string::npos) out.port = std::atoi(hostport.c_str() + colon + 1);
+    }
+    if (out.host.empty() || out.port <= 0 || out.port > 65535) return false;
+    out.request = std::string(kScheme) + hostport + url.substr(path_begin);
+    return true;
+}
+
+struct Response {
+    int status = 0;
+    std::map<std::string, std::string> headers;  // lower-case names
+    std::string body;
+
+    std::string header(const std::string& name) const {
+        auto it = headers.find(name);
+        return it == headers.end() ? std::string() : it->second;
+    }
+};
+
+// Parse one RTSP response from the front of `buf` (n bytes). Returns the bytes
+// consumed, 0 if more data is needed, or -1 if the data is not a response
+// (caller resyncs).
+inline long parse_response(const char* buf, size_t n, Response& out) {
+    static const char kEnd[] = "\r\n\r\n";
+    const char* end = std::search(buf, buf + n, kEnd, kEnd + 4);
+    if (end == buf + n) return n > 65536 ? -1 : 0;
+    if (n < 5 || std::memcmp(buf, "RTSP/", 5) != 0) return -1;
+    const std::string head(buf, end);
+    out = Response();
+    size_t line_end = head.find("\r\n");
+    const std::string status_line = head.substr(0, line_end);
+    const size_t sp = status_line.find(' ');
+    if (sp == std::string::npos) return -1;
+    out.status = std::atoi(status_line.c_str() + sp + 1);
+    while (line_end != std::string::npos && line_end < head.size()) {
+        const size_t next = head.find("\r\n", line_end + 2);
+        const std::string line = head.substr(line_end + 2, next == std::string::npos
+                                                                ? std::string::npos
+                                                                : next - line_end - 2);
+        const size_t colon = line.find(':');
+        if (colon != std::string::npos)
+            out.headers[to_lower(trim(line.substr(0, colon)))] = trim(line.substr(colon + 1));
+        line_end = next;
+    }
+    const size_t head_len = static_cast<size_t>(end - buf) + 4;
+    const long body_len = std::atol(out.header("content-length").c_str());
+    if (body_len < 0) return -1;
+    if (head_len + static_cast<size_t>(body_len) > n) return 0;
+    out.body.assign(buf + head_len, static_cast<size_t>(body_len));
+    return static_cast<long>(head_len + static_cast<size_t>(body_len));
+}
+
+// Length of an RTSP request (server -> client, e.g. a GET_PARAMETER) at the
+// front of `buf`, so the reader can skip it; 0 if incomplete.
+inline size_t request_length(const char* buf, size_t n) {
+    static const char kEnd[] = "\r\n\r\n";
+    const char* end = std::search(buf, buf + n, kEnd, kEnd + 4);
+    if (end == buf + n) return 0;
+    const std::string head(buf, end);
+    size_t body = 0;
+    const std::string lower = to_lower(head);
+    const size_t cl = lower.find("\r\ncontent-length:");
+    if (cl != std::string::npos) body = static_cast<size_t>(std::atol(head.c_str() + cl + 17));
+    const size_t total = static_cast<size_t>(end - buf) + 4 + body;
+    return total <= n ? total : 0;
+}
+
+inline std::vector<uint8_t> base64_decode(const std::string& in) {
+    std::vector<uint8_t> out;
+    uint32_t acc = 0;
+    int bits = 0;
+    for (char c : in) {
+        int v;
+        if (c >= 'A' && c <= 'Z') v = c - 'A';
+        else if (c >= 'a' && c <= 'z') v = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') v = c - '0' + 52;
+        else if (c == '+' || c == '-') v = 62;
+        else if (c == '/' || c == '_') v = 63;
+        else continue;  // '=' padding, whitespace
+        acc = (acc << 6) | static_cast<uint32_t>(v);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<uint8_t>(acc >> bits));
+        }
+    }
+    return out;
+}
+
+inline std::string base64_encode(const std::string& in) {
+    static const char kTable[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    size_t i = 0;
+    for (; i + 2 < in.size(); i += 3) {
+        const uint32_t v = static_cast<uint8_t>(in[i]) << 16 | static_cast<uint8_t>(in[i + 1]) << 8 |
+                           static_cast<uint8_t>(in[i + 2]);
+        out += kTable[v >> 18];
+        out += kTable[(v >> 12) & 63];
+        out += kTable[(v >> 6) & 63];
+        out += kTable[v & 63];
+    }
+    if (i < in.size()) {
+        uint32_t v = static_cast<uint8_t>(in[i]) << 16;
+        if (i + 1 < in.size()) v |= static_cast<uint8_t>(in[i + 1]) << 8;
+        out += kTable[v >> 18];
+        out += kTable[(v >> 12) & 63];
+        out += i + 1 < in.size() ? kTable[(v >> 6) & 63] : '=';
+        out += '=';
+    }
+    return out;
+}
+
+enum class Codec { Unknown, H264, H265, AAC };
+
+struct SdpTrack {
+    std::string media;     // "video" / "audio"
+    int payload_type = -1;
+    Codec codec = Codec::Unknown;
+    int clock_rate = 90000;
+    int channels = 1;
+    std::string control;   // absolute URL for SETUP
+    std::map<std::string, std::string> fmtp;  // lower-case keys
+
+    std::string param(const std::string& key) const {
+        auto it = fmtp.find(key);
+        return it == fmtp.end() ? std::string() : it->second;
+    }
+};
+
+// Resolve an SDP a=control value against the presentation base URL.
+inline std::string resolve_control(const std::string& base, const std::string& control) {
+    if (control.empty() || control == "*") return base;
+    if (control.compare(0, 7, "rtsp://") == 0) return control;
+    if (!base.empty() && base.back() == '/') return base + control;
+    return base + "/" + control;
+}
+
+// Media sections of an SDP with their codec, clock, control URL and fmtp.
+inline std::vector<SdpTrack> parse_sdp(const std::string& sdp, const std::string& base_url) {
+    std::vector<SdpTrack> tracks;
+    std::string session_control;
+    size_t pos = 0;
+    while (pos < sdp.size()) {
+        size_t eol = sdp.find('\n', pos);
+        if (eol == std::string::npos) eol = sdp.size();
+        std::string line = trim(sdp.substr(pos, eol - pos));
+        pos = eol + 1;
+        if (line.size() < 2 || line[1] != '=') continue;
+        const char kind = line[0];
+        const std::string value = line.substr(2);
+        if (kind == 'm') {
+            SdpTrack t;
+            char media[32] = {0};
+            int port = 0, pt = -1;
+            char proto[32] = {0};
+            if (std::sscanf(value.c_str(), "%31s %d %31s %d", media, &port, proto, &pt) >= 4) {
+                t.media = media;
+                t.payload_type = pt;
+            }
+            tracks.push_back(t);
+            continue;
+        }
+        if (kind != 'a') continue;
+        const size_t colon = value.find(':');
+        const std::string attr = to_lower(value.substr(0, colon));
+        const std::string arg = colon == std::string::npos ? "" : value.substr(colon + 1);
+        if (tracks.empty()) {
+            if (attr == "control") session_control = arg;
+            continue;
+        }
+        SdpTrack& t = tracks.back();
+        if (attr == "control") {
+            t.control = arg;
+        } else if (attr == "rtpmap") {
+            int pt = -1;
+            char enc[64] = {0};
+            int clock = 0, ch = 0;
+            const int got = std::sscanf(arg.c_str(), "%d %63[^/]/%d/%d", &pt, enc, &clock, &ch);
+            if (got >= 3 && pt == t.payload_type) {
+                const std::string e = to_lower(enc);
+                t.codec = e == "h264" ? Codec::H264
+                        : (e == "h265" || e == "hevc") ? Codec::H265
+                        : e == "mpeg4-generic" ? Codec::AAC : Codec::Unknown;
+                t.clock_rate = clock;
+                if (got >= 4 && ch > 0) t.channels = ch;
+            }
+        } else if (attr == "fmtp") {
+            const size_t sp = arg.find(' ');
+            if (sp == std::string::npos) continue;
+            std::string params = arg.substr(sp + 1);
+            size_t p = 0;
+            while (p < params.size()) {
+                size_t semi = params.find(';', p);
+                if (semi == std::string::npos) semi = params.size();
+                const std::string kv = trim(params.substr(p, semi - p));
+                const size_t eq = kv.find('=');
+                if (eq != std::string::npos)
+                    t.fmtp[to_lower(trim(kv.substr(0, eq)))] = trim(kv.substr(eq + 1));
+                p = semi + 1;
+            }
+        }
+    }
+    const std::string base = session_control.empty() || session_control == "*"
+                                 ? base_url
+                                 : resolve_control(base_url, session_control);
+    for (auto& t : tracks) t.control = resolve_control(base, t.control);
+    return tracks;
+}
+
+// Annex B parameter sets from sprop-parameter-sets (H.264) or
+// sprop-vps/sps/pps (H.265).
+inline std::vector<uint8_t> parameter_sets_annexb(const SdpTrack& t) {
+    std::vector<std::string> sets;
+    auto split = [&sets](const std::string& v) {
+        size_t p = 0;
+        while (p <= v.size()) {
+            size_t c = v.find(',', p);
+            if (c == std::string::npos) c = v.size();
+            if (c > p) sets.push_back(v.substr(p, c - p));
+            p = c + 1;
+        }
+    };
+    if (t.codec == Codec::H264) {
+        split(t.param("sprop-parameter-sets"));
+    } else if (t.codec == Codec::H265) {
+        split(t.param("sprop-vps"));
+        split(t.param("sprop-sps"));
+        split(t.param("sprop-pps"));
+    }
+    std::vector<uint8_t> out;
+    for (const auto& s : sets) {
+        const auto nal = base64_decode(s);
+        if (nal.empty()) continue;
+        static const uint8_t kStart[4] = {0, 0, 0, 1};
+        out.insert(out.end(), kStart, kStart + 4);
+        out.insert(out.end(), nal.begin(), nal.end());
+    }
+    return out;
+}
+
+// AudioSpecificConfig bytes from the mpeg4-generic fmtp "config" (hex).
+inline std::vector<uint8_t> aac_config(const SdpTrack& t) {
+    std::vector<uint8_t> out;
+    const std::string hex = t.param("config");
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        unsigned v = 0;
+        if (std::sscanf(hex.c_str() + i, "%2x", &v) != 1) return {};
+        out.push_back(static_cast<uint8_t>(v));
+    }
+    return out;
+}
+
+// Minimal MD5 (RFC 1321) for Digest authorization.
+inline std::string md5_hex(const std::string& msg) {
+    static const uint32_t K[64] = {
+        0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613,
+        0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193,
+        0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d,
+        0x02441453, 0xd8a1e681, 0xe7d3fbc8, 0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
+        0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122,
+        0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+        0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665, 0xf4292244,
+        0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+        0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb,
+        0xeb86d391};
+    static const int R[64] = {7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+                              5, 9,  14, 20, 5, 9,  14, 20, 5, 9,  14, 20, 5, 9,  14, 20,
+                              4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+                              6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21};
+    std::vector<uint8_t> m(msg.begin(), msg.end());
+    const uint64_t bit_len = static_cast<uint64_t>(m.size()) * 8;
+    m.push_back(0x80);
+    while (m.size() % 64 != 56) m.push_back(0);
+    for (int i = 0; i < 8; ++i) m.push_back(static_cast<uint8_t>(bit_len >> (8 * i)));
+    uint32_t h[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+    for (size_t off = 0; off < m.size(); off += 64) {
+        uint32_t w[16];
+        for (int i = 0; i < 16; ++i)
+            w[i] = static_cast<uint32_t>(m[off + i * 4]) |
+                   static_cast<uint32_t>(m[off + i * 4 + 1]) << 8 |
+                   static_cast<uint32_t>(m[off + i * 4 + 2]) << 16 |
+                   static_cast<uint32_t>(m[off + i * 4 + 3]) << 24;
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3];
+        for (int i = 0; i < 64; ++i) {
+            uint32_t f;
+            int g;
+            if (i < 16) { f = (b & c) | (~b & d); g = i; }
+            else if (i < 32) { f = (d & b) | (~d & c); g = (5 * i + 1) % 16; }
+            else if (i < 48) { f = b ^ c ^ d; g = (3 * i + 5) % 16; }
+            else { f = c ^ (b | ~d); g = (7 * i) % 16; }
+            const uint32_t tmp = d;
+            d = c;
+            c = b;
+            const uint32_t x = a + f + K[i] + w[g];
+            b = b + ((x << R[i]) | (x >> (32 - R[i])));
+            a = tmp;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+    }
+    char out[33];
+    for (int i = 0; i < 16; ++i)
+        std::snprintf(out + i * 2, 3, "%02x", (h[i / 4] >> (8 * (i % 4))) & 0xff);
+    return std::string(out, 32);
+}
+
+// Credentials plus the server's challenge; authorization() renders the header
+// value for a request (empty when no challenge has been seen).
+struct Auth {
+    std::string user, password;
+    bool digest = false, basic = false;
+    std::string realm, nonce;
+
+    // Take a WWW-Authenticate value; false if it offers nothing usable.
+    bool challenge(const std::string& www) {
+        const std::string lower = to_lower(www);
+        auto field = [&](const char* name) {
+            const std::string key = std::string(name) + "=\"";
+            const size_t p = lower.find(key);
+            if (p == std::string::npos) return std::string();
+            const size_t b = p + key.size(), e = www.find('"', b);
+            return e == std::string::npos ? std::string() : www.substr(b, e - b);
+        };
+        if (lower.compare(0, 6, "digest") == 0) {
+            digest = true;
+            realm = field("realm");
+            nonce = field("nonce");
+            return !nonce.empty();
+        }
+        if (lower.compare(0, 5, "basic") == 0) {
+            basic = true;
+            return true;
+        }
+        return false;
+    }
+
+    std::string authorization(const std::string& method, const std::string& uri) const {
+        if (digest) {
+            const std::string ha1 = md5_hex(user + ":" + realm + ":" + password);
+            const std::string ha2 = md5_hex(method + ":" + uri);
+            const std::string resp = md5_hex(ha1 + ":" + nonce + ":" + ha2);
+            return "Digest username=\"" + user + "\", realm=\"" + realm + "\", nonce=\"" +
+                   nonce + "\", uri=\"" + uri + "\", response=\"" + resp + "\"";
+        }
+        if (basic) return "Basic " + base64_encode(user + ":" + password);
+        return {};
+    }
+};
+
+// Session header "id;timeout=N" -> id, timeout seconds (60 when absent).
+inline std::string session_id(const std::string& header, int* timeout_s = nullptr) {
+    const size_t semi = header.find(';');
+    if (timeout_s) {
+        *timeout_s = 60;
+        const size_t t = to_lower(header).find("timeout=");
+        if (t != std::string::npos) *timeout_s = std::max(5, std::atoi(header.c_str() + t + 8));
+    }
+    return trim(header.substr(0, semi));
+}
+
+}  // namespace zm::rtsp
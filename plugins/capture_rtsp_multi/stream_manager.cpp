@@ -1,8 +1,9 @@
 #include "stream_manager.hpp"
+#include "codec_cache.hpp"
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
-#include <cinttypes>  // for PRId64
+#include <cinttypes>  // for PRId64 / PRIu64
 #include <algorithm>
 #include <sstream>
 
@@ -10,9 +11,19 @@ extern "C" {
 #include <libavutil/base64.h>  // for av_base64_encode
 }
 
+// AVIOInterruptCB: FFmpeg polls this while blocked in network I/O. Non-zero
+// aborts the call (AVERROR_EXIT) - on stop, or when the current connect/read
+// has run past its deadline.
+static int stream_interrupt_cb(void* opaque) {
+    const auto* state = static_cast<const StreamState*>(opaque);
+    if (!state->running.load(std::memory_order_relaxed)) return 1;
+    const int64_t deadline = state->io_deadline_us.load(std::memory_order_relaxed);
+    return deadline > 0 && av_gettime_relative() > deadline ? 1 : 0;
+}
+
 StreamManager::StreamManager() 
     : host_api_(nullptr), host_ctx_(nullptr), global_hw_decode_(false), 
-      default_transport_("tcp"), preferred_hw_type_(AV_HWDEVICE_TYPE_NONE),
+      default_transport_("tcp"), ingest_mode_("ffmpeg"), fast_start_(true), preferred_hw_type_(AV_HWDEVICE_TYPE_NONE),
       gen_(rd_()), jitter_dist_(-200, 200) {
 }
 
@@ -60,6 +71,28 @@ bool StreamManager::parse_configuration(const char* json_config) {
     // This is a simplified parser - replace with proper JSON library
     std::string config_str(json_config);
     
+    // Ingest engine: "ffmpeg" (thread per stream) or "epoll" (one reactor)
+    size_t ingest_pos = config_str.find("\"ingest\"");
+    if (ingest_pos != std::string::npos) {
+        size_t value_start = config_str.find(":", ingest_pos) + 1;
+        value_start = config_str.find("\"", value_start) + 1;
+        size_t value_end = config_str.find("\"", value_start);
+        ingest_mode_ = config_str.substr(value_start, value_end - value_start);
+    }
+    // Fast start on reconnect (default on)
+    size_t fast_pos = config_str.find("\"fast_start\"");
+    if (fast_pos != std::string::npos) {
+        size_t value_pos = config_str.find_first_not_of(" \t\r\n", config_str.find(":", fast_pos) + 1);
+        fast_start_ = value_pos == std::string::npos || config_str.compare(value_pos, 5, "false") != 0;
+    }
+    
+#ifndef ZM_WITH_RTSP_EPOLL
+    if (ingest_mode_ == "epoll") {
+        log(ZM_LOG_WARN, "epoll ingest is only available on Linux, using ffmpeg");
+        ingest_mode_ = "ffmpeg";
+    }
+#endif
+    
     // Look for "streams" array
     size_t streams_pos = config_str.find("\"streams\"");
     if (streams_pos == std::string::npos) {
@@ -184,6 +217,12 @@ bool StreamManager::start_all_streams() {
     
     log(ZM_LOG_INFO, "Starting %zu RTSP streams", stream_configs_.size());
     
+#ifdef ZM_WITH_RTSP_EPOLL
+    if (ingest_mode_ == "epoll") {
+        return start_epoll_ingest();
+    }
+#endif
+    
     bool all_started = true;
     for (const auto& [stream_id, config] : stream_configs_) {
         if (!setup_stream(stream_id)) {
@@ -207,9 +246,17 @@ void StreamManager::stop_all_streams() {
     
     log(ZM_LOG_INFO, "Stopping all RTSP streams");
     
-    // Signal all threads to stop
+#ifdef ZM_WITH_RTSP_EPOLL
+    // Joins the reactor (TEARDOWN sent) before the states it reports into go
+    if (ingest_) {
+        ingest_->stop();
+        ingest_.reset();
+    }
+#endif
+    
+    // Signal all threads to stop; the interrupt callback aborts blocking reads
     for (auto& [stream_id, state] : stream_states_) {
-        state->running = false;
+        state->request_stop();
     }
     
     // Wait for all threads to finish
@@ -234,6 +281,7 @@ bool StreamManager::setup_stream(uint32_t stream_id) {
     auto state = std::make_unique<StreamState>();
     state->stream_id = stream_id;
     state->start_time = std::chrono::steady_clock::now();
+    state->last_stats_time = state->start_time;
     
     stream_states_[stream_id] = std::move(state);
     
@@ -263,6 +311,8 @@ void StreamManager::cleanup_stream(uint32_t stream_id) {
         av_buffer_unref((AVBufferRef**)&state->hw_device_ctx);
     }
     
+    drop_codec_cache(state.get());
+    
     log_stream(stream_id, ZM_LOG_INFO, "Stream cleanup completed");
 }
 
@@ -310,65 +360,123 @@ void StreamManager::capture_loop(uint32_t stream_id) {
                 // Increase delay for next attempt (exponential backoff)
                 state->current_retry_delay_ms = std::min(state->current_retry_delay_ms * 2, MAX_RECONNECT_DELAY_MS);
                 
-                std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+                wait_or_stop(state.get(), delay_ms);
                 continue;
             }
         }
         
-        // Read and process frames
-        if (state->connected && state->fmt_ctx) {
-            int ret = av_read_frame(state->fmt_ctx, state->packet);
-            
-            if (ret >= 0) {
-                if (state->packet->stream_index == state->video_stream_index) {
-                    process_and_publish_frame(state.get(), config);
-                    state->frames_captured++;
-                } else if (config.forward_audio &&
-                           state->packet->stream_index == state->audio_stream_index) {
-                    publish_audio_packet(state.get(), config);
-                } else {
-                    // Other (e.g. data/subtitle) packet - discard
+        if (!state->fmt_ctx || !state->packet) {
+            state->connected = false;
+            continue;
+        }
+
+        // Demand-driven read: block in av_read_frame until the next packet
+        // arrives (or the interrupt callback fires) - no fixed sleeps, so a
+        // packet is forwarded as soon as the demuxer has it.
+        const int64_t read_start = av_gettime_relative();
+        state->io_deadline_us = read_start + READ_TIMEOUT_US;
+        int ret = av_read_frame(state->fmt_ctx, state->packet);
+        const int64_t arrival = av_gettime_relative();
+        if (!state->running) {
+            if (ret >= 0) av_packet_unref(state->packet);
+            break;
+        }
+
+        if (ret >= 0) {
+            state->read_stats.on_read(static_cast<uint64_t>(arrival - read_start));
+            if (state->packet->stream_index == state->video_stream_index) {
+                if (state->sps_pending && !check_fast_start_sps(state.get())) {
+                    log_stream(stream_id, ZM_LOG_WARN,
+                               "SPS differs from the cached codec parameters, reconnecting with a full probe");
+                    drop_codec_cache(state.get());
                     av_packet_unref(state->packet);
+                    handle_stream_disconnect(stream_id);
+                    continue;
                 }
-                
-                // Small delay to prevent overwhelming the system and network
-                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                if (state->packet->pts != AV_NOPTS_VALUE) {
+                    const AVRational tb = state->fmt_ctx->streams[state->video_stream_index]->time_base;
+                    state->read_stats.on_video_packet(
+                        arrival, av_rescale_q(state->packet->pts, tb, AVRational{1, 1000000}));
+                }
+                process_and_publish_frame(state.get(), config);
+                state->frames_captured++;
+                av_packet_unref(state->packet);
+            } else if (config.forward_audio &&
+                       state->packet->stream_index == state->audio_stream_index) {
+                publish_audio_packet(state.get(), config);
             } else {
-                if (ret == AVERROR_EOF) {
-                    log_stream(stream_id, ZM_LOG_INFO, "End of stream reached");
-                    handle_stream_disconnect(stream_id);
-                } else if (ret == AVERROR(EAGAIN)) {
-                    // Temporary unavailability - just wait a bit and continue
-                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                // Other (e.g. data/subtitle) packet - discard
+                av_packet_unref(state->packet);
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            if (now - state->last_stats_time >= std::chrono::milliseconds(STATS_INTERVAL_MS)) {
+                state->last_stats_time = now;
+                publish_read_stats(state.get());
+            }
+        } else if (ret == AVERROR(EAGAIN)) {
+            // Only non-blocking demuxers return this; let the next read block.
+            std::this_thread::yield();
+        } else {
+            if (ret == AVERROR_EOF) {
+                log_stream(stream_id, ZM_LOG_INFO, "End of stream reached");
+            } else {
+                char err_buf[AV_ERROR_MAX_STRING_SIZE];
+                av_strerror(ret, err_buf, sizeof(err_buf));
+                if (ret == AVERROR_EXIT) {
+                    log_stream(stream_id, ZM_LOG_WARN, "No packet for %d ms, reconnecting",
+                               static_cast<int>(READ_TIMEOUT_US / 1000));
                 } else {
-                    char err_buf[AV_ERROR_MAX_STRING_SIZE];
-                    av_strerror(ret, err_buf, sizeof(err_buf));
                     log_stream(stream_id, ZM_LOG_WARN, "Error reading frame: %s", err_buf);
-                    
-                    // Publish reconnection event
-                    char json_event[256];
-                    snprintf(json_event, sizeof(json_event), 
-                            "{\"event\":\"StreamReconnecting\",\"stream_id\":%u}", stream_id);
-                    if (host_api_ && host_api_->publish_evt) {
-                        host_api_->publish_evt(host_ctx_, json_event);
-                    }
-                    
-                    handle_stream_disconnect(stream_id);
+                }
+
+                // Publish reconnection event
+                char json_event[256];
+                snprintf(json_event, sizeof(json_event), 
+                        "{\"event\":\"StreamReconnecting\",\"stream_id\":%u}", stream_id);
+                if (host_api_ && host_api_->publish_evt) {
+                    host_api_->publish_evt(host_ctx_, json_event);
                 }
             }
-        } else {
-            // Not connected - wait before next connection attempt
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            handle_stream_disconnect(stream_id);
         }
-        
-        // Small delay to prevent busy waiting
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
     
     log_stream(stream_id, ZM_LOG_INFO, "Capture loop ended");
 }
 
+// Sleep up to delay_ms; returns early (false) when the stream is stopped.
+bool StreamManager::wait_or_stop(StreamState* state, int delay_ms) {
+    std::unique_lock<std::mutex> lk(state->wake_mutex);
+    return !state->wake_cv.wait_for(lk, std::chrono::milliseconds(delay_ms),
+                                    [state] { return !state->running.load(); });
+}
+
+void StreamManager::publish_read_stats(StreamState* state) {
+    if (!host_api_ || !host_api_->publish_evt) return;
+    const ReadStats& rs = state->read_stats;
+    char json_event[320];
+    snprintf(json_event, sizeof(json_event),
+             "{\"event\":\"StreamStats\",\"stream_id\":%u,\"packets_read\":%" PRIu64
+             ",\"read_latency_avg_us\":%" PRIu64 ",\"read_latency_max_us\":%" PRIu64
+             ",\"jitter_us\":%" PRIu64 "}",
+             state->stream_id, rs.packets.load(), rs.read_us_avg(), rs.read_us_max.load(),
+             rs.jitter_us.load());
+    host_api_->publish_evt(host_ctx_, json_event);
+}
+
+// SDP libavformat derives from the opened session (codecs, payload types,
+// sprop parameter sets); the fast-start cache key. Empty when unavailable.
+static std::string session_sdp(AVFormatContext* fmt_ctx) {
+    std::vector<char> buf(16384);
+    AVFormatContext* ctxs[1] = {fmt_ctx};
+    if (av_sdp_create(ctxs, 1, buf.data(), static_cast<int>(buf.size())) < 0) return std::string();
+    return std::string(buf.data());
+}
+
 bool StreamManager::connect_stream(StreamState* state, const StreamConfig& config) {
+    const auto connect_start = std::chrono::steady_clock::now();
+    
     // Cleanup any existing connection
     if (state->fmt_ctx) {
         avformat_close_input(&state->fmt_ctx);
@@ -387,6 +495,11 @@ bool StreamManager::connect_stream(StreamState* state, const StreamConfig& confi
         return false;
     }
     
+    // Stop/stall handling for every blocking call on this context
+    state->fmt_ctx->interrupt_callback.callback = stream_interrupt_cb;
+    state->fmt_ctx->interrupt_callback.opaque = state;
+    state->io_deadline_us = av_gettime_relative() + CONNECT_TIMEOUT_US;
+    
     // Set RTSP options for low latency and reliability
     AVDictionary* opts = nullptr;
     av_dict_set(&opts, "rtsp_transport", config.transport.c_str(), 0);
@@ -397,6 +510,11 @@ bool StreamManager::connect_stream(StreamState* state, const StreamConfig& confi
     av_dict_set(&opts, "reconnect", "1", 0);             // Auto reconnect
     av_dict_set(&opts, "reconnect_streamed", "1", 0);    // Auto reconnect for streamed media
     av_dict_set(&opts, "reconnect_delay_max", "5", 0);   // Max 5 seconds between reconnection attempts
+    if (fast_start_ && state->cached_video_par) {
+        // Codec parameters are expected from the cache: keep open's own probing minimal
+        av_dict_set(&opts, "probesize", "32", 0);
+        av_dict_set(&opts, "analyzeduration", "0", 0);
+    }
     
     // Open input
     int ret = avformat_open_input(&state->fmt_ctx, config.url.c_str(), nullptr, &opts);
@@ -409,13 +527,24 @@ bool StreamManager::connect_stream(StreamState* state, const StreamConfig& confi
         return false;
     }
     
-    // Find stream info
-    ret = avformat_find_stream_info(state->fmt_ctx, nullptr);
-    if (ret < 0) {
-        char err_buf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, err_buf, sizeof(err_buf));
-        log_stream(state->stream_id, ZM_LOG_ERROR, "Failed to find stream info: %s", err_buf);
-        return false;
+    // Fast start: when the session's SDP matches the one the cached codec
+    // parameters were probed under, reuse them and skip the probe (seconds of
+    // buffering before the first packet). The first keyframe's SPS confirms.
+    const std::string sdp = fast_start_ ? session_sdp(state->fmt_ctx) : std::string();
+    const bool fast = fast_start_ && apply_cached_codecpar(state, sdp);
+    if (!fast) {
+        // Find stream info
+        if (state->cached_video_par) {
+            log_stream(state->stream_id, ZM_LOG_INFO, "SDP changed, probing stream again");
+            drop_codec_cache(state);
+        }
+        ret = avformat_find_stream_info(state->fmt_ctx, nullptr);
+        if (ret < 0) {
+            char err_buf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(ret, err_buf, sizeof(err_buf));
+            log_stream(state->stream_id, ZM_LOG_ERROR, "Failed to find stream info: %s", err_buf);
+            return false;
+        }
     }
     
     // Count streams and find the first video + first audio stream
@@ -443,6 +572,10 @@ bool StreamManager::connect_stream(StreamState* state, const StreamConfig& confi
     }
     
     log_stream(state->stream_id, ZM_LOG_INFO, "Found %d video, %d audio streams", video_count, audio_count);
+    if (fast_start_ && !fast) {
+        cache_codecpar(state, sdp);
+    }
+    state->sps_pending = fast;
     
     // Setup decoder
     AVStream* video_stream = state->fmt_ctx->streams[state->video_stream_index];
@@ -479,13 +612,18 @@ bool StreamManager::connect_stream(StreamState* state, const StreamConfig& confi
     }
     
     // Allocate packet
+    if (state->packet) av_packet_free(&state->packet);
     state->packet = av_packet_alloc();
     if (!state->packet) {
         log_stream(state->stream_id, ZM_LOG_ERROR, "Failed to allocate packet");
         return false;
     }
     
-    log_stream(state->stream_id, ZM_LOG_INFO, "Successfully connected to %s", config.url.c_str());
+    const auto connect_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - connect_start).count();
+    log_stream(state->stream_id, ZM_LOG_INFO, "Successfully connected to %s in %lld ms (%s)",
+               config.url.c_str(), static_cast<long long>(connect_ms),
+               fast ? "fast start, cached codec parameters" : "probed");
     
     // Publish connection event with stream info
     char json_event[512];
@@ -507,6 +645,78 @@ bool StreamManager::connect_stream(StreamState* state, const StreamConfig& confi
     return true;
 }
 
+// Copy the cached parameters onto the first video (and audio) stream when
+// `sdp` matches the SDP they were probed under and the codecs still agree.
+bool StreamManager::apply_cached_codecpar(StreamState* state, const std::string& sdp) {
+    if (!state->cached_video_par || sdp.empty() || sdp != state->cached_sdp) {
+        return false;
+    }
+    AVStream* video = nullptr;
+    AVStream* audio = nullptr;
+    for (unsigned int i = 0; i < state->fmt_ctx->nb_streams; i++) {
+        AVStream* st = state->fmt_ctx->streams[i];
+        if (!video && st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) video = st;
+        if (!audio && st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) audio = st;
+    }
+    if (!video || video->codecpar->codec_id != state->cached_video_par->codec_id) {
+        return false;
+    }
+    if (avcodec_parameters_copy(video->codecpar, state->cached_video_par) < 0) {
+        return false;
+    }
+    if (audio && state->cached_audio_par &&
+        audio->codecpar->codec_id == state->cached_audio_par->codec_id) {
+        avcodec_parameters_copy(audio->codecpar, state->cached_audio_par);
+    }
+    return true;
+}
+
+void StreamManager::cache_codecpar(StreamState* state, const std::string& sdp) {
+    drop_codec_cache(state);
+    if (sdp.empty() || state->video_stream_index < 0) return;
+    
+    state->cached_video_par = avcodec_parameters_alloc();
+    if (!state->cached_video_par ||
+        avcodec_parameters_copy(state->cached_video_par,
+                                state->fmt_ctx->streams[state->video_stream_index]->codecpar) < 0) {
+        drop_codec_cache(state);
+        return;
+    }
+    if (state->audio_stream_index >= 0) {
+        state->cached_audio_par = avcodec_parameters_alloc();
+        if (state->cached_audio_par &&
+            avcodec_parameters_copy(state->cached_audio_par,
+                                    state->fmt_ctx->streams[state->audio_stream_index]->codecpar) < 0) {
+            avcodec_parameters_free(&state->cached_audio_par);
+        }
+    }
+    state->cached_sdp = sdp;
+}
+
+void StreamManager::drop_codec_cache(StreamState* state) {
+    avcodec_parameters_free(&state->cached_video_par);
+    avcodec_parameters_free(&state->cached_audio_par);
+    state->cached_sdp.clear();
+    state->sps_pending = false;
+}
+
+// First keyframe after a fast start: compare its in-band SPS with the cached
+// extradata. False when they differ (the camera was reconfigured while
+// away); a keyframe without an SPS to compare settles it as well.
+bool StreamManager::check_fast_start_sps(StreamState* state) {
+    const AVPacket* pkt = state->packet;
+    if (!(pkt->flags & AV_PKT_FLAG_KEY)) return true;
+    state->sps_pending = false;
+    const AVCodecParameters* par = state->cached_video_par;
+    if (!par || (par->codec_id != AV_CODEC_ID_H264 && par->codec_id != AV_CODEC_ID_HEVC)) {
+        return true;
+    }
+    return zm::codec_cache::check_sps(par->extradata, static_cast<size_t>(par->extradata_size),
+                                      pkt->data, static_cast<size_t>(pkt->size),
+                                      par->codec_id == AV_CODEC_ID_HEVC) !=
+           zm::codec_cache::SpsCheck::Mismatch;
+}
+
 bool StreamManager::init_hardware_acceleration(StreamState* state, const AVCodec* codec) {
     // Check if codec supports hardware acceleration
     bool supported = false;
@@ -552,6 +762,7 @@ void StreamManager::handle_stream_disconnect(uint32_t stream_id) {
     
     auto& state = state_it->second;
     state->connected = false;
+    state->read_stats.reset_timing();
     
     // Cleanup FFmpeg contexts
     if (state->codec_ctx) {
@@ -646,11 +857,6 @@ void StreamManager::process_and_publish_frame(StreamState* state, const StreamCo
         return;
     }
     
-    // Allocate frame buffer and copy data
-    std::vector<uint8_t> frame_buf(sizeof(zm_frame_hdr_t) + state->packet->size);
-    std::memcpy(frame_buf.data(), &hdr, sizeof(zm_frame_hdr_t));
-    std::memcpy(frame_buf.data() + sizeof(zm_frame_hdr_t), state->packet->data, state->packet->size);
-    
     // Debug logging for keyframes and periodic updates
     if (hdr.flags & 1) {
         log_stream(config.stream_id, ZM_LOG_DEBUG, "Publishing keyframe: size=%u, pts=%" PRId64, 
@@ -663,7 +869,8 @@ void StreamManager::process_and_publish_frame(StreamState* state, const StreamCo
     }
     
     // Publish validated frame to pipeline
-    host_api_->on_frame(host_ctx_, frame_buf.data(), frame_buf.size());
+    publish_compressed(config.stream_id, ZM_FRAME_COMPRESSED, state->packet->data,
+                       state->packet->size, hdr.pts_usec, hdr.flags);
 }
 
 void StreamManager::publish_audio_packet(StreamState* state, const StreamConfig& config) {
@@ -672,24 +879,35 @@ void StreamManager::publish_audio_packet(StreamState* state, const StreamConfig&
         return;
     }
     AVStream* astream = state->fmt_ctx->streams[state->audio_stream_index];
-    zm_frame_hdr_t hdr{};
-    hdr.stream_id = config.stream_id;
-    hdr.hw_type = ZM_FRAME_COMPRESSED_AUDIO;
-    hdr.handle = reinterpret_cast<uint64_t>(state->packet->data);
-    hdr.bytes = state->packet->size;
-    hdr.flags = 0;
     int64_t pts = (state->packet->pts != AV_NOPTS_VALUE) ? state->packet->pts : state->packet->dts;
-    hdr.pts_usec = (pts != AV_NOPTS_VALUE)
+    const int64_t pts_usec = (pts != AV_NOPTS_VALUE)
                        ? av_rescale_q(pts, astream->time_base, AVRational{1, 1000000})
                        : av_gettime();
 
-    std::vector<uint8_t> frame_buf(sizeof(zm_frame_hdr_t) + state->packet->size);
-    memcpy(frame_buf.data(), &hdr, sizeof(zm_frame_hdr_t));
-    memcpy(frame_buf.data() + sizeof(zm_frame_hdr_t), state->packet->data, state->packet->size);
-    host_api_->on_frame(host_ctx_, frame_buf.data(), frame_buf.size());
+    publish_compressed(config.stream_id, ZM_FRAME_COMPRESSED_AUDIO, state->packet->data,
+                       state->packet->size, pts_usec, 0);
     av_packet_unref(state->packet);
 }
 
+// Header + payload copy handed to the pipeline; shared by the libavformat and
+// epoll ingest paths so both produce identical packets.
+void StreamManager::publish_compressed(uint32_t stream_id, uint32_t hw_type, const uint8_t* data,
+                                       size_t size, int64_t pts_usec, uint32_t flags) {
+    if (!host_api_ || !host_api_->on_frame) return;
+    zm_frame_hdr_t hdr{};
+    hdr.stream_id = stream_id;
+    hdr.hw_type = hw_type;
+    hdr.handle = reinterpret_cast<uint64_t>(data);
+    hdr.bytes = static_cast<uint32_t>(size);
+    hdr.flags = flags;
+    hdr.pts_usec = pts_usec;
+
+    std::vector<uint8_t> frame_buf(sizeof(zm_frame_hdr_t) + size);
+    std::memcpy(frame_buf.data(), &hdr, sizeof(zm_frame_hdr_t));
+    std::memcpy(frame_buf.data() + sizeof(zm_frame_hdr_t), data, size);
+    host_api_->on_frame(host_ctx_, frame_buf.data(), frame_buf.size());
+}
+
 void StreamManager::publish_stream_metadata(uint32_t stream_id, const AVCodecParameters* codecpar,
                                             const char* media) {
     if (!host_api_ || !host_api_->publish_evt || !codecpar) {
@@ -750,10 +968,17 @@ bool StreamManager::remove_stream(uint32_t stream_id) {
     std::lock_guard<std::mutex> lock(streams_mutex_);
     
     // Stop the stream if running
+#ifdef ZM_WITH_RTSP_EPOLL
+    if (ingest_) {
+        log(ZM_LOG_ERROR, "Cannot remove stream %u while the epoll ingest is running", stream_id);
+        return false;
+    }
+#endif
+    
     auto state_it = stream_states_.find(stream_id);
     if (state_it != stream_states_.end()) {
         auto& state = state_it->second;
-        state->running = false;
+        state->request_stop();
         
         if (state->capture_thread.joinable()) {
             state->capture_thread.join();
@@ -810,6 +1035,10 @@ std::vector<StreamManager::StreamStats> StreamManager::get_stream_statistics() c
             stat.frames_captured = state->frames_captured;
             stat.packets_dropped = state->packets_dropped;
             stat.retry_count = state->retry_count;
+            stat.packets_read = state->read_stats.packets.load();
+            stat.read_latency_avg_us = state->read_stats.read_us_avg();
+            stat.read_latency_max_us = state->read_stats.read_us_max.load();
+            stat.jitter_us = state->read_stats.jitter_us.load();
             
             auto now = std::chrono::steady_clock::now();
             auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - state->start_time);
@@ -822,6 +1051,157 @@ std::vector<StreamManager::StreamStats> StreamManager::get_stream_statistics() c
     return stats;
 }
 
+#ifdef ZM_WITH_RTSP_EPOLL
+// Epoll ingest. Streams are fixed for the reactor's lifetime (remove_stream
+// refuses while it runs), so the callbacks look states up without the lock,
+// as the capture threads do.
+
+bool StreamManager::start_epoll_ingest() {
+    zm::rtsp::IngestCallbacks cb;
+    cb.on_connected = [this](uint32_t id, const zm::rtsp::SdpTrack& video,
+                             const zm::rtsp::SdpTrack* audio) {
+        on_ingest_connected(id, video, audio);
+    };
+    cb.on_frame = [this](uint32_t id, const zm::rtsp::IngestFrame& frame) {
+        on_ingest_frame(id, frame);
+    };
+    cb.on_disconnected = [this](uint32_t id, const std::string& reason) {
+        on_ingest_disconnected(id, reason);
+    };
+    cb.log = [this](uint32_t id, int level, const std::string& msg) {
+        log_stream(id, static_cast<zm_log_level_t>(level), "%s", msg.c_str());
+    };
+    ingest_ = std::make_unique<zm::rtsp::RtspIngest>(std::move(cb));
+
+    bool all_started = true;
+    for (const auto& [stream_id, config] : stream_configs_) {
+        if (!setup_stream(stream_id)) {
+            log(ZM_LOG_ERROR, "Failed to setup stream %u", stream_id);
+            all_started = false;
+            continue;
+        }
+        zm::rtsp::IngestStream stream;
+        stream.stream_id = stream_id;
+        stream.url = config.url;
+        stream.transport = config.transport;
+        stream.forward_audio = config.forward_audio;
+        stream.max_retry_attempts = config.max_retry_attempts;
+        if (!ingest_->add(stream)) {
+            log(ZM_LOG_ERROR, "Stream %u: epoll ingest rejected %s", stream_id, config.url.c_str());
+            all_started = false;
+            continue;
+        }
+        stream_states_[stream_id]->running = true;
+    }
+
+    if (!ingest_->start()) {
+        log(ZM_LOG_ERROR, "Failed to start epoll ingest");
+        ingest_.reset();
+        return false;
+    }
+    log(ZM_LOG_INFO, "Epoll ingest running %zu streams on one thread", stream_states_.size());
+    return all_started;
+}
+
+// AVCodecParameters equivalent of what libavformat derives from the SDP, so
+// StreamMetadata is the same on both paths. Dimensions are left 0 (the
+// decoder learns them from the in-band SPS).
+static AVCodecParameters* ingest_codecpar(const zm::rtsp::SdpTrack& track) {
+    AVCodecParameters* par = avcodec_parameters_alloc();
+    if (!par) return nullptr;
+    std::vector<uint8_t> extradata;
+    if (track.codec == zm::rtsp::Codec::AAC) {
+        par->codec_type = AVMEDIA_TYPE_AUDIO;
+        par->codec_id = AV_CODEC_ID_AAC;
+        par->sample_rate = track.clock_rate;
+        av_channel_layout_default(&par->ch_layout, track.channels);
+        extradata = zm::rtsp::aac_config(track);
+    } else {
+        par->codec_type = AVMEDIA_TYPE_VIDEO;
+        par->codec_id = track.codec == zm::rtsp::Codec::H265 ? AV_CODEC_ID_HEVC : AV_CODEC_ID_H264;
+        extradata = zm::rtsp::parameter_sets_annexb(track);
+    }
+    if (!extradata.empty()) {
+        par->extradata = static_cast<uint8_t*>(
+            av_mallocz(extradata.size() + AV_INPUT_BUFFER_PADDING_SIZE));
+        if (par->extradata) {
+            std::memcpy(par->extradata, extradata.data(), extradata.size());
+            par->extradata_size = static_cast<int>(extradata.size());
+        }
+    }
+    return par;
+}
+
+void StreamManager::on_ingest_connected(uint32_t stream_id, const zm::rtsp::SdpTrack& video,
+                                        const zm::rtsp::SdpTrack* audio) {
+    auto state_it = stream_states_.find(stream_id);
+    auto config_it = stream_configs_.find(stream_id);
+    if (state_it == stream_states_.end() || config_it == stream_configs_.end()) return;
+    StreamState* state = state_it->second.get();
+    state->connected = true;
+    state->retry_count = 0;
+
+    char json_event[512];
+    snprintf(json_event, sizeof(json_event),
+            "{\"event\":\"StreamConnected\",\"stream_id\":%u,\"url\":\"%s\",\"video_streams\":1,\"audio_streams\":%d}",
+            stream_id, config_it->second.url.c_str(), audio ? 1 : 0);
+    if (host_api_ && host_api_->publish_evt) {
+        host_api_->publish_evt(host_ctx_, json_event);
+    }
+
+    AVCodecParameters* par = ingest_codecpar(video);
+    publish_stream_metadata(stream_id, par, "video");
+    avcodec_parameters_free(&par);
+    if (audio) {
+        par = ingest_codecpar(*audio);
+        publish_stream_metadata(stream_id, par, "audio");
+        avcodec_parameters_free(&par);
+    }
+}
+
+void StreamManager::on_ingest_frame(uint32_t stream_id, const zm::rtsp::IngestFrame& frame) {
+    auto state_it = stream_states_.find(stream_id);
+    if (state_it == stream_states_.end()) return;
+    StreamState* state = state_it->second.get();
+
+    // No per-stream blocking read here: packets are counted, latency stays 0.
+    state->read_stats.on_read(0);
+    if (frame.audio) {
+        publish_compressed(stream_id, ZM_FRAME_COMPRESSED_AUDIO, frame.data, frame.size,
+                           frame.pts_usec, 0);
+    } else {
+        state->read_stats.on_video_packet(frame.arrival_usec, frame.pts_usec);
+        publish_compressed(stream_id, ZM_FRAME_COMPRESSED, frame.data, frame.size, frame.pts_usec,
+                           frame.keyframe ? ZM_FRAME_FLAG_KEYFRAME : 0);
+        state->frames_captured++;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - state->last_stats_time >= std::chrono::milliseconds(STATS_INTERVAL_MS)) {
+        state->last_stats_time = now;
+        publish_read_stats(state);
+    }
+}
+
+void StreamManager::on_ingest_disconnected(uint32_t stream_id, const std::string& reason) {
+    auto state_it = stream_states_.find(stream_id);
+    if (state_it == stream_states_.end()) return;
+    StreamState* state = state_it->second.get();
+    state->connected = false;
+    state->retry_count++;
+    state->read_stats.reset_timing();
+
+    char json_event[512];
+    snprintf(json_event, sizeof(json_event),
+            "{\"event\":\"StreamDisconnected\",\"stream_id\":%u}", stream_id);
+    if (host_api_ && host_api_->publish_evt) {
+        host_api_->publish_evt(host_ctx_, json_event);
+    }
+    log_stream(stream_id, ZM_LOG_INFO, "Stream disconnected (%s), will attempt reconnection",
+               reason.c_str());
+}
+#endif
+
 // Logging methods
 void StreamManager::log(zm_log_level_t level, const char* format, ...) {
     if (!host_api_ || !host_api_->log) return;
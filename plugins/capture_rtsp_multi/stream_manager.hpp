@@ -1,6 +1,10 @@
 #pragma once
 
 #include "zm_plugin.h"
+#include "read_stats.hpp"
+#ifdef ZM_WITH_RTSP_EPOLL
+#include "rtsp_ingest.hpp"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -21,6 +25,7 @@ extern "C" {
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
 #include <chrono>
 #include <memory>
 #include <random>
@@ -52,6 +57,14 @@ struct StreamState {
     std::atomic<bool> running;
     std::atomic<bool> connected;
     std::thread capture_thread;
+
+    // Blocking FFmpeg I/O is cut short through fmt_ctx->interrupt_callback:
+    // on stop (running == false) or once av_gettime_relative() passes this
+    // deadline (0 = none), so a stalled camera cannot hang the thread.
+    std::atomic<int64_t> io_deadline_us;
+    // Woken on stop so a reconnect backoff does not delay shutdown.
+    std::mutex wake_mutex;
+    std::condition_variable wake_cv;
     
     // Connection/retry state
     int retry_count;
@@ -63,11 +76,32 @@ struct StreamState {
     uint64_t frames_captured;
     uint64_t packets_dropped;
     std::chrono::steady_clock::time_point start_time;
+    ReadStats read_stats;
+    std::chrono::steady_clock::time_point last_stats_time;
+
+    // Fast start: codec parameters from the last full probe and the SDP they
+    // were probed under. A reconnect whose SDP matches reuses them instead of
+    // running avformat_find_stream_info; the first keyframe's SPS is then
+    // checked against the cached extradata (sps_pending).
+    AVCodecParameters* cached_video_par;
+    AVCodecParameters* cached_audio_par;
+    std::string cached_sdp;
+    bool sps_pending;
     
     StreamState() : fmt_ctx(nullptr), codec_ctx(nullptr), packet(nullptr), 
                    hw_device_ctx(nullptr), stream_id(0), video_stream_index(-1), audio_stream_index(-1),
-                   running(false), connected(false), retry_count(0), current_retry_delay_ms(1000),
-                   frames_captured(0), packets_dropped(0) {}
+                   running(false), connected(false), io_deadline_us(0), retry_count(0),
+                   current_retry_delay_ms(1000), frames_captured(0), packets_dropped(0),
+                   cached_video_par(nullptr), cached_audio_par(nullptr), sps_pending(false) {}
+
+    // Signal the capture thread to stop and abort any blocking read.
+    void request_stop() {
+        {
+            std::lock_guard<std::mutex> lk(wake_mutex);
+            running = false;
+        }
+        wake_cv.notify_all();
+    }
 };
 
 // Multi-stream RTSP capture manager
@@ -98,6 +132,10 @@ public:
         uint64_t packets_dropped;
         int retry_count;
         double uptime_seconds;
+        uint64_t packets_read;
+        uint64_t read_latency_avg_us;  // time blocked in av_read_frame per packet
+        uint64_t read_latency_max_us;
+        uint64_t jitter_us;            // video interarrival jitter (RFC 3550)
     };
     std::vector<StreamStats> get_stream_statistics() const;
     
@@ -114,6 +152,14 @@ private:
     // Global settings
     bool global_hw_decode_;
     std::string default_transport_;
+    std::string ingest_mode_;  // "ffmpeg" (thread per stream) or "epoll"
+    bool fast_start_;          // reuse cached codec parameters on reconnect
+
+#ifdef ZM_WITH_RTSP_EPOLL
+    // All streams on one reactor thread when ingest_mode_ == "epoll"; the
+    // StreamStates then only carry status and statistics.
+    std::unique_ptr<zm::rtsp::RtspIngest> ingest_;
+#endif
     
     // FFmpeg hardware acceleration
     AVHWDeviceType preferred_hw_type_;
@@ -121,6 +167,11 @@ private:
     // Reconnection constants
     static constexpr int MIN_RECONNECT_DELAY_MS = 1000;    // 1 second
     static constexpr int MAX_RECONNECT_DELAY_MS = 30000;   // 30 seconds
+    // I/O deadlines enforced by the interrupt callback
+    static constexpr int64_t CONNECT_TIMEOUT_US = 15000000; // open + probe
+    static constexpr int64_t READ_TIMEOUT_US = 10000000;    // one av_read_frame
+    // StreamStats event cadence per stream
+    static constexpr int STATS_INTERVAL_MS = 10000;
     
     // Random number generator for jitter
     mutable std::random_device rd_;
@@ -136,11 +187,28 @@ private:
     // Per-stream capture loop
     void capture_loop(uint32_t stream_id);
     bool connect_stream(StreamState* state, const StreamConfig& config);
+    bool apply_cached_codecpar(StreamState* state, const std::string& sdp);
+    void cache_codecpar(StreamState* state, const std::string& sdp);
+    void drop_codec_cache(StreamState* state);
+    bool check_fast_start_sps(StreamState* state);
     void handle_stream_disconnect(uint32_t stream_id);
+    bool wait_or_stop(StreamState* state, int delay_ms);
+    void publish_read_stats(StreamState* state);
+
+#ifdef ZM_WITH_RTSP_EPOLL
+    // Epoll ingest (ingest_mode_ == "epoll"); callbacks run on its reactor thread
+    bool start_epoll_ingest();
+    void on_ingest_connected(uint32_t stream_id, const zm::rtsp::SdpTrack& video,
+                             const zm::rtsp::SdpTrack* audio);
+    void on_ingest_frame(uint32_t stream_id, const zm::rtsp::IngestFrame& frame);
+    void on_ingest_disconnected(uint32_t stream_id, const std::string& reason);
+#endif
     
     // Frame processing and publishing
     void process_and_publish_frame(StreamState* state, const StreamConfig& config);
     void publish_audio_packet(StreamState* state, const StreamConfig& config);
+    void publish_compressed(uint32_t stream_id, uint32_t hw_type, const uint8_t* data, size_t size,
+                            int64_t pts_usec, uint32_t flags);
     
     // Publishing and communication
     void log(zm_log_level_t level, const char* format, ...);
@@ -0,0 +1,345 @@
+#pragma once
+
+// Local RTSP server stand-in for the epoll ingest tests: answers
+// DESCRIBE/SETUP/PLAY/OPTIONS/TEARDOWN (optionally behind Digest auth) and,
+// after PLAY, streams a fixed list of H.264 access units (and AAC frames) as
+// RTP over TCP-interleaved or UDP. One blocking thread per connection - it
+// only has to be simple, not fast.
+
+#include "rtsp_protocol.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace standin {
+
+using Bytes = std::vector<uint8_t>;
+
+// NAL units of an Annex B buffer (start codes stripped).
+inline std::vector<Bytes> split_nals(const Bytes& annexb) {
+    std::vector<Bytes> nals;
+    size_t i = 0, start = 0;
+    bool in_nal = false;
+    while (i + 2 < annexb.size()) {
+        if (annexb[i] == 0 && annexb[i + 1] == 0 && annexb[i + 2] == 1) {
+            if (in_nal) {
+                size_t end = i;
+                if (end > start && annexb[end - 1] == 0) --end;  // 4-byte start code
+                nals.emplace_back(annexb.begin() + start, annexb.begin() + end);
+            }
+            i += 3;
+            start = i;
+            in_nal = true;
+        } else {
+            ++i;
+        }
+    }
+    if (in_nal) nals.emplace_back(annexb.begin() + start, annexb.end());
+    return nals;
+}
+
+inline Bytes annexb(const std::vector<Bytes>& nals) {
+    Bytes out;
+    for (const auto& n : nals) {
+        out.insert(out.end(), {0, 0, 0, 1});
+        out.insert(out.end(), n.begin(), n.end());
+    }
+    return out;
+}
+
+inline Bytes rtp_packet(uint8_t pt, bool marker, uint16_t seq, uint32_t ts, const Bytes& payload) {
+    Bytes p(12);
+    p[0] = 0x80;
+    p[1] = static_cast<uint8_t>((marker ? 0x80 : 0) | pt);
+    p[2] = static_cast<uint8_t>(seq >> 8);
+    p[3] = static_cast<uint8_t>(seq);
+    for (int i = 0; i < 4; ++i) p[4 + i] = static_cast<uint8_t>(ts >> (24 - 8 * i));
+    p[8] = 0x12, p[9] = 0x34, p[10] = 0x56, p[11] = 0x78;
+    p.insert(p.end(), payload.begin(), payload.end());
+    return p;
+}
+
+// RFC 6184 packetization-mode 1: runs of small NALs go out as STAP-A, NALs
+// larger than `mtu` as FU-A, the rest as single NAL packets. Returns payloads;
+// the last one carries the marker.
+inline std::vector<Bytes> packetize_h264(const Bytes& au, size_t mtu = 1400) {
+    const auto nals = split_nals(au);
+    std::vector<Bytes> out;
+    size_t i = 0;
+    while (i < nals.size()) {
+        const Bytes& nal = nals[i];
+        if (nal.size() < 200 && i + 1 < nals.size() && nals[i + 1].size() < 200) {
+            Bytes stap{static_cast<uint8_t>((nal[0] & 0x60) | 24)};
+            while (i < nals.size() && nals[i].size() < 200) {
+                stap.push_back(static_cast<uint8_t>(nals[i].size() >> 8));
+                stap.push_back(static_cast<uint8_t>(nals[i].size()));
+                stap.insert(stap.end(), nals[i].begin(), nals[i].end());
+                ++i;
+            }
+            out.push_back(stap);
+            continue;
+        }
+        if (nal.size() <= mtu) {
+            out.push_back(nal);
+        } else {
+            size_t off = 1;
+            while (off < nal.size()) {
+                const size_t n = std::min(mtu - 2, nal.size() - off);
+                Bytes fu{static_cast<uint8_t>((nal[0] & 0xe0) | 28),
+                         static_cast<uint8_t>((off == 1 ? 0x80 : 0) |
+                                              (off + n == nal.size() ? 0x40 : 0) | (nal[0] & 0x1f))};
+                fu.insert(fu.end(), nal.begin() + off, nal.begin() + off + n);
+                out.push_back(fu);
+                off += n;
+            }
+        }
+        ++i;
+    }
+    return out;
+}
+
+// RFC 3640 AAC-hbr: one AU per packet, 13-bit size + 3-bit index.
+inline Bytes packetize_aac(const Bytes& au) {
+    Bytes p{0, 16, static_cast<uint8_t>(au.size() >> 5), static_cast<uint8_t>((au.size() & 0x1f) << 3)};
+    p.insert(p.end(), au.begin(), au.end());
+    return p;
+}
+
+inline Bytes read_file(const std::string& path) {
+    std::ifstream f(path, std::ios::binary);
+    return Bytes(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+}
+
+class Server {
+public:
+    std::vector<Bytes> video;  // Annex B access units
+    std::vector<Bytes> audio;  // raw AAC frames, one per video AU
+    std::string user, password;  // non-empty: Digest auth required
+    uint32_t video_ts_base = 0xfffe0000u;  // wraps within the first frames
+    uint32_t video_ts_step = 3000;         // 30 fps at 90 kHz
+
+    ~Server() { stop(); }
+
+    bool start() {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (listen_fd_ < 0 || bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(listen_fd_, 16) != 0 ||
+            getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+            return false;
+        port_ = ntohs(addr.sin_port);
+        set_timeout(listen_fd_);
+        running_ = true;
+        accept_thread_ = std::thread([this] { accept_loop(); });
+        return true;
+    }
+
+    void stop() {
+        running_ = false;
+        if (accept_thread_.joinable()) accept_thread_.join();
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            threads.swap(conn_threads_);
+        }
+        for (auto& t : threads) t.join();
+        if (listen_fd_ >= 0) ::close(listen_fd_);
+        listen_fd_ = -1;
+    }
+
+    std::string url(const std::string& path, bool with_credentials = false) const {
+        const std::string cred = with_credentials ? user + ":" + password + "@" : "";
+        return "rtsp://" + cred + "127.0.0.1:" + std::to_string(port_) + "/" + path;
+    }
+
+    int plays() const { return plays_; }
+    int teardowns() const { return teardowns_; }
+    int unauthorized() const { return unauthorized_; }
+
+private:
+    static void set_timeout(int fd) {
+        timeval tv{0, 50000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+
+    void accept_loop() {
+        while (running_) {
+            const int fd = accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) continue;
+            set_timeout(fd);
+            std::lock_guard<std::mutex> lk(mu_);
+            conn_threads_.emplace_back([this, fd] { serve(fd); });
+        }
+    }
+
+    static void send_all(int fd, const void* data, size_t n) {
+        const char* p = static_cast<const char*>(data);
+        while (n > 0) {
+            const ssize_t w = ::send(fd, p, n, MSG_NOSIGNAL);
+            if (w <= 0) return;
+            p += w;
+            n -= static_cast<size_t>(w);
+        }
+    }
+
+    std::string sdp() const {
+        const auto nals = split_nals(video.front());
+        std::string sprop;
+        for (const auto& n : nals) {
+            const int type = n[0] & 0x1f;
+            if (type != 7 && type != 8) continue;
+            if (!sprop.empty()) sprop += ",";
+            sprop += zm::rtsp::base64_encode(std::string(n.begin(), n.end()));
+        }
+        std::string s =
+            "v=0\r\no=- 0 0 IN IP4 127.0.0.1\r\ns=standin\r\nt=0 0\r\na=control:*\r\n"
+            "m=video 0 RTP/AVP 96\r\na=rtpmap:96 H264/90000\r\n"
+            "a=fmtp:96 packetization-mode=1;sprop-parameter-sets=" + sprop + "\r\n"
+            "a=control:trackID=0\r\n";
+        if (!audio.empty())
+            s += "m=audio 0 RTP/AVP 97\r\na=rtpmap:97 mpeg4-generic/48000/2\r\n"
+                 "a=fmtp:97 streamtype=5;profile-level-id=15;mode=AAC-hbr;config=1190;"
+                 "sizelength=13;indexlength=3;indexdeltalength=3\r\n"
+                 "a=control:trackID=1\r\n";
+        return s;
+    }
+
+    bool authorized(const std::string& method, const std::map<std::string, std::string>& h) const {
+        if (user.empty()) return true;
+        auto it = h.find("authorization");
+        if (it == h.end()) return false;
+        zm::rtsp::Auth a;
+        a.user = user;
+        a.password = password;
+        a.digest = true;
+        a.realm = "standin";
+        a.nonce = "5e7d1c";
+        const std::string& v = it->second;
+        const size_t u = v.find("uri=\"");
+        if (u == std::string::npos) return false;
+        const std::string uri = v.substr(u + 5, v.find('"', u + 5) - u - 5);
+        return v == a.authorization(method, uri);
+    }
+
+    void serve(int fd) {
+        std::string in;
+        bool tcp = true;
+        int udp_ports[2] = {0, 0};
+        size_t setups = 0;
+        char buf[4096];
+        while (running_) {
+            const ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n == 0) break;
+            if (n > 0) in.append(buf, static_cast<size_t>(n));
+            for (;;) {
+                const size_t end = in.find("\r\n\r\n");
+                if (end == std::string::npos) break;
+                const std::string head = in.substr(0, end);
+                in.erase(0, end + 4);
+                const std::string method = head.substr(0, head.find(' '));
+                std::map<std::string, std::string> h;
+                size_t pos = head.find("\r\n");
+                while (pos != std::string::npos) {
+                    const size_t next = head.find("\r\n", pos + 2);
+                    const std::string line = head.substr(pos + 2, next == std::string::npos ? std::string::npos : next - pos - 2);
+                    const size_t c = line.find(':');
+                    if (c != std::string::npos)
+                        h[zm::rtsp::to_lower(line.substr(0, c))] = zm::rtsp::trim(line.substr(c + 1));
+                    pos = next;
+                }
+                std::string reply = "RTSP/1.0 200 OK\r\nCSeq: " + h["cseq"] + "\r\n";
+                std::string body;
+                if (!authorized(method, h)) {
+                    ++unauthorized_;
+                    reply = "RTSP/1.0 401 Unauthorized\r\nCSeq: " + h["cseq"] +
+                            "\r\nWWW-Authenticate: Digest realm=\"standin\", nonce=\"5e7d1c\"\r\n";
+                } else if (method == "DESCRIBE") {
+                    body = sdp();
+                    reply += "Content-Type: application/sdp\r\nContent-Base: " + url("cam") + "/\r\n";
+                } else if (method == "SETUP") {
+                    const std::string t = h["transport"];
+                    tcp = t.find("TCP") != std::string::npos;
+                    const size_t cp = t.find("client_port=");
+                    if (!tcp && cp != std::string::npos && setups < 2)
+                        udp_ports[setups] = std::atoi(t.c_str() + cp + 12);
+                    ++setups;
+                    reply += "Transport: " + t + "\r\nSession: 4711;timeout=60\r\n";
+                } else if (method == "TEARDOWN") {
+                    ++teardowns_;
+                } else if (method != "PLAY" && method != "OPTIONS") {
+                    reply = "RTSP/1.0 501 Not Implemented\r\nCSeq: " + h["cseq"] + "\r\n";
+                }
+                if (!body.empty()) reply += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+                reply += "\r\n" + body;
+                send_all(fd, reply.data(), reply.size());
+                if (method == "PLAY" && reply.compare(9, 3, "200") == 0) {
+                    ++plays_;
+                    stream(fd, tcp, udp_ports, setups);
+                }
+            }
+        }
+        ::close(fd);
+    }
+
+    void stream(int fd, bool tcp, const int udp_ports[2], size_t tracks) {
+        int udp = -1;
+        if (!tcp) udp = socket(AF_INET, SOCK_DGRAM, 0);
+        size_t sent_since_pause = 0;
+        auto send_rtp = [&](int channel, const Bytes& pkt) {
+            if (tcp) {
+                Bytes frame{'$', static_cast<uint8_t>(channel), static_cast<uint8_t>(pkt.size() >> 8),
+                            static_cast<uint8_t>(pkt.size())};
+                frame.insert(frame.end(), pkt.begin(), pkt.end());
+                send_all(fd, frame.data(), frame.size());
+                return;
+            }
+            sockaddr_in to{};
+            to.sin_family = AF_INET;
+            to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            to.sin_port = htons(static_cast<uint16_t>(udp_ports[channel / 2]));
+            sendto(udp, pkt.data(), pkt.size(), 0, reinterpret_cast<sockaddr*>(&to), sizeof(to));
+            // Loopback has no flow control: pace so the socket buffer keeps up.
+            if (++sent_since_pause == 32) {
+                sent_since_pause = 0;
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+            }
+        };
+        uint16_t vseq = 0xfff0, aseq = 0;  // sequence numbers wrap too
+        for (size_t i = 0; i < video.size() && running_; ++i) {
+            const uint32_t ts = video_ts_base + static_cast<uint32_t>(i) * video_ts_step;
+            const auto payloads = packetize_h264(video[i]);
+            for (size_t k = 0; k < payloads.size(); ++k)
+                send_rtp(0, rtp_packet(96, k + 1 == payloads.size(), vseq++, ts, payloads[k]));
+            if (tracks > 1 && i < audio.size())
+                send_rtp(2, rtp_packet(97, true, aseq++, static_cast<uint32_t>(i) * 1024,
+                                       packetize_aac(audio[i])));
+        }
+        if (udp >= 0) ::close(udp);
+    }
+
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> running_{false};
+    std::atomic<int> plays_{0}, teardowns_{0}, unauthorized_{0};
+    std::thread accept_thread_;
+    std::mutex mu_;
+    std::vector<std::thread> conn_threads_;
+};
+
+}  // namespace standin
@@ -0,0 +1,93 @@
+// Unit tests for the fast-start SPS check (codec_cache.hpp); no FFmpeg needed.
+
+#include "codec_cache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using zm::codec_cache::SpsCheck;
+using Bytes = std::vector<uint8_t>;
+
+namespace {
+
+// SPS, PPS (4-byte start codes) and IDR (3-byte start code).
+Bytes keyframe() {
+    std::ifstream f(std::string(TEST_DATA_DIR) + "/packet.h264", std::ios::binary);
+    return Bytes(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+}
+
+Bytes sps_of(const Bytes& au) {
+    const auto nal = zm::codec_cache::find_annexb_nal(au.data(), au.size(), false, 7);
+    return Bytes(nal.data, nal.data + nal.size);
+}
+
+Bytes annexb(const Bytes& a, const Bytes& b) {
+    Bytes out{0, 0, 0, 1};
+    out.insert(out.end(), a.begin(), a.end());
+    out.insert(out.end(), {0, 0, 0, 1});
+    out.insert(out.end(), b.begin(), b.end());
+    return out;
+}
+
+SpsCheck check(const Bytes& extradata, const Bytes& pkt, bool hevc = false) {
+    return zm::codec_cache::check_sps(extradata.data(), extradata.size(), pkt.data(), pkt.size(), hevc);
+}
+
+}  // namespace
+
+TEST(CodecCacheTest, FindsSpsInAnnexB) {
+    const Bytes au = keyframe();
+    const Bytes sps = sps_of(au);
+    ASSERT_EQ(sps.size(), 27u);
+    EXPECT_EQ(sps[0], 0x67);
+    const auto idr = zm::codec_cache::find_annexb_nal(au.data(), au.size(), false, 5);
+    ASSERT_NE(idr.data, nullptr);
+    EXPECT_EQ(idr.data + idr.size, au.data() + au.size());
+}
+
+TEST(CodecCacheTest, AnnexBExtradataMatchesSameSps) {
+    const Bytes au = keyframe();
+    const Bytes sps = sps_of(au);
+    const Bytes extradata = annexb(sps, {0x68, 0xee, 0x3c, 0x80});
+    EXPECT_EQ(check(extradata, au), SpsCheck::Match);
+
+    Bytes other = sps;
+    other[5] ^= 0x10;  // e.g. a different resolution
+    EXPECT_EQ(check(annexb(other, {0x68, 0xee, 0x3c, 0x80}), au), SpsCheck::Mismatch);
+}
+
+TEST(CodecCacheTest, AvcCExtradata) {
+    const Bytes au = keyframe();
+    const Bytes sps = sps_of(au);
+    Bytes avcc{1, sps[1], sps[2], sps[3], 0xff, 0xe1,
+               static_cast<uint8_t>(sps.size() >> 8), static_cast<uint8_t>(sps.size())};
+    avcc.insert(avcc.end(), sps.begin(), sps.end());
+    avcc.insert(avcc.end(), {1, 0, 4, 0x68, 0xee, 0x3c, 0x80});
+    EXPECT_EQ(check(avcc, au), SpsCheck::Match);
+}
+
+TEST(CodecCacheTest, HvcCExtradata) {
+    const Bytes sps{33 << 1, 1, 0x01, 0x60, 0x00, 0x42};
+    Bytes hvcc(22, 0);
+    hvcc[0] = 1;
+    hvcc.push_back(2);                          // arrays
+    hvcc.insert(hvcc.end(), {0x20, 0, 1, 0, 3, 0x40, 0x01, 0x0c});  // VPS
+    hvcc.insert(hvcc.end(), {0x21, 0, 1, 0, static_cast<uint8_t>(sps.size())});
+    hvcc.insert(hvcc.end(), sps.begin(), sps.end());
+    const Bytes pkt = annexb({0x40, 0x01, 0x0c}, sps);
+    EXPECT_EQ(check(hvcc, pkt, true), SpsCheck::Match);
+    Bytes changed = sps;
+    changed.back() = 0x43;
+    EXPECT_EQ(check(hvcc, annexb({0x40, 0x01, 0x0c}, changed), true), SpsCheck::Mismatch);
+}
+
+TEST(CodecCacheTest, NothingToCompare) {
+    const Bytes au = keyframe();
+    const Bytes idr_only{0, 0, 1, 0x65, 0x88, 0x80};
+    EXPECT_EQ(check(annexb(sps_of(au), {0x68}), idr_only), SpsCheck::NoSps);
+    EXPECT_EQ(check({}, au), SpsCheck::NoSps);
+    EXPECT_EQ(check({1, 2}, au), SpsCheck::NoSps);
+}
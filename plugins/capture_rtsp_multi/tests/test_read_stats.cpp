@@ -0,0 +1,44 @@
+// Unit tests for the capture read counters (read_stats.hpp); no FFmpeg needed.
+
+#include "read_stats.hpp"
+
+#include <gtest/gtest.h>
+
+TEST(ReadStatsTest, LatencyAverageAndMax) {
+    ReadStats rs;
+    EXPECT_EQ(rs.read_us_avg(), 0u);
+    rs.on_read(100);
+    rs.on_read(300);
+    EXPECT_EQ(rs.packets.load(), 2u);
+    EXPECT_EQ(rs.read_us_avg(), 200u);
+    EXPECT_EQ(rs.read_us_max.load(), 300u);
+}
+
+TEST(ReadStatsTest, SteadyArrivalHasNoJitter) {
+    ReadStats rs;
+    for (int i = 0; i < 50; ++i) rs.on_video_packet(1000 + i * 40000, i * 40000);
+    EXPECT_EQ(rs.jitter_us.load(), 0u);
+}
+
+TEST(ReadStatsTest, JitterTracksArrivalDeviation) {
+    ReadStats rs;
+    // Frames every 40 ms of pts, arriving alternately 10 ms early and late.
+    int64_t arrival = 0;
+    for (int i = 0; i < 200; ++i) {
+        arrival = i * 40000 + ((i % 2) ? 10000 : -10000);
+        rs.on_video_packet(arrival, i * 40000);
+    }
+    // |D| is 20 ms every frame, so J converges on 20000 us.
+    EXPECT_NEAR(static_cast<double>(rs.jitter_us.load()), 20000.0, 50.0);
+}
+
+TEST(ReadStatsTest, SlicesOfOneFrameAndReconnectsAreIgnored) {
+    ReadStats rs;
+    rs.on_video_packet(0, 0);
+    rs.on_video_packet(5000, 0);  // second slice, same pts: not a new frame
+    rs.on_video_packet(40000, 40000);
+    EXPECT_EQ(rs.jitter_us.load(), 0u);
+    rs.reset_timing();
+    rs.on_video_packet(9000000, 0);  // timestamps restart after reconnect
+    EXPECT_EQ(rs.jitter_us.load(), 0u);
+}
@@ -0,0 +1,395 @@
+// Tests for the epoll RTSP ingest: depacketizers and protocol helpers in
+// isolation, then RtspIngest against a local server stand-in streaming the
+// repo's H.264 test access unit.
+
+#include "rtp_depacketizer.hpp"
+#include "rtsp_ingest.hpp"
+#include "rtsp_protocol.hpp"
+#include "rtsp_standin.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using standin::Bytes;
+using namespace zm;
+
+namespace {
+
+struct Au {
+    Bytes data;
+    uint32_t ts;
+    bool key;
+};
+
+// Run `payloads` (one AU's worth) through a depacketizer starting at `seq`;
+// payload `lose` is skipped as if lost on the wire.
+template <typename Depay>
+std::vector<Au> depay(Depay& d, const std::vector<Bytes>& payloads, uint16_t seq, uint32_t ts,
+                      std::vector<Au>* sink = nullptr, size_t lose = SIZE_MAX) {
+    std::vector<Au> got;
+    auto& out = sink ? *sink : got;
+    for (size_t i = 0; i < payloads.size(); ++i, ++seq) {
+        if (i == lose) continue;
+        const Bytes pkt = standin::rtp_packet(96, i + 1 == payloads.size(), seq, ts, payloads[i]);
+        rtp::RtpPacket p;
+        EXPECT_TRUE(rtp::parse_rtp(pkt.data(), pkt.size(), p));
+        d.push(p, [&](const uint8_t* a, size_t n, uint32_t t, bool k) {
+            out.push_back({Bytes(a, a + n), t, k});
+        });
+    }
+    return got;
+}
+
+// The repo's H.264 test access unit (SPS, PPS, IDR) with 4-byte start codes,
+// the form the depacketizer emits.
+Bytes test_au() {
+    return standin::annexb(
+        standin::split_nals(standin::read_file(std::string(TEST_DATA_DIR) + "/packet.h264")));
+}
+
+// A small non-IDR access unit with a recognizable body.
+Bytes p_frame(int i) {
+    Bytes nal{0x41};
+    for (int k = 0; k < 300 + 97 * i; ++k) nal.push_back(static_cast<uint8_t>(k * 7 + i));
+    return standin::annexb({nal});
+}
+
+}  // namespace
+
+TEST(RtpDepacketizerTest, ParsesHeaderExtensionAndPadding) {
+    Bytes pkt = standin::rtp_packet(96, true, 7, 1234, {1, 2, 3, 4, 5});
+    pkt[0] |= 0x10 | 0x20 | 0x01;  // extension, padding, one CSRC
+    Bytes with{pkt.begin(), pkt.begin() + 12};
+    with.insert(with.end(), {0, 0, 0, 9});               // CSRC
+    with.insert(with.end(), {0xbe, 0xde, 0, 1, 1, 2, 3, 4});  // one-word extension
+    with.insert(with.end(), pkt.begin() + 12, pkt.end());
+    with.insert(with.end(), {0, 0, 3});                  // 3 bytes of padding
+    rtp::RtpPacket p;
+    ASSERT_TRUE(rtp::parse_rtp(with.data(), with.size(), p));
+    EXPECT_TRUE(p.marker);
+    EXPECT_EQ(p.seq, 7);
+    EXPECT_EQ(p.timestamp, 1234u);
+    ASSERT_EQ(p.size, 5u);
+    EXPECT_EQ(p.payload[4], 5);
+    EXPECT_FALSE(rtp::parse_rtp(with.data(), 11, p));
+}
+
+TEST(RtpDepacketizerTest, H264FragmentedAndAggregatedRoundTrip) {
+    const Bytes au = test_au();
+    ASSERT_GT(au.size(), 100000u);
+    const auto payloads = standin::packetize_h264(au);
+    ASSERT_GT(payloads.size(), 100u);
+    EXPECT_EQ(payloads[0][0] & 0x1f, 24);  // SPS+PPS as STAP-A
+    EXPECT_EQ(payloads[1][0] & 0x1f, 28);  // IDR as FU-A
+
+    rtp::H26xDepacketizer d;
+    const auto got = depay(d, payloads, 0xfff0, 90000);  // seq wraps mid-AU
+    ASSERT_EQ(got.size(), 1u);
+    EXPECT_EQ(got[0].data, au);
+    EXPECT_TRUE(got[0].key);
+    EXPECT_EQ(got[0].ts, 90000u);
+    EXPECT_EQ(d.dropped(), 0u);
+}
+
+TEST(RtpDepacketizerTest, LossDropsOnlyTheDamagedAccessUnit) {
+    rtp::H26xDepacketizer d;
+    const auto payloads = standin::packetize_h264(test_au());
+    std::vector<Au> got;
+    uint16_t seq = 100;
+    // AU 1 loses a middle fragment.
+    depay(d, payloads, seq, 0, &got, 10);
+    seq = static_cast<uint16_t>(seq + payloads.size());
+    // AU 2 is complete.
+    depay(d, standin::packetize_h264(p_frame(1)), seq, 3000, &got);
+    ASSERT_EQ(got.size(), 1u);
+    EXPECT_EQ(got[0].data, p_frame(1));
+    EXPECT_FALSE(got[0].key);
+    EXPECT_EQ(d.dropped(), 1u);
+}
+
+TEST(RtpDepacketizerTest, PrependsOutOfBandParameterSetsToBareKeyframes) {
+    const auto nals = standin::split_nals(test_au());
+    ASSERT_EQ(nals.size(), 3u);
+    rtp::H26xDepacketizer d;
+    d.set_parameter_sets(standin::annexb({nals[0], nals[1]}));
+    const auto got = depay(d, standin::packetize_h264(standin::annexb({nals[2]})), 1, 0);
+    ASSERT_EQ(got.size(), 1u);
+    EXPECT_EQ(got[0].data, test_au());
+}
+
+TEST(RtpDepacketizerTest, H265FragmentationUnits) {
+    // IDR_W_RADL (19) split into three FUs, preceded by an AP with VPS+SPS.
+    Bytes idr{19 << 1, 1};
+    for (int i = 0; i < 3000; ++i) idr.push_back(static_cast<uint8_t>(i));
+    const Bytes vps{32 << 1, 1, 0xaa}, sps{33 << 1, 1, 0xbb};
+    std::vector<Bytes> payloads;
+    Bytes ap{48 << 1, 1};
+    for (const Bytes* n : {&vps, &sps}) {
+        ap.push_back(0);
+        ap.push_back(static_cast<uint8_t>(n->size()));
+        ap.insert(ap.end(), n->begin(), n->end());
+    }
+    payloads.push_back(ap);
+    for (size_t off = 2; off < idr.size(); off += 1000) {
+        const size_t n = std::min<size_t>(1000, idr.size() - off);
+        Bytes fu{49 << 1, 1,
+                 static_cast<uint8_t>((off == 2 ? 0x80 : 0) | (off + n == idr.size() ? 0x40 : 0) | 19)};
+        fu.insert(fu.end(), idr.begin() + off, idr.begin() + off + n);
+        payloads.push_back(fu);
+    }
+    rtp::H26xDepacketizer d(true);
+    const auto got = depay(d, payloads, 5, 42);
+    ASSERT_EQ(got.size(), 1u);
+    EXPECT_EQ(got[0].data, standin::annexb({vps, sps, idr}));
+    EXPECT_TRUE(got[0].key);
+}
+
+TEST(RtpDepacketizerTest, AacMultipleAndFragmentedUnits) {
+    rtp::AacDepacketizer d;
+    std::vector<Au> got;
+    auto emit = [&](const uint8_t* a, size_t n, uint32_t t, bool) { got.push_back({Bytes(a, a + n), t, true}); };
+    // Two AUs (5 and 3 bytes) in one packet.
+    Bytes two{0, 32, 0, 5 << 3, 0, 3 << 3, 1, 2, 3, 4, 5, 6, 7, 8};
+    Bytes pkt = standin::rtp_packet(97, true, 1, 1000, two);
+    rtp::RtpPacket p;
+    ASSERT_TRUE(rtp::parse_rtp(pkt.data(), pkt.size(), p));
+    d.push(p, emit);
+    ASSERT_EQ(got.size(), 2u);
+    EXPECT_EQ(got[1].data, (Bytes{6, 7, 8}));
+    EXPECT_EQ(got[1].ts, 1000u + 1024u);
+    // One 10-byte AU over two packets.
+    got.clear();
+    Bytes a{0, 16, 0, 10 << 3, 1, 2, 3, 4, 5, 6}, b{0, 16, 0, 10 << 3, 7, 8, 9, 10};
+    pkt = standin::rtp_packet(97, false, 2, 3048, a);
+    ASSERT_TRUE(rtp::parse_rtp(pkt.data(), pkt.size(), p));
+    d.push(p, emit);
+    EXPECT_TRUE(got.empty());
+    pkt = standin::rtp_packet(97, true, 3, 3048, b);
+    ASSERT_TRUE(rtp::parse_rtp(pkt.data(), pkt.size(), p));
+    d.push(p, emit);
+    ASSERT_EQ(got.size(), 1u);
+    EXPECT_EQ(got[0].data, (Bytes{1, 2, 3, 4, 5, 6, 7, 8, 9, 10}));
+}
+
+TEST(RtspProtocolTest, UrlAndResponseParsing) {
+    rtsp::Url u;
+    ASSERT_TRUE(rtsp::parse_url("rtsp://admin:p@ss@10.0.0.5:8554/live/main?x=1", u));
+    EXPECT_EQ(u.user, "admin");
+    EXPECT_EQ(u.password, "p@ss");
+    EXPECT_EQ(u.host, "10.0.0.5");
+    EXPECT_EQ(u.port, 8554);
+    EXPECT_EQ(u.request, "rtsp://10.0.0.5:8554/live/main?x=1");
+    EXPECT_FALSE(rtsp::parse_url("http://x/y", u));
+
+    const std::string resp =
+        "RTSP/1.0 200 OK\r\nCSeq: 2\r\nContent-Length: 4\r\nSession: abc;timeout=30\r\n\r\nbodyRTSP/";
+    rtsp::Response r;
+    EXPECT_EQ(rtsp::parse_response(resp.data(), 20, r), 0);  // incomplete
+    ASSERT_EQ(rtsp::parse_response(resp.data(), resp.size(), r),
+              static_cast<long>(resp.size() - 5));
+    EXPECT_EQ(r.status, 200);
+    EXPECT_EQ(r.body, "body");
+    int timeout = 0;
+    EXPECT_EQ(rtsp::session_id(r.header("session"), &timeout), "abc");
+    EXPECT_EQ(timeout, 30);
+}
+
+TEST(RtspProtocolTest, SdpTracksAndParameterSets) {
+    const std::string sdp =
+        "v=0\r\na=control:*\r\n"
+        "m=video 0 RTP/AVP 96\r\na=rtpmap:96 H264/90000\r\n"
+        "a=fmtp:96 packetization-mode=1; sprop-parameter-sets=Z0IAH5WoFAFuQA==,aM48gA==\r\n"
+        "a=control:trackID=0\r\n"
+        "m=audio 0 RTP/AVP 97\r\na=rtpmap:97 MPEG4-GENERIC/16000/1\r\n"
+        "a=fmtp:97 config=1408;SizeLength=13\r\na=control:rtsp://other/audio\r\n";
+    const auto tracks = rtsp::parse_sdp(sdp, "rtsp://cam/stream/");
+    ASSERT_EQ(tracks.size(), 2u);
+    EXPECT_EQ(tracks[0].codec, rtsp::Codec::H264);
+    EXPECT_EQ(tracks[0].control, "rtsp://cam/stream/trackID=0");
+    const auto ps = rtsp::parameter_sets_annexb(tracks[0]);
+    ASSERT_EQ(standin::split_nals(ps).size(), 2u);
+    EXPECT_EQ(standin::split_nals(ps)[0][0] & 0x1f, 7);
+    EXPECT_EQ(tracks[1].codec, rtsp::Codec::AAC);
+    EXPECT_EQ(tracks[1].clock_rate, 16000);
+    EXPECT_EQ(tracks[1].control, "rtsp://other/audio");
+    EXPECT_EQ(rtsp::aac_config(tracks[1]), (Bytes{0x14, 0x08}));
+    EXPECT_EQ(tracks[1].param("sizelength"), "13");
+}
+
+TEST(RtspProtocolTest, DigestAuthorization) {
+    EXPECT_EQ(rtsp::md5_hex(""), "d41d8cd98f00b204e9800998ecf8427e");
+    EXPECT_EQ(rtsp::md5_hex("The quick brown fox jumps over the lazy dog"),
+              "9e107d9d372bb6826bd81d3542a419d6");
+    rtsp::Auth a;
+    a.user = "Mufasa";
+    a.password = "Circle Of Life";
+    ASSERT_TRUE(a.challenge("Digest realm=\"testrealm@host.com\", nonce=\"dcd98b7102dd2f0e8b11d0f600bfb0c093\""));
+    // RFC 2617 section 3.5 without qop: response = MD5(HA1:nonce:HA2).
+    const std::string ha1 = rtsp::md5_hex("Mufasa:testrealm@host.com:Circle Of Life");
+    const std::string ha2 = rtsp::md5_hex("GET:/dir/index.html");
+    EXPECT_NE(a.authorization("GET", "/dir/index.html")
+                  .find("response=\"" + rtsp::md5_hex(ha1 + ":dcd98b7102dd2f0e8b11d0f600bfb0c093:" + ha2) + "\""),
+              std::string::npos);
+    rtsp::Auth b;
+    b.user = "u";
+    b.password = "p";
+    ASSERT_TRUE(b.challenge("Basic realm=\"x\""));
+    EXPECT_EQ(b.authorization("DESCRIBE", "rtsp://x"), "Basic dTpw");
+}
+
+namespace {
+
+// Collects everything RtspIngest reports, per stream.
+struct Sink {
+    std::mutex mu;
+    std::condition_variable cv;
+    std::map<uint32_t, std::vector<Au>> video, audio;
+    std::map<uint32_t, std::vector<int64_t>> pts;
+    std::map<uint32_t, rtsp::SdpTrack> connected;
+    std::map<uint32_t, bool> had_audio;
+    std::vector<std::string> errors;
+
+    rtsp::IngestCallbacks callbacks() {
+        rtsp::IngestCallbacks cb;
+        cb.on_connected = [this](uint32_t id, const rtsp::SdpTrack& v, const rtsp::SdpTrack* a) {
+            std::lock_guard<std::mutex> lk(mu);
+            connected[id] = v;
+            had_audio[id] = a != nullptr;
+        };
+        cb.on_frame = [this](uint32_t id, const rtsp::IngestFrame& f) {
+            std::lock_guard<std::mutex> lk(mu);
+            (f.audio ? audio : video)[id].push_back({Bytes(f.data, f.data + f.size), 0, f.keyframe});
+            if (!f.audio) pts[id].push_back(f.pts_usec);
+            cv.notify_all();
+        };
+        cb.log = [this](uint32_t, int level, const std::string& msg) {
+            std::lock_guard<std::mutex> lk(mu);
+            if (level >= 3) errors.push_back(msg);
+            cv.notify_all();
+        };
+        return cb;
+    }
+
+    bool wait_video(uint32_t id, size_t n) {
+        std::unique_lock<std::mutex> lk(mu);
+        return cv.wait_for(lk, std::chrono::seconds(10), [&] { return video[id].size() >= n; });
+    }
+};
+
+std::unique_ptr<standin::Server> make_server(bool with_audio) {
+    auto srv = std::make_unique<standin::Server>();
+    srv->video.push_back(test_au());
+    for (int i = 1; i < 8; ++i) srv->video.push_back(p_frame(i));
+    if (with_audio)
+        for (int i = 0; i < 8; ++i) srv->audio.push_back(Bytes(20 + i, static_cast<uint8_t>(i)));
+    return srv;
+}
+
+void expect_stream(Sink& sink, const standin::Server& srv, uint32_t id, bool with_audio) {
+    ASSERT_TRUE(sink.wait_video(id, srv.video.size())) << "stream " << id;
+    std::unique_lock<std::mutex> lk(sink.mu);
+    const auto& got = sink.video[id];
+    ASSERT_EQ(got.size(), srv.video.size());
+    for (size_t i = 0; i < got.size(); ++i) {
+        EXPECT_EQ(got[i].data, srv.video[i]) << "AU " << i;
+        EXPECT_EQ(got[i].key, i == 0);
+        // 3000 ticks of 90 kHz across the 32-bit timestamp wrap.
+        EXPECT_EQ(sink.pts[id][i], static_cast<int64_t>(i) * 3000 * 1000000 / 90000) << "AU " << i;
+    }
+    EXPECT_EQ(sink.connected[id].codec, rtsp::Codec::H264);
+    EXPECT_EQ(sink.had_audio[id], with_audio);
+    if (with_audio) {
+        // Audio trails the last video AU on the wire; allow it to land.
+        sink.cv.wait_for(lk, std::chrono::seconds(2),
+                         [&] { return sink.audio[id].size() >= srv.audio.size(); });
+        ASSERT_EQ(sink.audio[id].size(), srv.audio.size());
+        EXPECT_EQ(sink.audio[id][3].data, srv.audio[3]);
+    }
+}
+
+}  // namespace
+
+TEST(RtspIngestTest, ManyInterleavedSessionsOnOneReactor) {
+    auto srv = make_server(true);
+    ASSERT_TRUE(srv->start());
+    Sink sink;
+    rtsp::RtspIngest ingest(sink.callbacks());
+    for (uint32_t id = 1; id <= 6; ++id) {
+        rtsp::IngestStream s;
+        s.stream_id = id;
+        s.url = srv->url("cam");
+        s.forward_audio = id % 2 == 0;
+        ASSERT_TRUE(ingest.add(s));
+    }
+    ASSERT_TRUE(ingest.start());
+    for (uint32_t id = 1; id <= 6; ++id) expect_stream(sink, *srv, id, id % 2 == 0);
+    ingest.stop();
+    EXPECT_EQ(srv->plays(), 6);
+    for (int i = 0; i < 100 && srv->teardowns() < 6; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(srv->teardowns(), 6);
+    EXPECT_TRUE(sink.errors.empty());
+}
+
+TEST(RtspIngestTest, UdpTransport) {
+    auto srv = make_server(true);
+    ASSERT_TRUE(srv->start());
+    Sink sink;
+    rtsp::RtspIngest ingest(sink.callbacks());
+    for (uint32_t id = 1; id <= 2; ++id) {
+        rtsp::IngestStream s;
+        s.stream_id = id;
+        s.url = srv->url("cam");
+        s.transport = "udp";
+        ASSERT_TRUE(ingest.add(s));
+    }
+    ASSERT_TRUE(ingest.start());
+    expect_stream(sink, *srv, 1, true);
+    expect_stream(sink, *srv, 2, true);
+}
+
+TEST(RtspIngestTest, DigestAuthentication) {
+    auto srv = make_server(false);
+    srv->user = "viewer";
+    srv->password = "s3cret";
+    ASSERT_TRUE(srv->start());
+    Sink sink;
+    rtsp::RtspIngest ingest(sink.callbacks());
+    rtsp::IngestStream s;
+    s.stream_id = 9;
+    s.url = srv->url("cam", true);
+    ASSERT_TRUE(ingest.add(s));
+    ASSERT_TRUE(ingest.start());
+    expect_stream(sink, *srv, 9, false);
+    EXPECT_EQ(srv->unauthorized(), 1);  // only the first, unauthenticated DESCRIBE
+}
+
+TEST(RtspIngestTest, RefusedConnectionStopsAfterMaxRetries) {
+    // Grab a free port and release it so nothing is listening there.
+    standin::Server probe;
+    probe.video.push_back(test_au());
+    ASSERT_TRUE(probe.start());
+    const std::string url = probe.url("cam");
+    probe.stop();
+
+    Sink sink;
+    rtsp::RtspIngest ingest(sink.callbacks());
+    EXPECT_FALSE(ingest.add(rtsp::IngestStream{}));  // no URL
+    sink.errors.clear();
+    rtsp::IngestStream s;
+    s.stream_id = 3;
+    s.url = url;
+    s.max_retry_attempts = 1;
+    ASSERT_TRUE(ingest.add(s));
+    ASSERT_TRUE(ingest.start());
+    std::unique_lock<std::mutex> lk(sink.mu);
+    ASSERT_TRUE(sink.cv.wait_for(lk, std::chrono::seconds(5), [&] { return !sink.errors.empty(); }));
+    EXPECT_NE(sink.errors[0].find("max retry"), std::string::npos) << sink.errors[0];
+    EXPECT_TRUE(sink.video.empty());
+}
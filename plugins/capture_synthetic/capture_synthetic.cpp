@@ -0,0 +1,531 @@
+// capture_synthetic - ZM_PLUGIN_INPUT that generates its own video: a scripted
+// scene (moving blobs, scene changes, rain, sensor noise; synthetic_scene.hpp)
+// at a configured resolution, frame rate and bitrate, with no media file and
+// no disk I/O. A load generator for the capture -> ring -> stage paths and the
+// motion stages, and a camera-free, clip-free sibling of capture_file.
+//
+// Compressed mode ("codec": "h264", ...) renders and encodes one motion cycle
+// in memory at start and replays its packets in a loop (the scene is periodic
+// over the cycle, and the cycle starts on a keyframe), so the emit rate is not
+// limited by the encoder even at 8K. Raw mode ("codec": "raw") renders every
+// frame live in `output_format`, the layouts decode_ffmpeg emits. Frames are
+// paced to `fps` (`realtime`) or emitted as fast as possible.
+//
+// Honours the host's "rate_control" message (zm_plugin_control): only 1 of
+// every keep_every keyframe-led segments is emitted, i.e. 1 in keep_every
+// frames in raw mode and 1 in keep_every GOPs in compressed mode, on the same
+// timeline, so a decimated stream stays decodable.
+
+#include "zm_plugin.h"
+#include "synthetic_scene.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+#include <libavutil/base64.h>
+#include <libavutil/error.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/opt.h>
+}
+
+namespace {
+
+using zm::synthetic::PixFmt;
+
+// The host's capture ring holds frames of up to 1 MiB (header included);
+// larger frames are rejected there.
+constexpr size_t kRingSlotBytes = 1024 * 1024;
+
+// One packet of the pre-encoded cycle, stored as the buffer handed to the
+// host ([zm_frame_hdr_t][packet]); only the header is rewritten per emit.
+struct EncodedPacket {
+    std::vector<uint8_t> buf;
+    bool key = false;
+
+    size_t bytes() const { return buf.size() - sizeof(zm_frame_hdr_t); }
+};
+
+struct SyntheticContext {
+    zm_host_api_t* host_api = nullptr;
+    void* host_ctx = nullptr;
+
+    // Configuration.
+    uint32_t stream_id = 0;
+    int width = 1280;
+    int height = 720;
+    int fps = 30;
+    std::string codec = "h264";     // FFmpeg codec name, or "raw"
+    std::string encoder;            // explicit FFmpeg encoder name (overrides codec)
+    std::string preset = "ultrafast";
+    int64_t bitrate = 4000000;
+    int gop = 0;                    // 0 => fps
+    int cycle_frames = 0;           // 0 => 4 s of frames, rounded up to whole GOPs
+    PixFmt raw_format = PixFmt::YUV420P;
+    bool realtime = true;
+    uint64_t max_frames = 0;        // 0 => endless
+    zm::synthetic::SceneConfig scene_cfg;
+
+    std::vector<EncodedPacket> cycle;            // compressed mode
+    std::optional<zm::synthetic::Scene> scene;   // raw mode
+    std::vector<uint8_t> raw_buf;                // raw mode: [zm_frame_hdr_t][pixels]
+
+    std::thread worker;
+    std::atomic<bool> running{false};
+    std::atomic<int> keep_every{1};  // host rate_control request
+    uint64_t frames_emitted = 0;
+    uint64_t frames_shed = 0;        // skipped on rate_control requests
+
+    bool raw() const { return codec == "raw"; }
+
+    void log(zm_log_level_t level, const char* fmt, ...) {
+        if (!host_api || !host_api->log) return;
+        char buf[1024];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(buf, sizeof(buf), fmt, args);
+        va_end(args);
+        host_api->log(host_ctx, level, buf);
+    }
+};
+
+std::string av_error(int err) {
+    char buf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(err, buf, sizeof(buf));
+    return buf;
+}
+
+uint32_t raw_frame_type(PixFmt f) {
+    switch (f) {
+        case PixFmt::RGB24: return ZM_FRAME_RGB24;
+        case PixFmt::GRAY8: return ZM_FRAME_GRAYSCALE;
+        case PixFmt::YUV420P: break;
+    }
+    return ZM_FRAME_YUV420P;
+}
+
+AVPixelFormat raw_av_pix_fmt(PixFmt f) {
+    switch (f) {
+        case PixFmt::RGB24: return AV_PIX_FMT_RGB24;
+        case PixFmt::GRAY8: return AV_PIX_FMT_GRAY8;
+        case PixFmt::YUV420P: break;
+    }
+    return AV_PIX_FMT_YUV420P;
+}
+
+// StreamMetadata handshake (same shape as capture_file / capture_rtsp_multi).
+void publish_stream_metadata(SyntheticContext* ctx, const AVCodecContext* enc) {
+    if (!ctx->host_api || !ctx->host_api->publish_evt) return;
+    std::string extradata_b64;
+    if (enc && enc->extradata && enc->extradata_size > 0) {
+        int b64len = 4 * ((enc->extradata_size + 2) / 3) + 1;
+        std::vector<char> b64buf(b64len);
+        av_base64_encode(b64buf.data(), b64len, enc->extradata, enc->extradata_size);
+        extradata_b64 = std::string(b64buf.data());
+    }
+    nlohmann::json meta = {
+        {"event", "StreamMetadata"},
+        {"media", "video"},
+        {"stream_id", ctx->stream_id},
+        {"codec_id", static_cast<int>(enc ? enc->codec_id : AV_CODEC_ID_RAWVIDEO)},
+        {"width", ctx->width},
+        {"height", ctx->height},
+        {"pix_fmt", static_cast<int>(enc ? enc->pix_fmt : raw_av_pix_fmt(ctx->raw_format))},
+        {"profile", enc ? enc->profile : 0},
+        {"level", enc ? enc->level : 0},
+        {"sample_rate", 0},
+        {"channels", 0},
+        {"extradata", extradata_b64},
+    };
+    ctx->host_api->publish_evt(ctx->host_ctx, meta.dump().c_str());
+}
+
+// Pulls every pending packet out of the encoder into the cycle.
+int drain_encoder(SyntheticContext* ctx, AVCodecContext* enc, AVPacket* pkt) {
+    for (;;) {
+        int ret = avcodec_receive_packet(enc, pkt);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) return 0;
+        if (ret < 0) return ret;
+        EncodedPacket p;
+        p.buf.resize(sizeof(zm_frame_hdr_t) + static_cast<size_t>(pkt->size));
+        std::memcpy(p.buf.data() + sizeof(zm_frame_hdr_t), pkt->data, static_cast<size_t>(pkt->size));
+        p.key = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
+        ctx->cycle.push_back(std::move(p));
+        av_packet_unref(pkt);
+    }
+}
+
+// Renders and encodes one motion cycle into ctx->cycle, then publishes the
+// stream metadata. No B-frames, so packets come out in display order.
+bool encode_cycle(SyntheticContext* ctx) {
+    const AVCodec* codec = nullptr;
+    if (!ctx->encoder.empty()) {
+        codec = avcodec_find_encoder_by_name(ctx->encoder.c_str());
+    } else if (const AVCodecDescriptor* d = avcodec_descriptor_get_by_name(ctx->codec.c_str())) {
+        codec = avcodec_find_encoder(d->id);
+    }
+    if (!codec) {
+        ctx->log(ZM_LOG_ERROR, "capture_synthetic: no encoder for codec '%s' (encoder '%s')",
+                 ctx->codec.c_str(), ctx->encoder.c_str());
+        return false;
+    }
+
+    AVCodecContext* enc = avcodec_alloc_context3(codec);
+    AVFrame* frame = av_frame_alloc();
+    AVPacket* pkt = av_packet_alloc();
+    bool ok = false;
+    if (!enc || !frame || !pkt) {
+        ctx->log(ZM_LOG_ERROR, "capture_synthetic: out of memory");
+    } else {
+        enc->width = ctx->width;
+        enc->height = ctx->height;
+        // mjpeg only takes full-range planar 4:2:0; same memory layout.
+        enc->pix_fmt = codec->id == AV_CODEC_ID_MJPEG ? AV_PIX_FMT_YUVJ420P : AV_PIX_FMT_YUV420P;
+        enc->time_base = AVRational{1, ctx->fps};
+        enc->framerate = AVRational{ctx->fps, 1};
+        enc->bit_rate = ctx->bitrate;
+        enc->gop_size = ctx->gop;
+        enc->max_b_frames = 0;
+        enc->thread_count = 0;
+        // Emit global headers (extradata) so a downstream store/muxer can use them.
+        enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+        if (codec->name && std::string(codec->name) == "libx264") {
+            av_opt_set(enc->priv_data, "preset", ctx->preset.c_str(), 0);
+            av_opt_set(enc->priv_data, "tune", "zerolatency", 0);
+        }
+        int ret = avcodec_open2(enc, codec, nullptr);
+        if (ret < 0) {
+            ctx->log(ZM_LOG_ERROR, "capture_synthetic: failed to open encoder %s: %s",
+                     codec->name, av_error(ret).c_str());
+        } else {
+            const zm::synthetic::Scene scene(ctx->scene_cfg);
+            std::vector<uint8_t> pixels(
+                zm::synthetic::frame_bytes(PixFmt::YUV420P, ctx->width, ctx->height));
+            frame->width = ctx->width;
+            frame->height = ctx->height;
+            frame->format = enc->pix_fmt;
+            av_image_fill_arrays(frame->data, frame->linesize, pixels.data(), enc->pix_fmt,
+                                 ctx->width, ctx->height, 1);
+            const auto t0 = std::chrono::steady_clock::now();
+            ret = 0;
+            for (int i = 0; i < ctx->cycle_frames && ret >= 0 && ctx->running.load(); ++i) {
+                scene.render(static_cast<uint64_t>(i), PixFmt::YUV420P, pixels.data());
+                frame->pts = i;
+                ret = avcodec_send_frame(enc, frame);
+                if (ret >= 0) ret = drain_encoder(ctx, enc, pkt);
+            }
+            if (ret >= 0) ret = avcodec_send_frame(enc, nullptr);
+            if (ret >= 0) ret = drain_encoder(ctx, enc, pkt);
+            const double secs =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            if (ret < 0) {
+                ctx->log(ZM_LOG_ERROR, "capture_synthetic: encoding failed: %s",
+                         av_error(ret).c_str());
+            } else if (ctx->cycle.empty() || !ctx->cycle.front().key) {
+                ctx->log(ZM_LOG_ERROR, "capture_synthetic: encoder produced no leading keyframe");
+            } else {
+                size_t bytes = 0, biggest = 0;
+                for (const auto& p : ctx->cycle) {
+                    bytes += p.bytes();
+                    biggest = std::max(biggest, p.bytes());
+                }
+                ctx->log(ZM_LOG_INFO,
+                         "capture_synthetic: encoded %zu-frame cycle with %s in %.1f s "
+                         "(%.0f kbit/s, largest packet %zu bytes)",
+                         ctx->cycle.size(), codec->name, secs,
+                         bytes * 8.0 * ctx->fps / static_cast<double>(ctx->cycle.size()) / 1000.0,
+                         biggest);
+                if (biggest + sizeof(zm_frame_hdr_t) > kRingSlotBytes)
+                    ctx->log(ZM_LOG_WARN,
+                             "capture_synthetic: packets over %zu bytes will be rejected by the "
+                             "host ring; lower the bitrate",
+                             kRingSlotBytes - sizeof(zm_frame_hdr_t));
+                publish_stream_metadata(ctx, enc);
+                ok = true;
+            }
+        }
+    }
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    avcodec_free_context(&enc);
+    return ok;
+}
+
+bool is_key(const SyntheticContext* ctx, uint64_t n) {
+    return ctx->raw() || ctx->cycle[n % ctx->cycle.size()].key;
+}
+
+void emit(SyntheticContext* ctx, uint64_t n) {
+    if (!ctx->host_api || !ctx->host_api->on_frame) return;
+    zm_frame_hdr_t hdr = {};
+    hdr.stream_id = ctx->stream_id;
+    hdr.pts_usec = n * 1000000ull / static_cast<uint64_t>(ctx->fps);
+    if (ctx->raw()) {
+        uint8_t* pixels = ctx->raw_buf.data() + sizeof(zm_frame_hdr_t);
+        ctx->scene->render(n, ctx->raw_format, pixels);
+        hdr.hw_type = raw_frame_type(ctx->raw_format);
+        hdr.handle = reinterpret_cast<uint64_t>(pixels);
+        hdr.bytes = static_cast<uint32_t>(ctx->raw_buf.size() - sizeof(zm_frame_hdr_t));
+        hdr.flags = ZM_FRAME_FLAG_KEYFRAME;
+        std::memcpy(ctx->raw_buf.data(), &hdr, sizeof(hdr));
+        ctx->host_api->on_frame(ctx->host_ctx, ctx->raw_buf.data(), ctx->raw_buf.size());
+    } else {
+        EncodedPacket& p = ctx->cycle[n % ctx->cycle.size()];
+        hdr.hw_type = ZM_FRAME_COMPRESSED;
+        hdr.handle = reinterpret_cast<uint64_t>(p.buf.data() + sizeof(zm_frame_hdr_t));
+        hdr.bytes = static_cast<uint32_t>(p.bytes());
+        hdr.flags = p.key ? ZM_FRAME_FLAG_KEYFRAME : 0u;
+        std::memcpy(p.buf.data(), &hdr, sizeof(hdr));
+        ctx->host_api->on_frame(ctx->host_ctx, p.buf.data(), p.buf.size());
+    }
+    ctx->frames_emitted++;
+}
+
+void generate_loop(SyntheticContext* ctx) {
+    if (!ctx->raw() && !encode_cycle(ctx)) {
+        if (ctx->host_api && ctx->host_api->publish_evt) {
+            nlohmann::json ev = {
+                {"type", "connection_failed"},
+                {"stream_id", ctx->stream_id},
+                {"message", "capture_synthetic: cannot encode " + ctx->codec},
+            };
+            ctx->host_api->publish_evt(ctx->host_ctx, ev.dump().c_str());
+        }
+        return;
+    }
+    if (ctx->raw()) {
+        ctx->scene.emplace(ctx->scene_cfg);
+        publish_stream_metadata(ctx, nullptr);
+    }
+
+    ctx->log(ZM_LOG_INFO, "capture_synthetic: generating stream %u (realtime=%s)", ctx->stream_id,
+             ctx->realtime ? "true" : "false");
+    const auto origin = std::chrono::steady_clock::now();
+    const auto t0 = origin;
+    uint64_t segments = 0;
+    bool emitting = true;
+    for (uint64_t n = 0; ctx->running.load(); ++n) {
+        if (ctx->max_frames && n >= ctx->max_frames) {
+            ctx->log(ZM_LOG_INFO, "capture_synthetic: stream %u: %llu frames emitted, stopping",
+                     ctx->stream_id, static_cast<unsigned long long>(n));
+            break;
+        }
+        // Decimation starts and ends on keyframes only.
+        if (is_key(ctx, n)) {
+            const int keep = ctx->keep_every.load(std::memory_order_relaxed);
+            emitting = segments++ % static_cast<uint64_t>(keep) == 0;
+        }
+        if (!emitting) {
+            ctx->frames_shed++;
+            continue;
+        }
+        if (ctx->realtime) {
+            // Pace to the absolute schedule so sleep jitter does not accumulate.
+            const auto due = origin + std::chrono::microseconds(n * 1000000ull /
+                                                                static_cast<uint64_t>(ctx->fps));
+            while (ctx->running.load()) {
+                const auto now = std::chrono::steady_clock::now();
+                if (now >= due) break;
+                std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                    due - now, std::chrono::milliseconds(50)));
+            }
+            if (!ctx->running.load()) break;
+        }
+        emit(ctx, n);
+        if (ctx->frames_emitted % 1000 == 0) {
+            const double secs =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            ctx->log(ZM_LOG_DEBUG, "capture_synthetic: stream %u: %llu frames (%.1f fps)",
+                     ctx->stream_id, static_cast<unsigned long long>(ctx->frames_emitted),
+                     secs > 0 ? ctx->frames_emitted / secs : 0.0);
+        }
+    }
+    ctx->log(ZM_LOG_INFO, "capture_synthetic: stream %u ended (%llu frames emitted, %llu shed)",
+             ctx->stream_id, static_cast<unsigned long long>(ctx->frames_emitted),
+             static_cast<unsigned long long>(ctx->frames_shed));
+}
+
+bool parse_config(SyntheticContext* ctx, const char* json_cfg) {
+    try {
+        const nlohmann::json cfg = nlohmann::json::parse(json_cfg);
+        ctx->stream_id = cfg.value("stream_id", 0u);
+        ctx->width = cfg.value("width", ctx->width);
+        ctx->height = cfg.value("height", ctx->height);
+        ctx->fps = std::max(1, cfg.value("fps", ctx->fps));
+        ctx->codec = cfg.value("codec", ctx->codec);
+        ctx->encoder = cfg.value("encoder", ctx->encoder);
+        ctx->preset = cfg.value("preset", ctx->preset);
+        ctx->bitrate = cfg.value("bitrate", ctx->bitrate);
+        ctx->gop = cfg.value("gop", 0);
+        ctx->cycle_frames = cfg.value("cycle_frames", 0);
+        ctx->realtime = cfg.value("realtime", ctx->realtime);
+        ctx->max_frames = cfg.value("frames", uint64_t{0});
+
+        const std::string fmt = cfg.value("output_format", std::string("yuv420p"));
+        if (fmt == "rgb24") ctx->raw_format = PixFmt::RGB24;
+        else if (fmt == "gray" || fmt == "grayscale" || fmt == "gray8") ctx->raw_format = PixFmt::GRAY8;
+        else if (fmt == "yuv420p") ctx->raw_format = PixFmt::YUV420P;
+        else {
+            ctx->log(ZM_LOG_ERROR, "capture_synthetic: unknown output_format '%s'", fmt.c_str());
+            return false;
+        }
+
+        auto& s = ctx->scene_cfg;
+        s.seed = cfg.value("seed", s.seed);
+        s.blobs = cfg.value("blobs", s.blobs);
+        s.blob_size = cfg.value("blob_size", s.blob_size);
+        s.scene_change_every = cfg.value("scene_change_every", s.scene_change_every);
+        s.noise = cfg.value("noise", s.noise);
+        s.rain = cfg.value("rain", s.rain);
+    } catch (const std::exception& e) {
+        ctx->log(ZM_LOG_ERROR, "capture_synthetic: failed to parse config: %s", e.what());
+        return false;
+    }
+    if (ctx->width < 16 || ctx->height < 16 || ctx->width > 16384 || ctx->height > 16384) {
+        ctx->log(ZM_LOG_ERROR, "capture_synthetic: bad frame size %dx%d", ctx->width, ctx->height);
+        return false;
+    }
+    // Encoders want even dimensions for 4:2:0.
+    if (!ctx->raw()) {
+        ctx->width &= ~1;
+        ctx->height &= ~1;
+    }
+    if (ctx->gop <= 0) ctx->gop = ctx->fps;
+    if (ctx->cycle_frames <= 0) ctx->cycle_frames = 4 * ctx->fps;
+    ctx->cycle_frames = (ctx->cycle_frames + ctx->gop - 1) / ctx->gop * ctx->gop;
+    ctx->scene_cfg.width = ctx->width;
+    ctx->scene_cfg.height = ctx->height;
+    ctx->scene_cfg.period = ctx->cycle_frames;
+    return true;
+}
+
+}  // namespace
+
+// ----------------------------------------------------------------------------
+// Plugin lifecycle
+// ----------------------------------------------------------------------------
+
+static int capture_synthetic_start(zm_plugin_t* plugin, zm_host_api_t* host, void* host_ctx,
+                                   const char* json_cfg) {
+    if (!plugin || !host || !json_cfg) {
+        return -1;
+    }
+
+    zm_plugin_set_log_context(host, host_ctx);
+
+    auto* ctx = new SyntheticContext();
+    ctx->host_api = host;
+    ctx->host_ctx = host_ctx;
+    if (!parse_config(ctx, json_cfg)) {
+        delete ctx;
+        return -1;
+    }
+    plugin->instance = ctx;
+
+    if (ctx->raw()) {
+        const size_t bytes = zm::synthetic::frame_bytes(ctx->raw_format, ctx->width, ctx->height);
+        ctx->raw_buf.assign(sizeof(zm_frame_hdr_t) + bytes, 0);
+        if (ctx->raw_buf.size() > kRingSlotBytes)
+            ctx->log(ZM_LOG_WARN,
+                     "capture_synthetic: %dx%d raw frames (%zu bytes) exceed the host ring slot "
+                     "(%zu bytes) and will be rejected; use a compressed codec",
+                     ctx->width, ctx->height, bytes, kRingSlotBytes);
+    }
+
+    ctx->log(ZM_LOG_INFO,
+             "Starting capture_synthetic: %dx%d@%d codec=%s bitrate=%lld gop=%d cycle=%d "
+             "realtime=%s blobs=%d scene_change_every=%d noise=%d rain=%.1f",
+             ctx->width, ctx->height, ctx->fps, ctx->codec.c_str(),
+             static_cast<long long>(ctx->bitrate), ctx->gop, ctx->cycle_frames,
+             ctx->realtime ? "true" : "false", ctx->scene_cfg.blobs,
+             ctx->scene_cfg.scene_change_every, ctx->scene_cfg.noise, ctx->scene_cfg.rain);
+
+    // The cycle is encoded on the worker thread so start() returns promptly
+    // (an 8K cycle can take a while).
+    ctx->running.store(true);
+    ctx->worker = std::thread(generate_loop, ctx);
+    return 0;
+}
+
+static void capture_synthetic_stop(zm_plugin_t* plugin) {
+    if (!plugin || !plugin->instance) {
+        return;
+    }
+
+    auto* ctx = static_cast<SyntheticContext*>(plugin->instance);
+    ctx->running.store(false);
+    if (ctx->worker.joinable()) {
+        ctx->worker.join();
+    }
+    ctx->log(ZM_LOG_INFO, "capture_synthetic stopped");
+
+    delete ctx;
+    plugin->instance = nullptr;
+}
+
+static void capture_synthetic_on_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
+    // Input plugin: it produces frames, it does not receive them.
+    (void)plugin;
+    (void)buf;
+    (void)size;
+}
+
+// ----------------------------------------------------------------------------
+// Plugin entry point
+// ----------------------------------------------------------------------------
+
+extern "C" {
+
+// Host control messages (ZM_PLUGIN_CONTROL_SYMBOL); generate_loop applies a
+// new keep_every at the next keyframe.
+__attribute__((visibility("default")))
+void zm_plugin_control(zm_plugin_t* plugin, const char* json_msg) {
+    if (!plugin || !plugin->instance || !json_msg) {
+        return;
+    }
+    auto* ctx = static_cast<SyntheticContext*>(plugin->instance);
+    try {
+        const nlohmann::json msg = nlohmann::json::parse(json_msg);
+        if (msg.value("type", std::string()) != "rate_control") {
+            return;
+        }
+        const int keep = std::max(1, msg.value("keep_every", 1));
+        if (ctx->keep_every.exchange(keep, std::memory_order_relaxed) != keep) {
+            ctx->log(ZM_LOG_INFO, "capture_synthetic: stream %u: rate_control keep 1/%d (%s)",
+                     ctx->stream_id, keep, msg.value("reason", std::string("?")).c_str());
+        }
+    } catch (...) {
+        // ignore malformed messages
+    }
+}
+
+__attribute__((visibility("default")))
+void zm_plugin_init(zm_plugin_t* plugin) {
+    if (!plugin) {
+        return;
+    }
+
+    std::memset(plugin, 0, sizeof(zm_plugin_t));
+
+    plugin->version = ZM_PLUGIN_ABI_VERSION;
+    plugin->type = ZM_PLUGIN_INPUT;
+    plugin->start = capture_synthetic_start;
+    plugin->stop = capture_synthetic_stop;
+    plugin->on_frame = capture_synthetic_on_frame;
+    plugin->instance = nullptr;
+}
+
+}  // extern "C"
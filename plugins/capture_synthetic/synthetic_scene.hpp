@@ -0,0 +1,303 @@
+#pragma once
+// Scripted synthetic scene for capture_synthetic: a background that switches
+// pattern every N frames, moving elliptical blobs, falling rain streaks and
+// sensor noise, rendered straight into packed yuv420p / rgb24 / gray frames
+// (the layouts decode_ffmpeg emits). Every frame is a pure function of the
+// config and the frame index, and motion repeats exactly every `period`
+// frames so a pre-encoded cycle loops without a jump. No ABI / FFmpeg deps so
+// it can be unit-tested directly.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifdef ZMP_USE_SIMD
+#include <xsimd/xsimd.hpp>
+#endif
+
+namespace zm::synthetic {
+
+enum class PixFmt { YUV420P, RGB24, GRAY8 };
+
+// Packed frame size (no row padding), as av_image_get_buffer_size(.., 1).
+inline size_t frame_bytes(PixFmt fmt, int width, int height) {
+    const size_t w = static_cast<size_t>(width), h = static_cast<size_t>(height);
+    switch (fmt) {
+        case PixFmt::YUV420P: return w * h + 2 * ((w + 1) / 2) * ((h + 1) / 2);
+        case PixFmt::RGB24: return 3 * w * h;
+        case PixFmt::GRAY8: return w * h;
+    }
+    return 0;
+}
+
+struct SceneConfig {
+    int width = 1280;
+    int height = 720;
+    uint32_t seed = 1;
+    int blobs = 3;                // moving objects
+    float blob_size = 0.15f;      // mean blob diameter, fraction of the height
+    int period = 300;             // frames until the scene repeats exactly
+    int scene_change_every = 0;   // frames between background switches; 0 = never
+    int noise = 0;                // sensor noise amplitude (+/- levels); 0 = none
+    float rain = 0.0f;            // rain streaks per 100 px of width; 0 = none
+};
+
+struct Box {
+    int x, y, w, h;
+};
+
+class Scene {
+public:
+    explicit Scene(const SceneConfig& cfg) : cfg_(cfg) {
+        cfg_.width = std::max(cfg_.width, 2);
+        cfg_.height = std::max(cfg_.height, 2);
+        cfg_.period = std::max(cfg_.period, 1);
+        cfg_.noise = std::clamp(cfg_.noise, 0, 127);
+        uint64_t s = cfg_.seed;
+        const float H = static_cast<float>(cfg_.height), W = static_cast<float>(cfg_.width);
+        for (int i = 0; i < std::max(cfg_.blobs, 0); ++i) {
+            Blob b;
+            b.r = std::max(2.0f, cfg_.blob_size * H * 0.5f * (0.6f + 0.8f * unit(s)));
+            // Whole cycles per period keep the motion periodic.
+            b.fx = 1 + static_cast<int>(next(s) % 3);
+            b.fy = 1 + static_cast<int>(next(s) % 2);
+            b.px = 6.2831853f * unit(s);
+            b.py = 6.2831853f * unit(s);
+            b.ax = std::max(0.0f, W * 0.5f - b.r);
+            b.ay = std::max(0.0f, H * 0.5f - b.r);
+            b.color = Color{static_cast<uint8_t>(30 + next(s) % 200),
+                            static_cast<uint8_t>(48 + next(s) % 160),
+                            static_cast<uint8_t>(48 + next(s) % 160)};
+            blobs_.push_back(b);
+        }
+        const int drops = static_cast<int>(cfg_.rain * W / 100.0f);
+        for (int i = 0; i < drops; ++i) {
+            Drop d;
+            d.x = static_cast<int>(next(s) % static_cast<uint64_t>(cfg_.width));
+            d.y0 = static_cast<int>(next(s) % static_cast<uint64_t>(cfg_.height));
+            d.laps = 2 + static_cast<int>(next(s) % 5);
+            drops_.push_back(d);
+        }
+        if (cfg_.noise > 0) {
+            noise_up_.resize(kNoiseTile);
+            noise_down_.resize(kNoiseTile);
+            for (size_t i = 0; i < kNoiseTile; ++i) {
+                const int n = static_cast<int>(next(s) % (2 * cfg_.noise + 1)) - cfg_.noise;
+                noise_up_[i] = static_cast<uint8_t>(std::max(n, 0));
+                noise_down_[i] = static_cast<uint8_t>(std::max(-n, 0));
+            }
+        }
+    }
+
+    const SceneConfig& config() const { return cfg_; }
+
+    // Renders frame `index` into `dst` (frame_bytes(fmt, width, height) bytes).
+    void render(uint64_t index, PixFmt fmt, uint8_t* dst) const {
+        const Canvas c = canvas(fmt, dst);
+        const uint64_t t = index % static_cast<uint64_t>(cfg_.period);
+        draw_background(c, index);
+        for (const Blob& b : blobs_) {
+            float cx, cy;
+            center(b, t, cx, cy);
+            const float r2 = b.r * b.r;
+            const int y0 = std::max(0, static_cast<int>(std::ceil(cy - b.r)));
+            const int y1 = std::min(cfg_.height - 1, static_cast<int>(std::floor(cy + b.r)));
+            for (int y = y0; y <= y1; ++y) {
+                const float dy = static_cast<float>(y) - cy;
+                const float half = std::sqrt(std::max(0.0f, r2 - dy * dy));
+                const int x0 = std::max(0, static_cast<int>(std::ceil(cx - half)));
+                const int x1 = std::min(cfg_.width - 1, static_cast<int>(std::floor(cx + half)));
+                if (x0 <= x1) span(c, y, x0, x1 + 1, b.color);
+            }
+        }
+        if (!drops_.empty()) {
+            const int len = std::max(2, cfg_.height / 40);
+            const Color white{235, 128, 128};
+            for (const Drop& d : drops_) {
+                const uint64_t fall = t * static_cast<uint64_t>(cfg_.height) *
+                                      static_cast<uint64_t>(d.laps) /
+                                      static_cast<uint64_t>(cfg_.period);
+                const int top = static_cast<int>((static_cast<uint64_t>(d.y0) + fall) %
+                                                 static_cast<uint64_t>(cfg_.height));
+                for (int k = 0; k < len && top + k < cfg_.height; ++k)
+                    luma_dot(c, top + k, d.x, white);
+            }
+        }
+        if (!noise_up_.empty()) add_noise(c, index);
+    }
+
+    // Bounding boxes of the blobs in frame `index`, clipped to the frame
+    // (ground truth for tests and detector checks).
+    std::vector<Box> blob_boxes(uint64_t index) const {
+        std::vector<Box> out;
+        const uint64_t t = index % static_cast<uint64_t>(cfg_.period);
+        for (const Blob& b : blobs_) {
+            float cx, cy;
+            center(b, t, cx, cy);
+            const int x0 = std::max(0, static_cast<int>(std::ceil(cx - b.r)));
+            const int y0 = std::max(0, static_cast<int>(std::ceil(cy - b.r)));
+            const int x1 = std::min(cfg_.width - 1, static_cast<int>(std::floor(cx + b.r)));
+            const int y1 = std::min(cfg_.height - 1, static_cast<int>(std::floor(cy + b.r)));
+            out.push_back(Box{x0, y0, x1 - x0 + 1, y1 - y0 + 1});
+        }
+        return out;
+    }
+
+private:
+    static constexpr size_t kNoiseTile = 8192;
+
+    struct Color {
+        uint8_t y, u, v;
+    };
+    struct Blob {
+        float r, ax, ay, px, py;
+        int fx, fy;
+        Color color;
+    };
+    struct Drop {
+        int x, y0, laps;
+    };
+    struct Canvas {
+        PixFmt fmt;
+        uint8_t* y;  // luma, or packed rgb
+        uint8_t* u;
+        uint8_t* v;
+        size_t cw;   // chroma row width
+    };
+
+    static uint64_t next(uint64_t& s) {  // splitmix64
+        uint64_t z = (s += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    static float unit(uint64_t& s) { return static_cast<float>(next(s) >> 40) / 16777216.0f; }
+
+    static uint8_t clamp8(int v) { return static_cast<uint8_t>(v < 0 ? 0 : v > 255 ? 255 : v); }
+
+    // BT.601 limited-range YUV -> RGB, for rgb24 output.
+    static void to_rgb(Color c, uint8_t rgb[3]) {
+        const int y = 298 * (c.y - 16), u = c.u - 128, v = c.v - 128;
+        rgb[0] = clamp8((y + 409 * v + 128) >> 8);
+        rgb[1] = clamp8((y - 100 * u - 208 * v + 128) >> 8);
+        rgb[2] = clamp8((y + 516 * u + 128) >> 8);
+    }
+
+    Canvas canvas(PixFmt fmt, uint8_t* dst) const {
+        const size_t w = static_cast<size_t>(cfg_.width), h = static_cast<size_t>(cfg_.height);
+        Canvas c{fmt, dst, nullptr, nullptr, (w + 1) / 2};
+        if (fmt == PixFmt::YUV420P) {
+            c.u = dst + w * h;
+            c.v = c.u + c.cw * ((h + 1) / 2);
+        }
+        return c;
+    }
+
+    void center(const Blob& b, uint64_t t, float& cx, float& cy) const {
+        const float phase = 6.2831853f * static_cast<float>(t) / static_cast<float>(cfg_.period);
+        cx = static_cast<float>(cfg_.width) * 0.5f + b.ax * std::sin(b.fx * phase + b.px);
+        cy = static_cast<float>(cfg_.height) * 0.5f + b.ay * std::sin(b.fy * phase + b.py);
+    }
+
+    // Fills [x0, x1) of row y (and, on even rows, the chroma under it).
+    void span(const Canvas& c, int y, int x0, int x1, Color col) const {
+        const size_t w = static_cast<size_t>(cfg_.width);
+        switch (c.fmt) {
+            case PixFmt::GRAY8:
+                std::memset(c.y + static_cast<size_t>(y) * w + x0, col.y, static_cast<size_t>(x1 - x0));
+                break;
+            case PixFmt::YUV420P: {
+                std::memset(c.y + static_cast<size_t>(y) * w + x0, col.y, static_cast<size_t>(x1 - x0));
+                if (y % 2 == 0) {
+                    const size_t row = static_cast<size_t>(y / 2) * c.cw;
+                    const size_t cx0 = static_cast<size_t>(x0 / 2), cx1 = static_cast<size_t>((x1 + 1) / 2);
+                    std::memset(c.u + row + cx0, col.u, cx1 - cx0);
+                    std::memset(c.v + row + cx0, col.v, cx1 - cx0);
+                }
+                break;
+            }
+            case PixFmt::RGB24: {
+                uint8_t rgb[3];
+                to_rgb(col, rgb);
+                uint8_t* p = c.y + (static_cast<size_t>(y) * w + static_cast<size_t>(x0)) * 3;
+                for (int x = x0; x < x1; ++x, p += 3) p[0] = rgb[0], p[1] = rgb[1], p[2] = rgb[2];
+                break;
+            }
+        }
+    }
+
+    // A single bright pixel that leaves chroma alone (rain).
+    void luma_dot(const Canvas& c, int y, int x, Color col) const {
+        const size_t at = static_cast<size_t>(y) * static_cast<size_t>(cfg_.width) + static_cast<size_t>(x);
+        if (c.fmt == PixFmt::RGB24) {
+            uint8_t rgb[3];
+            to_rgb(col, rgb);
+            std::memcpy(c.y + at * 3, rgb, 3);
+        } else {
+            c.y[at] = col.y;
+        }
+    }
+
+    // Background of the scene segment holding frame `index`: flat, a vertical
+    // gradient or a checkerboard, each with its own levels.
+    void draw_background(const Canvas& c, uint64_t index) const {
+        const uint64_t segment =
+            cfg_.scene_change_every > 0 ? index / static_cast<uint64_t>(cfg_.scene_change_every) : 0;
+        uint64_t s = (static_cast<uint64_t>(cfg_.seed) << 32) ^ (segment * 0x2545F4914F6CDD1Dull);
+        const int kind = static_cast<int>(next(s) % 3);
+        const Color a{static_cast<uint8_t>(40 + next(s) % 160), static_cast<uint8_t>(112 + next(s) % 32),
+                      static_cast<uint8_t>(112 + next(s) % 32)};
+        const Color b{static_cast<uint8_t>(a.y > 128 ? a.y - 60 : a.y + 60), a.u, a.v};
+        const int cell = std::max(2, cfg_.height / 8);
+        for (int y = 0; y < cfg_.height; ++y) {
+            if (kind == 0) {
+                span(c, y, 0, cfg_.width, a);
+            } else if (kind == 1) {
+                const int level = a.y + (b.y - a.y) * y / cfg_.height;
+                span(c, y, 0, cfg_.width, Color{static_cast<uint8_t>(level), a.u, a.v});
+            } else {
+                for (int x = 0; x < cfg_.width; x += cell)
+                    span(c, y, x, std::min(cfg_.width, x + cell), ((x / cell + y / cell) & 1) ? b : a);
+            }
+        }
+    }
+
+    // p = clamp(p + up - down): the tile stores each signed noise value as a
+    // pair of unsigned magnitudes so whole vectors use saturating byte math.
+    static void add_saturated(uint8_t* p, const uint8_t* up, const uint8_t* down, size_t n) {
+        size_t k = 0;
+#ifdef ZMP_USE_SIMD
+        using batch_t = xsimd::batch<uint8_t>;
+        for (; k + batch_t::size <= n; k += batch_t::size) {
+            const batch_t v = xsimd::sadd(batch_t::load_unaligned(p + k), batch_t::load_unaligned(up + k));
+            xsimd::ssub(v, batch_t::load_unaligned(down + k)).store_unaligned(p + k);
+        }
+#endif
+        for (; k < n; ++k) p[k] = clamp8(p[k] + up[k] - down[k]);
+    }
+
+    void add_noise(const Canvas& c, uint64_t index) const {
+        const size_t row = static_cast<size_t>(cfg_.width) * (c.fmt == PixFmt::RGB24 ? 3 : 1);
+        uint64_t s = index * 0xD1B54A32D192ED03ull + cfg_.seed;
+        for (int y = 0; y < cfg_.height; ++y) {
+            uint8_t* p = c.y + static_cast<size_t>(y) * row;
+            size_t off = next(s) % kNoiseTile;
+            for (size_t x = 0; x < row;) {
+                const size_t n = std::min(row - x, kNoiseTile - off);
+                add_saturated(p + x, noise_up_.data() + off, noise_down_.data() + off, n);
+                x += n;
+                off = 0;
+            }
+        }
+    }
+
+    SceneConfig cfg_;
+    std::vector<Blob> blobs_;
+    std::vector<Drop> drops_;
+    std::vector<uint8_t> noise_up_, noise_down_;
+};
+
+}  // namespace zm::synthetic
@@ -0,0 +1,119 @@
+#include "synthetic_scene.hpp"
+
+#include <gtest/gtest.h>
+
+using zm::synthetic::frame_bytes;
+using zm::synthetic::PixFmt;
+using zm::synthetic::Scene;
+using zm::synthetic::SceneConfig;
+
+namespace {
+
+std::vector<uint8_t> render(const Scene& s, uint64_t index, PixFmt fmt) {
+    std::vector<uint8_t> f(frame_bytes(fmt, s.config().width, s.config().height));
+    s.render(index, fmt, f.data());
+    return f;
+}
+
+size_t diff_pixels(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, size_t n) {
+    size_t d = 0;
+    for (size_t i = 0; i < n; ++i) d += a[i] != b[i];
+    return d;
+}
+
+}  // namespace
+
+TEST(SyntheticScene, FrameBytesMatchPackedLayouts) {
+    EXPECT_EQ(frame_bytes(PixFmt::YUV420P, 1920, 1080), 1920u * 1080u * 3 / 2);
+    EXPECT_EQ(frame_bytes(PixFmt::YUV420P, 5, 3), 15u + 2 * 3 * 2);  // odd sizes round chroma up
+    EXPECT_EQ(frame_bytes(PixFmt::RGB24, 640, 360), 640u * 360u * 3);
+    EXPECT_EQ(frame_bytes(PixFmt::GRAY8, 7680, 4320), 7680u * 4320u);
+}
+
+TEST(SyntheticScene, DeterministicAndPeriodic) {
+    SceneConfig cfg;
+    cfg.width = 321;
+    cfg.height = 179;
+    cfg.period = 40;
+    cfg.noise = 6;
+    cfg.rain = 5;
+    for (PixFmt fmt : {PixFmt::YUV420P, PixFmt::RGB24, PixFmt::GRAY8}) {
+        const Scene a(cfg), b(cfg);
+        EXPECT_EQ(render(a, 17, fmt), render(b, 17, fmt));
+        EXPECT_NE(render(a, 17, fmt), render(a, 18, fmt));
+    }
+    // Without noise (which is seeded by the absolute index) the motion
+    // repeats exactly every period.
+    cfg.noise = 0;
+    const Scene s(cfg);
+    EXPECT_EQ(render(s, 3, PixFmt::YUV420P), render(s, 3 + 2 * 40, PixFmt::YUV420P));
+}
+
+TEST(SyntheticScene, BlobsMoveAndSitWhereReported) {
+    SceneConfig cfg;
+    cfg.width = 640;
+    cfg.height = 360;
+    cfg.blobs = 1;
+    cfg.period = 100;
+    const Scene s(cfg);
+    const auto f0 = render(s, 0, PixFmt::GRAY8), f5 = render(s, 5, PixFmt::GRAY8);
+    const auto b0 = s.blob_boxes(0), b5 = s.blob_boxes(5);
+    ASSERT_EQ(b0.size(), 1u);
+    EXPECT_TRUE(b0[0].x != b5[0].x || b0[0].y != b5[0].y);
+
+    // Every changed pixel lies inside the union of the two blob boxes.
+    size_t changed = 0;
+    for (int y = 0; y < cfg.height; ++y)
+        for (int x = 0; x < cfg.width; ++x) {
+            const size_t i = static_cast<size_t>(y) * cfg.width + x;
+            if (f0[i] == f5[i]) continue;
+            ++changed;
+            bool inside = false;
+            for (const auto& b : {b0[0], b5[0]})
+                inside |= x >= b.x && x < b.x + b.w && y >= b.y && y < b.y + b.h;
+            ASSERT_TRUE(inside) << x << "," << y;
+        }
+    EXPECT_GT(changed, 0u);
+}
+
+TEST(SyntheticScene, SceneChangesSwitchTheBackground) {
+    SceneConfig cfg;
+    cfg.width = 160;
+    cfg.height = 120;
+    cfg.blobs = 0;
+    cfg.scene_change_every = 10;
+    const Scene s(cfg);
+    const size_t n = frame_bytes(PixFmt::YUV420P, cfg.width, cfg.height);
+    const auto a = render(s, 0, PixFmt::YUV420P);
+    EXPECT_EQ(diff_pixels(a, render(s, 9, PixFmt::YUV420P), n), 0u);  // static within a segment
+    size_t switched = 0;
+    for (uint64_t seg = 1; seg < 6; ++seg)
+        switched += diff_pixels(a, render(s, seg * 10, PixFmt::YUV420P), n) > n / 4;
+    EXPECT_GE(switched, 3u);
+}
+
+TEST(SyntheticScene, NoiseAndRainTouchLumaOnly) {
+    SceneConfig cfg;
+    cfg.width = 200;
+    cfg.height = 100;
+    cfg.blobs = 0;
+    const Scene clean(cfg);
+    cfg.noise = 10;
+    const Scene noisy(cfg);
+    cfg.noise = 0;
+    cfg.rain = 10;
+    const Scene rainy(cfg);
+    const auto a = render(clean, 4, PixFmt::YUV420P);
+    const auto n = render(noisy, 4, PixFmt::YUV420P), r = render(rainy, 4, PixFmt::YUV420P);
+    const size_t luma = static_cast<size_t>(cfg.width) * cfg.height;
+    EXPECT_GT(diff_pixels(a, n, luma), luma / 2);
+    EXPECT_GT(diff_pixels(a, r, luma), 0u);
+    for (size_t i = 0; i < luma; ++i) {
+        ASSERT_LE(std::abs(int(a[i]) - int(n[i])), 10) << i;
+        if (a[i] != r[i]) {
+            ASSERT_EQ(r[i], 235) << i;  // rain streak
+        }
+    }
+    EXPECT_TRUE(std::equal(a.begin() + luma, a.end(), n.begin() + luma));
+    EXPECT_TRUE(std::equal(a.begin() + luma, a.end(), r.begin() + luma));
+}
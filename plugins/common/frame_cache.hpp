@@ -0,0 +1,98 @@
+#pragma once
+
+// Header-only RAII wrapper over the host frame cache (zm_host_api_t.frame_cache):
+// a plugin that only needs a decoded frame now and then (snapshot, VLM prompt,
+// cutout) holds a reference to the host's copy instead of keeping its own.
+//
+//   zm::fc::retain(host, host_ctx, 1);          // in start()
+//   auto ref = zm::fc::FrameRef::latest(host, host_ctx, sid, ZM_FRAME_RGB24, w * h * 3);
+//   if (ref) encode(ref.payload(), w, h);       // released when ref goes out of scope
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "zm_plugin.h"
+#include "zm_side_data.h"
+
+namespace zm {
+namespace fc {
+
+// True when the host provides a frame cache.
+inline bool available(const zm_host_api_t* host) {
+    return host && host->frame_cache && host->frame_cache->retain;
+}
+
+// Enable the cache, keeping at least `frames` recent frames per stream.
+inline bool retain(const zm_host_api_t* host, void* host_ctx, uint32_t frames) {
+    if (!available(host)) return false;
+    host->frame_cache->retain(host_ctx, frames);
+    return true;
+}
+
+class FrameRef {
+public:
+    FrameRef() = default;
+    ~FrameRef() { reset(); }
+    FrameRef(const FrameRef&) = delete;
+    FrameRef& operator=(const FrameRef&) = delete;
+    FrameRef(FrameRef&& o) noexcept { *this = std::move(o); }
+    FrameRef& operator=(FrameRef&& o) noexcept {
+        if (this != &o) {
+            reset();
+            std::swap(api_, o.api_);
+            std::swap(ctx_, o.ctx_);
+            std::swap(ref_, o.ref_);
+            std::swap(frame_, o.frame_);
+            std::swap(size_, o.size_);
+        }
+        return *this;
+    }
+
+    static FrameRef latest(const zm_host_api_t* host, void* host_ctx, uint32_t stream_id,
+                           uint32_t hw_type, uint32_t bytes) {
+        FrameRef r;
+        if (!available(host) || !host->frame_cache->acquire_latest) return r;
+        r.api_ = host->frame_cache;
+        r.ctx_ = host_ctx;
+        r.ref_ = r.api_->acquire_latest(host_ctx, stream_id, hw_type, bytes, &r.frame_, &r.size_);
+        return r;
+    }
+
+    static FrameRef at(const zm_host_api_t* host, void* host_ctx, uint32_t stream_id,
+                       uint32_t hw_type, uint32_t bytes, uint64_t pts_usec,
+                       uint64_t tolerance_usec) {
+        FrameRef r;
+        if (!available(host) || !host->frame_cache->acquire_at) return r;
+        r.api_ = host->frame_cache;
+        r.ctx_ = host_ctx;
+        r.ref_ = r.api_->acquire_at(host_ctx, stream_id, hw_type, bytes, pts_usec,
+                                    tolerance_usec, &r.frame_, &r.size_);
+        return r;
+    }
+
+    explicit operator bool() const { return ref_ && size_ >= sizeof(zm_frame_hdr_t); }
+    const zm_frame_hdr_t* hdr() const { return static_cast<const zm_frame_hdr_t*>(frame_); }
+    const uint8_t* payload() const {
+        return static_cast<const uint8_t*>(frame_) + sizeof(zm_frame_hdr_t);
+    }
+    // Excludes the side-data block a cached frame may carry after the payload.
+    size_t payload_size() const { return zm_frame_payload_size(frame_, size_); }
+
+    void reset() {
+        if (ref_ && api_ && api_->release) api_->release(ctx_, ref_);
+        ref_ = nullptr;
+        frame_ = nullptr;
+        size_ = 0;
+    }
+
+private:
+    const zm_frame_cache_api_t* api_ = nullptr;
+    void* ctx_ = nullptr;
+    zm_frame_ref_t* ref_ = nullptr;
+    const void* frame_ = nullptr;
+    size_t size_ = 0;
+};
+
+}  // namespace fc
+}  // namespace zm
@@ -0,0 +1,213 @@
+#pragma once
+
+// Dependency-free pixel helpers behind zm::img's JPEG encoders (image_encode.hpp),
+// split out so they can be unit-tested without FFmpeg.
+//
+// The RGB24 -> YUVJ420 converter is fixed-point BT.601 full range (what MJPEG
+// expects); it replaces a per-call swscale context when no resize is needed.
+// Built with ZMP_USE_SIMD it works in chunks of a row: the packed samples are
+// split into planar scratch (xsimd has no portable 3-way deinterleave), then
+// the multiply-adds run on xsimd batches, 16-bit lanes for luma and 32-bit for
+// the 2x2 chroma sums. Both paths give identical bytes.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifdef ZMP_USE_SIMD
+#include <xsimd/xsimd.hpp>
+#endif
+
+namespace zm {
+namespace img {
+
+// Planes of a planar 4:2:0 destination (e.g. an AVFrame's data/linesize).
+struct Yuv420Planes {
+    uint8_t* y = nullptr;
+    uint8_t* u = nullptr;
+    uint8_t* v = nullptr;
+    int y_stride = 0;
+    int u_stride = 0;
+    int v_stride = 0;
+};
+
+namespace detail {
+
+// Samples per chunk of the batch path; the planar scratch stays on the stack.
+constexpr int kConvertChunk = 256;
+
+inline uint8_t luma(int r, int g, int b) {
+    return static_cast<uint8_t>((77 * r + 150 * g + 29 * b + 128) >> 8);
+}
+
+// r/g/b are sums of 4 samples: scale by 1/1024 and bias by 128 (kept positive).
+inline uint8_t chroma_b(int r, int g, int b) {
+    const int cb = ((128 << 10) + 512 - 43 * r - 85 * g + 128 * b) >> 10;
+    return static_cast<uint8_t>(cb > 255 ? 255 : cb);
+}
+inline uint8_t chroma_r(int r, int g, int b) {
+    const int cr = ((128 << 10) + 512 + 128 * r - 107 * g - 21 * b) >> 10;
+    return static_cast<uint8_t>(cr > 255 ? 255 : cr);
+}
+
+// One luma row of n pixels.
+inline void luma_row(const uint8_t* s, int n, uint8_t* d) {
+    int x = 0;
+#ifdef ZMP_USE_SIMD
+    using batch_t = xsimd::batch<uint16_t>;
+    constexpr int VL = static_cast<int>(batch_t::size);
+    alignas(64) uint16_t r[kConvertChunk], g[kConvertChunk], b[kConvertChunk], y[kConvertChunk];
+    for (; x + VL <= n;) {
+        const int m = std::min(kConvertChunk, (n - x) / VL * VL);
+        const uint8_t* p = s + 3 * static_cast<size_t>(x);
+        for (int i = 0; i < m; ++i) {
+            r[i] = p[3 * i];
+            g[i] = p[3 * i + 1];
+            b[i] = p[3 * i + 2];
+        }
+        // At most 256 * 255 + 128: no 16-bit overflow.
+        for (int i = 0; i < m; i += VL) {
+            const batch_t v = batch_t::load_aligned(r + i) * batch_t(77) +
+                              batch_t::load_aligned(g + i) * batch_t(150) +
+                              batch_t::load_aligned(b + i) * batch_t(29) + batch_t(128);
+            (v >> 8).store_aligned(y + i);
+        }
+        for (int i = 0; i < m; ++i) d[x + i] = static_cast<uint8_t>(y[i]);
+        x += m;
+    }
+#endif
+    for (; x < n; ++x) d[x] = luma(s[3 * x], s[3 * x + 1], s[3 * x + 2]);
+}
+
+// One chroma row of cw samples from source rows s0/s1 (w pixels; the last
+// column repeats for odd w).
+inline void chroma_row(const uint8_t* s0, const uint8_t* s1, int w, int cw, uint8_t* du,
+                       uint8_t* dv) {
+    int cx = 0;
+    auto sums = [&](int c, int& r, int& g, int& b) {
+        const int x0 = 6 * c;
+        const int x1 = (2 * c + 1 < w) ? x0 + 3 : x0;
+        r = s0[x0] + s0[x1] + s1[x0] + s1[x1];
+        g = s0[x0 + 1] + s0[x1 + 1] + s1[x0 + 1] + s1[x1 + 1];
+        b = s0[x0 + 2] + s0[x1 + 2] + s1[x0 + 2] + s1[x1 + 2];
+    };
+#ifdef ZMP_USE_SIMD
+    using batch_t = xsimd::batch<int32_t>;
+    constexpr int VL = static_cast<int>(batch_t::size);
+    alignas(64) int32_t r[kConvertChunk], g[kConvertChunk], b[kConvertChunk];
+    alignas(64) int32_t u[kConvertChunk], v[kConvertChunk];
+    const batch_t bias((128 << 10) + 512), hi(255);
+    for (; cx + VL <= cw;) {
+        const int m = std::min(kConvertChunk, (cw - cx) / VL * VL);
+        for (int i = 0; i < m; ++i) sums(cx + i, r[i], g[i], b[i]);
+        for (int i = 0; i < m; i += VL) {
+            const batch_t vr = batch_t::load_aligned(r + i);
+            const batch_t vg = batch_t::load_aligned(g + i);
+            const batch_t vb = batch_t::load_aligned(b + i);
+            xsimd::min((bias - vr * batch_t(43) - vg * batch_t(85) + vb * batch_t(128)) >> 10, hi)
+                .store_aligned(u + i);
+            xsimd::min((bias + vr * batch_t(128) - vg * batch_t(107) - vb * batch_t(21)) >> 10, hi)
+                .store_aligned(v + i);
+        }
+        for (int i = 0; i < m; ++i) {
+            du[cx + i] = static_cast<uint8_t>(u[i]);
+            dv[cx + i] = static_cast<uint8_t>(v[i]);
+        }
+        cx += m;
+    }
+#endif
+    for (; cx < cw; ++cx) {
+        int r, g, b;
+        sums(cx, r, g, b);
+        du[cx] = chroma_b(r, g, b);
+        dv[cx] = chroma_r(r, g, b);
+    }
+}
+
+}  // namespace detail
+
+// Convert packed RGB24 (`stride` bytes per row) of w x h into `dst`. Chroma is
+// the average of each 2x2 block (edge pixels repeat for odd sizes).
+inline void rgb24_to_yuvj420(const uint8_t* rgb, int w, int h, int stride,
+                             const Yuv420Planes& dst) {
+    for (int y = 0; y < h; ++y)
+        detail::luma_row(rgb + static_cast<size_t>(y) * stride, w,
+                         dst.y + static_cast<size_t>(y) * dst.y_stride);
+    const int cw = (w + 1) / 2;
+    const int ch = (h + 1) / 2;
+    for (int cy = 0; cy < ch; ++cy) {
+        const int y0 = 2 * cy;
+        const int y1 = (y0 + 1 < h) ? y0 + 1 : y0;
+        detail::chroma_row(rgb + static_cast<size_t>(y0) * stride,
+                           rgb + static_cast<size_t>(y1) * stride, w, cw,
+                           dst.u + static_cast<size_t>(cy) * dst.u_stride,
+                           dst.v + static_cast<size_t>(cy) * dst.v_stride);
+    }
+}
+
+// Grayscale: luma is the input, chroma neutral.
+inline void gray8_to_yuvj420(const uint8_t* gray, int w, int h, int stride,
+                             const Yuv420Planes& dst) {
+    for (int y = 0; y < h; ++y)
+        std::memcpy(dst.y + static_cast<size_t>(y) * dst.y_stride,
+                    gray + static_cast<size_t>(y) * stride, static_cast<size_t>(w));
+    const int cw = (w + 1) / 2;
+    const int ch = (h + 1) / 2;
+    for (int cy = 0; cy < ch; ++cy) {
+        std::memset(dst.u + static_cast<size_t>(cy) * dst.u_stride, 128, static_cast<size_t>(cw));
+        std::memset(dst.v + static_cast<size_t>(cy) * dst.v_stride, 128, static_cast<size_t>(cw));
+    }
+}
+
+// Fill a pw x ph plane beyond its w x h content by repeating the last column
+// and row, so padding blocks don't bleed a hard edge into the visible image.
+inline void pad_plane(uint8_t* p, int stride, int w, int h, int pw, int ph) {
+    if (w <= 0 || h <= 0) return;
+    if (pw > w)
+        for (int y = 0; y < h; ++y) {
+            uint8_t* row = p + static_cast<size_t>(y) * stride;
+            std::memset(row + w, row[w - 1], static_cast<size_t>(pw - w));
+        }
+    for (int y = h; y < ph; ++y)
+        std::memcpy(p + static_cast<size_t>(y) * stride,
+                    p + static_cast<size_t>(h - 1) * stride, static_cast<size_t>(pw));
+}
+
+inline void pad_yuv420(const Yuv420Planes& p, int w, int h, int pw, int ph) {
+    pad_plane(p.y, p.y_stride, w, h, pw, ph);
+    pad_plane(p.u, p.u_stride, (w + 1) / 2, (h + 1) / 2, (pw + 1) / 2, (ph + 1) / 2);
+    pad_plane(p.v, p.v_stride, (w + 1) / 2, (h + 1) / 2, (pw + 1) / 2, (ph + 1) / 2);
+}
+
+// 4:2:0 JPEG codes whole 16x16 MCUs, so an image encoded at a size rounded up
+// to 16 can be relabelled to any size within the same MCU grid by rewriting the
+// frame header. That lets one encoder serve every size in its 16-pixel bucket.
+inline int jpeg_mcu_align(int v) { return (v + 15) & ~15; }
+
+// Rewrite the dimensions in a JPEG's SOF0/SOF1/SOF2 header. Returns false if no
+// SOF marker is found before the scan data.
+inline bool jpeg_set_dimensions(std::vector<uint8_t>& jpeg, int width, int height) {
+    size_t i = 2;  // skip SOI
+    while (i + 4 <= jpeg.size()) {
+        if (jpeg[i] != 0xFF) return false;
+        const uint8_t marker = jpeg[i + 1];
+        if (marker == 0xFF) { ++i; continue; }  // fill byte
+        const size_t len = (static_cast<size_t>(jpeg[i + 2]) << 8) | jpeg[i + 3];
+        if (marker >= 0xC0 && marker <= 0xC2) {
+            if (i + 9 > jpeg.size()) return false;
+            jpeg[i + 5] = static_cast<uint8_t>(height >> 8);
+            jpeg[i + 6] = static_cast<uint8_t>(height);
+            jpeg[i + 7] = static_cast<uint8_t>(width >> 8);
+            jpeg[i + 8] = static_cast<uint8_t>(width);
+            return true;
+        }
+        if (marker == 0xDA) return false;  // start of scan
+        i += 2 + len;
+    }
+    return false;
+}
+
+}  // namespace img
+}  // namespace zm
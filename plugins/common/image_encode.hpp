@@ -6,10 +6,23 @@
 //
 // Promoted from describe_vlm's file-static encoder so describe_vlm, review_export
 // (cutouts) and motion_pixel_diff (background plates) share one implementation.
-
+//
+// Encoders are reused: a JpegEncoder keeps its opened MJPEG context, frame and
+// packet for one 16-aligned size and quality, and JpegEncoderPool hands them out
+// per call (one pool per plugin, see default_jpeg_pool()). Same-size RGB24 /
+// GRAY8 input is converted with the fixed-point converter in image_convert.hpp;
+// only a resize (max_edge / max_pixels) or another pixel format goes through a
+// (cached) swscale context.
+
+#include <cmath>
 #include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <vector>
 
+#include "image_convert.hpp"
+
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavutil/imgutils.h>
@@ -19,79 +32,198 @@ extern "C" {
 namespace zm {
 namespace img {
 
+struct JpegOptions {
+    int qscale = 0;          // FFmpeg mjpeg qscale 2..31 (lower = better); 0 = codec default
+    int max_edge = 0;        // downscale so the long side is <= this (0 = off)
+    long max_pixels = 0;     // downscale so w*h <= this (0 = off)
+};
+
+// Output size for `opt` (aspect kept, even dimensions when scaled).
+inline void jpeg_output_size(int w, int h, const JpegOptions& opt, int& dw, int& dh) {
+    double s = 1.0;
+    const int long_edge = w > h ? w : h;
+    if (opt.max_edge > 0 && long_edge > opt.max_edge) s = static_cast<double>(opt.max_edge) / long_edge;
+    if (opt.max_pixels > 0 && static_cast<double>(w) * h * s * s > opt.max_pixels)
+        s = std::sqrt(static_cast<double>(opt.max_pixels) / (static_cast<double>(w) * h));
+    dw = w;
+    dh = h;
+    if (s < 1.0) {
+        dw = static_cast<int>(w * s) & ~1;
+        dh = static_cast<int>(h * s) & ~1;
+        if (dw < 2) dw = 2;
+        if (dh < 2) dh = 2;
+    }
+}
+
+// One opened MJPEG encoder for a 16-aligned size and a quality. Not thread-safe;
+// the pool leases each encoder to one caller at a time.
+class JpegEncoder {
+public:
+    JpegEncoder(int aligned_w, int aligned_h, int qscale)
+        : width_(aligned_w), height_(aligned_h), qscale_(qscale) {
+        const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+        if (!codec) return;
+        cctx_ = avcodec_alloc_context3(codec);
+        if (!cctx_) return;
+        cctx_->pix_fmt = AV_PIX_FMT_YUVJ420P;
+        cctx_->width = width_;
+        cctx_->height = height_;
+        cctx_->time_base = AVRational{1, 25};
+        cctx_->color_range = AVCOL_RANGE_JPEG;
+        if (qscale_ > 0) {
+            // Drive mjpeg quality via fixed qscale (FF_QP2LAMBDA-scaled).
+            cctx_->flags |= AV_CODEC_FLAG_QSCALE;
+            cctx_->global_quality = qscale_ * FF_QP2LAMBDA;
+        }
+        if (avcodec_open2(cctx_, codec, nullptr) < 0) return;
+        frame_ = av_frame_alloc();
+        pkt_ = av_packet_alloc();
+        if (!frame_ || !pkt_) return;
+        frame_->format = AV_PIX_FMT_YUVJ420P;
+        frame_->width = width_;
+        frame_->height = height_;
+        if (av_frame_get_buffer(frame_, 32) < 0) return;
+        ok_ = true;
+    }
+
+    ~JpegEncoder() {
+        if (sws_) sws_freeContext(sws_);
+        if (pkt_) av_packet_free(&pkt_);
+        if (frame_) av_frame_free(&frame_);
+        if (cctx_) avcodec_free_context(&cctx_);
+    }
+
+    JpegEncoder(const JpegEncoder&) = delete;
+    JpegEncoder& operator=(const JpegEncoder&) = delete;
+
+    bool ok() const { return ok_; }
+    bool fits(int aligned_w, int aligned_h, int qscale) const {
+        return width_ == aligned_w && height_ == aligned_h && qscale_ == qscale;
+    }
+
+    // Encode a w x h image of `fmt` as a dw x dh JPEG (dw/dh within this
+    // encoder's MCU bucket).
+    bool encode(const uint8_t* pixels, AVPixelFormat fmt, int w, int h, int stride,
+                int dw, int dh, std::vector<uint8_t>& out) {
+        out.clear();
+        if (!ok_ || av_frame_make_writable(frame_) < 0) return false;
+        const Yuv420Planes planes{frame_->data[0], frame_->data[1], frame_->data[2],
+                                  frame_->linesize[0], frame_->linesize[1], frame_->linesize[2]};
+        if (dw == w && dh == h && fmt == AV_PIX_FMT_RGB24) {
+            rgb24_to_yuvj420(pixels, w, h, stride, planes);
+        } else if (dw == w && dh == h && fmt == AV_PIX_FMT_GRAY8) {
+            gray8_to_yuvj420(pixels, w, h, stride, planes);
+        } else {
+            sws_ = sws_getCachedContext(sws_, w, h, fmt, dw, dh, AV_PIX_FMT_YUVJ420P,
+                                        SWS_BILINEAR, nullptr, nullptr, nullptr);
+            if (!sws_) return false;
+            const uint8_t* src[1] = {pixels};
+            const int src_stride[1] = {stride};
+            sws_scale(sws_, src, src_stride, 0, h, frame_->data, frame_->linesize);
+        }
+        pad_yuv420(planes, dw, dh, width_, height_);
+
+        frame_->pts = 0;
+        frame_->quality = cctx_->global_quality;
+        if (avcodec_send_frame(cctx_, frame_) < 0) return false;
+        if (avcodec_receive_packet(cctx_, pkt_) < 0) return false;
+        out.assign(pkt_->data, pkt_->data + pkt_->size);
+        av_packet_unref(pkt_);
+        if ((dw != width_ || dh != height_) && !jpeg_set_dimensions(out, dw, dh)) {
+            out.clear();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    int width_;
+    int height_;
+    int qscale_;
+    bool ok_ = false;
+    AVCodecContext* cctx_ = nullptr;
+    AVFrame* frame_ = nullptr;
+    AVPacket* pkt_ = nullptr;
+    SwsContext* sws_ = nullptr;
+};
+
+// Thread-safe pool of idle encoders, most recently used last. Encoding runs
+// outside the lock on a leased encoder; at most `max_idle` stay open.
+class JpegEncoderPool {
+public:
+    explicit JpegEncoderPool(size_t max_idle = 8) : max_idle_(max_idle) {}
+
+    bool encode(const uint8_t* pixels, AVPixelFormat fmt, int w, int h, int stride,
+                std::vector<uint8_t>& out, const JpegOptions& opt = {}) {
+        out.clear();
+        if (!pixels || w <= 0 || h <= 0) return false;
+        int dw = w, dh = h;
+        jpeg_output_size(w, h, opt, dw, dh);
+        std::unique_ptr<JpegEncoder> enc = acquire(jpeg_mcu_align(dw), jpeg_mcu_align(dh), opt.qscale);
+        if (!enc) return false;
+        const bool ok = enc->encode(pixels, fmt, w, h, stride, dw, dh, out);
+        release(std::move(enc));
+        return ok;
+    }
+
+    uint64_t opened() const { std::lock_guard<std::mutex> lk(mtx_); return opened_; }
+    uint64_t reused() const { std::lock_guard<std::mutex> lk(mtx_); return reused_; }
+
+private:
+    std::unique_ptr<JpegEncoder> acquire(int aw, int ah, int qscale) {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            for (auto it = idle_.rbegin(); it != idle_.rend(); ++it) {
+                if ((*it)->fits(aw, ah, qscale)) {
+                    std::unique_ptr<JpegEncoder> enc = std::move(*it);
+                    idle_.erase(std::next(it).base());
+                    ++reused_;
+                    return enc;
+                }
+            }
+            ++opened_;
+        }
+        auto enc = std::make_unique<JpegEncoder>(aw, ah, qscale);
+        return enc->ok() ? std::move(enc) : nullptr;
+    }
+
+    void release(std::unique_ptr<JpegEncoder> enc) {
+        std::lock_guard<std::mutex> lk(mtx_);
+        idle_.push_back(std::move(enc));
+        while (idle_.size() > max_idle_) idle_.pop_front();
+    }
+
+    size_t max_idle_;
+    mutable std::mutex mtx_;
+    std::deque<std::unique_ptr<JpegEncoder>> idle_;
+    uint64_t opened_ = 0;
+    uint64_t reused_ = 0;
+};
+
+// The calling plugin's pool (each plugin .so has its own copy of this header).
+inline JpegEncoderPool& default_jpeg_pool() {
+    static JpegEncoderPool pool(32);
+    return pool;
+}
+
 // Encode a tightly-packed pixel buffer of `src_fmt` to an in-memory JPEG.
 // Internal helper; callers use the typed wrappers below.
 inline bool encode_to_jpeg(const uint8_t* pixels, int width, int height,
                            AVPixelFormat src_fmt, int src_stride,
-                           std::vector<uint8_t>& out) {
-    out.clear();
-    if (!pixels || width <= 0 || height <= 0) return false;
-
-    const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
-    if (!codec) return false;
-
-    AVCodecContext* cctx = avcodec_alloc_context3(codec);
-    if (!cctx) return false;
-
-    cctx->pix_fmt = AV_PIX_FMT_YUVJ420P;
-    cctx->width = width;
-    cctx->height = height;
-    cctx->time_base = AVRational{1, 25};
-    cctx->color_range = AVCOL_RANGE_JPEG;
-
-    SwsContext* sws = nullptr;
-    AVFrame* frame = nullptr;
-    AVPacket* pkt = nullptr;
-    bool ok = false;
-
-    do {
-        if (avcodec_open2(cctx, codec, nullptr) < 0) break;
-
-        frame = av_frame_alloc();
-        if (!frame) break;
-        frame->format = cctx->pix_fmt;
-        frame->width = width;
-        frame->height = height;
-        if (av_frame_get_buffer(frame, 32) < 0) break;
-
-        sws = sws_getContext(width, height, src_fmt,
-                             width, height, AV_PIX_FMT_YUVJ420P,
-                             SWS_BILINEAR, nullptr, nullptr, nullptr);
-        if (!sws) break;
-
-        const uint8_t* srcSlice[1] = {pixels};
-        int srcStride[1] = {src_stride};
-        sws_scale(sws, srcSlice, srcStride, 0, height,
-                  frame->data, frame->linesize);
-
-        frame->pts = 0;
-        if (avcodec_send_frame(cctx, frame) < 0) break;
-
-        pkt = av_packet_alloc();
-        if (!pkt) break;
-        if (avcodec_receive_packet(cctx, pkt) < 0) break;
-
-        out.assign(pkt->data, pkt->data + pkt->size);
-        ok = true;
-    } while (false);
-
-    if (pkt) av_packet_free(&pkt);
-    if (frame) av_frame_free(&frame);
-    if (sws) sws_freeContext(sws);
-    if (cctx) avcodec_free_context(&cctx);
-    return ok;
+                           std::vector<uint8_t>& out, const JpegOptions& opt = {}) {
+    return default_jpeg_pool().encode(pixels, src_fmt, width, height, src_stride, out, opt);
 }
 
 // Encode a packed RGB24 (R,G,B per pixel) buffer to JPEG.
 inline bool encode_rgb24_to_jpeg(const uint8_t* rgb, int width, int height,
-                                 std::vector<uint8_t>& out) {
-    return encode_to_jpeg(rgb, width, height, AV_PIX_FMT_RGB24, 3 * width, out);
+                                 std::vector<uint8_t>& out, const JpegOptions& opt = {}) {
+    return encode_to_jpeg(rgb, width, height, AV_PIX_FMT_RGB24, 3 * width, out, opt);
 }
 
 // Encode a packed 8-bit grayscale buffer to JPEG (used for background plates).
 inline bool encode_gray8_to_jpeg(const uint8_t* gray, int width, int height,
-                                 std::vector<uint8_t>& out) {
-    return encode_to_jpeg(gray, width, height, AV_PIX_FMT_GRAY8, width, out);
+                                 std::vector<uint8_t>& out, const JpegOptions& opt = {}) {
+    return encode_to_jpeg(gray, width, height, AV_PIX_FMT_GRAY8, width, out, opt);
 }
 
 } // namespace img
@@ -0,0 +1,69 @@
+#pragma once
+
+// Header-only read-only file mapping, shared by the ORT model cache
+// (detect_onnx/model_cache.hpp) and the binary face gallery
+// (recognize_face/face_gallery.hpp). The pages come from the page cache, so N
+// processes mapping the same file hold one physical copy.
+//
+//   auto map = zm::io::MappedFile::open(path);  // nullptr on failure
+//   if (map) use(map->data(), map->size());     // unmapped with the last owner
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#if defined(_WIN32)
+#define ZM_MAPPED_FILE_MMAP 0
+#else
+#define ZM_MAPPED_FILE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace zm {
+namespace io {
+
+// Read-only shared mapping of a whole file.
+class MappedFile {
+public:
+    // nullptr if the file cannot be opened or is empty (always on Windows).
+    static std::shared_ptr<const MappedFile> open(const std::string& path) {
+#if ZM_MAPPED_FILE_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return nullptr;
+        struct stat st{};
+        void* p = MAP_FAILED;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0)
+            p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return nullptr;
+        return std::shared_ptr<const MappedFile>(
+            new MappedFile(static_cast<const uint8_t*>(p), static_cast<size_t>(st.st_size)));
+#else
+        (void)path;
+        return nullptr;
+#endif
+    }
+
+    ~MappedFile() {
+#if ZM_MAPPED_FILE_MMAP
+        if (data_) ::munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    MappedFile(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace io
+} // namespace zm
@@ -0,0 +1,127 @@
+#pragma once
+
+// Subscribe to "motion" events (motion_gate) and keep the newest changed
+// regions per stream, so a detector can crop to what moved. Header-only;
+// consumers link nlohmann_json and add this dir to their include path.
+//
+//   auto* feed = zm::motion::subscribe_motion(host, host_ctx);   // start()
+//   std::vector<zm::motion::MotionRegion> r;
+//   if (feed->index.latest(sid, pts, max_age_us, r)) ...         // on_frame()
+//   zm::motion::unsubscribe_motion(host, host_ctx, feed);         // stop()
+//
+// LIFETIME follows track_feed.hpp: the feed is leaked on unsubscribe so an
+// in-flight callback never touches freed memory.
+
+#include "zm_plugin.h"
+
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace zm {
+namespace motion {
+
+// Source-pixel rectangle; {0,0,0,0} = the whole frame (a motion event that
+// carries no regions).
+struct MotionRegion {
+    int x = 0, y = 0, w = 0, h = 0;
+};
+
+class MotionIndex {
+public:
+    void update(uint32_t stream, uint64_t pts, std::vector<MotionRegion> regions) {
+        std::lock_guard<std::mutex> lk(mtx_);
+        auto& s = streams_[stream];
+        s.pts = pts;
+        s.regions = std::move(regions);
+    }
+
+    // True once any motion event arrived for `stream`: a motion stage is
+    // upstream, so no recent event means nothing moved.
+    bool seen(uint32_t stream) const {
+        std::lock_guard<std::mutex> lk(mtx_);
+        return streams_.count(stream) != 0;
+    }
+
+    // Regions of the newest event if it is within max_age_us of `pts` (either
+    // side: events and frames race). False = no recent motion.
+    bool latest(uint32_t stream, uint64_t pts, uint64_t max_age_us,
+                std::vector<MotionRegion>& out) const {
+        std::lock_guard<std::mutex> lk(mtx_);
+        auto it = streams_.find(stream);
+        if (it == streams_.end()) return false;
+        const uint64_t d = pts > it->second.pts ? pts - it->second.pts : it->second.pts - pts;
+        if (d > max_age_us) return false;
+        out = it->second.regions;
+        return true;
+    }
+
+private:
+    struct Snapshot {
+        uint64_t pts = 0;
+        std::vector<MotionRegion> regions;
+    };
+    mutable std::mutex mtx_;
+    std::unordered_map<uint32_t, Snapshot> streams_;
+};
+
+struct MotionFeed {
+    std::atomic<bool> running{true};
+    void* subHandle = nullptr;
+    MotionIndex index;
+};
+
+// Apply one host event to `feed` (ignored unless it is a "motion" event with a
+// stream_id and pts_usec).
+inline void apply_motion_event(MotionFeed& feed, const char* event) {
+    if (!event || !std::strstr(event, "\"motion\"")) return;
+    nlohmann::json j = nlohmann::json::parse(event, nullptr, false);
+    if (j.is_discarded() || !j.is_object() || j.value("type", std::string()) != "motion" ||
+        !j.contains("stream_id") || !j.contains("pts_usec"))
+        return;
+    const auto stream = static_cast<uint32_t>(j.value("stream_id", 0));
+    const auto pts = j.value("pts_usec", static_cast<uint64_t>(0));
+    std::vector<MotionRegion> regions;
+    if (j.contains("regions") && j["regions"].is_array()) {
+        for (const auto& r : j["regions"]) {
+            if (!r.is_array() || r.size() < 4) continue;
+            MotionRegion m{r[0].get<int>(), r[1].get<int>(), r[2].get<int>(), r[3].get<int>()};
+            if (m.w > 0 && m.h > 0) regions.push_back(m);
+        }
+    }
+    if (regions.empty()) regions.push_back({});  // motion somewhere: whole frame
+    feed.index.update(stream, pts, std::move(regions));
+}
+
+inline MotionFeed* subscribe_motion(zm_host_api_t* host, void* host_ctx) {
+    if (!host || !host->subscribe_evt) return nullptr;
+    auto* feed = new MotionFeed();  // leaked on unsubscribe (see above)
+    feed->subHandle = host->subscribe_evt(
+        host_ctx,
+        [](void* user, const char* event) {
+            auto* f = static_cast<MotionFeed*>(user);
+            if (!f->running.load()) return;
+            try {
+                apply_motion_event(*f, event);
+            } catch (const std::exception&) {
+                // malformed region values; keep the previous snapshot
+            }
+        },
+        feed);
+    return feed;
+}
+
+inline void unsubscribe_motion(zm_host_api_t* host, void* host_ctx, MotionFeed* feed) {
+    if (!feed) return;
+    if (host && host->unsubscribe_evt) host->unsubscribe_evt(host_ctx, feed->subHandle);
+    feed->running.store(false);
+}
+
+}  // namespace motion
+}  // namespace zm
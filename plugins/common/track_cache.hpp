@@ -0,0 +1,291 @@
+#pragma once
+
+// Per-track caching of expensive recognition results (face identity, plate
+// text), keyed by the tracker's track_id. Pure C++ so it is unit-testable; the
+// host/event glue that fills a TrackIndex lives in track_feed.hpp.
+//
+// A recognizer associates each of its own detections (a face, a plate) with the
+// tracked object that contains it (a person, a vehicle), at most one detection
+// per track, and re-runs inference for that track only when there is no result
+// yet, the result is older than the refresh interval, or the new detection is of
+// clearly better quality (bigger, sharper, more confident). When every tracked
+// object in view is covered — a fresh result, or a recent pass that found
+// nothing on it — the frame's detector pass can be skipped altogether and the
+// cached results republished at the tracks' current positions.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace zm {
+namespace track {
+
+// A tracked object from a tracked_detection event. id 0 = not (yet) confirmed.
+struct TrackBox {
+    int id = 0;
+    float x = 0.f, y = 0.f, w = 0.f, h = 0.f;
+    std::string label;
+};
+
+// A box expressed relative to its track's box, so a cached sub-box (the face
+// inside a person) follows the track on frames that skip detection.
+struct RelBox {
+    float x = 0.f, y = 0.f, w = 0.f, h = 0.f;
+};
+
+inline RelBox to_relative(const TrackBox& t, float x, float y, float w, float h) {
+    if (t.w <= 0.f || t.h <= 0.f) return {};
+    return {(x - t.x) / t.w, (y - t.y) / t.h, w / t.w, h / t.h};
+}
+
+inline void from_relative(const TrackBox& t, const RelBox& r, float& x, float& y, float& w, float& h) {
+    x = t.x + r.x * t.w;
+    y = t.y + r.y * t.h;
+    w = r.w * t.w;
+    h = r.h * t.h;
+}
+
+// Index into `tracks` of the tightest track containing the centre of the box,
+// or -1.
+inline int tightest_track(const std::vector<TrackBox>& tracks, float x, float y, float w, float h) {
+    const float cx = x + 0.5f * w;
+    const float cy = y + 0.5f * h;
+    int best = -1;
+    float bestArea = 0.f;
+    for (size_t i = 0; i < tracks.size(); ++i) {
+        const auto& t = tracks[i];
+        if (cx < t.x || cy < t.y || cx > t.x + t.w || cy > t.y + t.h) continue;
+        const float area = t.w * t.h;
+        if (best < 0 || area < bestArea) {
+            best = static_cast<int>(i);
+            bestArea = area;
+        }
+    }
+    return best;
+}
+
+// One of a frame's detections (a face, a plate) with its box_quality().
+struct DetBox {
+    float x = 0.f, y = 0.f, w = 0.f, h = 0.f;
+    float quality = 0.f;
+};
+
+// One-to-one association of a frame's detections with tracks: result[i] is the
+// index into `tracks` of detection i's track, or -1. Each detection's candidate
+// is its tightest containing track; candidate pairs are taken tightest track
+// first, then highest quality, and a track takes at most one detection. The
+// others inside a claimed track stay untracked (inferred every frame) rather
+// than falling back to a looser box, so two faces in one person box never share
+// that track's cached result.
+inline std::vector<int> associate(const std::vector<TrackBox>& tracks,
+                                  const std::vector<DetBox>& dets) {
+    struct Pair { float area; float quality; size_t di; int ti; };
+    std::vector<Pair> pairs;
+    pairs.reserve(dets.size());
+    for (size_t di = 0; di < dets.size(); ++di) {
+        const DetBox& d = dets[di];
+        const int ti = tightest_track(tracks, d.x, d.y, d.w, d.h);
+        if (ti >= 0) pairs.push_back({tracks[ti].w * tracks[ti].h, d.quality, di, ti});
+    }
+    std::sort(pairs.begin(), pairs.end(), [](const Pair& a, const Pair& b) {
+        if (a.area != b.area) return a.area < b.area;
+        if (a.quality != b.quality) return a.quality > b.quality;
+        return a.di < b.di;
+    });
+    std::vector<int> out(dets.size(), -1);
+    std::vector<bool> taken(tracks.size(), false);
+    for (const Pair& p : pairs) {
+        if (taken[p.ti]) continue;
+        taken[p.ti] = true;
+        out[p.di] = p.ti;
+    }
+    return out;
+}
+
+// Mean absolute 4-neighbour Laplacian of the luma inside a box of a packed
+// RGB24 image, sampled on at most grid x grid points. Higher = sharper.
+inline float region_sharpness(const uint8_t* rgb, int w, int h,
+                              float bx, float by, float bw, float bh, int grid = 32) {
+    if (!rgb || w < 3 || h < 3) return 0.f;
+    const int x0 = std::clamp(static_cast<int>(bx), 1, w - 2);
+    const int y0 = std::clamp(static_cast<int>(by), 1, h - 2);
+    const int x1 = std::clamp(static_cast<int>(bx + bw), 1, w - 2);
+    const int y1 = std::clamp(static_cast<int>(by + bh), 1, h - 2);
+    if (x1 <= x0 || y1 <= y0) return 0.f;
+    const int sx = std::max(1, (x1 - x0) / grid);
+    const int sy = std::max(1, (y1 - y0) / grid);
+    auto luma = [&](int x, int y) {
+        const uint8_t* p = rgb + (static_cast<size_t>(y) * w + x) * 3;
+        return (77 * p[0] + 150 * p[1] + 29 * p[2]) >> 8;
+    };
+    long sum = 0;
+    long n = 0;
+    for (int y = y0; y <= y1; y += sy)
+        for (int x = x0; x <= x1; x += sx) {
+            const int lap = 4 * luma(x, y) - luma(x - 1, y) - luma(x + 1, y) -
+                            luma(x, y - 1) - luma(x, y + 1);
+            sum += lap < 0 ? -lap : lap;
+            ++n;
+        }
+    return n ? static_cast<float>(sum) / n : 0.f;
+}
+
+// Relative quality of a detection for comparing observations of one track:
+// detector confidence x linear size x a sharpness term.
+inline float box_quality(float confidence, float w, float h, float sharpness) {
+    return std::max(0.f, confidence) * std::sqrt(std::max(0.f, w * h)) * std::sqrt(1.f + sharpness);
+}
+
+// Latest tracked boxes per stream. Written from the event callback thread,
+// read from on_frame; thread-safe.
+class TrackIndex {
+public:
+    void update(uint32_t stream, uint64_t pts, std::vector<TrackBox> boxes) {
+        std::lock_guard<std::mutex> lk(mtx_);
+        auto& s = streams_[stream];
+        s.pts = pts;
+        s.boxes = std::move(boxes);
+    }
+
+    // Boxes for `stream` if the newest tracked event is within max_age_us of
+    // `pts` (either side: events and frames race). False = no usable tracks.
+    bool latest(uint32_t stream, uint64_t pts, uint64_t max_age_us,
+                std::vector<TrackBox>& out) const {
+        std::lock_guard<std::mutex> lk(mtx_);
+        auto it = streams_.find(stream);
+        if (it == streams_.end()) return false;
+        const uint64_t d = pts > it->second.pts ? pts - it->second.pts : it->second.pts - pts;
+        if (d > max_age_us) return false;
+        out = it->second.boxes;
+        return true;
+    }
+
+private:
+    struct Snapshot {
+        uint64_t pts = 0;
+        std::vector<TrackBox> boxes;
+    };
+    mutable std::mutex mtx_;
+    std::unordered_map<uint32_t, Snapshot> streams_;
+};
+
+struct TrackCacheOptions {
+    uint64_t refresh_us = 5000000;     // re-run a track's inference at least this often
+    uint64_t miss_retry_us = 1000000;  // after finding nothing on a track, retry after this
+    float quality_gain = 1.25f;        // re-run when quality beats the cached one by this factor
+    uint64_t forget_us = 10000000;     // drop tracks not seen for this long
+};
+
+// Recognition result R cached per (stream, track_id). Single-threaded (used
+// from on_frame only).
+template <typename R>
+class TrackResultCache {
+public:
+    struct Entry {
+        bool has = false;
+        R result{};
+        float quality = 0.f;
+        RelBox rel;               // last seen sub-box relative to the track box
+        uint64_t resultPts = 0;   // when `result` was computed
+        uint64_t hitPts = 0;      // last frame the sub-box was seen
+        uint64_t missPts = 0;     // last detector pass that found nothing on the track
+        bool missed = false;      // the latest pass found nothing (missPts is current)
+    };
+
+    explicit TrackResultCache(TrackCacheOptions opt = {}) : opt_(opt) {}
+
+    const TrackCacheOptions& options() const { return opt_; }
+
+    const Entry* find(uint32_t stream, int track) const {
+        auto s = streams_.find(stream);
+        if (s == streams_.end()) return nullptr;
+        auto e = s->second.find(track);
+        return e == s->second.end() ? nullptr : &e->second;
+    }
+
+    // Result younger than the refresh interval.
+    bool fresh(const Entry& e, uint64_t pts) const {
+        return e.has && pts >= e.resultPts && pts - e.resultPts <= opt_.refresh_us;
+    }
+
+    // Whether a detection of `quality` on `track` needs inference.
+    bool needs_run(uint32_t stream, int track, float quality, uint64_t pts) const {
+        if (track <= 0) return true;
+        const Entry* e = find(stream, track);
+        return !e || !fresh(*e, pts) || quality > e->quality * opt_.quality_gain;
+    }
+
+    // True when every track is confirmed and has either a fresh result seen on
+    // its latest pass or a recent miss, so the detector can skip this frame.
+    bool covers(uint32_t stream, const std::vector<TrackBox>& tracks, uint64_t pts) const {
+        for (const auto& t : tracks) {
+            if (t.id <= 0) return false;
+            const Entry* e = find(stream, t.id);
+            if (!e) return false;
+            if (e->missed) {
+                if (pts < e->missPts || pts - e->missPts > opt_.miss_retry_us) return false;
+            } else if (!fresh(*e, pts)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // A newly computed result for `track`.
+    void store(uint32_t stream, int track, uint64_t pts, float quality, R result, RelBox rel) {
+        if (track <= 0) return;
+        Entry& e = streams_[stream][track];
+        e.has = true;
+        e.result = std::move(result);
+        e.quality = quality;
+        e.rel = rel;
+        e.resultPts = pts;
+        e.hitPts = pts;
+        e.missed = false;
+    }
+
+    // The sub-box was seen again and the cached result reused.
+    void hit(uint32_t stream, int track, uint64_t pts, RelBox rel) {
+        if (track <= 0) return;
+        Entry& e = streams_[stream][track];
+        e.rel = rel;
+        e.hitPts = pts;
+        e.missed = false;
+    }
+
+    // A detector pass found nothing on `track`.
+    void miss(uint32_t stream, int track, uint64_t pts) {
+        if (track <= 0) return;
+        Entry& e = streams_[stream][track];
+        e.missPts = pts;
+        e.missed = true;
+    }
+
+    // Forget tracks of `stream` not seen within forget_us; a pts that goes
+    // backwards (stream restart) clears the stream.
+    void expire(uint32_t stream, uint64_t pts) {
+        auto s = streams_.find(stream);
+        if (s == streams_.end()) return;
+        for (auto it = s->second.begin(); it != s->second.end();) {
+            const uint64_t last = std::max({it->second.resultPts, it->second.hitPts, it->second.missPts});
+            if (pts < last || pts - last > opt_.forget_us) it = s->second.erase(it);
+            else ++it;
+        }
+    }
+
+    size_t size(uint32_t stream) const {
+        auto s = streams_.find(stream);
+        return s == streams_.end() ? 0 : s->second.size();
+    }
+
+private:
+    TrackCacheOptions opt_;
+    std::unordered_map<uint32_t, std::unordered_map<int, Entry>> streams_;
+};
+
+}  // namespace track
+}  // namespace zm
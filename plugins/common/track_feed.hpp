@@ -0,0 +1,97 @@
+#pragma once
+
+// Host glue for track_cache.hpp: subscribe to the tracker's tracked_detection
+// events and keep the newest tracked boxes of the wanted labels per stream.
+// Header-only; consumers link nlohmann_json and add this dir to their include
+// path.
+//
+//   auto* feed = zm::track::subscribe_tracks(host, host_ctx, {"person"});  // start()
+//   std::vector<zm::track::TrackBox> t;
+//   if (feed->index.latest(sid, pts, max_age_us, t)) ...                   // on_frame()
+//   zm::track::unsubscribe_tracks(host, host_ctx, feed);                    // stop()
+//
+// LIFETIME mirrors tracker.cpp/overlay.cpp: the feed is the subscription's
+// `user` pointer and is intentionally leaked on unsubscribe so an in-flight
+// callback never touches freed memory.
+
+#include "track_cache.hpp"
+#include "zm_plugin.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace zm {
+namespace track {
+
+struct TrackFeed {
+    std::atomic<bool> running{true};
+    void* subHandle = nullptr;
+    std::vector<std::string> labels;  // empty = every label
+    TrackIndex index;
+};
+
+// Apply one host event to `feed` (ignored unless it is a tracked_detection).
+inline void apply_tracked_event(TrackFeed& feed, const char* event) {
+    // Cheap pre-filter: every plugin event reaches every subscriber.
+    if (!event || !std::strstr(event, "\"tracked_detection\"")) return;
+    nlohmann::json j = nlohmann::json::parse(event, nullptr, false);
+    if (j.is_discarded() || !j.is_object() ||
+        j.value("type", std::string()) != "tracked_detection")
+        return;
+    const auto stream = static_cast<uint32_t>(j.value("stream_id", 0));
+    const auto pts = j.value("pts_usec", static_cast<uint64_t>(0));
+    std::vector<TrackBox> boxes;
+    if (j.contains("detections") && j["detections"].is_array()) {
+        for (const auto& d : j["detections"]) {
+            if (!d.is_object() || !d.contains("bbox") || !d["bbox"].is_array() ||
+                d["bbox"].size() < 4)
+                continue;
+            TrackBox b;
+            b.label = d.value("label", std::string());
+            if (!feed.labels.empty() &&
+                std::find(feed.labels.begin(), feed.labels.end(), b.label) == feed.labels.end())
+                continue;
+            b.id = d.value("track_id", 0);
+            b.x = d["bbox"][0].get<float>();
+            b.y = d["bbox"][1].get<float>();
+            b.w = d["bbox"][2].get<float>();
+            b.h = d["bbox"][3].get<float>();
+            boxes.push_back(std::move(b));
+        }
+    }
+    feed.index.update(stream, pts, std::move(boxes));
+}
+
+inline TrackFeed* subscribe_tracks(zm_host_api_t* host, void* host_ctx,
+                                   std::vector<std::string> labels) {
+    if (!host || !host->subscribe_evt) return nullptr;
+    auto* feed = new TrackFeed();  // leaked on unsubscribe (see above)
+    feed->labels = std::move(labels);
+    feed->subHandle = host->subscribe_evt(
+        host_ctx,
+        [](void* user, const char* event) {
+            auto* f = static_cast<TrackFeed*>(user);
+            if (!f->running.load()) return;
+            try {
+                apply_tracked_event(*f, event);
+            } catch (const std::exception&) {
+                // malformed bbox values; keep the previous snapshot
+            }
+        },
+        feed);
+    return feed;
+}
+
+inline void unsubscribe_tracks(zm_host_api_t* host, void* host_ctx, TrackFeed* feed) {
+    if (!feed) return;
+    if (host && host->unsubscribe_evt) host->unsubscribe_evt(host_ctx, feed->subHandle);
+    feed->running.store(false);
+}
+
+}  // namespace track
+}  // namespace zm
@@ -1,6 +1,10 @@
 // decode_ffmpeg.cpp - ZM_PLUG_PROCESS plugin for FFmpeg decoding
 #include <zm_plugin.h>
 #include <nlohmann/json.hpp>
+#include "decode_pacer.hpp"
+#include "output_pyramid.hpp"
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <vector>
 #include <string>
@@ -9,6 +13,7 @@
 #include <thread>
 #include <atomic>
 #include <sstream>
+#include <stdexcept>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -64,11 +69,32 @@ static std::string get_av_error_string(int errnum) {
     return std::string(errbuf);
 }
 
+// One emitted resolution/format. A decoder has one (top-level "scale" /
+// "output_format") or several ("outputs"); frames are tagged with the output
+// index (ZM_FRAME_OUTPUT) so each child branch receives only the one it selects.
+struct DecodeOutput {
+    std::string name;
+    std::string scale = "orig";
+    std::string format = "yuv420p";
+    AVPixelFormat pix_fmt = AV_PIX_FMT_YUV420P;
+    uint32_t frame_type = ZM_FRAME_YUV420P;
+    int width = 0, height = 0;
+    SwsContext* sws = nullptr;
+    int sws_w = 0, sws_h = 0;                  // source the sws context was built for
+    AVPixelFormat sws_fmt = AV_PIX_FMT_NONE;
+    std::vector<uint8_t> buf;                  // [zm_frame_hdr_t][pixels], reused per frame
+    uint8_t* planes[4] = {};
+    int linesize[4] = {};
+};
+
 struct DecoderCtx {
     int threads = 0;
     std::vector<int> stream_filter;   // empty = decode every stream; else only these
-    std::string scale = "orig";
-    std::string output_format = "yuv420p";
+    std::vector<DecodeOutput> outputs;
+    // Production order/sources for the outputs, rebuilt when the decoded size changes.
+    std::vector<zm::decode::PyramidStep> plan;
+    int plan_w = 0, plan_h = 0;
+    AVPixelFormat plan_fmt = AV_PIX_FMT_NONE;
     std::string codec_name = "h264";     // input codec fallback (h264/hevc/...)
     bool auto_codec = true;              // auto-detect input codec from StreamMetadata
     bool decoder_ready = false;          // decoder created lazily on first frame
@@ -81,20 +107,25 @@ struct DecoderCtx {
     bool use_cuda = false;               // CUDA zero-copy surface path active
     AVBufferRef* hw_device_ctx = nullptr;
     AVCodecContext* codec_ctx = nullptr;
-    SwsContext* sws_ctx = nullptr;
     AVFrame* sw_frame = nullptr;         // for downloading non-CUDA hw frames
-    int out_width = 0, out_height = 0;
-    AVPixelFormat out_pix_fmt = AV_PIX_FMT_YUV420P;
-    std::vector<uint8_t> frame_buf;
     zm_host_api_t* host = nullptr;
     void* host_ctx = nullptr;
     std::mutex mtx;
     std::atomic<bool> running{true};
     int decode_errors = 0;
     int frames_decoded = 0;
+    // Decimated analysis-rate decode (analysis_fps > 0), boosted to full rate
+    // while motion/track events arrive.
+    zm::decode::DecodePacer pacer;
+    struct DecodeActivity* activity = nullptr;  // leaked (callback-shared)
+    void* activity_sub = nullptr;
+    // Backpressure decimation requested by the host (zm_plugin_control);
+    // written from a host thread, applied to `decimator` under mtx.
+    std::atomic<int> keep_every{1};
+    zm::decode::Decimator decimator;
     ~DecoderCtx() {
         if (codec_ctx) avcodec_free_context(&codec_ctx);
-        if (sws_ctx) sws_freeContext(sws_ctx);
+        for (auto& o : outputs) if (o.sws) sws_freeContext(o.sws);
         if (sw_frame) av_frame_free(&sw_frame);
         if (hw_device_ctx) av_buffer_unref(&hw_device_ctx);
     }
@@ -153,6 +184,42 @@ static void decode_meta_cb(void* user, const char* json_event) {
     }
 }
 
+static int64_t steady_usec() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Activity state for the decimated decode boost. Leaked on stop like DecodeMeta.
+struct DecodeActivity {
+    std::vector<std::string> types;              // event types that boost ("motion", ...)
+    std::atomic<int64_t> last_usec{INT64_MIN};   // steady clock of the latest one
+    std::atomic<bool> running{true};
+};
+
+// Host event callback: any configured activity event (motion, tracked_detection)
+// steps decode up to full rate for boost_hold_sec.
+static void decode_activity_cb(void* user, const char* json_event) {
+    auto* act = static_cast<DecodeActivity*>(user);
+    if (!act || !act->running.load() || !json_event) return;
+    try {
+        auto j = nlohmann::json::parse(json_event);
+        const std::string type = j.value("type", std::string());
+        for (const auto& t : act->types) {
+            if (t == type) { act->last_usec.store(steady_usec()); return; }
+        }
+    } catch (...) {
+        // ignore malformed events
+    }
+}
+
+static enum AVDiscard to_av_discard(zm::decode::Discard d) {
+    switch (d) {
+        case zm::decode::Discard::NonKey: return AVDISCARD_NONKEY;
+        case zm::decode::Discard::NonRef: return AVDISCARD_NONREF;
+        default:                          return AVDISCARD_DEFAULT;
+    }
+}
+
 // Lazily create the decoder on the first frame, choosing the codec from the
 // auto-detected StreamMetadata id when available, else the configured fallback.
 static bool ensure_decoder(DecoderCtx* ctx) {
@@ -229,7 +296,7 @@ static bool ensure_decoder(DecoderCtx* ctx) {
     ctx->decoder_ready = true;
     log(ctx->host, ctx->host_ctx, 4, std::string("decode_ffmpeg: decoder ready codec=") +
         (codec->name ? codec->name : "?") + " (" + (ctx->auto_codec ? "auto" : "configured") +
-        "), output_format=" + ctx->output_format + ", hwaccel=" + ctx->hwaccel);
+        "), outputs=" + std::to_string(ctx->outputs.size()) + ", hwaccel=" + ctx->hwaccel);
     // Stop listening for metadata once the decoder exists.
     if (ctx->host && ctx->host->unsubscribe_evt && ctx->meta_sub) {
         ctx->host->unsubscribe_evt(ctx->host_ctx, ctx->meta_sub);
@@ -250,8 +317,30 @@ static int process_start(zm_plugin_t* plugin, zm_host_api_t* host, void* host_ct
         ctx->threads = cfg.value("threads", 0);
         if (cfg.contains("stream_filter") && cfg["stream_filter"].is_array())
             ctx->stream_filter = cfg["stream_filter"].get<std::vector<int>>();
-        ctx->scale = cfg.value("scale", "orig");
-        ctx->output_format = cfg.value("output_format", "yuv420p");
+        // "outputs" emits several resolutions/formats from the one decode;
+        // without it the top-level scale/output_format describe a single output.
+        auto add_output = [&](const json& o, const std::string& default_name) {
+            DecodeOutput out;
+            out.name = o.value("name", default_name);
+            out.scale = o.value("scale", std::string("orig"));
+            out.format = o.value("output_format", std::string("yuv420p"));
+            if (out.format == "rgb24") {
+                out.pix_fmt = AV_PIX_FMT_RGB24;
+                out.frame_type = ZM_FRAME_RGB24;
+            } else if (out.format == "gray" || out.format == "gray8") {
+                out.pix_fmt = AV_PIX_FMT_GRAY8;
+                out.frame_type = ZM_FRAME_GRAYSCALE;
+            }
+            ctx->outputs.push_back(std::move(out));
+        };
+        if (cfg.contains("outputs") && cfg["outputs"].is_array() && !cfg["outputs"].empty()) {
+            for (const auto& o : cfg["outputs"])
+                add_output(o, "out" + std::to_string(ctx->outputs.size()));
+        } else {
+            add_output(cfg, "default");
+        }
+        if (ctx->outputs.size() > (ZM_FRAME_OUTPUT_MASK >> ZM_FRAME_OUTPUT_SHIFT) + 1u)
+            throw std::runtime_error("too many outputs");
         // "codec" is an OPTIONAL override; without it the input codec is
         // auto-detected from the capture plugin's StreamMetadata.
         if (cfg.contains("codec")) {
@@ -261,12 +350,20 @@ static int process_start(zm_plugin_t* plugin, zm_host_api_t* host, void* host_ct
         ctx->hw_decode = cfg.value("hw_decode", false);
         ctx->hwaccel = cfg.value("hwaccel", std::string("none"));
 
-        if (ctx->output_format == "rgb24") {
-            ctx->out_pix_fmt = AV_PIX_FMT_RGB24;
-        } else if (ctx->output_format == "gray" || ctx->output_format == "gray8") {
-            ctx->out_pix_fmt = AV_PIX_FMT_GRAY8;
-        } else {
-            ctx->out_pix_fmt = AV_PIX_FMT_YUV420P;
+        // Analysis-rate decode: decode only keyframes ("keyframes") or only
+        // reference frames ("nonref"), emit at most analysis_fps, and step up to
+        // full rate while boost_on events arrive.
+        zm::decode::PacerConfig pc;
+        pc.analysis_fps = cfg.value("analysis_fps", 0.0);
+        pc.mode = cfg.value("decimate", std::string("nonref")) == "keyframes"
+                      ? zm::decode::DecimateMode::Keyframes
+                      : zm::decode::DecimateMode::NonRef;
+        pc.boost_hold_usec = static_cast<int64_t>(cfg.value("boost_hold_sec", 3.0) * 1e6);
+        ctx->pacer = zm::decode::DecodePacer(pc);
+        if (ctx->pacer.enabled()) {
+            ctx->activity = new DecodeActivity();
+            ctx->activity->types = cfg.value("boost_on",
+                std::vector<std::string>{"motion", "tracked_detection"});
         }
     } catch (...) {
         log(host, host_ctx, 3, "decode_ffmpeg: failed to parse config");
@@ -279,9 +376,12 @@ static int process_start(zm_plugin_t* plugin, zm_host_api_t* host, void* host_ct
     ctx->meta = new DecodeMeta();
     if (host && host->subscribe_evt)
         ctx->meta_sub = host->subscribe_evt(host_ctx, &decode_meta_cb, ctx->meta);
+    if (ctx->activity && host && host->subscribe_evt)
+        ctx->activity_sub = host->subscribe_evt(host_ctx, &decode_activity_cb, ctx->activity);
 
     log(host, host_ctx, 4, std::string("decode_ffmpeg: started (codec=") +
-        (ctx->auto_codec ? "auto" : ctx->codec_name) + ")");
+        (ctx->auto_codec ? "auto" : ctx->codec_name) +
+        (ctx->pacer.enabled() ? ", decimated analysis decode" : "") + ")");
     plugin->instance = ctx;
     return 0;
 }
@@ -295,11 +395,73 @@ static void process_stop(zm_plugin_t* plugin) {
     if (ctx->host && ctx->host->unsubscribe_evt && ctx->meta_sub)
         ctx->host->unsubscribe_evt(ctx->host_ctx, ctx->meta_sub);
     if (ctx->meta) ctx->meta->running.store(false);
+    if (ctx->host && ctx->host->unsubscribe_evt && ctx->activity_sub)
+        ctx->host->unsubscribe_evt(ctx->host_ctx, ctx->activity_sub);
+    if (ctx->activity) ctx->activity->running.store(false);
     delete ctx;
     plugin->instance = nullptr;
 }
 
 
+// Send a GPU surface descriptor to every output. The surface stays on the
+// device, so each branch's consumer scales it itself.
+static void emit_to_outputs(DecoderCtx* ctx, std::vector<uint8_t>& buf) {
+    if (!ctx->host || !ctx->host->on_frame) return;
+    auto* h = reinterpret_cast<zm_frame_hdr_t*>(buf.data());
+    for (size_t i = 0; i < ctx->outputs.size(); ++i) {
+        h->flags = (h->flags & ~(ZM_FRAME_OUTPUT_MASK | ZM_FRAME_FLAG_SIDE_DATA)) |
+                   (static_cast<uint32_t>(i) << ZM_FRAME_OUTPUT_SHIFT);
+        ctx->host->on_frame(ctx->host_ctx, buf.data(), buf.size());
+    }
+}
+
+// Convert/scale `src` (the decoded frame or an earlier output) into `out`'s
+// reusable buffer, after the space reserved for the frame header.
+static bool produce_output(DecoderCtx* ctx, DecodeOutput& out, const uint8_t* const src[],
+                           const int src_linesize[], int src_w, int src_h,
+                           AVPixelFormat src_fmt) {
+    const int size = av_image_get_buffer_size(out.pix_fmt, out.width, out.height, 1);
+    if (size < 0) {
+        log(ctx->host, ctx->host_ctx, 3, "decode_ffmpeg: failed to calculate output buffer size");
+        return false;
+    }
+    out.buf.resize(sizeof(zm_frame_hdr_t) + size);
+    uint8_t* dst = out.buf.data() + sizeof(zm_frame_hdr_t);
+    if (av_image_fill_arrays(out.planes, out.linesize, dst, out.pix_fmt,
+                             out.width, out.height, 1) < 0) {
+        log(ctx->host, ctx->host_ctx, 3, "decode_ffmpeg: failed to setup output arrays");
+        return false;
+    }
+    if (src_fmt == out.pix_fmt && src_w == out.width && src_h == out.height) {
+        // Direct copy when no conversion needed
+        av_image_copy_to_buffer(dst, size, src, src_linesize, out.pix_fmt,
+                                out.width, out.height, 1);
+        return true;
+    }
+    if (!out.sws || out.sws_w != src_w || out.sws_h != src_h || out.sws_fmt != src_fmt) {
+        if (out.sws) sws_freeContext(out.sws);
+        out.sws = sws_getContext(src_w, src_h, src_fmt, out.width, out.height, out.pix_fmt,
+                                 SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (!out.sws) {
+            log(ctx->host, ctx->host_ctx, 3, "decode_ffmpeg: failed to create swscale context");
+            return false;
+        }
+        out.sws_w = src_w;
+        out.sws_h = src_h;
+        out.sws_fmt = src_fmt;
+        std::ostringstream oss;
+        oss << "decode_ffmpeg: created swscale " << src_w << "x" << src_h << " "
+            << av_get_pix_fmt_name(src_fmt) << " -> " << out.width << "x" << out.height
+            << " " << av_get_pix_fmt_name(out.pix_fmt) << " (output " << out.name << ")";
+        log(ctx->host, ctx->host_ctx, 4, oss.str());
+    }
+    if (sws_scale(out.sws, src, src_linesize, 0, src_h, out.planes, out.linesize) < 0) {
+        log(ctx->host, ctx->host_ctx, 3, "decode_ffmpeg: swscale failed");
+        return false;
+    }
+    return true;
+}
+
 // Standardized single-buffer on_frame: buf = [zm_frame_hdr_t][payload]
 static void process_on_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
     if (!plugin || !plugin->instance || !buf || size < sizeof(zm_frame_hdr_t)) return;
@@ -328,7 +490,25 @@ static void process_on_frame(zm_plugin_t* plugin, const void* buf, size_t size)
     if (size < sizeof(zm_frame_hdr_t) + hdr->bytes) return;
     
     const uint8_t* payload = (const uint8_t*)buf + sizeof(zm_frame_hdr_t);
-    
+
+    // Decimated decode: drop packets the analysis rate (or a congested
+    // downstream stage) doesn't need before they cost anything, and tell the
+    // decoder which frames it may discard.
+    const bool keyframe = (hdr->flags & 1) != 0;
+    bool admit = true;
+    zm::decode::Discard discard = zm::decode::Discard::Default;
+    if (ctx->pacer.enabled()) {
+        const int64_t now = steady_usec();
+        const int64_t last = ctx->activity ? ctx->activity->last_usec.load() : INT64_MIN;
+        if (last != INT64_MIN) ctx->pacer.on_activity(last);
+        admit = ctx->pacer.admit_packet(keyframe, now);
+        discard = ctx->pacer.discard();
+    }
+    ctx->decimator.set_keep_every(ctx->keep_every.load(std::memory_order_relaxed));
+    admit = ctx->decimator.admit_packet(keyframe) && admit;
+    if (!admit) return;
+    ctx->codec_ctx->skip_frame = to_av_discard(zm::decode::stronger(discard, ctx->decimator.discard()));
+
     AVPacket* pkt = av_packet_alloc();
     if (!pkt) {
         log(ctx->host, ctx->host_ctx, 3, "decode_ffmpeg: failed to allocate packet");
@@ -365,6 +545,12 @@ static void process_on_frame(zm_plugin_t* plugin, const void* buf, size_t size)
     
     while (avcodec_receive_frame(ctx->codec_ctx, avf) == 0) {
         ctx->frames_decoded++;
+        // Analysis-rate pacing: skip frames above analysis_fps before any
+        // download/convert/copy work.
+        if (!ctx->pacer.emit_frame(avf->best_effort_timestamp) || !ctx->decimator.emit_frame()) {
+            av_frame_unref(avf);
+            continue;
+        }
 
         // Zero-copy GPU path: the frame is a CUDA surface. Emit a descriptor
         // referencing the device memory instead of downloading/converting on CPU.
@@ -391,8 +577,7 @@ static void process_on_frame(zm_plugin_t* plugin, const void* buf, size_t size)
             memcpy(out_buf.data(), &out_hdr, sizeof(zm_frame_hdr_t));
             memcpy(out_buf.data() + sizeof(zm_frame_hdr_t), &g, sizeof(zm_gpu_frame_t));
 
-            if (ctx->host && ctx->host->on_frame)
-                ctx->host->on_frame(ctx->host_ctx, out_buf.data(), out_buf.size());
+            emit_to_outputs(ctx, out_buf);
             av_frame_unref(avf);
             continue;  // next frame; skip the CPU swscale path below
         }
@@ -418,8 +603,7 @@ static void process_on_frame(zm_plugin_t* plugin, const void* buf, size_t size)
             memcpy(out_buf.data(), &out_hdr, sizeof(zm_frame_hdr_t));
             memcpy(out_buf.data() + sizeof(zm_frame_hdr_t), &g, sizeof(zm_gpu_frame_t));
 
-            if (ctx->host && ctx->host->on_frame)
-                ctx->host->on_frame(ctx->host_ctx, out_buf.data(), out_buf.size());
+            emit_to_outputs(ctx, out_buf);
             av_frame_unref(avf);
             continue;  // skip the CPU download/swscale path below
         }
@@ -440,133 +624,103 @@ static void process_on_frame(zm_plugin_t* plugin, const void* buf, size_t size)
             avf->best_effort_timestamp = pts;
         }
 
-        int w = avf->width, h = avf->height;
-        AVPixelFormat src_pix_fmt = (AVPixelFormat)avf->format;
-        
+        const int w = avf->width, h = avf->height;
+        const AVPixelFormat src_pix_fmt = (AVPixelFormat)avf->format;
+
         // Log frame info occasionally
         if (ctx->frames_decoded % 100 == 1) {
             std::ostringstream oss;
-            oss << "decode_ffmpeg: decoded frame #" << ctx->frames_decoded 
+            oss << "decode_ffmpeg: decoded frame #" << ctx->frames_decoded
                 << " size=" << w << "x" << h << " fmt=" << av_get_pix_fmt_name(src_pix_fmt);
             log(ctx->host, ctx->host_ctx, 4, oss.str());
         }
-        
-        // Setup output dimensions
-        if (ctx->scale != "orig") {
-            if (ctx->scale == "720p") {
-                ctx->out_width = 1280; 
-                ctx->out_height = 720;
-            } else if (ctx->scale.find('x') != std::string::npos) {
-                sscanf(ctx->scale.c_str(), "%dx%d", &ctx->out_width, &ctx->out_height);
-            } else {
-                ctx->out_width = w; 
-                ctx->out_height = h;
-            }
-        } else {
-            ctx->out_width = w; 
-            ctx->out_height = h;
-        }
-        
-        // Setup swscale context if needed (format conversion or scaling)
-        bool needs_conversion = (src_pix_fmt != ctx->out_pix_fmt) || 
-                               (ctx->out_width != w) || (ctx->out_height != h);
-        
-        if (needs_conversion) {
-            if (ctx->sws_ctx == nullptr || 
-                ctx->out_width != w || ctx->out_height != h) {
-                if (ctx->sws_ctx) sws_freeContext(ctx->sws_ctx);
-                
-                ctx->sws_ctx = sws_getContext(
-                    w, h, src_pix_fmt,
-                    ctx->out_width, ctx->out_height, ctx->out_pix_fmt,
-                    SWS_BILINEAR, nullptr, nullptr, nullptr);
-                
-                if (!ctx->sws_ctx) {
-                    log(ctx->host, ctx->host_ctx, 3, "decode_ffmpeg: failed to create swscale context");
-                    av_frame_free(&avf);
-                    return;
-                }
-                
-                std::ostringstream oss;
-                oss << "decode_ffmpeg: created swscale " << w << "x" << h << " " 
-                    << av_get_pix_fmt_name(src_pix_fmt) << " -> " 
-                    << ctx->out_width << "x" << ctx->out_height << " " 
-                    << av_get_pix_fmt_name(ctx->out_pix_fmt);
-                log(ctx->host, ctx->host_ctx, 4, oss.str());
+
+        // (Re)plan the output pyramid when the decoded size/format changes.
+        if (w != ctx->plan_w || h != ctx->plan_h || src_pix_fmt != ctx->plan_fmt) {
+            std::vector<zm::decode::PyramidLevel> levels;
+            for (auto& o : ctx->outputs) {
+                if (!zm::decode::resolve_scale(o.scale, w, h, o.width, o.height))
+                    log(ctx->host, ctx->host_ctx, 2, "decode_ffmpeg: bad scale '" + o.scale +
+                        "' for output " + o.name + "; using the decoded size");
+                levels.push_back({o.width, o.height, o.pix_fmt == AV_PIX_FMT_YUV420P});
             }
+            ctx->plan = zm::decode::plan_pyramid(levels, w, h);
+            ctx->plan_w = w;
+            ctx->plan_h = h;
+            ctx->plan_fmt = src_pix_fmt;
         }
-        
-        // Calculate output buffer size
-        int out_size = av_image_get_buffer_size(ctx->out_pix_fmt, ctx->out_width, ctx->out_height, 1);
-        if (out_size < 0) {
-            log(ctx->host, ctx->host_ctx, 3, "decode_ffmpeg: failed to calculate output buffer size");
-            av_frame_free(&avf);
-            return;
-        }
-        
-        ctx->frame_buf.resize(out_size);
-        
-        if (needs_conversion && ctx->sws_ctx) {
-            // Use swscale for format conversion/scaling
-            uint8_t* dst_data[4];
-            int dst_linesize[4];
-            
-            ret = av_image_fill_arrays(dst_data, dst_linesize, ctx->frame_buf.data(), 
-                                     ctx->out_pix_fmt, ctx->out_width, ctx->out_height, 1);
-            if (ret < 0) {
-                log(ctx->host, ctx->host_ctx, 3, "decode_ffmpeg: failed to setup output arrays");
-                av_frame_free(&avf);
-                return;
-            }
-            
-            ret = sws_scale(ctx->sws_ctx, avf->data, avf->linesize, 0, h, dst_data, dst_linesize);
-            if (ret < 0) {
-                log(ctx->host, ctx->host_ctx, 3, "decode_ffmpeg: swscale failed");
-                av_frame_free(&avf);
-                return;
+
+        // Produce every output (largest first, each from the cheapest covering
+        // source) straight into its reusable [header][pixels] buffer, then
+        // send it tagged with its output index.
+        size_t out_bytes = 0;
+        std::vector<bool> ready(ctx->outputs.size(), false);
+        for (const auto& step : ctx->plan) {
+            DecodeOutput& out = ctx->outputs[step.output];
+            bool ok;
+            if (step.source >= 0 && ready[step.source]) {
+                const DecodeOutput& src = ctx->outputs[step.source];
+                ok = produce_output(ctx, out, src.planes, src.linesize,
+                                    src.width, src.height, src.pix_fmt);
+            } else {
+                ok = produce_output(ctx, out, avf->data, avf->linesize, w, h, src_pix_fmt);
             }
-        } else {
-            // Direct copy when no conversion needed
-            av_image_copy_to_buffer(ctx->frame_buf.data(), out_size, 
-                                  (const uint8_t**)avf->data, avf->linesize,
-                                  ctx->out_pix_fmt, ctx->out_width, ctx->out_height, 1);
-        }
-        
-        // Allocate output buffer with header
-        std::vector<uint8_t> out_buf(sizeof(zm_frame_hdr_t) + ctx->frame_buf.size());
-        zm_frame_hdr_t out_hdr = *hdr;
-        
-        // Set frame format based on output pixel format
-        if (ctx->out_pix_fmt == AV_PIX_FMT_RGB24) {
-            out_hdr.hw_type = ZM_FRAME_RGB24;
-        } else if (ctx->out_pix_fmt == AV_PIX_FMT_GRAY8) {
-            out_hdr.hw_type = ZM_FRAME_GRAYSCALE;
-        } else {
-            out_hdr.hw_type = ZM_FRAME_YUV420P;
-        }
-        
-        out_hdr.bytes = ctx->frame_buf.size();
-        out_hdr.pts_usec = avf->best_effort_timestamp;
-        
-        memcpy(out_buf.data(), &out_hdr, sizeof(zm_frame_hdr_t));
-        memcpy(out_buf.data() + sizeof(zm_frame_hdr_t), ctx->frame_buf.data(), ctx->frame_buf.size());
-        
-        // Send frame to next plugin
-        if (ctx->host && ctx->host->on_frame) {
-            ctx->host->on_frame(ctx->host_ctx, out_buf.data(), out_buf.size());
+            if (!ok) continue;
+            ready[step.output] = true;
+
+            zm_frame_hdr_t out_hdr = *hdr;
+            out_hdr.hw_type = out.frame_type;
+            out_hdr.bytes = static_cast<uint32_t>(out.buf.size() - sizeof(zm_frame_hdr_t));
+            out_hdr.pts_usec = avf->best_effort_timestamp;
+            // The packet's side data (if any) is not copied into the decoded frame.
+            out_hdr.flags = (hdr->flags & ~(ZM_FRAME_OUTPUT_MASK | ZM_FRAME_FLAG_SIDE_DATA)) |
+                            (static_cast<uint32_t>(step.output) << ZM_FRAME_OUTPUT_SHIFT);
+            memcpy(out.buf.data(), &out_hdr, sizeof(zm_frame_hdr_t));
+            out_bytes += out.buf.size();
+
+            // Send frame to next plugin
+            if (ctx->host && ctx->host->on_frame)
+                ctx->host->on_frame(ctx->host_ctx, out.buf.data(), out.buf.size());
         }
-        
+        av_frame_unref(avf);
+
         // Log successful frame processing occasionally
         if (ctx->frames_decoded % 100 == 0) {
             std::ostringstream oss;
-            oss << "decode_ffmpeg: processed " << ctx->frames_decoded << " frames, " 
-                << ctx->decode_errors << " errors, output=" << ctx->frame_buf.size() << " bytes";
+            oss << "decode_ffmpeg: processed " << ctx->frames_decoded << " frames, "
+                << ctx->decode_errors << " errors, output=" << out_bytes << " bytes in "
+                << ctx->outputs.size() << " output(s)";
+            if (ctx->pacer.enabled())
+                oss << ", packets skipped=" << ctx->pacer.packets_skipped()
+                    << ", frames paced out=" << ctx->pacer.frames_paced_out()
+                    << (ctx->pacer.full_rate() ? " (full rate)" : "");
+            if (ctx->decimator.active())
+                oss << ", backpressure keep 1/" << ctx->decimator.keep_every()
+                    << (ctx->decimator.keyframes_only() ? " (keyframes only)" : "");
             log(ctx->host, ctx->host_ctx, 4, oss.str());
         }
     }
     av_frame_free(&avf);
 }
 
+// Host control messages (ZM_PLUGIN_CONTROL_SYMBOL). Only records the request;
+// process_on_frame applies it to the next packet.
+extern "C" __attribute__((visibility("default"))) void zm_plugin_control(zm_plugin_t* plugin, const char* json_msg) {
+    if (!plugin || !plugin->instance || !json_msg) return;
+    auto ctx = static_cast<DecoderCtx*>(plugin->instance);
+    try {
+        auto j = nlohmann::json::parse(json_msg);
+        if (j.value("type", std::string()) != "rate_control") return;
+        const int keep = std::max(1, j.value("keep_every", 1));
+        if (ctx->keep_every.exchange(keep, std::memory_order_relaxed) == keep) return;
+        log(ctx->host, ctx->host_ctx, 1,
+            "decode_ffmpeg: rate_control keep 1/" + std::to_string(keep) + " (" +
+            j.value("reason", std::string("?")) + ", stage " + j.value("stage", std::string("?")) + ")");
+    } catch (...) {
+        // ignore malformed messages
+    }
+}
+
 extern "C" __attribute__((visibility("default"))) void zm_plugin_init(zm_plugin_t* plugin) {
     if (!plugin) return;
     plugin->version = 1;
@@ -0,0 +1,167 @@
+#pragma once
+
+// Pure, dependency-free pacing policy for decimated ("analysis rate") decode.
+// Kept separate from the plugin so it can be unit-tested without FFmpeg.
+//
+// With a target `analysis_fps` the decoder stops paying for frames nobody looks
+// at: in Keyframes mode non-key packets are dropped before they reach the
+// decoder, in NonRef mode they are sent but the decoder discards non-reference
+// frames (skip_frame = AVDISCARD_NONREF). Decoded frames are then rate-limited
+// by pts to analysis_fps. While motion/track activity is reported the pacer
+// steps up to full-rate decode for `boost_hold_usec` after the last activity.
+
+#include <cstdint>
+
+namespace zm::decode {
+
+enum class DecimateMode { Keyframes, NonRef };
+
+// Decoder discard level to apply (maps to AVCodecContext::skip_frame).
+enum class Discard { Default, NonRef, NonKey };
+
+// The level that discards more of the two.
+inline Discard stronger(Discard a, Discard b) { return a > b ? a : b; }
+
+struct PacerConfig {
+    double analysis_fps = 0;          // 0 = full rate (pacer disabled)
+    DecimateMode mode = DecimateMode::NonRef;
+    int64_t boost_hold_usec = 3000000;
+};
+
+class DecodePacer {
+public:
+    explicit DecodePacer(PacerConfig cfg = {}) : cfg_(cfg) {
+        interval_usec_ = cfg_.analysis_fps > 0 ? static_cast<int64_t>(1e6 / cfg_.analysis_fps) : 0;
+    }
+
+    bool enabled() const { return interval_usec_ > 0; }
+
+    // Motion/track activity seen at `now_usec` (monotonic clock).
+    void on_activity(int64_t now_usec) {
+        const int64_t until = now_usec + cfg_.boost_hold_usec;
+        if (until > boost_until_) boost_until_ = until;
+    }
+    bool boosted(int64_t now_usec) const { return now_usec < boost_until_; }
+
+    // Decide whether a compressed packet goes to the decoder at all. Also
+    // updates full_rate(): in Keyframes mode the step up to full rate waits for
+    // a keyframe, since the dropped packets left no reference chain to decode
+    // P-frames against. NonRef mode keeps every reference, so it switches at once.
+    bool admit_packet(bool keyframe, int64_t now_usec) {
+        if (!enabled()) return true;
+        const bool want_full = boosted(now_usec);
+        if (cfg_.mode == DecimateMode::NonRef) {
+            full_ = want_full;
+            return true;
+        }
+        if (!want_full) full_ = false;
+        else if (keyframe) full_ = true;
+        if (full_ || keyframe) return true;
+        ++packets_skipped_;
+        return false;
+    }
+
+    // Discard level for the packet just admitted.
+    Discard discard() const {
+        if (!enabled() || full_) return Discard::Default;
+        return cfg_.mode == DecimateMode::Keyframes ? Discard::NonKey : Discard::NonRef;
+    }
+
+    bool full_rate() const { return !enabled() || full_; }
+
+    // Rate-limit decoded frames to analysis_fps by pts. The due time advances
+    // by whole intervals so the output cadence doesn't drift with source
+    // jitter; a pts jump (gap, stream restart) re-anchors it.
+    bool emit_frame(int64_t pts_usec) {
+        if (full_rate()) {
+            next_due_ = pts_usec + interval_usec_;
+            has_due_ = enabled();
+            return true;
+        }
+        if (has_due_ && pts_usec < next_due_ && next_due_ - pts_usec <= 2 * interval_usec_) {
+            ++frames_paced_out_;
+            return false;
+        }
+        if (has_due_ && pts_usec >= next_due_ && pts_usec - next_due_ < interval_usec_)
+            next_due_ += interval_usec_;
+        else
+            next_due_ = pts_usec + interval_usec_;
+        has_due_ = true;
+        return true;
+    }
+
+    uint64_t packets_skipped() const { return packets_skipped_; }
+    uint64_t frames_paced_out() const { return frames_paced_out_; }
+
+private:
+    PacerConfig cfg_;
+    int64_t interval_usec_ = 0;
+    int64_t boost_until_ = INT64_MIN;
+    bool full_ = false;
+    int64_t next_due_ = 0;
+    bool has_due_ = false;
+    uint64_t packets_skipped_ = 0;
+    uint64_t frames_paced_out_ = 0;
+};
+
+// Host-requested decimation (a "rate_control" control message): a congested
+// downstream stage wants only 1 of every keep_every frames. Non-reference
+// frames are discarded inside the decoder, and once keep_every spans the
+// observed GOP only keyframes reach the decoder at all; whatever still decodes
+// is thinned to 1 in keep_every. Going back below a GOP waits for a keyframe,
+// like the pacer's Keyframes mode.
+class Decimator {
+public:
+    void set_keep_every(int keep_every) { keep_ = keep_every < 1 ? 1 : keep_every; }
+    int keep_every() const { return keep_; }
+    bool active() const { return keep_ > 1; }
+
+    // Decide whether a compressed packet goes to the decoder. Sees every
+    // packet, so it also measures the GOP length (packets between keyframes).
+    bool admit_packet(bool keyframe) {
+        if (keyframe) {
+            if (since_key_ > 0) gop_ = since_key_;
+            since_key_ = 0;
+        }
+        ++since_key_;
+        if (active() && gop_ > 1 && keep_ >= gop_) keys_only_ = true;
+        else if (keyframe) keys_only_ = false;
+        if (!keys_only_ || keyframe) return true;
+        ++packets_skipped_;
+        return false;
+    }
+
+    Discard discard() const {
+        if (keys_only_) return Discard::NonKey;
+        return active() ? Discard::NonRef : Discard::Default;
+    }
+
+    // Thin decoded frames to 1 in keep_every (keyframes-only decode is
+    // already at or below that rate).
+    bool emit_frame() {
+        if (!active() || keys_only_) {
+            phase_ = 0;
+            return true;
+        }
+        const bool emit = phase_ == 0;
+        phase_ = (phase_ + 1) % keep_;
+        if (!emit) ++frames_decimated_;
+        return emit;
+    }
+
+    bool keyframes_only() const { return keys_only_; }
+    int gop() const { return gop_; }
+    uint64_t packets_skipped() const { return packets_skipped_; }
+    uint64_t frames_decimated() const { return frames_decimated_; }
+
+private:
+    int keep_ = 1;
+    int gop_ = 0;        // 0 until two keyframes have been seen; 1 = all-intra
+    int since_key_ = 0;
+    bool keys_only_ = false;
+    int phase_ = 0;
+    uint64_t packets_skipped_ = 0;
+    uint64_t frames_decimated_ = 0;
+};
+
+} // namespace zm::decode
@@ -0,0 +1,79 @@
+#pragma once
+
+// Pure, dependency-free planning for decode_ffmpeg's multi-resolution outputs.
+// Kept separate from the plugin so it can be unit-tested without FFmpeg.
+//
+// One decode feeds several outputs (e.g. 640x360 rgb24 for detection plus the
+// full-resolution yuv420p frame for snapshots/crops). Instead of scaling every
+// output from the decoded frame, outputs are produced largest first and each
+// one is scaled from the smallest already-produced planar YUV output that still
+// covers it, so a 4K decode feeding 1080p and 360p outputs reads the 4K frame
+// once and the 360p pass reads the 1080p one.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace zm::decode {
+
+// Resolve a "scale" spec against the decoded size: "orig", "720p", "WxH", or
+// "Wx-1" / "-1xH" to keep the source aspect ratio (rounded to even). Returns
+// false for a malformed spec.
+inline bool resolve_scale(const std::string& scale, int src_w, int src_h, int& w, int& h) {
+    w = src_w;
+    h = src_h;
+    if (scale.empty() || scale == "orig") return true;
+    if (scale == "720p") { w = 1280; h = 720; return true; }
+    int sw = 0, sh = 0;
+    if (std::sscanf(scale.c_str(), "%dx%d", &sw, &sh) != 2) return false;
+    if (sw == -1 && sh > 0 && src_h > 0) sw = (static_cast<long long>(src_w) * sh / src_h + 1) & ~1;
+    if (sh == -1 && sw > 0 && src_w > 0) sh = (static_cast<long long>(src_h) * sw / src_w + 1) & ~1;
+    if (sw <= 0 || sh <= 0) return false;
+    w = sw;
+    h = sh;
+    return true;
+}
+
+struct PyramidLevel {
+    int width = 0;
+    int height = 0;
+    bool planar_yuv = false;   // yuv420p: a cheap, lossless-enough cascade source
+};
+
+struct PyramidStep {
+    int output = 0;            // index into the levels
+    int source = -1;           // -1 = the decoded frame, else an earlier output
+};
+
+// Production order and scaling source for each output.
+inline std::vector<PyramidStep> plan_pyramid(const std::vector<PyramidLevel>& levels,
+                                             int src_w, int src_h) {
+    std::vector<int> order(levels.size());
+    for (size_t i = 0; i < levels.size(); ++i) order[i] = static_cast<int>(i);
+    auto area = [&](int i) { return static_cast<long long>(levels[i].width) * levels[i].height; };
+    // Stable insertion sort: largest first, config order among equals.
+    for (size_t i = 1; i < order.size(); ++i)
+        for (size_t j = i; j > 0 && area(order[j]) > area(order[j - 1]); --j)
+            std::swap(order[j], order[j - 1]);
+
+    const long long src_area = static_cast<long long>(src_w) * src_h;
+    std::vector<PyramidStep> plan;
+    plan.reserve(order.size());
+    for (int o : order) {
+        const PyramidLevel& want = levels[o];
+        PyramidStep step{o, -1};
+        long long best = src_area;
+        for (const PyramidStep& done : plan) {
+            const PyramidLevel& have = levels[done.output];
+            if (!have.planar_yuv || have.width < want.width || have.height < want.height) continue;
+            if (area(done.output) < best) {
+                best = area(done.output);
+                step.source = done.output;
+            }
+        }
+        plan.push_back(step);
+    }
+    return plan;
+}
+
+} // namespace zm::decode
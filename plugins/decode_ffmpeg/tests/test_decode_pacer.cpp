@@ -0,0 +1,164 @@
+#include "../decode_pacer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+using zm::decode::DecimateMode;
+using zm::decode::Decimator;
+using zm::decode::DecodePacer;
+using zm::decode::Discard;
+using zm::decode::PacerConfig;
+
+namespace {
+
+constexpr int64_t kFrame = 40000;  // 25 fps source
+
+PacerConfig config(double fps, DecimateMode mode) {
+    PacerConfig c;
+    c.analysis_fps = fps;
+    c.mode = mode;
+    c.boost_hold_usec = 1000000;
+    return c;
+}
+
+}  // namespace
+
+TEST(DecodePacer, DisabledPassesEverything) {
+    DecodePacer p;
+    EXPECT_FALSE(p.enabled());
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_TRUE(p.admit_packet(i % 25 == 0, 0));
+        EXPECT_EQ(p.discard(), Discard::Default);
+        EXPECT_TRUE(p.emit_frame(i * kFrame));
+    }
+}
+
+TEST(DecodePacer, KeyframesModeDropsNonKeyPackets) {
+    DecodePacer p(config(2, DecimateMode::Keyframes));
+    int admitted = 0;
+    for (int i = 0; i < 100; ++i)
+        if (p.admit_packet(i % 25 == 0, 0)) ++admitted;
+    EXPECT_EQ(admitted, 4);
+    EXPECT_EQ(p.packets_skipped(), 96u);
+    EXPECT_EQ(p.discard(), Discard::NonKey);
+}
+
+TEST(DecodePacer, EmitsAtAnalysisRateWithoutDrift) {
+    DecodePacer p(config(5, DecimateMode::NonRef));
+    int emitted = 0;
+    for (int i = 0; i < 250; ++i) {  // 10 s at 25 fps
+        ASSERT_TRUE(p.admit_packet(i % 25 == 0, 0));
+        EXPECT_EQ(p.discard(), Discard::NonRef);
+        if (p.emit_frame(i * kFrame)) ++emitted;
+    }
+    EXPECT_EQ(emitted, 50);
+    EXPECT_EQ(p.frames_paced_out(), 200u);
+}
+
+TEST(DecodePacer, PtsJumpReanchors) {
+    DecodePacer p(config(2, DecimateMode::NonRef));
+    EXPECT_TRUE(p.emit_frame(10000000));
+    EXPECT_FALSE(p.emit_frame(10040000));
+    EXPECT_TRUE(p.emit_frame(0));  // stream restarted with a lower clock
+    EXPECT_FALSE(p.emit_frame(40000));
+    EXPECT_TRUE(p.emit_frame(500000));
+}
+
+TEST(DecodePacer, NonRefBoostSwitchesImmediately) {
+    DecodePacer p(config(2, DecimateMode::NonRef));
+    p.admit_packet(true, 0);
+    EXPECT_FALSE(p.full_rate());
+    p.on_activity(100);
+    p.admit_packet(false, 200);
+    EXPECT_TRUE(p.full_rate());
+    EXPECT_EQ(p.discard(), Discard::Default);
+    EXPECT_TRUE(p.emit_frame(0));
+    EXPECT_TRUE(p.emit_frame(kFrame));
+    // Hold expires one second after the last activity.
+    p.admit_packet(false, 1000100);
+    EXPECT_FALSE(p.full_rate());
+    EXPECT_EQ(p.discard(), Discard::NonRef);
+}
+
+TEST(DecodePacer, KeyframesBoostWaitsForKeyframe) {
+    DecodePacer p(config(2, DecimateMode::Keyframes));
+    EXPECT_TRUE(p.admit_packet(true, 0));
+    p.on_activity(10);
+    // Mid-GOP: no reference chain yet, keep dropping.
+    EXPECT_FALSE(p.admit_packet(false, 20));
+    EXPECT_FALSE(p.full_rate());
+    EXPECT_TRUE(p.admit_packet(true, 30));
+    EXPECT_TRUE(p.full_rate());
+    EXPECT_TRUE(p.admit_packet(false, 40));
+    EXPECT_EQ(p.discard(), Discard::Default);
+    // Boost over: back to keyframes only.
+    EXPECT_FALSE(p.admit_packet(false, 2000000));
+    EXPECT_FALSE(p.full_rate());
+}
+
+TEST(Decimator, FullRateByDefault) {
+    Decimator d;
+    EXPECT_FALSE(d.active());
+    for (int i = 0; i < 30; ++i) {
+        EXPECT_TRUE(d.admit_packet(i % 10 == 0));
+        EXPECT_EQ(d.discard(), Discard::Default);
+        EXPECT_TRUE(d.emit_frame());
+    }
+    EXPECT_EQ(d.gop(), 10);
+}
+
+TEST(Decimator, ThinsBelowGopWithNonRefDiscard) {
+    Decimator d;
+    d.set_keep_every(3);
+    int emitted = 0;
+    for (int i = 0; i < 60; ++i) {
+        EXPECT_TRUE(d.admit_packet(i % 25 == 0));
+        EXPECT_EQ(d.discard(), Discard::NonRef);
+        emitted += d.emit_frame();
+    }
+    EXPECT_EQ(emitted, 20);
+    EXPECT_EQ(d.frames_decimated(), 40u);
+    EXPECT_FALSE(d.keyframes_only());
+}
+
+TEST(Decimator, KeyframesOnlyOnceKeepSpansGop) {
+    Decimator d;
+    for (int i = 0; i < 11; ++i) d.admit_packet(i % 10 == 0);  // learn GOP = 10
+    d.set_keep_every(16);
+    // Mid-GOP packets are dropped right away; keyframes always decode.
+    EXPECT_FALSE(d.admit_packet(false));
+    EXPECT_EQ(d.discard(), Discard::NonKey);
+    for (int i = 12; i < 40; ++i) EXPECT_EQ(d.admit_packet(i % 10 == 0), i % 10 == 0) << i;
+    EXPECT_TRUE(d.emit_frame());
+    EXPECT_EQ(d.packets_skipped(), 27u);
+
+    // Back below a GOP: P-frames wait for the next keyframe's reference chain.
+    d.set_keep_every(2);
+    EXPECT_FALSE(d.admit_packet(false));
+    EXPECT_FALSE(d.admit_packet(false));
+    EXPECT_TRUE(d.keyframes_only());
+    for (int i = 42; i < 50; ++i) d.admit_packet(false);
+    EXPECT_TRUE(d.admit_packet(true));
+    EXPECT_FALSE(d.keyframes_only());
+    EXPECT_TRUE(d.admit_packet(false));
+    EXPECT_EQ(d.discard(), Discard::NonRef);
+}
+
+TEST(Decimator, AllIntraStreamIsThinnedNotKeyframeGated) {
+    Decimator d;
+    d.set_keep_every(4);
+    int emitted = 0;
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_TRUE(d.admit_packet(true));
+        emitted += d.emit_frame();
+    }
+    EXPECT_EQ(d.gop(), 1);
+    EXPECT_EQ(emitted, 5);
+}
+
+TEST(Decimator, StrongerDiscardWins) {
+    EXPECT_EQ(zm::decode::stronger(Discard::Default, Discard::NonRef), Discard::NonRef);
+    EXPECT_EQ(zm::decode::stronger(Discard::NonKey, Discard::NonRef), Discard::NonKey);
+    EXPECT_EQ(zm::decode::stronger(Discard::Default, Discard::Default), Discard::Default);
+}
@@ -0,0 +1,56 @@
+#include "../output_pyramid.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using zm::decode::plan_pyramid;
+using zm::decode::PyramidLevel;
+using zm::decode::resolve_scale;
+
+TEST(OutputPyramid, ResolvesScaleSpecs) {
+    int w = 0, h = 0;
+    ASSERT_TRUE(resolve_scale("orig", 1920, 1080, w, h));
+    EXPECT_EQ(w, 1920);
+    EXPECT_EQ(h, 1080);
+    ASSERT_TRUE(resolve_scale("720p", 1920, 1080, w, h));
+    EXPECT_EQ(w, 1280);
+    ASSERT_TRUE(resolve_scale("640x360", 1920, 1080, w, h));
+    EXPECT_EQ(h, 360);
+    ASSERT_TRUE(resolve_scale("640x-1", 2560, 1440, w, h));
+    EXPECT_EQ(h, 360);
+    ASSERT_TRUE(resolve_scale("-1x480", 1280, 960, w, h));
+    EXPECT_EQ(w, 640);
+    EXPECT_FALSE(resolve_scale("big", 1920, 1080, w, h));
+    EXPECT_FALSE(resolve_scale("-1x-1", 1920, 1080, w, h));
+}
+
+TEST(OutputPyramid, CascadesFromSmallestCoveringYuvOutput) {
+    // Config order: detect (rgb), full (yuv), mid (yuv).
+    std::vector<PyramidLevel> levels = {
+        {640, 360, false}, {3840, 2160, true}, {1920, 1080, true}};
+    auto plan = plan_pyramid(levels, 3840, 2160);
+    ASSERT_EQ(plan.size(), 3u);
+    EXPECT_EQ(plan[0].output, 1);   // full first, from the decoded frame
+    EXPECT_EQ(plan[0].source, -1);
+    EXPECT_EQ(plan[1].output, 2);   // mid: full is no smaller than the decoded frame
+    EXPECT_EQ(plan[1].source, -1);
+    EXPECT_EQ(plan[2].output, 0);   // detect from mid, not from 4K
+    EXPECT_EQ(plan[2].source, 2);
+}
+
+TEST(OutputPyramid, NonYuvOutputsAreNotCascadeSources) {
+    std::vector<PyramidLevel> levels = {{1280, 720, false}, {640, 360, true}};
+    auto plan = plan_pyramid(levels, 1920, 1080);
+    EXPECT_EQ(plan[0].source, -1);
+    EXPECT_EQ(plan[1].source, -1);
+}
+
+TEST(OutputPyramid, UpscaledOutputReadsDecodedFrame) {
+    std::vector<PyramidLevel> levels = {{640, 360, true}, {1280, 720, true}};
+    auto plan = plan_pyramid(levels, 640, 360);
+    EXPECT_EQ(plan[0].output, 1);
+    EXPECT_EQ(plan[0].source, -1);
+    EXPECT_EQ(plan[1].output, 0);
+    EXPECT_EQ(plan[1].source, -1);  // equal-area to the source: no gain from a cascade
+}
@@ -27,8 +27,10 @@
 #include <nlohmann/json.hpp>
 
 #include "zm_plugin.h"
+#include "zm_side_data.h"
 #include "vlm_client.hpp"
 #include "image_encode.hpp"
+#include "frame_cache.hpp"
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -86,7 +88,10 @@ struct DescribeVlmCtx {
     int maxTokens = 128;
 
     // Latest frame snapshot + a sparse ring (one frame per ~frameIntervalMs, last
-    // `frames` kept) — all protected by frameMutex.
+    // `frames` kept) — all protected by frameMutex. With the host frame cache
+    // (useCache) latestFrame stays empty: only the stream/pts are tracked and the
+    // pixels are acquired from the host when a describe runs.
+    bool useCache = false;
     std::mutex frameMutex;
     std::vector<uint8_t> latestFrame;
     int latestWidth = 0;
@@ -167,11 +172,12 @@ static void run_inference_cycle(DescribeVlmCtx* ctx) {
     // Gather frame(s): the sampled ring (multi-frame mode) or the latest snapshot.
     DescribeVlmCtx::RingFrame single;
     std::vector<DescribeVlmCtx::RingFrame> picked;
+    zm::fc::FrameRef cached;   // single-frame mode with the host cache
     uint32_t streamId = 0;
     uint64_t ptsUsec = 0;
     {
         std::lock_guard<std::mutex> lk(ctx->frameMutex);
-        if (!ctx->haveFrame || ctx->latestFrame.empty()) return;
+        if (!ctx->haveFrame || (!ctx->useCache && ctx->latestFrame.empty())) return;
         streamId = ctx->latestStreamId;
         ptsUsec = ctx->latestPtsUsec;
         if (ctx->frames > 1 && !ctx->ring.empty()) {
@@ -180,7 +186,16 @@ static void run_inference_cycle(DescribeVlmCtx* ctx) {
             single.pts = ctx->latestPtsUsec;
             single.w = ctx->latestWidth;
             single.h = ctx->latestHeight;
-            single.rgb = ctx->latestFrame;
+            if (ctx->useCache) {
+                const uint32_t bytes = (single.w > 0 && single.h > 0)
+                                           ? static_cast<uint32_t>(single.w * single.h * 3) : 0;
+                cached = zm::fc::FrameRef::latest(ctx->host, ctx->hostCtx, streamId,
+                                                  ZM_FRAME_RGB24, bytes);
+                if (!cached) return;
+                single.pts = ptsUsec = cached.hdr()->pts_usec;
+            } else {
+                single.rgb = ctx->latestFrame;
+            }
             picked.push_back(std::move(single));
         }
     }
@@ -189,9 +204,11 @@ static void run_inference_cycle(DescribeVlmCtx* ctx) {
     std::vector<vlm::ReqFrame> reqs;
     reqs.reserve(picked.size());
     for (const auto& f : picked) {
-        if (f.w <= 0 || f.h <= 0 || f.rgb.size() < size_t(f.w) * size_t(f.h) * 3) continue;
+        const uint8_t* rgb = cached ? cached.payload() : f.rgb.data();
+        const size_t rgbSize = cached ? cached.payload_size() : f.rgb.size();
+        if (f.w <= 0 || f.h <= 0 || rgbSize < size_t(f.w) * size_t(f.h) * 3) continue;
         std::vector<uint8_t> jpeg;
-        if (!zm::img::encode_rgb24_to_jpeg(f.rgb.data(), f.w, f.h, jpeg)) continue;
+        if (!zm::img::encode_rgb24_to_jpeg(rgb, f.w, f.h, jpeg)) continue;
         vlm::ReqFrame rf;
         rf.jpeg_base64 = vlm::base64_encode(jpeg.data(), jpeg.size());
         if (picked.size() > 1) {
@@ -369,6 +386,7 @@ static int describe_vlm_start(zm_plugin_t* plugin, zm_host_api_t* host,
         }
     }
 
+    ctx->useCache = zm::fc::retain(host, host_ctx, 1);
     plugin->instance = ctx;
 
     // libcurl global init (idempotent enough for our single-plugin use).
@@ -434,7 +452,7 @@ static void describe_vlm_on_frame(zm_plugin_t* plugin, const void* buf, size_t s
 
     const zm_frame_hdr_t* hdr = static_cast<const zm_frame_hdr_t*>(buf);
     const uint8_t* payload = static_cast<const uint8_t*>(buf) + sizeof(zm_frame_hdr_t);
-    size_t payloadSize = size - sizeof(zm_frame_hdr_t);
+    size_t payloadSize = zm_frame_payload_size(buf, size);
 
     // Only act on RGB24 frames; everything else is forwarded untouched.
     if (hdr->hw_type == ZM_FRAME_RGB24) {
@@ -452,9 +470,10 @@ static void describe_vlm_on_frame(zm_plugin_t* plugin, const void* buf, size_t s
             int width = ctx->frameWidth;
             int height = ctx->frameHeight;
 
-            // Fast snapshot under a short lock: just a memcpy.
+            // Fast snapshot under a short lock: just a memcpy (nothing at all
+            // when the host cache holds the frame for us).
             std::lock_guard<std::mutex> lk(ctx->frameMutex);
-            ctx->latestFrame.assign(payload, payload + payloadSize);
+            if (!ctx->useCache) ctx->latestFrame.assign(payload, payload + payloadSize);
             ctx->latestWidth = width;
             ctx->latestHeight = height;
             ctx->latestStreamId = hdr->stream_id;
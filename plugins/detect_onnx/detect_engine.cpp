@@ -1,4 +1,5 @@
 #include "detect_engine.hpp"
+#include "ort_model.hpp"                 // open_session (shared model cache)
 
 #ifdef ZMP_WITH_CUDA
 
@@ -16,7 +17,10 @@ InferenceEngine::InferenceEngine(const std::string& model, int net, int maxBatch
     so_.SetGraphOptimizationLevel(ORT_ENABLE_ALL);
     OrtCUDAProviderOptions o{};
     so_.AppendExecutionProvider_CUDA(o);
-    sess_ = std::make_unique<Ort::Session>(env_, model.c_str(), so_);
+    zm::hw::CachedSession cs = zm::hw::open_session(env_, model, so_, "cuda");
+    mapping_ = std::move(cs.mapping);
+    sess_ = std::move(cs.session);
+    stats_ = std::move(cs.stats);
     Ort::AllocatorWithDefaultOptions a;
     in_ = sess_->GetInputNameAllocated(0, a).get();
     out_ = sess_->GetOutputNameAllocated(0, a).get();
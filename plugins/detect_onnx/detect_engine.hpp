@@ -11,6 +11,7 @@
 #ifdef ZMP_WITH_CUDA
 
 #include "detect_postprocess.hpp"        // Box, Letterbox, decode_nms_free
+#include "model_cache.hpp"                // ModelLoadStats, MappedFile
 #include <onnxruntime_cxx_api.h>
 
 #include <atomic>
@@ -44,6 +45,7 @@ public:
 
     long runs() const { return runs_.load(); }      // number of batched Runs
     long items() const { return items_.load(); }    // total tensors processed
+    const zm::hw::ModelLoadStats& load_stats() const { return stats_; }
 
 private:
     struct Req {
@@ -57,7 +59,9 @@ private:
 
     Ort::Env env_;
     Ort::SessionOptions so_;
+    std::shared_ptr<const zm::io::MappedFile> mapping_;   // outlives sess_
     std::unique_ptr<Ort::Session> sess_;
+    zm::hw::ModelLoadStats stats_;
     std::string in_, out_;
     int net_, maxBatch_, maxWaitUs_;
     size_t per_ = 0;
@@ -4,9 +4,18 @@
 // structured "detection" events. Always forwards the frame downstream (the
 // plugin is a pass-through DETECT stage). If no model is loaded, or the frame
 // is not RGB24, or the stream is filtered out, it simply forwards.
+//
+// With roi_motion on, the CPU path is a cascade: motion regions (motion_gate's
+// "motion" events, else the CPU backend's own luma diff) are planned into a few
+// crops, letterboxed into one batched tensor and detected together, with a
+// periodic full-frame sweep for static objects; results are merged with
+// merge_overlapping. No motion and no sweep due = no inference at all.
 
 #include "detect_postprocess.hpp"
 #include "detect_cuda.hpp"   // CUDA zero-copy path (only active when ZM_WITH_CUDA)
+#include "motion_feed.hpp"
+#include "ort_model.hpp"     // open_session (shared model cache)
+#include "roi_cascade.hpp"
 
 #include <onnxruntime_cxx_api.h>
 #ifdef __APPLE__
@@ -25,6 +34,7 @@
 #include <vector>
 #include <cstdint>
 #include <cstdlib>   // getenv (ZM_MOTION_REGIONS opt-in)
+#include <fstream>
 #include <algorithm>
 #include <cmath>
 
@@ -58,9 +68,12 @@ struct DetectOnnxCtx {
     // ONNX Runtime state.
     std::unique_ptr<Ort::Env> env;
     Ort::SessionOptions sessionOptions;
+    std::string activeEp = "cpu";       // provider actually appended (cache key)
+    std::shared_ptr<const zm::io::MappedFile> modelMapping;  // outlives session
     std::unique_ptr<Ort::Session> session;
     std::string inputName;
     std::string outputName;
+    bool dynamicBatch = false;          // model input has a dynamic batch dim
 
     // Config.
     std::string modelPath;
@@ -75,6 +88,7 @@ struct DetectOnnxCtx {
     // if unset or the model fails to load.
     std::string reidModelPath;
     int reidW = 128, reidH = 256;       // ReID input W×H (OSNet default 128×256)
+    std::shared_ptr<const zm::io::MappedFile> reidMapping;   // outlives reidSession
     std::unique_ptr<Ort::Session> reidSession;
     std::string reidInputName, reidOutputName;
     bool reidReady = false;
@@ -82,7 +96,8 @@ struct DetectOnnxCtx {
     std::vector<int> streamFilter;      // empty = all
     std::vector<std::string> classNames; // empty = use COCO-80
 
-    // ROI motion cascade (CUDA/GPU surface path only).
+    // ROI motion cascade (CUDA surfaces: on-device motion; RGB24: motion events
+    // or the CPU backend's luma diff).
     bool roiMotion = false;            // gate inference on motion + detect per-region crops
     int motionDownscale = 8;
     int motionThreshold = 25;
@@ -95,11 +110,30 @@ struct DetectOnnxCtx {
 #endif
     uint64_t lastSweepUsec = 0;
     bool sweptOnce = false;
+    zm::detect::RoiPlanOptions roiPlan;           // CPU cascade crop planning
+    uint64_t motionMaxAgeUs = 500000;             // motion events older than this are stale
+    zm::motion::MotionFeed* motionFeed = nullptr; // leaked on stop (see motion_feed.hpp)
+    std::unique_ptr<zm::hw::HwBackend> cpuBackend; // batched crop preprocess + fallback motion
     bool sharedEngine = false;     // route full-frame CUDA detect through the shared engine
     int  sharedMaxBatch = 8;       // max tensors coalesced per batched Run
     int  sharedMaxWaitUs = 2000;   // linger after first request to let a batch fill
     bool engineReady = false;
 
+    // INT8 QDQ model (tools/quantize_int8.py). precision "int8" runs
+    // int8ModelPath (default <model>.int8.onnx) in place of model_path; with
+    // int8CompareEvery > 0 every Nth inference also runs the FP32 model on the
+    // same input and the agreement is logged every int8ReportEvery comparisons.
+    std::string precision = "fp32";
+    std::string int8ModelPath;
+    std::string fp32ModelPath;
+    int int8CompareEvery = 0;
+    int int8ReportEvery = 100;
+    std::shared_ptr<const zm::io::MappedFile> refMapping;  // outlives refSession
+    std::unique_ptr<Ort::Session> refSession;              // FP32 reference
+    std::string refInputName, refOutputName;
+    uint64_t inferCount = 0;
+    zm::detect::DetectionAgreement agreement;
+
     bool warnedUnsupportedShape = false;
     bool warnedNoCuda = false;
 };
@@ -121,6 +155,39 @@ void forwardFrame(DetectOnnxCtx* ctx, const void* buf, size_t size) {
     }
 }
 
+// Default INT8 model next to the FP32 one: "m.onnx" -> "m.int8.onnx" (the
+// name tools/quantize_int8.py writes).
+std::string int8PathFor(const std::string& fp32) {
+    const size_t slash = fp32.find_last_of("/\\");
+    const size_t dot = fp32.rfind('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return fp32 + ".int8.onnx";
+    return fp32.substr(0, dot) + ".int8" + fp32.substr(dot);
+}
+
+void logAgreement(const DetectOnnxCtx* ctx) {
+    const zm::detect::DetectionAgreement& a = ctx->agreement;
+    if (a.frames == 0) return;
+    ZM_LOG_INFO("detect_onnx: INT8 vs FP32 over %llu frame(s): recall %.3f precision %.3f "
+                "(fp32 %llu boxes, int8 %llu, matched %llu), mean |dconf| %.3f, mean IoU %.3f",
+                static_cast<unsigned long long>(a.frames), a.recall(), a.precision(),
+                static_cast<unsigned long long>(a.ref_boxes),
+                static_cast<unsigned long long>(a.test_boxes),
+                static_cast<unsigned long long>(a.matched), a.mean_conf_delta(), a.mean_iou());
+}
+
+// True when this inference should also run the FP32 reference.
+bool compareDue(DetectOnnxCtx* ctx) {
+    if (!ctx->refSession) return false;
+    return ctx->inferCount++ % static_cast<uint64_t>(ctx->int8CompareEvery) == 0;
+}
+
+void recordAgreement(DetectOnnxCtx* ctx, const std::vector<zm::detect::Box>& fp32,
+                     const std::vector<zm::detect::Box>& int8) {
+    zm::detect::compare_detections(fp32, int8, 0.5f, ctx->agreement);
+    if (ctx->agreement.frames % ctx->int8ReportEvery == 0) logAgreement(ctx);
+}
+
 } // namespace
 
 extern "C" {
@@ -158,14 +225,40 @@ static int detect_onnx_start(zm_plugin_t* plugin, zm_host_api_t* host, void* hos
             ctx->motionMinCells = j.value("motion_min_changed", 0);
             ctx->maxRegions = j.value("max_regions", 8);
             ctx->fullSweepSec = j.value("full_sweep_sec", 2.0);
+            ctx->roiPlan.margin = j.value("roi_margin", 0.2f);
+            ctx->roiPlan.min_size = j.value("roi_min_size", 0);   // 0 = input_size / 2
+            ctx->roiPlan.full_frame_ratio = j.value("roi_full_frame_ratio", 0.5f);
+            ctx->motionMaxAgeUs = static_cast<uint64_t>(std::max(0, j.value("motion_max_age_ms", 500))) * 1000;
             ctx->sharedEngine = j.value("shared_engine", false);
             ctx->sharedMaxBatch = j.value("shared_max_batch", 8);
             ctx->sharedMaxWaitUs = j.value("shared_max_wait_us", 2000);
+            ctx->precision = j.value("precision", std::string("fp32"));
+            ctx->int8ModelPath = j.value("int8_model_path", std::string());
+            ctx->int8CompareEvery = std::max(0, j.value("int8_compare_every", 0));
+            ctx->int8ReportEvery = std::max(1, j.value("int8_report_every", 100));
         } catch (const std::exception& e) {
             ZM_LOG_ERROR("detect_onnx: failed to parse config: %s", e.what());
         }
     }
 
+    // precision "int8": swap in the quantized model; the FP32 one stays the
+    // reference for the agreement check.
+    if (ctx->precision == "int8" && !ctx->modelPath.empty()) {
+        if (ctx->int8ModelPath.empty()) ctx->int8ModelPath = int8PathFor(ctx->modelPath);
+        if (std::ifstream(ctx->int8ModelPath).good()) {
+            ctx->fp32ModelPath = ctx->modelPath;
+            ctx->modelPath = ctx->int8ModelPath;
+            if (ctx->ep != "cpu")
+                ZM_LOG_WARN("detect_onnx: INT8 QDQ models are tuned for ep \"cpu\" (ep=%s)",
+                            ctx->ep.c_str());
+        } else {
+            ZM_LOG_WARN("detect_onnx: precision int8 but '%s' does not exist (build it with "
+                        "tools/quantize_int8.py); running FP32", ctx->int8ModelPath.c_str());
+        }
+    } else if (ctx->precision != "fp32") {
+        ZM_LOG_WARN("detect_onnx: unknown precision '%s'; running FP32", ctx->precision.c_str());
+    }
+
     // Create the ONNX Runtime environment and session options.
     try {
         ctx->env = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "detect_onnx");
@@ -182,6 +275,7 @@ static int detect_onnx_start(zm_plugin_t* plugin, zm_host_api_t* host, void* hos
             uint32_t coreml_flags = 0;
             Ort::ThrowOnError(OrtSessionOptionsAppendExecutionProvider_CoreML(
                 static_cast<OrtSessionOptions*>(ctx->sessionOptions), coreml_flags));
+            ctx->activeEp = "coreml";
             ZM_LOG_INFO("detect_onnx: CoreML execution provider enabled");
         } catch (const std::exception& e) {
             ZM_LOG_WARN("detect_onnx: CoreML EP unavailable, falling back to CPU: %s",
@@ -201,6 +295,7 @@ static int detect_onnx_start(zm_plugin_t* plugin, zm_host_api_t* host, void* hos
             cudaSetDeviceFlags(cudaDeviceScheduleBlockingSync);
             OrtCUDAProviderOptions cuda_opts{};
             ctx->sessionOptions.AppendExecutionProvider_CUDA(cuda_opts);
+            ctx->activeEp = "cuda";
             ZM_LOG_INFO("detect_onnx: CUDA execution provider enabled (blocking sync)");
         } catch (const std::exception& e) {
             ZM_LOG_WARN("detect_onnx: CUDA EP unavailable, falling back to CPU: %s", e.what());
@@ -213,12 +308,13 @@ static int detect_onnx_start(zm_plugin_t* plugin, zm_host_api_t* host, void* hos
     // batched engine (one ORT session + CUDA context for all detect instances).
     if (ctx->sharedEngine && ctx->ep == "cuda" && !ctx->modelPath.empty()) {
         try {
-            zm::detect::InferenceEngine::get(ctx->modelPath, ctx->net,
-                                             ctx->sharedMaxBatch, ctx->sharedMaxWaitUs);   // load shared session now
+            auto& engine = zm::detect::InferenceEngine::get(
+                ctx->modelPath, ctx->net, ctx->sharedMaxBatch,
+                ctx->sharedMaxWaitUs);   // load shared session now
             ctx->engineReady = true;
             ctx->roiMotion = false;   // engine path is whole-frame only
-            ZM_LOG_INFO("detect_onnx: using SHARED batched inference engine (model '%s')",
-                        ctx->modelPath.c_str());
+            ZM_LOG_INFO("detect_onnx: using SHARED batched inference engine (model '%s') %s",
+                        ctx->modelPath.c_str(), engine.load_stats().summary().c_str());
         } catch (const std::exception& e) {
             ZM_LOG_ERROR("detect_onnx: shared engine init failed (%s); using per-instance session", e.what());
         }
@@ -228,45 +324,85 @@ static int detect_onnx_start(zm_plugin_t* plugin, zm_host_api_t* host, void* hos
     // Construct a per-instance session unless the shared engine owns inference.
     if (!ctx->engineReady && !ctx->modelPath.empty() && ctx->env) {
         try {
-            ctx->session = std::make_unique<Ort::Session>(
-                *ctx->env, ctx->modelPath.c_str(), ctx->sessionOptions);
+            zm::hw::CachedSession cs = zm::hw::open_session(
+                *ctx->env, ctx->modelPath, ctx->sessionOptions, ctx->activeEp);
+            ctx->modelMapping = std::move(cs.mapping);
+            ctx->session = std::move(cs.session);
 
             Ort::AllocatorWithDefaultOptions allocator;
             auto inName = ctx->session->GetInputNameAllocated(0, allocator);
             auto outName = ctx->session->GetOutputNameAllocated(0, allocator);
             ctx->inputName = inName.get();
             ctx->outputName = outName.get();
+            const auto inShape =
+                ctx->session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+            ctx->dynamicBatch = !inShape.empty() && inShape[0] <= 0;
 
-            ZM_LOG_INFO("detect_onnx: loaded model '%s' (input='%s' output='%s' net=%d ep=%s)",
+            ZM_LOG_INFO("detect_onnx: loaded %s model '%s' (input='%s' output='%s' net=%d ep=%s) %s",
+                        ctx->fp32ModelPath.empty() ? "FP32" : "INT8",
                         ctx->modelPath.c_str(), ctx->inputName.c_str(),
-                        ctx->outputName.c_str(), ctx->net, ctx->ep.c_str());
+                        ctx->outputName.c_str(), ctx->net, ctx->ep.c_str(),
+                        cs.stats.summary().c_str());
         } catch (const std::exception& e) {
             ZM_LOG_ERROR("detect_onnx: failed to load model '%s': %s (running as pass-through)",
                          ctx->modelPath.c_str(), e.what());
             ctx->session.reset();
+            ctx->modelMapping.reset();
         }
     } else if (!ctx->engineReady) {
         ZM_LOG_WARN("detect_onnx: no model_path configured; running as pass-through");
     }
 
+    // FP32 reference for the INT8 agreement check (host-frame paths only).
+    if (ctx->session && !ctx->fp32ModelPath.empty() && ctx->int8CompareEvery > 0) {
+        try {
+            zm::hw::CachedSession cs = zm::hw::open_session(
+                *ctx->env, ctx->fp32ModelPath, ctx->sessionOptions, ctx->activeEp);
+            ctx->refMapping = std::move(cs.mapping);
+            ctx->refSession = std::move(cs.session);
+            Ort::AllocatorWithDefaultOptions alloc;
+            ctx->refInputName = ctx->refSession->GetInputNameAllocated(0, alloc).get();
+            ctx->refOutputName = ctx->refSession->GetOutputNameAllocated(0, alloc).get();
+            ZM_LOG_INFO("detect_onnx: comparing INT8 against FP32 '%s' every %d inference(s)",
+                        ctx->fp32ModelPath.c_str(), ctx->int8CompareEvery);
+        } catch (const std::exception& e) {
+            ZM_LOG_WARN("detect_onnx: FP32 reference '%s' failed to load (%s); no INT8 "
+                        "comparison", ctx->fp32ModelPath.c_str(), e.what());
+            ctx->refSession.reset();
+            ctx->refMapping.reset();
+        }
+    }
+
+    // CPU ROI cascade: crops come from motion_gate's events when it is upstream.
+    if (ctx->roiMotion && ctx->session) {
+        ctx->roiPlan.max_regions = std::max(1, ctx->maxRegions);
+        if (ctx->roiPlan.min_size <= 0) ctx->roiPlan.min_size = ctx->net / 2;
+        ctx->cpuBackend = zm::hw::make_backend("cpu");
+        ctx->motionFeed = zm::motion::subscribe_motion(host, host_ctx);
+    }
+
     // Optional learned ReID head. Loaded only when reid is on AND a model path is
     // given; on failure we fall back to the colour-histogram embedding.
     if (ctx->reid && !ctx->reidModelPath.empty() && ctx->env) {
         try {
-            ctx->reidSession = std::make_unique<Ort::Session>(
-                *ctx->env, ctx->reidModelPath.c_str(), ctx->sessionOptions);
+            zm::hw::CachedSession cs = zm::hw::open_session(
+                *ctx->env, ctx->reidModelPath, ctx->sessionOptions, ctx->activeEp);
+            ctx->reidMapping = std::move(cs.mapping);
+            ctx->reidSession = std::move(cs.session);
             Ort::AllocatorWithDefaultOptions alloc;
             ctx->reidInputName = ctx->reidSession->GetInputNameAllocated(0, alloc).get();
             ctx->reidOutputName = ctx->reidSession->GetOutputNameAllocated(0, alloc).get();
             ctx->reidReady = true;
-            ZM_LOG_INFO("detect_onnx: loaded ReID model '%s' (in='%s' out='%s' %dx%d)",
+            ZM_LOG_INFO("detect_onnx: loaded ReID model '%s' (in='%s' out='%s' %dx%d) %s",
                         ctx->reidModelPath.c_str(), ctx->reidInputName.c_str(),
-                        ctx->reidOutputName.c_str(), ctx->reidW, ctx->reidH);
+                        ctx->reidOutputName.c_str(), ctx->reidW, ctx->reidH,
+                        cs.stats.summary().c_str());
         } catch (const std::exception& e) {
             ZM_LOG_WARN("detect_onnx: ReID model '%s' failed to load (%s); "
                         "falling back to colour-histogram embedding",
                         ctx->reidModelPath.c_str(), e.what());
             ctx->reidSession.reset();
+            ctx->reidMapping.reset();
             ctx->reidReady = false;
         }
     }
@@ -281,6 +417,8 @@ static void detect_onnx_stop(zm_plugin_t* plugin) {
 #ifdef ZMP_WITH_CUDA
         if (ctx->gpuDiff) { zm::detect::gpudiff_state_destroy(ctx->gpuDiff); ctx->gpuDiff = nullptr; }
 #endif
+        zm::motion::unsubscribe_motion(ctx->host, ctx->hostCtx, ctx->motionFeed);
+        if (ctx->agreement.frames % ctx->int8ReportEvery != 0) logAgreement(ctx);
         delete ctx;
         plugin->instance = nullptr;
     }
@@ -437,6 +575,92 @@ static void publishBoxes(DetectOnnxCtx* ctx, const zm_frame_hdr_t* hdr,
         ctx->host->publish_evt(ctx->hostCtx, evt.dump().c_str());
 }
 
+// Run a letterboxed [n,3,net,net] host batch and decode each item into frame
+// coordinates (one Run for dynamic-batch models, else one per item).
+// `reference` runs the FP32 reference session instead (one item per Run).
+static std::vector<zm::detect::Box> runCpuBatch(DetectOnnxCtx* ctx, const zm::hw::BatchTensor& t,
+                                                bool reference = false) {
+    std::vector<zm::detect::Box> boxes;
+    Ort::MemoryInfo memInfo = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+    Ort::Session& session = reference ? *ctx->refSession : *ctx->session;
+    const char* inputNames[] = {reference ? ctx->refInputName.c_str() : ctx->inputName.c_str()};
+    const char* outputNames[] = {reference ? ctx->refOutputName.c_str() : ctx->outputName.c_str()};
+    const int per = ctx->dynamicBatch && !reference ? t.n : 1;
+    for (int first = 0; first < t.n; first += per) {
+        std::array<int64_t, 4> shape{per, t.channels, t.height, t.width};
+        Ort::Value in = Ort::Value::CreateTensor<float>(
+            memInfo, t.data + first * t.item_floats(), per * t.item_floats(),
+            shape.data(), shape.size());
+        auto outputs = session.Run(Ort::RunOptions{nullptr}, inputNames, &in, 1, outputNames, 1);
+        const float* out = outputs[0].GetTensorData<float>();
+        const auto oshape = outputs[0].GetTensorTypeAndShapeInfo().GetShape();
+        if (oshape.empty() || oshape.back() != 6) {
+            if (!ctx->warnedUnsupportedShape) {
+                ZM_LOG_WARN("detect_onnx: unsupported output shape; only NMS-free [1,N,6] supported");
+                ctx->warnedUnsupportedShape = true;
+            }
+            return {};
+        }
+        const int num = oshape.size() == 3 ? static_cast<int>(oshape[1])
+                                           : static_cast<int>(oshape[0]) / per;
+        for (int i = 0; i < per; ++i) {
+            auto b = zm::detect::decode_nms_free(out + static_cast<size_t>(i) * num * 6, num,
+                                                 t.lb[first + i], ctx->confThreshold,
+                                                 ctx->classFilter);
+            zm::detect::offset_boxes(b, t.crops[first + i]);
+            boxes.insert(boxes.end(), b.begin(), b.end());
+        }
+    }
+    return boxes;
+}
+
+// CPU ROI cascade for one RGB24 frame; false = nothing to run this frame.
+static bool roiDetectCpu(DetectOnnxCtx* ctx, const void* buf, size_t size, int w, int h,
+                         std::vector<zm::detect::Box>& boxes) {
+    const auto* hdr = static_cast<const zm_frame_hdr_t*>(buf);
+    const auto* rgb = static_cast<const uint8_t*>(buf) + sizeof(zm_frame_hdr_t);
+    const zm::hw::Surface surface = zm::hw::cpu_surface(rgb, w, h);
+
+    // Motion regions: the boxes motion_gate attached to this frame; else its
+    // events when it feeds this stream (no recent event = nothing moved); else
+    // the backend's own luma-grid diff.
+    std::vector<zm::hw::Region> motion;
+    if (zm::detect::side_data_motion(buf, size, motion)) {
+        // exact for this frame; no pts matching needed
+    } else if (ctx->motionFeed && ctx->motionFeed->index.seen(hdr->stream_id)) {
+        std::vector<zm::motion::MotionRegion> regions;
+        if (ctx->motionFeed->index.latest(hdr->stream_id, hdr->pts_usec, ctx->motionMaxAgeUs,
+                                          regions))
+            for (const auto& r : regions) motion.push_back({r.x, r.y, r.w, r.h});
+    } else {
+        motion = ctx->cpuBackend->motion(surface);
+    }
+    std::vector<zm::hw::Region> crops = zm::detect::plan_roi_crops(motion, w, h, ctx->roiPlan);
+
+    const bool fullPlanned = crops.size() == 1 && crops[0].w <= 0;
+    const bool sweep = !ctx->sweptOnce ||
+        hdr->pts_usec >= ctx->lastSweepUsec + static_cast<uint64_t>(ctx->fullSweepSec * 1e6);
+    if (sweep || fullPlanned) {
+        ctx->lastSweepUsec = hdr->pts_usec;
+        ctx->sweptOnce = true;
+        if (!fullPlanned) crops.push_back({});  // whole frame alongside the movers
+    }
+    if (crops.empty()) return false;
+
+    zm::hw::TensorSpec spec;
+    spec.width = spec.height = ctx->net;
+    const zm::hw::BatchTensor t = ctx->cpuBackend->preprocess_batch(surface, crops, spec);
+    if (!t.valid()) return false;
+    boxes = runCpuBatch(ctx, t);
+    if (t.n > 1 && !boxes.empty()) boxes = zm::detect::merge_overlapping(boxes, 0.5f);
+    if (compareDue(ctx)) {
+        std::vector<zm::detect::Box> ref = runCpuBatch(ctx, t, true);
+        if (t.n > 1 && !ref.empty()) ref = zm::detect::merge_overlapping(ref, 0.5f);
+        recordAgreement(ctx, ref, boxes);
+    }
+    return true;
+}
+
 static void detect_onnx_on_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
     auto* ctx = static_cast<DetectOnnxCtx*>(plugin->instance);
     if (!ctx || !buf || size < sizeof(zm_frame_hdr_t)) {
@@ -550,6 +774,18 @@ static void detect_onnx_on_frame(zm_plugin_t* plugin, const void* buf, size_t si
         return;
     }
 
+    if (ctx->roiMotion && ctx->cpuBackend) {
+        try {
+            std::vector<zm::detect::Box> boxes;
+            if (roiDetectCpu(ctx, buf, size, w, h, boxes))
+                publishBoxes(ctx, hdr, boxes, payload, w, h);
+        } catch (const std::exception& e) {
+            ZM_LOG_ERROR("detect_onnx: ROI inference error: %s", e.what());
+        }
+        forwardFrame(ctx, buf, size);
+        return;
+    }
+
     try {
         const int net = ctx->net;
         zm::detect::Letterbox lb = zm::detect::compute_letterbox(w, h, net);
@@ -590,6 +826,20 @@ static void detect_onnx_on_frame(zm_plugin_t* plugin, const void* buf, size_t si
         std::vector<zm::detect::Box> boxes =
             zm::detect::decode_nms_free(out, num, lb, ctx->confThreshold, ctx->classFilter);
 
+        if (compareDue(ctx)) {
+            const char* refIn[] = {ctx->refInputName.c_str()};
+            const char* refOut[] = {ctx->refOutputName.c_str()};
+            auto ref = ctx->refSession->Run(Ort::RunOptions{nullptr}, refIn, &inputTensor, 1,
+                                            refOut, 1);
+            const auto rshape = ref[0].GetTensorTypeAndShapeInfo().GetShape();
+            const int rnum = rshape.size() == 3 ? static_cast<int>(rshape[1])
+                           : rshape.size() == 2 ? static_cast<int>(rshape[0]) : 0;
+            recordAgreement(ctx,
+                            zm::detect::decode_nms_free(ref[0].GetTensorData<float>(), rnum, lb,
+                                                        ctx->confThreshold, ctx->classFilter),
+                            boxes);
+        }
+
         publishBoxes(ctx, hdr, boxes, payload, w, h);
     } catch (const std::exception& e) {
         ZM_LOG_ERROR("detect_onnx: inference error: %s", e.what());
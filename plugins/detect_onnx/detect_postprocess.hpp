@@ -138,4 +138,59 @@ inline std::vector<Box> merge_overlapping(std::vector<Box> boxes, float iou_thr
     return keep;
 }
 
+// Intersection-over-union of two source-pixel boxes.
+inline float box_iou(const Box& a, const Box& b) {
+    const float ix = std::max(0.f, std::min(a.x + a.w, b.x + b.w) - std::max(a.x, b.x));
+    const float iy = std::max(0.f, std::min(a.y + a.h, b.y + b.h) - std::max(a.y, b.y));
+    const float inter = ix * iy, uni = a.w * a.h + b.w * b.h - inter;
+    return uni > 0 ? inter / uni : 0.f;
+}
+
+// Running agreement of a test model's detections (e.g. INT8) with a reference
+// model's (FP32) on the same inputs. A test box matches the best unmatched
+// reference box of the same class with IoU >= the match threshold.
+struct DetectionAgreement {
+    uint64_t frames = 0;
+    uint64_t ref_boxes = 0;
+    uint64_t test_boxes = 0;
+    uint64_t matched = 0;
+    double conf_delta_sum = 0;  // sum |test.conf - ref.conf| over matches
+    double iou_sum = 0;         // sum IoU over matches
+
+    // Share of reference boxes the test model also found (1 when none).
+    double recall() const { return ref_boxes ? double(matched) / ref_boxes : 1.0; }
+    // Share of test boxes that the reference model agrees with (1 when none).
+    double precision() const { return test_boxes ? double(matched) / test_boxes : 1.0; }
+    double mean_conf_delta() const { return matched ? conf_delta_sum / matched : 0.0; }
+    double mean_iou() const { return matched ? iou_sum / matched : 0.0; }
+};
+
+// Accumulate one frame into `agg`. Greedy: reference boxes in descending
+// confidence each take their best remaining test box.
+inline void compare_detections(const std::vector<Box>& ref, const std::vector<Box>& test,
+                               float iou_thr, DetectionAgreement& agg) {
+    ++agg.frames;
+    agg.ref_boxes += ref.size();
+    agg.test_boxes += test.size();
+    std::vector<size_t> order(ref.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(),
+              [&](size_t a, size_t b) { return ref[a].confidence > ref[b].confidence; });
+    std::vector<char> used(test.size(), 0);
+    for (size_t r : order) {
+        int best = -1;
+        float bestIou = iou_thr;
+        for (size_t t = 0; t < test.size(); ++t) {
+            if (used[t] || test[t].class_id != ref[r].class_id) continue;
+            const float iou = box_iou(ref[r], test[t]);
+            if (iou >= bestIou) { bestIou = iou; best = static_cast<int>(t); }
+        }
+        if (best < 0) continue;
+        used[best] = 1;
+        ++agg.matched;
+        agg.conf_delta_sum += std::fabs(test[best].confidence - ref[r].confidence);
+        agg.iou_sum += bestIou;
+    }
+}
+
 } // namespace zm::detect
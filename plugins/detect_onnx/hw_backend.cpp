@@ -7,6 +7,9 @@
 // defined, so the default (CUDA-only, or even nothing) build still links cleanly and
 // the unsupported names fall through to nullptr — letting a caller fall back to CPU.
 //
+// The CPU backend (hw_backend_cpu.cpp) has no guard: it is always linked, so
+// "cpu" always resolves.
+//
 // Guards (must match the per-backend TUs and the CMake compile-definitions):
 //   ZMP_WITH_CUDA              -> make_cuda_backend()      (defined globally by top CMake)
 //   ZM_WITH_VAAPI              -> make_vaapi_backend()
@@ -20,6 +23,7 @@ namespace zm::hw {
 // Per-backend factory entry points. Declared here (rather than in the public header)
 // so the contract header stays vendor-agnostic; each is defined in its own TU under
 // the matching guard. Only the enabled ones are linked in.
+std::unique_ptr<HwBackend> make_cpu_backend();
 #ifdef ZMP_WITH_CUDA
 std::unique_ptr<HwBackend> make_cuda_backend();
 #endif
@@ -37,6 +41,7 @@ std::unique_ptr<HwBackend> make_vulkan_backend();
 #endif
 
 std::unique_ptr<HwBackend> make_backend(const std::string& kind) {
+    if (kind == "cpu") return make_cpu_backend();
 #ifdef ZMP_WITH_CUDA
     if (kind == "cuda") return make_cuda_backend();
 #endif
@@ -14,6 +14,12 @@
 //
 // (Lives next to detect for now since it reuses the detect postprocess types; it
 // could move to core/ when a non-detect on-device plugin needs it too.)
+//
+// The rest of the detector family (pose / seg / openvocab / lpr / face) goes
+// through the model-agnostic preprocess_batch() instead of the YOLO-specific
+// preprocess()/infer() pair, and runs its own session via infer_pipeline.hpp. A
+// CPU backend (hw_backend_cpu.cpp, "cpu") implements the same interface over
+// RGB24 host frames, so one code path serves GPU-less boxes and device backends.
 
 #include "detect_postprocess.hpp"        // zm::detect::Box, Letterbox
 #include <cstdint>
@@ -51,6 +57,45 @@ struct DeviceTensor {
     bool valid() const { return ptr != nullptr; }
 };
 
+// Model input layout for preprocess_batch(). value = (pixel - mean) * scale, per
+// channel; channels = 1 is Rec.601 luma. letterbox keeps aspect (width must equal
+// height, padded with `pad`); otherwise the crop is stretched to width x height.
+struct TensorSpec {
+    int width = 640, height = 640;
+    int channels = 3;
+    bool letterbox = true;
+    float mean = 0.0f;
+    float scale = 1.0f / 255.0f;
+    uint8_t pad = 114;
+};
+
+// A preprocessed [n, channels, height, width] float batch, one item per crop.
+// Backend-owned (device memory when `device`); valid until the next preprocess on
+// the same backend. lb[i] maps item i's net space back to its crop, crops[i]
+// is the crop in source pixels (add its x/y after unletterboxing).
+struct BatchTensor {
+    float* data = nullptr;
+    bool device = false;
+    int n = 0, channels = 0, height = 0, width = 0;
+    std::vector<zm::detect::Letterbox> lb;
+    std::vector<Region> crops;
+    bool valid() const { return data != nullptr && n > 0; }
+    size_t item_floats() const { return static_cast<size_t>(channels) * height * width; }
+};
+
+// Host RGB24 frame as a Surface (hw_type ZM_HW_CPU, pix_fmt ZM_FRAME_RGB24). Not
+// acquired: the caller keeps `rgb` alive while the surface is in use.
+inline Surface cpu_surface(const uint8_t* rgb, int width, int height) {
+    Surface s;
+    s.hw_type = 0;      // ZM_HW_CPU
+    s.pix_fmt = 101;    // ZM_FRAME_RGB24
+    s.width = width;
+    s.height = height;
+    s.plane_ptr[0] = reinterpret_cast<uint64_t>(rgb);
+    s.linesize[0] = width * 3;
+    return s;
+}
+
 class HwBackend {
 public:
     virtual ~HwBackend() = default;
@@ -74,11 +119,22 @@ public:
     // Run inference on a device tensor; boxes are mapped to source pixels.
     virtual std::vector<Detection> infer(const DeviceTensor& t, float conf,
                                          const std::vector<int>& allow = {}) = 0;
+
+    // Model-agnostic preprocess: `crops` of a surface (empty = whole frame; a
+    // {0,0,0,0} entry = whole frame) into ONE batched tensor laid out per `spec`.
+    // Returns an invalid tensor when this backend cannot handle the surface or
+    // the spec, so callers fall back (the default, for backends that only do
+    // the fused YOLO path).
+    virtual BatchTensor preprocess_batch(const Surface& s, const std::vector<Region>& crops,
+                                         const TensorSpec& spec) {
+        (void)s; (void)crops; (void)spec;
+        return {};
+    }
 };
 
-// Build a backend by name: "cuda" today (when ZM_WITH_CUDA); "metal" / "openvino" /
-// "rocm" / "directml" are the planned seams. Returns nullptr if unavailable, so a
-// caller can fall back (e.g. to the CPU path).
+// Build a backend by name: "cpu" (always), "cuda" (when ZM_WITH_CUDA); "metal" /
+// "openvino" / "rocm" / "directml" are the planned seams. Returns nullptr if
+// unavailable, so a caller can fall back (e.g. to the CPU path).
 std::unique_ptr<HwBackend> make_backend(const std::string& kind);
 
 }  // namespace zm::hw
@@ -0,0 +1,136 @@
+#include "hw_backend.hpp"
+
+// CPU HwBackend — the same acquire / motion / preprocess / infer contract over
+// host RGB24 frames (cpu_surface()), with no accelerator. It is what the
+// detector family runs on a GPU-less box and what the tests drive, so the
+// device backends only have to match its output.
+//
+//   * acquire(av_frame) has no hw frame to hold: host frames are wrapped with
+//     cpu_surface() by the caller and need no release.
+//   * motion() is the luma-grid diff of the CUDA gpudiff path (ds 8, thr 25),
+//     returning one merged changed region.
+//   * preprocess()/preprocess_batch() use the hw_preprocess_cpu.hpp kernels into
+//     a backend-owned host buffer; infer() runs a per-instance ORT CPU session on
+//     a YOLO26 NMS-free model, like detect_onnx's CPU path.
+
+#include "hw_preprocess_cpu.hpp"
+#include "ort_model.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace zm::hw {
+namespace {
+
+bool isHostRgb(const Surface& s) {
+    return s.hw_type == 0 && s.pix_fmt == 101 && s.plane_ptr[0] && s.width > 0 && s.height > 0;
+}
+
+class CpuBackend : public HwBackend {
+public:
+    const char* name() const override { return "cpu"; }
+
+    bool load_model(const std::string& path, int net) override {
+        net_ = net;
+        return model_.load(path, "cpu", "hw_cpu");
+    }
+
+    Surface acquire(uint64_t) override { return {}; }
+    void release(Surface& s) override { s.owner = nullptr; }
+
+    std::vector<Region> motion(const Surface& s) override {
+        if (!isHostRgb(s)) return {};
+        const int gw = s.width / ds_, gh = s.height / ds_;
+        if (gw <= 0 || gh <= 0) return {};
+        const auto* rgb = reinterpret_cast<const uint8_t*>(s.plane_ptr[0]);
+        grid_.resize(static_cast<size_t>(gw) * gh);
+        for (int gy = 0; gy < gh; ++gy) {
+            const uint8_t* row = rgb + static_cast<size_t>(gy * ds_ + ds_ / 2) * s.linesize[0];
+            for (int gx = 0; gx < gw; ++gx) {
+                const uint8_t* p = row + (gx * ds_ + ds_ / 2) * 3;
+                grid_[gy * gw + gx] = static_cast<uint8_t>((77 * p[0] + 150 * p[1] + 29 * p[2]) >> 8);
+            }
+        }
+        const bool first = prevGrid_.size() != grid_.size();
+        std::swap(grid_, prevGrid_);
+        if (first) return {};
+        const int minCells = std::max(8, gw * gh / 400);
+        int x0 = gw, y0 = gh, x1 = -1, y1 = -1, changed = 0;
+        for (int gy = 0; gy < gh; ++gy)
+            for (int gx = 0; gx < gw; ++gx) {
+                const int i = gy * gw + gx;
+                if (std::abs(static_cast<int>(prevGrid_[i]) - grid_[i]) <= thr_) continue;
+                ++changed;
+                x0 = std::min(x0, gx); y0 = std::min(y0, gy);
+                x1 = std::max(x1, gx); y1 = std::max(y1, gy);
+            }
+        if (changed < minCells) return {};
+        return {Region{x0 * ds_, y0 * ds_, (x1 - x0 + 1) * ds_, (y1 - y0 + 1) * ds_}};
+    }
+
+    DeviceTensor preprocess(const Surface& s, Region crop) override {
+        DeviceTensor t;
+        t.net = net_;
+        TensorSpec spec;
+        spec.width = spec.height = net_;
+        BatchTensor b = preprocess_batch(s, {crop}, spec);
+        if (!b.valid()) return t;
+        // DeviceTensor maps boxes to the full frame; fold the crop origin into
+        // the letterbox padding so unletterbox lands in source pixels.
+        t.lb = b.lb[0];
+        t.lb.pad_x -= static_cast<int>(std::lround(b.crops[0].x * t.lb.scale));
+        t.lb.pad_y -= static_cast<int>(std::lround(b.crops[0].y * t.lb.scale));
+        t.lb.src_w = s.width;
+        t.lb.src_h = s.height;
+        t.ptr = b.data;
+        return t;
+    }
+
+    std::vector<Detection> infer(const DeviceTensor& t, float conf,
+                                 const std::vector<int>& allow) override {
+        if (!t.ptr || !model_.loaded()) return {};
+        try {
+            auto outs = model_.run(static_cast<float*>(t.ptr), {1, 3, t.net, t.net}, false);
+            const auto shape = outs[0].GetTensorTypeAndShapeInfo().GetShape();
+            int num = 0;
+            if (shape.size() == 3) num = static_cast<int>(shape[1]);
+            else if (shape.size() == 2) num = static_cast<int>(shape[0]);
+            return zm::detect::decode_nms_free(outs[0].GetTensorData<float>(), num, t.lb, conf, allow);
+        } catch (const std::exception&) {
+            return {};
+        }
+    }
+
+    BatchTensor preprocess_batch(const Surface& s, const std::vector<Region>& crops,
+                                 const TensorSpec& spec) override {
+        BatchTensor t;
+        if (!isHostRgb(s) || spec.width <= 0 || spec.height <= 0 ||
+            (spec.channels != 1 && spec.channels != 3) ||
+            (spec.letterbox && spec.width != spec.height))
+            return t;
+        preprocess_rgb_batch(reinterpret_cast<const uint8_t*>(s.plane_ptr[0]), s.width, s.height,
+                             s.linesize[0], crops, spec, buf_, t.lb, t.crops);
+        t.data = buf_.data();
+        t.n = static_cast<int>(t.crops.size());
+        t.channels = spec.channels;
+        t.height = spec.height;
+        t.width = spec.width;
+        return t;
+    }
+
+private:
+    OrtModel model_;
+    int net_ = 640;
+    std::vector<float> buf_;                  // preprocess output, reused per call
+    std::vector<uint8_t> grid_, prevGrid_;    // motion luma grids
+    int ds_ = 8, thr_ = 25;
+};
+
+}  // namespace
+
+std::unique_ptr<HwBackend> make_cpu_backend() {
+    return std::make_unique<CpuBackend>();
+}
+
+}  // namespace zm::hw
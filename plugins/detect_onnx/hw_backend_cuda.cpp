@@ -5,7 +5,9 @@
 #include "detect_cuda.hpp"      // cuda_motion_bbox_gpudiff / cuda_motion_regions_cpudiff, cuda_preprocess_nv12
 #include "detect_engine.hpp"    // shared batched InferenceEngine
 #include <algorithm>
+#include <cmath>
 #include <cstdlib>              // getenv (ZM_MOTION_REGIONS opt-in)
+#include <cuda_runtime_api.h>   // cudaMalloc / cudaMemcpy (batch staging)
 
 extern "C" {
 #include <libavutil/frame.h>    // av_frame_clone / av_frame_free  (surface lifetime)
@@ -22,6 +24,7 @@ class CudaBackend : public HwBackend {
 public:
     ~CudaBackend() override {
         if (gpuDiff_) { zm::detect::gpudiff_state_destroy(gpuDiff_); gpuDiff_ = nullptr; }
+        if (dBatch_) { cudaFree(dBatch_); dBatch_ = nullptr; }
     }
 
     const char* name() const override { return "cuda"; }
@@ -97,12 +100,66 @@ public:
             .infer(static_cast<const float*>(t.ptr), t.lb, conf, allow);
     }
 
+    // Generic preprocess on the device. The NV12 kernel implements exactly the
+    // YOLO letterbox (RGB, /255, pad 114), so that is the spec served here; any
+    // other layout (stretched OCR/face crops, luma) returns invalid and the
+    // caller falls back. One crop is handed out in place; several are staged
+    // into one [n,3,net,net] device buffer.
+    BatchTensor preprocess_batch(const Surface& s, const std::vector<Region>& crops,
+                                 const TensorSpec& spec) override {
+        BatchTensor t;
+        if (!s.plane_ptr[0] || !s.plane_ptr[1] || s.hw_type != 1 || !spec.letterbox ||
+            spec.channels != 3 || spec.width != spec.height || spec.mean != 0.0f ||
+            std::fabs(spec.scale * 255.0f - 1.0f) > 1e-6f || spec.pad != 114)
+            return t;
+        const int net = spec.width;
+        const size_t item = static_cast<size_t>(3) * net * net;
+        const std::vector<Region> want = crops.empty() ? std::vector<Region>{Region{}} : crops;
+        if (want.size() > 1 && want.size() * item > batchFloats_) {
+            if (dBatch_) cudaFree(dBatch_);
+            dBatch_ = nullptr;
+            batchFloats_ = 0;
+            if (cudaMalloc(&dBatch_, want.size() * item * sizeof(float)) != cudaSuccess) return t;
+            batchFloats_ = want.size() * item;
+        }
+        for (size_t i = 0; i < want.size(); ++i) {
+            // Same even-aligned clamp as cuda_preprocess_nv12, so crops[i] is the
+            // region the letterbox actually covers.
+            Region r = want[i];
+            if (r.w <= 0 || r.h <= 0) r = {0, 0, s.width, s.height};
+            r.x &= ~1; r.y &= ~1; r.w &= ~1; r.h &= ~1;
+            if (r.x + r.w > s.width) r.w = (s.width - r.x) & ~1;
+            if (r.y + r.h > s.height) r.h = (s.height - r.y) & ~1;
+            zm::detect::Letterbox lb;
+            const float* d = zm::detect::cuda_preprocess_nv12(
+                s.plane_ptr[0], s.linesize[0], s.plane_ptr[1], s.linesize[1],
+                s.width, s.height, net, lb, r.x, r.y, r.w, r.h);
+            if (!d) return {};
+            if (want.size() == 1) {
+                t.data = const_cast<float*>(d);
+            } else if (cudaMemcpy(static_cast<float*>(dBatch_) + i * item, d, item * sizeof(float),
+                                  cudaMemcpyDeviceToDevice) != cudaSuccess) {
+                return {};
+            }
+            t.lb.push_back(lb);
+            t.crops.push_back(r);
+        }
+        if (want.size() > 1) t.data = static_cast<float*>(dBatch_);
+        t.device = true;
+        t.n = static_cast<int>(want.size());
+        t.channels = 3;
+        t.height = t.width = net;
+        return t;
+    }
+
 private:
     std::string model_;
     int net_ = 640;
     std::vector<uint8_t> prevGrid_;            // per-instance motion state (regions opt-in path)
     zm::detect::GpuDiffState* gpuDiff_ = nullptr;  // device-resident prev grid (default gpudiff path), lazily created
     int ds_ = 8, thr_ = 25, minCells_ = 0, maxRegions_ = 8;
+    void* dBatch_ = nullptr;                   // [n,3,net,net] staging for multi-crop batches
+    size_t batchFloats_ = 0;
 };
 
 }  // namespace
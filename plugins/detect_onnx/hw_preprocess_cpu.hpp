@@ -0,0 +1,147 @@
+#pragma once
+
+// Pure CPU kernels behind the "cpu" HwBackend's preprocess_batch(): crop an
+// interleaved RGB24 frame, letterbox or stretch it bilinearly to the model
+// size, and write normalized CHW floats. Runtime-free so it is unit-testable;
+// the whole-frame letterbox matches detect::letterbox_rgb_to_chw.
+
+#include "detect_postprocess.hpp"   // Letterbox, compute_letterbox
+#include "hw_backend.hpp"           // Region, TensorSpec
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace zm::hw {
+
+// Clamp a crop to the frame; {0,0,0,0} (or anything empty after clamping) is
+// the whole frame.
+inline Region clamp_region(Region r, int width, int height) {
+    if (r.w <= 0 || r.h <= 0) return {0, 0, width, height};
+    const int x0 = std::clamp(r.x, 0, width);
+    const int y0 = std::clamp(r.y, 0, height);
+    const int x1 = std::clamp(r.x + r.w, 0, width);
+    const int y1 = std::clamp(r.y + r.h, 0, height);
+    if (x1 <= x0 || y1 <= y0) return {0, 0, width, height};
+    return {x0, y0, x1 - x0, y1 - y0};
+}
+
+namespace detail {
+
+// Bilinear taps for one axis: dst i samples src (i0, i1) with weight w, at
+// scale `inv` source px per dst px, both indices clamped to [0, n-1].
+struct Taps {
+    std::vector<int> i0, i1;
+    std::vector<float> w;
+};
+
+inline void make_taps(int n_dst, float inv, int n_src, Taps& t) {
+    t.i0.resize(n_dst);
+    t.i1.resize(n_dst);
+    t.w.resize(n_dst);
+    for (int i = 0; i < n_dst; ++i) {
+        const float s = (i + 0.5f) * inv - 0.5f;
+        const float f = std::floor(s);
+        t.i0[i] = std::clamp(static_cast<int>(f), 0, n_src - 1);
+        t.i1[i] = std::min(t.i0[i] + 1, n_src - 1);
+        t.w[i] = s - f;
+    }
+}
+
+// Resample `crop` of an RGB24 frame to out_w x out_h pixels and store channel
+// values at (off_x, off_y) of a dst plane set (plane = dst_w*dst_h floats).
+inline void resample_into(const uint8_t* rgb, int stride, Region crop, int out_w, int out_h,
+                          float inv_x, float inv_y, const TensorSpec& spec,
+                          float* dst, int dst_w, int dst_h, int off_x, int off_y) {
+    Taps tx, ty;
+    make_taps(out_w, inv_x, crop.w, tx);
+    make_taps(out_h, inv_y, crop.h, ty);
+    const size_t plane = static_cast<size_t>(dst_w) * dst_h;
+    std::vector<float> px(static_cast<size_t>(out_w) * 3);
+    for (int y = 0; y < out_h; ++y) {
+        const uint8_t* r0 = rgb + static_cast<size_t>(crop.y + ty.i0[y]) * stride + crop.x * 3;
+        const uint8_t* r1 = rgb + static_cast<size_t>(crop.y + ty.i1[y]) * stride + crop.x * 3;
+        const float wy = ty.w[y];
+        for (int x = 0; x < out_w; ++x) {
+            const int a = tx.i0[x] * 3, b = tx.i1[x] * 3;
+            const float wx = tx.w[x];
+            for (int c = 0; c < 3; ++c) {
+                const float p00 = r0[a + c], p01 = r0[b + c];
+                const float p10 = r1[a + c], p11 = r1[b + c];
+                const float top = p00 + (p01 - p00) * wx;
+                const float bot = p10 + (p11 - p10) * wx;
+                px[x * 3 + c] = top + (bot - top) * wy;
+            }
+        }
+        const size_t row = static_cast<size_t>(y + off_y) * dst_w + off_x;
+        if (spec.channels == 1) {
+            float* out = dst + row;
+            for (int x = 0; x < out_w; ++x) {
+                const float l = 0.299f * px[x * 3] + 0.587f * px[x * 3 + 1] + 0.114f * px[x * 3 + 2];
+                out[x] = (l - spec.mean) * spec.scale;
+            }
+        } else {
+            for (int c = 0; c < 3; ++c) {
+                float* out = dst + c * plane + row;
+                for (int x = 0; x < out_w; ++x) out[x] = (px[x * 3 + c] - spec.mean) * spec.scale;
+            }
+        }
+    }
+}
+
+}  // namespace detail
+
+// Letterbox `crop` of an RGB24 frame into spec.channels x net x net floats
+// (net = spec.width). The returned Letterbox maps net space to crop-relative
+// pixels.
+inline zm::detect::Letterbox letterbox_crop(const uint8_t* rgb, int stride, Region crop,
+                                            const TensorSpec& spec, float* dst) {
+    const int net = spec.width;
+    zm::detect::Letterbox lb = zm::detect::compute_letterbox(crop.w, crop.h, net);
+    const size_t floats = static_cast<size_t>(spec.channels) * net * net;
+    std::fill(dst, dst + floats, (spec.pad - spec.mean) * spec.scale);
+    const int new_w = static_cast<int>(std::round(crop.w * lb.scale));
+    const int new_h = static_cast<int>(std::round(crop.h * lb.scale));
+    if (new_w <= 0 || new_h <= 0) return lb;
+    detail::resample_into(rgb, stride, crop, new_w, new_h, 1.0f / lb.scale, 1.0f / lb.scale,
+                          spec, dst, net, net, lb.pad_x, lb.pad_y);
+    return lb;
+}
+
+// Stretch `crop` of an RGB24 frame to spec.width x spec.height (aspect not
+// kept), as face embedders and plate OCR expect.
+inline void stretch_crop(const uint8_t* rgb, int stride, Region crop, const TensorSpec& spec,
+                         float* dst) {
+    detail::resample_into(rgb, stride, crop, spec.width, spec.height,
+                          static_cast<float>(crop.w) / spec.width,
+                          static_cast<float>(crop.h) / spec.height,
+                          spec, dst, spec.width, spec.height, 0, 0);
+}
+
+// Preprocess every crop of a width x height RGB24 frame into `out` (resized to
+// n * item floats); fills `lbs`/`used` per item. Stretch items get a
+// Letterbox with scale 1 and no padding (callers map their own boxes).
+inline void preprocess_rgb_batch(const uint8_t* rgb, int width, int height, int stride,
+                                 const std::vector<Region>& crops, const TensorSpec& spec,
+                                 std::vector<float>& out, std::vector<zm::detect::Letterbox>& lbs,
+                                 std::vector<Region>& used) {
+    const size_t n = crops.empty() ? 1 : crops.size();
+    const size_t item = static_cast<size_t>(spec.channels) * spec.width * spec.height;
+    out.resize(n * item);
+    lbs.assign(n, {});
+    used.assign(n, {});
+    for (size_t i = 0; i < n; ++i) {
+        used[i] = clamp_region(crops.empty() ? Region{} : crops[i], width, height);
+        if (spec.letterbox) {
+            lbs[i] = letterbox_crop(rgb, stride, used[i], spec, out.data() + i * item);
+        } else {
+            stretch_crop(rgb, stride, used[i], spec, out.data() + i * item);
+            lbs[i].net = spec.width;
+            lbs[i].src_w = used[i].w;
+            lbs[i].src_h = used[i].h;
+        }
+    }
+}
+
+}  // namespace zm::hw
@@ -0,0 +1,95 @@
+#pragma once
+
+// InferPipeline — the frame side of the detector family on top of HwBackend:
+// turn an on_frame buffer into a Surface (host RGB24 or a decoded device
+// surface), preprocess crops of it into a batched tensor, and release it. The
+// model side is OrtModel (ort_model.hpp); a plugin owns one pipeline and one
+// OrtModel per network.
+//
+//   zm::hw::InferPipeline pipe;
+//   pipe.open(cfg.value("hw", "cpu"));                          // start()
+//   zm::hw::Surface s;
+//   if (!pipe.acquire(buf, size, frameW, frameH, s)) { forward; return; }
+//   auto t = pipe.preprocess(s, {}, spec);                       // letterbox
+//   auto outs = model.run(t);
+//   pipe.release(s);
+//
+// The CPU backend always exists; a device backend ("cuda", ...) is added when it
+// is built in and handles the device surfaces decode_ffmpeg emits in hw mode, so
+// frames never take the download + swscale detour. Tensors from it are device
+// memory: pair it with an OrtModel on the matching EP (device_inputs()).
+
+#include "hw_backend.hpp"
+#include "zm_plugin.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace zm::hw {
+
+class InferPipeline {
+public:
+    // hw: "cpu" (host frames only) or a device backend name. Returns the device
+    // backend's name, or "cpu" when none was requested or it is unavailable.
+    std::string open(const std::string& hw) {
+        cpu_ = make_backend("cpu");
+        device_.reset();
+        if (!hw.empty() && hw != "cpu") device_ = make_backend(hw);
+        return device_ ? device_->name() : "cpu";
+    }
+
+    bool has_device() const { return device_ != nullptr; }
+
+    // Wrap an on_frame buffer. RGB24 frames need width/height (the plugins'
+    // frame_width/frame_height); device frames carry their own. False = not a
+    // frame this pipeline can use (caller forwards it untouched).
+    bool acquire(const void* buf, size_t size, int width, int height, Surface& out) {
+        out = {};
+        if (!buf || size < sizeof(zm_frame_hdr_t)) return false;
+        const auto* hdr = static_cast<const zm_frame_hdr_t*>(buf);
+        const auto* payload = static_cast<const uint8_t*>(buf) + sizeof(zm_frame_hdr_t);
+        if (hdr->hw_type == ZM_FRAME_RGB24) {
+            if (width <= 0 || height <= 0 ||
+                size < sizeof(zm_frame_hdr_t) + static_cast<size_t>(width) * height * 3)
+                return false;
+            out = cpu_surface(payload, width, height);
+            return true;
+        }
+        if (device_ && (hdr->hw_type == ZM_HW_CUDA || hdr->hw_type == ZM_HW_VAAPI ||
+                        hdr->hw_type == ZM_HW_VTB) &&
+            size >= sizeof(zm_frame_hdr_t) + sizeof(zm_gpu_frame_t)) {
+            const auto* g = reinterpret_cast<const zm_gpu_frame_t*>(payload);
+            out = device_->acquire(g->av_frame);
+            return out.owner != nullptr;
+        }
+        return false;
+    }
+
+    void release(Surface& s) {
+        if (s.owner && device_) device_->release(s);
+        s = {};
+    }
+
+    // Host surfaces go to the CPU backend, device surfaces to the device one.
+    // Invalid when the backend cannot produce `spec` from this surface.
+    BatchTensor preprocess(const Surface& s, const std::vector<Region>& crops,
+                           const TensorSpec& spec) {
+        HwBackend* be = s.owner ? device_.get() : cpu_.get();
+        return be ? be->preprocess_batch(s, crops, spec) : BatchTensor{};
+    }
+
+    // Host RGB24 pixels of the surface, or nullptr for device surfaces (for the
+    // cheap CPU-side extras: sharpness, colour histograms, snapshots).
+    static const uint8_t* host_rgb(const Surface& s) {
+        return (!s.owner && s.pix_fmt == ZM_FRAME_RGB24)
+                   ? reinterpret_cast<const uint8_t*>(s.plane_ptr[0])
+                   : nullptr;
+    }
+
+private:
+    std::unique_ptr<HwBackend> cpu_;
+    std::unique_ptr<HwBackend> device_;
+};
+
+}  // namespace zm::hw
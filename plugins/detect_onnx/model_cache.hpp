@@ -0,0 +1,228 @@
+#pragma once
+
+// Model cache plumbing shared by the ONNX Runtime plugins (see open_session()
+// in ort_model.hpp): a content hash and cache file name for an ORT-optimized
+// model and the startup time / RSS report. Cached models are opened through
+// zm::io::MappedFile (common/mapped_file.hpp) so every worker loading the same
+// one shares its physical pages. ORT-free so it is unit-testable.
+//
+// The cache directory is $ZM_MODEL_CACHE (default $XDG_CACHE_HOME/zm, else
+// /tmp/zm_ort_cache-<euid>); "off" or "0" disables it. Entries are only trusted
+// from a directory owned by this user that nobody else can write to
+// (prepare_cache_dir()).
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+#include "mapped_file.hpp"
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+namespace zm::hw {
+
+// 64-bit FNV-1a over 8-byte words (then the tail bytes) and the length. A
+// cache key, not a checksum: any edit to the model changes it.
+inline uint64_t content_hash(const uint8_t* p, size_t n) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    const uint64_t prime = 0x100000001b3ull;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        h = (h ^ w) * prime;
+    }
+    for (; i < n; ++i) h = (h ^ p[i]) * prime;
+    return (h ^ static_cast<uint64_t>(n)) * prime;
+}
+
+// Cache directory, or "" when caching is disabled. The default is per user: a
+// shared, predictable /tmp path would let any local user plant entries.
+inline std::string model_cache_dir() {
+    const char* e = std::getenv("ZM_MODEL_CACHE");
+    if (!e) {
+        const char* xdg = std::getenv("XDG_CACHE_HOME");
+        if (xdg && *xdg == '/') return std::string(xdg) + "/zm";
+#if ZM_MAPPED_FILE_MMAP
+        return "/tmp/zm_ort_cache-" + std::to_string(::geteuid());
+#else
+        return "";
+#endif
+    }
+    const std::string dir = e;
+    if (dir.empty() || dir == "0" || dir == "off") return "";
+    return dir;
+}
+
+// Create `dir` (mode 0700) if missing and check that its entries can be
+// trusted: a real directory (not a symlink) owned by geteuid() and not
+// writable by group or others. Cached graphs are handed to ORT as mapped
+// bytes, so anyone who can write the directory controls what the workers
+// run. False with the reason in *why otherwise; load uncached then.
+inline bool prepare_cache_dir(std::string dir, std::string* why) {
+#if ZM_MAPPED_FILE_MMAP
+    while (dir.size() > 1 && dir.back() == '/') dir.pop_back();  // lstat must not follow
+    auto fail = [&](const std::string& reason) {
+        if (why) *why = "untrusted model cache " + dir + ": " + reason;
+        return false;
+    };
+    const size_t slash = dir.find_last_of('/');
+    if (slash != std::string::npos && slash > 0) {
+        std::error_code ec;
+        std::filesystem::create_directories(dir.substr(0, slash), ec);
+    }
+    if (::mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) return fail(std::strerror(errno));
+    struct stat st{};
+    if (::lstat(dir.c_str(), &st) != 0) return fail(std::strerror(errno));
+    if (!S_ISDIR(st.st_mode)) return fail("not a directory");
+    if (st.st_uid != ::geteuid()) return fail("not owned by this user");
+    if (st.st_mode & (S_IWGRP | S_IWOTH)) return fail("writable by group or others");
+    return true;
+#else
+    (void)dir;
+    if (why) *why = "model cache needs mmap";
+    return false;
+#endif
+}
+
+// Optimizations at ORT_ENABLE_ALL are specific to the CPU they ran on (e.g.
+// the NCHWc block size), so the widest x86 vector extension is part of the key.
+inline const char* cpu_tag() {
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    if (__builtin_cpu_supports("avx512f")) return "avx512";
+    if (__builtin_cpu_supports("avx2")) return "avx2";
+    return "x86";
+#elif defined(__aarch64__)
+    return "arm64";
+#else
+    return "generic";
+#endif
+}
+
+// "<model stem>.<hash>.<ep>.<level>.<cpu>.ort<version>.ort"; characters
+// outside [A-Za-z0-9_-] in the variable parts become '_'.
+inline std::string cache_file_name(const std::string& model_path, uint64_t hash,
+                                   const std::string& ep, const std::string& level,
+                                   const std::string& ort_version, const std::string& cpu) {
+    auto clean = [](std::string s) {
+        for (char& c : s) {
+            const bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                            (c >= '0' && c <= '9') || c == '_' || c == '-';
+            if (!ok) c = '_';
+        }
+        return s;
+    };
+    std::string stem = model_path.substr(model_path.find_last_of("/\\") + 1);
+    const size_t dot = stem.rfind('.');
+    if (dot != std::string::npos && dot > 0) stem.resize(dot);
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    return clean(stem) + "." + hex + "." + clean(ep) + "." + clean(level) + "." + clean(cpu) +
+           ".ort" + clean(ort_version) + ".ort";
+}
+
+// Per-process suffix for a cache entry being written.
+inline std::string temp_suffix() {
+#if ZM_MAPPED_FILE_MMAP
+    return ".tmp" + std::to_string(::getpid());
+#else
+    return ".tmp" + std::to_string(::_getpid());
+#endif
+}
+
+// Resident set of this process; `shared` is the file-backed part (Linux
+// only; -1 elsewhere). Both -1 when unavailable.
+struct MemUsage {
+    int64_t rss = -1;
+    int64_t shared = -1;
+};
+
+inline MemUsage mem_usage() {
+    MemUsage m;
+#if defined(__linux__)
+    if (FILE* f = std::fopen("/proc/self/statm", "r")) {
+        long long size = 0, resident = 0, shared = 0;
+        if (std::fscanf(f, "%lld %lld %lld", &size, &resident, &shared) == 3) {
+            const int64_t page = ::sysconf(_SC_PAGESIZE);
+            m.rss = resident * page;
+            m.shared = shared * page;
+        }
+        std::fclose(f);
+    }
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info{};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                  reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS)
+        m.rss = static_cast<int64_t>(info.resident_size);
+#endif
+    return m;
+}
+
+// What one model load cost; summary() goes into the plugin's "loaded" log.
+struct ModelLoadStats {
+    enum class Cache {
+        Off,     // caching disabled, or the EP cannot serialize its graph
+        Hit,     // loaded the mapped, pre-optimized graph
+        Miss,    // optimized from the source model and wrote the cache entry
+        Failed,  // could not use or write the cache; loaded the source model
+    };
+    Cache cache = Cache::Off;
+    double load_ms = 0;
+    size_t mapped_bytes = 0;
+    int64_t rss_delta = 0;      // 0 when unavailable
+    int64_t private_delta = 0;  // RSS minus file-backed pages (Linux)
+    std::string cache_path;
+    std::string note;           // why the cache was not used
+
+    std::string summary() const {
+        static const char* const names[] = {"off", "hit", "miss", "failed"};
+        auto mib = [](int64_t b) { return static_cast<double>(b) / (1024.0 * 1024.0); };
+        char buf[160];
+        int n = std::snprintf(buf, sizeof(buf), "ready in %.0f ms (cache %s", load_ms,
+                              names[static_cast<int>(cache)]);
+        if (mapped_bytes)
+            n += std::snprintf(buf + n, sizeof(buf) - n, ", %.1f MiB mapped",
+                               mib(static_cast<int64_t>(mapped_bytes)));
+        n += std::snprintf(buf + n, sizeof(buf) - n, "; RSS %+.1f MiB", mib(rss_delta));
+#if defined(__linux__)
+        n += std::snprintf(buf + n, sizeof(buf) - n, ", private %+.1f MiB", mib(private_delta));
+#endif
+        std::snprintf(buf + n, sizeof(buf) - n, ")");
+        return note.empty() ? std::string(buf) : std::string(buf) + ": " + note;
+    }
+};
+
+// Measures a load: construct before, finish() after.
+class LoadProbe {
+public:
+    LoadProbe() : t0_(std::chrono::steady_clock::now()), m0_(mem_usage()) {}
+    void finish(ModelLoadStats& s) const {
+        s.load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0_)
+                        .count();
+        const MemUsage m1 = mem_usage();
+        if (m0_.rss >= 0 && m1.rss >= 0) s.rss_delta = m1.rss - m0_.rss;
+        if (m0_.shared >= 0 && m1.shared >= 0)
+            s.private_delta = (m1.rss - m1.shared) - (m0_.rss - m0_.shared);
+    }
+
+private:
+    std::chrono::steady_clock::time_point t0_;
+    MemUsage m0_;
+};
+
+}  // namespace zm::hw
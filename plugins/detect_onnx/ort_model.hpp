@@ -0,0 +1,269 @@
+#pragma once
+
+// OrtModel — the ONNX Runtime session setup every detector-family plugin used
+// to repeat (env, options, execution provider, I/O names), plus a Run() that
+// takes a hw::BatchTensor and binds it from host or device memory. Header-only;
+// consumers already link onnxruntime.
+//
+// Sessions come from open_session(), which keeps ORT-optimized models in the
+// shared model cache (model_cache.hpp): the first start on a host optimizes
+// and saves the graph in ORT format, later starts map that file and build the
+// session on the mapped bytes, so no re-optimization and no per-process copy
+// of the weights.
+//
+//   zm::hw::OrtModel m;
+//   std::string err, note;
+//   if (!m.load(path, "cpu", "detect_pose", &err, &note)) ...
+//   auto outs = m.run(pipeline.preprocess(surface, {}, spec));
+
+#include "hw_backend.hpp"
+#include "model_cache.hpp"
+#include "zm_plugin.h"
+
+#include <onnxruntime_cxx_api.h>
+#ifdef __APPLE__
+#include <coreml_provider_factory.h>
+#endif
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace zm::hw {
+
+// A session plus the mapped cache file backing its weights. Keep `mapping`
+// alive at least as long as `session` (declare it first).
+struct CachedSession {
+    std::shared_ptr<const io::MappedFile> mapping;
+    std::unique_ptr<Ort::Session> session;
+    ModelLoadStats stats;
+};
+
+// Create a session for `path` through the model cache. `options` carry the
+// execution provider and ORT_ENABLE_ALL; they are cloned, not modified. `ep`
+// names the provider actually appended (part of the cache key); "coreml"
+// compiles its partitions, which ORT cannot serialize, so it bypasses the
+// cache. Throws like the Ort::Session constructor when the model itself
+// cannot be loaded.
+inline CachedSession open_session(Ort::Env& env, const std::string& path,
+                                  const Ort::SessionOptions& options, const std::string& ep) {
+    CachedSession out;
+    const LoadProbe probe;
+    const std::string dir = ep == "coreml" ? std::string() : model_cache_dir();
+    std::shared_ptr<const io::MappedFile> source = dir.empty() ? nullptr : io::MappedFile::open(path);
+    std::error_code ec;
+    if (source && !prepare_cache_dir(dir, &out.stats.note)) {
+        out.stats.cache = ModelLoadStats::Cache::Failed;
+        ZM_LOG_WARN("model cache: %s", out.stats.note.c_str());
+        source.reset();
+    }
+
+    if (source) {
+        const size_t model_bytes = source->size();
+        const std::string cached = dir + "/" +
+            cache_file_name(path, content_hash(source->data(), source->size()), ep, "all",
+                            Ort::GetVersionString(), cpu_tag());
+        source.reset();
+        out.stats.cache_path = cached;
+
+        if (auto map = io::MappedFile::open(cached)) {
+            try {
+                Ort::SessionOptions so = options.Clone();
+                so.SetGraphOptimizationLevel(ORT_DISABLE_ALL);  // already optimized
+                so.AddConfigEntry("session.load_model_format", "ORT");
+                so.AddConfigEntry("session.use_ort_model_bytes_directly", "1");
+                so.AddConfigEntry("session.use_ort_model_bytes_for_initializers", "1");
+                out.session = std::make_unique<Ort::Session>(env, map->data(), map->size(), so);
+                out.stats.cache = ModelLoadStats::Cache::Hit;
+                out.stats.mapped_bytes = map->size();
+                out.mapping = std::move(map);
+            } catch (const std::exception& e) {
+                // Truncated or written by an incompatible build: rebuild it.
+                out.stats.note = std::string("dropped unusable cache entry: ") + e.what();
+                std::filesystem::remove(cached, ec);
+            }
+        }
+
+        const std::string failed = cached + ".failed";
+        if (!out.session && !std::filesystem::exists(failed, ec)) {
+            // Each process writes its own temp file; the rename is atomic, so
+            // concurrent cold starts race harmlessly. Only ORT being unable to
+            // serialize the graph is remembered in `failed`; filesystem trouble
+            // (read-only or full cache directory, failed rename) is retried on
+            // the next start.
+            const std::string tmp = cached + temp_suffix();
+            std::string fs_error;
+            if (FILE* f = std::fopen(tmp.c_str(), "wb")) std::fclose(f);
+            else fs_error = "cannot create " + tmp + ": " + std::strerror(errno);
+            if (fs_error.empty()) {
+                try {
+                    Ort::SessionOptions so = options.Clone();
+                    so.SetOptimizedModelFilePath(tmp.c_str());
+                    so.AddConfigEntry("session.save_model_format", "ORT");
+                    out.session = std::make_unique<Ort::Session>(env, path.c_str(), so);
+                } catch (const Ort::Exception& e) {
+                    // ORT reports a failed write the same way as an
+                    // unserializable graph; no room for the model means the
+                    // former.
+                    const auto space = std::filesystem::space(dir, ec);
+                    if (!ec && space.available < model_bytes) {
+                        fs_error = std::string("cache directory full: ") + e.what();
+                    } else {
+                        out.stats.cache = ModelLoadStats::Cache::Failed;
+                        out.stats.note = std::string("cannot write cache entry: ") + e.what();
+                        if (FILE* f = std::fopen(failed.c_str(), "w")) std::fclose(f);
+                    }
+                } catch (const std::exception& e) {
+                    fs_error = std::string("cannot write cache entry: ") + e.what();
+                }
+            }
+            if (out.session) {
+                std::filesystem::rename(tmp, cached, ec);
+                if (ec) fs_error = "cannot rename " + tmp + ": " + ec.message();
+                else out.stats.cache = ModelLoadStats::Cache::Miss;
+            }
+            if (!fs_error.empty()) {
+                out.stats.cache = ModelLoadStats::Cache::Failed;
+                out.stats.note = fs_error + " (retrying next start)";
+                ZM_LOG_WARN("model cache: %s", out.stats.note.c_str());
+            }
+            if (out.stats.cache != ModelLoadStats::Cache::Miss) std::filesystem::remove(tmp, ec);
+        } else if (!out.session) {
+            out.stats.cache = ModelLoadStats::Cache::Failed;
+            out.stats.note = "cache disabled for this model (" + failed + ")";
+        }
+    }
+
+    if (!out.session) out.session = std::make_unique<Ort::Session>(env, path.c_str(), options);
+    probe.finish(out.stats);
+    return out;
+}
+
+class OrtModel {
+public:
+    // ep: "cpu" | "coreml" (Apple) | "cuda" (ZM_WITH_CUDA builds). An unavailable
+    // EP falls back to CPU and says so in *note. False (with *err) when the
+    // model cannot be loaded; the plugin then runs as a pass-through.
+    bool load(const std::string& path, const std::string& ep, const char* tag,
+              std::string* err = nullptr, std::string* note = nullptr) {
+        session_.reset();
+        mapping_.reset();
+        deviceInputs_ = false;
+        try {
+            if (!env_) env_ = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, tag);
+            options_ = Ort::SessionOptions();
+            options_.SetIntraOpNumThreads(1);
+            options_.SetGraphOptimizationLevel(ORT_ENABLE_ALL);
+            CachedSession cs = open_session(*env_, path, options_, appendProvider(ep, note));
+            mapping_ = std::move(cs.mapping);
+            session_ = std::move(cs.session);
+            stats_ = std::move(cs.stats);
+
+            Ort::AllocatorWithDefaultOptions allocator;
+            inputName_ = session_->GetInputNameAllocated(0, allocator).get();
+            outputNames_.clear();
+            for (size_t i = 0; i < session_->GetOutputCount(); ++i)
+                outputNames_.emplace_back(session_->GetOutputNameAllocated(i, allocator).get());
+            inputShape_ = session_->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+            return true;
+        } catch (const std::exception& e) {
+            if (err) *err = e.what();
+            session_.reset();
+            mapping_.reset();
+            return false;
+        }
+    }
+
+    bool loaded() const { return session_ != nullptr; }
+    Ort::Session& session() { return *session_; }
+    const std::string& input_name() const { return inputName_; }
+    const std::vector<std::string>& output_names() const { return outputNames_; }
+    // Declared input shape; dynamic dims are -1.
+    const std::vector<int64_t>& input_shape() const { return inputShape_; }
+    bool dynamic_batch() const { return !inputShape_.empty() && inputShape_[0] < 0; }
+    // The CUDA EP is active, so device-resident BatchTensors bind without a copy.
+    bool device_inputs() const { return deviceInputs_; }
+    // Startup time, cache outcome and RSS cost of the last load().
+    const ModelLoadStats& load_stats() const { return stats_; }
+
+    // Run on a preprocessed batch [n, c, h, w]; `outputs` = indices into
+    // output_names() (empty = the first output). Throws on failure.
+    std::vector<Ort::Value> run(const BatchTensor& t, const std::vector<size_t>& outputs = {}) {
+        if (!t.valid()) throw std::runtime_error("invalid input tensor");
+        const std::vector<int64_t> shape{t.n, t.channels, t.height, t.width};
+        return run(t.data, shape, t.device, outputs);
+    }
+
+    std::vector<Ort::Value> run(float* data, const std::vector<int64_t>& shape, bool device,
+                                const std::vector<size_t>& outputs = {}) {
+        if (!session_) throw std::runtime_error("no session");
+        if (device && !deviceInputs_)
+            throw std::runtime_error("device tensor needs the cuda execution provider");
+        size_t count = 1;
+        for (int64_t d : shape) count *= static_cast<size_t>(d);
+        const Ort::MemoryInfo mem =
+            device ? Ort::MemoryInfo("Cuda", OrtDeviceAllocator, 0, OrtMemTypeDefault)
+                   : Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+        Ort::Value input =
+            Ort::Value::CreateTensor<float>(mem, data, count, shape.data(), shape.size());
+        const char* inName = inputName_.c_str();
+        std::vector<const char*> outNames;
+        if (outputs.empty()) {
+            outNames.push_back(outputNames_.at(0).c_str());
+        } else {
+            for (size_t i : outputs) outNames.push_back(outputNames_.at(i).c_str());
+        }
+        return session_->Run(Ort::RunOptions{nullptr}, &inName, &input, 1, outNames.data(),
+                             outNames.size());
+    }
+
+private:
+    // Returns the provider actually appended ("cpu" after a fallback).
+    std::string appendProvider(const std::string& ep, std::string* note) {
+        if (ep == "coreml") {
+#ifdef __APPLE__
+            try {
+                Ort::ThrowOnError(OrtSessionOptionsAppendExecutionProvider_CoreML(
+                    static_cast<OrtSessionOptions*>(options_), 0));
+                return ep;
+            } catch (const std::exception& e) {
+                if (note) *note = std::string("CoreML EP unavailable, using CPU: ") + e.what();
+            }
+#else
+            if (note) *note = "CoreML EP not available on this platform, using CPU";
+#endif
+        } else if (ep == "cuda") {
+#ifdef ZMP_WITH_CUDA
+            try {
+                OrtCUDAProviderOptions cuda{};
+                options_.AppendExecutionProvider_CUDA(cuda);
+                deviceInputs_ = true;
+                return ep;
+            } catch (const std::exception& e) {
+                if (note) *note = std::string("CUDA EP unavailable, using CPU: ") + e.what();
+            }
+#else
+            if (note) *note = "CUDA EP not built in, using CPU";
+#endif
+        }
+        return "cpu";
+    }
+
+    std::unique_ptr<Ort::Env> env_;
+    Ort::SessionOptions options_;
+    std::shared_ptr<const io::MappedFile> mapping_;  // outlives session_
+    std::unique_ptr<Ort::Session> session_;
+    ModelLoadStats stats_;
+    std::string inputName_;
+    std::vector<std::string> outputNames_;
+    std::vector<int64_t> inputShape_;
+    bool deviceInputs_ = false;
+};
+
+}  // namespace zm::hw
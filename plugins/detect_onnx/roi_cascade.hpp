@@ -0,0 +1,127 @@
+#pragma once
+
+// Pure helpers for detect_onnx's CPU ROI cascade: turn motion regions into the
+// crops the detector runs on, and map crop-space boxes back to the frame.
+// Runtime-free so it is unit-testable.
+
+#include "detect_postprocess.hpp"   // Box
+#include "hw_backend.hpp"           // Region
+#include "zm_side_data.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace zm::detect {
+
+struct RoiPlanOptions {
+    float margin = 0.2f;          // grow each region by this fraction per side
+    int min_size = 320;           // minimum crop side (context for small movers)
+    int max_regions = 8;          // crops per frame; extra ones are merged
+    float full_frame_ratio = 0.5f; // crops covering this much of the frame -> one full pass
+};
+
+namespace detail {
+
+inline bool touches(const zm::hw::Region& a, const zm::hw::Region& b) {
+    return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h;
+}
+
+inline zm::hw::Region unite(const zm::hw::Region& a, const zm::hw::Region& b) {
+    const int x0 = std::min(a.x, b.x), y0 = std::min(a.y, b.y);
+    const int x1 = std::max(a.x + a.w, b.x + b.w), y1 = std::max(a.y + a.h, b.y + b.h);
+    return {x0, y0, x1 - x0, y1 - y0};
+}
+
+// Grow `r` by the margin and to the minimum side (centred), clamped to the frame.
+inline zm::hw::Region expand(zm::hw::Region r, int width, int height, const RoiPlanOptions& o) {
+    const int mx = static_cast<int>(r.w * o.margin), my = static_cast<int>(r.h * o.margin);
+    r = {r.x - mx, r.y - my, r.w + 2 * mx, r.h + 2 * my};
+    const int side_w = std::min(width, std::max(r.w, o.min_size));
+    const int side_h = std::min(height, std::max(r.h, o.min_size));
+    const int cx = r.x + r.w / 2, cy = r.y + r.h / 2;
+    const int x = std::clamp(cx - side_w / 2, 0, width - side_w);
+    const int y = std::clamp(cy - side_h / 2, 0, height - side_h);
+    return {x, y, side_w, side_h};
+}
+
+}  // namespace detail
+
+// Crops to detect on for a width x height frame moving in `motion` (source
+// pixels; a {0,0,0,0} entry means the whole frame). Overlapping crops are
+// merged, then the closest pairs until max_regions remain. Returns a single
+// {0,0,0,0} when the crops would cover most of the frame anyway, and nothing
+// when there is no motion.
+inline std::vector<zm::hw::Region> plan_roi_crops(const std::vector<zm::hw::Region>& motion,
+                                                  int width, int height,
+                                                  const RoiPlanOptions& o) {
+    std::vector<zm::hw::Region> crops;
+    if (width <= 0 || height <= 0) return crops;
+    for (const auto& m : motion) {
+        if (m.w <= 0 || m.h <= 0) return {zm::hw::Region{}};
+        const int x0 = std::clamp(m.x, 0, width), y0 = std::clamp(m.y, 0, height);
+        const int x1 = std::clamp(m.x + m.w, 0, width), y1 = std::clamp(m.y + m.h, 0, height);
+        if (x1 <= x0 || y1 <= y0) continue;
+        crops.push_back(detail::expand({x0, y0, x1 - x0, y1 - y0}, width, height, o));
+    }
+
+    // Merge touching crops until stable (a merged crop can reach a third).
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (size_t i = 0; i < crops.size() && !merged; ++i)
+            for (size_t j = i + 1; j < crops.size(); ++j)
+                if (detail::touches(crops[i], crops[j])) {
+                    crops[i] = detail::unite(crops[i], crops[j]);
+                    crops.erase(crops.begin() + j);
+                    merged = true;
+                    break;
+                }
+    }
+    const size_t cap = static_cast<size_t>(std::max(1, o.max_regions));
+    while (crops.size() > cap) {
+        size_t bi = 0, bj = 1;
+        long best = -1;
+        for (size_t i = 0; i < crops.size(); ++i)
+            for (size_t j = i + 1; j < crops.size(); ++j) {
+                const zm::hw::Region u = detail::unite(crops[i], crops[j]);
+                const long area = static_cast<long>(u.w) * u.h;
+                if (best < 0 || area < best) { best = area; bi = i; bj = j; }
+            }
+        crops[bi] = detail::unite(crops[bi], crops[bj]);
+        crops.erase(crops.begin() + bj);
+    }
+
+    long covered = 0;
+    for (const auto& c : crops) covered += static_cast<long>(c.w) * c.h;
+    if (!crops.empty() &&
+        covered >= static_cast<long>(o.full_frame_ratio * static_cast<float>(width) * height))
+        return {zm::hw::Region{}};
+    return crops;
+}
+
+// Motion boxes a motion stage attached to this frame (ZM_SIDE_MOTION_BOXES).
+// False when the frame carries none; true with an empty `out` = analyzed, nothing
+// moved.
+inline bool side_data_motion(const void* frame, size_t size, std::vector<zm::hw::Region>& out) {
+    size_t bytes = 0;
+    const void* v = zm_side_data_find(frame, size, ZM_SIDE_MOTION_BOXES, &bytes);
+    if (!v) return false;
+    out.clear();
+    const auto* p = static_cast<const uint8_t*>(v);
+    for (size_t at = 0; at + sizeof(zm_side_box_t) <= bytes; at += sizeof(zm_side_box_t)) {
+        zm_side_box_t b;
+        std::memcpy(&b, p + at, sizeof(b));  // entries are unaligned
+        if (b.w > 0 && b.h > 0) out.push_back({b.x, b.y, b.w, b.h});
+    }
+    return true;
+}
+
+// Move crop-relative boxes into frame coordinates.
+inline void offset_boxes(std::vector<Box>& boxes, const zm::hw::Region& crop) {
+    for (auto& b : boxes) {
+        b.x += static_cast<float>(crop.x);
+        b.y += static_cast<float>(crop.y);
+    }
+}
+
+}  // namespace zm::detect
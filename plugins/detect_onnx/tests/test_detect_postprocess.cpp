@@ -92,3 +92,42 @@ TEST(DecodeNmsFree, DropsDegenerateBox) {
     auto boxes = decode_nms_free(out.data(), 1, lb, 0.25f);
     EXPECT_TRUE(boxes.empty());
 }
+
+static Box mk(float x, float y, float w, float h, float conf, int cls) {
+    Box b;
+    b.x = x; b.y = y; b.w = w; b.h = h; b.confidence = conf; b.class_id = cls;
+    return b;
+}
+
+TEST(CompareDetections, MatchesSameClassByIou) {
+    DetectionAgreement agg;
+    const std::vector<Box> ref = {mk(0, 0, 100, 100, 0.9f, 0), mk(200, 200, 50, 50, 0.6f, 2)};
+    const std::vector<Box> test = {
+        mk(5, 0, 100, 100, 0.85f, 0),    // same object, slightly shifted
+        mk(200, 200, 50, 50, 0.55f, 7),  // right place, wrong class
+        mk(400, 400, 20, 20, 0.3f, 0),   // not in the reference
+    };
+    compare_detections(ref, test, 0.5f, agg);
+    EXPECT_EQ(agg.frames, 1u);
+    EXPECT_EQ(agg.matched, 1u);
+    EXPECT_DOUBLE_EQ(agg.recall(), 0.5);
+    EXPECT_NEAR(agg.precision(), 1.0 / 3.0, 1e-9);
+    EXPECT_NEAR(agg.mean_conf_delta(), 0.05, 1e-6);
+    EXPECT_NEAR(agg.mean_iou(), box_iou(ref[0], test[0]), 1e-6);
+}
+
+TEST(CompareDetections, EachTestBoxMatchesOnce) {
+    DetectionAgreement agg;
+    // Two reference boxes on top of each other, one test box: the more
+    // confident reference takes it, the other is a miss.
+    const std::vector<Box> ref = {mk(0, 0, 10, 10, 0.5f, 0), mk(0, 0, 10, 10, 0.9f, 0)};
+    const std::vector<Box> test = {mk(0, 0, 10, 10, 0.8f, 0)};
+    compare_detections(ref, test, 0.5f, agg);
+    EXPECT_EQ(agg.matched, 1u);
+    EXPECT_NEAR(agg.mean_conf_delta(), 0.1, 1e-6);
+
+    compare_detections({}, {}, 0.5f, agg);  // empty frames do not move the ratios
+    EXPECT_EQ(agg.frames, 2u);
+    EXPECT_DOUBLE_EQ(agg.recall(), 0.5);
+    EXPECT_DOUBLE_EQ(agg.precision(), 1.0);
+}
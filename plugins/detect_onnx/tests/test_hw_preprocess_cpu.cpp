@@ -0,0 +1,142 @@
+// Unit tests for the CPU HwBackend preprocess kernels (hw_preprocess_cpu.hpp).
+// These do not require ONNX Runtime.
+
+#include "../hw_preprocess_cpu.hpp"
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace zm::hw;
+
+namespace {
+
+std::vector<uint8_t> gradient(int w, int h) {
+    std::vector<uint8_t> img(static_cast<size_t>(w) * h * 3);
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x) {
+            uint8_t* p = &img[(static_cast<size_t>(y) * w + x) * 3];
+            p[0] = static_cast<uint8_t>((x * 7 + y * 3) & 0xff);
+            p[1] = static_cast<uint8_t>((x * 2 + y * 11) & 0xff);
+            p[2] = static_cast<uint8_t>((x * y) & 0xff);
+        }
+    return img;
+}
+
+float maxAbsDiff(const std::vector<float>& a, const std::vector<float>& b) {
+    float m = 0.0f;
+    for (size_t i = 0; i < a.size() && i < b.size(); ++i) m = std::max(m, std::fabs(a[i] - b[i]));
+    return m;
+}
+
+}  // namespace
+
+TEST(HwPreprocessCpu, ClampRegion) {
+    EXPECT_EQ(clamp_region({}, 100, 50).w, 100);
+    EXPECT_EQ(clamp_region({}, 100, 50).h, 50);
+    const Region r = clamp_region({-10, 40, 30, 30}, 100, 50);
+    EXPECT_EQ(r.x, 0);
+    EXPECT_EQ(r.y, 40);
+    EXPECT_EQ(r.w, 20);
+    EXPECT_EQ(r.h, 10);
+    const Region outside = clamp_region({200, 200, 10, 10}, 100, 50);
+    EXPECT_EQ(outside.w, 100);  // nothing left: whole frame
+}
+
+TEST(HwPreprocessCpu, WholeFrameLetterboxMatchesDetectPath) {
+    const int w = 96, h = 54, net = 64;
+    const auto img = gradient(w, h);
+    TensorSpec spec;
+    spec.width = spec.height = net;
+
+    const zm::detect::Letterbox ref_lb = zm::detect::compute_letterbox(w, h, net);
+    std::vector<float> ref(3 * net * net), got(3 * net * net);
+    zm::detect::letterbox_rgb_to_chw(img.data(), ref_lb, ref.data());
+    const zm::detect::Letterbox lb = letterbox_crop(img.data(), w * 3, {0, 0, w, h}, spec, got.data());
+
+    EXPECT_EQ(lb.pad_x, ref_lb.pad_x);
+    EXPECT_EQ(lb.pad_y, ref_lb.pad_y);
+    EXPECT_FLOAT_EQ(lb.scale, ref_lb.scale);
+    EXPECT_LT(maxAbsDiff(ref, got), 1e-6f);
+}
+
+TEST(HwPreprocessCpu, CropLetterboxEqualsPreCroppedImage) {
+    const int w = 80, h = 60, net = 32;
+    const auto img = gradient(w, h);
+    const Region crop{17, 9, 40, 30};
+
+    std::vector<uint8_t> sub(static_cast<size_t>(crop.w) * crop.h * 3);
+    for (int y = 0; y < crop.h; ++y)
+        std::copy_n(&img[(static_cast<size_t>(crop.y + y) * w + crop.x) * 3], crop.w * 3,
+                    &sub[static_cast<size_t>(y) * crop.w * 3]);
+
+    TensorSpec spec;
+    spec.width = spec.height = net;
+    std::vector<float> a(3 * net * net), b(3 * net * net);
+    letterbox_crop(img.data(), w * 3, crop, spec, a.data());
+    letterbox_crop(sub.data(), crop.w * 3, {0, 0, crop.w, crop.h}, spec, b.data());
+    EXPECT_LT(maxAbsDiff(a, b), 1e-6f);
+}
+
+TEST(HwPreprocessCpu, StretchGrayAndMeanScale) {
+    // Uniform colour: every output pixel is the (normalized) input value.
+    const int w = 20, h = 10;
+    std::vector<uint8_t> img(static_cast<size_t>(w) * h * 3);
+    for (size_t i = 0; i < img.size(); i += 3) {
+        img[i] = 200;
+        img[i + 1] = 100;
+        img[i + 2] = 50;
+    }
+
+    TensorSpec gray;
+    gray.width = 8;
+    gray.height = 4;
+    gray.channels = 1;
+    gray.letterbox = false;
+    std::vector<float> g(8 * 4);
+    stretch_crop(img.data(), w * 3, {2, 2, 12, 6}, gray, g.data());
+    const float luma = (0.299f * 200 + 0.587f * 100 + 0.114f * 50) / 255.0f;
+    for (float v : g) EXPECT_NEAR(v, luma, 1e-5f);
+
+    TensorSpec face;
+    face.width = face.height = 4;
+    face.letterbox = false;
+    face.mean = 127.5f;
+    face.scale = 1.0f / 128.0f;
+    std::vector<float> f(3 * 4 * 4);
+    stretch_crop(img.data(), w * 3, {0, 0, w, h}, face, f.data());
+    EXPECT_NEAR(f[0], (200 - 127.5f) / 128.0f, 1e-6f);
+    EXPECT_NEAR(f[16], (100 - 127.5f) / 128.0f, 1e-6f);
+    EXPECT_NEAR(f[32], (50 - 127.5f) / 128.0f, 1e-6f);
+}
+
+TEST(HwPreprocessCpu, BatchOfCrops) {
+    const int w = 64, h = 48;
+    const auto img = gradient(w, h);
+    TensorSpec spec;
+    spec.width = 16;
+    spec.height = 8;
+    spec.letterbox = false;
+
+    std::vector<float> out;
+    std::vector<zm::detect::Letterbox> lbs;
+    std::vector<Region> used;
+    preprocess_rgb_batch(img.data(), w, h, w * 3, {{0, 0, 10, 10}, {50, 40, 30, 30}}, spec,
+                         out, lbs, used);
+    ASSERT_EQ(used.size(), 2u);
+    EXPECT_EQ(out.size(), 2u * 3 * 16 * 8);
+    EXPECT_EQ(used[1].w, 14);  // clamped to the frame
+    EXPECT_EQ(used[1].h, 8);
+
+    // Each item equals the same crop preprocessed on its own.
+    std::vector<float> single(3 * 16 * 8);
+    stretch_crop(img.data(), w * 3, used[1], spec, single.data());
+    EXPECT_LT(maxAbsDiff(single, std::vector<float>(out.begin() + single.size(), out.end())), 1e-6f);
+
+    // No crops: one whole-frame item.
+    preprocess_rgb_batch(img.data(), w, h, w * 3, {}, spec, out, lbs, used);
+    ASSERT_EQ(used.size(), 1u);
+    EXPECT_EQ(used[0].w, w);
+    EXPECT_EQ(out.size(), 3u * 16 * 8);
+}
@@ -0,0 +1,166 @@
+// Unit tests for the ORT-free model cache helpers (model_cache.hpp).
+
+#include "../model_cache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace zm::hw;
+
+namespace {
+
+std::string writeTemp(const std::string& name, const std::vector<uint8_t>& bytes) {
+    const char* dir = std::getenv("TMPDIR");
+    const std::string path = std::string(dir && *dir ? dir : "/tmp") + "/" + name;
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (f) {
+        if (!bytes.empty()) std::fwrite(bytes.data(), 1, bytes.size(), f);
+        std::fclose(f);
+    }
+    return path;
+}
+
+} // namespace
+
+TEST(ModelCache, ContentHashTracksEveryByte) {
+    std::vector<uint8_t> a(1000);
+    for (size_t i = 0; i < a.size(); ++i) a[i] = static_cast<uint8_t>(i * 7);
+    const uint64_t h = content_hash(a.data(), a.size());
+    EXPECT_EQ(h, content_hash(a.data(), a.size()));
+
+    std::vector<uint8_t> b = a;
+    b[997] ^= 1;  // tail byte
+    EXPECT_NE(h, content_hash(b.data(), b.size()));
+    b = a;
+    b[8] ^= 1;    // word body
+    EXPECT_NE(h, content_hash(b.data(), b.size()));
+    // A trailing zero byte changes the length, so the key.
+    b = a;
+    b.push_back(0);
+    EXPECT_NE(h, content_hash(b.data(), b.size()));
+}
+
+TEST(ModelCache, FileNameCarriesKeyParts) {
+    const std::string n = cache_file_name("/models/yolo11n.onnx", 0xabcull, "cuda", "all",
+                                          "1.20.0", "avx2");
+    EXPECT_EQ(n, "yolo11n.0000000000000abc.cuda.all.avx2.ort1_20_0.ort");
+    // Path separators and dots in the variable parts cannot escape the directory.
+    EXPECT_EQ(cache_file_name("m", 1, "../x", "all", "1", "c").find('/'), std::string::npos);
+    EXPECT_EQ(cache_file_name("C:\\m\\face.v2.onnx", 1, "cpu", "all", "1", "c")
+                  .rfind("face_v2.", 0), 0u);
+    EXPECT_NE(cache_file_name("m.onnx", 1, "cpu", "all", "1", "c"),
+              cache_file_name("m.onnx", 1, "cuda", "all", "1", "c"));
+}
+
+TEST(ModelCache, CacheDirFromEnvironment) {
+    const char* saved = std::getenv("ZM_MODEL_CACHE");
+    const std::string restore = saved ? saved : "";
+    const char* savedXdg = std::getenv("XDG_CACHE_HOME");
+    const std::string restoreXdg = savedXdg ? savedXdg : "";
+    unsetenv("ZM_MODEL_CACHE");
+    unsetenv("XDG_CACHE_HOME");
+    EXPECT_EQ(model_cache_dir(), "/tmp/zm_ort_cache-" + std::to_string(::geteuid()));
+    setenv("XDG_CACHE_HOME", "/home/zm/.cache", 1);
+    EXPECT_EQ(model_cache_dir(), "/home/zm/.cache/zm");
+    setenv("XDG_CACHE_HOME", "relative", 1);  // ignored, as the spec says
+    EXPECT_EQ(model_cache_dir(), "/tmp/zm_ort_cache-" + std::to_string(::geteuid()));
+    if (savedXdg) setenv("XDG_CACHE_HOME", restoreXdg.c_str(), 1);
+    else unsetenv("XDG_CACHE_HOME");
+    setenv("ZM_MODEL_CACHE", "/var/cache/zm", 1);
+    EXPECT_EQ(model_cache_dir(), "/var/cache/zm");
+    setenv("ZM_MODEL_CACHE", "off", 1);
+    EXPECT_EQ(model_cache_dir(), "");
+    setenv("ZM_MODEL_CACHE", "0", 1);
+    EXPECT_EQ(model_cache_dir(), "");
+    if (saved) setenv("ZM_MODEL_CACHE", restore.c_str(), 1);
+    else unsetenv("ZM_MODEL_CACHE");
+}
+
+#if ZM_MAPPED_FILE_MMAP
+TEST(ModelCache, TrustsOnlyPrivateDirectories) {
+    const char* tmp = std::getenv("TMPDIR");
+    const std::string base = std::string(tmp && *tmp ? tmp : "/tmp") + "/zm_model_cache_dir_test." +
+                             std::to_string(::getpid());
+    std::string why;
+
+    // Created on demand, parents included, private to this user.
+    const std::string fresh = base + "/a/cache";
+    ASSERT_TRUE(prepare_cache_dir(fresh + "/", &why)) << why;
+    struct stat st{};
+    ASSERT_EQ(::lstat(fresh.c_str(), &st), 0);
+    EXPECT_EQ(st.st_mode & 0777, 0700u);
+    EXPECT_TRUE(prepare_cache_dir(fresh, &why));  // existing is fine too
+
+    const std::string shared = base + "/shared";
+    ASSERT_EQ(::mkdir(shared.c_str(), 0700), 0);
+    ASSERT_EQ(::chmod(shared.c_str(), 0777), 0);
+    EXPECT_FALSE(prepare_cache_dir(shared, &why));
+    EXPECT_NE(why.find("writable by group or others"), std::string::npos) << why;
+
+    const std::string link = base + "/link";
+    ASSERT_EQ(::symlink(fresh.c_str(), link.c_str()), 0);
+    EXPECT_FALSE(prepare_cache_dir(link, &why));
+    EXPECT_FALSE(prepare_cache_dir(link + "/", &why));
+
+    const std::string file = writeTemp("zm_model_cache_not_a_dir", {1});
+    EXPECT_FALSE(prepare_cache_dir(file, &why));
+
+    std::remove(file.c_str());
+    std::error_code ec;
+    std::filesystem::remove_all(base, ec);
+}
+
+TEST(ModelCache, MapsWholeFileReadOnly) {
+    std::vector<uint8_t> bytes(10000);
+    for (size_t i = 0; i < bytes.size(); ++i) bytes[i] = static_cast<uint8_t>(i ^ (i >> 8));
+    const std::string path = writeTemp("zm_model_cache_test.bin", bytes);
+    {
+        auto m = zm::io::MappedFile::open(path);
+        ASSERT_NE(m, nullptr);
+        ASSERT_EQ(m->size(), bytes.size());
+        EXPECT_EQ(std::vector<uint8_t>(m->data(), m->data() + m->size()), bytes);
+        EXPECT_EQ(content_hash(m->data(), m->size()), content_hash(bytes.data(), bytes.size()));
+    }
+    std::remove(path.c_str());
+    EXPECT_EQ(zm::io::MappedFile::open(path), nullptr);
+
+    const std::string empty = writeTemp("zm_model_cache_empty.bin", {});
+    EXPECT_EQ(zm::io::MappedFile::open(empty), nullptr);
+    std::remove(empty.c_str());
+}
+#endif
+
+#if defined(__linux__)
+TEST(ModelCache, ProbeReportsRssGrowth) {
+    LoadProbe probe;
+    std::vector<uint8_t> touched(32 << 20, 1);  // 32 MiB of private pages
+    ModelLoadStats s;
+    probe.finish(s);
+    EXPECT_GE(s.load_ms, 0.0);
+    EXPECT_GT(s.rss_delta, 16 << 20);
+    EXPECT_GT(s.private_delta, 16 << 20);
+    EXPECT_EQ(touched.back(), 1);
+}
+#endif
+
+TEST(ModelCache, SummaryNamesOutcome) {
+    ModelLoadStats s;
+    s.cache = ModelLoadStats::Cache::Hit;
+    s.load_ms = 42;
+    s.mapped_bytes = 3 << 20;
+    s.rss_delta = 1 << 20;
+    const std::string hit = s.summary();
+    EXPECT_EQ(hit.rfind("ready in 42 ms (cache hit, 3.0 MiB mapped; RSS +1.0 MiB", 0), 0u) << hit;
+
+    s = ModelLoadStats();
+    s.cache = ModelLoadStats::Cache::Failed;
+    s.note = "cannot write cache entry: disk full";
+    const std::string failed = s.summary();
+    EXPECT_NE(failed.find("cache failed"), std::string::npos);
+    EXPECT_NE(failed.find("): cannot write cache entry: disk full"), std::string::npos) << failed;
+    EXPECT_EQ(failed.find("mapped"), std::string::npos);
+}
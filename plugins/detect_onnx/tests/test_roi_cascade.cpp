@@ -0,0 +1,121 @@
+// Unit tests for the CPU ROI cascade helpers (roi_cascade.hpp) and the motion
+// event feed they consume (plugins/common/motion_feed.hpp).
+
+#include "../roi_cascade.hpp"
+#include "motion_feed.hpp"
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <vector>
+
+using zm::hw::Region;
+using namespace zm::detect;
+
+namespace {
+RoiPlanOptions opts() {
+    RoiPlanOptions o;
+    o.margin = 0.0f;
+    o.min_size = 100;
+    o.max_regions = 4;
+    o.full_frame_ratio = 0.5f;
+    return o;
+}
+}  // namespace
+
+TEST(RoiCascade, NoMotionNoCrops) {
+    EXPECT_TRUE(plan_roi_crops({}, 1920, 1080, opts()).empty());
+}
+
+TEST(RoiCascade, SmallMoverGrowsToMinSizeInsideFrame) {
+    const auto crops = plan_roi_crops({{1900, 10, 10, 10}}, 1920, 1080, opts());
+    ASSERT_EQ(crops.size(), 1u);
+    EXPECT_EQ(crops[0].w, 100);
+    EXPECT_EQ(crops[0].h, 100);
+    EXPECT_EQ(crops[0].x, 1820);  // shifted back inside the frame
+    EXPECT_EQ(crops[0].y, 0);
+}
+
+TEST(RoiCascade, OverlappingCropsMergeAndCap) {
+    // Two movers whose crops overlap become one; two far apart stay separate.
+    auto crops = plan_roi_crops({{100, 100, 60, 60}, {170, 100, 60, 60}, {1500, 800, 100, 100}},
+                                1920, 1080, opts());
+    ASSERT_EQ(crops.size(), 2u);
+    EXPECT_EQ(crops[0].x, 80);
+    EXPECT_EQ(crops[0].w, 170);
+
+    RoiPlanOptions one = opts();
+    one.max_regions = 1;
+    one.full_frame_ratio = 1.0f;  // the union is 60% of the frame
+    crops = plan_roi_crops({{100, 100, 60, 60}, {1500, 800, 100, 100}}, 1920, 1080, one);
+    ASSERT_EQ(crops.size(), 1u);
+    EXPECT_EQ(crops[0].x, 80);
+    EXPECT_EQ(crops[0].x + crops[0].w, 1600);
+}
+
+TEST(RoiCascade, LargeCoverageBecomesFullFrame) {
+    auto crops = plan_roi_crops({{0, 0, 1500, 800}}, 1920, 1080, opts());
+    ASSERT_EQ(crops.size(), 1u);
+    EXPECT_EQ(crops[0].w, 0);
+    crops = plan_roi_crops({{}}, 1920, 1080, opts());  // "somewhere" = whole frame
+    ASSERT_EQ(crops.size(), 1u);
+    EXPECT_EQ(crops[0].w, 0);
+}
+
+TEST(RoiCascade, OffsetBoxes) {
+    std::vector<Box> boxes(1);
+    boxes[0].x = 5;
+    boxes[0].y = 6;
+    offset_boxes(boxes, {100, 200, 50, 50});
+    EXPECT_FLOAT_EQ(boxes[0].x, 105.f);
+    EXPECT_FLOAT_EQ(boxes[0].y, 206.f);
+}
+
+TEST(RoiCascade, SideDataMotion) {
+    // Hand-built frame: 5-byte payload (entries land unaligned), one box entry.
+    const zm_side_box_t boxes[2] = {{10, 20, 30, 40}, {0, 0, 0, 0}};
+    std::vector<uint8_t> f(sizeof(zm_frame_hdr_t) + 5);
+    auto* hdr = reinterpret_cast<zm_frame_hdr_t*>(f.data());
+    hdr->flags = ZM_FRAME_FLAG_SIDE_DATA;
+    std::vector<Region> r;
+    EXPECT_FALSE(side_data_motion(f.data(), f.size(), r));  // flag but no block
+
+    // Grow the frame once and write the entry and trailer in place (appending
+    // the trailer's bytes trips a GCC 12 -Wstringop-overflow false positive).
+    const size_t at = f.size();
+    const size_t entry = sizeof(zm_side_data_entry_t) + sizeof(boxes);
+    const zm_side_data_trailer_t t{static_cast<uint32_t>(entry + sizeof(t)), ZM_SIDE_DATA_MAGIC};
+    f.resize(at + entry + sizeof(t));
+    ASSERT_EQ(zm_side_data_put(f.data() + at, entry, ZM_SIDE_MOTION_BOXES, boxes, sizeof(boxes)),
+              entry);
+    std::memcpy(f.data() + at + entry, &t, sizeof(t));
+
+    ASSERT_TRUE(side_data_motion(f.data(), f.size(), r));
+    ASSERT_EQ(r.size(), 1u);  // the empty box is dropped
+    EXPECT_EQ(r[0].x, 10);
+    EXPECT_EQ(r[0].h, 40);
+}
+
+TEST(MotionFeed, AppliesMotionEvents) {
+    zm::motion::MotionFeed feed;
+    std::vector<zm::motion::MotionRegion> r;
+    EXPECT_FALSE(feed.index.seen(3));
+
+    zm::motion::apply_motion_event(feed, R"({"type":"zone_motion","stream_id":3,"pts_usec":1})");
+    zm::motion::apply_motion_event(feed, R"({"type":"motion","algorithm":"pixel_diff"})");
+    EXPECT_FALSE(feed.index.seen(3));
+
+    zm::motion::apply_motion_event(
+        feed, R"({"type":"motion","stream_id":3,"pts_usec":1000000,"regions":[[10,20,30,40]]})");
+    EXPECT_TRUE(feed.index.seen(3));
+    ASSERT_TRUE(feed.index.latest(3, 1200000, 500000, r));
+    ASSERT_EQ(r.size(), 1u);
+    EXPECT_EQ(r[0].x, 10);
+    EXPECT_EQ(r[0].h, 40);
+    EXPECT_FALSE(feed.index.latest(3, 1600000, 500000, r));  // stale: nothing moved
+
+    // No regions: motion somewhere in the frame.
+    zm::motion::apply_motion_event(feed, R"({"type":"motion","stream_id":3,"pts_usec":2000000})");
+    ASSERT_TRUE(feed.index.latest(3, 2000000, 500000, r));
+    ASSERT_EQ(r.size(), 1u);
+    EXPECT_EQ(r[0].w, 0);
+}
@@ -30,19 +30,16 @@
 // Behaviour mirrors detect_onnx: it runs the model on decoded RGB24 frames,
 // publishes detections as structured "detection" events (tagged
 // "source":"openvocab"), and is ALWAYS a pass-through DETECT stage — the frame
-// is forwarded downstream regardless of whether inference ran.
+// is forwarded downstream regardless of whether inference ran. Frames reach
+// the model through zm::hw::InferPipeline (RGB24 via the CPU backend; device
+// surfaces in place when "hw" names a device backend).
 
 #include "../detect_onnx/detect_postprocess.hpp"  // shared pure pre/post-process
-
-#include <onnxruntime_cxx_api.h>
-#ifdef __APPLE__
-#include <coreml_provider_factory.h>
-#endif
+#include "../detect_onnx/infer_pipeline.hpp"      // shared frame acquire/preprocess
+#include "../detect_onnx/ort_model.hpp"           // shared ORT session setup
 
 #include <nlohmann/json.hpp>
 
-#include <array>
-#include <memory>
 #include <string>
 #include <vector>
 #include <cstdint>
@@ -58,12 +55,9 @@ struct DetectOpenVocabCtx {
     zm_host_api_t* host = nullptr;
     void* hostCtx = nullptr;
 
-    // ONNX Runtime state.
-    std::unique_ptr<Ort::Env> env;
-    Ort::SessionOptions sessionOptions;
-    std::unique_ptr<Ort::Session> session;
-    std::string inputName;
-    std::string outputName;
+    // Frame acquire/preprocess and the ONNX Runtime session.
+    zm::hw::InferPipeline pipeline;
+    zm::hw::OrtModel model;
 
     // Config.
     std::string modelPath;
@@ -72,6 +66,7 @@ struct DetectOpenVocabCtx {
     int frameWidth = 0;
     int frameHeight = 0;
     std::string ep = "cpu";
+    std::string hw = "cpu";                 // HwBackend for device surfaces
     std::vector<int> streamFilter;          // empty = all
     std::vector<std::string> prompts;       // class_id -> prompt string
 
@@ -114,6 +109,7 @@ static int detect_openvocab_start(zm_plugin_t* plugin, zm_host_api_t* host, void
             ctx->frameWidth = j.value("frame_width", 0);
             ctx->frameHeight = j.value("frame_height", 0);
             ctx->ep = j.value("ep", std::string("cpu"));
+            ctx->hw = j.value("hw", std::string("cpu"));
             if (j.contains("stream_filter") && j["stream_filter"].is_array())
                 ctx->streamFilter = j["stream_filter"].get<std::vector<int>>();
             if (j.contains("prompts") && j["prompts"].is_array())
@@ -123,56 +119,31 @@ static int detect_openvocab_start(zm_plugin_t* plugin, zm_host_api_t* host, void
         }
     }
 
-    // Create the ONNX Runtime environment and session options.
-    try {
-        ctx->env = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "detect_openvocab");
-        ctx->sessionOptions.SetIntraOpNumThreads(1);
-        ctx->sessionOptions.SetGraphOptimizationLevel(ORT_ENABLE_ALL);
-    } catch (const std::exception& e) {
-        ZM_LOG_ERROR("detect_openvocab: failed to init ORT env: %s", e.what());
-    }
-
-    // Optionally append the CoreML execution provider, falling back to CPU.
-    if (ctx->ep == "coreml") {
-#ifdef __APPLE__
-        try {
-            uint32_t coreml_flags = 0;
-            Ort::ThrowOnError(OrtSessionOptionsAppendExecutionProvider_CoreML(
-                static_cast<OrtSessionOptions*>(ctx->sessionOptions), coreml_flags));
-            ZM_LOG_INFO("detect_openvocab: CoreML execution provider enabled");
-        } catch (const std::exception& e) {
-            ZM_LOG_WARN("detect_openvocab: CoreML EP unavailable, falling back to CPU: %s",
-                        e.what());
-        }
-#else
-        ZM_LOG_WARN("detect_openvocab: CoreML EP not available on this platform, falling back to CPU");
-#endif
-    }
+    const std::string backend = ctx->pipeline.open(ctx->hw);
+    if (ctx->hw != "cpu" && backend == "cpu")
+        ZM_LOG_WARN("detect_openvocab: hw backend '%s' unavailable; RGB24 frames only",
+                    ctx->hw.c_str());
 
     // Construct the session if a model path was given.
-    if (!ctx->modelPath.empty() && ctx->env) {
-        try {
-            ctx->session = std::make_unique<Ort::Session>(
-                *ctx->env, ctx->modelPath.c_str(), ctx->sessionOptions);
-
-            Ort::AllocatorWithDefaultOptions allocator;
-            auto inName = ctx->session->GetInputNameAllocated(0, allocator);
-            auto outName = ctx->session->GetOutputNameAllocated(0, allocator);
-            ctx->inputName = inName.get();
-            ctx->outputName = outName.get();
-
+    if (!ctx->modelPath.empty()) {
+        std::string err, note;
+        if (ctx->model.load(ctx->modelPath, ctx->ep, "detect_openvocab", &err, &note)) {
+            if (!note.empty()) ZM_LOG_WARN("detect_openvocab: %s", note.c_str());
+            if (ctx->pipeline.has_device() && !ctx->model.device_inputs())
+                ZM_LOG_WARN("detect_openvocab: hw '%s' needs ep \"cuda\"; device frames will be "
+                            "skipped", backend.c_str());
             ZM_LOG_INFO("detect_openvocab: loaded model '%s' (input='%s' output='%s' "
-                        "net=%d ep=%s prompts=%zu)",
-                        ctx->modelPath.c_str(), ctx->inputName.c_str(),
-                        ctx->outputName.c_str(), ctx->net, ctx->ep.c_str(),
-                        ctx->prompts.size());
+                        "net=%d ep=%s hw=%s prompts=%zu) %s",
+                        ctx->modelPath.c_str(), ctx->model.input_name().c_str(),
+                        ctx->model.output_names()[0].c_str(), ctx->net, ctx->ep.c_str(),
+                        backend.c_str(), ctx->prompts.size(),
+                        ctx->model.load_stats().summary().c_str());
             if (ctx->prompts.empty())
                 ZM_LOG_WARN("detect_openvocab: no prompts configured; detections will be "
                             "labelled 'class_<id>'");
-        } catch (const std::exception& e) {
+        } else {
             ZM_LOG_ERROR("detect_openvocab: failed to load model '%s': %s (running as pass-through)",
-                         ctx->modelPath.c_str(), e.what());
-            ctx->session.reset();
+                         ctx->modelPath.c_str(), err.c_str());
         }
     } else {
         ZM_LOG_WARN("detect_openvocab: no model_path configured; running as pass-through");
@@ -214,54 +185,16 @@ static void publishBoxes(DetectOpenVocabCtx* ctx, const zm_frame_hdr_t* hdr,
         ctx->host->publish_evt(ctx->hostCtx, evt.dump().c_str());
 }
 
-static void detect_openvocab_on_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
-    auto* ctx = static_cast<DetectOpenVocabCtx*>(plugin->instance);
-    if (!ctx || !buf || size < sizeof(zm_frame_hdr_t)) {
-        forwardFrame(ctx, buf, size);
-        return;
-    }
-
-    const zm_frame_hdr_t* hdr = static_cast<const zm_frame_hdr_t*>(buf);
-    const uint8_t* payload = static_cast<const uint8_t*>(buf) + sizeof(zm_frame_hdr_t);
-
-    // Bail out (pass-through) when we cannot or should not run inference.
-    if (!ctx->session || hdr->hw_type != ZM_FRAME_RGB24) {
-        forwardFrame(ctx, buf, size);
-        return;
-    }
-    if (!ctx->streamFilter.empty() &&
-        std::find(ctx->streamFilter.begin(), ctx->streamFilter.end(),
-                  static_cast<int>(hdr->stream_id)) == ctx->streamFilter.end()) {
-        forwardFrame(ctx, buf, size);
-        return;
-    }
-
-    const int w = ctx->frameWidth;
-    const int h = ctx->frameHeight;
-    if (w <= 0 || h <= 0 ||
-        size < sizeof(zm_frame_hdr_t) + static_cast<size_t>(w) * h * 3) {
-        forwardFrame(ctx, buf, size);
-        return;
-    }
-
+// Letterbox the surface, run the model and publish the decoded boxes.
+static void inferOpenVocab(DetectOpenVocabCtx* ctx, const zm_frame_hdr_t* hdr,
+                           const zm::hw::Surface& surface) {
     try {
-        const int net = ctx->net;
-        zm::detect::Letterbox lb = zm::detect::compute_letterbox(w, h, net);
-
-        std::vector<float> input(static_cast<size_t>(3) * net * net);
-        zm::detect::letterbox_rgb_to_chw(payload, lb, input.data());
-
-        Ort::MemoryInfo memInfo =
-            Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
-        std::array<int64_t, 4> inputShape{1, 3, net, net};
-        Ort::Value inputTensor = Ort::Value::CreateTensor<float>(
-            memInfo, input.data(), input.size(), inputShape.data(), inputShape.size());
-
-        const char* inputNames[] = {ctx->inputName.c_str()};
-        const char* outputNames[] = {ctx->outputName.c_str()};
-
-        auto outputs = ctx->session->Run(Ort::RunOptions{nullptr}, inputNames,
-                                         &inputTensor, 1, outputNames, 1);
+        zm::hw::TensorSpec spec;
+        spec.width = spec.height = ctx->net;
+        const zm::hw::BatchTensor input = ctx->pipeline.preprocess(surface, {}, spec);
+        if (!input.valid() || (input.device && !ctx->model.device_inputs())) return;
+        const zm::detect::Letterbox& lb = input.lb[0];
+        auto outputs = ctx->model.run(input);
 
         const float* out = outputs[0].GetTensorData<float>();
         auto shape = outputs[0].GetTensorTypeAndShapeInfo().GetShape();
@@ -274,7 +207,6 @@ static void detect_openvocab_on_frame(zm_plugin_t* plugin, const void* buf, size
                             "[1,N,6] supported");
                 ctx->warnedUnsupportedShape = true;
             }
-            forwardFrame(ctx, buf, size);
             return;
         }
 
@@ -289,7 +221,36 @@ static void detect_openvocab_on_frame(zm_plugin_t* plugin, const void* buf, size
     } catch (const std::exception& e) {
         ZM_LOG_ERROR("detect_openvocab: inference error: %s", e.what());
     }
+}
+
+static void detect_openvocab_on_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
+    auto* ctx = static_cast<DetectOpenVocabCtx*>(plugin->instance);
+    if (!ctx || !buf || size < sizeof(zm_frame_hdr_t)) {
+        forwardFrame(ctx, buf, size);
+        return;
+    }
+
+    const zm_frame_hdr_t* hdr = static_cast<const zm_frame_hdr_t*>(buf);
 
+    // Bail out (pass-through) when we cannot or should not run inference.
+    if (!ctx->model.loaded()) {
+        forwardFrame(ctx, buf, size);
+        return;
+    }
+    if (!ctx->streamFilter.empty() &&
+        std::find(ctx->streamFilter.begin(), ctx->streamFilter.end(),
+                  static_cast<int>(hdr->stream_id)) == ctx->streamFilter.end()) {
+        forwardFrame(ctx, buf, size);
+        return;
+    }
+
+    zm::hw::Surface surface;
+    if (!ctx->pipeline.acquire(buf, size, ctx->frameWidth, ctx->frameHeight, surface)) {
+        forwardFrame(ctx, buf, size);
+        return;
+    }
+    inferOpenVocab(ctx, hdr, surface);
+    ctx->pipeline.release(surface);
     forwardFrame(ctx, buf, size);
 }
 
@@ -11,13 +11,14 @@
 // (candidate-major). Each candidate = [cx,cy,w,h,conf, 17*(x,y,vis)]. There is
 // one class (person), conf is the person score, and the output is NOT
 // pre-deduplicated, so we must confidence-filter then run IoU NMS.
+//
+// Frames reach the model through zm::hw::InferPipeline: RGB24 frames are
+// letterboxed by the CPU backend; with "hw" set to a device backend (e.g.
+// "cuda" + ep "cuda") decoded device surfaces are letterboxed and run in place.
 
 #include "pose_postprocess.hpp"
-
-#include <onnxruntime_cxx_api.h>
-#ifdef __APPLE__
-#include <coreml_provider_factory.h>
-#endif
+#include "infer_pipeline.hpp"
+#include "ort_model.hpp"
 
 #include <nlohmann/json.hpp>
 
@@ -46,12 +47,9 @@ struct DetectPoseCtx {
     zm_host_api_t* host = nullptr;
     void* hostCtx = nullptr;
 
-    // ONNX Runtime state.
-    std::unique_ptr<Ort::Env> env;
-    Ort::SessionOptions sessionOptions;
-    std::unique_ptr<Ort::Session> session;
-    std::string inputName;
-    std::string outputName;
+    // Frame acquire/preprocess and the ONNX Runtime session.
+    zm::hw::InferPipeline pipeline;
+    zm::hw::OrtModel model;
 
     // Config.
     std::string modelPath;
@@ -61,6 +59,7 @@ struct DetectPoseCtx {
     int frameWidth = 0;
     int frameHeight = 0;
     std::string ep = "cpu";
+    std::string hw = "cpu";                    // HwBackend for device surfaces
     std::vector<int> streamFilter;             // empty = all
     std::vector<std::string> keypointNames;    // empty = use COCO-17
 
@@ -105,6 +104,7 @@ static int detect_pose_start(zm_plugin_t* plugin, zm_host_api_t* host, void* hos
             ctx->frameWidth = j.value("frame_width", 0);
             ctx->frameHeight = j.value("frame_height", 0);
             ctx->ep = j.value("ep", std::string("cpu"));
+            ctx->hw = j.value("hw", std::string("cpu"));
             if (j.contains("stream_filter") && j["stream_filter"].is_array())
                 ctx->streamFilter = j["stream_filter"].get<std::vector<int>>();
             if (j.contains("keypoint_names") && j["keypoint_names"].is_array())
@@ -114,51 +114,25 @@ static int detect_pose_start(zm_plugin_t* plugin, zm_host_api_t* host, void* hos
         }
     }
 
-    // Create the ONNX Runtime environment and session options.
-    try {
-        ctx->env = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "detect_pose");
-        ctx->sessionOptions.SetIntraOpNumThreads(1);
-        ctx->sessionOptions.SetGraphOptimizationLevel(ORT_ENABLE_ALL);
-    } catch (const std::exception& e) {
-        ZM_LOG_ERROR("detect_pose: failed to init ORT env: %s", e.what());
-    }
-
-    // Optionally append the CoreML execution provider, falling back to CPU.
-    if (ctx->ep == "coreml") {
-#ifdef __APPLE__
-        try {
-            uint32_t coreml_flags = 0;
-            Ort::ThrowOnError(OrtSessionOptionsAppendExecutionProvider_CoreML(
-                static_cast<OrtSessionOptions*>(ctx->sessionOptions), coreml_flags));
-            ZM_LOG_INFO("detect_pose: CoreML execution provider enabled");
-        } catch (const std::exception& e) {
-            ZM_LOG_WARN("detect_pose: CoreML EP unavailable, falling back to CPU: %s",
-                        e.what());
-        }
-#else
-        ZM_LOG_WARN("detect_pose: CoreML EP not available on this platform, falling back to CPU");
-#endif
-    }
+    const std::string backend = ctx->pipeline.open(ctx->hw);
+    if (ctx->hw != "cpu" && backend == "cpu")
+        ZM_LOG_WARN("detect_pose: hw backend '%s' unavailable; RGB24 frames only", ctx->hw.c_str());
 
     // Construct the session if a model path was given.
-    if (!ctx->modelPath.empty() && ctx->env) {
-        try {
-            ctx->session = std::make_unique<Ort::Session>(
-                *ctx->env, ctx->modelPath.c_str(), ctx->sessionOptions);
-
-            Ort::AllocatorWithDefaultOptions allocator;
-            auto inName = ctx->session->GetInputNameAllocated(0, allocator);
-            auto outName = ctx->session->GetOutputNameAllocated(0, allocator);
-            ctx->inputName = inName.get();
-            ctx->outputName = outName.get();
-
-            ZM_LOG_INFO("detect_pose: loaded model '%s' (input='%s' output='%s' net=%d ep=%s)",
-                        ctx->modelPath.c_str(), ctx->inputName.c_str(),
-                        ctx->outputName.c_str(), ctx->net, ctx->ep.c_str());
-        } catch (const std::exception& e) {
+    if (!ctx->modelPath.empty()) {
+        std::string err, note;
+        if (ctx->model.load(ctx->modelPath, ctx->ep, "detect_pose", &err, &note)) {
+            if (!note.empty()) ZM_LOG_WARN("detect_pose: %s", note.c_str());
+            if (ctx->pipeline.has_device() && !ctx->model.device_inputs())
+                ZM_LOG_WARN("detect_pose: hw '%s' needs ep \"cuda\"; device frames will be skipped",
+                            backend.c_str());
+            ZM_LOG_INFO("detect_pose: loaded model '%s' (input='%s' output='%s' net=%d ep=%s hw=%s) %s",
+                        ctx->modelPath.c_str(), ctx->model.input_name().c_str(),
+                        ctx->model.output_names()[0].c_str(), ctx->net, ctx->ep.c_str(),
+                        backend.c_str(), ctx->model.load_stats().summary().c_str());
+        } else {
             ZM_LOG_ERROR("detect_pose: failed to load model '%s': %s (running as pass-through)",
-                         ctx->modelPath.c_str(), e.what());
-            ctx->session.reset();
+                         ctx->modelPath.c_str(), err.c_str());
         }
     } else {
         ZM_LOG_WARN("detect_pose: no model_path configured; running as pass-through");
@@ -206,54 +180,16 @@ static void publishPersons(DetectPoseCtx* ctx, const zm_frame_hdr_t* hdr,
         ctx->host->publish_evt(ctx->hostCtx, evt.dump().c_str());
 }
 
-static void detect_pose_on_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
-    auto* ctx = static_cast<DetectPoseCtx*>(plugin->instance);
-    if (!ctx || !buf || size < sizeof(zm_frame_hdr_t)) {
-        forwardFrame(ctx, buf, size);
-        return;
-    }
-
-    const zm_frame_hdr_t* hdr = static_cast<const zm_frame_hdr_t*>(buf);
-    const uint8_t* payload = static_cast<const uint8_t*>(buf) + sizeof(zm_frame_hdr_t);
-
-    // Bail out (pass-through) when we cannot or should not run inference.
-    if (!ctx->session || hdr->hw_type != ZM_FRAME_RGB24) {
-        forwardFrame(ctx, buf, size);
-        return;
-    }
-    if (!ctx->streamFilter.empty() &&
-        std::find(ctx->streamFilter.begin(), ctx->streamFilter.end(),
-                  static_cast<int>(hdr->stream_id)) == ctx->streamFilter.end()) {
-        forwardFrame(ctx, buf, size);
-        return;
-    }
-
-    const int w = ctx->frameWidth;
-    const int h = ctx->frameHeight;
-    if (w <= 0 || h <= 0 ||
-        size < sizeof(zm_frame_hdr_t) + static_cast<size_t>(w) * h * 3) {
-        forwardFrame(ctx, buf, size);
-        return;
-    }
-
+// Letterbox the surface, run the model and publish the decoded persons.
+static void inferPose(DetectPoseCtx* ctx, const zm_frame_hdr_t* hdr,
+                      const zm::hw::Surface& surface) {
     try {
-        const int net = ctx->net;
-        zm::detect::Letterbox lb = zm::detect::compute_letterbox(w, h, net);
-
-        std::vector<float> input(static_cast<size_t>(3) * net * net);
-        zm::detect::letterbox_rgb_to_chw(payload, lb, input.data());
-
-        Ort::MemoryInfo memInfo =
-            Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
-        std::array<int64_t, 4> inputShape{1, 3, net, net};
-        Ort::Value inputTensor = Ort::Value::CreateTensor<float>(
-            memInfo, input.data(), input.size(), inputShape.data(), inputShape.size());
-
-        const char* inputNames[] = {ctx->inputName.c_str()};
-        const char* outputNames[] = {ctx->outputName.c_str()};
-
-        auto outputs = ctx->session->Run(Ort::RunOptions{nullptr}, inputNames,
-                                         &inputTensor, 1, outputNames, 1);
+        zm::hw::TensorSpec spec;
+        spec.width = spec.height = ctx->net;
+        const zm::hw::BatchTensor input = ctx->pipeline.preprocess(surface, {}, spec);
+        if (!input.valid() || (input.device && !ctx->model.device_inputs())) return;
+        const zm::detect::Letterbox& lb = input.lb[0];
+        auto outputs = ctx->model.run(input);
 
         const float* out = outputs[0].GetTensorData<float>();
         auto shape = outputs[0].GetTensorTypeAndShapeInfo().GetShape();
@@ -266,7 +202,6 @@ static void detect_pose_on_frame(zm_plugin_t* plugin, const void* buf, size_t si
                             shape.size());
                 ctx->warnedUnsupportedShape = true;
             }
-            forwardFrame(ctx, buf, size);
             return;
         }
 
@@ -295,7 +230,6 @@ static void detect_pose_on_frame(zm_plugin_t* plugin, const void* buf, size_t si
                             "(expected 5 + 3*num_kpts, e.g. 56)", values);
                 ctx->warnedUnsupportedShape = true;
             }
-            forwardFrame(ctx, buf, size);
             return;
         }
 
@@ -308,6 +242,37 @@ static void detect_pose_on_frame(zm_plugin_t* plugin, const void* buf, size_t si
         ZM_LOG_ERROR("detect_pose: inference error: %s", e.what());
     }
 
+}
+
+static void detect_pose_on_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
+    auto* ctx = static_cast<DetectPoseCtx*>(plugin->instance);
+    if (!ctx || !buf || size < sizeof(zm_frame_hdr_t)) {
+        forwardFrame(ctx, buf, size);
+        return;
+    }
+
+    const zm_frame_hdr_t* hdr = static_cast<const zm_frame_hdr_t*>(buf);
+
+    // Bail out (pass-through) when we cannot or should not run inference.
+    if (!ctx->model.loaded()) {
+        forwardFrame(ctx, buf, size);
+        return;
+    }
+    if (!ctx->streamFilter.empty() &&
+        std::find(ctx->streamFilter.begin(), ctx->streamFilter.end(),
+                  static_cast<int>(hdr->stream_id)) == ctx->streamFilter.end()) {
+        forwardFrame(ctx, buf, size);
+        return;
+    }
+
+    zm::hw::Surface surface;
+    if (!ctx->pipeline.acquire(buf, size, ctx->frameWidth, ctx->frameHeight, surface)) {
+        forwardFrame(ctx, buf, size);
+        return;
+    }
+
+    inferPose(ctx, hdr, surface);
+    ctx->pipeline.release(surface);
     forwardFrame(ctx, buf, size);
 }
 
@@ -12,14 +12,14 @@
 //   proto     (rank 4): [1, nm, mh, mw]      prototype masks
 // For each kept detection: class = argmax of nc class scores, conf = that max,
 // box from (cx,cy,w,h); mask = sigmoid(sum_k coeff_k * proto_k), thresholded.
+//
+// Frames reach the model through zm::hw::InferPipeline (RGB24 via the CPU
+// backend; device surfaces in place when "hw" names a device backend).
 
 #include "seg_postprocess.hpp"
 #include "base64.hpp"
-
-#include <onnxruntime_cxx_api.h>
-#ifdef __APPLE__
-#include <coreml_provider_factory.h>
-#endif
+#include "infer_pipeline.hpp"
+#include "ort_model.hpp"
 
 #include <nlohmann/json.hpp>
 
@@ -57,13 +57,11 @@ struct DetectSegCtx {
     zm_host_api_t* host = nullptr;
     void* hostCtx = nullptr;
 
-    // ONNX Runtime state.
-    std::unique_ptr<Ort::Env> env;
-    Ort::SessionOptions sessionOptions;
-    std::unique_ptr<Ort::Session> session;
-    std::string inputName;
-    std::string detName;    // output0 (rank 3) detection
-    std::string protoName;  // output1 (rank 4) proto masks
+    // Frame acquire/preprocess and the ONNX Runtime session.
+    zm::hw::InferPipeline pipeline;
+    zm::hw::OrtModel model;
+    size_t detOutput = 0;    // output index of the (rank 3) detection
+    size_t protoOutput = 1;  // output index of the (rank 4) proto masks
 
     // Config.
     std::string modelPath;
@@ -75,6 +73,7 @@ struct DetectSegCtx {
     int frameWidth = 0;
     int frameHeight = 0;
     std::string ep = "cpu";
+    std::string hw = "cpu";              // HwBackend for device surfaces
     std::string maskFormat = "polygon";  // "polygon" | "none"
     // Event shape: "segmentation" (default; key "objects") or "detection" (key
     // "detections", type "detection") so the tracker consumes it and the polygon
@@ -88,6 +87,9 @@ struct DetectSegCtx {
     std::vector<int> streamFilter;       // empty = all
     std::vector<std::string> classNames; // empty = use COCO-80
 
+    // Per-frame soft masks (box footprints only); buffers reused across frames.
+    zm::seg::MaskBatch masks;
+
     bool warnedShape = false;
 };
 
@@ -132,6 +134,7 @@ static int detect_seg_start(zm_plugin_t* plugin, zm_host_api_t* host, void* host
             ctx->frameWidth = j.value("frame_width", 0);
             ctx->frameHeight = j.value("frame_height", 0);
             ctx->ep = j.value("ep", std::string("cpu"));
+            ctx->hw = j.value("hw", std::string("cpu"));
             ctx->maskFormat = j.value("mask_format", std::string("polygon"));
             ctx->eventType = j.value("event_type", std::string("segmentation"));
             ctx->emitSoftMask = j.value("emit_soft_mask", false);
@@ -147,73 +150,40 @@ static int detect_seg_start(zm_plugin_t* plugin, zm_host_api_t* host, void* host
         }
     }
 
-    // Create the ONNX Runtime environment and session options.
-    try {
-        ctx->env = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "detect_seg");
-        ctx->sessionOptions.SetIntraOpNumThreads(1);
-        ctx->sessionOptions.SetGraphOptimizationLevel(ORT_ENABLE_ALL);
-    } catch (const std::exception& e) {
-        ZM_LOG_ERROR("detect_seg: failed to init ORT env: %s", e.what());
-    }
-
-    // Optionally append the CoreML execution provider, falling back to CPU.
-    if (ctx->ep == "coreml") {
-#ifdef __APPLE__
-        try {
-            uint32_t coreml_flags = 0;
-            Ort::ThrowOnError(OrtSessionOptionsAppendExecutionProvider_CoreML(
-                static_cast<OrtSessionOptions*>(ctx->sessionOptions), coreml_flags));
-            ZM_LOG_INFO("detect_seg: CoreML execution provider enabled");
-        } catch (const std::exception& e) {
-            ZM_LOG_WARN("detect_seg: CoreML EP unavailable, falling back to CPU: %s",
-                        e.what());
-        }
-#else
-        ZM_LOG_WARN("detect_seg: CoreML EP not available on this platform, falling back to CPU");
-#endif
-    }
+    const std::string backend = ctx->pipeline.open(ctx->hw);
+    if (ctx->hw != "cpu" && backend == "cpu")
+        ZM_LOG_WARN("detect_seg: hw backend '%s' unavailable; RGB24 frames only", ctx->hw.c_str());
 
     // Construct the session if a model path was given.
-    if (!ctx->modelPath.empty() && ctx->env) {
-        try {
-            ctx->session = std::make_unique<Ort::Session>(
-                *ctx->env, ctx->modelPath.c_str(), ctx->sessionOptions);
-
-            Ort::AllocatorWithDefaultOptions allocator;
-            auto inName = ctx->session->GetInputNameAllocated(0, allocator);
-            ctx->inputName = inName.get();
-
+    if (!ctx->modelPath.empty()) {
+        std::string err, note;
+        if (!ctx->model.load(ctx->modelPath, ctx->ep, "detect_seg", &err, &note)) {
+            ZM_LOG_ERROR("detect_seg: failed to load model '%s': %s (running as pass-through)",
+                         ctx->modelPath.c_str(), err.c_str());
+        } else if (ctx->model.output_names().size() < 2) {
+            ZM_LOG_ERROR("detect_seg: model has %zu output(s); YOLO-seg needs 2 "
+                         "(running as pass-through)", ctx->model.output_names().size());
+            ctx->model = zm::hw::OrtModel();
+        } else {
+            if (!note.empty()) ZM_LOG_WARN("detect_seg: %s", note.c_str());
+            if (ctx->pipeline.has_device() && !ctx->model.device_inputs())
+                ZM_LOG_WARN("detect_seg: hw '%s' needs ep \"cuda\"; device frames will be skipped",
+                            backend.c_str());
             // YOLO-seg has two outputs; identify which is proto (rank 4) vs
             // detection (rank 3) by inspecting their shapes.
-            const size_t outCount = ctx->session->GetOutputCount();
-            if (outCount < 2) {
-                ZM_LOG_ERROR("detect_seg: model has %zu output(s); YOLO-seg needs 2 "
-                             "(running as pass-through)", outCount);
-                ctx->session.reset();
-            } else {
-                auto n0 = ctx->session->GetOutputNameAllocated(0, allocator);
-                auto n1 = ctx->session->GetOutputNameAllocated(1, allocator);
-                std::string name0 = n0.get();
-                std::string name1 = n1.get();
-                auto rank0 = ctx->session->GetOutputTypeInfo(0)
-                                 .GetTensorTypeAndShapeInfo().GetShape().size();
-                auto rank1 = ctx->session->GetOutputTypeInfo(1)
-                                 .GetTensorTypeAndShapeInfo().GetShape().size();
-                if (rank0 == 4) { ctx->protoName = name0; ctx->detName = name1; }
-                else if (rank1 == 4) { ctx->protoName = name1; ctx->detName = name0; }
-                else {
-                    // Fall back to ordering: out0 detection, out1 proto.
-                    ctx->detName = name0; ctx->protoName = name1;
-                }
-                ZM_LOG_INFO("detect_seg: loaded model '%s' (input='%s' det='%s' proto='%s' "
-                            "net=%d ep=%s)", ctx->modelPath.c_str(), ctx->inputName.c_str(),
-                            ctx->detName.c_str(), ctx->protoName.c_str(), ctx->net,
-                            ctx->ep.c_str());
-            }
-        } catch (const std::exception& e) {
-            ZM_LOG_ERROR("detect_seg: failed to load model '%s': %s (running as pass-through)",
-                         ctx->modelPath.c_str(), e.what());
-            ctx->session.reset();
+            auto& session = ctx->model.session();
+            auto rank0 = session.GetOutputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape().size();
+            auto rank1 = session.GetOutputTypeInfo(1).GetTensorTypeAndShapeInfo().GetShape().size();
+            if (rank0 == 4) { ctx->protoOutput = 0; ctx->detOutput = 1; }
+            else if (rank1 == 4) { ctx->protoOutput = 1; ctx->detOutput = 0; }
+            // else fall back to ordering: out0 detection, out1 proto.
+            ZM_LOG_INFO("detect_seg: loaded model '%s' (input='%s' det='%s' proto='%s' "
+                        "net=%d ep=%s hw=%s) %s", ctx->modelPath.c_str(),
+                        ctx->model.input_name().c_str(),
+                        ctx->model.output_names()[ctx->detOutput].c_str(),
+                        ctx->model.output_names()[ctx->protoOutput].c_str(), ctx->net,
+                        ctx->ep.c_str(), backend.c_str(),
+                        ctx->model.load_stats().summary().c_str());
         }
     } else {
         ZM_LOG_WARN("detect_seg: no model_path configured; running as pass-through");
@@ -231,56 +201,18 @@ static void detect_seg_stop(zm_plugin_t* plugin) {
     }
 }
 
-static void detect_seg_on_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
-    auto* ctx = static_cast<DetectSegCtx*>(plugin->instance);
-    if (!ctx || !buf || size < sizeof(zm_frame_hdr_t)) {
-        forwardFrame(ctx, buf, size);
-        return;
-    }
-
-    const zm_frame_hdr_t* hdr = static_cast<const zm_frame_hdr_t*>(buf);
-    const uint8_t* payload = static_cast<const uint8_t*>(buf) + sizeof(zm_frame_hdr_t);
-
-    // Bail out (pass-through) when we cannot or should not run inference.
-    if (!ctx->session || hdr->hw_type != ZM_FRAME_RGB24) {
-        forwardFrame(ctx, buf, size);
-        return;
-    }
-    if (!ctx->streamFilter.empty() &&
-        std::find(ctx->streamFilter.begin(), ctx->streamFilter.end(),
-                  static_cast<int>(hdr->stream_id)) == ctx->streamFilter.end()) {
-        forwardFrame(ctx, buf, size);
-        return;
-    }
-
-    const int w = ctx->frameWidth;
-    const int h = ctx->frameHeight;
-    if (w <= 0 || h <= 0 ||
-        size < sizeof(zm_frame_hdr_t) + static_cast<size_t>(w) * h * 3) {
-        forwardFrame(ctx, buf, size);
-        return;
-    }
-
+// Letterbox the surface, run the model and publish the decoded objects.
+static void inferSeg(DetectSegCtx* ctx, const zm_frame_hdr_t* hdr,
+                     const zm::hw::Surface& surface) {
     try {
-        const int net = ctx->net;
-        zm::detect::Letterbox lb = zm::detect::compute_letterbox(w, h, net);
-
-        std::vector<float> input(static_cast<size_t>(3) * net * net);
-        zm::detect::letterbox_rgb_to_chw(payload, lb, input.data());
-
-        Ort::MemoryInfo memInfo =
-            Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
-        std::array<int64_t, 4> inputShape{1, 3, net, net};
-        Ort::Value inputTensor = Ort::Value::CreateTensor<float>(
-            memInfo, input.data(), input.size(), inputShape.data(), inputShape.size());
-
-        const char* inputNames[] = {ctx->inputName.c_str()};
-        const char* outputNames[] = {ctx->detName.c_str(), ctx->protoName.c_str()};
-
-        auto outputs = ctx->session->Run(Ort::RunOptions{nullptr}, inputNames,
-                                         &inputTensor, 1, outputNames, 2);
-
-        // outputs[0] = detection, outputs[1] = proto (per outputNames order).
+        zm::hw::TensorSpec spec;
+        spec.width = spec.height = ctx->net;
+        const zm::hw::BatchTensor input = ctx->pipeline.preprocess(surface, {}, spec);
+        if (!input.valid() || (input.device && !ctx->model.device_inputs())) return;
+        const zm::detect::Letterbox& lb = input.lb[0];
+        auto outputs = ctx->model.run(input, {ctx->detOutput, ctx->protoOutput});
+
+        // outputs[0] = detection, outputs[1] = proto (per the requested order).
         const float* det = outputs[0].GetTensorData<float>();
         auto detShape = outputs[0].GetTensorTypeAndShapeInfo().GetShape();
         const float* proto = outputs[1].GetTensorData<float>();
@@ -293,7 +225,6 @@ static void detect_seg_on_frame(zm_plugin_t* plugin, const void* buf, size_t siz
                             detShape.size(), protoShape.size());
                 ctx->warnedShape = true;
             }
-            forwardFrame(ctx, buf, size);
             return;
         }
 
@@ -320,7 +251,6 @@ static void detect_seg_on_frame(zm_plugin_t* plugin, const void* buf, size_t siz
                             channels, maskDim);
                 ctx->warnedShape = true;
             }
-            forwardFrame(ctx, buf, size);
             return;
         }
 
@@ -329,21 +259,20 @@ static void detect_seg_on_frame(zm_plugin_t* plugin, const void* buf, size_t siz
             ctx->confThreshold, ctx->classFilter);
         objs = zm::seg::nms(std::move(objs), ctx->iouThreshold);
 
-        if (objs.empty()) {
-            forwardFrame(ctx, buf, size);
-            return;
-        }
+        if (objs.empty()) return;
 
         const bool wantAlpha = ctx->emitSoftMask;
         const bool wantPolygon = (ctx->maskFormat != "none") && !wantAlpha;
 
+        // The soft sigmoid mask feeds either the alpha matte (P4) or the
+        // coarse polygon; synthesize all objects' masks in one batch if either
+        // is wanted.
+        if (wantAlpha || wantPolygon)
+            ctx->masks.build(proto, maskDim, mh, mw, lb, objs);
+
         json objsJson = json::array();
-        for (auto& o : objs) {
-            // The soft sigmoid mask feeds either the alpha matte (P4) or the
-            // coarse polygon; compute it once if either is wanted.
-            std::vector<float> softmask;
-            if (wantAlpha || wantPolygon)
-                softmask = zm::seg::build_mask(proto, maskDim, mh, mw, o.coeffs);
+        for (size_t i = 0; i < objs.size(); ++i) {
+            zm::seg::SegObj& o = objs[i];
 
             std::string scratch;
             json od;
@@ -353,13 +282,13 @@ static void detect_seg_on_frame(zm_plugin_t* plugin, const void* buf, size_t siz
             od["class_id"] = o.class_id;
             if (wantAlpha) {
                 zm::seg::AlphaMask am =
-                    zm::seg::mask_to_alpha(softmask, mh, mw, lb, o, ctx->softMaskMaxEdge);
+                    zm::seg::mask_to_alpha(ctx->masks.view(i), ctx->softMaskMaxEdge);
                 if (am.w > 0 && am.h > 0) {
                     od["mask"] = {{"format", "alpha"}, {"w", am.w}, {"h", am.h},
                                   {"data", zm::b64::encode(am.data)}};
                 }
             } else if (wantPolygon) {
-                o.polygon = zm::seg::mask_to_polygon(softmask, mh, mw, 0.5f, lb, o);
+                o.polygon = zm::seg::mask_to_polygon(ctx->masks.view(i), mh, mw, 0.5f, lb);
                 json poly = json::array();
                 for (const auto& p : o.polygon) poly.push_back({p[0], p[1]});
                 od["polygon"] = std::move(poly);
@@ -386,7 +315,36 @@ static void detect_seg_on_frame(zm_plugin_t* plugin, const void* buf, size_t siz
     } catch (const std::exception& e) {
         ZM_LOG_ERROR("detect_seg: inference error: %s", e.what());
     }
+}
 
+static void detect_seg_on_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
+    auto* ctx = static_cast<DetectSegCtx*>(plugin->instance);
+    if (!ctx || !buf || size < sizeof(zm_frame_hdr_t)) {
+        forwardFrame(ctx, buf, size);
+        return;
+    }
+
+    const zm_frame_hdr_t* hdr = static_cast<const zm_frame_hdr_t*>(buf);
+
+    // Bail out (pass-through) when we cannot or should not run inference.
+    if (!ctx->model.loaded()) {
+        forwardFrame(ctx, buf, size);
+        return;
+    }
+    if (!ctx->streamFilter.empty() &&
+        std::find(ctx->streamFilter.begin(), ctx->streamFilter.end(),
+                  static_cast<int>(hdr->stream_id)) == ctx->streamFilter.end()) {
+        forwardFrame(ctx, buf, size);
+        return;
+    }
+
+    zm::hw::Surface surface;
+    if (!ctx->pipeline.acquire(buf, size, ctx->frameWidth, ctx->frameHeight, surface)) {
+        forwardFrame(ctx, buf, size);
+        return;
+    }
+    inferSeg(ctx, hdr, surface);
+    ctx->pipeline.release(surface);
     forwardFrame(ctx, buf, size);
 }
 
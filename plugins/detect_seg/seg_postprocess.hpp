@@ -5,15 +5,23 @@
 // unit-tested without a model.
 //
 // Reuses Letterbox / unletterbox math from the detect_onnx shared header.
+// Mask synthesis for a frame's kept objects (MaskBatch) only evaluates each
+// object's box footprint; the coeff*proto kernel uses xsimd batches when built
+// with ZMP_USE_SIMD, with a scalar fallback.
 
 #include "../detect_onnx/detect_postprocess.hpp"
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 #include <array>
 #include <algorithm>
 #include <cmath>
 
+#ifdef ZMP_USE_SIMD
+#include <xsimd/xsimd.hpp>
+#endif
+
 namespace zm::seg {
 
 // A segmented object in source-image pixel coordinates (x,y = top-left;
@@ -128,7 +136,8 @@ inline float sigmoid(float v) { return 1.0f / (1.0f + std::exp(-v)); }
 //
 // `proto` is the proto tensor (output1) data of shape [nm, mh, mw], i.e.
 // proto[k*mh*mw + y*mw + x]. `coeffs` has `mask_dim` entries. The result is
-// row-major mh*mw. No thresholding is applied here.
+// row-major mh*mw. No thresholding is applied here. The plugin uses MaskBatch,
+// which evaluates only the box footprints; this full-grid form is the reference.
 inline std::vector<float> build_mask(const float* proto, int mask_dim,
                                      int mh, int mw, const std::vector<float>& coeffs) {
     std::vector<float> mask(static_cast<size_t>(mh) * mw, 0.0f);
@@ -143,24 +152,149 @@ inline std::vector<float> build_mask(const float* proto, int mask_dim,
     return mask;
 }
 
-// Convert a thresholded mask (in mask-grid coords mh*mw) to a coarse outer
-// polygon in SOURCE pixel coordinates.
-//
-// Method (documented "coarse but valid" approach): scan each mask row and find
-// the min/max x of set pixels (mask >= thr) that also fall inside the
-// detection box's mask-grid footprint. Each occupied row contributes two
-// boundary points (left edge, right edge). We walk down the left edges then
-// back up the right edges, producing a single closed polygon ring that hugs
-// the mask's horizontal extent per row. Rows are subsampled by `row_step` to
-// keep the polygon compact.
-//
-// Coordinate mapping: the mask grid corresponds to the letterboxed `net`x`net`
-// input scaled down by net/mask_w. So a mask pixel (mx,my) maps to net space
-// as (mx * net/mw, my * net/mh), then unletterbox (subtract pad, divide scale)
-// to source pixels. We pass the Letterbox and mask dims to do this.
-//
-// `box` (source pixels, xywh) clips the mask so only pixels inside the
-// detection box contribute (YOLO-seg crops the mask to the box).
+// Inclusive mask-grid rectangle; empty when x1 < x0 or y1 < y0.
+struct MaskRect {
+    int x0 = 0, y0 = 0, x1 = -1, y1 = -1;
+    int w() const { return x1 - x0 + 1; }
+    int h() const { return y1 - y0 + 1; }
+    bool empty() const { return x1 < x0 || y1 < y0; }
+};
+
+// Footprint of an object's box (source pixels) on the mh*mw mask grid:
+// source -> net (letterbox) -> mask (net/mw per cell), widened to whole cells
+// and clipped to the grid. YOLO-seg crops each mask to this region.
+inline MaskRect box_footprint(int mh, int mw, const zm::detect::Letterbox& lb,
+                              const SegObj& box) {
+    const float net = static_cast<float>(lb.net);
+    const float sx = net / static_cast<float>(mw);  // mask px -> net px (x)
+    const float sy = net / static_cast<float>(mh);  // mask px -> net px (y)
+    auto src_to_mask_x = [&](float xs) { return (xs * lb.scale + lb.pad_x) / sx; };
+    auto src_to_mask_y = [&](float ys) { return (ys * lb.scale + lb.pad_y) / sy; };
+    MaskRect r;
+    r.x0 = std::max(0, static_cast<int>(std::floor(src_to_mask_x(box.x))));
+    r.x1 = std::min(mw - 1, static_cast<int>(std::ceil(src_to_mask_x(box.x + box.w))));
+    r.y0 = std::max(0, static_cast<int>(std::floor(src_to_mask_y(box.y))));
+    r.y1 = std::min(mh - 1, static_cast<int>(std::ceil(src_to_mask_y(box.y + box.h))));
+    return r;
+}
+
+// Read-only view of soft mask values over `rect`: the value of mask cell
+// (mx,my) is data[(my - rect.y0) * stride + (mx - rect.x0)]. Views either a
+// full mh*mw mask (stride mw) or a crop-only mask from MaskBatch (stride w).
+struct MaskView {
+    const float* data = nullptr;
+    size_t stride = 0;
+    MaskRect rect;
+    float at(int mx, int my) const {
+        return data[static_cast<size_t>(my - rect.y0) * stride + (mx - rect.x0)];
+    }
+};
+
+// View of a full mh*mw mask restricted to the object's box footprint.
+inline MaskView full_mask_view(const std::vector<float>& mask, int mh, int mw,
+                               const zm::detect::Letterbox& lb, const SegObj& box) {
+    MaskView v;
+    v.rect = box_footprint(mh, mw, lb, box);
+    v.stride = static_cast<size_t>(mw);
+    if (!v.rect.empty())
+        v.data = mask.data() + static_cast<size_t>(v.rect.y0) * mw + v.rect.x0;
+    return v;
+}
+
+namespace detail {
+
+// out[x] = sum_k c[k] * proto[k*plane + x] for x < n: one output row of the
+// [1 x nm] . [nm x n] product. Accumulates in registers across all nm
+// prototypes, so each output value is written once.
+inline void combine_row(const float* proto, size_t plane, const float* c, int nm,
+                        int n, float* out) {
+    int x = 0;
+#ifdef ZMP_USE_SIMD
+    // Two batches per step; multiply then add, like the scalar tail.
+    using batch_t = xsimd::batch<float>;
+    constexpr int VL = static_cast<int>(batch_t::size);
+    for (; x + 2 * VL <= n; x += 2 * VL) {
+        batch_t a0(0.0f), a1(0.0f);
+        const float* p = proto + x;
+        for (int k = 0; k < nm; ++k, p += plane) {
+            const batch_t ck(c[k]);
+            a0 = a0 + ck * batch_t::load_unaligned(p);
+            a1 = a1 + ck * batch_t::load_unaligned(p + VL);
+        }
+        a0.store_unaligned(out + x);
+        a1.store_unaligned(out + x + VL);
+    }
+#endif
+    for (; x < n; ++x) {
+        float acc = 0.0f;
+        const float* p = proto + x;
+        for (int k = 0; k < nm; ++k, p += plane) acc += c[k] * p[0];
+        out[x] = acc;
+    }
+}
+
+} // namespace detail
+
+// Soft masks for all of a frame's kept objects, synthesized only inside each
+// object's box footprint. The objects' coefficients are stacked into one
+// [N x nm] matrix and multiplied against the proto columns each footprint
+// covers, so the cost scales with total object area rather than object count
+// times mh*mw. Buffers are reused across build() calls; keep one per plugin
+// instance. Values match build_mask() over the same cells.
+class MaskBatch {
+public:
+    void build(const float* proto, int mask_dim, int mh, int mw,
+               const zm::detect::Letterbox& lb, const std::vector<SegObj>& objs) {
+        const size_t n = objs.size();
+        const int nm = std::max(0, mask_dim);
+        const size_t plane = static_cast<size_t>(mh) * mw;
+        rects_.resize(n);
+        offsets_.resize(n + 1);
+        coeffs_.assign(n * nm, 0.0f);
+        offsets_[0] = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const SegObj& o = objs[i];
+            const size_t km = std::min(o.coeffs.size(), static_cast<size_t>(nm));
+            std::copy(o.coeffs.begin(), o.coeffs.begin() + km, coeffs_.begin() + i * nm);
+            rects_[i] = box_footprint(mh, mw, lb, o);
+            const size_t area = rects_[i].empty()
+                ? 0 : static_cast<size_t>(rects_[i].w()) * rects_[i].h();
+            offsets_[i + 1] = offsets_[i] + area;
+        }
+        masks_.resize(offsets_[n]);
+
+        for (size_t i = 0; i < n; ++i) {
+            const MaskRect& r = rects_[i];
+            if (r.empty()) continue;
+            const float* c = coeffs_.data() + i * nm;
+            float* out = masks_.data() + offsets_[i];
+            for (int y = r.y0; y <= r.y1; ++y, out += r.w()) {
+                detail::combine_row(proto + static_cast<size_t>(y) * mw + r.x0, plane, c, nm,
+                                    r.w(), out);
+                for (int x = 0; x < r.w(); ++x) out[x] = sigmoid(out[x]);
+            }
+        }
+    }
+
+    size_t size() const { return rects_.size(); }
+
+    // Soft mask of object i (build() order) over its box footprint; the view is
+    // empty (data == nullptr) when the box misses the mask grid.
+    MaskView view(size_t i) const {
+        MaskView v;
+        v.rect = rects_[i];
+        v.stride = static_cast<size_t>(std::max(0, v.rect.w()));
+        if (!v.rect.empty()) v.data = masks_.data() + offsets_[i];
+        return v;
+    }
+
+private:
+    std::vector<float> coeffs_;      // [N x nm] stacked mask coefficients
+    std::vector<MaskRect> rects_;    // per-object footprint
+    std::vector<size_t> offsets_;    // N+1 prefix offsets into masks_
+    std::vector<float> masks_;       // concatenated row-major footprint masks
+};
+
 // A downscaled soft-alpha cutout of one object's mask, aligned to its bbox.
 // `w`*`h` row-major 8-bit alpha (0=background, 255=object); stretch it across the
 // object's bbox at render time. This preserves the per-pixel soft matte the
@@ -170,25 +304,15 @@ struct AlphaMask {
     std::vector<uint8_t> data;  // row-major w*h, 8-bit
 };
 
-// Crop the soft mask (mh*mw, [0,1]) to the object's bbox footprint in mask-grid
-// coords, convert to 8-bit alpha, and downscale (nearest) so the longer edge is
-// <= max_edge. The result maps linearly onto the object's source-pixel bbox.
-inline AlphaMask mask_to_alpha(const std::vector<float>& mask, int mh, int mw,
-                               const zm::detect::Letterbox& lb, const SegObj& box,
-                               int max_edge = 64) {
+// Convert the soft mask over the object's bbox footprint to 8-bit alpha and
+// downscale (nearest) so the longer edge is <= max_edge. The result maps
+// linearly onto the object's source-pixel bbox.
+inline AlphaMask mask_to_alpha(const MaskView& mask, int max_edge = 64) {
     AlphaMask out;
-    const float net = static_cast<float>(lb.net);
-    const float sx = net / static_cast<float>(mw);
-    const float sy = net / static_cast<float>(mh);
-    auto src_to_mask_x = [&](float xs) { return (xs * lb.scale + lb.pad_x) / sx; };
-    auto src_to_mask_y = [&](float ys) { return (ys * lb.scale + lb.pad_y) / sy; };
-    const int bx0 = std::max(0, static_cast<int>(std::floor(src_to_mask_x(box.x))));
-    const int bx1 = std::min(mw - 1, static_cast<int>(std::ceil(src_to_mask_x(box.x + box.w))));
-    const int by0 = std::max(0, static_cast<int>(std::floor(src_to_mask_y(box.y))));
-    const int by1 = std::min(mh - 1, static_cast<int>(std::ceil(src_to_mask_y(box.y + box.h))));
-    const int cw = bx1 - bx0 + 1;
-    const int ch = by1 - by0 + 1;
-    if (cw < 1 || ch < 1) return out;
+    const int bx0 = mask.rect.x0, by0 = mask.rect.y0;
+    const int cw = mask.rect.w();
+    const int ch = mask.rect.h();
+    if (cw < 1 || ch < 1 || !mask.data) return out;
 
     // Target dims: downscale (nearest) so the long edge <= max_edge.
     int dw = cw, dh = ch;
@@ -204,7 +328,7 @@ inline AlphaMask mask_to_alpha(const std::vector<float>& mask, int mh, int mw,
         const int my = by0 + std::min(ch - 1, y * ch / dh);
         for (int x = 0; x < dw; ++x) {
             const int mx = bx0 + std::min(cw - 1, x * cw / dw);
-            float v = mask[static_cast<size_t>(my) * mw + mx];
+            float v = mask.at(mx, my);
             if (v < 0.0f) v = 0.0f; else if (v > 1.0f) v = 1.0f;
             out.data[static_cast<size_t>(y) * dw + x] = static_cast<uint8_t>(v * 255.0f + 0.5f);
         }
@@ -212,25 +336,43 @@ inline AlphaMask mask_to_alpha(const std::vector<float>& mask, int mh, int mw,
     return out;
 }
 
+// Crop the full soft mask (mh*mw, [0,1]) to the object's bbox footprint in
+// mask-grid coords, then as above.
+inline AlphaMask mask_to_alpha(const std::vector<float>& mask, int mh, int mw,
+                               const zm::detect::Letterbox& lb, const SegObj& box,
+                               int max_edge = 64) {
+    return mask_to_alpha(full_mask_view(mask, mh, mw, lb, box), max_edge);
+}
+
+// Convert a thresholded mask (in mask-grid coords mh*mw) to a coarse outer
+// polygon in SOURCE pixel coordinates.
+//
+// Method (documented "coarse but valid" approach): scan each mask row and find
+// the min/max x of set pixels (mask >= thr) that also fall inside the
+// detection box's mask-grid footprint. Each occupied row contributes two
+// boundary points (left edge, right edge). We walk down the left edges then
+// back up the right edges, producing a single closed polygon ring that hugs
+// the mask's horizontal extent per row. Rows are subsampled by `row_step` to
+// keep the polygon compact.
+//
+// Coordinate mapping: the mask grid corresponds to the letterboxed `net`x`net`
+// input scaled down by net/mask_w. So a mask pixel (mx,my) maps to net space
+// as (mx * net/mw, my * net/mh), then unletterbox (subtract pad, divide scale)
+// to source pixels. We pass the Letterbox and mask dims to do this.
+//
+// `mask` covers the detection box's footprint (YOLO-seg crops the mask to the
+// box), so only pixels inside it contribute.
 inline std::vector<std::array<float, 2>> mask_to_polygon(
-        const std::vector<float>& mask, int mh, int mw, float thr,
-        const zm::detect::Letterbox& lb, const SegObj& box, int row_step = 2) {
+        const MaskView& mask, int mh, int mw, float thr,
+        const zm::detect::Letterbox& lb, int row_step = 2) {
     if (row_step < 1) row_step = 1;
+    std::vector<std::array<float, 2>> poly;
+    if (!mask.data || mask.rect.empty()) return poly;
     const float net = static_cast<float>(lb.net);
     const float sx = net / static_cast<float>(mw);  // mask px -> net px (x)
     const float sy = net / static_cast<float>(mh);  // mask px -> net px (y)
-
-    // Box footprint in mask-grid coords (source -> net -> mask).
-    auto src_to_mask_x = [&](float xs) {
-        return (xs * lb.scale + lb.pad_x) / sx;
-    };
-    auto src_to_mask_y = [&](float ys) {
-        return (ys * lb.scale + lb.pad_y) / sy;
-    };
-    const int bx0 = std::max(0, static_cast<int>(std::floor(src_to_mask_x(box.x))));
-    const int bx1 = std::min(mw - 1, static_cast<int>(std::ceil(src_to_mask_x(box.x + box.w))));
-    const int by0 = std::max(0, static_cast<int>(std::floor(src_to_mask_y(box.y))));
-    const int by1 = std::min(mh - 1, static_cast<int>(std::ceil(src_to_mask_y(box.y + box.h))));
+    const int bx0 = mask.rect.x0, bx1 = mask.rect.x1;
+    const int by0 = mask.rect.y0, by1 = mask.rect.y1;
 
     // Map a mask pixel center to source pixels.
     auto mask_to_src = [&](float mx, float my) -> std::array<float, 2> {
@@ -248,7 +390,7 @@ inline std::vector<std::array<float, 2>> mask_to_polygon(
     for (int y = by0; y <= by1; y += row_step) {
         int xmin = -1, xmax = -1;
         for (int x = bx0; x <= bx1; ++x) {
-            if (mask[static_cast<size_t>(y) * mw + x] >= thr) {
+            if (mask.at(x, y) >= thr) {
                 if (xmin < 0) xmin = x;
                 xmax = x;
             }
@@ -259,7 +401,6 @@ inline std::vector<std::array<float, 2>> mask_to_polygon(
         }
     }
 
-    std::vector<std::array<float, 2>> poly;
     if (leftEdges.empty()) return poly;
 
     poly.reserve(leftEdges.size() * 2);
@@ -273,4 +414,11 @@ inline std::vector<std::array<float, 2>> mask_to_polygon(
     return poly;
 }
 
+// Full-mask form: `box` (source pixels, xywh) selects the footprint.
+inline std::vector<std::array<float, 2>> mask_to_polygon(
+        const std::vector<float>& mask, int mh, int mw, float thr,
+        const zm::detect::Letterbox& lb, const SegObj& box, int row_step = 2) {
+    return mask_to_polygon(full_mask_view(mask, mh, mw, lb, box), mh, mw, thr, lb, row_step);
+}
+
 } // namespace zm::seg
@@ -206,3 +206,108 @@ TEST(Decode, ConfidenceThresholdRejects) {
     auto objs = decode(det.data(), num, channels, nc, nm, true, lb, 0.25f);
     EXPECT_TRUE(objs.empty());
 }
+
+namespace {
+
+// Deterministic pseudo-random proto tensor [nm, mh, mw] in [-1, 1).
+std::vector<float> randomProto(int nm, int mh, int mw) {
+    std::vector<float> proto(static_cast<size_t>(nm) * mh * mw);
+    uint32_t s = 12345u;
+    for (float& v : proto) {
+        s = s * 1664525u + 1013904223u;
+        v = static_cast<float>(s >> 8) / static_cast<float>(1u << 24) * 2.0f - 1.0f;
+    }
+    return proto;
+}
+
+SegObj makeSegObj(float x, float y, float w, float h, int nm, float phase) {
+    SegObj o = makeBox(x, y, w, h, 0.9f, 0);
+    for (int k = 0; k < nm; ++k) o.coeffs.push_back(std::sin(phase + 0.7f * k));
+    return o;
+}
+
+} // namespace
+
+TEST(MaskBatch, MatchesFullMaskInsideFootprint) {
+    // 64x48 source into a 64 net -> 16x16 grid (scale 1, vertical padding).
+    zm::detect::Letterbox lb = zm::detect::compute_letterbox(64, 48, 64);
+    const int nm = 32, mh = 16, mw = 16;
+    const auto proto = randomProto(nm, mh, mw);
+    std::vector<SegObj> objs = {
+        makeSegObj(4, 4, 20, 10, nm, 0.0f),
+        makeSegObj(0, 0, 64, 48, nm, 1.0f),    // whole frame
+        makeSegObj(50, 30, 30, 30, nm, 2.0f),  // spills past the frame edge
+        makeSegObj(10, 10, 1, 1, nm, 3.0f),    // a single cell or two
+    };
+    MaskBatch batch;
+    batch.build(proto.data(), nm, mh, mw, lb, objs);
+    ASSERT_EQ(batch.size(), objs.size());
+    for (size_t i = 0; i < objs.size(); ++i) {
+        const auto full = build_mask(proto.data(), nm, mh, mw, objs[i].coeffs);
+        const MaskView v = batch.view(i);
+        const MaskRect r = box_footprint(mh, mw, lb, objs[i]);
+        EXPECT_EQ(v.rect.x0, r.x0);
+        EXPECT_EQ(v.rect.y1, r.y1);
+        ASSERT_FALSE(v.rect.empty());
+        for (int y = r.y0; y <= r.y1; ++y)
+            for (int x = r.x0; x <= r.x1; ++x)
+                ASSERT_NEAR(v.at(x, y), full[static_cast<size_t>(y) * mw + x], 1e-5f)
+                    << "object " << i << " cell (" << x << "," << y << ")";
+
+        // Polygon and alpha from the crop match the full-mask forms.
+        EXPECT_EQ(mask_to_polygon(v, mh, mw, 0.5f, lb, 1),
+                  mask_to_polygon(full, mh, mw, 0.5f, lb, objs[i], 1));
+        EXPECT_EQ(mask_to_alpha(v, 8).data, mask_to_alpha(full, mh, mw, lb, objs[i], 8).data);
+    }
+}
+
+TEST(MaskBatch, ReusesBuffersAcrossFrames) {
+    zm::detect::Letterbox lb = zm::detect::compute_letterbox(32, 32, 32);
+    const int nm = 4, mh = 8, mw = 8;
+    const auto proto = randomProto(nm, mh, mw);
+    MaskBatch batch;
+    batch.build(proto.data(), nm, mh, mw, lb,
+                {makeSegObj(0, 0, 32, 32, nm, 0.0f), makeSegObj(8, 8, 8, 8, nm, 1.0f)});
+    ASSERT_EQ(batch.size(), 2u);
+
+    const SegObj small = makeSegObj(16, 0, 8, 4, nm, 2.0f);
+    batch.build(proto.data(), nm, mh, mw, lb, {small});
+    ASSERT_EQ(batch.size(), 1u);
+    const auto full = build_mask(proto.data(), nm, mh, mw, small.coeffs);
+    const MaskView v = batch.view(0);
+    EXPECT_EQ(v.rect.w() * v.rect.h(), 3 * 2);
+    for (int y = v.rect.y0; y <= v.rect.y1; ++y)
+        for (int x = v.rect.x0; x <= v.rect.x1; ++x)
+            EXPECT_NEAR(v.at(x, y), full[static_cast<size_t>(y) * mw + x], 1e-5f);
+
+    batch.build(proto.data(), nm, mh, mw, lb, {});
+    EXPECT_EQ(batch.size(), 0u);
+}
+
+TEST(MaskBatch, BoxOffGridIsEmpty) {
+    zm::detect::Letterbox lb = zm::detect::compute_letterbox(32, 32, 32);
+    const int nm = 2, mh = 8, mw = 8;
+    const auto proto = randomProto(nm, mh, mw);
+    MaskBatch batch;
+    batch.build(proto.data(), nm, mh, mw, lb, {makeSegObj(100, 100, 4, 4, nm, 0.0f)});
+    const MaskView v = batch.view(0);
+    EXPECT_EQ(v.data, nullptr);
+    EXPECT_TRUE(mask_to_polygon(v, mh, mw, 0.5f, lb).empty());
+    EXPECT_EQ(mask_to_alpha(v).w, 0);
+}
+
+TEST(MaskBatch, CombineRowMatchesScalarAtEveryWidth) {
+    // Widths around every batch multiple, so both the vector body and the tail run.
+    const int nm = 32, mw = 80;
+    const auto proto = randomProto(nm, 1, mw);
+    const SegObj o = makeSegObj(0, 0, 1, 1, nm, 0.5f);
+    std::vector<float> out(mw);
+    for (int n = 0; n <= mw; ++n) {
+        detail::combine_row(proto.data(), mw, o.coeffs.data(), nm, n, out.data());
+        for (int x = 0; x < n; ++x) {
+            float ref = 0.0f;
+            for (int k = 0; k < nm; ++k) ref += o.coeffs[k] * proto[static_cast<size_t>(k) * mw + x];
+            ASSERT_NEAR(out[x], ref, 1e-5f) << "n " << n << " x " << x;
+        }
+    }
+}
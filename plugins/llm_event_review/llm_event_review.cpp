@@ -11,7 +11,7 @@
 //
 // It reuses describe_vlm's proven machinery:
 //   - latest-frame-per-stream cache populated from on_frame (RGB24), under mutex,
-//   - FFmpeg mjpeg JPEG encode (here with an added downscale to max_pixels),
+//   - the shared pooled mjpeg encoder (here with downscale to max_pixels),
 //   - libcurl + OpenAI-compatible /v1/chat/completions HTTP (via IVisionProvider).
 //
 // THREADING: on_frame runs on the decode thread; the EventBus callback runs on
@@ -42,6 +42,8 @@
 
 #include "provider.hpp"
 #include "zm_plugin.h"
+#include "zm_side_data.h"
+#include "image_encode.hpp"
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -221,87 +223,15 @@ struct State {
 // Encodes an RGB24 buffer to an in-memory JPEG. If width*height exceeds
 // maxPixels, the image is bilinearly downscaled (aspect preserved) before
 // encoding — this caps the visual-token cost on the VLM and reduces PII in the
-// bytes that leave the box. Returns true and fills `out` on success.
+// bytes that leave the box. Returns true and fills `out` on success. Uses the
+// plugin's pooled encoder (plugins/common/image_encode.hpp), which scales and
+// converts in one pass.
 //
 bool encodeRgb24ToJpeg(const uint8_t* rgb, int width, int height, long maxPixels,
                        std::vector<uint8_t>& out) {
-    out.clear();
-    if (!rgb || width <= 0 || height <= 0) return false;
-
-    // Compute the (possibly downscaled) destination size.
-    int dstW = width, dstH = height;
-    if (maxPixels > 0 &&
-        static_cast<long>(width) * static_cast<long>(height) > maxPixels) {
-        const double scale =
-            std::sqrt(static_cast<double>(maxPixels) /
-                      (static_cast<double>(width) * static_cast<double>(height)));
-        dstW = std::max(1, static_cast<int>(width * scale));
-        dstH = std::max(1, static_cast<int>(height * scale));
-        // mjpeg/yuvj420p prefers even dimensions.
-        dstW &= ~1;
-        dstH &= ~1;
-        if (dstW < 2) dstW = 2;
-        if (dstH < 2) dstH = 2;
-    }
-
-    const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
-    if (!codec) return false;
-
-    AVCodecContext* cctx = avcodec_alloc_context3(codec);
-    if (!cctx) return false;
-
-    cctx->pix_fmt = AV_PIX_FMT_YUVJ420P;
-    cctx->width = dstW;
-    cctx->height = dstH;
-    cctx->time_base = AVRational{1, 25};
-    cctx->color_range = AVCOL_RANGE_JPEG;
-
-    SwsContext* sws = nullptr;
-    AVFrame* frame = nullptr;
-    AVPacket* pkt = nullptr;
-    bool ok = false;
-
-    do {
-        if (avcodec_open2(cctx, codec, nullptr) < 0) break;
-
-        frame = av_frame_alloc();
-        if (!frame) break;
-        frame->format = cctx->pix_fmt;
-        frame->width = dstW;
-        frame->height = dstH;
-        if (av_frame_get_buffer(frame, 32) < 0) break;
-
-        // Scale RGB24(src) -> YUVJ420P(dst), resizing in the same pass.
-        sws = sws_getContext(width, height, AV_PIX_FMT_RGB24,
-                             dstW, dstH, AV_PIX_FMT_YUVJ420P,
-                             SWS_BILINEAR, nullptr, nullptr, nullptr);
-        if (!sws) break;
-
-        const uint8_t* srcSlice[1] = {rgb};
-        int srcStride[1] = {3 * width};
-        sws_scale(sws, srcSlice, srcStride, 0, height,
-                  frame->data, frame->linesize);
-
-        frame->pts = 0;
-
-        if (avcodec_send_frame(cctx, frame) < 0) break;
-
-        pkt = av_packet_alloc();
-        if (!pkt) break;
-
-        int ret = avcodec_receive_packet(cctx, pkt);
-        if (ret < 0) break;
-
-        out.assign(pkt->data, pkt->data + pkt->size);
-        ok = true;
-    } while (false);
-
-    if (pkt) av_packet_free(&pkt);
-    if (frame) av_frame_free(&frame);
-    if (sws) sws_freeContext(sws);
-    if (cctx) avcodec_free_context(&cctx);
-
-    return ok;
+    zm::img::JpegOptions opt;
+    opt.max_pixels = maxPixels;
+    return zm::img::encode_rgb24_to_jpeg(rgb, width, height, out, opt);
 }
 
 // ---------------------------------------------------------------------------
@@ -1077,7 +1007,7 @@ void on_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
     const auto* hdr = static_cast<const zm_frame_hdr_t*>(buf);
     const uint8_t* payload =
         static_cast<const uint8_t*>(buf) + sizeof(zm_frame_hdr_t);
-    const size_t payloadSize = size - sizeof(zm_frame_hdr_t);
+    const size_t payloadSize = zm_frame_payload_size(buf, size);
 
     // Feed the per-stream ring (thinned to montage_sample_fps; thumbnails only).
     //
@@ -0,0 +1,204 @@
+#pragma once
+
+// Cross-caller request coalescing for the LPR models. Kept free of ONNX Runtime
+// (the model call is a std::function) so it can be unit-tested without a model.
+//
+// Each lpr instance (one per camera) submits all of a frame's inputs in one
+// blocking run(); when several instances share a model, a worker thread merges
+// the requests pending at that moment into a single batched model call and
+// hands each caller its slice of the output. Same idea as detect_onnx's
+// InferenceEngine, but for CPU tensors and variable-size requests.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace zm::lpr {
+
+// Per-item output dims from a batched output `shape` for `n` items whose
+// per-item rank is `item_rank`: [n, ...] -> [...]. A single item may also come
+// back without the batch dim ([T, C] instead of [1, T, C]). Returns false if
+// the shape does not split into n items.
+inline bool batch_item_shape(const std::vector<int64_t>& shape, int n, size_t item_rank,
+                             std::vector<int64_t>& item) {
+    if (shape.size() == item_rank + 1 && shape[0] == n) {
+        item.assign(shape.begin() + 1, shape.end());
+    } else if (n == 1 && shape.size() == item_rank) {
+        item = shape;
+    } else {
+        return false;
+    }
+    for (int64_t d : item)
+        if (d <= 0) return false;
+    return true;
+}
+
+class BatchQueue {
+public:
+    // Run the model on `n` contiguous inputs of item_floats each. Fills `out`
+    // with n contiguous outputs and `item_shape` with one output's dims; returns
+    // false on failure. Must be safe to call from several threads at once.
+    using RunFn = std::function<bool(const float* in, int n, std::vector<float>& out,
+                                     std::vector<int64_t>& item_shape)>;
+
+    // max_batch caps items per model call; max_wait_us is how long the worker
+    // lingers for other attached callers before running a partial batch.
+    BatchQueue(size_t item_floats, int max_batch, int max_wait_us, RunFn run)
+        : itemFloats_(item_floats), maxBatch_(std::max(1, max_batch)),
+          maxWaitUs_(std::max(0, max_wait_us)), run_(std::move(run)) {
+        th_ = std::thread(&BatchQueue::loop, this);
+    }
+
+    ~BatchQueue() {
+        { std::lock_guard<std::mutex> lk(m_); stop_ = true; }
+        cv_.notify_all();
+        if (th_.joinable()) th_.join();
+    }
+
+    BatchQueue(const BatchQueue&) = delete;
+    BatchQueue& operator=(const BatchQueue&) = delete;
+
+    // Callers sharing this queue. With a single caller there is nothing to
+    // coalesce, so run() calls the model directly on the caller's thread.
+    void attach() { std::lock_guard<std::mutex> lk(m_); ++clients_; }
+    void detach() { std::lock_guard<std::mutex> lk(m_); --clients_; }
+
+    // Blocking. `in` holds n * item_floats floats and must stay valid until
+    // this returns.
+    bool run(const float* in, int n, std::vector<float>& out, std::vector<int64_t>& item_shape) {
+        out.clear();
+        if (!in || n <= 0) return false;
+        bool direct;
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            direct = clients_ <= 1;
+        }
+        if (direct) return runChunked(in, n, out, item_shape);
+
+        Req r{in, n, &out, &item_shape, {}};
+        auto fut = r.done.get_future();
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            q_.push_back(&r);
+            queuedItems_ += n;
+        }
+        cv_.notify_all();
+        return fut.get();
+    }
+
+    long runs() const { std::lock_guard<std::mutex> lk(m_); return runs_; }    // model calls
+    long items() const { std::lock_guard<std::mutex> lk(m_); return items_; }  // inputs processed
+
+private:
+    struct Req {
+        const float* in;
+        int n;
+        std::vector<float>* out;
+        std::vector<int64_t>* shape;
+        std::promise<bool> done;
+    };
+
+    // One model call per max_batch items.
+    bool runChunked(const float* in, int n, std::vector<float>& out,
+                    std::vector<int64_t>& item_shape) {
+        std::vector<float> part;
+        std::vector<int64_t> shape;
+        for (int off = 0; off < n; off += maxBatch_) {
+            const int k = std::min(maxBatch_, n - off);
+            if (!run_(in + static_cast<size_t>(off) * itemFloats_, k, part, shape)) return false;
+            if (off == 0) item_shape = shape;
+            else if (shape != item_shape) return false;
+            out.insert(out.end(), part.begin(), part.end());
+            std::lock_guard<std::mutex> lk(m_);
+            ++runs_;
+            items_ += k;
+        }
+        return true;
+    }
+
+    void loop() {
+        std::vector<float> staged;
+        std::vector<float> out;
+        std::vector<int64_t> shape;
+        while (true) {
+            std::vector<Req*> batch;
+            int n = 0;
+            {
+                std::unique_lock<std::mutex> lk(m_);
+                cv_.wait(lk, [&] { return stop_ || !q_.empty(); });
+                if (stop_ && q_.empty()) return;
+                // Linger while other attached callers may still submit this round.
+                if (maxWaitUs_ > 0)
+                    cv_.wait_for(lk, std::chrono::microseconds(maxWaitUs_), [&] {
+                        return stop_ || queuedItems_ >= maxBatch_ ||
+                               static_cast<int>(q_.size()) >= clients_;
+                    });
+                // Whole requests only; an oversized first request runs chunked.
+                while (!q_.empty() && (batch.empty() || n + q_.front()->n <= maxBatch_)) {
+                    n += q_.front()->n;
+                    queuedItems_ -= q_.front()->n;
+                    batch.push_back(q_.front());
+                    q_.pop_front();
+                }
+            }
+
+            const float* in = batch[0]->in;
+            if (batch.size() > 1) {
+                staged.resize(static_cast<size_t>(n) * itemFloats_);
+                float* dst = staged.data();
+                for (Req* r : batch) {
+                    const size_t len = static_cast<size_t>(r->n) * itemFloats_;
+                    std::memcpy(dst, r->in, len * sizeof(float));
+                    dst += len;
+                }
+                in = staged.data();
+            }
+
+            out.clear();
+            bool ok = false;
+            try {
+                ok = runChunked(in, n, out, shape);
+            } catch (...) {
+                ok = false;
+            }
+            size_t per = 1;
+            for (int64_t d : shape) per *= static_cast<size_t>(d);
+            ok = ok && !shape.empty() && out.size() == per * static_cast<size_t>(n);
+
+            size_t off = 0;
+            for (Req* r : batch) {
+                if (ok) {
+                    r->out->assign(out.begin() + off, out.begin() + off + per * r->n);
+                    *r->shape = shape;
+                    off += per * r->n;
+                }
+                r->done.set_value(ok);
+            }
+        }
+    }
+
+    const size_t itemFloats_;
+    const int maxBatch_;
+    const int maxWaitUs_;
+    RunFn run_;
+
+    mutable std::mutex m_;
+    std::condition_variable cv_;
+    std::deque<Req*> q_;
+    int queuedItems_ = 0;
+    int clients_ = 0;
+    bool stop_ = false;
+    long runs_ = 0;
+    long items_ = 0;
+    std::thread th_;
+};
+
+} // namespace zm::lpr
@@ -14,11 +14,30 @@
 // already de-duplicated. We reuse zm::detect::decode_nms_free for that.
 //
 // IMPORTANT (OCR export): the OCR model is expected to output a per-timestep
-// class-logit sequence of shape [1, T, C] (or [T, C]) where C = len(charset)+1,
-// the extra slot being the CTC blank. We greedy-CTC-decode it to a string.
+// class-logit sequence of shape [N, T, C] (or [T, C] for a single crop) where
+// C = len(charset)+1, the extra slot being the CTC blank. We greedy-CTC-decode
+// each crop to a string.
+//
+// Batching: all plate crops of a frame go to the OCR model in one Run. Models
+// with a dynamic batch dim are shared process-wide (one session per model/EP/
+// input shape) and concurrent frames from other lpr instances (cameras) are
+// coalesced into the same Run by a BatchQueue. Plates already read with high
+// confidence are not re-OCR'd: when the tracker runs, each plate is tied to the
+// tracked vehicle containing it and its read is cached per track_id (frames
+// whose tracked vehicles are all covered skip the plate detector too);
+// otherwise plates are followed by box overlap (PlateReadCache).
+//
+// Frames are wrapped and letterboxed for the detector by zm::hw::InferPipeline
+// on its CPU backend. Both stages stay on host memory: the BatchQueue coalesces
+// host inputs across cameras and the OCR crops are sub-pixel float boxes.
 
+#include "batch_queue.hpp"
 #include "lpr_decode.hpp"
+#include "plate_cache.hpp"
 #include "../detect_onnx/detect_postprocess.hpp"
+#include "../detect_onnx/infer_pipeline.hpp"
+#include "../detect_onnx/ort_model.hpp"   // open_session (shared model cache)
+#include "track_feed.hpp"
 
 #include <onnxruntime_cxx_api.h>
 #ifdef __APPLE__
@@ -28,7 +47,9 @@
 #include <nlohmann/json.hpp>
 
 #include <array>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <cstdint>
@@ -45,23 +66,28 @@ namespace {
 static const char* kDefaultCharset =
     "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
 
-struct LprCtx {
-    zm_host_api_t* host = nullptr;
-    void* hostCtx = nullptr;
-
-    // ONNX Runtime state shared between both sessions.
+// One loaded model plus the queue that batches calls into it. Shared between
+// lpr instances when the model has a dynamic batch dim and shared_session is on.
+struct LprModel {
     std::unique_ptr<Ort::Env> env;
     Ort::SessionOptions sessionOptions;
+    std::shared_ptr<const zm::io::MappedFile> mapping;  // outlives session
+    std::unique_ptr<Ort::Session> session;
+    zm::hw::ModelLoadStats stats;
+    std::string inputName;
+    std::string outputName;
+    std::array<int64_t, 3> itemDims{};  // C, H, W of one input
+    bool dynamicBatch = false;
+    std::unique_ptr<zm::lpr::BatchQueue> queue;  // declared last: stops first
+};
 
-    // Detector session.
-    std::unique_ptr<Ort::Session> detector;
-    std::string detInputName;
-    std::string detOutputName;
+struct LprCtx {
+    zm_host_api_t* host = nullptr;
+    void* hostCtx = nullptr;
 
-    // OCR session.
-    std::unique_ptr<Ort::Session> ocr;
-    std::string ocrInputName;
-    std::string ocrOutputName;
+    zm::hw::InferPipeline pipeline;   // host frames only (see header)
+    std::shared_ptr<LprModel> detector;
+    std::shared_ptr<LprModel> ocr;
 
     // Config.
     std::string detectorPath;
@@ -78,6 +104,28 @@ struct LprCtx {
     std::string ep = "cpu";
     std::vector<int> streamFilter;          // empty = all
     std::vector<std::string> watchlist;     // raw strings; normalized at compare time
+    bool sharedSession = true;
+    int sharedMaxBatch = 16;
+    int sharedMaxWaitUs = 2000;
+
+    // Plate read cache (cache_ttl_ms 0 = off).
+    int cacheTtlMs = 2000;
+    float cacheIou = 0.5f;
+    float cacheMinConf = 0.9f;
+    std::unique_ptr<zm::lpr::PlateReadCache> plateCache;
+
+    // Per-track read cache, fed by the tracker's tracked_detection events.
+    bool useTracks = true;
+    std::vector<std::string> trackLabels{"car", "truck", "bus", "motorcycle"};
+    uint64_t trackMaxAgeUs = 500000;
+    zm::track::TrackCacheOptions trackOptions;
+    zm::track::TrackFeed* tracks = nullptr;  // leaked on stop (see track_feed.hpp)
+    std::unique_ptr<zm::track::TrackResultCache<zm::lpr::PlateRead>> trackCache;
+
+    // Scratch reused across frames.
+    std::vector<float> detOutput;
+    std::vector<float> ocrInput;
+    std::vector<float> ocrOutput;
 
     bool warnedUnsupportedDetShape = false;
     bool warnedUnsupportedOcrShape = false;
@@ -89,28 +137,113 @@ void forwardFrame(LprCtx* ctx, const void* buf, size_t size) {
     }
 }
 
-// Build an ORT session for `path`, capturing its first input/output names.
-// Returns nullptr (and logs) on failure.
-std::unique_ptr<Ort::Session> makeSession(LprCtx* ctx, const std::string& path,
-                                          const char* tag,
-                                          std::string& inName, std::string& outName) {
-    if (path.empty() || !ctx->env) return nullptr;
+// One Run on `n` contiguous inputs (n > 1 only for dynamic-batch models).
+bool runModel(LprModel& m, const float* in, int n, std::vector<float>& out,
+              std::vector<int64_t>& itemShape) {
+    Ort::MemoryInfo memInfo =
+        Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+    const std::array<int64_t, 4> shape{n, m.itemDims[0], m.itemDims[1], m.itemDims[2]};
+    const size_t count = static_cast<size_t>(n) * m.itemDims[0] * m.itemDims[1] * m.itemDims[2];
+    Ort::Value tensor = Ort::Value::CreateTensor<float>(
+        memInfo, const_cast<float*>(in), count, shape.data(), shape.size());
+
+    const char* inputNames[] = {m.inputName.c_str()};
+    const char* outputNames[] = {m.outputName.c_str()};
+    auto outputs = m.session->Run(Ort::RunOptions{nullptr}, inputNames,
+                                  &tensor, 1, outputNames, 1);
+
+    auto info = outputs[0].GetTensorTypeAndShapeInfo();
+    // Both models produce a rank-2 result per item: [N,6] boxes or [T,C] logits.
+    if (!zm::lpr::batch_item_shape(info.GetShape(), n, 2, itemShape)) return false;
+    const float* data = outputs[0].GetTensorData<float>();
+    out.assign(data, data + info.GetElementCount());
+    return true;
+}
+
+// Load `path` for inputs of itemDims (C,H,W), or join the instance already
+// loaded in this process for the same model, EP and input shape.
+std::shared_ptr<LprModel> acquireModel(LprCtx* ctx, const std::string& path, const char* tag,
+                                       const std::array<int64_t, 3>& itemDims) {
+    if (path.empty()) return nullptr;
+
+    static std::mutex registryMutex;
+    static std::map<std::string, std::weak_ptr<LprModel>> registry;
+    const std::string key = path + "|" + ctx->ep + "|" + std::to_string(itemDims[0]) + "x" +
+                            std::to_string(itemDims[1]) + "x" + std::to_string(itemDims[2]);
+
+    std::lock_guard<std::mutex> lk(registryMutex);
+    if (ctx->sharedSession) {
+        if (auto existing = registry[key].lock()) {
+            existing->queue->attach();
+            ZM_LOG_INFO("lpr: sharing %s model '%s' with other instances", tag, path.c_str());
+            return existing;
+        }
+    }
+
+    auto m = std::make_shared<LprModel>();
     try {
-        auto session = std::make_unique<Ort::Session>(
-            *ctx->env, path.c_str(), ctx->sessionOptions);
+        m->env = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "lpr");
+        m->sessionOptions.SetIntraOpNumThreads(1);
+        m->sessionOptions.SetGraphOptimizationLevel(ORT_ENABLE_ALL);
+
+        // Optionally append the CoreML execution provider, falling back to CPU.
+        std::string activeEp = "cpu";
+        if (ctx->ep == "coreml") {
+#ifdef __APPLE__
+            try {
+                uint32_t coreml_flags = 0;
+                Ort::ThrowOnError(OrtSessionOptionsAppendExecutionProvider_CoreML(
+                    static_cast<OrtSessionOptions*>(m->sessionOptions), coreml_flags));
+                activeEp = "coreml";
+                ZM_LOG_INFO("lpr: CoreML execution provider enabled");
+            } catch (const std::exception& e) {
+                ZM_LOG_WARN("lpr: CoreML EP unavailable, falling back to CPU: %s", e.what());
+            }
+#else
+            ZM_LOG_WARN("lpr: CoreML EP not available on this platform, falling back to CPU");
+#endif
+        }
+
+        zm::hw::CachedSession cs =
+            zm::hw::open_session(*m->env, path, m->sessionOptions, activeEp);
+        m->mapping = std::move(cs.mapping);
+        m->session = std::move(cs.session);
+        m->stats = std::move(cs.stats);
         Ort::AllocatorWithDefaultOptions allocator;
-        auto in = session->GetInputNameAllocated(0, allocator);
-        auto out = session->GetOutputNameAllocated(0, allocator);
-        inName = in.get();
-        outName = out.get();
-        ZM_LOG_INFO("lpr: loaded %s model '%s' (input='%s' output='%s')",
-                    tag, path.c_str(), inName.c_str(), outName.c_str());
-        return session;
+        m->inputName = m->session->GetInputNameAllocated(0, allocator).get();
+        m->outputName = m->session->GetOutputNameAllocated(0, allocator).get();
+        const auto inShape =
+            m->session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+        m->dynamicBatch = !inShape.empty() && inShape[0] <= 0;
     } catch (const std::exception& e) {
         ZM_LOG_ERROR("lpr: failed to load %s model '%s': %s (pass-through)",
                      tag, path.c_str(), e.what());
         return nullptr;
     }
+    m->itemDims = itemDims;
+
+    // A fixed-batch model runs one input per Run; sharing it would only
+    // serialise the cameras, so it stays private to this instance.
+    const int maxBatch = m->dynamicBatch ? ctx->sharedMaxBatch : 1;
+    const size_t itemFloats = static_cast<size_t>(itemDims[0]) * itemDims[1] * itemDims[2];
+    LprModel* raw = m.get();
+    m->queue = std::make_unique<zm::lpr::BatchQueue>(
+        itemFloats, maxBatch, ctx->sharedMaxWaitUs,
+        [raw](const float* in, int n, std::vector<float>& out, std::vector<int64_t>& shape) {
+            return runModel(*raw, in, n, out, shape);
+        });
+    m->queue->attach();
+    if (ctx->sharedSession && m->dynamicBatch) registry[key] = m;
+
+    ZM_LOG_INFO("lpr: loaded %s model '%s' (input='%s' output='%s' batch=%s) %s",
+                tag, path.c_str(), m->inputName.c_str(), m->outputName.c_str(),
+                m->dynamicBatch ? "dynamic" : "fixed", m->stats.summary().c_str());
+    return m;
+}
+
+void releaseModel(std::shared_ptr<LprModel>& m) {
+    if (m) m->queue->detach();
+    m.reset();
 }
 
 } // namespace
@@ -144,41 +277,38 @@ static int lpr_start(zm_plugin_t* plugin, zm_host_api_t* host, void* host_ctx,
                 ctx->streamFilter = j["stream_filter"].get<std::vector<int>>();
             if (j.contains("watchlist") && j["watchlist"].is_array())
                 ctx->watchlist = j["watchlist"].get<std::vector<std::string>>();
+            ctx->sharedSession = j.value("shared_session", true);
+            ctx->sharedMaxBatch = std::max(1, j.value("shared_max_batch", 16));
+            ctx->sharedMaxWaitUs = std::max(0, j.value("shared_max_wait_us", 2000));
+            ctx->cacheTtlMs = std::max(0, j.value("cache_ttl_ms", 2000));
+            ctx->cacheIou = j.value("cache_iou", 0.5f);
+            ctx->cacheMinConf = j.value("cache_min_conf", 0.9f);
+            ctx->useTracks = j.value("use_tracks", true);
+            if (j.contains("track_labels") && j["track_labels"].is_array())
+                ctx->trackLabels = j["track_labels"].get<std::vector<std::string>>();
+            ctx->trackMaxAgeUs = static_cast<uint64_t>(std::max(0, j.value("track_max_age_ms", 500))) * 1000;
+            ctx->trackOptions.refresh_us = static_cast<uint64_t>(std::max(0, j.value("refresh_ms", 5000))) * 1000;
+            ctx->trackOptions.miss_retry_us = static_cast<uint64_t>(std::max(0, j.value("miss_retry_ms", 1000))) * 1000;
+            ctx->trackOptions.quality_gain = j.value("quality_gain", 1.25f);
         } catch (const std::exception& e) {
             ZM_LOG_ERROR("lpr: failed to parse config: %s", e.what());
         }
     }
+    if (ctx->cacheTtlMs > 0)
+        ctx->plateCache = std::make_unique<zm::lpr::PlateReadCache>(
+            ctx->cacheIou, ctx->cacheMinConf, static_cast<uint64_t>(ctx->cacheTtlMs) * 1000);
 
-    // Create the ONNX Runtime environment and session options.
-    try {
-        ctx->env = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "lpr");
-        ctx->sessionOptions.SetIntraOpNumThreads(1);
-        ctx->sessionOptions.SetGraphOptimizationLevel(ORT_ENABLE_ALL);
-    } catch (const std::exception& e) {
-        ZM_LOG_ERROR("lpr: failed to init ORT env: %s", e.what());
+    if (ctx->useTracks) {
+        ctx->tracks = zm::track::subscribe_tracks(host, host_ctx, ctx->trackLabels);
+        ctx->trackCache = std::make_unique<zm::track::TrackResultCache<zm::lpr::PlateRead>>(ctx->trackOptions);
     }
 
-    // Optionally append the CoreML execution provider, falling back to CPU.
-    if (ctx->ep == "coreml") {
-#ifdef __APPLE__
-        try {
-            uint32_t coreml_flags = 0;
-            Ort::ThrowOnError(OrtSessionOptionsAppendExecutionProvider_CoreML(
-                static_cast<OrtSessionOptions*>(ctx->sessionOptions), coreml_flags));
-            ZM_LOG_INFO("lpr: CoreML execution provider enabled");
-        } catch (const std::exception& e) {
-            ZM_LOG_WARN("lpr: CoreML EP unavailable, falling back to CPU: %s", e.what());
-        }
-#else
-        ZM_LOG_WARN("lpr: CoreML EP not available on this platform, falling back to CPU");
-#endif
-    }
+    ctx->pipeline.open("cpu");
 
-    // Construct both sessions; either missing -> pass-through.
-    ctx->detector = makeSession(ctx, ctx->detectorPath, "detector",
-                                ctx->detInputName, ctx->detOutputName);
-    ctx->ocr = makeSession(ctx, ctx->ocrPath, "ocr",
-                           ctx->ocrInputName, ctx->ocrOutputName);
+    // Load (or join) both models; either missing -> pass-through.
+    ctx->detector = acquireModel(ctx, ctx->detectorPath, "detector", {3, ctx->net, ctx->net});
+    ctx->ocr = acquireModel(ctx, ctx->ocrPath, "ocr",
+                            {ctx->ocrGrayscale ? 1 : 3, ctx->ocrHeight, ctx->ocrWidth});
 
     if (!ctx->detector || !ctx->ocr) {
         ZM_LOG_WARN("lpr: detector and/or OCR model not loaded; running as pass-through");
@@ -191,61 +321,178 @@ static int lpr_start(zm_plugin_t* plugin, zm_host_api_t* host, void* host_ctx,
 static void lpr_stop(zm_plugin_t* plugin) {
     auto* ctx = static_cast<LprCtx*>(plugin->instance);
     if (ctx) {
+        zm::track::unsubscribe_tracks(ctx->host, ctx->hostCtx, ctx->tracks);
+        releaseModel(ctx->detector);
+        releaseModel(ctx->ocr);
         delete ctx;
         plugin->instance = nullptr;
     }
 }
 
-// Run the OCR session on a single plate crop and return the decoded text.
-// `confidenceOut` receives an approximate mean per-timestep confidence.
-static std::string runOcr(LprCtx* ctx, const uint8_t* rgb, int w, int h,
-                          const zm::detect::Box& box, float& confidenceOut) {
-    confidenceOut = 0.0f;
+// Crop and resize every box into one contiguous [n, C, ocrHeight, ocrWidth]
+// batch, OCR it in a single Run and decode each crop. `texts`/`confs` are
+// parallel to `boxes`; an empty text means nothing was read.
+static bool runOcrBatch(LprCtx* ctx, const uint8_t* rgb, int w, int h,
+                        const std::vector<zm::detect::Box>& boxes,
+                        std::vector<std::string>& texts, std::vector<float>& confs) {
+    const int n = static_cast<int>(boxes.size());
+    texts.assign(n, std::string());
+    confs.assign(n, 0.0f);
+    if (n == 0) return true;
+
     const int channels = ctx->ocrGrayscale ? 1 : 3;
-    std::vector<float> input(static_cast<size_t>(channels) * ctx->ocrHeight * ctx->ocrWidth);
-    if (ctx->ocrGrayscale) {
-        zm::lpr::crop_resize_gray(rgb, w, h, box.x, box.y, box.w, box.h,
-                                  ctx->ocrWidth, ctx->ocrHeight, input.data());
-    } else {
-        zm::lpr::crop_resize_rgb(rgb, w, h, box.x, box.y, box.w, box.h,
-                                 ctx->ocrWidth, ctx->ocrHeight, input.data());
+    const size_t per = static_cast<size_t>(channels) * ctx->ocrHeight * ctx->ocrWidth;
+    ctx->ocrInput.resize(per * n);
+    for (int i = 0; i < n; ++i) {
+        const auto& box = boxes[i];
+        float* dst = ctx->ocrInput.data() + per * i;
+        if (ctx->ocrGrayscale) {
+            zm::lpr::crop_resize_gray(rgb, w, h, box.x, box.y, box.w, box.h,
+                                      ctx->ocrWidth, ctx->ocrHeight, dst);
+        } else {
+            zm::lpr::crop_resize_rgb(rgb, w, h, box.x, box.y, box.w, box.h,
+                                     ctx->ocrWidth, ctx->ocrHeight, dst);
+        }
     }
 
-    Ort::MemoryInfo memInfo =
-        Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
-    std::array<int64_t, 4> inputShape{1, channels, ctx->ocrHeight, ctx->ocrWidth};
-    Ort::Value inputTensor = Ort::Value::CreateTensor<float>(
-        memInfo, input.data(), input.size(), inputShape.data(), inputShape.size());
-
-    const char* inputNames[] = {ctx->ocrInputName.c_str()};
-    const char* outputNames[] = {ctx->ocrOutputName.c_str()};
-
-    auto outputs = ctx->ocr->Run(Ort::RunOptions{nullptr}, inputNames,
-                                 &inputTensor, 1, outputNames, 1);
-
-    const float* out = outputs[0].GetTensorData<float>();
-    auto shape = outputs[0].GetTensorTypeAndShapeInfo().GetShape();
-
-    // Accept [1, T, C] or [T, C].
-    int T = 0, C = 0;
-    if (shape.size() == 3) {
-        T = static_cast<int>(shape[1]);
-        C = static_cast<int>(shape[2]);
-    } else if (shape.size() == 2) {
-        T = static_cast<int>(shape[0]);
-        C = static_cast<int>(shape[1]);
-    } else {
+    std::vector<int64_t> itemShape;
+    if (!ctx->ocr->queue->run(ctx->ocrInput.data(), n, ctx->ocrOutput, itemShape)) {
         if (!ctx->warnedUnsupportedOcrShape) {
-            ZM_LOG_WARN("lpr: unsupported OCR output shape; expected [1,T,C] or [T,C]");
+            ZM_LOG_WARN("lpr: OCR run failed or unsupported output shape; expected [N,T,C] or [T,C]");
             ctx->warnedUnsupportedOcrShape = true;
         }
-        return std::string();
+        return false;
     }
-    if (T <= 0 || C <= 0) return std::string();
-
+    const int T = static_cast<int>(itemShape[0]);
+    const int C = static_cast<int>(itemShape[1]);
     const int blank = (ctx->ctcBlank >= 0) ? ctx->ctcBlank : (C - 1);
-    confidenceOut = zm::lpr::ctc_mean_confidence(out, T, C);
-    return zm::lpr::ctc_greedy_decode(out, T, C, ctx->charset, blank);
+    for (int i = 0; i < n; ++i) {
+        const float* out = ctx->ocrOutput.data() + static_cast<size_t>(i) * T * C;
+        confs[i] = zm::lpr::ctc_mean_confidence(out, T, C);
+        texts[i] = zm::lpr::ctc_greedy_decode(out, T, C, ctx->charset, blank);
+    }
+    return true;
+}
+
+static void addPlate(LprCtx* ctx, json& plates, const std::string& text, float conf,
+                     float bx, float by, float bw, float bh, int trackId, bool cached) {
+    json p;
+    p["text"] = text;
+    p["confidence"] = conf;
+    p["bbox"] = {bx, by, bw, bh};
+    p["watchlisted"] = zm::lpr::watchlisted(ctx->watchlist, text);
+    if (trackId > 0) p["track_id"] = trackId;
+    if (cached) p["cached"] = true;
+    plates.push_back(std::move(p));
+}
+
+// Detect plates on the frame, reuse cached reads (per track, else by box
+// overlap) and OCR the rest in one batch, appending to `plates`. Returns false
+// if the detector output is unusable.
+static bool detectAndRead(LprCtx* ctx, const zm_frame_hdr_t* hdr,
+                          const zm::hw::Surface& surface,
+                          const std::vector<zm::track::TrackBox>& tracks,
+                          bool haveTracks, json& plates) {
+    auto* trackCache = ctx->trackCache.get();
+    const uint8_t* payload = zm::hw::InferPipeline::host_rgb(surface);
+    const int w = surface.width;
+    const int h = surface.height;
+
+    // Stage 1: plate detection.
+    zm::hw::TensorSpec spec;
+    spec.width = spec.height = ctx->net;
+    const zm::hw::BatchTensor input = ctx->pipeline.preprocess(surface, {}, spec);
+    if (!input.valid()) return false;
+    const zm::detect::Letterbox& lb = input.lb[0];
+
+    std::vector<int64_t> dshape;
+    if (!ctx->detector->queue->run(input.data, 1, ctx->detOutput, dshape) ||
+        dshape[1] != 6) {
+        if (!ctx->warnedUnsupportedDetShape) {
+            ZM_LOG_WARN("lpr: unsupported detector output shape; only NMS-free [1,N,6] supported");
+            ctx->warnedUnsupportedDetShape = true;
+        }
+        return false;
+    }
+    const int num = static_cast<int>(dshape[0]);
+
+    std::vector<zm::detect::Box> plateBoxes =
+        zm::detect::decode_nms_free(ctx->detOutput.data(), num, lb, ctx->confThreshold, {});
+
+    // Stage 2: reuse cached reads (per track, else by box overlap), OCR the
+    // rest in one batch.
+    auto* cache = ctx->plateCache.get();
+    if (cache) cache->expire(hdr->stream_id, hdr->pts_usec);
+    const size_t n = plateBoxes.size();
+    std::vector<zm::lpr::PlateRead> reads(n);
+    std::vector<bool> cached(n, false);
+    std::vector<int> trackOf(n, -1);
+    std::vector<float> quality(n, 0.0f);
+    std::vector<bool> trackSeen(tracks.size(), false);
+    std::vector<zm::detect::Box> toRead;
+    if (haveTracks) {
+        // One plate per tracked vehicle: a second plate inside the same box is
+        // always read, never served that track's cached text.
+        std::vector<zm::track::DetBox> dets(n);
+        for (size_t i = 0; i < n; ++i) {
+            const auto& box = plateBoxes[i];
+            quality[i] = zm::track::box_quality(
+                box.confidence, box.w, box.h,
+                zm::track::region_sharpness(payload, w, h, box.x, box.y, box.w, box.h));
+            dets[i] = {box.x, box.y, box.w, box.h, quality[i]};
+        }
+        trackOf = zm::track::associate(tracks, dets);
+        for (int ti : trackOf)
+            if (ti >= 0) trackSeen[ti] = true;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        const auto& box = plateBoxes[i];
+        const int trackId = trackOf[i] >= 0 ? tracks[trackOf[i]].id : 0;
+        if (trackId > 0) {
+            if (!trackCache->needs_run(hdr->stream_id, trackId, quality[i], hdr->pts_usec)) {
+                reads[i] = trackCache->find(hdr->stream_id, trackId)->result;
+                cached[i] = true;
+                trackCache->hit(hdr->stream_id, trackId, hdr->pts_usec,
+                                zm::track::to_relative(tracks[trackOf[i]], box.x, box.y,
+                                                       box.w, box.h));
+            }
+        } else if (cache) {
+            cached[i] = cache->lookup(hdr->stream_id, {box.x, box.y, box.w, box.h},
+                                      hdr->pts_usec, reads[i]);
+        }
+        if (!cached[i]) toRead.push_back(box);
+    }
+    for (size_t i = 0; i < tracks.size(); ++i)
+        if (!trackSeen[i]) trackCache->miss(hdr->stream_id, tracks[i].id, hdr->pts_usec);
+
+    std::vector<std::string> texts;
+    std::vector<float> confs;
+    runOcrBatch(ctx, payload, w, h, toRead, texts, confs);
+
+    size_t next = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const auto& box = plateBoxes[i];
+        const int trackId = trackOf[i] >= 0 ? tracks[trackOf[i]].id : 0;
+        if (!cached[i]) {
+            const size_t k = next++;
+            if (k >= texts.size() || texts[k].empty()) continue;
+            reads[i] = {zm::lpr::normalize_plate(texts[k]), confs[k]};
+            if (trackId > 0) {
+                // Only confident reads are kept; weaker ones are retried.
+                if (reads[i].confidence >= ctx->cacheMinConf)
+                    trackCache->store(hdr->stream_id, trackId, hdr->pts_usec, quality[i],
+                                      reads[i],
+                                      zm::track::to_relative(tracks[trackOf[i]], box.x,
+                                                             box.y, box.w, box.h));
+            } else if (cache) {
+                cache->store(hdr->stream_id, {box.x, box.y, box.w, box.h}, hdr->pts_usec,
+                             reads[i]);
+            }
+        }
+        addPlate(ctx, plates, reads[i].text, reads[i].confidence, box.x, box.y, box.w, box.h,
+                 trackId, cached[i]);
+    }
+    return true;
 }
 
 static void lpr_on_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
@@ -256,10 +503,9 @@ static void lpr_on_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
     }
 
     const zm_frame_hdr_t* hdr = static_cast<const zm_frame_hdr_t*>(buf);
-    const uint8_t* payload = static_cast<const uint8_t*>(buf) + sizeof(zm_frame_hdr_t);
 
     // Pass-through when we cannot or should not run inference.
-    if (!ctx->detector || !ctx->ocr || hdr->hw_type != ZM_FRAME_RGB24) {
+    if (!ctx->detector || !ctx->ocr) {
         forwardFrame(ctx, buf, size);
         return;
     }
@@ -270,65 +516,38 @@ static void lpr_on_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
         return;
     }
 
-    const int w = ctx->frameWidth;
-    const int h = ctx->frameHeight;
-    if (w <= 0 || h <= 0 ||
-        size < sizeof(zm_frame_hdr_t) + static_cast<size_t>(w) * h * 3) {
+    // Host RGB24 only: the pipeline has no device backend here.
+    zm::hw::Surface surface;
+    if (!ctx->pipeline.acquire(buf, size, ctx->frameWidth, ctx->frameHeight, surface)) {
         forwardFrame(ctx, buf, size);
         return;
     }
 
+    // Tracked vehicles in view (only when the tracker is feeding this stream).
+    std::vector<zm::track::TrackBox> tracks;
+    auto* trackCache = ctx->trackCache.get();
+    const bool haveTracks =
+        trackCache && ctx->tracks &&
+        ctx->tracks->index.latest(hdr->stream_id, hdr->pts_usec, ctx->trackMaxAgeUs, tracks);
+    if (haveTracks) trackCache->expire(hdr->stream_id, hdr->pts_usec);
+
     try {
-        // Stage 1: plate detection.
-        const int net = ctx->net;
-        zm::detect::Letterbox lb = zm::detect::compute_letterbox(w, h, net);
-
-        std::vector<float> detInput(static_cast<size_t>(3) * net * net);
-        zm::detect::letterbox_rgb_to_chw(payload, lb, detInput.data());
-
-        Ort::MemoryInfo memInfo =
-            Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
-        std::array<int64_t, 4> detShape{1, 3, net, net};
-        Ort::Value detTensor = Ort::Value::CreateTensor<float>(
-            memInfo, detInput.data(), detInput.size(), detShape.data(), detShape.size());
-
-        const char* detIn[] = {ctx->detInputName.c_str()};
-        const char* detOut[] = {ctx->detOutputName.c_str()};
-        auto detOutputs = ctx->detector->Run(Ort::RunOptions{nullptr}, detIn,
-                                             &detTensor, 1, detOut, 1);
-
-        const float* dout = detOutputs[0].GetTensorData<float>();
-        auto dshape = detOutputs[0].GetTensorTypeAndShapeInfo().GetShape();
-        const int64_t lastDim = dshape.empty() ? 0 : dshape.back();
-        if (lastDim != 6) {
-            if (!ctx->warnedUnsupportedDetShape) {
-                ZM_LOG_WARN("lpr: unsupported detector output shape; only NMS-free [1,N,6] supported");
-                ctx->warnedUnsupportedDetShape = true;
+        json plates = json::array();
+
+        if (haveTracks && trackCache->covers(hdr->stream_id, tracks, hdr->pts_usec)) {
+            // Every tracked vehicle already has a fresh confident read (or
+            // recently showed no plate): skip detection, republish the reads.
+            for (const auto& t : tracks) {
+                const auto* e = trackCache->find(hdr->stream_id, t.id);
+                if (!e || e->missed) continue;
+                float bx, by, bw, bh;
+                zm::track::from_relative(t, e->rel, bx, by, bw, bh);
+                addPlate(ctx, plates, e->result.text, e->result.confidence, bx, by, bw, bh, t.id, true);
             }
+        } else if (!detectAndRead(ctx, hdr, surface, tracks, haveTracks, plates)) {
             forwardFrame(ctx, buf, size);
             return;
         }
-        int num = 0;
-        if (dshape.size() == 3)      num = static_cast<int>(dshape[1]);
-        else if (dshape.size() == 2) num = static_cast<int>(dshape[0]);
-
-        std::vector<zm::detect::Box> plateBoxes =
-            zm::detect::decode_nms_free(dout, num, lb, ctx->confThreshold, {});
-
-        // Stage 2: OCR each plate box.
-        json plates = json::array();
-        for (const auto& box : plateBoxes) {
-            float ocrConf = 0.0f;
-            std::string text = runOcr(ctx, payload, w, h, box, ocrConf);
-            if (text.empty()) continue;
-            const std::string norm = zm::lpr::normalize_plate(text);
-            json p;
-            p["text"] = norm;
-            p["confidence"] = ocrConf;
-            p["bbox"] = {box.x, box.y, box.w, box.h};
-            p["watchlisted"] = zm::lpr::watchlisted(ctx->watchlist, norm);
-            plates.push_back(std::move(p));
-        }
 
         if (!plates.empty()) {
             json evt;
@@ -92,6 +92,89 @@ inline bool watchlisted(const std::vector<std::string>& list, const std::string&
     return false;
 }
 
+namespace detail {
+
+// Bilinear sampling taps for one axis of a crop [origin, origin+extent) of a
+// source axis of `src_n` pixels resampled to `dst_n` outputs.
+struct AxisTaps {
+    std::vector<int> i0, i1;
+    std::vector<float> w;
+};
+
+inline void axis_taps(float origin, float extent, int src_n, int dst_n, AxisTaps& t) {
+    t.i0.resize(dst_n);
+    t.i1.resize(dst_n);
+    t.w.resize(dst_n);
+    for (int d = 0; d < dst_n; ++d) {
+        const float f = (d + 0.5f) / dst_n * extent + origin - 0.5f;
+        const float fl = std::floor(f);
+        t.i0[d] = std::clamp(static_cast<int>(fl), 0, src_n - 1);
+        t.i1[d] = std::min(t.i0[d] + 1, src_n - 1);
+        t.w[d] = f - fl;
+    }
+}
+
+// Horizontal pass for one source row: three planar channel rows of dst_w.
+inline void resample_row_rgb(const uint8_t* row, const AxisTaps& tx, int dst_w, float* out) {
+    float* r = out;
+    float* g = out + dst_w;
+    float* b = out + 2 * dst_w;
+    for (int dx = 0; dx < dst_w; ++dx) {
+        const uint8_t* p0 = row + tx.i0[dx] * 3;
+        const uint8_t* p1 = row + tx.i1[dx] * 3;
+        const float wx = tx.w[dx];
+        r[dx] = p0[0] + (static_cast<float>(p1[0]) - p0[0]) * wx;
+        g[dx] = p0[1] + (static_cast<float>(p1[1]) - p0[1]) * wx;
+        b[dx] = p0[2] + (static_cast<float>(p1[2]) - p0[2]) * wx;
+    }
+}
+
+// Separable bilinear crop+resize into three planar float rows per output row.
+// The per-column taps are computed once per call and each source row is
+// horizontally resampled at most once (adjacent output rows usually share it);
+// the vertical blend and store are unit-stride loops the compiler vectorises.
+template <typename Emit>
+inline void crop_resize_planar(const uint8_t* src, int src_w, int src_h,
+                               float sx, float sy, float sw, float sh,
+                               int dst_w, int dst_h, Emit&& emit) {
+    // Clamp crop rectangle to source bounds.
+    const float x0 = std::clamp(sx, 0.0f, static_cast<float>(src_w));
+    const float y0 = std::clamp(sy, 0.0f, static_cast<float>(src_h));
+    const float x1 = std::clamp(sx + sw, 0.0f, static_cast<float>(src_w));
+    const float y1 = std::clamp(sy + sh, 0.0f, static_cast<float>(src_h));
+    AxisTaps tx, ty;
+    axis_taps(x0, std::max(1.0f, x1 - x0), src_w, dst_w, tx);
+    axis_taps(y0, std::max(1.0f, y1 - y0), src_h, dst_h, ty);
+
+    const size_t row_floats = static_cast<size_t>(3) * dst_w;
+    std::vector<float> rows(2 * row_floats);
+    float* top = rows.data();
+    float* bot = rows.data() + row_floats;
+    int top_y = -1, bot_y = -1;
+    std::vector<float> blended(row_floats);
+    for (int dy = 0; dy < dst_h; ++dy) {
+        const int want_top = ty.i0[dy], want_bot = ty.i1[dy];
+        if (want_top == bot_y) {  // moved down one source row: reuse it
+            std::swap(top, bot);
+            std::swap(top_y, bot_y);
+        }
+        if (top_y != want_top) {
+            resample_row_rgb(src + static_cast<size_t>(want_top) * src_w * 3, tx, dst_w, top);
+            top_y = want_top;
+        }
+        if (bot_y != want_bot) {
+            resample_row_rgb(src + static_cast<size_t>(want_bot) * src_w * 3, tx, dst_w, bot);
+            bot_y = want_bot;
+        }
+        const float wy = ty.w[dy];
+        for (size_t i = 0; i < row_floats; ++i)
+            blended[i] = top[i] + (bot[i] - top[i]) * wy;
+        emit(dy, blended.data());
+    }
+}
+
+}  // namespace detail
+
 // Crop a rectangular region [sx,sy,sw,sh] (source pixels) from an interleaved
 // RGB24 source image (src_w x src_h) and bilinearly resize it into a normalized
 // CHW float buffer of size 3*dst_h*dst_w (planar R,G,B), values /255. `dst` must
@@ -100,37 +183,15 @@ inline void crop_resize_rgb(const uint8_t* src, int src_w, int src_h,
                             float sx, float sy, float sw, float sh,
                             int dst_w, int dst_h, float* dst) {
     if (!src || !dst || src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0) return;
-    // Clamp crop rectangle to source bounds.
-    float x0 = std::clamp(sx, 0.0f, static_cast<float>(src_w));
-    float y0 = std::clamp(sy, 0.0f, static_cast<float>(src_h));
-    float x1 = std::clamp(sx + sw, 0.0f, static_cast<float>(src_w));
-    float y1 = std::clamp(sy + sh, 0.0f, static_cast<float>(src_h));
-    float cw = std::max(1.0f, x1 - x0);
-    float ch = std::max(1.0f, y1 - y0);
-
     const int plane = dst_w * dst_h;
-    for (int dy = 0; dy < dst_h; ++dy) {
-        // Map dst row -> source y inside the crop.
-        const float fy = (dy + 0.5f) / dst_h * ch + y0 - 0.5f;
-        const int iy0 = std::clamp(static_cast<int>(std::floor(fy)), 0, src_h - 1);
-        const int iy1 = std::min(iy0 + 1, src_h - 1);
-        const float wy = fy - std::floor(fy);
-        for (int dx = 0; dx < dst_w; ++dx) {
-            const float fx = (dx + 0.5f) / dst_w * cw + x0 - 0.5f;
-            const int ix0 = std::clamp(static_cast<int>(std::floor(fx)), 0, src_w - 1);
-            const int ix1 = std::min(ix0 + 1, src_w - 1);
-            const float wx = fx - std::floor(fx);
-            for (int c = 0; c < 3; ++c) {
-                const float p00 = src[(iy0 * src_w + ix0) * 3 + c];
-                const float p01 = src[(iy0 * src_w + ix1) * 3 + c];
-                const float p10 = src[(iy1 * src_w + ix0) * 3 + c];
-                const float p11 = src[(iy1 * src_w + ix1) * 3 + c];
-                const float top = p00 + (p01 - p00) * wx;
-                const float bot = p10 + (p11 - p10) * wx;
-                dst[c * plane + dy * dst_w + dx] = (top + (bot - top) * wy) / 255.0f;
-            }
+    detail::crop_resize_planar(src, src_w, src_h, sx, sy, sw, sh, dst_w, dst_h,
+                               [&](int dy, const float* rgb) {
+        for (int c = 0; c < 3; ++c) {
+            const float* in = rgb + c * dst_w;
+            float* out = dst + c * plane + dy * dst_w;
+            for (int dx = 0; dx < dst_w; ++dx) out[dx] = in[dx] / 255.0f;
         }
-    }
+    });
 }
 
 // Grayscale variant of crop_resize_rgb: output is a single-channel CHW buffer of
@@ -140,38 +201,15 @@ inline void crop_resize_gray(const uint8_t* src, int src_w, int src_h,
                              float sx, float sy, float sw, float sh,
                              int dst_w, int dst_h, float* dst) {
     if (!src || !dst || src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0) return;
-    float x0 = std::clamp(sx, 0.0f, static_cast<float>(src_w));
-    float y0 = std::clamp(sy, 0.0f, static_cast<float>(src_h));
-    float x1 = std::clamp(sx + sw, 0.0f, static_cast<float>(src_w));
-    float y1 = std::clamp(sy + sh, 0.0f, static_cast<float>(src_h));
-    float cw = std::max(1.0f, x1 - x0);
-    float ch = std::max(1.0f, y1 - y0);
-
-    for (int dy = 0; dy < dst_h; ++dy) {
-        const float fy = (dy + 0.5f) / dst_h * ch + y0 - 0.5f;
-        const int iy0 = std::clamp(static_cast<int>(std::floor(fy)), 0, src_h - 1);
-        const int iy1 = std::min(iy0 + 1, src_h - 1);
-        const float wy = fy - std::floor(fy);
-        for (int dx = 0; dx < dst_w; ++dx) {
-            const float fx = (dx + 0.5f) / dst_w * cw + x0 - 0.5f;
-            const int ix0 = std::clamp(static_cast<int>(std::floor(fx)), 0, src_w - 1);
-            const int ix1 = std::min(ix0 + 1, src_w - 1);
-            const float wx = fx - std::floor(fx);
-            float gray = 0.0f;
-            // Rec.601 luma weights.
-            static const float kW[3] = {0.299f, 0.587f, 0.114f};
-            for (int c = 0; c < 3; ++c) {
-                const float p00 = src[(iy0 * src_w + ix0) * 3 + c];
-                const float p01 = src[(iy0 * src_w + ix1) * 3 + c];
-                const float p10 = src[(iy1 * src_w + ix0) * 3 + c];
-                const float p11 = src[(iy1 * src_w + ix1) * 3 + c];
-                const float top = p00 + (p01 - p00) * wx;
-                const float bot = p10 + (p11 - p10) * wx;
-                gray += kW[c] * (top + (bot - top) * wy);
-            }
-            dst[dy * dst_w + dx] = gray / 255.0f;
-        }
-    }
+    detail::crop_resize_planar(src, src_w, src_h, sx, sy, sw, sh, dst_w, dst_h,
+                               [&](int dy, const float* rgb) {
+        const float* r = rgb;
+        const float* g = rgb + dst_w;
+        const float* b = rgb + 2 * dst_w;
+        float* out = dst + dy * dst_w;
+        for (int dx = 0; dx < dst_w; ++dx)
+            out[dx] = (0.299f * r[dx] + 0.587f * g[dx] + 0.114f * b[dx]) / 255.0f;
+    });
 }
 
 } // namespace zm::lpr
@@ -0,0 +1,120 @@
+#pragma once
+
+// Per-stream cache of recent plate reads, so a plate that stays in view (a car
+// waiting at a gate) is OCR'd once and then followed by box overlap instead of
+// being re-read every frame. Pure C++ (no ORT) for unit testing.
+//
+// A detection reuses a cached read when its box overlaps the cached plate's
+// last box by at least `min_iou`, the read's confidence is at least `min_conf`
+// and the read is younger than `ttl_usec`. Low-confidence reads are stored too
+// but never reused, so the plate is re-read until a confident read is made;
+// the TTL bounds how long a read is trusted before it is refreshed.
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace zm::lpr {
+
+struct PlateBox {
+    float x = 0.f, y = 0.f, w = 0.f, h = 0.f;
+};
+
+inline float plate_iou(const PlateBox& a, const PlateBox& b) {
+    const float ix = std::max(0.f, std::min(a.x + a.w, b.x + b.w) - std::max(a.x, b.x));
+    const float iy = std::max(0.f, std::min(a.y + a.h, b.y + b.h) - std::max(a.y, b.y));
+    const float inter = ix * iy;
+    const float uni = a.w * a.h + b.w * b.h - inter;
+    return uni > 0.f ? inter / uni : 0.f;
+}
+
+struct PlateRead {
+    std::string text;        // normalized plate text
+    float confidence = 0.f;
+};
+
+class PlateReadCache {
+public:
+    PlateReadCache(float min_iou, float min_conf, uint64_t ttl_usec)
+        : minIou_(min_iou), minConf_(min_conf), ttlUs_(ttl_usec) {}
+
+    bool enabled() const { return ttlUs_ > 0; }
+
+    // Drop entries of `stream` not seen within the TTL. A pts that goes
+    // backwards (stream restart) clears the stream.
+    void expire(uint32_t stream, uint64_t pts) {
+        auto it = streams_.find(stream);
+        if (it == streams_.end()) return;
+        auto& entries = it->second;
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const Entry& e) {
+                          return pts < e.seenPts || pts - e.seenPts > ttlUs_;
+                      }),
+                      entries.end());
+    }
+
+    // Copy a reusable read for `box` at `pts` into `out`; follows the plate by
+    // updating the cached box. Returns false when the plate should be (re-)read.
+    bool lookup(uint32_t stream, const PlateBox& box, uint64_t pts, PlateRead& out) {
+        if (!enabled()) return false;
+        Entry* e = match(stream, box);
+        if (!e) return false;
+        e->box = box;
+        e->seenPts = std::max(e->seenPts, pts);
+        if (e->read.confidence < minConf_ || pts < e->readPts || pts - e->readPts > ttlUs_)
+            return false;
+        out = e->read;
+        return true;
+    }
+
+    // Record a fresh read of `box`, replacing the overlapping entry if any.
+    void store(uint32_t stream, const PlateBox& box, uint64_t pts, PlateRead read) {
+        if (!enabled()) return;
+        Entry* e = match(stream, box);
+        if (!e) {
+            auto& entries = streams_[stream];
+            entries.emplace_back();
+            e = &entries.back();
+        }
+        e->box = box;
+        e->read = std::move(read);
+        e->readPts = pts;
+        e->seenPts = pts;
+    }
+
+    size_t size(uint32_t stream) const {
+        auto it = streams_.find(stream);
+        return it == streams_.end() ? 0 : it->second.size();
+    }
+
+private:
+    struct Entry {
+        PlateBox box;
+        PlateRead read;
+        uint64_t readPts = 0;   // when the text was read
+        uint64_t seenPts = 0;   // when the plate was last matched
+    };
+
+    Entry* match(uint32_t stream, const PlateBox& box) {
+        auto it = streams_.find(stream);
+        if (it == streams_.end()) return nullptr;
+        Entry* best = nullptr;
+        float bestIou = minIou_;
+        for (auto& e : it->second) {
+            const float iou = plate_iou(e.box, box);
+            if (iou >= bestIou) {
+                bestIou = iou;
+                best = &e;
+            }
+        }
+        return best;
+    }
+
+    float minIou_;
+    float minConf_;
+    uint64_t ttlUs_;
+    std::unordered_map<uint32_t, std::vector<Entry>> streams_;
+};
+
+} // namespace zm::lpr
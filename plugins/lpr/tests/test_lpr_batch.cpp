@@ -0,0 +1,153 @@
+// Unit tests for LPR's cross-instance batching and plate read cache (no ONNX
+// Runtime required: the model is a plain function).
+
+#include "../batch_queue.hpp"
+#include "../plate_cache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace zm::lpr;
+
+namespace {
+// Fake model: item_floats inputs -> [1, 2] outputs {sum, n}.
+BatchQueue::RunFn sumModel(size_t itemFloats, std::vector<int>* batchSizes, std::mutex* mu) {
+    return [=](const float* in, int n, std::vector<float>& out, std::vector<int64_t>& shape) {
+        {
+            std::lock_guard<std::mutex> lk(*mu);
+            batchSizes->push_back(n);
+        }
+        out.clear();
+        for (int i = 0; i < n; ++i) {
+            float s = 0.0f;
+            for (size_t k = 0; k < itemFloats; ++k) s += in[i * itemFloats + k];
+            out.push_back(s);
+            out.push_back(static_cast<float>(n));
+        }
+        shape = {1, 2};
+        return true;
+    };
+}
+}  // namespace
+
+TEST(BatchItemShape, SplitsBatchDim) {
+    std::vector<int64_t> item;
+    EXPECT_TRUE(batch_item_shape({4, 25, 37}, 4, 2, item));
+    EXPECT_EQ(item, (std::vector<int64_t>{25, 37}));
+    EXPECT_TRUE(batch_item_shape({25, 37}, 1, 2, item));   // single item without batch dim
+    EXPECT_EQ(item, (std::vector<int64_t>{25, 37}));
+    EXPECT_FALSE(batch_item_shape({1, 25, 37}, 4, 2, item));  // model ignored the batch
+    EXPECT_FALSE(batch_item_shape({25, 37}, 2, 2, item));
+    EXPECT_FALSE(batch_item_shape({2, 0, 6}, 2, 2, item));
+}
+
+TEST(BatchQueue, SingleClientRunsDirectlyInChunks) {
+    std::vector<int> sizes;
+    std::mutex mu;
+    BatchQueue q(2, 3, 2000, sumModel(2, &sizes, &mu));
+    q.attach();
+    const std::vector<float> in = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};  // 5 items
+    std::vector<float> out;
+    std::vector<int64_t> shape;
+    ASSERT_TRUE(q.run(in.data(), 5, out, shape));
+    EXPECT_EQ(sizes, (std::vector<int>{3, 2}));
+    ASSERT_EQ(out.size(), 10u);
+    EXPECT_FLOAT_EQ(out[0], 3.0f);
+    EXPECT_FLOAT_EQ(out[8], 19.0f);
+    EXPECT_EQ(q.runs(), 2);
+    EXPECT_EQ(q.items(), 5);
+}
+
+TEST(BatchQueue, CoalescesConcurrentClients) {
+    std::vector<int> sizes;
+    std::mutex mu;
+    // Generous window so all four submissions land in one round.
+    BatchQueue q(1, 16, 500000, sumModel(1, &sizes, &mu));
+    const int kClients = 4;
+    for (int i = 0; i < kClients; ++i) q.attach();
+
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int c = 0; c < kClients; ++c) {
+        threads.emplace_back([&, c] {
+            // Client c submits c+1 items valued 100*c + i.
+            std::vector<float> in;
+            for (int i = 0; i <= c; ++i) in.push_back(100.0f * c + i);
+            std::vector<float> out;
+            std::vector<int64_t> shape;
+            if (!q.run(in.data(), static_cast<int>(in.size()), out, shape)) ++failures;
+            if (out.size() != 2 * in.size() || shape != std::vector<int64_t>{1, 2}) ++failures;
+            for (size_t i = 0; i < in.size() && 2 * i < out.size(); ++i)
+                if (out[2 * i] != in[i]) ++failures;
+        });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(q.items(), 10);
+    EXPECT_EQ(sizes, (std::vector<int>{10}));  // one model call for every client
+}
+
+TEST(BatchQueue, FailurePropagatesToEveryCaller) {
+    BatchQueue q(1, 8, 100000,
+                 [](const float*, int, std::vector<float>&, std::vector<int64_t>&) { return false; });
+    q.attach();
+    q.attach();
+    std::atomic<int> ok{0};
+    std::vector<std::thread> threads;
+    for (int c = 0; c < 2; ++c)
+        threads.emplace_back([&] {
+            const float in = 1.0f;
+            std::vector<float> out;
+            std::vector<int64_t> shape;
+            if (q.run(&in, 1, out, shape)) ++ok;
+        });
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(ok.load(), 0);
+}
+
+TEST(PlateReadCache, ReusesConfidentReadWhileOverlapping) {
+    PlateReadCache cache(0.5f, 0.9f, 2000000);
+    PlateRead read;
+    EXPECT_FALSE(cache.lookup(0, {100, 100, 80, 20}, 0, read));
+    cache.store(0, {100, 100, 80, 20}, 0, {"ABC123", 0.95f});
+
+    // Plate drifts a little each frame: still the same read.
+    ASSERT_TRUE(cache.lookup(0, {104, 101, 80, 20}, 100000, read));
+    EXPECT_EQ(read.text, "ABC123");
+    ASSERT_TRUE(cache.lookup(0, {110, 102, 80, 20}, 200000, read));
+    // Other streams and non-overlapping boxes miss.
+    EXPECT_FALSE(cache.lookup(1, {110, 102, 80, 20}, 200000, read));
+    EXPECT_FALSE(cache.lookup(0, {400, 300, 80, 20}, 200000, read));
+    // The read is refreshed once it is older than the TTL.
+    EXPECT_FALSE(cache.lookup(0, {110, 102, 80, 20}, 2100000, read));
+}
+
+TEST(PlateReadCache, LowConfidenceReadsAreRetried) {
+    PlateReadCache cache(0.5f, 0.9f, 2000000);
+    PlateRead read;
+    cache.store(0, {0, 0, 50, 20}, 0, {"A8C", 0.6f});
+    EXPECT_FALSE(cache.lookup(0, {0, 0, 50, 20}, 40000, read));
+    cache.store(0, {0, 0, 50, 20}, 80000, {"ABC", 0.97f});
+    EXPECT_EQ(cache.size(0), 1u);  // replaced, not duplicated
+    ASSERT_TRUE(cache.lookup(0, {0, 0, 50, 20}, 120000, read));
+    EXPECT_EQ(read.text, "ABC");
+}
+
+TEST(PlateReadCache, ExpiresUnseenPlatesAndStreamRestarts) {
+    PlateReadCache cache(0.5f, 0.9f, 1000000);
+    cache.store(0, {0, 0, 50, 20}, 5000000, {"ABC", 0.97f});
+    cache.store(0, {200, 0, 50, 20}, 5500000, {"XYZ", 0.97f});
+    cache.expire(0, 6200000);
+    EXPECT_EQ(cache.size(0), 1u);
+    cache.expire(0, 10);  // pts went backwards
+    EXPECT_EQ(cache.size(0), 0u);
+
+    PlateReadCache off(0.5f, 0.9f, 0);
+    PlateRead read;
+    off.store(0, {0, 0, 50, 20}, 0, {"ABC", 0.99f});
+    EXPECT_FALSE(off.lookup(0, {0, 0, 50, 20}, 0, read));
+}
@@ -4,6 +4,8 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <vector>
 
@@ -120,3 +122,47 @@ TEST(CropResizeGray, ProducesNormalizedValues) {
     crop_resize_gray(img.data(), 2, 2, 0, 0, 2, 2, 2, 2, dst.data());
     for (float v : dst) EXPECT_NEAR(v, 1.0f, 1e-5f);
 }
+
+namespace {
+// Per-pixel bilinear reference for the separable crop/resize kernels.
+float refSample(const std::vector<uint8_t>& img, int w, int h, float sx, float sy, float sw,
+                float sh, int dw, int dh, int dx, int dy, int c) {
+    const float x0 = std::clamp(sx, 0.0f, float(w)), y0 = std::clamp(sy, 0.0f, float(h));
+    const float cw = std::max(1.0f, std::clamp(sx + sw, 0.0f, float(w)) - x0);
+    const float ch = std::max(1.0f, std::clamp(sy + sh, 0.0f, float(h)) - y0);
+    const float fx = (dx + 0.5f) / dw * cw + x0 - 0.5f;
+    const float fy = (dy + 0.5f) / dh * ch + y0 - 0.5f;
+    const int ix0 = std::clamp(int(std::floor(fx)), 0, w - 1), ix1 = std::min(ix0 + 1, w - 1);
+    const int iy0 = std::clamp(int(std::floor(fy)), 0, h - 1), iy1 = std::min(iy0 + 1, h - 1);
+    const float wx = fx - std::floor(fx), wy = fy - std::floor(fy);
+    auto px = [&](int x, int y) { return float(img[(y * w + x) * 3 + c]); };
+    const float top = px(ix0, iy0) + (px(ix1, iy0) - px(ix0, iy0)) * wx;
+    const float bot = px(ix0, iy1) + (px(ix1, iy1) - px(ix0, iy1)) * wx;
+    return (top + (bot - top) * wy) / 255.0f;
+}
+}  // namespace
+
+TEST(CropResizeRgb, MatchesBilinearReferenceOnNonUniformImage) {
+    const int w = 37, h = 23;
+    std::vector<uint8_t> img(size_t(w) * h * 3);
+    for (size_t i = 0; i < img.size(); ++i) img[i] = uint8_t((i * 37 + i / 7) & 0xFF);
+    // Upscale, downscale and a crop hanging off the image edge.
+    const float crops[][4] = {{3.5f, 2.0f, 12.0f, 5.0f}, {0, 0, 37, 23}, {30.0f, -4.0f, 20.0f, 10.0f}};
+    const int dw = 16, dh = 9;
+    for (const auto& c : crops) {
+        std::vector<float> rgb(3 * dw * dh), gray(dw * dh);
+        crop_resize_rgb(img.data(), w, h, c[0], c[1], c[2], c[3], dw, dh, rgb.data());
+        crop_resize_gray(img.data(), w, h, c[0], c[1], c[2], c[3], dw, dh, gray.data());
+        for (int y = 0; y < dh; ++y)
+            for (int x = 0; x < dw; ++x) {
+                float luma = 0.0f;
+                const float kW[3] = {0.299f, 0.587f, 0.114f};
+                for (int ch = 0; ch < 3; ++ch) {
+                    const float ref = refSample(img, w, h, c[0], c[1], c[2], c[3], dw, dh, x, y, ch);
+                    EXPECT_NEAR(rgb[ch * dw * dh + y * dw + x], ref, 1e-5f);
+                    luma += kW[ch] * ref;
+                }
+                EXPECT_NEAR(gray[y * dw + x], luma, 1e-5f);
+            }
+    }
+}
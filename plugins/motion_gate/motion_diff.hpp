@@ -2,17 +2,61 @@
 
 // Pure, dependency-free luma-diff helpers for the lightweight motion gate.
 // Kept separate from the plugin so they can be unit-tested without the ABI.
+// The block-SAD kernel uses xsimd batches when built with ZMP_USE_SIMD; the
+// scalar tail and fallback give identical results.
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <vector>
 
+#ifdef ZMP_USE_SIMD
+#include <xsimd/xsimd.hpp>
+#endif
+
 namespace zm::motiongate {
 
 enum class PixFmt { RGB24, GRAY8, YUV420P };
 
+namespace detail {
+
+template <int Step>
+inline void gather_step(const uint8_t* src, int n, uint8_t* dst) {
+    for (int i = 0; i < n; ++i) dst[i] = src[static_cast<size_t>(i) * Step];
+}
+
+// dst[i] = src[i * step] for i < n. The common steps get constant-stride loops,
+// which the compiler vectorizes with shuffles at -O3 (xsimd has no portable
+// deinterleave).
+inline void gather_strided(const uint8_t* src, int step, int n, uint8_t* dst) {
+    switch (step) {
+    case 1: std::memcpy(dst, src, static_cast<size_t>(n)); return;
+    case 2: gather_step<2>(src, n, dst); return;
+    case 4: gather_step<4>(src, n, dst); return;
+    default:
+        for (int i = 0; i < n; ++i) dst[i] = src[static_cast<size_t>(i) * step];
+    }
+}
+
+#ifdef ZMP_USE_SIMD
+// Sum of the 8 bytes in each 64-bit lane (at most 8 * 255), by pairwise adds
+// within the lane.
+template <class A>
+inline xsimd::batch<uint64_t, A> sum_bytes_per_u64(xsimd::batch<uint64_t, A> v) {
+    using b64 = xsimd::batch<uint64_t, A>;
+    v = (v & b64(0x00ff00ff00ff00ffull)) + ((v >> 8) & b64(0x00ff00ff00ff00ffull));
+    v = (v & b64(0x0000ffff0000ffffull)) + ((v >> 16) & b64(0x0000ffff0000ffffull));
+    return (v & b64(0x00000000ffffffffull)) + (v >> 32);
+}
+#endif
+
+}  // namespace detail
+
 // Extract a downsampled luma image by sampling every `step`-th pixel in x and y.
-// For GRAY8 / YUV420P the first w*h bytes are the luma plane; for RGB24 luma is
-// computed as 0.299R + 0.587G + 0.114B (fixed-point). `out` is resized to dw*dh.
+// For GRAY8 / YUV420P the first w*h bytes are the luma plane (read in place,
+// vectorized for step 1/2/4); for RGB24 luma is computed as
+// 0.299R + 0.587G + 0.114B (fixed-point). `out` is resized to dw*dh, so a
+// buffer reused across frames is not reallocated.
 inline void downsample_luma(const uint8_t* buf, PixFmt fmt, int w, int h, int step,
                             std::vector<uint8_t>& out, int& dw, int& dh) {
     if (step < 1) step = 1;
@@ -21,15 +65,14 @@ inline void downsample_luma(const uint8_t* buf, PixFmt fmt, int w, int h, int st
     out.resize(static_cast<size_t>(dw) * dh);
     size_t oi = 0;
     for (int y = 0; y < h; y += step) {
+        if (fmt != PixFmt::RGB24) {
+            detail::gather_strided(buf + static_cast<size_t>(y) * w, step, dw, out.data() + oi);
+            oi += static_cast<size_t>(dw);
+            continue;
+        }
         for (int x = 0; x < w; x += step) {
-            uint8_t l;
-            if (fmt == PixFmt::RGB24) {
-                const uint8_t* p = buf + (static_cast<size_t>(y) * w + x) * 3;
-                l = static_cast<uint8_t>((p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8);
-            } else {
-                l = buf[static_cast<size_t>(y) * w + x];  // luma plane
-            }
-            out[oi++] = l;
+            const uint8_t* p = buf + (static_cast<size_t>(y) * w + x) * 3;
+            out[oi++] = static_cast<uint8_t>((p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8);
         }
     }
 }
@@ -48,4 +91,155 @@ inline int count_changed(const std::vector<uint8_t>& a, const std::vector<uint8_
     return changed;
 }
 
+// Per-sample change mask: out[i] = 1 where |a-b| > threshold, else 0. False (and
+// `out` untouched) if the buffers differ in size.
+inline bool changed_mask(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b,
+                         int threshold, std::vector<uint8_t>& out) {
+    if (a.size() != b.size()) return false;
+    out.resize(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        int d = static_cast<int>(a[i]) - static_cast<int>(b[i]);
+        if (d < 0) d = -d;
+        out[i] = d > threshold ? 1 : 0;
+    }
+    return true;
+}
+
+// Per-block activity between two dw x dh sample grids, `block` x `block`
+// samples per block (rounded up to a multiple of 8, the SIMD group width).
+struct BlockGrid {
+    int cols = 0, rows = 0;
+    int block = 8;
+    std::vector<uint32_t> sad;      // sum of |a-b| over the block
+    std::vector<uint32_t> changed;  // samples with |a-b| > threshold
+    int total_changed = 0;
+};
+
+// Fill `out` (buffers reused across calls) and, when `mask` is given, the
+// per-sample change mask (1 = changed) in the same pass. total_changed equals
+// count_changed(a, b, threshold). False when the grids differ in size.
+inline bool block_diff(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, int dw,
+                       int dh, int block, int threshold, BlockGrid& out,
+                       std::vector<uint8_t>* mask = nullptr) {
+    if (a.size() != b.size() || a.size() != static_cast<size_t>(dw) * dh || dw <= 0 || dh <= 0)
+        return false;
+    block = (std::max(block, 8) + 7) / 8 * 8;
+    out.block = block;
+    out.cols = (dw + block - 1) / block;
+    out.rows = (dh + block - 1) / block;
+    out.sad.assign(static_cast<size_t>(out.cols) * out.rows, 0);
+    out.changed.assign(out.sad.size(), 0);
+    if (mask) mask->resize(a.size());
+    const int thr = std::clamp(threshold, 0, 255);
+    uint32_t total = 0;
+
+    for (int y = 0; y < dh; ++y) {
+        const size_t row = static_cast<size_t>(y) * dw;
+        const uint8_t* pa = a.data() + row;
+        const uint8_t* pb = b.data() + row;
+        uint8_t* pm = mask ? mask->data() + row : nullptr;
+        uint32_t* sad = out.sad.data() + static_cast<size_t>(y / block) * out.cols;
+        uint32_t* cnt = out.changed.data() + static_cast<size_t>(y / block) * out.cols;
+        int x = 0;
+#ifdef ZMP_USE_SIMD
+        // One batch per step, summed per 8-sample group (one 64-bit lane);
+        // block is a multiple of 8, so a group never straddles two blocks.
+        using batch_t = xsimd::batch<uint8_t>;
+        using wide_t = xsimd::batch<uint64_t, batch_t::arch_type>;
+        constexpr size_t VL = batch_t::size;
+        constexpr size_t kGroups = wide_t::size;
+        const batch_t vthr(static_cast<uint8_t>(thr)), one(1), zero(0);
+        uint64_t group_sad[kGroups], group_cnt[kGroups];
+        for (; x + static_cast<int>(VL) <= dw; x += static_cast<int>(VL)) {
+            const batch_t va = batch_t::load_unaligned(pa + x);
+            const batch_t vb = batch_t::load_unaligned(pb + x);
+            const batch_t d = xsimd::max(va, vb) - xsimd::min(va, vb);
+            const batch_t c = xsimd::select(d > vthr, one, zero);
+            if (pm) c.store_unaligned(pm + x);
+            detail::sum_bytes_per_u64(xsimd::bitwise_cast<uint64_t>(d)).store_unaligned(group_sad);
+            detail::sum_bytes_per_u64(xsimd::bitwise_cast<uint64_t>(c)).store_unaligned(group_cnt);
+            for (size_t g = 0; g < kGroups; ++g) {
+                const int b = (x + static_cast<int>(g) * 8) / block;
+                sad[b] += static_cast<uint32_t>(group_sad[g]);
+                cnt[b] += static_cast<uint32_t>(group_cnt[g]);
+                total += static_cast<uint32_t>(group_cnt[g]);
+            }
+        }
+#endif
+        for (; x < dw; ++x) {
+            int d = static_cast<int>(pa[x]) - static_cast<int>(pb[x]);
+            if (d < 0) d = -d;
+            const uint32_t c = d > thr ? 1u : 0u;
+            if (pm) pm[x] = static_cast<uint8_t>(c);
+            sad[x / block] += static_cast<uint32_t>(d);
+            cnt[x / block] += c;
+            total += c;
+        }
+    }
+    out.total_changed = static_cast<int>(total);
+    return true;
+}
+
+// Bounding box of one group of changed samples, in downsampled-grid cells.
+struct CellBox {
+    int x = 0, y = 0, w = 0, h = 0;
+    int cells = 0;  // changed samples in the group
+};
+
+// Group the changed samples of a dw x dh change mask (block_diff /
+// changed_mask; 1 = changed) into 8-connected components, drop groups under
+// `min_cells`, and return their boxes largest first. Past `max_regions`, the
+// smallest groups are folded into the last box so no moving area is lost. The
+// mask is consumed: visited samples are marked 2.
+inline std::vector<CellBox> mask_regions(std::vector<uint8_t>& state, int dw, int dh,
+                                         int min_cells, int max_regions) {
+    std::vector<CellBox> out;
+    if (dw <= 0 || dh <= 0 || state.size() != static_cast<size_t>(dw) * dh) return out;
+    std::vector<int> stack;
+    for (int start = 0; start < dw * dh; ++start) {
+        if (state[start] != 1) continue;
+        int x0 = dw, y0 = dh, x1 = -1, y1 = -1, cells = 0;
+        state[start] = 2;
+        stack.assign(1, start);
+        while (!stack.empty()) {
+            const int i = stack.back();
+            stack.pop_back();
+            const int x = i % dw, y = i / dw;
+            ++cells;
+            x0 = std::min(x0, x); x1 = std::max(x1, x);
+            y0 = std::min(y0, y); y1 = std::max(y1, y);
+            for (int ny = std::max(0, y - 1); ny <= std::min(dh - 1, y + 1); ++ny)
+                for (int nx = std::max(0, x - 1); nx <= std::min(dw - 1, x + 1); ++nx) {
+                    const int j = ny * dw + nx;
+                    if (state[j] == 1) { state[j] = 2; stack.push_back(j); }
+                }
+        }
+        if (cells >= min_cells) out.push_back({x0, y0, x1 - x0 + 1, y1 - y0 + 1, cells});
+    }
+    std::sort(out.begin(), out.end(),
+              [](const CellBox& l, const CellBox& r) { return l.cells > r.cells; });
+    if (max_regions > 0 && static_cast<int>(out.size()) > max_regions) {
+        CellBox& last = out[max_regions - 1];
+        for (size_t i = max_regions; i < out.size(); ++i) {
+            const CellBox& o = out[i];
+            const int nx0 = std::min(last.x, o.x), ny0 = std::min(last.y, o.y);
+            const int nx1 = std::max(last.x + last.w, o.x + o.w);
+            const int ny1 = std::max(last.y + last.h, o.y + o.h);
+            last = {nx0, ny0, nx1 - nx0, ny1 - ny0, last.cells + o.cells};
+        }
+        out.resize(max_regions);
+    }
+    return out;
+}
+
+// mask_regions over the samples with |a-b| > threshold. Empty when the grids
+// differ in size.
+inline std::vector<CellBox> changed_regions(const std::vector<uint8_t>& a,
+                                            const std::vector<uint8_t>& b, int dw, int dh,
+                                            int threshold, int min_cells, int max_regions) {
+    std::vector<uint8_t> state;
+    if (!changed_mask(a, b, threshold, state)) return {};
+    return mask_regions(state, dw, dh, min_cells, max_regions);
+}
+
 }  // namespace zm::motiongate
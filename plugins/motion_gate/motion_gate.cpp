@@ -3,18 +3,28 @@
 // Diffs downsampled luma between frames and, when "gate" is enabled, only forwards
 // frames downstream while motion is active (plus a cooldown). Placed before an
 // expensive stage (e.g. detect_onnx) it means YOLO only runs when something moves.
+// The diff is a SIMD block-SAD pass over luma sampled straight off the Y plane,
+// yielding per-block activity as well as the global changed count.
+// Each "motion" event also carries the changed areas as source-pixel "regions"
+// (8-connected groups of changed samples), which detect_onnx's ROI cascade
+// crops instead of letterboxing the whole frame.
+// The same data also rides on each forwarded frame as side data (zm_side_data.h:
+// motion boxes, scene score, optionally the block activity grid), so a stage downstream
+// reads the motion of exactly that frame instead of matching events by pts.
 // It is a pass-through PROCESS plugin: GPU-surface frames and unknown formats are
 // forwarded untouched (gating needs CPU luma).
 
 #include "motion_diff.hpp"
 
 #include <zm_plugin.h>
+#include <zm_side_data.h>
 #include <nlohmann/json.hpp>
 
 #include <string>
 #include <vector>
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
 
 using json = nlohmann::json;
 
@@ -32,13 +42,24 @@ struct MotionGateCtx {
     int minChanged = 50;          // changed samples needed to declare motion
     int cooldownFrames = 15;      // keep the gate open this long after last motion
     bool gate = true;             // hard-gate downstream (drop static frames)
+    int maxRegions = 8;           // changed areas reported per motion event
+    int regionMinChanged = 4;     // changed samples for an area to be reported
+    bool sideData = true;         // attach motion side data to forwarded frames
+    bool sideDataGrid = false;    // ...including the per-block activity grid
+    int blockSize = 8;            // samples per activity block side (multiple of 8)
     std::vector<int> streamFilter;
 
-    // State.
+    // State. prev/cur are double buffers swapped each frame (no per-frame
+    // allocation once sized).
     std::vector<uint8_t> prev;
+    std::vector<uint8_t> cur;
+    zm::motiongate::BlockGrid blocks;
     int prevW = 0, prevH = 0;
     uint64_t frameCount = 0;
     uint64_t gateOpenUntil = 0;   // forward while frameCount <= this
+    std::vector<uint8_t> entries; // encoded side data for the current frame (reused)
+    std::vector<uint8_t> mask;    // per-sample change mask (regions)
+    std::vector<uint8_t> grid;    // side-data activity grid scratch
 };
 
 void forwardFrame(MotionGateCtx* ctx, const void* buf, size_t size) {
@@ -46,6 +67,23 @@ void forwardFrame(MotionGateCtx* ctx, const void* buf, size_t size) {
         ctx->host->on_frame(ctx->hostCtx, buf, size);
 }
 
+// Forward with the current frame's side data; the host appends it while copying
+// the frame for the children. Hosts without on_frame_side_data get the plain frame.
+void forwardWithSideData(MotionGateCtx* ctx, const void* buf, size_t size) {
+    if (!ctx->entries.empty() && ctx->host && ctx->host->on_frame_side_data) {
+        ctx->host->on_frame_side_data(ctx->hostCtx, buf, size, ctx->entries.data(),
+                                      ctx->entries.size());
+        return;
+    }
+    forwardFrame(ctx, buf, size);
+}
+
+void appendEntry(std::vector<uint8_t>& out, uint32_t type, const void* value, size_t bytes) {
+    const size_t at = out.size();
+    out.resize(at + sizeof(zm_side_data_entry_t) + zm_side_data_pad(bytes));
+    zm_side_data_put(out.data() + at, out.size() - at, type, value, bytes);
+}
+
 bool fmt_from_hw_type(uint32_t hw_type, zm::motiongate::PixFmt& out) {
     switch (hw_type) {
         case ZM_FRAME_RGB24:     out = zm::motiongate::PixFmt::RGB24;   return true;
@@ -70,6 +108,11 @@ int motion_gate_start(zm_plugin_t* plugin, zm_host_api_t* host, void* host_ctx,
         ctx->minChanged = j.value("min_changed_pixels", 50);
         ctx->cooldownFrames = j.value("cooldown_frames", 15);
         ctx->gate = j.value("gate", true);
+        ctx->maxRegions = std::max(1, j.value("max_regions", 8));
+        ctx->regionMinChanged = std::max(1, j.value("region_min_changed", 4));
+        ctx->sideData = j.value("side_data", true);
+        ctx->sideDataGrid = j.value("side_data_grid", false);
+        ctx->blockSize = std::max(8, j.value("block_size", 8));
         if (j.contains("stream_filter") && j["stream_filter"].is_array())
             for (const auto& s : j["stream_filter"]) ctx->streamFilter.push_back(s.get<int>());
     } catch (const std::exception& e) {
@@ -113,33 +156,68 @@ void motion_gate_on_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
     }
 
     const uint8_t* payload = static_cast<const uint8_t*>(buf) + sizeof(zm_frame_hdr_t);
-    std::vector<uint8_t> cur;
     int dw = 0, dh = 0;
-    zm::motiongate::downsample_luma(payload, fmt, w, h, ctx->step, cur, dw, dh);
+    zm::motiongate::downsample_luma(payload, fmt, w, h, ctx->step, ctx->cur, dw, dh);
 
     bool motion = false;
-    if (ctx->prevW == dw && ctx->prevH == dh && !ctx->prev.empty()) {
-        const int changed = zm::motiongate::count_changed(ctx->prev, cur, ctx->pixelThreshold);
+    ctx->entries.clear();
+    if (ctx->prevW == dw && ctx->prevH == dh &&
+        zm::motiongate::block_diff(ctx->prev, ctx->cur, dw, dh, ctx->blockSize,
+                                   ctx->pixelThreshold, ctx->blocks, &ctx->mask)) {
+        const int changed = ctx->blocks.total_changed;
         motion = (changed >= ctx->minChanged);
+        std::vector<zm_side_box_t> boxes;
         if (motion) {
             ctx->gateOpenUntil = ctx->frameCount + static_cast<uint64_t>(ctx->cooldownFrames);
+            for (const auto& r : zm::motiongate::mask_regions(ctx->mask, dw, dh,
+                                                              ctx->regionMinChanged,
+                                                              ctx->maxRegions)) {
+                const int x = r.x * ctx->step, y = r.y * ctx->step;
+                boxes.push_back({x, y, std::min(w - x, r.w * ctx->step),
+                                 std::min(h - y, r.h * ctx->step)});
+            }
             if (ctx->host && ctx->host->publish_evt) {
                 json evt;
                 evt["type"] = "motion";
                 evt["stream_id"] = hdr->stream_id;
                 evt["changed"] = changed;
                 evt["pts_usec"] = hdr->pts_usec;
+                json regions = json::array();
+                for (const auto& b : boxes) regions.push_back({b.x, b.y, b.w, b.h});
+                evt["regions"] = std::move(regions);
                 ctx->host->publish_evt(ctx->hostCtx, evt.dump().c_str());
             }
         }
+        if (ctx->sideData) {
+            // An empty box list on a frame with side data = analyzed, nothing moved.
+            appendEntry(ctx->entries, ZM_SIDE_MOTION_BOXES, boxes.data(),
+                        boxes.size() * sizeof(zm_side_box_t));
+            const float score = static_cast<float>(changed) / static_cast<float>(ctx->cur.size());
+            appendEntry(ctx->entries, ZM_SIDE_SCENE_SCORE, &score, sizeof(score));
+            const int cell = ctx->blocks.block * ctx->step;
+            if (ctx->sideDataGrid && ctx->blocks.cols <= 0xffff && ctx->blocks.rows <= 0xffff &&
+                cell <= 0xffff) {
+                const zm_side_motion_grid_t g{static_cast<uint16_t>(ctx->blocks.cols),
+                                              static_cast<uint16_t>(ctx->blocks.rows),
+                                              static_cast<uint16_t>(cell),
+                                              static_cast<uint16_t>(cell)};
+                ctx->grid.resize(sizeof(g) + ctx->blocks.changed.size());
+                std::memcpy(ctx->grid.data(), &g, sizeof(g));
+                for (size_t i = 0; i < ctx->blocks.changed.size(); ++i)
+                    ctx->grid[sizeof(g) + i] =
+                        static_cast<uint8_t>(std::min<uint32_t>(255, ctx->blocks.changed[i]));
+                appendEntry(ctx->entries, ZM_SIDE_MOTION_GRID, ctx->grid.data(),
+                            ctx->grid.size());
+            }
+        }
     }
-    ctx->prev = std::move(cur);
+    std::swap(ctx->prev, ctx->cur);
     ctx->prevW = dw;
     ctx->prevH = dh;
 
     const bool open = !ctx->gate || (ctx->frameCount <= ctx->gateOpenUntil);
     ++ctx->frameCount;
-    if (open) forwardFrame(ctx, buf, size);
+    if (open) forwardWithSideData(ctx, buf, size);
 }
 
 }  // namespace
@@ -3,6 +3,7 @@
 #include <gtest/gtest.h>
 #include <vector>
 #include <cstdint>
+#include <cstdlib>
 
 using namespace zm::motiongate;
 
@@ -47,3 +48,90 @@ TEST(MotionDiffTest, IdenticalFramesNoChange) {
     std::vector<uint8_t> b(100, 128);
     EXPECT_EQ(count_changed(a, b, 0), 0);
 }
+
+TEST(MotionDiffTest, ChangedRegionsSeparatesMovers) {
+    // 10x6 grid: a 2x2 mover top-left, a 3x1 mover bottom-right, one noise cell.
+    const int dw = 10, dh = 6;
+    std::vector<uint8_t> a(dw * dh, 0), b(dw * dh, 0);
+    auto set = [&](int x, int y) { b[y * dw + x] = 200; };
+    set(1, 1); set(2, 1); set(1, 2); set(2, 2);
+    set(6, 5); set(7, 5); set(8, 5);
+    set(9, 0);
+    auto r = changed_regions(a, b, dw, dh, 20, 2, 8);
+    ASSERT_EQ(r.size(), 2u);  // noise cell below min_cells
+    EXPECT_EQ(r[0].cells, 4);
+    EXPECT_EQ(r[0].x, 1); EXPECT_EQ(r[0].y, 1); EXPECT_EQ(r[0].w, 2); EXPECT_EQ(r[0].h, 2);
+    EXPECT_EQ(r[1].x, 6); EXPECT_EQ(r[1].y, 5); EXPECT_EQ(r[1].w, 3); EXPECT_EQ(r[1].h, 1);
+
+    // Capped at one region: the smaller mover is folded into the kept box.
+    r = changed_regions(a, b, dw, dh, 20, 2, 1);
+    ASSERT_EQ(r.size(), 1u);
+    EXPECT_EQ(r[0].x, 1); EXPECT_EQ(r[0].y, 1); EXPECT_EQ(r[0].w, 8); EXPECT_EQ(r[0].h, 5);
+    EXPECT_EQ(r[0].cells, 7);
+
+    EXPECT_TRUE(changed_regions(a, std::vector<uint8_t>(3), dw, dh, 20, 1, 8).empty());
+}
+
+TEST(MotionDiffTest, ChangedMaskMarksSamplesOverThreshold) {
+    std::vector<uint8_t> a{10, 10, 10, 10}, b{10, 40, 25, 10}, m;
+    ASSERT_TRUE(changed_mask(a, b, 20, m));
+    EXPECT_EQ(m, (std::vector<uint8_t>{0, 1, 0, 0}));
+    EXPECT_FALSE(changed_mask(a, std::vector<uint8_t>(3), 20, m));
+}
+
+TEST(MotionDiffTest, StridedGatherMatchesScalar) {
+    // Widths that leave SIMD tails, and a last row the vector path must not overread.
+    for (int step : {1, 2, 3, 4}) {
+        for (int w : {7, 64, 100, 129}) {
+            const int h = 9;
+            std::vector<uint8_t> img(static_cast<size_t>(w) * h);
+            for (size_t i = 0; i < img.size(); ++i) img[i] = static_cast<uint8_t>(i * 37 + 11);
+            std::vector<uint8_t> out;
+            int dw = 0, dh = 0;
+            downsample_luma(img.data(), PixFmt::GRAY8, w, h, step, out, dw, dh);
+            ASSERT_EQ(out.size(), static_cast<size_t>(dw) * dh);
+            size_t k = 0;
+            for (int y = 0; y < h; y += step)
+                for (int x = 0; x < w; x += step)
+                    ASSERT_EQ(out[k++], img[static_cast<size_t>(y) * w + x])
+                        << "step " << step << " w " << w;
+        }
+    }
+}
+
+TEST(MotionDiffTest, BlockDiffMatchesScalarReference) {
+    // 53: a SIMD body plus a scalar tail; 150: several batches even at 64 lanes.
+    const int thr = 20;
+    for (const int dw : {53, 150}) {
+        for (const int blockReq : {8, 12}) {  // 12 rounds up to 16
+            const int dh = 21;
+            std::vector<uint8_t> a(dw * dh), b(dw * dh), mask;
+            uint32_t seed = 7;
+            for (size_t i = 0; i < a.size(); ++i) {
+                seed = seed * 1103515245u + 12345u;
+                a[i] = static_cast<uint8_t>(seed >> 16);
+                b[i] = static_cast<uint8_t>(a[i] + ((seed >> 8) % 3 == 0 ? (seed >> 24) : 0));
+            }
+            BlockGrid g;
+            ASSERT_TRUE(block_diff(a, b, dw, dh, blockReq, thr, g, &mask));
+            const int block = blockReq == 8 ? 8 : 16;
+            EXPECT_EQ(g.block, block);
+            ASSERT_EQ(g.cols, (dw + block - 1) / block);
+            ASSERT_EQ(g.rows, (dh + block - 1) / block);
+            EXPECT_EQ(g.total_changed, count_changed(a, b, thr));
+
+            std::vector<uint32_t> sad(g.cols * g.rows, 0), cnt(g.cols * g.rows, 0);
+            for (int y = 0; y < dh; ++y)
+                for (int x = 0; x < dw; ++x) {
+                    const int d = std::abs(a[y * dw + x] - b[y * dw + x]);
+                    const size_t cell = static_cast<size_t>(y / block) * g.cols + x / block;
+                    sad[cell] += d;
+                    cnt[cell] += d > thr;
+                    ASSERT_EQ(mask[y * dw + x], d > thr ? 1 : 0);
+                }
+            EXPECT_EQ(g.sad, sad) << "dw " << dw << " block " << block;
+            EXPECT_EQ(g.changed, cnt) << "dw " << dw << " block " << block;
+            EXPECT_FALSE(block_diff(a, std::vector<uint8_t>(3), dw, dh, 8, thr, g));
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include <zm_plugin.h>
+#include <zm_side_data.h>
 #include <mutex>
 #include <queue>
 #include <vector>
@@ -1414,7 +1415,7 @@ static void mse_on_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
     // worker link / zm-api front door.)
     if (hdr->hw_type == ZM_FRAME_COMPRESSED_AUDIO) return;
     const uint8_t* payload = static_cast<const uint8_t*>(buf) + sizeof(zm_frame_hdr_t);
-    size_t payload_size = size - sizeof(zm_frame_hdr_t);
+    size_t payload_size = zm_frame_payload_size(buf, size);
     
     // Use the configured camera_id from the plugin configuration
     uint32_t camera_id = plugin_instance->camera_id;
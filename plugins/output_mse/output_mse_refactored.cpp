@@ -1,4 +1,5 @@
 #include <zm_plugin.h>
+#include <zm_side_data.h>
 #include <zm_plugin_utils.h>
 #include <vector>
 #include <queue>
@@ -368,7 +369,7 @@ static int mse_process_frame(zm_plugin_t* plugin, const void* frame_data, size_t
     
     const zm_frame_hdr_t* frame_hdr = static_cast<const zm_frame_hdr_t*>(frame_data);
     const uint8_t* payload = static_cast<const uint8_t*>(frame_data) + sizeof(zm_frame_hdr_t);
-    size_t payload_size = frame_size - sizeof(zm_frame_hdr_t);
+    size_t payload_size = zm_frame_payload_size(frame_data, frame_size);
     
     MSEPluginManager::getInstance().pushFrame(frame_hdr, payload, payload_size);
     return 0;
@@ -1,6 +1,8 @@
 #include <zm_plugin.h>
+#include <zm_side_data.h>
 #include <nlohmann/json.hpp>
 #include <rtc/rtc.hpp>
+#include "rtp_fanout.hpp"
 #include <boost/asio.hpp>
 #include <boost/thread.hpp>
 #include <boost/thread/shared_mutex.hpp>
@@ -16,6 +18,7 @@
 #include <condition_variable>
 #include <thread>
 #include <cstring>
+#include <random>
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -108,10 +111,15 @@ struct ViewerSession {
     std::chrono::steady_clock::time_point last_activity;
     std::atomic<bool> is_connected{false};
     uint32_t ssrc;
-    uint16_t sequence_number = 0;
-    
-    ViewerSession(const std::string& id, uint32_t cam_id, uint32_t ssrc_val)
-        : viewer_id(id), camera_id(cam_id), ssrc(ssrc_val), 
+    // Per-viewer RTP header rewrite of the camera's shared packets, and the
+    // scratch buffer it writes into (touched only by the frame processor thread).
+    zm::webrtc::RtpRewriter rewriter;
+    std::vector<uint8_t> rtp_scratch;
+    
+    ViewerSession(const std::string& id, uint32_t cam_id, uint32_t ssrc_val,
+                  uint16_t seq_base, uint32_t ts_base)
+        : viewer_id(id), camera_id(cam_id), ssrc(ssrc_val),
+          rewriter(ssrc_val, seq_base, ts_base),
           last_activity(std::chrono::steady_clock::now()) {}
 };
 
@@ -138,7 +146,9 @@ public:
     
     std::shared_ptr<rtc::PeerConnection> createPeerConnection(const std::string& viewer_id);
     void addVideoTrack(std::shared_ptr<rtc::PeerConnection> pc, uint32_t ssrc);
-    void sendFrame(const std::string& viewer_key, const FrameData& frame);
+    // Send a camera frame that was packetized once to one viewer: only the RTP
+    // header is rewritten per viewer. Returns the number of packets sent.
+    size_t sendPackets(ViewerSession& session, const zm::webrtc::PacketizedFrame& frame);
     
 private:
     std::shared_ptr<rtc::Configuration> rtc_config_;
@@ -172,39 +182,41 @@ void PeerConnectionManager::addVideoTrack(std::shared_ptr<rtc::PeerConnection> p
     
     auto track = pc->addTrack(video);
     
-    // Create H.264 RTP packetizer for this track
-    auto rtpConfig = std::make_shared<rtc::RtpPacketizationConfig>(ssrc, "video", 96, rtc::H264RtpPacketizer::defaultClockRate);
-    auto h264_packetizer = std::make_shared<rtc::H264RtpPacketizer>(rtc::NalUnit::Separator::StartSequence, rtpConfig);
-    track->setMediaHandler(h264_packetizer);
+    // No per-track packetizer: the service packetizes each camera frame once
+    // and the track sends ready-made RTP. The NACK responder keeps recent
+    // packets so a viewer's loss is repaired from the track's own history.
+    track->setMediaHandler(std::make_shared<rtc::RtcpNackResponder>());
     
     std::lock_guard<std::mutex> lock(tracks_mutex_);
     tracks_[std::to_string(ssrc)] = track;
 }
 
-void PeerConnectionManager::sendFrame(const std::string& viewer_key, const FrameData& frame) {
-    std::lock_guard<std::mutex> lock(tracks_mutex_);
-    auto it = tracks_.find(viewer_key);
-    if (it != tracks_.end() && it->second) {
-        try {
-            // Convert uint8_t data to std::byte for libdatachannel
-            rtc::binary nal_data;
-            nal_data.reserve(frame.data.size());
-            for (uint8_t byte : frame.data) {
-                nal_data.push_back(static_cast<std::byte>(byte));
-            }
-            
-            // Send H.264 NAL unit - timestamps will be managed by RTP packetizer
-            it->second->send(nal_data);
-            
-        } catch (const std::exception& e) {
-            // Filter out "Track is closed" errors as they're expected during disconnection
-            std::string error_msg = e.what();
-            if (error_msg.find("Track is closed") == std::string::npos) {
-                log_error("Failed to send frame: %s", e.what());
-            }
-            // Note: Track closed errors are normal during viewer disconnection
+size_t PeerConnectionManager::sendPackets(ViewerSession& session,
+                                         const zm::webrtc::PacketizedFrame& frame) {
+    std::shared_ptr<rtc::Track> track;
+    {
+        std::lock_guard<std::mutex> lock(tracks_mutex_);
+        auto it = tracks_.find(std::to_string(session.ssrc));
+        if (it == tracks_.end() || !it->second) return 0;
+        track = it->second;
+    }
+    size_t sent = 0;
+    try {
+        for (const auto& pkt : frame.packets) {
+            session.rewriter.rewrite(*pkt, session.rtp_scratch);
+            track->send(reinterpret_cast<const rtc::byte*>(session.rtp_scratch.data()),
+                        session.rtp_scratch.size());
+            ++sent;
+        }
+    } catch (const std::exception& e) {
+        // Filter out "Track is closed" errors as they're expected during disconnection
+        std::string error_msg = e.what();
+        if (error_msg.find("Track is closed") == std::string::npos) {
+            log_error("Failed to send frame: %s", e.what());
         }
+        // Note: Track closed errors are normal during viewer disconnection
     }
+    return sent;
 }
 
 // =============================================================================
@@ -302,6 +314,12 @@ private:
     std::atomic<uint64_t> total_bytes_processed_{0};
     std::atomic<uint64_t> total_connections_created_{0};
     std::atomic<uint64_t> total_connections_dropped_{0};
+    std::atomic<uint64_t> rtp_packets_packetized_{0};
+    std::atomic<uint64_t> rtp_packets_sent_{0};
+    
+    // One packetizer per camera; used only by the frame processor thread.
+    std::unordered_map<uint32_t, zm::webrtc::H264Packetizer> packetizers_;
+    std::mt19937 rng_{std::random_device{}()};
     
     // Configuration
     std::shared_ptr<rtc::Configuration> rtc_config_;
@@ -770,7 +788,10 @@ std::shared_ptr<ViewerSession> WebRTCService::createViewerSession(uint32_t camer
     
     // Create new session
     uint32_t ssrc = next_ssrc_++;
-    auto session = std::make_shared<ViewerSession>(viewer_id, camera_id, ssrc);
+    // Random initial sequence number and timestamp per viewer (RFC 3550).
+    auto session = std::make_shared<ViewerSession>(viewer_id, camera_id, ssrc,
+                                                   static_cast<uint16_t>(rng_()),
+                                                   static_cast<uint32_t>(rng_()));
     session->peer_connection = peer_manager_->createPeerConnection(viewer_id);
     
     peer_manager_->addVideoTrack(session->peer_connection, ssrc);
@@ -791,13 +812,20 @@ void WebRTCService::processFrameQueue() {
             frame_queue_.pop();
             lock.unlock();
             
-            // Send frame to all viewers of this camera
+            // Packetize once per camera, then fan the shared RTP packets out to
+            // all viewers of this camera with a per-viewer header rewrite.
+            auto rtp = packetizers_[frame->camera_id].packetize(
+                frame->data.data(), frame->data.size(), frame->timestamp, frame->is_keyframe);
+            rtp_packets_packetized_ += rtp->packets.size();
+
             boost::shared_lock<boost::shared_mutex> viewers_lock(viewers_mutex_);
             int active_viewers = 0;
             auto now = std::chrono::steady_clock::now();
             for (const auto& [viewer_key, session] : viewers_) {
                 if (session->camera_id == frame->camera_id && session->is_connected) {
-                    peer_manager_->sendFrame(std::to_string(session->ssrc), *frame);
+                    // A new viewer starts on a keyframe so its decoder has references.
+                    if (session->rewriter.started() || rtp->keyframe)
+                        rtp_packets_sent_ += peer_manager_->sendPackets(*session, *rtp);
                     // Update last_activity to prevent stale cleanup of active viewers
                     session->last_activity = now;
                     active_viewers++;
@@ -878,6 +906,8 @@ json WebRTCService::getStatistics() const {
     stats["total_bytes_processed"] = total_bytes_processed_.load();
     stats["total_connections_created"] = total_connections_created_.load();
     stats["total_connections_dropped"] = total_connections_dropped_.load();
+    stats["rtp_packets_packetized"] = rtp_packets_packetized_.load();
+    stats["rtp_packets_sent"] = rtp_packets_sent_.load();
     
     // Stream statistics
     json streams_stats = json::array();
@@ -1036,7 +1066,7 @@ static void webrtc_on_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
     // Video-only output; ignore audio frames now that the pipeline carries audio.
     if (frame_hdr->hw_type == ZM_FRAME_COMPRESSED_AUDIO) return;
     const uint8_t* frame_data = static_cast<const uint8_t*>(buf) + sizeof(zm_frame_hdr_t);
-    size_t frame_size = size - sizeof(zm_frame_hdr_t);
+    size_t frame_size = zm_frame_payload_size(buf, size);
 
     WebRTCService::getInstance().pushFrame(frame_hdr, frame_data, frame_size);
 }
@@ -0,0 +1,178 @@
+#pragma once
+
+// Packetize-once RTP fan-out (SFU style) for the WebRTC output.
+// Pure and dependency-free so it can be unit-tested without libdatachannel.
+//
+// Each camera stream's H.264 access unit is packetized ONCE (RFC 6184: single
+// NAL unit packets, FU-A for NALs larger than the payload budget) into RTP
+// packets held in refcounted buffers. Every viewer then only rewrites the
+// 12-byte header (its own SSRC, a contiguous sequence number and a
+// viewer-relative timestamp) into a reused scratch buffer before sending, so
+// per-viewer cost is one memcpy per packet instead of a full re-fragmentation.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace zm::webrtc {
+
+constexpr size_t kRtpHeaderSize = 12;
+constexpr uint32_t kVideoClockRate = 90000;
+
+// Call fn(nal, size) for each NAL unit of an Annex-B byte stream (start codes
+// 00 00 01 / 00 00 00 01 stripped). Trailing zero bytes of a NAL are dropped.
+template <typename Fn>
+inline void for_each_annexb_nal(const uint8_t* data, size_t size, Fn&& fn) {
+    auto find_start = [&](size_t from, size_t& code_len) -> size_t {
+        for (size_t i = from; i + 3 <= size; ++i) {
+            if (data[i] == 0 && data[i + 1] == 0) {
+                if (data[i + 2] == 1) { code_len = 3; return i; }
+                if (i + 4 <= size && data[i + 2] == 0 && data[i + 3] == 1) { code_len = 4; return i; }
+            }
+        }
+        code_len = 0;
+        return size;
+    };
+    size_t code_len = 0;
+    size_t pos = find_start(0, code_len);
+    if (pos == size) {  // no start code: treat the buffer as a single NAL
+        if (size) fn(data, size);
+        return;
+    }
+    while (pos < size) {
+        const size_t begin = pos + code_len;
+        size_t next_len = 0;
+        const size_t next = find_start(begin, next_len);
+        size_t end = next;
+        while (end > begin && data[end - 1] == 0) --end;
+        if (end > begin) fn(data + begin, end - begin);
+        pos = next;
+        code_len = next_len;
+    }
+}
+
+using RtpPacketPtr = std::shared_ptr<const std::vector<uint8_t>>;
+
+// One access unit, packetized once and shared by every viewer of the stream.
+struct PacketizedFrame {
+    std::vector<RtpPacketPtr> packets;
+    uint32_t rtp_timestamp = 0;
+    bool keyframe = false;
+    size_t payload_bytes = 0;
+};
+
+class H264Packetizer {
+public:
+    explicit H264Packetizer(size_t max_payload = 1200, uint8_t payload_type = 96)
+        : max_payload_(max_payload < 3 ? 3 : max_payload), payload_type_(payload_type & 0x7f) {}
+
+    // Packetize an Annex-B access unit. AUD NALs (type 9) are not sent.
+    std::shared_ptr<const PacketizedFrame> packetize(const uint8_t* au, size_t size,
+                                                     uint64_t pts_usec, bool keyframe) {
+        auto frame = std::make_shared<PacketizedFrame>();
+        frame->keyframe = keyframe;
+        frame->rtp_timestamp = static_cast<uint32_t>(pts_usec * kVideoClockRate / 1000000);
+        std::shared_ptr<std::vector<uint8_t>> last;
+        for_each_annexb_nal(au, size, [&](const uint8_t* nal, size_t len) {
+            if ((nal[0] & 0x1f) == 9) return;
+            if (len <= max_payload_) {
+                last = make_packet(frame->rtp_timestamp, nal, len, nullptr, 0);
+                frame->packets.push_back(last);
+            } else {
+                // FU-A: indicator keeps F/NRI with type 28; header carries S/E + type.
+                const uint8_t indicator = static_cast<uint8_t>((nal[0] & 0xe0) | 28);
+                const uint8_t type = nal[0] & 0x1f;
+                const size_t chunk = max_payload_ - 2;
+                for (size_t off = 1; off < len; off += chunk) {
+                    const size_t n = (len - off < chunk) ? len - off : chunk;
+                    uint8_t fu[2] = {indicator, type};
+                    if (off == 1) fu[1] |= 0x80;
+                    if (off + n == len) fu[1] |= 0x40;
+                    last = make_packet(frame->rtp_timestamp, fu, 2, nal + off, n);
+                    frame->packets.push_back(last);
+                }
+            }
+            frame->payload_bytes += len;
+        });
+        if (last) (*last)[1] |= 0x80;  // marker bit on the last packet of the AU
+        return frame;
+    }
+
+    uint64_t packets() const { return packets_; }
+
+private:
+    std::shared_ptr<std::vector<uint8_t>> make_packet(uint32_t ts, const uint8_t* a,
+                                                      size_t a_len, const uint8_t* b,
+                                                      size_t b_len) {
+        auto p = std::make_shared<std::vector<uint8_t>>(kRtpHeaderSize + a_len + b_len);
+        uint8_t* h = p->data();
+        h[0] = 0x80;  // V=2
+        h[1] = payload_type_;
+        h[2] = static_cast<uint8_t>(seq_ >> 8);
+        h[3] = static_cast<uint8_t>(seq_);
+        h[4] = static_cast<uint8_t>(ts >> 24);
+        h[5] = static_cast<uint8_t>(ts >> 16);
+        h[6] = static_cast<uint8_t>(ts >> 8);
+        h[7] = static_cast<uint8_t>(ts);
+        // SSRC (bytes 8..11) is left 0: every viewer writes its own.
+        std::memcpy(h + kRtpHeaderSize, a, a_len);
+        if (b_len) std::memcpy(h + kRtpHeaderSize + a_len, b, b_len);
+        ++seq_;
+        ++packets_;
+        return p;
+    }
+
+    size_t max_payload_;
+    uint8_t payload_type_;
+    uint16_t seq_ = 0;
+    uint64_t packets_ = 0;
+};
+
+// Per-viewer header rewrite. The viewer's sequence numbers and timestamps are
+// anchored at the first packet it is sent, so a viewer joining mid-stream (on a
+// keyframe) sees a contiguous sequence from its own random base.
+class RtpRewriter {
+public:
+    RtpRewriter(uint32_t ssrc = 0, uint16_t seq_base = 0, uint32_t ts_base = 0)
+        : ssrc_(ssrc), seq_base_(seq_base), ts_base_(ts_base) {}
+
+    bool started() const { return started_; }
+
+    // Copy `src` into `out` (reusing its capacity) with this viewer's header.
+    void rewrite(const std::vector<uint8_t>& src, std::vector<uint8_t>& out) {
+        out.assign(src.begin(), src.end());
+        if (out.size() < kRtpHeaderSize) return;
+        const uint16_t seq = static_cast<uint16_t>((src[2] << 8) | src[3]);
+        const uint32_t ts = (static_cast<uint32_t>(src[4]) << 24) | (static_cast<uint32_t>(src[5]) << 16) |
+                            (static_cast<uint32_t>(src[6]) << 8) | src[7];
+        if (!started_) {
+            started_ = true;
+            seq_delta_ = static_cast<uint16_t>(seq_base_ - seq);
+            ts_delta_ = ts_base_ - ts;
+        }
+        const uint16_t vseq = static_cast<uint16_t>(seq + seq_delta_);
+        const uint32_t vts = ts + ts_delta_;
+        out[2] = static_cast<uint8_t>(vseq >> 8);
+        out[3] = static_cast<uint8_t>(vseq);
+        out[4] = static_cast<uint8_t>(vts >> 24);
+        out[5] = static_cast<uint8_t>(vts >> 16);
+        out[6] = static_cast<uint8_t>(vts >> 8);
+        out[7] = static_cast<uint8_t>(vts);
+        out[8] = static_cast<uint8_t>(ssrc_ >> 24);
+        out[9] = static_cast<uint8_t>(ssrc_ >> 16);
+        out[10] = static_cast<uint8_t>(ssrc_ >> 8);
+        out[11] = static_cast<uint8_t>(ssrc_);
+    }
+
+private:
+    uint32_t ssrc_;
+    uint16_t seq_base_;
+    uint32_t ts_base_;
+    bool started_ = false;
+    uint16_t seq_delta_ = 0;
+    uint32_t ts_delta_ = 0;
+};
+
+} // namespace zm::webrtc
@@ -0,0 +1,101 @@
+#include "../rtp_fanout.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+using zm::webrtc::for_each_annexb_nal;
+using zm::webrtc::H264Packetizer;
+using zm::webrtc::RtpRewriter;
+
+namespace {
+
+uint16_t seq_of(const std::vector<uint8_t>& p) { return static_cast<uint16_t>((p[2] << 8) | p[3]); }
+uint32_t u32_at(const std::vector<uint8_t>& p, size_t i) {
+    return (uint32_t(p[i]) << 24) | (uint32_t(p[i + 1]) << 16) | (uint32_t(p[i + 2]) << 8) | p[i + 3];
+}
+
+// AUD + SPS + IDR slice of `idr_size` bytes, Annex-B.
+std::vector<uint8_t> access_unit(size_t idr_size) {
+    std::vector<uint8_t> au = {0, 0, 0, 1, 0x09, 0xf0,           // AUD
+                               0, 0, 0, 1, 0x67, 0x42, 0x00, 0x1f,  // SPS
+                               0, 0, 1, 0x65};                      // IDR header
+    for (size_t i = 1; i < idr_size; ++i) au.push_back(static_cast<uint8_t>(i));
+    return au;
+}
+
+}  // namespace
+
+TEST(RtpFanout, SplitsAnnexBNals) {
+    auto au = access_unit(10);
+    std::vector<std::vector<uint8_t>> nals;
+    for_each_annexb_nal(au.data(), au.size(), [&](const uint8_t* n, size_t len) {
+        nals.emplace_back(n, n + len);
+    });
+    ASSERT_EQ(nals.size(), 3u);
+    EXPECT_EQ(nals[0][0], 0x09);
+    EXPECT_EQ(nals[1].size(), 4u);
+    EXPECT_EQ(nals[2][0], 0x65);
+    EXPECT_EQ(nals[2].size(), 10u);
+}
+
+TEST(RtpFanout, SmallNalsAreSingleNalPacketsWithMarkerOnLast) {
+    H264Packetizer pk(1200);
+    auto au = access_unit(100);
+    auto f = pk.packetize(au.data(), au.size(), 1000000, true);
+    ASSERT_EQ(f->packets.size(), 2u);  // AUD dropped
+    EXPECT_EQ(f->rtp_timestamp, 90000u);
+    EXPECT_EQ((*f->packets[0])[12], 0x67);
+    EXPECT_EQ((*f->packets[0])[1] & 0x80, 0);
+    EXPECT_EQ((*f->packets[1])[1] & 0x80, 0x80);
+    EXPECT_EQ((*f->packets[1])[1] & 0x7f, 96);
+    EXPECT_EQ(seq_of(*f->packets[1]), seq_of(*f->packets[0]) + 1);
+}
+
+TEST(RtpFanout, LargeNalIsFragmentedAsFuA) {
+    H264Packetizer pk(100);
+    auto au = access_unit(250);  // IDR NAL: 1 header byte + 249 payload bytes
+    auto f = pk.packetize(au.data(), au.size(), 0, true);
+    ASSERT_EQ(f->packets.size(), 1u + 3u);  // SPS + ceil(249 / 98) FU-A
+    std::vector<uint8_t> rebuilt = {0x65};
+    for (size_t i = 1; i < f->packets.size(); ++i) {
+        const auto& p = *f->packets[i];
+        ASSERT_LE(p.size(), 12u + 100u);
+        EXPECT_EQ(p[12], (0x65 & 0xe0) | 28);
+        EXPECT_EQ(p[13] & 0x1f, 5);
+        EXPECT_EQ((p[13] & 0x80) != 0, i == 1);              // start bit
+        EXPECT_EQ((p[13] & 0x40) != 0, i + 1 == f->packets.size());  // end bit
+        rebuilt.insert(rebuilt.end(), p.begin() + 14, p.end());
+    }
+    EXPECT_EQ(rebuilt, std::vector<uint8_t>(au.begin() + 17, au.end()));
+}
+
+TEST(RtpFanout, ViewersShareBuffersAndRewriteOnlyHeaders) {
+    H264Packetizer pk(1200);
+    auto au = access_unit(50);
+    auto f1 = pk.packetize(au.data(), au.size(), 0, true);
+    auto f2 = pk.packetize(au.data(), au.size(), 40000, false);
+
+    RtpRewriter a(0xAAAA0001, 1000, 5000), b(0xBBBB0002, 65535, 0);
+    std::vector<uint8_t> out;
+    std::vector<uint16_t> a_seq, b_seq;
+    for (const auto& f : {f1, f2}) {
+        for (const auto& p : f->packets) {
+            a.rewrite(*p, out);
+            EXPECT_EQ(u32_at(out, 8), 0xAAAA0001u);
+            EXPECT_EQ(std::vector<uint8_t>(out.begin() + 12, out.end()),
+                      std::vector<uint8_t>(p->begin() + 12, p->end()));
+            a_seq.push_back(seq_of(out));
+            if (f == f2) {
+                EXPECT_EQ(u32_at(out, 4), 5000u + 3600u);
+            }
+            b.rewrite(*p, out);
+            b_seq.push_back(seq_of(out));
+        }
+    }
+    EXPECT_EQ(a_seq, (std::vector<uint16_t>{1000, 1001, 1002, 1003}));
+    EXPECT_EQ(b_seq, (std::vector<uint16_t>{65535, 0, 1, 2}));  // wraps
+    // The shared packet still carries the source header.
+    EXPECT_EQ(u32_at(*f1->packets[0], 8), 0u);
+}
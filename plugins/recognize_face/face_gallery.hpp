@@ -0,0 +1,345 @@
+#pragma once
+
+// Face gallery for large enrolments: one contiguous, row-major matrix of
+// L2-normalized embeddings, scored for all faces of a frame in one pass, with an
+// optional IVF (inverted file) index and a memory-mapped binary file format.
+// No ONNX Runtime dependency — unit-testable without a model.
+//
+// Binary gallery (".zmfg"), native little-endian, written by save() or the
+// face_gallery tool:
+//   GalleryFileHeader
+//   matrix     count x dim float32, rows grouped by IVF list
+//   centroids  nlist x dim float32 (nlist 0 = flat)
+//   lists      nlist+1 uint32 row offsets, list k = rows [lists[k], lists[k+1])
+//   names      count NUL-terminated UTF-8 strings, in row order
+// load() maps the file read-only and scores straight from the mapping, so every
+// worker process shares one page-cache copy and starts without parsing floats.
+
+#include "face_match.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace zm::face {
+
+// Dot product over `n` floats with 16 independent accumulators, so the loop
+// vectorises without -ffast-math (no reassociation of a single running sum).
+inline float dot(const float* a, const float* b, size_t n) {
+    constexpr size_t kLanes = 16;
+    float acc[kLanes] = {};
+    size_t i = 0;
+    for (; i + kLanes <= n; i += kLanes)
+        for (size_t j = 0; j < kLanes; ++j) acc[j] += a[i + j] * b[i + j];
+    float s = 0.0f;
+    for (size_t j = 0; j < kLanes; ++j) s += acc[j];
+    for (; i < n; ++i) s += a[i] * b[i];
+    return s;
+}
+
+// For rows [begin, end) of a row-major `dim`-wide matrix, keep each probe's
+// best score/row. Every gallery row is read once and scored against all probes
+// while it is in L1, so a frame with several faces streams the gallery once.
+inline void best_rows(const float* matrix, size_t dim, size_t begin, size_t end,
+                      const float* probes, int nprobes, float* bestScore, int64_t* bestRow) {
+    for (size_t r = begin; r < end; ++r) {
+        const float* row = matrix + r * dim;
+        for (int p = 0; p < nprobes; ++p) {
+            const float s = dot(row, probes + static_cast<size_t>(p) * dim, dim);
+            if (bestRow[p] < 0 || s > bestScore[p]) {
+                bestScore[p] = s;
+                bestRow[p] = static_cast<int64_t>(r);
+            }
+        }
+    }
+}
+
+struct GalleryFileHeader {
+    char magic[8];           // "ZMFGAL1\0"
+    uint32_t dim;
+    uint32_t count;
+    uint32_t nlist;
+    uint32_t reserved;
+    uint64_t matrixOffset;
+    uint64_t centroidsOffset;
+    uint64_t listsOffset;
+    uint64_t namesOffset;
+    uint64_t namesSize;
+};
+
+inline constexpr char kGalleryMagic[8] = {'Z', 'M', 'F', 'G', 'A', 'L', '1', '\0'};
+
+class FaceGallery {
+public:
+    FaceGallery() = default;
+    FaceGallery(const FaceGallery&) = delete;
+    FaceGallery& operator=(const FaceGallery&) = delete;
+
+    size_t size() const { return count_; }
+    size_t dim() const { return dim_; }
+    size_t lists() const { return nlist_; }
+    bool mapped() const { return map_ != nullptr; }
+    const std::string& name(size_t row) const { return names_[row]; }
+    const float* row(size_t r) const { return matrix_ + r * dim_; }
+
+    // Append an entry (in-memory galleries only). The embedding is
+    // L2-normalized; all entries must share the first entry's dimension.
+    bool add(std::string name, std::vector<float> emb) {
+        if (mapped() || emb.empty() || (dim_ && emb.size() != dim_)) return false;
+        l2_normalize(emb);
+        dim_ = emb.size();
+        owned_.insert(owned_.end(), emb.begin(), emb.end());
+        names_.push_back(std::move(name));
+        ++count_;
+        dropIndex();
+        matrix_ = owned_.data();
+        return true;
+    }
+
+    // Build an IVF index: spherical k-means into `nlist` lists (0 = sqrt(size)),
+    // then regroup rows so each list is contiguous. In-memory galleries only.
+    bool build_ivf(size_t nlist = 0, int iterations = 10, uint32_t seed = 1) {
+        if (mapped() || count_ == 0) return false;
+        if (nlist == 0) nlist = static_cast<size_t>(std::lround(std::sqrt(static_cast<double>(count_))));
+        nlist = std::clamp<size_t>(nlist, 1, count_);
+
+        std::mt19937 rng(seed);
+        std::vector<size_t> order(count_);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), rng);
+        std::vector<float> cent(nlist * dim_);
+        for (size_t k = 0; k < nlist; ++k)
+            std::copy_n(row(order[k]), dim_, cent.data() + k * dim_);
+
+        std::vector<uint32_t> assign(count_, 0);
+        std::vector<float> sums(nlist * dim_);
+        std::vector<size_t> counts(nlist);
+        for (int it = 0; it < iterations; ++it) {
+            for (size_t r = 0; r < count_; ++r) {
+                float best = 0.0f;
+                int64_t bestK = -1;
+                best_rows(cent.data(), dim_, 0, nlist, row(r), 1, &best, &bestK);
+                assign[r] = static_cast<uint32_t>(bestK);
+            }
+            std::fill(sums.begin(), sums.end(), 0.0f);
+            std::fill(counts.begin(), counts.end(), 0);
+            for (size_t r = 0; r < count_; ++r) {
+                float* s = sums.data() + assign[r] * dim_;
+                const float* v = row(r);
+                for (size_t d = 0; d < dim_; ++d) s[d] += v[d];
+                ++counts[assign[r]];
+            }
+            for (size_t k = 0; k < nlist; ++k) {
+                float* c = cent.data() + k * dim_;
+                if (counts[k] == 0) {  // reseed an empty list from a random row
+                    std::copy_n(row(rng() % count_), dim_, c);
+                    continue;
+                }
+                std::copy_n(sums.data() + k * dim_, dim_, c);
+                std::vector<float> tmp(c, c + dim_);
+                l2_normalize(tmp);
+                std::copy(tmp.begin(), tmp.end(), c);
+            }
+        }
+
+        // Regroup rows by list (stable, so equal lists keep enrolment order).
+        std::vector<size_t> perm(count_);
+        std::iota(perm.begin(), perm.end(), 0);
+        std::stable_sort(perm.begin(), perm.end(),
+                         [&](size_t a, size_t b) { return assign[a] < assign[b]; });
+        std::vector<float> matrix(owned_.size());
+        std::vector<std::string> names(count_);
+        for (size_t i = 0; i < count_; ++i) {
+            std::copy_n(row(perm[i]), dim_, matrix.data() + i * dim_);
+            names[i] = std::move(names_[perm[i]]);
+        }
+        owned_ = std::move(matrix);
+        names_ = std::move(names);
+        matrix_ = owned_.data();
+
+        ownedLists_.assign(nlist + 1, 0);
+        for (size_t r = 0; r < count_; ++r) ++ownedLists_[assign[r] + 1];
+        for (size_t k = 0; k < nlist; ++k) ownedLists_[k + 1] += ownedLists_[k];
+        ownedCentroids_ = std::move(cent);
+        centroids_ = ownedCentroids_.data();
+        lists_ = ownedLists_.data();
+        nlist_ = nlist;
+        return true;
+    }
+
+    // Best match per probe. `probes` holds nprobes embeddings of dim() floats,
+    // L2-normalized. With an IVF index, only the `nprobe_lists` lists whose
+    // centroids are closest are scanned (0 or >= lists() = exhaustive).
+    std::vector<Match> search(const float* probes, int nprobes, float threshold,
+                              size_t nprobe_lists = 8) const {
+        std::vector<Match> out(nprobes > 0 ? nprobes : 0, Match{"unknown", 0.0f});
+        if (count_ == 0 || nprobes <= 0) return out;
+        std::vector<float> score(nprobes, 0.0f);
+        std::vector<int64_t> best(nprobes, -1);
+
+        if (nlist_ == 0 || nprobe_lists == 0 || nprobe_lists >= nlist_) {
+            best_rows(matrix_, dim_, 0, count_, probes, nprobes, score.data(), best.data());
+        } else {
+            std::vector<float> cs(nlist_);
+            std::vector<uint32_t> ks(nlist_);
+            for (int p = 0; p < nprobes; ++p) {
+                const float* q = probes + static_cast<size_t>(p) * dim_;
+                for (size_t k = 0; k < nlist_; ++k) cs[k] = dot(centroids_ + k * dim_, q, dim_);
+                std::iota(ks.begin(), ks.end(), 0u);
+                std::partial_sort(ks.begin(), ks.begin() + nprobe_lists, ks.end(),
+                                  [&](uint32_t a, uint32_t b) { return cs[a] > cs[b]; });
+                for (size_t i = 0; i < nprobe_lists; ++i)
+                    best_rows(matrix_, dim_, lists_[ks[i]], lists_[ks[i] + 1], q, 1,
+                              &score[p], &best[p]);
+            }
+        }
+
+        for (int p = 0; p < nprobes; ++p) {
+            if (best[p] < 0) continue;
+            out[p].score = score[p];
+            if (score[p] >= threshold) out[p].name = names_[best[p]];
+        }
+        return out;
+    }
+
+    Match search(const std::vector<float>& probe, float threshold, size_t nprobe_lists = 8) const {
+        if (probe.size() != dim_) return Match{"unknown", 0.0f};
+        return search(probe.data(), 1, threshold, nprobe_lists)[0];
+    }
+
+    // Write the binary gallery format (see top of file).
+    bool save(const std::string& path, std::string* err = nullptr) const {
+        GalleryFileHeader h{};
+        std::memcpy(h.magic, kGalleryMagic, sizeof(h.magic));
+        h.dim = static_cast<uint32_t>(dim_);
+        h.count = static_cast<uint32_t>(count_);
+        h.nlist = static_cast<uint32_t>(nlist_);
+        h.matrixOffset = align(sizeof(h));
+        h.centroidsOffset = align(h.matrixOffset + count_ * dim_ * sizeof(float));
+        h.listsOffset = align(h.centroidsOffset + nlist_ * dim_ * sizeof(float));
+        h.namesOffset = h.listsOffset + (nlist_ ? (nlist_ + 1) * sizeof(uint32_t) : 0);
+        for (const auto& n : names_) h.namesSize += n.size() + 1;
+
+        FILE* f = std::fopen(path.c_str(), "wb");
+        if (!f) return fail(err, "cannot open " + path + " for writing");
+        bool ok = writeAt(f, 0, &h, sizeof(h)) &&
+                  writeAt(f, h.matrixOffset, matrix_, count_ * dim_ * sizeof(float));
+        if (ok && nlist_) {
+            ok = writeAt(f, h.centroidsOffset, centroids_, nlist_ * dim_ * sizeof(float)) &&
+                 writeAt(f, h.listsOffset, lists_, (nlist_ + 1) * sizeof(uint32_t));
+        }
+        if (ok && std::fseek(f, static_cast<long>(h.namesOffset), SEEK_SET) == 0) {
+            for (const auto& n : names_) ok = ok && std::fwrite(n.c_str(), 1, n.size() + 1, f) == n.size() + 1;
+        } else {
+            ok = false;
+        }
+        ok = (std::fclose(f) == 0) && ok;
+        return ok ? true : fail(err, "write failed: " + path);
+    }
+
+    // Map a binary gallery. Replaces the current contents.
+    bool load(const std::string& path, std::string* err = nullptr) {
+        clear();
+        map_ = io::MappedFile::open(path);
+        if (!map_) return fail(err, "cannot map " + path);
+        const uint8_t* base = map_->data();
+        const size_t size = map_->size();
+        GalleryFileHeader h{};
+        if (size < sizeof(h)) return failClear(err, "truncated header");
+        std::memcpy(&h, base, sizeof(h));
+        if (std::memcmp(h.magic, kGalleryMagic, sizeof(h.magic)) != 0)
+            return failClear(err, "not a face gallery file");
+        const uint64_t matrixBytes = uint64_t(h.count) * h.dim * sizeof(float);
+        const uint64_t centroidBytes = uint64_t(h.nlist) * h.dim * sizeof(float);
+        const uint64_t listBytes = h.nlist ? (uint64_t(h.nlist) + 1) * sizeof(uint32_t) : 0;
+        if (h.dim == 0 || h.matrixOffset % alignof(float) || h.listsOffset % alignof(uint32_t) ||
+            h.centroidsOffset % alignof(float) ||
+            h.matrixOffset + matrixBytes > size || h.centroidsOffset + centroidBytes > size ||
+            h.listsOffset + listBytes > size || h.namesOffset + h.namesSize > size)
+            return failClear(err, "corrupt or truncated gallery");
+
+        dim_ = h.dim;
+        count_ = h.count;
+        nlist_ = h.nlist;
+        matrix_ = reinterpret_cast<const float*>(base + h.matrixOffset);
+        if (nlist_) {
+            centroids_ = reinterpret_cast<const float*>(base + h.centroidsOffset);
+            lists_ = reinterpret_cast<const uint32_t*>(base + h.listsOffset);
+            if (lists_[0] != 0 || lists_[nlist_] != count_)
+                return failClear(err, "corrupt IVF lists");
+            for (size_t k = 0; k < nlist_; ++k)
+                if (lists_[k] > lists_[k + 1]) return failClear(err, "corrupt IVF lists");
+        }
+
+        const char* p = reinterpret_cast<const char*>(base + h.namesOffset);
+        const char* end = p + h.namesSize;
+        names_.reserve(count_);
+        while (p < end && names_.size() < count_) {
+            const char* z = static_cast<const char*>(std::memchr(p, '\0', end - p));
+            if (!z) break;
+            names_.emplace_back(p, z);
+            p = z + 1;
+        }
+        if (names_.size() != count_) return failClear(err, "corrupt name table");
+        return true;
+    }
+
+    void clear() {
+        map_.reset();
+        owned_.clear();
+        names_.clear();
+        dropIndex();
+        matrix_ = nullptr;
+        dim_ = count_ = 0;
+    }
+
+private:
+    static uint64_t align(uint64_t off) { return (off + 63) & ~uint64_t(63); }
+
+    static bool writeAt(FILE* f, uint64_t off, const void* data, size_t bytes) {
+        if (std::fseek(f, static_cast<long>(off), SEEK_SET) != 0) return false;
+        return bytes == 0 || std::fwrite(data, 1, bytes, f) == bytes;
+    }
+
+    static bool fail(std::string* err, const std::string& msg) {
+        if (err) *err = msg;
+        return false;
+    }
+    bool failClear(std::string* err, const std::string& msg) {
+        clear();
+        return fail(err, msg);
+    }
+
+    void dropIndex() {
+        ownedCentroids_.clear();
+        ownedLists_.clear();
+        centroids_ = nullptr;
+        lists_ = nullptr;
+        nlist_ = 0;
+    }
+
+    // Views used for scoring: into owned_/ownedCentroids_/ownedLists_ for an
+    // in-memory gallery, or into map_ for a loaded file.
+    const float* matrix_ = nullptr;
+    const float* centroids_ = nullptr;
+    const uint32_t* lists_ = nullptr;
+    size_t dim_ = 0;
+    size_t count_ = 0;
+    size_t nlist_ = 0;
+
+    std::vector<std::string> names_;
+    std::vector<float> owned_;
+    std::vector<float> ownedCentroids_;
+    std::vector<uint32_t> ownedLists_;
+    std::shared_ptr<const io::MappedFile> map_;
+};
+
+} // namespace zm::face
@@ -2,12 +2,27 @@
 //
 // Stage 1 — a FACE DETECTOR ONNX model produces face boxes. Stage 2 — a face
 // EMBEDDER (ArcFace / MobileFaceNet-style) ONNX model produces a 512-D
-// embedding per detected face. Each embedding is matched by cosine similarity
-// against a configured gallery of known people; a single "face" recognition
-// event is published when one or more faces are present.
+// embedding per detected face. The embeddings of all faces in a frame are
+// matched by cosine similarity against the gallery of known people in one pass
+// (FaceGallery: contiguous normalized matrix, optional IVF index, optionally
+// memory-mapped from a binary file); a single "face" recognition event is
+// published when one or more faces are present.
+//
+// Track-aware skipping: when the pipeline runs the tracker, each face is tied to
+// the tracked person containing it and its match is cached per track_id. The
+// embedder only re-runs for a track when its result is older than refresh_ms or
+// a clearly better view (size, sharpness, confidence) arrives, and frames whose
+// tracked people are all covered skip the face detector entirely; their cached
+// faces are republished at the tracks' current positions ("cached": true).
+//
+// Frames reach both models through zm::hw::InferPipeline: the detector input is
+// a letterbox of the surface, and every face crop needing an embedding is
+// stretched into ONE [n,3,es,es] batch (one Run when the embedder has a dynamic
+// batch dimension). With "hw" naming a device backend the detector runs on the
+// decoded device surface in place.
 //
 // This is a pass-through DETECT stage: the frame is ALWAYS forwarded downstream.
-// If either model is missing/unloadable, the frame is not RGB24, or the stream
+// If either model is missing/unloadable, the frame is not usable, or the stream
 // is filtered out, the plugin simply forwards.
 //
 // IMPORTANT: the face DETECTOR must be exported NMS-free, exactly like
@@ -15,17 +30,15 @@
 // (x1, y1, x2, y2, conf, class). We reuse zm::detect::decode_nms_free to turn
 // it into source-pixel face boxes.
 
+#include "face_gallery.hpp"
 #include "face_match.hpp"
 #include "../detect_onnx/detect_postprocess.hpp"
-
-#include <onnxruntime_cxx_api.h>
-#ifdef __APPLE__
-#include <coreml_provider_factory.h>
-#endif
+#include "../detect_onnx/infer_pipeline.hpp"
+#include "../detect_onnx/ort_model.hpp"
+#include "track_feed.hpp"
 
 #include <nlohmann/json.hpp>
 
-#include <array>
 #include <memory>
 #include <string>
 #include <vector>
@@ -42,17 +55,10 @@ struct RecognizeFaceCtx {
     zm_host_api_t* host = nullptr;
     void* hostCtx = nullptr;
 
-    // ONNX Runtime state (shared env + options, one session per stage).
-    std::unique_ptr<Ort::Env> env;
-    Ort::SessionOptions sessionOptions;
-
-    std::unique_ptr<Ort::Session> detector;
-    std::string detInputName;
-    std::string detOutputName;
-
-    std::unique_ptr<Ort::Session> embedder;
-    std::string embInputName;
-    std::string embOutputName;
+    // Frame acquire/preprocess and one ONNX Runtime session per stage.
+    zm::hw::InferPipeline pipeline;
+    zm::hw::OrtModel detector;
+    zm::hw::OrtModel embedder;
 
     // Config.
     std::string detectorModelPath;
@@ -66,11 +72,25 @@ struct RecognizeFaceCtx {
     int frameWidth = 0;
     int frameHeight = 0;
     std::string ep = "cpu";
+    std::string hw = "cpu";        // HwBackend for device surfaces
     std::vector<int> streamFilter; // empty = all
+    std::string galleryPath;       // binary gallery (mmap); overrides "gallery"
+    std::string index = "flat";    // "flat" | "ivf" (for config galleries)
+    int ivfLists = 0;              // 0 = sqrt(gallery size)
+    int ivfProbe = 8;              // IVF lists scanned per face
+
+    zm::face::FaceGallery gallery;
 
-    std::vector<zm::face::GalleryEntry> gallery;
+    // Track-aware skipping (see top of file).
+    bool useTracks = true;
+    std::vector<std::string> trackLabels{"person"};
+    uint64_t trackMaxAgeUs = 500000;
+    zm::track::TrackCacheOptions trackOptions;
+    zm::track::TrackFeed* tracks = nullptr;  // leaked on stop (see track_feed.hpp)
+    std::unique_ptr<zm::track::TrackResultCache<zm::face::Match>> trackCache;
 
     bool warnedUnsupportedShape = false;
+    bool warnedDeviceCrops = false;
 };
 
 void forwardFrame(RecognizeFaceCtx* ctx, const void* buf, size_t size) {
@@ -78,97 +98,88 @@ void forwardFrame(RecognizeFaceCtx* ctx, const void* buf, size_t size) {
         ctx->host->on_frame(ctx->hostCtx, buf, size);
 }
 
-// Create a session from `path`, capturing its first input/output names.
-// Returns nullptr (and logs) on failure so the caller can run pass-through.
-std::unique_ptr<Ort::Session> makeSession(RecognizeFaceCtx* ctx, const std::string& path,
-                                          const char* tag, std::string& inName,
-                                          std::string& outName) {
-    if (path.empty() || !ctx->env) return nullptr;
-    try {
-        auto session = std::make_unique<Ort::Session>(*ctx->env, path.c_str(),
-                                                      ctx->sessionOptions);
-        Ort::AllocatorWithDefaultOptions allocator;
-        auto in = session->GetInputNameAllocated(0, allocator);
-        auto out = session->GetOutputNameAllocated(0, allocator);
-        inName = in.get();
-        outName = out.get();
-        ZM_LOG_INFO("recognize_face: loaded %s model '%s' (input='%s' output='%s')",
-                    tag, path.c_str(), inName.c_str(), outName.c_str());
-        return session;
-    } catch (const std::exception& e) {
+// Load one stage's model; logs and returns false so the caller can run
+// pass-through.
+bool loadModel(RecognizeFaceCtx* ctx, zm::hw::OrtModel& model, const std::string& path,
+               const char* tag) {
+    if (path.empty()) return false;
+    std::string err, note;
+    if (!model.load(path, ctx->ep, "recognize_face", &err, &note)) {
         ZM_LOG_ERROR("recognize_face: failed to load %s model '%s': %s",
-                     tag, path.c_str(), e.what());
-        return nullptr;
+                     tag, path.c_str(), err.c_str());
+        return false;
     }
+    if (!note.empty()) ZM_LOG_WARN("recognize_face: %s", note.c_str());
+    ZM_LOG_INFO("recognize_face: loaded %s model '%s' (input='%s' output='%s') %s",
+                tag, path.c_str(), model.input_name().c_str(), model.output_names()[0].c_str(),
+                model.load_stats().summary().c_str());
+    return true;
 }
 
-// Run the embedder on an embedSize x embedSize RGB24 crop, returning an
-// L2-normalized embedding (empty on failure).
-std::vector<float> runEmbedder(RecognizeFaceCtx* ctx, const uint8_t* rgb) {
-    std::vector<float> emb;
-    if (!ctx->embedder) return emb;
-    const int es = ctx->embedSize;
-    const int plane = es * es;
-
-    // Interleaved RGB24 -> planar CHW float, normalized (pixel - mean) / scale.
-    std::vector<float> input(static_cast<size_t>(3) * plane);
-    for (int y = 0; y < es; ++y) {
-        for (int x = 0; x < es; ++x) {
-            for (int c = 0; c < 3; ++c) {
-                const float p = rgb[(y * es + x) * 3 + c];
-                input[c * plane + y * es + x] = (p - ctx->embedMean) / ctx->embedScale;
-            }
+// Run the embedder on `crops` of the surface (source pixels), returning one
+// L2-normalized embedding per crop (all empty on failure).
+std::vector<std::vector<float>> runEmbedder(RecognizeFaceCtx* ctx, const zm::hw::Surface& surface,
+                                            const std::vector<zm::hw::Region>& crops) {
+    std::vector<std::vector<float>> embs(crops.size());
+    if (!ctx->embedder.loaded() || crops.empty()) return embs;
+
+    // (pixel - mean) / scale, stretched to embedSize x embedSize.
+    zm::hw::TensorSpec spec;
+    spec.width = spec.height = ctx->embedSize;
+    spec.letterbox = false;
+    spec.mean = ctx->embedMean;
+    spec.scale = 1.0f / ctx->embedScale;
+    zm::hw::BatchTensor input = ctx->pipeline.preprocess(surface, crops, spec);
+    if (!input.valid() || (input.device && !ctx->embedder.device_inputs())) {
+        if (!ctx->warnedDeviceCrops) {
+            ZM_LOG_WARN("recognize_face: %s backend cannot produce embedder crops; "
+                        "faces are reported unmatched", surface.owner ? "device" : "cpu");
+            ctx->warnedDeviceCrops = true;
         }
+        return embs;
     }
 
-    try {
-        Ort::MemoryInfo memInfo =
-            Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
-        std::array<int64_t, 4> inputShape{1, 3, es, es};
-        Ort::Value inputTensor = Ort::Value::CreateTensor<float>(
-            memInfo, input.data(), input.size(), inputShape.data(), inputShape.size());
-
-        const char* inputNames[] = {ctx->embInputName.c_str()};
-        const char* outputNames[] = {ctx->embOutputName.c_str()};
+    auto collect = [&](const Ort::Value& out, size_t first, size_t count) {
+        const float* data = out.GetTensorData<float>();
+        const size_t total = out.GetTensorTypeAndShapeInfo().GetElementCount();
+        const size_t per = count ? total / count : 0;
+        for (size_t i = 0; i < count && per > 0; ++i) {
+            embs[first + i].assign(data + i * per, data + (i + 1) * per);
+            zm::face::l2_normalize(embs[first + i]);
+        }
+    };
 
-        auto outputs = ctx->embedder->Run(Ort::RunOptions{nullptr}, inputNames,
-                                          &inputTensor, 1, outputNames, 1);
-        const float* out = outputs[0].GetTensorData<float>();
-        auto shape = outputs[0].GetTensorTypeAndShapeInfo().GetShape();
-        size_t n = 1;
-        for (auto d : shape) if (d > 0) n *= static_cast<size_t>(d);
-        emb.assign(out, out + n);
-        zm::face::l2_normalize(emb);
+    try {
+        if (ctx->embedder.dynamic_batch() || input.n == 1) {
+            auto outputs = ctx->embedder.run(input);
+            collect(outputs[0], 0, static_cast<size_t>(input.n));
+        } else {
+            // Fixed batch-1 export: one Run per crop over the same batch buffer.
+            const int64_t es = ctx->embedSize;
+            for (int i = 0; i < input.n; ++i) {
+                auto outputs = ctx->embedder.run(input.data + i * input.item_floats(),
+                                                 {1, 3, es, es}, input.device);
+                collect(outputs[0], static_cast<size_t>(i), 1);
+            }
+        }
     } catch (const std::exception& e) {
         ZM_LOG_ERROR("recognize_face: embedder inference error: %s", e.what());
-        emb.clear();
+        for (auto& e2 : embs) e2.clear();
     }
-    return emb;
+    return embs;
 }
 
-// Run the detector on a w x h RGB24 frame, returning source-pixel face boxes.
-std::vector<zm::detect::Box> runDetector(RecognizeFaceCtx* ctx, const uint8_t* rgb,
-                                         int w, int h) {
+// Run the detector on the surface, returning source-pixel face boxes.
+std::vector<zm::detect::Box> runDetector(RecognizeFaceCtx* ctx, const zm::hw::Surface& surface) {
     std::vector<zm::detect::Box> boxes;
-    if (!ctx->detector) return boxes;
+    if (!ctx->detector.loaded()) return boxes;
     try {
-        const int net = ctx->net;
-        zm::detect::Letterbox lb = zm::detect::compute_letterbox(w, h, net);
-
-        std::vector<float> input(static_cast<size_t>(3) * net * net);
-        zm::detect::letterbox_rgb_to_chw(rgb, lb, input.data());
-
-        Ort::MemoryInfo memInfo =
-            Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
-        std::array<int64_t, 4> inputShape{1, 3, net, net};
-        Ort::Value inputTensor = Ort::Value::CreateTensor<float>(
-            memInfo, input.data(), input.size(), inputShape.data(), inputShape.size());
-
-        const char* inputNames[] = {ctx->detInputName.c_str()};
-        const char* outputNames[] = {ctx->detOutputName.c_str()};
-
-        auto outputs = ctx->detector->Run(Ort::RunOptions{nullptr}, inputNames,
-                                          &inputTensor, 1, outputNames, 1);
+        zm::hw::TensorSpec spec;
+        spec.width = spec.height = ctx->net;
+        const zm::hw::BatchTensor input = ctx->pipeline.preprocess(surface, {}, spec);
+        if (!input.valid() || (input.device && !ctx->detector.device_inputs())) return boxes;
+        const zm::detect::Letterbox& lb = input.lb[0];
+        auto outputs = ctx->detector.run(input);
         const float* out = outputs[0].GetTensorData<float>();
         auto shape = outputs[0].GetTensorTypeAndShapeInfo().GetShape();
 
@@ -198,19 +209,36 @@ std::vector<zm::detect::Box> runDetector(RecognizeFaceCtx* ctx, const uint8_t* r
 // Load the gallery from config. Each entry is either {name, embedding:[...]} or
 // {name, image_path:"..."}. Precomputed embeddings are the primary path; image
 // galleries are best-effort and currently unsupported (logged and skipped).
+// Large galleries should use gallery_path (a binary file built with the
+// face_gallery tool) instead, which is mapped rather than parsed.
 void loadGallery(RecognizeFaceCtx* ctx, const json& arr) {
+    if (!ctx->galleryPath.empty()) {
+        std::string err;
+        if (!ctx->gallery.load(ctx->galleryPath, &err)) {
+            ZM_LOG_ERROR("recognize_face: failed to load gallery '%s': %s",
+                         ctx->galleryPath.c_str(), err.c_str());
+        } else {
+            if (arr.is_array() && !arr.empty())
+                ZM_LOG_WARN("recognize_face: gallery_path set; ignoring inline 'gallery'");
+            ZM_LOG_INFO("recognize_face: mapped gallery '%s' (%zu entries, dim %zu, %zu IVF lists)",
+                        ctx->galleryPath.c_str(), ctx->gallery.size(), ctx->gallery.dim(),
+                        ctx->gallery.lists());
+        }
+        return;
+    }
+
     if (!arr.is_array()) return;
     for (const auto& e : arr) {
         if (!e.is_object() || !e.contains("name")) continue;
-        zm::face::GalleryEntry g;
-        g.name = e.value("name", std::string());
-        if (g.name.empty()) continue;
+        std::string name = e.value("name", std::string());
+        if (name.empty()) continue;
 
         if (e.contains("embedding") && e["embedding"].is_array()) {
-            g.emb = e["embedding"].get<std::vector<float>>();
-            if (g.emb.empty()) continue;
-            zm::face::l2_normalize(g.emb);  // idempotent if already normalized
-            ctx->gallery.push_back(std::move(g));
+            auto emb = e["embedding"].get<std::vector<float>>();
+            if (emb.empty()) continue;
+            if (!ctx->gallery.add(name, std::move(emb)))
+                ZM_LOG_WARN("recognize_face: skipping '%s' (embedding size differs from %zu)",
+                            name.c_str(), ctx->gallery.dim());
             continue;
         }
 
@@ -220,12 +248,15 @@ void loadGallery(RecognizeFaceCtx* ctx, const json& arr) {
             // build — precomputed embeddings are the reliable path.
             ZM_LOG_WARN("recognize_face: image gallery not supported in this build; "
                         "skipping '%s' (provide a precomputed 'embedding' instead)",
-                        g.name.c_str());
+                        name.c_str());
             continue;
         }
     }
-    ZM_LOG_INFO("recognize_face: loaded %zu gallery entr%s",
-                ctx->gallery.size(), ctx->gallery.size() == 1 ? "y" : "ies");
+    if (ctx->index == "ivf" && ctx->gallery.size() > 0)
+        ctx->gallery.build_ivf(static_cast<size_t>(std::max(0, ctx->ivfLists)));
+    ZM_LOG_INFO("recognize_face: loaded %zu gallery entr%s (%zu IVF lists)",
+                ctx->gallery.size(), ctx->gallery.size() == 1 ? "y" : "ies",
+                ctx->gallery.lists());
 }
 
 } // namespace
@@ -254,10 +285,22 @@ static int recognize_face_start(zm_plugin_t* plugin, zm_host_api_t* host, void*
             ctx->frameWidth = j.value("frame_width", 0);
             ctx->frameHeight = j.value("frame_height", 0);
             ctx->ep = j.value("ep", std::string("cpu"));
+            ctx->hw = j.value("hw", std::string("cpu"));
             if (j.contains("stream_filter") && j["stream_filter"].is_array())
                 ctx->streamFilter = j["stream_filter"].get<std::vector<int>>();
+            ctx->galleryPath = j.value("gallery_path", std::string());
+            ctx->index = j.value("index", std::string("flat"));
+            ctx->ivfLists = j.value("ivf_lists", 0);
+            ctx->ivfProbe = std::max(1, j.value("ivf_probe", 8));
             if (j.contains("gallery"))
                 galleryJson = j["gallery"];
+            ctx->useTracks = j.value("use_tracks", true);
+            if (j.contains("track_labels") && j["track_labels"].is_array())
+                ctx->trackLabels = j["track_labels"].get<std::vector<std::string>>();
+            ctx->trackMaxAgeUs = static_cast<uint64_t>(std::max(0, j.value("track_max_age_ms", 500))) * 1000;
+            ctx->trackOptions.refresh_us = static_cast<uint64_t>(std::max(0, j.value("refresh_ms", 5000))) * 1000;
+            ctx->trackOptions.miss_retry_us = static_cast<uint64_t>(std::max(0, j.value("miss_retry_ms", 1000))) * 1000;
+            ctx->trackOptions.quality_gain = j.value("quality_gain", 1.25f);
         } catch (const std::exception& e) {
             ZM_LOG_ERROR("recognize_face: failed to parse config: %s", e.what());
         }
@@ -265,44 +308,25 @@ static int recognize_face_start(zm_plugin_t* plugin, zm_host_api_t* host, void*
 
     if (ctx->embedScale == 0.0f) ctx->embedScale = 128.0f;
 
-    // Create the ONNX Runtime environment and shared session options.
-    try {
-        ctx->env = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "recognize_face");
-        ctx->sessionOptions.SetIntraOpNumThreads(1);
-        ctx->sessionOptions.SetGraphOptimizationLevel(ORT_ENABLE_ALL);
-    } catch (const std::exception& e) {
-        ZM_LOG_ERROR("recognize_face: failed to init ORT env: %s", e.what());
-    }
+    const std::string backend = ctx->pipeline.open(ctx->hw);
+    if (ctx->hw != "cpu" && backend == "cpu")
+        ZM_LOG_WARN("recognize_face: hw backend '%s' unavailable; RGB24 frames only",
+                    ctx->hw.c_str());
 
-    // Optionally append the CoreML execution provider, falling back to CPU.
-    if (ctx->ep == "coreml") {
-#ifdef __APPLE__
-        try {
-            uint32_t coreml_flags = 0;
-            Ort::ThrowOnError(OrtSessionOptionsAppendExecutionProvider_CoreML(
-                static_cast<OrtSessionOptions*>(ctx->sessionOptions), coreml_flags));
-            ZM_LOG_INFO("recognize_face: CoreML execution provider enabled");
-        } catch (const std::exception& e) {
-            ZM_LOG_WARN("recognize_face: CoreML EP unavailable, falling back to CPU: %s",
-                        e.what());
-        }
-#else
-        ZM_LOG_WARN("recognize_face: CoreML EP not available on this platform, falling back to CPU");
-#endif
-    }
-
-    ctx->detector = makeSession(ctx, ctx->detectorModelPath, "detector",
-                                ctx->detInputName, ctx->detOutputName);
-    ctx->embedder = makeSession(ctx, ctx->embedderModelPath, "embedder",
-                                ctx->embInputName, ctx->embOutputName);
-
-    if (!ctx->detector || !ctx->embedder) {
+    const bool haveDetector = loadModel(ctx, ctx->detector, ctx->detectorModelPath, "detector");
+    const bool haveEmbedder = loadModel(ctx, ctx->embedder, ctx->embedderModelPath, "embedder");
+    if (!haveDetector || !haveEmbedder) {
         ZM_LOG_WARN("recognize_face: detector and/or embedder not loaded; "
                     "running as pass-through");
     }
 
     loadGallery(ctx, galleryJson);
 
+    if (ctx->useTracks) {
+        ctx->tracks = zm::track::subscribe_tracks(host, host_ctx, ctx->trackLabels);
+        ctx->trackCache = std::make_unique<zm::track::TrackResultCache<zm::face::Match>>(ctx->trackOptions);
+    }
+
     plugin->instance = ctx;
     return 0;
 }
@@ -310,6 +334,7 @@ static int recognize_face_start(zm_plugin_t* plugin, zm_host_api_t* host, void*
 static void recognize_face_stop(zm_plugin_t* plugin) {
     auto* ctx = static_cast<RecognizeFaceCtx*>(plugin->instance);
     if (ctx) {
+        zm::track::unsubscribe_tracks(ctx->host, ctx->hostCtx, ctx->tracks);
         delete ctx;
         plugin->instance = nullptr;
     }
@@ -323,10 +348,9 @@ static void recognize_face_on_frame(zm_plugin_t* plugin, const void* buf, size_t
     }
 
     const zm_frame_hdr_t* hdr = static_cast<const zm_frame_hdr_t*>(buf);
-    const uint8_t* payload = static_cast<const uint8_t*>(buf) + sizeof(zm_frame_hdr_t);
 
-    // Pass-through unless both models are loaded and the frame is usable RGB24.
-    if (!ctx->detector || !ctx->embedder || hdr->hw_type != ZM_FRAME_RGB24) {
+    // Pass-through unless both models are loaded and the frame is usable.
+    if (!ctx->detector.loaded() || !ctx->embedder.loaded()) {
         forwardFrame(ctx, buf, size);
         return;
     }
@@ -337,52 +361,151 @@ static void recognize_face_on_frame(zm_plugin_t* plugin, const void* buf, size_t
         return;
     }
 
-    const int w = ctx->frameWidth;
-    const int h = ctx->frameHeight;
-    if (w <= 0 || h <= 0 ||
-        size < sizeof(zm_frame_hdr_t) + static_cast<size_t>(w) * h * 3) {
+    zm::hw::Surface surface;
+    if (!ctx->pipeline.acquire(buf, size, ctx->frameWidth, ctx->frameHeight, surface)) {
         forwardFrame(ctx, buf, size);
         return;
     }
-
-    // Stage 1: detect faces.
-    std::vector<zm::detect::Box> faces = runDetector(ctx, payload, w, h);
-
-    if (!faces.empty()) {
-        json facesJson = json::array();
-        std::vector<uint8_t> crop;
-        for (const auto& f : faces) {
+    // Host pixels for the sharpness term (nullptr on device surfaces).
+    const uint8_t* rgb = zm::hw::InferPipeline::host_rgb(surface);
+    const int w = surface.width;
+    const int h = surface.height;
+
+    // Tracked people in view (only when the tracker is feeding this stream).
+    std::vector<zm::track::TrackBox> tracks;
+    auto* cache = ctx->trackCache.get();
+    const bool haveTracks =
+        cache && ctx->tracks &&
+        ctx->tracks->index.latest(hdr->stream_id, hdr->pts_usec, ctx->trackMaxAgeUs, tracks);
+    if (haveTracks) cache->expire(hdr->stream_id, hdr->pts_usec);
+
+    json facesJson = json::array();
+    auto addFace = [&](const zm::face::Match& m, int x, int y, int fw, int fh, int trackId,
+                       bool cached) {
+        json fj;
+        fj["name"] = m.name;
+        fj["similarity"] = m.score;
+        fj["bbox"] = {x, y, fw, fh};
+        if (trackId > 0) fj["track_id"] = trackId;
+        if (cached) fj["cached"] = true;
+        facesJson.push_back(std::move(fj));
+    };
+
+    if (haveTracks && cache->covers(hdr->stream_id, tracks, hdr->pts_usec)) {
+        // Every tracked person already has a fresh match (or recently showed no
+        // face): skip detection and republish the cached faces.
+        for (const auto& t : tracks) {
+            const auto* e = cache->find(hdr->stream_id, t.id);
+            if (!e || e->missed) continue;
+            float fx, fy, fw, fh;
+            zm::track::from_relative(t, e->rel, fx, fy, fw, fh);
+            addFace(e->result, static_cast<int>(std::lround(fx)), static_cast<int>(std::lround(fy)),
+                    static_cast<int>(std::lround(fw)), static_cast<int>(std::lround(fh)), t.id, true);
+        }
+    } else {
+        // Stage 1: detect faces.
+        std::vector<zm::detect::Box> faces = runDetector(ctx, surface);
+
+        // Stage 2: crop -> embedder for every face that needs it, then score all
+        // embeddings against the gallery at once.
+        struct FaceRow { int x, y, w, h; int probe; int ti; int track; float quality; bool cached; };
+        std::vector<FaceRow> rows;
+        std::vector<zm::hw::Region> crops;
+        std::vector<bool> trackSeen(tracks.size(), false);
+        const size_t dim = ctx->gallery.dim();
+        faces.erase(std::remove_if(faces.begin(), faces.end(),
+                                   [](const zm::detect::Box& f) {
+                                       return std::lround(f.w) <= 0 || std::lround(f.h) <= 0;
+                                   }),
+                    faces.end());
+        // One face per tracked person: a second face inside the same box is
+        // always inferred, never served that track's cached identity.
+        std::vector<zm::track::DetBox> faceBoxes;
+        std::vector<int> trackOf(faces.size(), -1);
+        if (haveTracks) {
+            for (const auto& f : faces)
+                faceBoxes.push_back({f.x, f.y, f.w, f.h,
+                                     zm::track::box_quality(
+                                         f.confidence, f.w, f.h,
+                                         rgb ? zm::track::region_sharpness(rgb, w, h, f.x, f.y,
+                                                                           f.w, f.h)
+                                             : 0.0f)});
+            trackOf = zm::track::associate(tracks, faceBoxes);
+        }
+        for (size_t i = 0; i < faces.size(); ++i) {
+            const auto& f = faces[i];
             const int fx = static_cast<int>(std::lround(f.x));
             const int fy = static_cast<int>(std::lround(f.y));
             const int fw = static_cast<int>(std::lround(f.w));
             const int fh = static_cast<int>(std::lround(f.h));
-            if (fw <= 0 || fh <= 0) continue;
 
-            // Stage 2: crop -> embedder -> match.
-            zm::face::crop_resize_rgb(payload, w, h, fx, fy, fw, fh,
-                                      ctx->embedSize, ctx->embedSize, crop);
-            std::vector<float> emb = runEmbedder(ctx, crop.data());
+            FaceRow r{fx, fy, fw, fh, -1, -1, 0, 0.0f, false};
+            if (haveTracks) {
+                const int ti = trackOf[i];
+                if (ti >= 0) {
+                    trackSeen[ti] = true;
+                    r.ti = ti;
+                    r.track = tracks[ti].id;
+                }
+                r.quality = faceBoxes[i].quality;
+                if (r.track > 0 &&
+                    !cache->needs_run(hdr->stream_id, r.track, r.quality, hdr->pts_usec)) {
+                    r.cached = true;
+                    cache->hit(hdr->stream_id, r.track, hdr->pts_usec,
+                               zm::track::to_relative(tracks[ti], f.x, f.y, f.w, f.h));
+                    rows.push_back(r);
+                    continue;
+                }
+            }
 
-            zm::face::Match m{"unknown", 0.0f};
-            if (!emb.empty())
-                m = zm::face::best_match(ctx->gallery, emb, ctx->matchThreshold);
-
-            json fj;
-            fj["name"] = m.name;
-            fj["similarity"] = m.score;
-            fj["bbox"] = {fx, fy, fw, fh};
-            facesJson.push_back(std::move(fj));
+            r.probe = static_cast<int>(crops.size());
+            crops.push_back({fx, fy, fw, fh});
+            rows.push_back(r);
         }
 
-        if (!facesJson.empty()) {
-            json evt;
-            evt["type"] = "face";
-            evt["stream_id"] = hdr->stream_id;
-            evt["pts_usec"] = hdr->pts_usec;
-            evt["faces"] = std::move(facesJson);
-            if (ctx->host && ctx->host->publish_evt)
-                ctx->host->publish_evt(ctx->hostCtx, evt.dump().c_str());
+        // One embedder pass over every crop; rows whose embedding failed (or
+        // has the wrong size for the gallery) fall back to "unknown".
+        const std::vector<std::vector<float>> embs = runEmbedder(ctx, surface, crops);
+        std::vector<float> probes;
+        std::vector<int> probeOf(crops.size(), -1);
+        for (size_t i = 0; i < embs.size(); ++i) {
+            if (embs[i].empty() || embs[i].size() != dim) continue;
+            probeOf[i] = static_cast<int>(probes.size() / dim);
+            probes.insert(probes.end(), embs[i].begin(), embs[i].end());
         }
+        for (auto& r : rows)
+            if (r.probe >= 0) r.probe = probeOf[r.probe];
+
+        const int nprobes = dim ? static_cast<int>(probes.size() / dim) : 0;
+        const std::vector<zm::face::Match> matches = ctx->gallery.search(
+            probes.data(), nprobes, ctx->matchThreshold, static_cast<size_t>(ctx->ivfProbe));
+
+        for (const auto& r : rows) {
+            zm::face::Match m{"unknown", 0.0f};
+            if (r.cached) {
+                m = cache->find(hdr->stream_id, r.track)->result;
+            } else if (r.probe >= 0) {
+                m = matches[r.probe];
+            }
+            if (!r.cached && r.probe >= 0 && r.track > 0)
+                cache->store(hdr->stream_id, r.track, hdr->pts_usec, r.quality, m,
+                             zm::track::to_relative(tracks[r.ti], r.x, r.y, r.w, r.h));
+            addFace(m, r.x, r.y, r.w, r.h, r.track, r.cached);
+        }
+        for (size_t i = 0; i < tracks.size(); ++i)
+            if (!trackSeen[i]) cache->miss(hdr->stream_id, tracks[i].id, hdr->pts_usec);
+    }
+
+    ctx->pipeline.release(surface);
+
+    if (!facesJson.empty()) {
+        json evt;
+        evt["type"] = "face";
+        evt["stream_id"] = hdr->stream_id;
+        evt["pts_usec"] = hdr->pts_usec;
+        evt["faces"] = std::move(facesJson);
+        if (ctx->host && ctx->host->publish_evt)
+            ctx->host->publish_evt(ctx->hostCtx, evt.dump().c_str());
     }
 
     forwardFrame(ctx, buf, size);
@@ -0,0 +1,157 @@
+// Unit tests for the matrix/IVF face gallery and its mapped file format.
+
+#include "../face_gallery.hpp"
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace zm::face;
+
+namespace {
+
+std::vector<float> randomUnit(std::mt19937& rng, size_t dim) {
+    std::normal_distribution<float> n(0.0f, 1.0f);
+    std::vector<float> v(dim);
+    for (auto& x : v) x = n(rng);
+    l2_normalize(v);
+    return v;
+}
+
+// A probe close to `base` (same identity, different capture).
+std::vector<float> jitter(std::mt19937& rng, const std::vector<float>& base, float amount) {
+    std::normal_distribution<float> n(0.0f, amount);
+    std::vector<float> v = base;
+    for (auto& x : v) x += n(rng);
+    l2_normalize(v);
+    return v;
+}
+
+std::string tempPath(const char* tag) {
+    return ::testing::TempDir() + "face_gallery_" + tag + ".zmfg";
+}
+
+}  // namespace
+
+TEST(FaceGallery, DotMatchesScalarSum) {
+    std::vector<float> a(37), b(37);
+    double ref = 0.0;
+    for (int i = 0; i < 37; ++i) {
+        a[i] = 0.1f * i;
+        b[i] = 1.0f - 0.05f * i;
+        ref += double(a[i]) * b[i];
+    }
+    EXPECT_NEAR(dot(a.data(), b.data(), a.size()), ref, 1e-4);
+}
+
+TEST(FaceGallery, FlatSearchAgreesWithBestMatch) {
+    std::mt19937 rng(7);
+    const size_t dim = 64;
+    FaceGallery g;
+    std::vector<GalleryEntry> ref;
+    for (int i = 0; i < 200; ++i) {
+        auto e = randomUnit(rng, dim);
+        ASSERT_TRUE(g.add("p" + std::to_string(i), e));
+        ref.push_back({"p" + std::to_string(i), e});
+    }
+    EXPECT_FALSE(g.add("bad", std::vector<float>(dim + 1, 1.0f)));
+
+    // Four faces scored in one call.
+    std::vector<float> probes;
+    std::vector<std::vector<float>> each;
+    for (int id : {3, 50, 199}) each.push_back(jitter(rng, ref[id].emb, 0.02f));
+    each.push_back(randomUnit(rng, dim));  // a stranger
+    for (const auto& p : each) probes.insert(probes.end(), p.begin(), p.end());
+
+    const auto got = g.search(probes.data(), 4, 0.6f);
+    ASSERT_EQ(got.size(), 4u);
+    for (size_t i = 0; i < each.size(); ++i) {
+        const Match want = best_match(ref, each[i], 0.6f);
+        EXPECT_EQ(got[i].name, want.name);
+        EXPECT_NEAR(got[i].score, want.score, 1e-4);
+    }
+    EXPECT_EQ(got[0].name, "p3");
+    EXPECT_EQ(got[3].name, "unknown");
+}
+
+TEST(FaceGallery, IvfFindsEnrolledIdentities) {
+    std::mt19937 rng(11);
+    const size_t dim = 32;
+    FaceGallery g;
+    std::vector<std::vector<float>> embs;
+    for (int i = 0; i < 1000; ++i) {
+        embs.push_back(randomUnit(rng, dim));
+        g.add("id" + std::to_string(i), embs.back());
+    }
+    ASSERT_TRUE(g.build_ivf(0));
+    EXPECT_EQ(g.lists(), 32u);  // sqrt(1000)
+
+    int hits = 0;
+    for (int i = 0; i < 1000; i += 10) {
+        const Match m = g.search(jitter(rng, embs[i], 0.01f), 0.5f, 4);
+        hits += m.name == "id" + std::to_string(i);
+    }
+    EXPECT_GE(hits, 95);  // approximate, but near-duplicates land in their list
+    // Scanning every list is exact.
+    const Match exact = g.search(embs[123], 0.5f, g.lists());
+    EXPECT_EQ(exact.name, "id123");
+    EXPECT_NEAR(exact.score, 1.0f, 1e-4);
+}
+
+TEST(FaceGallery, SaveAndMapRoundTrip) {
+    std::mt19937 rng(3);
+    const size_t dim = 48;
+    FaceGallery g;
+    std::vector<std::vector<float>> embs;
+    for (int i = 0; i < 100; ++i) {
+        embs.push_back(randomUnit(rng, dim));
+        g.add(i % 2 ? "Ada Lovelace " + std::to_string(i) : "x" + std::to_string(i), embs.back());
+    }
+    g.build_ivf(8);
+    const std::string path = tempPath("roundtrip");
+    std::string err;
+    ASSERT_TRUE(g.save(path, &err)) << err;
+
+    FaceGallery m;
+    ASSERT_TRUE(m.load(path, &err)) << err;
+    EXPECT_TRUE(m.mapped());
+    EXPECT_EQ(m.size(), 100u);
+    EXPECT_EQ(m.dim(), dim);
+    EXPECT_EQ(m.lists(), 8u);
+    EXPECT_FALSE(m.add("late", embs[0]));  // mapped galleries are read-only
+    for (int i : {0, 41, 99}) {
+        const Match a = g.search(embs[i], 0.5f, 2);
+        const Match b = m.search(embs[i], 0.5f, 2);
+        EXPECT_EQ(a.name, b.name);
+        EXPECT_FLOAT_EQ(a.score, b.score);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(FaceGallery, RejectsBadFiles) {
+    FaceGallery g;
+    std::string err;
+    EXPECT_FALSE(g.load(tempPath("missing"), &err));
+
+    const std::string path = tempPath("bad");
+    FILE* f = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(f, nullptr);
+    const char junk[100] = "definitely not a gallery";
+    std::fwrite(junk, 1, sizeof(junk), f);
+    std::fclose(f);
+    EXPECT_FALSE(g.load(path, &err));
+    EXPECT_EQ(g.size(), 0u);
+
+    // Valid header, truncated matrix.
+    FaceGallery ok;
+    ok.add("a", std::vector<float>(16, 1.0f));
+    ASSERT_TRUE(ok.save(path, &err));
+    ASSERT_EQ(truncate(path.c_str(), sizeof(GalleryFileHeader) + 8), 0);
+    EXPECT_FALSE(g.load(path, &err));
+    std::remove(path.c_str());
+}
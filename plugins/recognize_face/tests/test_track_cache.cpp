@@ -0,0 +1,142 @@
+// Tests for the per-track recognition cache shared by recognize_face and lpr
+// (plugins/common/track_cache.hpp).
+#include "track_cache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace zm::track;
+
+namespace {
+constexpr uint64_t kMs = 1000;
+
+TrackCacheOptions opts() {
+    TrackCacheOptions o;
+    o.refresh_us = 5000 * kMs;
+    o.miss_retry_us = 1000 * kMs;
+    o.quality_gain = 1.25f;
+    o.forget_us = 10000 * kMs;
+    return o;
+}
+}  // namespace
+
+TEST(TrackCache, AssociatesTightestContainingTrack) {
+    const std::vector<TrackBox> tracks = {
+        {1, 0, 0, 1000, 1000, "person"},   // big box containing everything
+        {2, 100, 100, 200, 400, "person"},
+        {3, 600, 100, 200, 400, "person"},
+    };
+    EXPECT_EQ(tightest_track(tracks, 150, 120, 60, 60), 1);  // face inside track 2
+    EXPECT_EQ(tightest_track(tracks, 650, 120, 60, 60), 2);
+    EXPECT_EQ(tightest_track(tracks, 450, 800, 20, 20), 0);
+    EXPECT_EQ(tightest_track(tracks, 2000, 2000, 20, 20), -1);
+
+    const RelBox rel = to_relative(tracks[1], 150, 120, 60, 60);
+    const TrackBox moved{2, 110, 90, 400, 800, "person"};  // moved and closer
+    float x, y, w, h;
+    from_relative(moved, rel, x, y, w, h);
+    EXPECT_FLOAT_EQ(x, 210.f);
+    EXPECT_FLOAT_EQ(y, 130.f);
+    EXPECT_FLOAT_EQ(w, 120.f);
+    EXPECT_FLOAT_EQ(h, 120.f);
+}
+
+TEST(TrackCache, AssociatesAtMostOneDetectionPerTrack) {
+    const std::vector<TrackBox> tracks = {
+        {1, 0, 0, 1000, 1000, "person"},   // big box containing everything
+        {2, 100, 100, 200, 400, "person"},
+        {3, 600, 100, 200, 400, "person"},
+    };
+    // Two faces inside person 2: the better one gets the track, the other is
+    // untracked (not handed to the enclosing track 1 either).
+    const std::vector<DetBox> faces = {
+        {110, 120, 40, 40, 1.0f},
+        {200, 130, 60, 60, 3.0f},
+        {650, 120, 60, 60, 0.5f},
+        {450, 800, 20, 20, 1.0f},
+        {2000, 2000, 20, 20, 1.0f},
+    };
+    EXPECT_EQ(associate(tracks, faces), (std::vector<int>{-1, 1, 2, 0, -1}));
+
+    // Equal quality: the earlier detection wins, deterministically.
+    const std::vector<DetBox> same = {{110, 120, 40, 40, 1.0f}, {200, 130, 40, 40, 1.0f}};
+    EXPECT_EQ(associate(tracks, same), (std::vector<int>{1, -1}));
+    EXPECT_TRUE(associate(tracks, {}).empty());
+    EXPECT_EQ(associate({}, same), (std::vector<int>{-1, -1}));
+}
+
+TEST(TrackCache, RerunsOnRefreshOrBetterQuality) {
+    TrackResultCache<std::string> c(opts());
+    EXPECT_TRUE(c.needs_run(0, 7, 10.f, 0));
+    c.store(0, 7, 0, 10.f, "alice", {});
+    EXPECT_FALSE(c.needs_run(0, 7, 10.f, 1000 * kMs));
+    EXPECT_FALSE(c.needs_run(0, 7, 12.f, 1000 * kMs));   // not enough better
+    EXPECT_TRUE(c.needs_run(0, 7, 13.f, 1000 * kMs));    // clearly better view
+    EXPECT_TRUE(c.needs_run(0, 7, 10.f, 5001 * kMs));    // refresh interval
+    EXPECT_TRUE(c.needs_run(1, 7, 10.f, 1000 * kMs));    // other stream
+    EXPECT_TRUE(c.needs_run(0, 0, 10.f, 1000 * kMs));    // unconfirmed track
+}
+
+TEST(TrackCache, CoversFrameWhenEveryTrackIsResolved) {
+    TrackResultCache<std::string> c(opts());
+    std::vector<TrackBox> tracks = {{1, 0, 0, 100, 200, "person"}, {2, 300, 0, 100, 200, "person"}};
+    EXPECT_FALSE(c.covers(0, tracks, 0));
+    c.store(0, 1, 0, 5.f, "alice", {});
+    EXPECT_FALSE(c.covers(0, tracks, 0));  // track 2 unresolved
+    c.miss(0, 2, 0);                       // no face on track 2 (facing away)
+    EXPECT_TRUE(c.covers(0, tracks, 500 * kMs));
+    EXPECT_FALSE(c.covers(0, tracks, 1500 * kMs));  // retry the miss
+    c.miss(0, 2, 1500 * kMs);
+    EXPECT_TRUE(c.covers(0, tracks, 2000 * kMs));
+    EXPECT_TRUE(c.covers(0, {}, 2000 * kMs));  // nobody in view
+
+    tracks.push_back({0, 500, 0, 100, 200, "person"});  // unconfirmed newcomer
+    EXPECT_FALSE(c.covers(0, tracks, 2000 * kMs));
+
+    // A face seen again after a miss counts as a hit again.
+    c.hit(0, 2, 2100 * kMs, {});
+    c.store(0, 2, 2100 * kMs, 5.f, "bob", {});
+    tracks.pop_back();
+    EXPECT_TRUE(c.covers(0, tracks, 4000 * kMs));
+    EXPECT_FALSE(c.covers(0, tracks, 5500 * kMs));  // alice needs a refresh
+}
+
+TEST(TrackCache, ExpiresStaleTracks) {
+    TrackResultCache<int> c(opts());
+    c.store(0, 1, 0, 1.f, 42, {});
+    c.store(0, 2, 9000 * kMs, 1.f, 43, {});
+    c.expire(0, 10500 * kMs);
+    EXPECT_EQ(c.size(0), 1u);
+    ASSERT_NE(c.find(0, 2), nullptr);
+    EXPECT_EQ(c.find(0, 2)->result, 43);
+    c.expire(0, 5);  // stream restarted
+    EXPECT_EQ(c.size(0), 0u);
+}
+
+TEST(TrackCache, IndexServesRecentSnapshots) {
+    TrackIndex idx;
+    std::vector<TrackBox> out;
+    EXPECT_FALSE(idx.latest(0, 0, 500 * kMs, out));
+    idx.update(0, 1000 * kMs, {{4, 1, 2, 3, 4, "car"}});
+    ASSERT_TRUE(idx.latest(0, 1300 * kMs, 500 * kMs, out));
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(out[0].id, 4);
+    EXPECT_TRUE(idx.latest(0, 900 * kMs, 500 * kMs, out));   // event ahead of the frame
+    EXPECT_FALSE(idx.latest(0, 1600 * kMs, 500 * kMs, out)); // tracker stalled
+    EXPECT_FALSE(idx.latest(1, 1000 * kMs, 500 * kMs, out));
+}
+
+TEST(TrackCache, SharpnessAndQuality) {
+    const int w = 32, h = 32;
+    std::vector<uint8_t> flat(w * h * 3, 128), checker(w * h * 3);
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+            for (int c = 0; c < 3; ++c) checker[(y * w + x) * 3 + c] = ((x + y) & 1) ? 255 : 0;
+    EXPECT_FLOAT_EQ(region_sharpness(flat.data(), w, h, 0, 0, 32, 32), 0.f);
+    EXPECT_GT(region_sharpness(checker.data(), w, h, 0, 0, 32, 32), 500.f);
+    EXPECT_GT(box_quality(0.9f, 80, 80, 10.f), box_quality(0.9f, 40, 40, 10.f));
+    EXPECT_GT(box_quality(0.9f, 40, 40, 20.f), box_quality(0.9f, 40, 40, 5.f));
+    EXPECT_GT(box_quality(0.9f, 40, 40, 5.f), box_quality(0.5f, 40, 40, 5.f));
+}
@@ -0,0 +1,85 @@
+// face_gallery: build or inspect the binary gallery recognize_face maps at
+// startup (gallery_path). Input is the same JSON as the plugin's inline
+// "gallery" config — an array of {name, embedding:[...]} (or an object with a
+// "gallery" array).
+// Usage: face_gallery build <gallery.json> <out.zmfg> [--ivf <lists>|auto]
+//        face_gallery info <gallery.zmfg>
+
+#include "../face_gallery.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+static int usage() {
+    std::cerr << "usage: face_gallery build <gallery.json> <out.zmfg> [--ivf <lists>|auto]\n"
+                 "       face_gallery info <gallery.zmfg>\n";
+    return 2;
+}
+
+static int build(const std::string& in, const std::string& out, bool ivf, size_t lists) {
+    std::ifstream f(in);
+    if (!f) { std::cerr << "cannot open " << in << "\n"; return 1; }
+    json j;
+    try {
+        f >> j;
+    } catch (const std::exception& e) {
+        std::cerr << in << ": " << e.what() << "\n";
+        return 1;
+    }
+    const json& arr = j.is_object() ? j.value("gallery", json::array()) : j;
+    if (!arr.is_array()) { std::cerr << in << ": expected a gallery array\n"; return 1; }
+
+    zm::face::FaceGallery g;
+    size_t skipped = 0;
+    for (const auto& e : arr) {
+        if (!e.is_object() || !e.contains("embedding") || !e["embedding"].is_array()) { ++skipped; continue; }
+        std::string name = e.value("name", std::string());
+        if (name.empty() || !g.add(std::move(name), e["embedding"].get<std::vector<float>>())) ++skipped;
+    }
+    if (g.size() == 0) { std::cerr << in << ": no usable entries\n"; return 1; }
+    if (ivf) g.build_ivf(lists);
+
+    std::string err;
+    if (!g.save(out, &err)) { std::cerr << err << "\n"; return 1; }
+    std::cout << out << ": " << g.size() << " entries, dim " << g.dim() << ", "
+              << g.lists() << " IVF lists";
+    if (skipped) std::cout << " (" << skipped << " skipped)";
+    std::cout << "\n";
+    return 0;
+}
+
+static int info(const std::string& path) {
+    zm::face::FaceGallery g;
+    std::string err;
+    if (!g.load(path, &err)) { std::cerr << path << ": " << err << "\n"; return 1; }
+    std::cout << path << ": " << g.size() << " entries, dim " << g.dim() << ", "
+              << g.lists() << " IVF lists\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) return usage();
+    const std::string cmd = argv[1];
+    if (cmd == "info") return info(argv[2]);
+    if (cmd != "build" || argc < 4) return usage();
+    bool ivf = false;
+    size_t lists = 0;
+    for (int i = 4; i < argc; ++i) {
+        const std::string a = argv[i];
+        if (a == "--ivf" && i + 1 < argc) {
+            ivf = true;
+            const std::string v = argv[++i];
+            lists = v == "auto" ? 0 : static_cast<size_t>(std::strtoul(v.c_str(), nullptr, 10));
+        } else {
+            return usage();
+        }
+    }
+    return build(argv[2], argv[3], ivf, lists);
+}
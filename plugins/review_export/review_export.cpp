@@ -9,8 +9,9 @@
 //   - "background_plate"    (motion_pixel_diff: latest plate side-file path)
 //   - "RecordingOpening" / "EventClip" (store: the recording lifecycle window)
 //
-// For each tracked object it samples (<= sample_fps/track) the matching frame
-// from a small ring, rasterises the seg polygon to a feathered matte, premultiplies
+// For each tracked object it samples (<= sample_fps/track) the pts-matched frame
+// from the host frame cache (retaining ring_size frames; a private ring of
+// copies when the host has no cache), rasterises the seg polygon to a feathered matte, premultiplies
 // the RGB crop (background -> black), downscales it, and MJPEG-encodes a cutout.
 // On EventClip it writes the cutouts + chosen plate under {event_dir}/synopsis/
 // and publishes a "review_assets" event (mapped to wire EVENT 0x0306, TLV 0x10).
@@ -21,6 +22,7 @@
 #include <zm_plugin.h>
 #include <nlohmann/json.hpp>
 #include "image_encode.hpp"
+#include "frame_cache.hpp"
 #include "review_matte.hpp"
 #include "base64.hpp"
 
@@ -92,6 +94,10 @@ struct State {
     int64_t matchTolUs = 100000;         // nearest-frame match window (100ms)
     std::vector<int> streamFilter;
 
+    // Frames come from the host frame cache (retained ring_size deep); `ring`
+    // is only filled when the host has none.
+    bool useCache = false;
+
     std::mutex mtx;
 
     // pts -> wallclock anchor.
@@ -125,7 +131,7 @@ uint64_t wallclock_for(State* st, int64_t pts_us) {
 
 // Build a premultiplied, downscaled, MJPEG-encoded cutout for one detection.
 // Returns false if the crop is degenerate or encoding fails.
-bool build_cutout(const RingFrame& f, int fw, int fh, const std::array<float, 4>& bbox,
+bool build_cutout(const uint8_t* rgb, int fw, int fh, const std::array<float, 4>& bbox,
                   const std::vector<std::array<float, 2>>& poly,
                   const std::vector<uint8_t>& alpha, int alphaW, int alphaH,
                   int maxEdge, int feather,
@@ -139,7 +145,7 @@ bool build_cutout(const RingFrame& f, int fw, int fh, const std::array<float, 4>
     // Crop RGB.
     std::vector<uint8_t> crop(static_cast<size_t>(iw) * ih * 3);
     for (int y = 0; y < ih; ++y) {
-        const uint8_t* srow = f.rgb.data() + (static_cast<size_t>(iy + y) * fw + ix) * 3;
+        const uint8_t* srow = rgb + (static_cast<size_t>(iy + y) * fw + ix) * 3;
         std::memcpy(crop.data() + static_cast<size_t>(y) * iw * 3, srow,
                     static_cast<size_t>(iw) * 3);
     }
@@ -156,31 +162,12 @@ bool build_cutout(const RingFrame& f, int fw, int fh, const std::array<float, 4>
     for (int i = 0; i < feather; ++i) zm::review::box_blur3(mask, iw, ih);
     zm::review::premultiply_rgb(crop, mask);
 
-    // Downscale (nearest) to <= maxEdge on the long side.
+    // Downscale to <= maxEdge on the long side as part of the (pooled) encode.
+    zm::img::JpegOptions opt;
+    opt.max_edge = maxEdge;
     int dw = iw, dh = ih;
-    const int longEdge = std::max(iw, ih);
-    if (longEdge > maxEdge) {
-        const double s = static_cast<double>(maxEdge) / longEdge;
-        dw = std::max(1, static_cast<int>(iw * s));
-        dh = std::max(1, static_cast<int>(ih * s));
-    }
-    const uint8_t* encSrc = crop.data();
-    std::vector<uint8_t> scaled;
-    if (dw != iw || dh != ih) {
-        scaled.resize(static_cast<size_t>(dw) * dh * 3);
-        for (int y = 0; y < dh; ++y) {
-            const int sy = std::min(ih - 1, y * ih / dh);
-            for (int x = 0; x < dw; ++x) {
-                const int sx = std::min(iw - 1, x * iw / dw);
-                const uint8_t* sp = crop.data() + (static_cast<size_t>(sy) * iw + sx) * 3;
-                uint8_t* dp = scaled.data() + (static_cast<size_t>(y) * dw + x) * 3;
-                dp[0] = sp[0]; dp[1] = sp[1]; dp[2] = sp[2];
-            }
-        }
-        encSrc = scaled.data();
-    }
-
-    if (!zm::img::encode_rgb24_to_jpeg(encSrc, dw, dh, jpegOut)) return false;
+    zm::img::jpeg_output_size(iw, ih, opt, dw, dh);
+    if (!zm::img::encode_rgb24_to_jpeg(crop.data(), iw, ih, jpegOut, opt)) return false;
     outW = dw; outH = dh;
     return true;
 }
@@ -313,8 +300,19 @@ void on_tracked_detection(State* st, const json& j) {
     if (!j.contains("detections") || !j["detections"].is_array()) return;
     const int64_t pts = j.value("pts_usec", static_cast<int64_t>(0));
 
-    const RingFrame* frame = nearest_frame(st, pts);
-    if (!frame) return;   // sample frame dropped under load — tolerate (skip)
+    zm::fc::FrameRef cached;
+    const uint8_t* rgb = nullptr;
+    if (st->useCache) {
+        cached = zm::fc::FrameRef::at(st->host, st->hostCtx, static_cast<uint32_t>(streamId),
+                                      ZM_FRAME_RGB24,
+                                      static_cast<uint32_t>(st->frameW * st->frameH * 3),
+                                      static_cast<uint64_t>(pts),
+                                      static_cast<uint64_t>(st->matchTolUs));
+        if (cached) rgb = cached.payload();
+    } else if (const RingFrame* frame = nearest_frame(st, pts)) {
+        rgb = frame->rgb.data();
+    }
+    if (!rgb) return;     // sample frame dropped under load — tolerate (skip)
 
     const int64_t minGap = (st->sampleFps > 0) ? (1000000 / st->sampleFps) : 0;
 
@@ -362,7 +360,7 @@ void on_tracked_detection(State* st, const json& j) {
         }
 
         Sample s;
-        if (!build_cutout(*frame, st->frameW, st->frameH, bbox, poly, alpha, alphaW, alphaH,
+        if (!build_cutout(rgb, st->frameW, st->frameH, bbox, poly, alpha, alphaW, alphaH,
                           st->cutoutMaxEdge, st->feather, s.jpeg, s.cutout_w, s.cutout_h))
             continue;
         s.pts_us = pts;
@@ -464,6 +462,7 @@ int review_export_start(zm_plugin_t* plugin, zm_host_api_t* host, void* host_ctx
     if (st->ringSize < 1) st->ringSize = 1;
     if (st->ringSize > 64) st->ringSize = 64;   // bound ring memory (full RGB frames)
     if (st->maxSamples < 1) st->maxSamples = 1;
+    st->useCache = zm::fc::retain(host, host_ctx, static_cast<uint32_t>(st->ringSize));
 
     st->running.store(true);
     ctx->state = st;
@@ -520,12 +519,14 @@ void review_export_on_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
                 std::chrono::duration_cast<std::chrono::milliseconds>(
                     std::chrono::system_clock::now().time_since_epoch()).count());
         }
-        RingFrame rf;
-        rf.pts_us = static_cast<int64_t>(hdr->pts_usec);
-        rf.rgb.assign(payload, payload + static_cast<size_t>(st->frameW) * st->frameH * 3);
-        const int64_t framePts = rf.pts_us;
-        st->ring.push_back(std::move(rf));
-        while (st->ring.size() > st->ringSize) st->ring.pop_front();
+        const int64_t framePts = static_cast<int64_t>(hdr->pts_usec);
+        if (!st->useCache) {
+            RingFrame rf;
+            rf.pts_us = framePts;
+            rf.rgb.assign(payload, payload + static_cast<size_t>(st->frameW) * st->frameH * 3);
+            st->ring.push_back(std::move(rf));
+            while (st->ring.size() > st->ringSize) st->ring.pop_front();
+        }
         if (st->collecting) {
             if (!st->haveCollPts) { st->collFirstPts = framePts; st->haveCollPts = true; }
             st->collLastPts = framePts;
@@ -0,0 +1,122 @@
+// Tests for the shared JPEG pre-encode helpers in plugins/common (the converter
+// and the MCU-bucket header rewrite behind the pooled cutout encoder).
+#include "image_convert.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using zm::img::gray8_to_yuvj420;
+using zm::img::jpeg_mcu_align;
+using zm::img::jpeg_set_dimensions;
+using zm::img::pad_yuv420;
+using zm::img::rgb24_to_yuvj420;
+using zm::img::Yuv420Planes;
+
+namespace {
+
+struct Planes {
+    Planes(int w, int h) : yw(w), cw((w + 1) / 2), y(size_t(w) * h), u(size_t(cw) * ((h + 1) / 2)),
+                           v(u.size()) {}
+    Yuv420Planes view() { return {y.data(), u.data(), v.data(), yw, cw, cw}; }
+    int yw, cw;
+    std::vector<uint8_t> y, u, v;
+};
+
+int ref_y(int r, int g, int b) { return int(std::lround(0.299 * r + 0.587 * g + 0.114 * b)); }
+int ref_cb(int r, int g, int b) { return int(std::lround(128 - 0.168736 * r - 0.331264 * g + 0.5 * b)); }
+int ref_cr(int r, int g, int b) { return int(std::lround(128 + 0.5 * r - 0.418688 * g - 0.081312 * b)); }
+
+}  // namespace
+
+TEST(ImageConvert, SolidColoursMatchBt601FullRange) {
+    const int colours[][3] = {{0, 0, 0}, {255, 255, 255}, {255, 0, 0}, {0, 255, 0},
+                              {0, 0, 255}, {18, 140, 200}, {250, 250, 5}};
+    for (const auto& c : colours) {
+        std::vector<uint8_t> rgb;
+        for (int i = 0; i < 4 * 4; ++i) rgb.insert(rgb.end(), {uint8_t(c[0]), uint8_t(c[1]), uint8_t(c[2])});
+        Planes p(4, 4);
+        rgb24_to_yuvj420(rgb.data(), 4, 4, 12, p.view());
+        EXPECT_NEAR(p.y[5], ref_y(c[0], c[1], c[2]), 1);
+        EXPECT_NEAR(p.u[3], std::min(255, ref_cb(c[0], c[1], c[2])), 1);
+        EXPECT_NEAR(p.v[3], std::min(255, ref_cr(c[0], c[1], c[2])), 1);
+    }
+}
+
+TEST(ImageConvert, OddSizeAveragesAvailableSamples) {
+    // 3x1: chroma column 1 only has the last pixel (repeated).
+    const uint8_t rgb[] = {0, 0, 0, 0, 0, 0, 255, 0, 0};
+    Planes p(3, 1);
+    rgb24_to_yuvj420(rgb, 3, 1, 9, p.view());
+    EXPECT_EQ(p.y[0], 0);
+    EXPECT_NEAR(p.y[2], ref_y(255, 0, 0), 1);
+    EXPECT_EQ(p.v[0], 128);
+    EXPECT_NEAR(p.v[1], 255, 1);
+}
+
+TEST(ImageConvert, MatchesFixedPointFormulaAtEveryWidth) {
+    // Widths around every batch and chunk boundary, odd heights, padded rows.
+    uint32_t seed = 1;
+    auto next = [&] { return (seed = seed * 1664525u + 1013904223u) >> 24; };
+    for (int w : {1, 2, 7, 15, 16, 17, 33, 63, 64, 65, 255, 256, 257, 511, 530}) {
+        for (int h : {1, 3}) {
+            const int stride = 3 * w + 5;
+            std::vector<uint8_t> rgb(size_t(stride) * h);
+            for (auto& b : rgb) b = uint8_t(next());
+            if (w == 65) std::fill(rgb.begin(), rgb.end(), 255);  // luma / chroma ceilings
+            Planes p(w, h);
+            rgb24_to_yuvj420(rgb.data(), w, h, stride, p.view());
+            for (int y = 0; y < h; ++y)
+                for (int x = 0; x < w; ++x) {
+                    const uint8_t* s = &rgb[size_t(y) * stride + 3 * x];
+                    ASSERT_EQ(p.y[size_t(y) * w + x], (77 * s[0] + 150 * s[1] + 29 * s[2] + 128) >> 8)
+                        << "w " << w << " x " << x << " y " << y;
+                }
+            for (int cy = 0; cy < (h + 1) / 2; ++cy)
+                for (int cx = 0; cx < p.cw; ++cx) {
+                    int sum[3] = {0, 0, 0};
+                    for (int dy : {0, 1})
+                        for (int dx : {0, 1}) {
+                            const int y = std::min(2 * cy + dy, h - 1);
+                            const int x = std::min(2 * cx + dx, w - 1);
+                            for (int c = 0; c < 3; ++c) sum[c] += rgb[size_t(y) * stride + 3 * x + c];
+                        }
+                    const int cb = ((128 << 10) + 512 - 43 * sum[0] - 85 * sum[1] + 128 * sum[2]) >> 10;
+                    const int cr = ((128 << 10) + 512 + 128 * sum[0] - 107 * sum[1] - 21 * sum[2]) >> 10;
+                    ASSERT_EQ(p.u[size_t(cy) * p.cw + cx], std::min(cb, 255)) << "w " << w << " cx " << cx;
+                    ASSERT_EQ(p.v[size_t(cy) * p.cw + cx], std::min(cr, 255)) << "w " << w << " cx " << cx;
+                }
+        }
+    }
+}
+
+TEST(ImageConvert, GrayAndPadding) {
+    const uint8_t gray[] = {10, 20, 30, 40, 50, 60};  // 3x2
+    Planes p(4, 4);
+    gray8_to_yuvj420(gray, 3, 2, 3, p.view());
+    pad_yuv420(p.view(), 3, 2, 4, 4);
+    const std::vector<uint8_t> want = {10, 20, 30, 30, 40, 50, 60, 60, 40, 50, 60, 60, 40, 50, 60, 60};
+    EXPECT_EQ(p.y, want);
+    EXPECT_EQ(p.u, std::vector<uint8_t>(4, 128));
+}
+
+TEST(ImageConvert, RewritesSofDimensions) {
+    EXPECT_EQ(jpeg_mcu_align(1), 16);
+    EXPECT_EQ(jpeg_mcu_align(32), 32);
+    EXPECT_EQ(jpeg_mcu_align(250), 256);
+    // SOI, APP0 (len 4), SOF0 (256x32), SOS.
+    std::vector<uint8_t> jpeg = {0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x04, 0xAA, 0xBB,
+                                 0xFF, 0xC0, 0x00, 0x11, 0x08, 0x00, 0x20, 0x01, 0x00, 0x03,
+                                 1, 0x22, 0, 2, 0x11, 1, 3, 0x11, 1,
+                                 0xFF, 0xDA, 0x00, 0x02};
+    ASSERT_TRUE(jpeg_set_dimensions(jpeg, 250, 17));
+    EXPECT_EQ(jpeg[13], 0x00);
+    EXPECT_EQ(jpeg[14], 17);
+    EXPECT_EQ(jpeg[15], 0x00);
+    EXPECT_EQ(jpeg[16], 250);
+    std::vector<uint8_t> no_sof = {0xFF, 0xD8, 0xFF, 0xDA, 0x00, 0x02};
+    EXPECT_FALSE(jpeg_set_dimensions(no_sof, 1, 1));
+}
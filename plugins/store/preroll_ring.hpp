@@ -0,0 +1,224 @@
+// preroll_ring.hpp — pure helper for store's event-mode pre-roll buffer.
+//
+// PrerollRing keeps the last few seconds of compressed packets in ONE
+// preallocated byte arena instead of a deque of per-packet vectors. Packet
+// payloads are laid out back to back; a packet never wraps (if it doesn't fit in
+// the tail it starts again at offset 0), so every packet is readable in place as
+// a (pointer, size) view and write_preroll streams straight out of the arena.
+//
+// A side index of GOP starts (video keyframes) makes eviction O(1) per GOP:
+// the oldest GOP is dropped by advancing the head past it, no per-packet free.
+// Memory is fixed at construction: size it as bitrate x max_buffer_sec. When a
+// burst exceeds the arena, whole GOPs are evicted from the front to make room.
+//
+// Free of FFmpeg / ABI dependencies so it can be unit-tested on its own.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace zm {
+namespace store {
+
+// Growable FIFO over a vector (doubles on overflow, never shrinks), so the
+// packet index stops allocating once it has seen its steady-state depth.
+template <typename T>
+class IndexRing {
+public:
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    T& operator[](size_t i) { return slots_[(head_ + i) & (slots_.size() - 1)]; }
+    const T& operator[](size_t i) const {
+        return slots_[(head_ + i) & (slots_.size() - 1)];
+    }
+    T& front() { return (*this)[0]; }
+    const T& front() const { return (*this)[0]; }
+    T& back() { return (*this)[count_ - 1]; }
+    const T& back() const { return (*this)[count_ - 1]; }
+
+    void push_back(const T& v) {
+        if (count_ == slots_.size()) grow();
+        slots_[(head_ + count_) & (slots_.size() - 1)] = v;
+        ++count_;
+    }
+    void pop_front() {
+        head_ = (head_ + 1) & (slots_.size() - 1);
+        --count_;
+    }
+    void clear() { head_ = count_ = 0; }
+
+private:
+    void grow() {
+        std::vector<T> next(slots_.empty() ? 64 : slots_.size() * 2);
+        for (size_t i = 0; i < count_; ++i) next[i] = (*this)[i];
+        slots_.swap(next);
+        head_ = 0;
+    }
+
+    std::vector<T> slots_;  // power-of-two capacity
+    size_t head_ = 0;
+    size_t count_ = 0;
+};
+
+class PrerollRing {
+public:
+    struct Packet {
+        uint32_t stream_id = 0;
+        uint32_t hw_type = 0;
+        bool keyframe = false;
+        int64_t pts_usec = 0;
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    explicit PrerollRing(size_t capacity_bytes)
+        : cap_(capacity_bytes ? capacity_bytes : 1),
+          arena_(new uint8_t[cap_]) {}
+
+    PrerollRing(const PrerollRing&) = delete;
+    PrerollRing& operator=(const PrerollRing&) = delete;
+
+    size_t capacity() const { return cap_; }
+    size_t used_bytes() const { return used_; }
+    size_t packets() const { return entries_.size(); }
+    size_t gops() const { return gops_.size(); }
+    bool empty() const { return entries_.empty(); }
+    int64_t newest_pts() const { return entries_.empty() ? 0 : entries_.back().pts_usec; }
+    int64_t oldest_pts() const { return entries_.empty() ? 0 : entries_.front().pts_usec; }
+    // GOPs dropped to make room (arena too small for the stream's bitrate).
+    uint64_t space_evictions() const { return space_evictions_; }
+
+    // Copy a packet into the arena. `gop_start` marks a video keyframe. Evicts
+    // whole GOPs from the front if the arena is full; returns false only if the
+    // packet is larger than the whole arena.
+    bool append(uint32_t stream_id, uint32_t hw_type, bool keyframe, bool gop_start,
+                int64_t pts_usec, const uint8_t* data, size_t size) {
+        if (size > cap_) return false;
+        size_t off = 0;
+        while (!reserve(size, off)) {
+            if (!evict_front_gop()) {
+                clear();  // only a partial GOP left; start over from this packet
+            }
+            ++space_evictions_;
+        }
+        if (size) std::memcpy(arena_.get() + off, data, size);
+        Entry e;
+        e.seq = next_seq_++;
+        e.offset = off;
+        e.size = size;
+        e.stream_id = stream_id;
+        e.hw_type = hw_type;
+        e.keyframe = keyframe;
+        e.pts_usec = pts_usec;
+        entries_.push_back(e);
+        if (gop_start) gops_.push_back(e.seq);
+        tail_ = off + size;
+        used_ += size;
+        return true;
+    }
+
+    // Keep only what a pre-roll of `window_usec` (ending at the newest packet)
+    // needs: everything before the last GOP start at or before the cutoff goes.
+    // Then enforce `hard_usec` as an absolute cap, also at GOP granularity.
+    void trim(int64_t window_usec, int64_t hard_usec) {
+        if (entries_.empty()) return;
+        const int64_t newest = entries_.back().pts_usec;
+        const int64_t cutoff = newest - window_usec;
+        while (gops_.size() >= 2 && pts_of(gops_[1]) <= cutoff) evict_front_gop();
+        if (!gops_.empty() && pts_of(gops_.front()) <= cutoff)
+            evict_before(gops_.front());
+
+        const int64_t hard_cutoff = newest - hard_usec;
+        while (!entries_.empty() && entries_.front().pts_usec < hard_cutoff) {
+            if (!evict_front_gop()) break;  // never drop the newest GOP
+        }
+    }
+
+    // Visit the buffered packets oldest-first as in-place views.
+    template <typename F>
+    void for_each(F&& f) const {
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            const Entry& e = entries_[i];
+            Packet p;
+            p.stream_id = e.stream_id;
+            p.hw_type = e.hw_type;
+            p.keyframe = e.keyframe;
+            p.pts_usec = e.pts_usec;
+            p.data = arena_.get() + e.offset;
+            p.size = e.size;
+            f(p);
+        }
+    }
+
+    void clear() {
+        entries_.clear();
+        gops_.clear();
+        used_ = 0;
+        tail_ = 0;
+    }
+
+private:
+    struct Entry {
+        uint64_t seq = 0;
+        size_t offset = 0;
+        size_t size = 0;
+        uint32_t stream_id = 0;
+        uint32_t hw_type = 0;
+        bool keyframe = false;
+        int64_t pts_usec = 0;
+    };
+
+    int64_t pts_of(uint64_t seq) const { return entries_[seq - entries_.front().seq].pts_usec; }
+
+    // Find `size` contiguous free bytes after the tail (or at offset 0 when the
+    // tail region is too short). Live data is [head, tail) or, once wrapped,
+    // [head, end-of-data) + [0, tail).
+    bool reserve(size_t size, size_t& off) const {
+        if (entries_.empty()) {
+            off = 0;
+            return true;
+        }
+        const size_t head = entries_.front().offset;
+        if (tail_ > head || (tail_ == head && used_ == 0)) {
+            if (cap_ - tail_ >= size) { off = tail_; return true; }
+            if (head >= size) { off = 0; return true; }
+            return false;
+        }
+        // Wrapped: free space is the gap between tail and head.
+        if (head - tail_ >= size) { off = tail_; return true; }
+        return false;
+    }
+
+    void evict_before(uint64_t seq) {
+        while (!entries_.empty() && entries_.front().seq < seq) {
+            used_ -= entries_.front().size;
+            entries_.pop_front();
+        }
+        if (entries_.empty()) clear();
+    }
+
+    // Drop everything before the second GOP start. False if fewer than two
+    // GOPs are buffered (the newest GOP is never evicted this way).
+    bool evict_front_gop() {
+        if (gops_.size() < 2) return false;
+        evict_before(gops_[1]);
+        gops_.pop_front();
+        return true;
+    }
+
+    size_t cap_;
+    std::unique_ptr<uint8_t[]> arena_;
+    IndexRing<Entry> entries_;
+    IndexRing<uint64_t> gops_;  // seq of each buffered GOP start, oldest first
+    uint64_t next_seq_ = 0;
+    size_t tail_ = 0;
+    size_t used_ = 0;
+    uint64_t space_evictions_ = 0;
+};
+
+}  // namespace store
+}  // namespace zm
@@ -12,6 +12,12 @@
 //                  segment's cause and its VLM descriptions are captured. No
 //                  second file (ZM "Mocord").
 //
+// Next to every clip the writer also keeps a keyframe/time index sidecar
+// (<clip>.idx, zm/segment_index.hpp): the byte offset of each keyframe cluster,
+// taken from the muxer's AVIO sync-point markers, plus trigger event markers. It
+// is appended as the clip is written, so zm-api can scrub or cut evidence by
+// byte range (tools/seg_extract) without demuxing.
+//
 // Every recorded clip/segment participates in the event-id handshake with zm-api
 // over the worker socket: on open it emits recording_opening{clip_token,trigger};
 // zm-api replies assign_recording{clip_token,event_id,dir,video_name}, which we
@@ -22,8 +28,14 @@
 //
 // Data flow:
 //   on_frame (capture thread): (a) maintain rolling buffer (event mode) / drive
-//   segment open+rotate (continuous), (b) write to the open clip, (c) ALWAYS
-//   forward downstream via host->on_frame.
+//   segment open+rotate (continuous), (b) queue the packet for the open clip,
+//   (c) ALWAYS forward downstream via host->on_frame.
+//   writer thread: owns the muxer and the segment fd. Pops open / packet /
+//   rename / close ops from a byte-budgeted write-behind queue, so a filesystem
+//   stall (NFS hiccup, another process's fsync, rotation rename) backs up the
+//   queue instead of the store stage. Writes go through a custom AVIOContext with
+//   a large buffer (few big pwrite()s), segments are fallocate()d up front, and the
+//   buffer is flushed at every video keyframe (one GOP at most in userspace).
 //   event callback (publisher thread): StreamMetadata -> codec params; trigger
 //   events -> start/extend a clip (event/both); assign_recording -> stash for the
 //   capture thread; description -> sidecar.
@@ -31,8 +43,11 @@
 // Lifetime: state is leaked on stop() so an in-flight host callback never dangles.
 
 #include "event_trigger.hpp"
+#include "preroll_ring.hpp"
+#include "write_queue.hpp"
 
 #include <zm_plugin.h>
+#include <zm/segment_index.hpp>
 #include <nlohmann/json.hpp>
 
 #ifdef __cplusplus
@@ -47,18 +62,23 @@ extern "C" {
 }
 #endif
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <algorithm>
 #include <atomic>
+#include <cerrno>
+#include <chrono>
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
 #include <ctime>
-#include <deque>
 #include <filesystem>
 #include <fstream>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 using json = nlohmann::json;
@@ -90,13 +110,70 @@ struct AudioParams {
     std::vector<uint8_t> extradata;
 };
 
-// One buffered compressed packet (copied off the host buffer).
-struct BufferedPacket {
-    uint32_t stream_id = 0;
-    uint32_t hw_type = 0;     // ZM_FRAME_COMPRESSED or ZM_FRAME_COMPRESSED_AUDIO
+// ---------------------------------------------------------------------------
+// Write-behind recorder: one op per unit of muxer work, produced on the capture
+// thread and executed in order on the writer thread.
+// ---------------------------------------------------------------------------
+struct WriteOp {
+    enum class Kind { Open, Packet, Marker, Assign, Close };
+    Kind kind = Kind::Packet;
+
+    // Packet: rel_usec is relative to the clip start (capture-side clock),
+    // pts_usec the absolute capture pts. Marker: rel_usec + `cause` (event type).
+    uint32_t hw_type = 0;
     bool keyframe = false;
+    int64_t rel_usec = 0;
     int64_t pts_usec = 0;
     std::vector<uint8_t> data;
+
+    // Open: naming inputs + a snapshot of the codec params at open time.
+    uint32_t stream_id = 0;
+    std::time_t wall = 0;
+    VideoParams video;
+    AudioParams audio;
+
+    // Assign: zm-api's target directory + file name for the rename.
+    std::string dir;
+    std::string video_name;
+
+    // Close: the clip summary the capture thread accumulated.
+    long event_id = 0;
+    std::string cause;
+    int64_t duration_usec = 0;
+    int64_t frames = 0;
+    std::vector<std::string> descriptions;
+};
+
+struct StoreState;
+
+// Target of the custom AVIOContext: the segment fd plus our own file position
+// (pwrite at pos, so the muxer's seek-back for cues/duration costs no syscall).
+struct SegmentFile {
+    int fd = -1;
+    int64_t pos = 0;
+    int64_t size = 0;
+    StoreState* st = nullptr;
+};
+
+// Writer-thread-only muxer state. Counters in `stats` are read by the writer
+// itself when it closes a clip, so they need no synchronization.
+struct ClipWriter {
+    std::thread thread;
+    std::unique_ptr<zm::store::WriteQueue<WriteOp>> queue;
+
+    std::unique_ptr<AVFormatContext, decltype(&avformat_free_context)> fmt_ctx{
+        nullptr, avformat_free_context};
+    AVIOContext* pb = nullptr;
+    SegmentFile file;
+    bool header_written = false;
+    bool open_failed = false;             // drop packets until the next Open
+    std::string cur_path;
+    AVStream* video_stream = nullptr;
+    AVStream* audio_stream = nullptr;
+    int64_t last_segment_bytes = 0;       // sizes the next segment's fallocate
+    std::time_t opened_wall = 0;
+    zm::segment_index::Writer index;      // <cur_path>.idx, opened at first packet
+    zm::store::WriteStats stats;
 };
 
 // ---------------------------------------------------------------------------
@@ -111,8 +188,14 @@ struct StoreState {
     int pre_roll_sec = 5;                 // event: seconds before the trigger
     int post_roll_sec = 10;               // event: seconds after the last trigger
     int max_buffer_sec = 15;              // event: rolling-buffer cap
+    int preroll_kbps = 8000;              // event: sizes the pre-roll arena
     std::vector<std::string> trigger_types;
     std::vector<uint32_t> stream_filter;  // empty == accept all
+    size_t write_queue_bytes = 64u << 20; // write-behind budget (~60 s at 8 Mbps)
+    int write_buffer_bytes = 1 << 20;     // AVIO buffer == size of each pwrite()
+    int64_t prealloc_bytes = 64ll << 20;  // fallocate() per segment; 0 = off
+    int64_t stall_usec = 500000;          // a single write slower than this is a stall
+    bool fsync_on_close = true;
 
     // Host.
     zm_host_api_t* host = nullptr;
@@ -130,23 +213,26 @@ struct StoreState {
     VideoParams video;
     AudioParams audio;
 
-    // Rolling pre-roll buffer (event mode only).
-    std::deque<BufferedPacket> buffer;
+    // Rolling pre-roll buffer (event mode only): one arena of
+    // preroll_kbps x max_buffer_sec bytes, allocated at start.
+    std::unique_ptr<zm::store::PrerollRing> buffer;
+    bool warned_preroll_full = false;
 
     // Recording state.
     bool recording = false;
     int64_t last_trigger_usec = 0;
     bool warned_no_codec = false;
 
-    // Open muxer.
-    std::unique_ptr<AVFormatContext, decltype(&avformat_free_context)> fmt_ctx{
-        nullptr, avformat_free_context};
-    bool header_written = false;
+    // Capture-side clock of the open clip (the muxer itself lives in `writer`).
     int64_t start_ts = 0;
     int64_t last_pts = 0;
-    std::string cur_path;
-    AVStream* video_stream = nullptr;
-    AVStream* audio_stream = nullptr;
+
+    // Write-behind overflow: once the queue rejects a packet, drop everything up
+    // to the next video keyframe so the recording resumes decodable.
+    bool overflow_skip = false;
+    uint64_t overflow_dropped = 0;
+
+    ClipWriter writer;
 
     // VLM "description" events captured during the current clip; written to a
     // sidecar JSON on close so recordings are searchable by description.
@@ -255,151 +341,234 @@ bool stream_allowed(const StoreState* st, uint32_t sid) {
 // ---------------------------------------------------------------------------
 void buffer_append(StoreState* st, const zm_frame_hdr_t* hdr,
                    const uint8_t* payload) {
-    BufferedPacket bp;
-    bp.stream_id = hdr->stream_id;
-    bp.hw_type = hdr->hw_type;
-    bp.keyframe = (hdr->flags & 1u) != 0;
-    bp.pts_usec = (int64_t)hdr->pts_usec;
-    bp.data.assign(payload, payload + hdr->bytes);
-    st->buffer.push_back(std::move(bp));
+    zm::store::PrerollRing& ring = *st->buffer;
+    const bool keyframe = (hdr->flags & 1u) != 0;
+    const bool gop_start = keyframe && hdr->hw_type == (uint32_t)ZM_FRAME_COMPRESSED;
+    const uint64_t evictions = ring.space_evictions();
+    if (!ring.append(hdr->stream_id, hdr->hw_type, keyframe, gop_start,
+                     (int64_t)hdr->pts_usec, payload, hdr->bytes)) {
+        slog(st, ZM_LOG_WARN, "store: %u-byte packet exceeds the %zu-byte pre-roll arena",
+             hdr->bytes, ring.capacity());
+        return;
+    }
+    if (ring.space_evictions() != evictions && !st->warned_preroll_full) {
+        slog(st, ZM_LOG_WARN,
+             "store: pre-roll arena (%zu KB) full before %d s; stream exceeds "
+             "preroll_kbps=%d, pre-roll will be shorter",
+             ring.capacity() >> 10, st->max_buffer_sec, st->preroll_kbps);
+        st->warned_preroll_full = true;
+    }
 
     int window_sec = st->pre_roll_sec + 2;
     if (window_sec > st->max_buffer_sec) window_sec = st->max_buffer_sec;
     if (window_sec < 1) window_sec = 1;
-    const int64_t window_usec = (int64_t)window_sec * 1000000;
-
-    const int64_t newest = st->buffer.back().pts_usec;
-    const int64_t cutoff = newest - window_usec;
-
-    size_t drop_before = 0;
-    bool found = false;
-    for (size_t i = 0; i < st->buffer.size(); ++i) {
-        const auto& pk = st->buffer[i];
-        if (pk.pts_usec > cutoff) break;
-        if (pk.hw_type == (uint32_t)ZM_FRAME_COMPRESSED && pk.keyframe) {
-            drop_before = i;
-            found = true;
+    ring.trim((int64_t)window_sec * 1000000, (int64_t)st->max_buffer_sec * 1000000);
+}
+
+// ---------------------------------------------------------------------------
+// Segment file I/O — writer thread. AVIO callbacks over a pwrite()-positioned fd.
+// ---------------------------------------------------------------------------
+int segment_write(void* opaque, const uint8_t* buf, int n) {
+    auto* f = static_cast<SegmentFile*>(opaque);
+    auto t0 = std::chrono::steady_clock::now();
+    size_t off = 0;
+    while (off < (size_t)n) {
+        ssize_t w = ::pwrite(f->fd, buf + off, (size_t)n - off, f->pos + (int64_t)off);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return AVERROR(errno);
         }
+        off += (size_t)w;
+    }
+    f->pos += n;
+    if (f->pos > f->size) f->size = f->pos;
+
+    StoreState* st = f->st;
+    const uint64_t usec = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::steady_clock::now() - t0).count();
+    st->writer.stats.record((uint64_t)n, usec, (uint64_t)st->stall_usec);
+    if (st->stall_usec > 0 && usec >= (uint64_t)st->stall_usec)
+        slog(st, ZM_LOG_WARN, "store: write stall %.1f ms (%d bytes, %zu queued)",
+             usec / 1000.0, n, st->writer.queue->queued_bytes());
+    return n;
+}
+
+// Same write, tagged by the muxer's avio_write_marker(): Matroska marks the start
+// of each cluster that begins with a video keyframe as a SYNC_POINT, and the
+// first chunk after it lands exactly at that cluster's file offset.
+int segment_write_typed(void* opaque, const uint8_t* buf, int n,
+                        enum AVIODataMarkerType type, int64_t time) {
+    auto* f = static_cast<SegmentFile*>(opaque);
+    if (type == AVIO_DATA_MARKER_SYNC_POINT && time != AV_NOPTS_VALUE)
+        f->st->writer.index.AddKeyframe(time, f->pos);
+    return segment_write(opaque, buf, n);
+}
+
+int64_t segment_seek(void* opaque, int64_t offset, int whence) {
+    auto* f = static_cast<SegmentFile*>(opaque);
+    switch (whence & ~AVSEEK_FORCE) {
+        case AVSEEK_SIZE: return f->size;
+        case SEEK_SET: f->pos = offset; break;
+        case SEEK_CUR: f->pos += offset; break;
+        case SEEK_END: f->pos = f->size + offset; break;
+        default: return AVERROR(EINVAL);
     }
-    if (found) {
-        for (size_t i = 0; i < drop_before; ++i)
-            st->buffer.pop_front();
+    return f->pos;
+}
+
+// Open the segment fd and reserve its blocks up front so a growing recording
+// doesn't fragment or hit allocation latency mid-GOP. KEEP_SIZE: the logical
+// size still tracks what was written; close() trims the unused reservation.
+bool segment_open(StoreState* st, const std::string& path) {
+    ClipWriter& w = st->writer;
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        slog(st, ZM_LOG_ERROR, "store: open failed for %s: %s", path.c_str(),
+             strerror(errno));
+        return false;
     }
+#ifdef __linux__
+    const int64_t prealloc = std::max(st->prealloc_bytes, w.last_segment_bytes);
+    if (st->prealloc_bytes > 0 && prealloc > 0)
+        (void)::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)prealloc);
+#endif
+    w.file = SegmentFile{fd, 0, 0, st};
+
+    auto* buf = static_cast<unsigned char*>(av_malloc((size_t)st->write_buffer_bytes));
+    if (buf)
+        w.pb = avio_alloc_context(buf, st->write_buffer_bytes, /*write_flag=*/1,
+                                  &w.file, nullptr, &segment_write, &segment_seek);
+    if (w.pb) {
+        w.pb->write_data_type = &segment_write_typed;
+        w.pb->ignore_boundary_point = 1;  // only keyframe clusters matter
+    }
+    if (!w.pb) {
+        av_free(buf);
+        ::close(fd);
+        w.file.fd = -1;
+        slog(st, ZM_LOG_ERROR, "store: could not allocate AVIO for %s", path.c_str());
+        return false;
+    }
+    return true;
+}
 
-    const int64_t hard_cutoff = newest - (int64_t)st->max_buffer_sec * 1000000;
-    while (st->buffer.size() > 1 && st->buffer.front().pts_usec < hard_cutoff) {
-        bool keyframe_ahead = false;
-        for (size_t i = 1; i < st->buffer.size(); ++i) {
-            if (st->buffer[i].hw_type == (uint32_t)ZM_FRAME_COMPRESSED &&
-                st->buffer[i].keyframe) {
-                keyframe_ahead = true;
-                break;
-            }
+// Returns the final file size.
+int64_t segment_close(StoreState* st) {
+    ClipWriter& w = st->writer;
+    if (w.pb) {
+        avio_flush(w.pb);
+        av_freep(&w.pb->buffer);
+        avio_context_free(&w.pb);
+    }
+    if (w.file.fd >= 0) {
+        // Release the fallocate() reservation past the real end of the clip.
+        if (::ftruncate(w.file.fd, (off_t)w.file.size) != 0)
+            slog(st, ZM_LOG_WARN, "store: ftruncate failed for %s", w.cur_path.c_str());
+        if (st->fsync_on_close) {
+            auto t0 = std::chrono::steady_clock::now();
+            ::fdatasync(w.file.fd);
+            const uint64_t usec = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                                      std::chrono::steady_clock::now() - t0).count();
+            if (st->stall_usec > 0 && usec >= (uint64_t)st->stall_usec) ++w.stats.stalls;
         }
-        if (!keyframe_ahead) break;
-        st->buffer.pop_front();
+        ::close(w.file.fd);
+        if (w.file.size > 0) w.last_segment_bytes = w.file.size;
     }
+    const int64_t size = w.file.size;
+    w.file = SegmentFile{};
+    return size;
 }
 
 // ---------------------------------------------------------------------------
-// Muxer open / write / close. Caller holds mtx.
+// Muxer open / write / close — writer thread only.
 // ---------------------------------------------------------------------------
-bool open_clip(StoreState* st, uint32_t stream_id, std::time_t t) {
-    if (!st->video.valid) {
-        if (!st->warned_no_codec) {
-            slog(st, ZM_LOG_WARN,
-                 "store: recording requested before StreamMetadata known; "
-                 "waiting for codec params");
-            st->warned_no_codec = true;
-        }
-        return false;
-    }
-
-    st->cur_path = make_clip_path(st->root, st->monitor_id, stream_id, t);
+bool open_clip(StoreState* st, const WriteOp& op) {
+    ClipWriter& w = st->writer;
+    w.cur_path = make_clip_path(st->root, st->monitor_id, op.stream_id, op.wall);
     std::error_code ec;
-    fs::create_directories(fs::path(st->cur_path).parent_path(), ec);
+    fs::create_directories(fs::path(w.cur_path).parent_path(), ec);
     // 1-second filename resolution: disambiguate same-second segments.
-    if (fs::exists(st->cur_path)) {
-        const std::string stem = st->cur_path.substr(0, st->cur_path.size() - 4);
+    if (fs::exists(w.cur_path)) {
+        const std::string stem = w.cur_path.substr(0, w.cur_path.size() - 4);
         for (int n = 2;; ++n) {
             std::string cand = stem + "-" + std::to_string(n) + ".mkv";
-            if (!fs::exists(cand)) { st->cur_path = cand; break; }
+            if (!fs::exists(cand)) { w.cur_path = cand; break; }
         }
     }
 
     AVFormatContext* ctx = nullptr;
     if (avformat_alloc_output_context2(&ctx, nullptr, "matroska",
-                                       st->cur_path.c_str()) < 0 || !ctx) {
+                                       w.cur_path.c_str()) < 0 || !ctx) {
         slog(st, ZM_LOG_ERROR, "store: alloc output ctx failed for %s",
-             st->cur_path.c_str());
+             w.cur_path.c_str());
         return false;
     }
-    st->fmt_ctx.reset(ctx);
+    w.fmt_ctx.reset(ctx);
 
-    if (avio_open(&ctx->pb, st->cur_path.c_str(), AVIO_FLAG_WRITE) < 0) {
-        slog(st, ZM_LOG_ERROR, "store: avio_open failed for %s",
-             st->cur_path.c_str());
-        st->fmt_ctx.reset();
+    if (!segment_open(st, w.cur_path)) {
+        w.fmt_ctx.reset();
         return false;
     }
+    ctx->pb = w.pb;
+    ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
 
     AVStream* vst = avformat_new_stream(ctx, nullptr);
     if (!vst) {
         slog(st, ZM_LOG_ERROR, "store: could not create video stream");
-        avio_closep(&ctx->pb);
-        st->fmt_ctx.reset();
+        segment_close(st);
+        w.fmt_ctx.reset();
         return false;
     }
     vst->codecpar->codec_type = AVMEDIA_TYPE_VIDEO;
-    vst->codecpar->codec_id = (enum AVCodecID)st->video.codec_id;
-    vst->codecpar->width = st->video.width;
-    vst->codecpar->height = st->video.height;
-    vst->codecpar->format = st->video.format;
-    vst->codecpar->profile = st->video.profile;
-    vst->codecpar->level = st->video.level;
-    if (!st->video.extradata.empty()) {
-        uint8_t* ed = (uint8_t*)av_mallocz(st->video.extradata.size() +
+    vst->codecpar->codec_id = (enum AVCodecID)op.video.codec_id;
+    vst->codecpar->width = op.video.width;
+    vst->codecpar->height = op.video.height;
+    vst->codecpar->format = op.video.format;
+    vst->codecpar->profile = op.video.profile;
+    vst->codecpar->level = op.video.level;
+    if (!op.video.extradata.empty()) {
+        uint8_t* ed = (uint8_t*)av_mallocz(op.video.extradata.size() +
                                            AV_INPUT_BUFFER_PADDING_SIZE);
         if (ed) {
-            memcpy(ed, st->video.extradata.data(), st->video.extradata.size());
+            memcpy(ed, op.video.extradata.data(), op.video.extradata.size());
             vst->codecpar->extradata = ed;
-            vst->codecpar->extradata_size = (int)st->video.extradata.size();
+            vst->codecpar->extradata_size = (int)op.video.extradata.size();
         }
     }
     vst->time_base = AVRational{1, 1000000};
     vst->avg_frame_rate = AVRational{25, 1};
     vst->r_frame_rate = vst->avg_frame_rate;
-    st->video_stream = vst;
+    w.video_stream = vst;
 
-    st->audio_stream = nullptr;
-    if (st->audio.valid) {
+    w.audio_stream = nullptr;
+    if (op.audio.valid) {
         AVStream* ast = avformat_new_stream(ctx, nullptr);
         if (ast) {
             ast->codecpar->codec_type = AVMEDIA_TYPE_AUDIO;
-            ast->codecpar->codec_id = (enum AVCodecID)st->audio.codec_id;
-            ast->codecpar->sample_rate = st->audio.sample_rate;
+            ast->codecpar->codec_id = (enum AVCodecID)op.audio.codec_id;
+            ast->codecpar->sample_rate = op.audio.sample_rate;
 #if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100)
             av_channel_layout_default(
                 &ast->codecpar->ch_layout,
-                st->audio.channels > 0 ? st->audio.channels : 1);
+                op.audio.channels > 0 ? op.audio.channels : 1);
 #else
-            ast->codecpar->channels = st->audio.channels;
+            ast->codecpar->channels = op.audio.channels;
             ast->codecpar->channel_layout = av_get_default_channel_layout(
-                st->audio.channels > 0 ? st->audio.channels : 1);
+                op.audio.channels > 0 ? op.audio.channels : 1);
 #endif
-            if (!st->audio.extradata.empty()) {
-                uint8_t* ed = (uint8_t*)av_mallocz(st->audio.extradata.size() +
+            if (!op.audio.extradata.empty()) {
+                uint8_t* ed = (uint8_t*)av_mallocz(op.audio.extradata.size() +
                                                    AV_INPUT_BUFFER_PADDING_SIZE);
                 if (ed) {
-                    memcpy(ed, st->audio.extradata.data(),
-                           st->audio.extradata.size());
+                    memcpy(ed, op.audio.extradata.data(),
+                           op.audio.extradata.size());
                     ast->codecpar->extradata = ed;
                     ast->codecpar->extradata_size =
-                        (int)st->audio.extradata.size();
+                        (int)op.audio.extradata.size();
                 }
             }
             ast->time_base = AVRational{1, 1000000};
-            st->audio_stream = ast;
+            w.audio_stream = ast;
         }
     }
 
@@ -408,83 +577,98 @@ bool open_clip(StoreState* st, uint32_t stream_id, std::time_t t) {
         char eb[AV_ERROR_MAX_STRING_SIZE];
         av_strerror(ret, eb, sizeof(eb));
         slog(st, ZM_LOG_ERROR, "store: write_header failed: %s", eb);
-        avio_closep(&ctx->pb);
-        st->fmt_ctx.reset();
-        st->video_stream = nullptr;
-        st->audio_stream = nullptr;
+        segment_close(st);
+        w.fmt_ctx.reset();
+        w.video_stream = nullptr;
+        w.audio_stream = nullptr;
         return false;
     }
 
-    st->header_written = true;
-    st->start_ts = 0;
-    st->last_pts = 0;
-    st->frames_written = 0;
-    slog(st, ZM_LOG_INFO, "store: opened clip %s", st->cur_path.c_str());
+    w.header_written = true;
+    w.opened_wall = op.wall;
+    w.stats = zm::store::WriteStats{};
+    slog(st, ZM_LOG_INFO, "store: opened clip %s", w.cur_path.c_str());
     return true;
 }
 
-void write_packet(StoreState* st, uint32_t hw_type, bool keyframe,
-                  int64_t pts_usec, const uint8_t* data, size_t bytes) {
-    if (!st->header_written || !st->fmt_ctx) return;
+void mux_packet(StoreState* st, const WriteOp& op) {
+    ClipWriter& w = st->writer;
+    if (!w.header_written || !w.fmt_ctx) return;
 
-    AVStream* target = (hw_type == (uint32_t)ZM_FRAME_COMPRESSED_AUDIO)
-                           ? st->audio_stream : st->video_stream;
+    AVStream* target = (op.hw_type == (uint32_t)ZM_FRAME_COMPRESSED_AUDIO)
+                           ? w.audio_stream : w.video_stream;
     if (!target) return;
 
-    if (st->start_ts == 0) st->start_ts = pts_usec;
-    int64_t rel = pts_usec - st->start_ts;
-    if (rel < 0) rel = 0;
+    if (!w.index.IsOpen() &&
+        !w.index.Open(w.cur_path + ".idx", op.pts_usec - op.rel_usec, w.opened_wall))
+        slog(st, ZM_LOG_WARN, "store: could not create index %s.idx", w.cur_path.c_str());
 
     AVPacket* pkt = av_packet_alloc();
     if (!pkt) return;
-    if (av_new_packet(pkt, (int)bytes) < 0) {
+    if (av_new_packet(pkt, (int)op.data.size()) < 0) {
         av_packet_free(&pkt);
         return;
     }
-    memcpy(pkt->data, data, bytes);
+    memcpy(pkt->data, op.data.data(), op.data.size());
     pkt->pts = pkt->dts =
-        av_rescale_q(rel, AVRational{1, 1000000}, target->time_base);
+        av_rescale_q(op.rel_usec, AVRational{1, 1000000}, target->time_base);
     pkt->stream_index = target->index;
-    if (keyframe || hw_type == (uint32_t)ZM_FRAME_COMPRESSED_AUDIO)
+    const bool video_key =
+        op.keyframe && op.hw_type != (uint32_t)ZM_FRAME_COMPRESSED_AUDIO;
+    if (op.keyframe || op.hw_type == (uint32_t)ZM_FRAME_COMPRESSED_AUDIO)
         pkt->flags |= AV_PKT_FLAG_KEY;
 
-    int ret = av_interleaved_write_frame(st->fmt_ctx.get(), pkt);
+    int ret = av_interleaved_write_frame(w.fmt_ctx.get(), pkt);
     if (ret < 0) {
         char eb[AV_ERROR_MAX_STRING_SIZE];
         av_strerror(ret, eb, sizeof(eb));
         slog(st, ZM_LOG_ERROR, "store: write_frame failed: %s", eb);
     }
-    if (hw_type != (uint32_t)ZM_FRAME_COMPRESSED_AUDIO) {
-        st->last_pts = pts_usec;
-        ++st->frames_written;
-    }
     av_packet_free(&pkt);
+    // Flush point: a video keyframe closes the previous Matroska cluster, so
+    // pushing the AVIO buffer now bounds what a crash can lose to one GOP.
+    if (video_key && w.pb) {
+        avio_flush(w.pb);
+        w.index.Flush();
+    }
 }
 
-void close_clip(StoreState* st) {
-    if (!st->fmt_ctx) return;
-    if (st->header_written) {
-        av_write_trailer(st->fmt_ctx.get());
-    }
-    if (st->fmt_ctx->pb) avio_closep(&st->fmt_ctx->pb);
-
-    int64_t duration = st->last_pts - st->start_ts;
-    std::string path = st->cur_path;
-    long ev_id = st->current_event_id;       // captured before the reset below
-    int64_t frames = st->frames_written;
-    std::string cause = st->current_cause;
-    st->fmt_ctx.reset();
-    st->header_written = false;
-    st->video_stream = nullptr;
-    st->audio_stream = nullptr;
-    st->recording = false;
-    st->start_ts = 0;
-    st->last_pts = 0;
-    st->frames_written = 0;
-    st->current_clip_token.clear();
-    st->current_event_id = 0;
-    st->clip_assigned = false;
-    st->current_cause.clear();
+void rename_clip(StoreState* st, const WriteOp& op) {
+    ClipWriter& w = st->writer;
+    if (!w.header_written) return;
+    std::error_code ec;
+    fs::create_directories(op.dir, ec);
+    const std::string target = op.dir + "/" + op.video_name;
+    fs::rename(w.cur_path, target, ec);
+    if (ec) {
+        slog(st, ZM_LOG_WARN,
+             "store: could not move clip to %s (%s); keeping %s",
+             target.c_str(), ec.message().c_str(), w.cur_path.c_str());
+    } else {
+        slog(st, ZM_LOG_INFO, "store: assigned event_id=%ld, clip -> %s",
+             op.event_id, target.c_str());
+        w.cur_path = target;
+        if (w.index.IsOpen() && !w.index.Rename(target + ".idx"))
+            slog(st, ZM_LOG_WARN, "store: could not move index to %s.idx", target.c_str());
+    }
+}
+
+void finish_clip(StoreState* st, const WriteOp& op) {
+    ClipWriter& w = st->writer;
+    if (!w.fmt_ctx) return;
+    if (w.header_written) {
+        av_write_trailer(w.fmt_ctx.get());
+    }
+    const int64_t file_size = segment_close(st);
+
+    const std::string path = w.cur_path;
+    const std::string index_path = w.index.IsOpen() ? w.index.path() : std::string();
+    w.index.Close(op.duration_usec, file_size);
+    const zm::store::WriteStats stats = w.stats;
+    w.fmt_ctx.reset();
+    w.header_written = false;
+    w.video_stream = nullptr;
+    w.audio_stream = nullptr;
 
     // Sidecar JSON next to the clip — the VLM descriptions captured during the
     // event, so recordings are searchable/greppable by what was seen.
@@ -492,11 +676,12 @@ void close_clip(StoreState* st) {
         json side;
         side["clip"] = fs::path(path).filename().string();
         side["path"] = path;
-        side["duration_usec"] = duration;
-        side["cause"] = cause;
+        side["duration_usec"] = op.duration_usec;
+        side["cause"] = op.cause;
+        side["index"] = index_path;
         side["descriptions"] = json::array();
         std::string joined;
-        for (const auto& d : st->descriptions) {
+        for (const auto& d : op.descriptions) {
             try {
                 json dj = json::parse(d);
                 side["descriptions"].push_back(dj);
@@ -511,31 +696,153 @@ void close_clip(StoreState* st) {
         std::ofstream f(side_path);
         if (f) { f << side.dump(2); }
         slog(st, ZM_LOG_INFO, "store: wrote sidecar %s (%zu descriptions)",
-             side_path.c_str(), st->descriptions.size());
+             side_path.c_str(), op.descriptions.size());
     }
-    st->descriptions.clear();
 
+    const size_t high_water = st->writer.queue->high_water_bytes();
     if (st->host && st->host->publish_evt) {
         // recording_saved: echo zm-api's assigned event_id (0 if unassigned), the
         // final path, cause, duration in seconds, and the video frame count.
+        // Published once the trailer is on disk, so the clip is complete.
         json ev = {{"event", "EventClip"},
-                   {"event_id", ev_id},
+                   {"event_id", op.event_id},
                    {"path", path},
-                   {"cause", cause},
-                   {"duration", duration / 1e6},
-                   {"frames", frames}};
+                   {"cause", op.cause},
+                   {"duration", op.duration_usec / 1e6},
+                   {"frames", op.frames},
+                   {"index", index_path},
+                   {"writer", {{"writes", stats.writes},
+                               {"bytes", stats.bytes},
+                               {"stalls", stats.stalls},
+                               {"mean_write_usec", stats.mean_usec()},
+                               {"max_write_usec", stats.max_usec},
+                               {"queue_high_water_bytes", high_water}}}};
         st->host->publish_evt(st->host_ctx, ev.dump().c_str());
     }
     slog(st, ZM_LOG_INFO,
-         "store: closed clip %s (event_id=%ld, cause=%s, duration=%.2fs, frames=%lld)",
-         path.c_str(), ev_id, cause.c_str(), duration / 1e6, (long long)frames);
+         "store: closed clip %s (event_id=%ld, cause=%s, duration=%.2fs, frames=%lld, "
+         "writes=%llu, stalls=%llu, max_write=%.1fms)",
+         path.c_str(), op.event_id, op.cause.c_str(), op.duration_usec / 1e6,
+         (long long)op.frames, (unsigned long long)stats.writes,
+         (unsigned long long)stats.stalls, stats.max_usec / 1000.0);
 }
 
-void write_preroll(StoreState* st) {
-    for (const auto& pk : st->buffer) {
-        write_packet(st, pk.hw_type, pk.keyframe, pk.pts_usec, pk.data.data(),
-                     pk.data.size());
+// Writer thread: execute queued ops in order until the queue is closed+drained.
+void writer_loop(StoreState* st) {
+    ClipWriter& w = st->writer;
+    WriteOp op;
+    while (w.queue->pop(op)) {
+        switch (op.kind) {
+            case WriteOp::Kind::Open:
+                if (w.fmt_ctx) finish_clip(st, WriteOp{});  // defensive: unpaired open
+                w.open_failed = !open_clip(st, op);
+                break;
+            case WriteOp::Kind::Packet:
+                if (!w.open_failed) mux_packet(st, op);
+                break;
+            case WriteOp::Kind::Marker:
+                if (!w.open_failed) w.index.AddEvent(op.rel_usec, op.cause);
+                break;
+            case WriteOp::Kind::Assign:
+                if (!w.open_failed) rename_clip(st, op);
+                break;
+            case WriteOp::Kind::Close:
+                if (!w.open_failed) finish_clip(st, op);
+                w.open_failed = false;
+                break;
+        }
+    }
+    if (w.fmt_ctx) finish_clip(st, WriteOp{});
+}
+
+// ---------------------------------------------------------------------------
+// Capture side: queue muxer work for the writer. Caller holds mtx.
+// ---------------------------------------------------------------------------
+void write_packet(StoreState* st, uint32_t hw_type, bool keyframe,
+                  int64_t pts_usec, const uint8_t* data, size_t bytes) {
+    if (!st->recording) return;
+    const bool is_audio = hw_type == (uint32_t)ZM_FRAME_COMPRESSED_AUDIO;
+
+    // While skipping, only a keyframe is offered to the queue; the skip ends
+    // once one is accepted.
+    if (st->overflow_skip && (is_audio || !keyframe)) {
+        ++st->overflow_dropped;
+        return;
+    }
+
+    if (st->start_ts == 0) st->start_ts = pts_usec;
+    int64_t rel = pts_usec - st->start_ts;
+    if (rel < 0) rel = 0;
+
+    WriteOp op;
+    op.kind = WriteOp::Kind::Packet;
+    op.hw_type = hw_type;
+    op.keyframe = keyframe;
+    op.rel_usec = rel;
+    op.pts_usec = pts_usec;
+    op.data.assign(data, data + bytes);
+    if (!st->writer.queue->push(std::move(op), bytes)) {
+        // Budget exhausted: storage has been stalled for longer than the queue
+        // covers. Skip to the next keyframe rather than writing an undecodable gap.
+        ++st->overflow_dropped;
+        if (!st->overflow_skip)
+            slog(st, ZM_LOG_ERROR,
+                 "store: write queue full (%zu bytes); dropping until next keyframe",
+                 st->writer.queue->queued_bytes());
+        st->overflow_skip = true;
+        return;
+    }
+    if (st->overflow_skip) {
+        slog(st, ZM_LOG_WARN,
+             "store: write queue drained; resuming at keyframe (%llu packets dropped)",
+             (unsigned long long)st->overflow_dropped);
+        st->overflow_skip = false;
     }
+    if (!is_audio) {
+        st->last_pts = pts_usec;
+        ++st->frames_written;
+    }
+}
+
+// Record a trigger in the clip's index at capture time `pts_usec`. Caller holds mtx.
+void mark_event(StoreState* st, const std::string& type, int64_t pts_usec) {
+    if (!st->recording || st->start_ts == 0) return;
+    WriteOp op;
+    op.kind = WriteOp::Kind::Marker;
+    op.cause = type;
+    op.rel_usec = std::max<int64_t>(0, pts_usec - st->start_ts);
+    st->writer.queue->push(std::move(op), 0, /*force=*/true);
+}
+
+void close_clip(StoreState* st) {
+    if (!st->recording) return;
+
+    WriteOp op;
+    op.kind = WriteOp::Kind::Close;
+    op.event_id = st->current_event_id;
+    op.cause = st->current_cause;
+    op.duration_usec = st->last_pts - st->start_ts;
+    op.frames = st->frames_written;
+    op.descriptions = std::move(st->descriptions);
+    st->writer.queue->push(std::move(op), 0, /*force=*/true);
+
+    st->recording = false;
+    st->start_ts = 0;
+    st->last_pts = 0;
+    st->frames_written = 0;
+    st->overflow_skip = false;
+    st->current_clip_token.clear();
+    st->current_event_id = 0;
+    st->clip_assigned = false;
+    st->current_cause.clear();
+    st->descriptions.clear();
+}
+
+void write_preroll(StoreState* st) {
+    if (!st->buffer) return;
+    st->buffer->for_each([st](const zm::store::PrerollRing::Packet& pk) {
+        write_packet(st, pk.hw_type, pk.keyframe, pk.pts_usec, pk.data, pk.size);
+    });
 }
 
 // ---------------------------------------------------------------------------
@@ -546,9 +853,30 @@ void write_preroll(StoreState* st) {
 // Caller holds mtx.
 bool open_recording(StoreState* st, uint32_t stream_id, const std::string& cause,
                     bool with_preroll) {
+    if (!st->video.valid) {
+        if (!st->warned_no_codec) {
+            slog(st, ZM_LOG_WARN,
+                 "store: recording requested before StreamMetadata known; "
+                 "waiting for codec params");
+            st->warned_no_codec = true;
+        }
+        return false;
+    }
+
     std::time_t wall = std::time(nullptr);
-    if (!open_clip(st, stream_id, wall)) return false;
+    WriteOp op;
+    op.kind = WriteOp::Kind::Open;
+    op.stream_id = stream_id;
+    op.wall = wall;
+    op.video = st->video;
+    op.audio = st->audio;
+    st->writer.queue->push(std::move(op), 0, /*force=*/true);
+
     st->recording = true;
+    st->start_ts = 0;
+    st->last_pts = 0;
+    st->frames_written = 0;
+    st->overflow_skip = false;
     st->descriptions.clear();
     st->current_cause = cause;
     st->current_clip_token = std::to_string(st->monitor_id) + "-" +
@@ -571,10 +899,11 @@ bool open_recording(StoreState* st, uint32_t stream_id, const std::string& cause
     return true;
 }
 
-// Apply a pending event-id assignment from zm-api: rename the in-progress clip
-// from store's own-naming path to zm-api's target. The open avio fd keeps writing
-// the same inode after rename (POSIX, same filesystem); a cross-filesystem move
-// fails and we keep the own-naming file as a fallback. Caller holds mtx.
+// Apply a pending event-id assignment from zm-api: the writer renames the
+// in-progress clip from store's own-naming path to zm-api's target. The open fd
+// keeps writing the same inode after rename (POSIX, same filesystem); a
+// cross-filesystem move fails and we keep the own-naming file as a fallback.
+// Caller holds mtx.
 void apply_pending_assignment(StoreState* st) {
     if (st->clip_assigned || !st->recording) return;
     StoreState::Assignment a;
@@ -589,19 +918,12 @@ void apply_pending_assignment(StoreState* st) {
     st->clip_assigned = true;
     if (a.dir.empty() || a.video_name.empty()) return;  // id only, keep own naming
 
-    std::error_code ec;
-    fs::create_directories(a.dir, ec);
-    const std::string target = a.dir + "/" + a.video_name;
-    fs::rename(st->cur_path, target, ec);
-    if (ec) {
-        slog(st, ZM_LOG_WARN,
-             "store: could not move clip to %s (%s); keeping %s",
-             target.c_str(), ec.message().c_str(), st->cur_path.c_str());
-    } else {
-        slog(st, ZM_LOG_INFO, "store: assigned event_id=%ld, clip -> %s",
-             a.event_id, target.c_str());
-        st->cur_path = target;
-    }
+    WriteOp op;
+    op.kind = WriteOp::Kind::Assign;
+    op.event_id = a.event_id;
+    op.dir = a.dir;
+    op.video_name = a.video_name;
+    st->writer.queue->push(std::move(op), 0, /*force=*/true);
 }
 
 // StreamMetadata event -> configure codec params. Caller holds mtx.
@@ -690,12 +1012,14 @@ void event_cb(void* user, const char* json_event) {
     if (!stream_allowed(st, sid)) return;
 
     std::lock_guard<std::mutex> lk(st->mtx);
-    int64_t now_usec = st->buffer.empty() ? st->last_pts : st->buffer.back().pts_usec;
+    int64_t now_usec = (!st->buffer || st->buffer->empty()) ? st->last_pts
+                                                            : st->buffer->newest_pts();
 
     if (st->mode == Mode::Both) {
         // Continuous file is (or will be) recording; a trigger just sets the
         // segment's cause (and its descriptions are captured above).
         if (st->recording) st->current_cause = type;
+        mark_event(st, type, now_usec);
         st->last_trigger_usec = now_usec;
         return;
     }
@@ -704,6 +1028,7 @@ void event_cb(void* user, const char* json_event) {
     if (!st->recording) {
         open_recording(st, sid, type, /*with_preroll=*/true);
     }
+    mark_event(st, type, now_usec);
     st->last_trigger_usec = now_usec;
 }
 
@@ -810,6 +1135,12 @@ int handle_start(zm_plugin_t* plugin, zm_host_api_t* host, void* host_ctx,
         st->pre_roll_sec = j.value("pre_roll_sec", 5);
         st->post_roll_sec = j.value("post_roll_sec", 10);
         st->max_buffer_sec = j.value("max_buffer_sec", 15);
+        st->preroll_kbps = std::max(256, j.value("preroll_kbps", 8000));
+        st->write_queue_bytes = (size_t)std::max(1, j.value("write_queue_mb", 64)) << 20;
+        st->write_buffer_bytes = std::max(64, j.value("write_buffer_kb", 1024)) << 10;
+        st->prealloc_bytes = (int64_t)std::max(0, j.value("prealloc_mb", 64)) << 20;
+        st->stall_usec = (int64_t)std::max(0, j.value("stall_ms", 500)) * 1000;
+        st->fsync_on_close = j.value("fsync_on_close", true);
         if (j.contains("trigger_types") && j["trigger_types"].is_array()) {
             for (const auto& t : j["trigger_types"])
                 if (t.is_string()) st->trigger_types.push_back(t.get<std::string>());
@@ -826,6 +1157,15 @@ int handle_start(zm_plugin_t* plugin, zm_host_api_t* host, void* host_ctx,
     }
     if (st->max_buffer_sec < st->pre_roll_sec)
         st->max_buffer_sec = st->pre_roll_sec + 2;
+    if (st->mode == Mode::Event) {
+        // Fixed per-monitor footprint: bitrate x seconds of pre-roll history.
+        const size_t arena = (size_t)st->preroll_kbps * 1000 / 8 * (size_t)st->max_buffer_sec;
+        st->buffer = std::make_unique<zm::store::PrerollRing>(arena);
+    }
+
+    st->writer.queue =
+        std::make_unique<zm::store::WriteQueue<WriteOp>>(st->write_queue_bytes);
+    st->writer.thread = std::thread(writer_loop, st);
 
     st->running.store(true, std::memory_order_release);
 
@@ -836,9 +1176,10 @@ int handle_start(zm_plugin_t* plugin, zm_host_api_t* host, void* host_ctx,
     plugin->instance = ctx;
 
     slog(st, ZM_LOG_INFO,
-         "store: started mode=%s root=%s max_secs=%d pre_roll=%d post_roll=%d",
+         "store: started mode=%s root=%s max_secs=%d pre_roll=%d post_roll=%d "
+         "write_queue=%zuMB",
          mode_name(st->mode), st->root.c_str(), st->max_secs,
-         st->pre_roll_sec, st->post_roll_sec);
+         st->pre_roll_sec, st->post_roll_sec, st->write_queue_bytes >> 20);
     return 0;
 }
 
@@ -852,8 +1193,13 @@ void handle_stop(zm_plugin_t* plugin) {
             ctx->host->unsubscribe_evt(ctx->host_ctx, st->sub_handle);
         st->running.store(false, std::memory_order_release);
 
-        std::lock_guard<std::mutex> lk(st->mtx);
-        if (st->recording || st->fmt_ctx) close_clip(st);
+        {
+            std::lock_guard<std::mutex> lk(st->mtx);
+            close_clip(st);
+        }
+        // Drain the write-behind queue so the last clip gets its trailer.
+        st->writer.queue->close();
+        if (st->writer.thread.joinable()) st->writer.thread.join();
     }
 
     delete ctx;  // `st` is intentionally leaked so a late callback can't dangle.
@@ -0,0 +1,120 @@
+#include "preroll_ring.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+using zm::store::PrerollRing;
+
+namespace {
+
+constexpr uint32_t kVideo = 100;  // ZM_FRAME_COMPRESSED
+constexpr uint32_t kAudio = 104;  // ZM_FRAME_COMPRESSED_AUDIO
+
+// Append one video packet of `size` bytes filled with `tag`.
+bool add_video(PrerollRing& r, int64_t pts, bool key, size_t size, uint8_t tag) {
+    std::vector<uint8_t> d(size, tag);
+    return r.append(0, kVideo, key, key, pts, d.data(), d.size());
+}
+
+std::vector<int64_t> pts_list(const PrerollRing& r) {
+    std::vector<int64_t> out;
+    r.for_each([&](const PrerollRing::Packet& p) { out.push_back(p.pts_usec); });
+    return out;
+}
+
+}  // namespace
+
+TEST(PrerollRing, StoresPacketsInOrderAsViews) {
+    PrerollRing r(1024);
+    add_video(r, 0, true, 10, 0xA);
+    std::vector<uint8_t> a(5, 0xB);
+    r.append(0, kAudio, false, false, 5, a.data(), a.size());
+    add_video(r, 40, false, 20, 0xC);
+    EXPECT_EQ(r.packets(), 3u);
+    EXPECT_EQ(r.used_bytes(), 35u);
+    std::vector<uint8_t> tags;
+    r.for_each([&](const PrerollRing::Packet& p) {
+        ASSERT_GT(p.size, 0u);
+        for (size_t i = 0; i < p.size; ++i) ASSERT_EQ(p.data[i], p.data[0]);
+        tags.push_back(p.data[0]);
+    });
+    EXPECT_EQ(tags, (std::vector<uint8_t>{0xA, 0xB, 0xC}));
+    EXPECT_EQ(r.newest_pts(), 40);
+}
+
+TEST(PrerollRing, TrimDropsWholeGopsOutsideWindow) {
+    PrerollRing r(1 << 16);
+    // GOPs start at 0, 1s, 2s, 3s; 4 frames per GOP.
+    for (int g = 0; g < 4; ++g)
+        for (int f = 0; f < 4; ++f)
+            add_video(r, g * 1000000 + f * 250000, f == 0, 8, (uint8_t)g);
+    ASSERT_EQ(r.gops(), 4u);
+    // Window of 1.5 s back from 3.75 s => cutoff 2.25 s: keep from the GOP at 2 s.
+    r.trim(1500000, 10000000);
+    EXPECT_EQ(r.gops(), 2u);
+    EXPECT_EQ(r.oldest_pts(), 2000000);
+    EXPECT_EQ(r.packets(), 8u);
+}
+
+TEST(PrerollRing, TrimDropsLeadingPacketsBeforeFirstKeyframe) {
+    PrerollRing r(1 << 16);
+    add_video(r, 0, false, 8, 1);   // mid-GOP join: no keyframe yet
+    add_video(r, 100, false, 8, 1);
+    add_video(r, 200, true, 8, 2);
+    add_video(r, 300, false, 8, 2);
+    r.trim(/*window=*/50, /*hard=*/1000000);
+    EXPECT_EQ(pts_list(r), (std::vector<int64_t>{200, 300}));
+}
+
+TEST(PrerollRing, HardCapNeverDropsNewestGop) {
+    PrerollRing r(1 << 16);
+    add_video(r, 0, true, 8, 1);
+    for (int i = 1; i < 10; ++i) add_video(r, i * 1000000, false, 8, 1);
+    // One long GOP older than the hard cap: nothing else to fall back to.
+    r.trim(1000000, 2000000);
+    EXPECT_EQ(r.oldest_pts(), 0);
+    add_video(r, 10000000, true, 8, 2);
+    r.trim(1000000, 2000000);
+    EXPECT_EQ(r.oldest_pts(), 10000000);
+    EXPECT_EQ(r.packets(), 1u);
+}
+
+TEST(PrerollRing, FullArenaEvictsOldestGopAndWraps) {
+    PrerollRing r(100);
+    add_video(r, 0, true, 30, 1);
+    add_video(r, 1, false, 30, 1);
+    add_video(r, 2, true, 30, 2);
+    // 90 used; a 30-byte packet doesn't fit in the tail -> evict GOP 1, wrap to 0.
+    add_video(r, 3, false, 30, 2);
+    EXPECT_EQ(r.space_evictions(), 1u);
+    EXPECT_EQ(pts_list(r), (std::vector<int64_t>{2, 3}));
+    EXPECT_EQ(r.used_bytes(), 60u);
+    // Payload integrity across the wrap.
+    std::vector<uint8_t> tags;
+    r.for_each([&](const PrerollRing::Packet& p) { tags.push_back(p.data[p.size - 1]); });
+    EXPECT_EQ(tags, (std::vector<uint8_t>{2, 2}));
+}
+
+TEST(PrerollRing, SingleGopLargerThanArenaRestarts) {
+    PrerollRing r(64);
+    add_video(r, 0, true, 30, 1);
+    add_video(r, 1, false, 30, 1);
+    add_video(r, 2, false, 30, 1);  // no older GOP to evict: start over
+    EXPECT_EQ(r.packets(), 1u);
+    EXPECT_EQ(r.oldest_pts(), 2);
+    EXPECT_FALSE(add_video(r, 3, true, 65, 1));  // larger than the arena
+}
+
+TEST(PrerollRing, SteadyStateReusesArena) {
+    PrerollRing r(4096);
+    int64_t pts = 0;
+    for (int i = 0; i < 10000; ++i, pts += 40000) {
+        ASSERT_TRUE(add_video(r, pts, i % 25 == 0, 37 + (i % 11), (uint8_t)i));
+        r.trim(2000000, 3000000);
+        ASSERT_LE(r.used_bytes(), r.capacity());
+    }
+    EXPECT_GT(r.packets(), 0u);
+    EXPECT_LE(r.newest_pts() - r.oldest_pts(), 3000000);
+}
@@ -0,0 +1,84 @@
+#include "write_queue.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using zm::store::WriteQueue;
+using zm::store::WriteStats;
+
+TEST(WriteQueue, FifoOrderAndByteAccounting) {
+    WriteQueue<int> q(100);
+    EXPECT_TRUE(q.push(1, 10));
+    EXPECT_TRUE(q.push(2, 20));
+    EXPECT_EQ(q.queued_bytes(), 30u);
+    int v = 0;
+    ASSERT_TRUE(q.pop(v));
+    EXPECT_EQ(v, 1);
+    EXPECT_EQ(q.queued_bytes(), 20u);
+    ASSERT_TRUE(q.pop(v));
+    EXPECT_EQ(v, 2);
+    EXPECT_EQ(q.queued_bytes(), 0u);
+    EXPECT_EQ(q.high_water_bytes(), 30u);
+}
+
+TEST(WriteQueue, RejectsOverBudgetButNotForced) {
+    WriteQueue<int> q(50);
+    EXPECT_TRUE(q.push(1, 40));
+    EXPECT_FALSE(q.push(2, 20));       // 60 > 50
+    EXPECT_EQ(q.rejected(), 1u);
+    EXPECT_TRUE(q.push(3, 20, true));  // control op: never rejected
+    EXPECT_EQ(q.size(), 2u);
+    EXPECT_EQ(q.queued_bytes(), 60u);
+}
+
+TEST(WriteQueue, OversizedItemAcceptedIntoEmptyQueue) {
+    WriteQueue<int> q(10);
+    EXPECT_TRUE(q.push(1, 1000));
+    EXPECT_FALSE(q.push(2, 1));
+}
+
+TEST(WriteQueue, CloseDrainsThenStops) {
+    WriteQueue<std::string> q(1024);
+    q.push(std::string("a"), 1);
+    q.push(std::string("b"), 1);
+    q.close();
+    EXPECT_FALSE(q.push(std::string("c"), 1));
+    std::string s;
+    ASSERT_TRUE(q.pop(s));
+    EXPECT_EQ(s, "a");
+    ASSERT_TRUE(q.pop(s));
+    EXPECT_EQ(s, "b");
+    EXPECT_FALSE(q.pop(s));
+}
+
+TEST(WriteQueue, ConsumerThreadSeesEveryItemInOrder) {
+    WriteQueue<int> q(1 << 20);
+    std::vector<int> got;
+    std::thread consumer([&] {
+        int v;
+        while (q.pop(v)) got.push_back(v);
+    });
+    for (int i = 0; i < 1000; ++i) ASSERT_TRUE(q.push(int(i), 16));
+    q.close();
+    consumer.join();
+    ASSERT_EQ(got.size(), 1000u);
+    for (int i = 0; i < 1000; ++i) EXPECT_EQ(got[i], i);
+}
+
+TEST(WriteStats, TracksStallsAndMean) {
+    WriteStats s;
+    s.record(100, 10, 50);
+    s.record(100, 90, 50);
+    s.record(100, 50, 50);
+    EXPECT_EQ(s.writes, 3u);
+    EXPECT_EQ(s.bytes, 300u);
+    EXPECT_EQ(s.stalls, 2u);  // 90 and 50 (>= threshold)
+    EXPECT_EQ(s.max_usec, 90u);
+    EXPECT_EQ(s.mean_usec(), 50u);
+    WriteStats off;
+    off.record(1, 1000000, 0);  // threshold 0 disables stall counting
+    EXPECT_EQ(off.stalls, 0u);
+}
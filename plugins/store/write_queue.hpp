@@ -0,0 +1,124 @@
+// write_queue.hpp — pure helper for store's write-behind recorder thread.
+//
+// WriteQueue<T> is a bounded FIFO whose budget is counted in BYTES, not items:
+// the capture thread pushes muxer work (packets + open/rename/close ops) and the
+// writer thread pops it. A push that would exceed the byte budget is rejected so
+// the caller can apply its own drop policy (store drops to the next keyframe so
+// the recording stays decodable). Control items are pushed with force=true and
+// are never rejected — like WorkerLink's control messages, losing an open/close
+// would corrupt the recording, whereas their byte cost is negligible.
+//
+// Free of FFmpeg / ABI dependencies so it can be unit-tested on its own.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace zm {
+namespace store {
+
+template <typename T>
+class WriteQueue {
+public:
+    explicit WriteQueue(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+    WriteQueue(const WriteQueue&) = delete;
+    WriteQueue& operator=(const WriteQueue&) = delete;
+
+    // Enqueue `item` accounting `bytes` against the budget. Returns false (and
+    // leaves `item` untouched) if the queue is closed, or if it would exceed the
+    // budget and `force` is not set. A single item larger than the whole budget
+    // is accepted into an EMPTY queue so an oversized keyframe can't wedge it.
+    bool push(T&& item, size_t bytes, bool force = false) {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (closed_) return false;
+            if (!force && !items_.empty() && queued_bytes_ + bytes > max_bytes_) {
+                ++rejected_;
+                return false;
+            }
+            items_.emplace_back(std::move(item), bytes);
+            queued_bytes_ += bytes;
+            if (queued_bytes_ > high_water_) high_water_ = queued_bytes_;
+        }
+        cv_.notify_one();
+        return true;
+    }
+
+    // Block until an item is available and move it into `out`. Returns false once
+    // the queue is closed AND drained (the writer's exit condition).
+    bool pop(T& out) {
+        std::unique_lock<std::mutex> lk(mtx_);
+        cv_.wait(lk, [this] { return !items_.empty() || closed_; });
+        if (items_.empty()) return false;
+        out = std::move(items_.front().first);
+        queued_bytes_ -= items_.front().second;
+        items_.pop_front();
+        return true;
+    }
+
+    // Stop accepting new items; pop() keeps draining what is queued.
+    void close() {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    size_t max_bytes() const { return max_bytes_; }
+    size_t queued_bytes() const {
+        std::lock_guard<std::mutex> lk(mtx_);
+        return queued_bytes_;
+    }
+    size_t high_water_bytes() const {
+        std::lock_guard<std::mutex> lk(mtx_);
+        return high_water_;
+    }
+    uint64_t rejected() const {
+        std::lock_guard<std::mutex> lk(mtx_);
+        return rejected_;
+    }
+    size_t size() const {
+        std::lock_guard<std::mutex> lk(mtx_);
+        return items_.size();
+    }
+
+private:
+    const size_t max_bytes_;
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<std::pair<T, size_t>> items_;
+    size_t queued_bytes_ = 0;
+    size_t high_water_ = 0;
+    uint64_t rejected_ = 0;
+    bool closed_ = false;
+};
+
+// Latency/stall accounting for the writer's write() syscalls. Plain counters;
+// the writer thread is the only mutator, readers take a snapshot on clip close.
+struct WriteStats {
+    uint64_t writes = 0;
+    uint64_t bytes = 0;
+    uint64_t stalls = 0;            // writes slower than the stall threshold
+    uint64_t total_usec = 0;
+    uint64_t max_usec = 0;
+
+    void record(uint64_t nbytes, uint64_t usec, uint64_t stall_usec) {
+        ++writes;
+        bytes += nbytes;
+        total_usec += usec;
+        if (usec > max_usec) max_usec = usec;
+        if (stall_usec > 0 && usec >= stall_usec) ++stalls;
+    }
+    uint64_t mean_usec() const { return writes ? total_usec / writes : 0; }
+};
+
+}  // namespace store
+}  // namespace zm
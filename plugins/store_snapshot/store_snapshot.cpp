@@ -1,9 +1,9 @@
 // store_snapshot: write a JPEG snapshot/thumbnail to disk when an alarm event
 // fires — for event thumbnails in the UI.
 //
-// This is a ZM_PLUGIN_PROCESS pass-through. It keeps the latest decoded RGB24
-// frame in memory (under a mutex) and, when a triggering event arrives via the
-// host event subscription, JPEG-encodes that frame and writes it to:
+// This is a ZM_PLUGIN_PROCESS pass-through. It tracks the latest decoded RGB24
+// frame and, when a triggering event arrives via the host event subscription,
+// JPEG-encodes that frame and writes it to:
 //
 //   {root}/{YYYY-MM-DD}/snap-{stream}-{HH-MM-SS-mmm}.jpg
 //
@@ -12,30 +12,29 @@
 //
 // Data flow:
 //   on_frame (capture thread):
-//     - if the frame is ZM_FRAME_RGB24 and passes stream_filter, copy it into
-//       the "latest frame" buffer under the mutex,
+//     - if the frame is ZM_FRAME_RGB24 and passes stream_filter, note its
+//       stream/pts under the mutex. When the host provides a frame cache
+//       (zm_host_api_t.frame_cache) that is all: the pixels are fetched from the
+//       cache at snapshot time. Otherwise copy it into the "latest frame" buffer,
 //     - ALWAYS forward downstream via host->on_frame (pass-through). Non-RGB24
 //       frames are forwarded untouched.
 //   event callback (publisher thread, via host->subscribe_evt):
 //     - if the event "type" is a configured trigger and the throttle window has
-//       elapsed, snapshot the latest frame under the mutex, JPEG-encode it, and
-//       write it to disk.
+//       elapsed, take a reference to the latest frame from the host cache (or
+//       copy our own under the mutex), JPEG-encode it, and write it to disk.
 //
 // Lifetime: state is a raw, leaked struct handed to the host callback as `user`
 // plus an atomic `running`; we unsubscribe in stop(). The event callback (reader
 // of the latest frame) and on_frame (writer) are serialised by st->mtx.
 
 #include "snapshot_util.hpp"
+#include "frame_cache.hpp"
+#include "image_encode.hpp"
 
 #include <zm_plugin.h>
+#include <zm_side_data.h>
 #include <nlohmann/json.hpp>
 
-extern "C" {
-#include <libavcodec/avcodec.h>
-#include <libavutil/imgutils.h>
-#include <libswscale/swscale.h>
-}
-
 #include <algorithm>
 #include <atomic>
 #include <chrono>
@@ -77,6 +76,10 @@ struct StoreSnapshotState {
     // Lifetime gate for the host callback.
     std::atomic<bool> running{false};
 
+    // Host frame cache in use: latest_frame stays empty and take_snapshot
+    // acquires the host's reference instead.
+    bool use_cache = false;
+
     // Latest RGB24 frame + throttle state — guarded by mtx. on_frame (capture
     // thread) writes the frame; the event callback (publisher thread) reads it.
     std::mutex mtx;
@@ -148,78 +151,15 @@ bool stream_allowed(const StoreSnapshotState* st, uint32_t sid) {
 }
 
 // ---------------------------------------------------------------------------
-// JPEG encoding helper (FFmpeg mjpeg encoder). Mirrors describe_vlm: sws_scale
-// RGB24 -> YUVJ420P, then the mjpeg encoder. `quality` is the native FFmpeg
-// qscale (2..31, lower == better quality / larger file).
+// JPEG encoding: the shared pooled mjpeg encoder (plugins/common), so repeated
+// snapshots reuse one opened encoder. `quality` is the native FFmpeg qscale
+// (2..31, lower == better quality / larger file).
 // ---------------------------------------------------------------------------
 bool encode_rgb24_to_jpeg(const uint8_t* rgb, int width, int height,
                           int quality, std::vector<uint8_t>& out) {
-    out.clear();
-    if (!rgb || width <= 0 || height <= 0) return false;
-    if (quality < 2) quality = 2;
-    if (quality > 31) quality = 31;
-
-    const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
-    if (!codec) return false;
-
-    AVCodecContext* cctx = avcodec_alloc_context3(codec);
-    if (!cctx) return false;
-
-    cctx->pix_fmt = AV_PIX_FMT_YUVJ420P;
-    cctx->width = width;
-    cctx->height = height;
-    cctx->time_base = AVRational{1, 25};
-    cctx->color_range = AVCOL_RANGE_JPEG;
-    // Drive mjpeg quality via fixed qscale (FF_QP2LAMBDA-scaled).
-    cctx->flags |= AV_CODEC_FLAG_QSCALE;
-    cctx->global_quality = quality * FF_QP2LAMBDA;
-
-    SwsContext* sws = nullptr;
-    AVFrame* frame = nullptr;
-    AVPacket* pkt = nullptr;
-    bool ok = false;
-
-    do {
-        if (avcodec_open2(cctx, codec, nullptr) < 0) break;
-
-        frame = av_frame_alloc();
-        if (!frame) break;
-        frame->format = cctx->pix_fmt;
-        frame->width = width;
-        frame->height = height;
-        if (av_frame_get_buffer(frame, 32) < 0) break;
-
-        sws = sws_getContext(width, height, AV_PIX_FMT_RGB24, width, height,
-                             AV_PIX_FMT_YUVJ420P, SWS_BILINEAR, nullptr, nullptr,
-                             nullptr);
-        if (!sws) break;
-
-        const uint8_t* srcSlice[1] = {rgb};
-        int srcStride[1] = {3 * width};
-        sws_scale(sws, srcSlice, srcStride, 0, height, frame->data,
-                  frame->linesize);
-
-        frame->pts = 0;
-        frame->quality = cctx->global_quality;
-
-        if (avcodec_send_frame(cctx, frame) < 0) break;
-
-        pkt = av_packet_alloc();
-        if (!pkt) break;
-
-        int ret = avcodec_receive_packet(cctx, pkt);
-        if (ret < 0) break;
-
-        out.assign(pkt->data, pkt->data + pkt->size);
-        ok = true;
-    } while (false);
-
-    if (pkt) av_packet_free(&pkt);
-    if (frame) av_frame_free(&frame);
-    if (sws) sws_freeContext(sws);
-    if (cctx) avcodec_free_context(&cctx);
-
-    return ok;
+    zm::img::JpegOptions opt;
+    opt.qscale = std::clamp(quality, 2, 31);
+    return zm::img::encode_rgb24_to_jpeg(rgb, width, height, out, opt);
 }
 
 // Write a buffer to a file atomically-ish (parent dirs created). Returns true on
@@ -241,11 +181,14 @@ bool write_file(const std::string& path, const std::vector<uint8_t>& data) {
 // ---------------------------------------------------------------------------
 void take_snapshot(StoreSnapshotState* st, int64_t now_ms) {
     std::vector<uint8_t> rgb;
+    zm::fc::FrameRef ref;
+    const uint8_t* pixels = nullptr;
+    size_t pixels_size = 0;
     int width = 0, height = 0;
     uint32_t stream_id = 0;
     {
         std::lock_guard<std::mutex> lk(st->mtx);
-        if (!st->have_frame || st->latest_frame.empty()) {
+        if (!st->have_frame || (!st->use_cache && st->latest_frame.empty())) {
             if (!st->warned_no_frame) {
                 slog(st, ZM_LOG_WARN,
                      "store_snapshot: trigger before any RGB24 frame seen; "
@@ -254,12 +197,29 @@ void take_snapshot(StoreSnapshotState* st, int64_t now_ms) {
             }
             return;
         }
-        rgb = st->latest_frame;  // copy under lock
+        if (!st->use_cache) rgb = st->latest_frame;  // copy under lock
         width = st->latest_width;
         height = st->latest_height;
         stream_id = st->latest_stream_id;
         st->last_snapshot_ms = now_ms;  // reserve the throttle slot
     }
+    if (st->use_cache) {
+        const uint32_t bytes = (width > 0 && height > 0) ? (uint32_t)width * height * 3 : 0;
+        ref = zm::fc::FrameRef::latest(st->host, st->host_ctx, stream_id,
+                                       ZM_FRAME_RGB24, bytes);
+        if (!ref) {
+            slog(st, ZM_LOG_WARN,
+                 "store_snapshot: no cached %dx%d RGB24 frame for stream %u; "
+                 "skipping snapshot",
+                 width, height, stream_id);
+            return;
+        }
+        pixels = ref.payload();
+        pixels_size = ref.payload_size();
+    } else {
+        pixels = rgb.data();
+        pixels_size = rgb.size();
+    }
 
     if (width <= 0 || height <= 0) {
         slog(st, ZM_LOG_ERROR,
@@ -268,7 +228,7 @@ void take_snapshot(StoreSnapshotState* st, int64_t now_ms) {
              width, height);
         return;
     }
-    if (rgb.size() < (size_t)width * (size_t)height * 3) {
+    if (pixels_size < (size_t)width * (size_t)height * 3) {
         slog(st, ZM_LOG_ERROR,
              "store_snapshot: frame buffer too small for %dx%d RGB24", width,
              height);
@@ -276,7 +236,7 @@ void take_snapshot(StoreSnapshotState* st, int64_t now_ms) {
     }
 
     std::vector<uint8_t> jpeg;
-    if (!encode_rgb24_to_jpeg(rgb.data(), width, height, st->jpeg_quality,
+    if (!encode_rgb24_to_jpeg(pixels, width, height, st->jpeg_quality,
                               jpeg)) {
         slog(st, ZM_LOG_ERROR, "store_snapshot: JPEG encode failed");
         return;
@@ -358,7 +318,7 @@ void handle_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
     const zm_frame_hdr_t* hdr = static_cast<const zm_frame_hdr_t*>(buf);
     const uint8_t* payload =
         static_cast<const uint8_t*>(buf) + sizeof(zm_frame_hdr_t);
-    size_t payload_size = size - sizeof(zm_frame_hdr_t);
+    size_t payload_size = zm_frame_payload_size(buf, size);
 
     // Only RGB24 frames are snapshot-able; everything else just forwards.
     if (hdr->hw_type == (uint32_t)ZM_FRAME_RGB24 &&
@@ -370,7 +330,7 @@ void handle_frame(zm_plugin_t* plugin, const void* buf, size_t size) {
         int height = st->frame_height;
 
         std::lock_guard<std::mutex> lk(st->mtx);
-        st->latest_frame.assign(payload, payload + payload_size);
+        if (!st->use_cache) st->latest_frame.assign(payload, payload + payload_size);
         st->latest_width = width;
         st->latest_height = height;
         st->latest_stream_id = hdr->stream_id;
@@ -419,6 +379,7 @@ int handle_start(zm_plugin_t* plugin, zm_host_api_t* host, void* host_ctx,
     if (st->jpeg_quality > 31) st->jpeg_quality = 31;
     if (st->min_interval_ms < 0) st->min_interval_ms = 0;
 
+    st->use_cache = zm::fc::retain(host, host_ctx, 1);
     st->running.store(true, std::memory_order_release);
 
     if (host && host->subscribe_evt)
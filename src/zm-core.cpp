@@ -156,6 +156,7 @@ int main(int argc, char** argv) {
 
     // Per-instance shared-memory segment name so concurrent monitors don't clash.
     pm.setRingName("zm_shmring_" + std::to_string(monitorId));
+    pm.setRateControl(loader.getRateControl());
 
     pm.startAll();
     std::cout << "[zm-core] Pipeline running. Press Ctrl+C to exit." << std::endl;
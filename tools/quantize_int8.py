@@ -0,0 +1,272 @@
+#!/usr/bin/env python3
+"""Build an INT8 (QDQ) detect_onnx model from an FP32 one, calibrated on real frames.
+
+The calibration set comes from the same clip a capture_file replay plays.
+Frames are letterboxed exactly like detect_onnx does (bilinear, 114 padding,
+/255, CHW). When a bench_events dump of that clip is given, the frames that
+had detections are preferred, so the activation ranges cover real objects.
+After quantizing, both models run on held-out frames of the clip with the CPU
+EP (one intra-op thread, as in the plugin). The tool reports the INT8
+detections' agreement with FP32 (recall / precision at IoU 0.5, same class)
+and the per-frame latency of both.
+
+  python quantize_int8.py --model yolo26n.onnx --clip replay.mp4 \\
+      [--events events.jsonl] [--out yolo26n.int8.onnx] [--calib-frames 200] \\
+      [--eval-frames 100] [--input-size 640] [--conf 0.25] \\
+      [--method minmax|entropy|percentile] [--op-types Conv,MatMul] \\
+      [--max-recall-loss 0.03] [--report report.json]
+
+The default output name, <model>.int8.onnx, is the one detect_onnx picks up
+for "precision": "int8". The exit status is 1 when the recall loss exceeds
+--max-recall-loss.
+
+Needs onnxruntime (with onnxruntime.quantization), onnx, numpy and opencv-python.
+"""
+import argparse, json, os, sys, tempfile, time
+
+import cv2
+import numpy as np
+import onnxruntime as ort
+from onnxruntime.quantization import (CalibrationDataReader, CalibrationMethod, QuantFormat,
+                                      QuantType, quantize_static)
+from onnxruntime.quantization.shape_inference import quant_pre_process
+
+
+def letterbox(rgb, net):
+    """detect_postprocess.hpp letterbox_rgb_to_chw: returns (1,3,net,net) float32, lb."""
+    h, w = rgb.shape[:2]
+    scale = min(net / w, net / h)
+    nw, nh = int(round(w * scale)), int(round(h * scale))
+    pad_x, pad_y = (net - nw) // 2, (net - nh) // 2
+    out = np.full((net, net, 3), 114.0 / 255.0, np.float32)
+    resized = cv2.resize(rgb, (nw, nh), interpolation=cv2.INTER_LINEAR).astype(np.float32) / 255.0
+    out[pad_y:pad_y + nh, pad_x:pad_x + nw] = resized
+    return out.transpose(2, 0, 1)[None].copy(), (scale, pad_x, pad_y, w, h)
+
+
+def decode(out, lb, conf):
+    """decode_nms_free: [N,6] net-space xyxy/conf/cls -> source-pixel boxes."""
+    scale, px, py, w, h = lb
+    rows = out.reshape(-1, 6)
+    boxes = []
+    for x1, y1, x2, y2, c, cls in rows:
+        if c < conf:
+            continue
+        sx1 = min(max((x1 - px) / scale, 0), w); sy1 = min(max((y1 - py) / scale, 0), h)
+        sx2 = min(max((x2 - px) / scale, 0), w); sy2 = min(max((y2 - py) / scale, 0), h)
+        if sx2 - sx1 <= 0 or sy2 - sy1 <= 0:
+            continue
+        boxes.append((sx1, sy1, sx2 - sx1, sy2 - sy1, float(c), int(round(cls))))
+    return boxes
+
+
+def iou(a, b):
+    ix = max(0.0, min(a[0] + a[2], b[0] + b[2]) - max(a[0], b[0]))
+    iy = max(0.0, min(a[1] + a[3], b[1] + b[3]) - max(a[1], b[1]))
+    inter = ix * iy
+    uni = a[2] * a[3] + b[2] * b[3] - inter
+    return inter / uni if uni > 0 else 0.0
+
+
+class Agreement:
+    """compare_detections in detect_postprocess.hpp."""
+    def __init__(self):
+        self.frames = self.ref = self.test = self.matched = 0
+        self.dconf = self.iou = 0.0
+
+    def add(self, ref, test, thr=0.5):
+        self.frames += 1
+        self.ref += len(ref)
+        self.test += len(test)
+        used = [False] * len(test)
+        for r in sorted(ref, key=lambda b: -b[4]):
+            best, best_iou = -1, thr
+            for i, t in enumerate(test):
+                if used[i] or t[5] != r[5]:
+                    continue
+                v = iou(r, t)
+                if v >= best_iou:
+                    best, best_iou = i, v
+            if best >= 0:
+                used[best] = True
+                self.matched += 1
+                self.dconf += abs(test[best][4] - r[4])
+                self.iou += best_iou
+
+    def summary(self):
+        m = self.matched
+        return {
+            "frames": self.frames, "fp32_boxes": self.ref, "int8_boxes": self.test, "matched": m,
+            "recall": m / self.ref if self.ref else 1.0,
+            "precision": m / self.test if self.test else 1.0,
+            "mean_abs_conf_delta": self.dconf / m if m else 0.0,
+            "mean_iou": self.iou / m if m else 0.0,
+        }
+
+
+def read_frames(clip, wanted):
+    """RGB frames of `clip` at the (sorted) indices in `wanted`."""
+    cap = cv2.VideoCapture(clip)
+    if not cap.isOpened():
+        sys.exit(f"quantize_int8: cannot open clip '{clip}'")
+    wanted = sorted(set(wanted))
+    frames, idx, k = {}, 0, 0
+    while k < len(wanted):
+        ok = cap.grab()
+        if not ok:
+            break
+        if idx == wanted[k]:
+            ok, bgr = cap.retrieve()
+            if ok:
+                frames[idx] = cv2.cvtColor(bgr, cv2.COLOR_BGR2RGB)
+            k += 1
+        idx += 1
+    return frames
+
+
+def frame_count(clip):
+    cap = cv2.VideoCapture(clip)
+    n = int(cap.get(cv2.CAP_PROP_FRAME_COUNT))
+    if n > 0:
+        return n
+    n = 0
+    while cap.grab():
+        n += 1
+    return n
+
+
+def pick_frames(total, events, calib_n, eval_n):
+    """Interleave calibration and evaluation frames so they never overlap.
+    Frames with detections (from a bench_events dump) go first."""
+    busy = []
+    if events:
+        for line in open(events):
+            o = json.loads(line)
+            if o.get("event", {}).get("detections"):
+                busy.append(int(o["frame"]))
+    busy = [f for f in sorted(set(busy)) if f < total]
+    busy_set = set(busy)
+    rest = [f for f in range(total) if f not in busy_set]
+
+    def spread(pool, n):
+        if n <= 0 or not pool:
+            return []
+        if len(pool) <= n:
+            return list(pool)
+        step = len(pool) / n
+        return [pool[int(i * step)] for i in range(n)]
+
+    # Even positions calibrate, odd positions evaluate.
+    need = calib_n + eval_n
+    chosen = spread(busy, need)
+    chosen += spread(rest, need - len(chosen))
+    chosen.sort()
+    return chosen[0::2][:calib_n], chosen[1::2][:eval_n]
+
+
+class FrameReader(CalibrationDataReader):
+    def __init__(self, input_name, tensors):
+        self.input_name = input_name
+        self.it = iter(tensors)
+
+    def get_next(self):
+        t = next(self.it, None)
+        return None if t is None else {self.input_name: t}
+
+
+def session(path):
+    so = ort.SessionOptions()
+    so.intra_op_num_threads = 1
+    so.graph_optimization_level = ort.GraphOptimizationLevel.ORT_ENABLE_ALL
+    return ort.InferenceSession(path, so, providers=["CPUExecutionProvider"])
+
+
+def run(sess, tensor):
+    name = sess.get_inputs()[0].name
+    t0 = time.perf_counter()
+    out = sess.run(None, {name: tensor})[0]
+    return out, (time.perf_counter() - t0) * 1000.0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--model", required=True, help="FP32 ONNX model (NMS-free [1,N,6] output)")
+    ap.add_argument("--clip", required=True, help="video file (the capture_file replay)")
+    ap.add_argument("--events", help="bench_events JSONL dump of the clip (prefer busy frames)")
+    ap.add_argument("--out", help="INT8 model path (default <model>.int8.onnx)")
+    ap.add_argument("--calib-frames", type=int, default=200)
+    ap.add_argument("--eval-frames", type=int, default=100)
+    ap.add_argument("--input-size", type=int, default=640)
+    ap.add_argument("--conf", type=float, default=0.25)
+    ap.add_argument("--method", choices=["minmax", "entropy", "percentile"], default="minmax")
+    ap.add_argument("--op-types", default="Conv,MatMul",
+                    help="ops to quantize; the box decode tail stays FP32 (empty = all)")
+    ap.add_argument("--per-tensor", action="store_true", help="per-tensor instead of per-channel weights")
+    ap.add_argument("--max-recall-loss", type=float, default=0.03)
+    ap.add_argument("--report", help="also write the JSON report here")
+    a = ap.parse_args()
+
+    root, ext = os.path.splitext(a.model)
+    out_path = a.out or f"{root}.int8{ext or '.onnx'}"
+
+    total = frame_count(a.clip)
+    calib_idx, eval_idx = pick_frames(total, a.events, a.calib_frames, a.eval_frames)
+    if not calib_idx:
+        sys.exit(f"quantize_int8: no frames in '{a.clip}'")
+    frames = read_frames(a.clip, calib_idx + eval_idx)
+    prep = {i: letterbox(f, a.input_size) for i, f in frames.items()}
+    print(f"quantize_int8: {len(calib_idx)} calibration / {len(eval_idx)} evaluation frames "
+          f"of {total} ({'bench_events-guided' if a.events else 'uniform'})", file=sys.stderr)
+
+    fp32 = session(a.model)
+    input_name = fp32.get_inputs()[0].name
+    with tempfile.TemporaryDirectory() as tmp:
+        pre = os.path.join(tmp, "pre.onnx")
+        quant_pre_process(a.model, pre)
+        method = {"minmax": CalibrationMethod.MinMax, "entropy": CalibrationMethod.Entropy,
+                  "percentile": CalibrationMethod.Percentile}[a.method]
+        quantize_static(
+            pre, out_path,
+            FrameReader(input_name, [prep[i][0] for i in calib_idx if i in prep]),
+            quant_format=QuantFormat.QDQ,
+            activation_type=QuantType.QUInt8, weight_type=QuantType.QInt8,
+            per_channel=not a.per_tensor, calibrate_method=method,
+            op_types_to_quantize=[t for t in a.op_types.split(",") if t] or None)
+    print(f"quantize_int8: wrote {out_path}", file=sys.stderr)
+
+    int8 = session(out_path)
+    agree = Agreement()
+    t32 = t8 = 0.0
+    for i in eval_idx:
+        if i not in prep:
+            continue
+        tensor, lb = prep[i]
+        o32, ms32 = run(fp32, tensor)
+        o8, ms8 = run(int8, tensor)
+        t32 += ms32
+        t8 += ms8
+        agree.add(decode(o32, lb, a.conf), decode(o8, lb, a.conf))
+
+    report = agree.summary()
+    n = max(1, report["frames"])
+    report.update({
+        "fp32_model": a.model, "int8_model": out_path,
+        "fp32_ms_per_frame": t32 / n, "int8_ms_per_frame": t8 / n,
+        "speedup": (t32 / t8) if t8 > 0 else 0.0,
+        "recall_loss": 1.0 - report["recall"], "max_recall_loss": a.max_recall_loss,
+    })
+    text = json.dumps(report, indent=2)
+    print(text)
+    if a.report:
+        with open(a.report, "w") as f:
+            f.write(text + "\n")
+    if report["recall_loss"] > a.max_recall_loss:
+        print(f"quantize_int8: recall loss {report['recall_loss']:.3f} exceeds "
+              f"{a.max_recall_loss:.3f}; try --method entropy/percentile or more frames",
+              file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())